@@ -0,0 +1,50 @@
+// Test the knob-gated parallel collection scan feeding aggregation
+// (internalAggregationParallelScanThreads, see pipeline_d.cpp).  Results must
+// match the regular single-cursor path.
+
+var t = db.jstests_aggregation_parallel_scan;
+t.drop();
+
+// several extents worth of data
+var big = new Array(8 * 1024).join("x");
+var n = 2000;
+for (var i = 0; i < n; i++) {
+    t.insert({_id: i, mod: i % 10, pad: big});
+}
+assert.eq(n, t.count());
+
+function groupAgg() {
+    return t.aggregate([{$match: {mod: 3}},
+                        {$group: {_id: null, count: {$sum: 1}, total: {$sum: "$_id"}}}]).toArray();
+}
+
+var expected = groupAgg();
+assert.eq(1, expected.length);
+assert.eq(n / 10, expected[0].count);
+
+assert.commandWorked(
+    db.adminCommand({setParameter: 1, internalAggregationParallelScanThreads: 4}));
+try {
+    assert.eq(expected, groupAgg());
+
+    // unordered results are complete and unduplicated
+    var ids = t.aggregate([{$match: {mod: {$lt: 3}}}, {$project: {_id: 1}}]).toArray()
+                  .map(function(d) { return d._id; });
+    assert.eq(3 * n / 10, ids.length);
+    ids.sort(function(a, b) { return a - b; });
+    for (var i = 1; i < ids.length; i++) {
+        assert.lt(ids[i - 1], ids[i], "duplicate or unsorted _id from parallel scan");
+    }
+
+    // a pipeline with an initial $sort falls back to the regular path but
+    // must still be correct
+    var sorted = t.aggregate([{$match: {mod: 3}}, {$sort: {_id: 1}}, {$limit: 3},
+                              {$project: {_id: 1}}]).toArray();
+    assert.eq([{_id: 3}, {_id: 13}, {_id: 23}], sorted);
+}
+finally {
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalAggregationParallelScanThreads: 0}));
+}
+
+t.drop();
@@ -0,0 +1,58 @@
+// Test replaying a profiled workload through benchRun:
+// capture ops with the profiler, convert them with db.profileToBenchRunOps,
+// and check the latency histograms in the benchRun output.
+
+t = db.bench_test_replay;
+t.drop();
+
+t.insert( { _id : 1 , x : 1 } );
+t.insert( { _id : 2 , x : 1 } );
+
+db.setProfilingLevel( 0 );
+db.system.profile.drop();
+db.setProfilingLevel( 2 );
+
+t.findOne( { _id : 1 } );
+t.update( { _id : 1 } , { $inc : { x : 1 } } );
+t.remove( { _id : 42 } );
+
+db.setProfilingLevel( 0 );
+
+ops = db.profileToBenchRunOps( { ns : t.getFullName() } );
+
+assert.eq( 3 , ops.length , "A1" );
+assert.eq( "find" , ops[0].op , "A2" );
+assert.eq( t.getFullName() , ops[0].ns , "A3" );
+assert.docEq( { _id : 1 } , ops[0].query , "A4" );
+assert.eq( "update" , ops[1].op , "A5" );
+assert.docEq( { $inc : { x : 1 } } , ops[1].update , "A6" );
+assert.eq( "remove" , ops[2].op , "A7" );
+
+// filter and limit are honored
+assert.eq( 1 , db.profileToBenchRunOps( { op : "update" } ).length , "B1" );
+assert.eq( 1 , db.profileToBenchRunOps( null , 1 ).length , "B2" );
+
+benchArgs = { ops : ops , parallel : 2 , seconds : .7 , host : db.getMongo().host };
+
+if (jsTest.options().auth) {
+    benchArgs['db'] = 'admin';
+    benchArgs['username'] = jsTest.options().adminUser;
+    benchArgs['password'] = jsTest.options().adminPassword;
+}
+res = benchRun( benchArgs );
+
+assert.gt( res.queryLatencyAverageMicros , 0 , "C1" );
+
+// The histogram bucket counts must add up to the number of timed events.
+function histogramTotal( histo ) {
+    var total = 0;
+    for ( var bucket in histo )
+        total += histo[bucket];
+    return total;
+}
+assert( res.queryLatencyHistogramMicros , "C2" );
+assert.gt( histogramTotal( res.queryLatencyHistogramMicros ) , 0 , "C3" );
+assert( res.updateLatencyHistogramMicros , "C4" );
+assert.gt( histogramTotal( res.updateLatencyHistogramMicros ) , 0 , "C5" );
+
+assert.gte( t.findOne( { _id : 1 } ).x , 2 , "C6" );
@@ -1,22 +1,45 @@
+// dbhash serves per-collection running digests that the write path keeps
+// current, so repeat runs don't rescan; fullScan forces a rehash
 
 mydb = db.getSisterDB( "config" );
 
 t = mydb.foo;
 t.drop();
 
-t.insert( { x : 1 } );
+t.insert( { _id : 1, x : 1 } );
 res1 = mydb.runCommand( "dbhash" );
-assert( res1.fromCache.indexOf( "config.foo" ) == -1 );
+assert( res1.fromCache.indexOf( "config.foo" ) == -1 ); // first run seeds the digest
 
 res2 = mydb.runCommand( "dbhash" );
 assert( res2.fromCache.indexOf( "config.foo" ) >= 0 );
 assert.eq( res1.collections.foo, res2.collections.foo );
 
-t.insert( { x : 2 } );
+t.insert( { _id : 2, x : 2 } );
 res3 = mydb.runCommand( "dbhash" );
-assert( res3.fromCache.indexOf( "config.foo" ) < 0 );
+// the running digest absorbed the insert, so we are still served from cache...
+assert( res3.fromCache.indexOf( "config.foo" ) >= 0 );
+// ...but the hash reflects the new document
 assert.neq( res1.collections.foo, res3.collections.foo );
 
+// updates and removes are folded in as well
+t.update( { _id : 2 }, { _id : 2, x : 3 } );
+res4 = mydb.runCommand( "dbhash" );
+assert( res4.fromCache.indexOf( "config.foo" ) >= 0 );
+assert.neq( res3.collections.foo, res4.collections.foo );
 
+t.remove( { _id : 2 } );
+res5 = mydb.runCommand( "dbhash" );
+assert( res5.fromCache.indexOf( "config.foo" ) >= 0 );
+assert.eq( res1.collections.foo, res5.collections.foo ); // back to the original doc set
 
-
+// a drop forgets the digest; reseeding over identical documents has to agree
+// with the incrementally maintained value
+t.drop();
+t.insert( { _id : 1, x : 1 } );
+res6 = mydb.runCommand( "dbhash" );
+assert( res6.fromCache.indexOf( "config.foo" ) == -1 );
+assert.eq( res1.collections.foo, res6.collections.foo );
+
+// fullScan bypasses the digests and rehashes every collection
+res7 = mydb.runCommand( { dbhash : 1, fullScan : true } );
+assert( res7.fromCache.indexOf( "config.foo" ) == -1 );
@@ -0,0 +1,34 @@
+// Distinct on a non-leading component of a compound index uses an index skip
+// scan (see getRunnerDistinct); results must match the document-scan fallback.
+
+t = db.distinct_index3;
+t.drop();
+
+t.ensureIndex( { a : 1 , b : 1 } );
+
+for ( var a = 0; a < 5; a++ ) {
+    for ( var b = 0; b < 20; b++ ) {
+        t.insert( { a : a , b : b % 7 } );
+    }
+}
+
+// no query: distinct over the second component
+assert.eq( [ 0, 1, 2, 3, 4, 5, 6 ] , t.distinct( "b" ).sort() , "A1" );
+
+// with a query on the leading component
+assert.eq( [ 0, 1, 2, 3, 4, 5, 6 ] , t.distinct( "b" , { a : { $gte : 3 } } ).sort() , "A2" );
+
+// values that compare equal but are encoded differently collapse to one
+t.drop();
+t.ensureIndex( { a : 1 , b : 1 } );
+t.insert( { a : 1 , b : NumberLong( 5 ) } );
+t.insert( { a : 2 , b : 5 } );
+t.insert( { a : 3 , b : 5.0 } );
+assert.eq( 1 , t.distinct( "b" ).length , "B1" );
+
+// arrays still expand through the multikey compound index
+t.drop();
+t.ensureIndex( { a : 1 , b : 1 } );
+t.insert( { a : 1 , b : [ 1 , 2 ] } );
+t.insert( { a : 2 , b : [ 2 , 3 ] } );
+assert.eq( [ 1, 2, 3 ] , t.distinct( "b" ).sort() , "C1" );
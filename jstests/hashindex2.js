@@ -0,0 +1,38 @@
+// test hashVersion 1 (fast 64-bit hash) hashed indexes
+var t = db.hashindex2;
+t.drop()
+
+//unknown hash versions are rejected
+t.ensureIndex( {a : "hashed"} , {"hashVersion" : 2} );
+assert.eq( t.getIndexes().length , 1 , "bad hashVersion got created");
+
+//a v1 index does get created
+t.ensureIndex( {a : "hashed"} , {"hashVersion" : 1} );
+assert.eq( t.getIndexes().length , 2 , "hashVersion 1 index didn't get created");
+
+//basic inserts and lookups work
+for(i=0; i < 10; i++ ){
+	t.insert( {a:i } );
+}
+assert.eq( t.find().count() , 10 , "basic insert didn't work");
+var goodspec = {a : "hashed"};
+assert.eq( t.find().hint(goodspec).toArray().length , 10 , "basic insert didn't work");
+assert.eq( t.find({a : 3}).hint({_id : 1}).toArray()[0]._id ,
+		   t.find({a : 3}).hint(goodspec).toArray()[0]._id ,
+		   "hashindex lookup didn't work" );
+
+//numeric type squashing works the same as v0: only one of 3 and 3.1 comes back
+t.insert( {a: 3.1} );
+assert.eq( t.find({a : 3.1}).hint(goodspec).toArray().length , 1);
+assert.eq( t.find({a : 3.1}).hint(goodspec).toArray()[0].a , 3.1);
+assert.eq( t.find({a : 3}).hint(goodspec).toArray().length , 1);
+
+//the hashed cursor is used for equality
+var cursorname = "BtreeCursor a_hashed";
+assert.eq( t.find({a : 1}).explain().cursor ,
+		cursorname ,
+		"not using hashed cursor");
+
+//documents missing the field are found via the null hash
+t.insert( {b : 1} );
+assert.eq( t.find({a : null}).hint(goodspec).toArray().length , 1 , "missing field not indexed");
@@ -0,0 +1,25 @@
+// When metricsStreamIntervalMs is set, the server pushes delta-encoded counter
+// samples into the capped collection local.system.metricsStream.
+
+assert.commandWorked(db.adminCommand({setParameter: 1, metricsStreamIntervalMs: 50}));
+try {
+    var stream = db.getSiblingDB("local").system.metricsStream;
+
+    assert.soon(function() {
+        return stream.count() > 0;
+    }, "no metrics samples pushed", 30 * 1000);
+
+    assert(stream.isCapped());
+
+    var doc = stream.findOne();
+    assert(doc.ts instanceof Date, tojson(doc));
+    assert.lte(0, doc.ms, tojson(doc));
+    assert.lte(0, doc.op.insert, tojson(doc));
+    assert.lte(0, doc.op.command, tojson(doc));
+    assert.lte(0, doc.lockMicros.r, tojson(doc));
+    assert.lte(0, doc.lockMicros.w, tojson(doc));
+}
+finally {
+    // turn the stream back off so we don't keep writing during the rest of the suite
+    assert.commandWorked(db.adminCommand({setParameter: 1, metricsStreamIntervalMs: 0}));
+}
@@ -0,0 +1,52 @@
+// Test the knob-gated parallel extent scan for unsorted table scans
+// (internalQueryParallelCollscanThreads, see db/exec/parallel_gather.cpp).
+// Results must match the regular single-threaded collection scan.
+
+var t = db.jstests_parallel_collscan;
+t.drop();
+
+// several extents worth of data
+var big = new Array(8 * 1024).join("x");
+var n = 2000;
+for (var i = 0; i < n; i++) {
+    t.insert({_id: i, mod: i % 10, pad: big});
+}
+assert.eq(n, t.count());
+
+assert.commandWorked(
+    db.adminCommand({setParameter: 1, internalQueryParallelCollscanThreads: 4}));
+assert.commandWorked(
+    db.adminCommand({setParameter: 1, internalQueryParallelCollscanMinSizeMB: 0}));
+try {
+    // unordered results are complete and unduplicated
+    var ids = t.find({mod: {$lt: 3}}, {_id: 1}).toArray()
+                  .map(function(d) { return d._id; });
+    assert.eq(3 * n / 10, ids.length);
+    ids.sort(function(a, b) { return a - b; });
+    for (var i = 1; i < ids.length; i++) {
+        assert.lt(ids[i - 1], ids[i], "duplicate _id from parallel scan");
+    }
+
+    // limit and count go through the same scan
+    assert.eq(5, t.find({mod: 3}).limit(5).itcount());
+    assert.eq(n / 10, t.find({mod: 7}).itcount());
+    assert.eq(n, t.find().itcount());
+
+    // nscanned covers the whole collection and the fan-out is reported
+    var exp = t.find({mod: 3}).explain(true);
+    assert.eq("BasicCursor", exp.cursor, tojson(exp));
+    assert.eq(n, exp.nscanned, tojson(exp));
+
+    // sorted and tailing-style queries must fall back to the regular scan
+    var sorted = t.find({mod: 3}, {_id: 1}).sort({_id: 1}).limit(3).toArray();
+    assert.eq([{_id: 3}, {_id: 13}, {_id: 23}], sorted);
+    assert.eq(n - 1, t.find().sort({$natural: -1}).next()._id);
+}
+finally {
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryParallelCollscanThreads: 0}));
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryParallelCollscanMinSizeMB: 256}));
+}
+
+t.drop();
@@ -0,0 +1,40 @@
+// the qlock scheduling policy is tunable at runtime and the global lock
+// stats expose an acquire-wait histogram
+
+old = db.adminCommand( { "getParameter" : "*" } )
+assert( old.qlockWriterBatchSize >= 0, "A1" )
+assert( old.qlockReaderAdmissionLimit >= 0, "A2" )
+
+tmp1 = db.adminCommand( { "setParameter" : 1, "qlockWriterBatchSize" : 4 } )
+assert.eq( old.qlockWriterBatchSize, tmp1.was, "B1" )
+tmp2 = db.adminCommand( { "setParameter" : 1, "qlockReaderAdmissionLimit" : 16 } )
+assert.eq( old.qlockReaderAdmissionLimit, tmp2.was, "B2" )
+
+now = db.adminCommand( { "getParameter" : "*" } )
+assert.eq( 4, now.qlockWriterBatchSize, "C1" )
+assert.eq( 16, now.qlockReaderAdmissionLimit, "C2" )
+
+// negative values are rejected
+assert.commandFailed( db.adminCommand( { "setParameter" : 1, "qlockWriterBatchSize" : -1 } ), "D1" )
+assert.commandFailed( db.adminCommand( { "setParameter" : 1, "qlockReaderAdmissionLimit" : -1 } ), "D2" )
+
+// restore
+db.adminCommand( { "setParameter" : 1, "qlockWriterBatchSize" : old.qlockWriterBatchSize } )
+db.adminCommand( { "setParameter" : 1, "qlockReaderAdmissionLimit" : old.qlockReaderAdmissionLimit } )
+
+// do a little write-locked work so the global lock stats have something in them,
+// then check the histogram buckets sum to the acquisition counts reported
+t = db.qlock_policy_params
+t.drop()
+for ( var i = 0; i < 100; i++ )
+    t.insert( { _id : i } )
+
+locks = db.serverStatus().locks["."]
+assert( locks, "E1" )
+if ( locks.acquireWaitHistogramMicros ) {
+    for ( var state in locks.acquireWaitHistogramMicros ) {
+        var buckets = locks.acquireWaitHistogramMicros[state]
+        for ( var b in buckets )
+            assert( buckets[b] > 0, "E2 " + state + "/" + b )
+    }
+}
@@ -0,0 +1,45 @@
+// Test collMod {resultCache: true} - cached replies must stay correct across writes.
+
+var t = db.query_result_cache;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({_id: i, a: i % 10});
+}
+
+// turn the cache on
+var res = db.runCommand({collMod: t.getName(), resultCache: true});
+assert.commandWorked(res);
+assert.eq(false, res.resultCache_old);
+assert.eq(true, res.resultCache_new);
+
+// repeated identical queries agree (second one is served from the cache)
+assert.eq(10, t.find({a: 3}).itcount());
+assert.eq(10, t.find({a: 3}).itcount());
+assert.eq(3, t.findOne({_id: 3}).a);
+assert.eq(3, t.findOne({_id: 3}).a);
+
+// a write must invalidate: re-running the same query sees the new data
+t.insert({_id: 100, a: 3});
+assert.eq(11, t.find({a: 3}).itcount());
+
+t.update({_id: 100}, {$set: {a: 4}});
+assert.eq(10, t.find({a: 3}).itcount());
+
+t.remove({_id: 0});
+assert.eq(9, t.find({a: 0}).itcount());
+
+// sorts and projections are cached per exact query message too
+assert.eq(9, t.find({a: 0}, {a: 1}).itcount());
+assert.eq(9, t.find({a: 0}, {a: 1}).itcount());
+
+// turn the cache back off
+res = db.runCommand({collMod: t.getName(), resultCache: false});
+assert.commandWorked(res);
+assert.eq(true, res.resultCache_old);
+assert.eq(false, res.resultCache_new);
+
+t.insert({_id: 101, a: 3});
+assert.eq(11, t.find({a: 3}).itcount());
+
+t.drop();
@@ -0,0 +1,39 @@
+
+// test that a node whose initial sync clones collections in parallel
+// (replInitialSyncCloneThreads > 1) ends up with the same data and indexes
+// as the sync source.
+
+var rt = new ReplSetTest( { name : "initsyncparallel" , nodes : 1 } );
+
+rt.startSet();
+rt.initiate();
+var master = rt.getMaster();
+var mdb = master.getDB( "d" );
+
+var collections = 5;
+var doccount = 2000;
+for ( var c = 0; c < collections; c++ ) {
+    var coll = mdb[ "c" + c ];
+    for ( var i = 0; i < doccount; i++ ) {
+        coll.insert( { _id : i , x : "some string payload " + i } );
+    }
+    coll.ensureIndex( { x : 1 } );
+}
+mdb.getLastError();
+
+// add a secondary that clones with several reader threads
+var slave = rt.add( { setParameter : "replInitialSyncCloneThreads=4" } );
+rt.reInitiate();
+print( "initiation complete!" );
+rt.awaitSecondaryNodes();
+
+slave.setSlaveOk();
+var sdb = slave.getDB( "d" );
+for ( var c = 0; c < collections; c++ ) {
+    assert.eq( doccount , sdb[ "c" + c ].count() , "count of c" + c );
+    assert.eq( 2 , sdb[ "c" + c ].getIndexes().length , "indexes of c" + c );
+    assert.eq( "some string payload 0" , sdb[ "c" + c ].findOne( { _id : 0 } ).x ,
+               "content of c" + c );
+}
+
+rt.stopSet();
@@ -0,0 +1,30 @@
+// serverStatus({delta: <epochs>}) returns only sections whose change epoch
+// moved since the client's last poll
+
+var full = db.serverStatus();
+assert( full.connections, "baseline has connections" );
+assert( full.asserts, "baseline has asserts" );
+assert.eq( undefined, full.epochs, "no epochs doc without delta" );
+
+// first delta poll: empty token, everything comes back plus the epochs doc
+var first = db.serverStatus( { delta : {} } );
+assert( first.connections, "first delta poll has connections" );
+assert( first.asserts, "first delta poll has asserts" );
+assert( first.epochs, "first delta poll returns epochs" );
+assert( first.epochs.asserts !== undefined, "asserts publishes an epoch" );
+
+// second poll with the token: unchanged sections are omitted.  asserts only
+// moves when an assertion fires, so between two back-to-back polls it should
+// (eventually, to tolerate unrelated activity) be skipped; sections without
+// epoch support (e.g. extra_info) must still be present.
+assert.soon( function() {
+    var token = db.serverStatus( { delta : {} } ).epochs;
+    var second = db.serverStatus( { delta : token } );
+    assert( second.epochs, "second delta poll returns epochs" );
+    assert( second.extra_info, "epoch-less sections always included" );
+    return second.asserts === undefined;
+}, "unchanged asserts section omitted between back-to-back polls" );
+
+// a stale/garbage token just means the section is regenerated
+var third = db.serverStatus( { delta : { asserts : -1 } } );
+assert( third.asserts, "mismatched epoch regenerates the section" );
@@ -0,0 +1,30 @@
+// importparallel1.js
+// mongoimport --parseThreads parses line-delimited JSON on a worker pool but
+// must import the same documents as a single-threaded run
+
+t = new ToolTest( "importparallel1" );
+
+c = t.startDB( "foo" );
+assert.eq( 0 , c.count() , "setup" );
+
+var n = 5000;
+for ( var i = 0; i < n; i++ ) {
+    c.save( { _id : i , x : "x" + i , s : "some string payload " + i } );
+}
+assert.eq( n , c.count() , "setup2" );
+
+t.runTool( "export" , "--out" , t.extFile , "-d" , t.baseName , "-c" , "foo" );
+
+c.drop();
+assert.eq( 0 , c.count() , "after drop" );
+
+t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" ,
+           "--parseThreads" , "4" );
+assert.soon( n + " == c.count()" , "after parallel import" );
+
+// spot check content
+assert.eq( "x0" , c.findOne( { _id : 0 } ).x , "doc 0" );
+assert.eq( "x" + ( n - 1 ) , c.findOne( { _id : n - 1 } ).x , "last doc" );
+assert.eq( n , c.distinct( "_id" ).length , "all ids distinct" );
+
+t.stop();
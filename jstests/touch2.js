@@ -0,0 +1,46 @@
+// rate-limited / background / residency / evict options of the touch command
+
+t = db.touch2;
+t.drop();
+
+t.insert( { x : 1 } );
+t.ensureIndex( { x : 1 } );
+
+// rate limit: still touches everything, just (possibly) slower
+res = t.runCommand( "touch", { data : true, index : true, rateMBPerSec : 100 } );
+assert.commandWorked( res );
+assert.eq( 1, res.data.numRanges, tojson( res ) );
+assert.eq( 2, res.indexes.numRanges, tojson( res ) );
+
+res = t.runCommand( "touch", { data : true, rateMBPerSec : -1 } );
+assert( !res.ok, tojson( res ) );
+
+// background: returns immediately with a note
+res = t.runCommand( "touch", { data : true, index : true, background : true } );
+assert.commandWorked( res );
+assert( res.note, tojson( res ) );
+
+// residency: per-namespace page counts for the collection and its indexes
+res = t.runCommand( "touch", { residency : true } );
+if ( res.ok ) {
+    var data = res.residency[ t.getFullName() ];
+    assert( data, tojson( res ) );
+    assert( data.totalPages > 0, tojson( res ) );
+    assert( data.residentPages >= 0, tojson( res ) );
+    assert( res.residency[ t.getFullName() + ".$_id_" ], tojson( res ) );
+    assert( res.residency[ t.getFullName() + ".$x_1" ], tojson( res ) );
+
+    // same report through serverStatus
+    var ss = db.serverStatus( { residency : t.getFullName() } );
+    assert( ss.residency[ t.getFullName() ], tojson( ss.residency ) );
+}
+// else: mincore not supported on this platform
+
+// evict: advisory only; just check it runs where fadvise exists
+res = t.runCommand( "touch", { data : true, index : true, evict : true } );
+if ( res.ok ) {
+    assert.eq( 1, res.data.numRanges, tojson( res ) );
+    assert.eq( 2, res.indexes.numRanges, tojson( res ) );
+    // the data comes right back
+    assert.eq( 1, t.findOne().x );
+}
@@ -0,0 +1,38 @@
+// Test that validate with {parallel: n} returns the same counts as a serial validate.
+
+t = db.validate_parallel;
+t.drop();
+
+for (var i = 0; i < 5000; i++) {
+    t.insert({ _id: i, x: i, s: "padding padding padding" });
+}
+t.ensureIndex({ x: 1 });
+db.getLastError();
+
+var serial = t.validate(true);
+assert(serial.valid, "A1: " + tojson(serial));
+
+var parallel = db.runCommand({ validate: t.getName(), full: true, parallel: 4 });
+assert(parallel.valid, "A2: " + tojson(parallel));
+
+assert.eq(serial.nrecords, parallel.nrecords, "B1");
+assert.eq(serial.objectsFound, parallel.objectsFound, "B2");
+assert.eq(serial.invalidObjects, parallel.invalidObjects, "B3");
+assert.eq(serial.bytesWithHeaders, parallel.bytesWithHeaders, "B4");
+assert.eq(serial.bytesWithoutHeaders, parallel.bytesWithoutHeaders, "B5");
+assert.eq(serial.bytesBson, parallel.bytesBson, "B6");
+assert.eq(serial.nQuantizedSize, parallel.nQuantizedSize, "B7");
+assert.eq(serial.nPowerOf2QuantizedSize, parallel.nPowerOf2QuantizedSize, "B8");
+assert.eq(serial.deletedCount, parallel.deletedCount, "B9");
+assert.docEq(serial.keysPerIndex, parallel.keysPerIndex, "B10");
+
+// capped collections fall back to the serial scan so the out-of-order check still runs
+db.validate_parallel_capped.drop();
+db.createCollection("validate_parallel_capped", { capped: true, size: 4096 });
+for (var i = 0; i < 10; i++) {
+    db.validate_parallel_capped.insert({ x: i });
+}
+var capped = db.runCommand({ validate: "validate_parallel_capped",
+                             full: true, parallel: 4 });
+assert(capped.valid, "C1: " + tojson(capped));
+assert.eq(0, capped.cappedOutOfOrder, "C2");
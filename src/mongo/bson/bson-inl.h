@@ -223,7 +223,7 @@ dodouble:
        getOwned() method.  the presumption being that is better.
     */
     inline NOINLINE_DECL BSONObj BSONObj::copy() const {
-        Holder *h = (Holder*) malloc(objsize() + sizeof(unsigned));
+        Holder *h = (Holder*) malloc(objsize() + Holder::extraBytes);
         h->zero();
         memcpy(h->data, objdata(), objsize());
         return BSONObj(h);
@@ -263,6 +263,15 @@ dodouble:
     }
 
     inline BSONElement BSONObj::getField(const StringData& name) const {
+        if ( _holder.get() && _objdata == _holder->data ) {
+            const BSONFieldIndex* idx = _holder->fieldIndexForScan( _objdata );
+            if ( idx && idx->size() ) {
+                const int ofs = idx->find( _objdata, name );
+                if ( ofs < 0 )
+                    return BSONElement();
+                return BSONElement( _objdata + ofs );
+            }
+        }
         BSONObjIterator i(*this);
         while ( i.more() ) {
             BSONElement e = i.next();
@@ -778,6 +787,11 @@ dodouble:
     }
 
     inline int BSONObj::nFields() const {
+        if ( _holder.get() && _objdata == _holder->data ) {
+            const BSONFieldIndex* idx = _holder->builtFieldIndex();
+            if ( idx && idx->size() )
+                return idx->size();
+        }
         int n = 0;
         BSONObjIterator i(*this);
         while ( i.moreWithEOO() ) {
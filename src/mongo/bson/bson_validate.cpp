@@ -18,9 +18,15 @@
 #include <cstring>
 #include <deque>
 
+#if defined(__SSE2__) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MONGO_HAVE_BSON_VALIDATE_SSE2 1
+#include <emmintrin.h>
+#endif
+
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/bits.h"
 
 namespace mongo {
 
@@ -59,7 +65,29 @@ namespace mongo {
             }
 
             Status readCString( StringData* out ) {
-                const void* x = memchr( _buffer + _position, 0, _maxLength - _position );
+                const char* start = _buffer + _position;
+                const uint64_t remaining = _maxLength - _position;
+                const void* x = 0;
+#ifdef MONGO_HAVE_BSON_VALIDATE_SSE2
+                // scan for the NUL terminator 16 bytes at a time.  this is the hot loop of
+                // validation: every element has a c-string field name.
+                const char* p = start;
+                const char* const vecEnd = start + ( remaining & ~static_cast<uint64_t>(15) );
+                const __m128i zero = _mm_setzero_si128();
+                while ( p < vecEnd ) {
+                    const __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) );
+                    const int mask = _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, zero ) );
+                    if ( mask ) {
+                        x = p + ( firstBitSet(mask) - 1 );
+                        break;
+                    }
+                    p += 16;
+                }
+                if ( !x && p < start + remaining )
+                    x = memchr( p, 0, remaining - ( p - start ) );
+#else
+                x = memchr( start, 0, remaining );
+#endif
                 if ( !x )
                     return makeError("no end of c-string", _idElem);
                 uint64_t len = static_cast<uint64_t>( static_cast<const char*>(x) - ( _buffer + _position ) );
@@ -28,6 +28,7 @@
 #include "mongo/base/string_data.h"
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/bson/util/builder.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/client/export_macros.h"
 #include "mongo/util/bufreader.h"
 
@@ -36,6 +37,58 @@ namespace mongo {
     typedef std::set< BSONElement, BSONElementCmpWithoutField > BSONElementSet;
     typedef std::multiset< BSONElement, BSONElementCmpWithoutField > BSONElementMSet;
 
+    /**
+     * Lazily built lookup index over the top level field names of an owned
+     * BSONObj: a small array of (name hash, element offset) pairs sorted by
+     * hash.  It is attached to BSONObj::Holder once the same document has been
+     * scanned for a field a few times, so later getField() calls become a
+     * binary search instead of a walk of the whole buffer.  An instance with
+     * no entries is the shared marker for "not worth indexing".
+     * @see BSONObj::getField
+     */
+    class MONGO_CLIENT_API BSONFieldIndex : boost::noncopyable {
+    public:
+        /**
+         * walk an object and build its index.  returns the shared empty
+         * instance when the object has too few fields to be worth indexing.
+         */
+        static BSONFieldIndex* make( const char* objdata );
+
+        /** delete idx unless it is the shared empty instance (or NULL) */
+        static void destroy( BSONFieldIndex* idx ) {
+            if ( idx && idx != &_declined )
+                delete idx;
+        }
+
+        /** number of indexed fields; 0 means "fall back to a linear scan" */
+        int size() const { return static_cast<int>( _entries.size() ); }
+
+        /**
+         * @param objdata the buffer this index was built from
+         * @return offset of the first element with that field name, -1 if none
+         */
+        int find( const char* objdata, const StringData& name ) const;
+
+    private:
+        BSONFieldIndex() {}
+
+        struct Entry {
+            unsigned hash;
+            int offset;
+            bool operator<( const Entry& other ) const {
+                if ( hash != other.hash )
+                    return hash < other.hash;
+                return offset < other.offset; // keep first occurrence first
+            }
+        };
+
+        static unsigned hashName( const StringData& name );
+
+        static BSONFieldIndex _declined;
+
+        std::vector<Entry> _entries;
+    };
+
     /**
        C++ representation of a "BSON" object -- that is, an extended JSON-style
        object in a binary representation.
@@ -74,6 +127,8 @@ namespace mongo {
      Code With Scope: <total size><String><Object>
      \endcode
      */
+    class SharedBuffer;
+
     class MONGO_CLIENT_API BSONObj {
     public:
 
@@ -86,13 +141,20 @@ namespace mongo {
 
         /** Construct a BSONObj from data in the proper format.
          *  Use this constructor when you want BSONObj to free(holder) when it is no longer needed
-         *  BSONObj::Holder has an extra 4 bytes for a ref-count before the start of the object
+         *  BSONObj::Holder has Holder::extraBytes extra bytes for a ref-count and the lazy
+         *  field index slots before the start of the object
         */
         class Holder;
         explicit BSONObj(Holder* holder) {
             init(holder);
         }
 
+        /** Construct a BSONObj aliasing 'objdata' inside 'buffer' -- owned, but
+         *  with no copy: the object shares ownership of the buffer's whole
+         *  allocation with any other objects built over it.  See SharedBuffer.
+         */
+        BSONObj(const SharedBuffer& buffer, const char* objdata);
+
         /** Construct an empty BSONObj -- that is, {}. */
         BSONObj();
 
@@ -504,10 +566,48 @@ namespace mongo {
         private:
             Holder(); // this class should never be explicitly created
             AtomicUInt refCount;
+            unsigned fieldScans;                    // approximate; see fieldIndexForScan()
+            AtomicWord<BSONFieldIndex*> fieldIndex; // lazily built, owned
+            char* extData;                          // see makeForExternalData(); usually NULL
         public:
             char data[4]; // start of object
 
-            void zero() { refCount.zero(); }
+            /** bytes preceding the object: the ref-count, the lazy field
+                index slots and the external data pointer.  every producer of
+                a Holder must reserve (and zero) exactly this much before the
+                object data. */
+            static const unsigned extraBytes = 2 * sizeof(unsigned) + 2 * sizeof(void*);
+
+            void zero() {
+                refCount.zero();
+                fieldScans = 0;
+                fieldIndex.store(NULL);
+                extData = NULL;
+            }
+
+            /** Make a holder whose bytes live in 'extBuf' -- a malloc'd
+                allocation whose ownership transfers to the holder -- instead
+                of inline after the header.  The holder is a separate small
+                allocation; 'extBuf' is freed when the last reference goes.
+                Used by SharedBuffer so several objects can share one big
+                allocation (say, a wire message full of documents). */
+            static Holder* makeForExternalData( char* extBuf ) {
+                Holder* h = (Holder*) malloc( sizeof( Holder ) );
+                h->zero();
+                h->extData = extBuf;
+                return h;
+            }
+
+            /**
+             * the field index for this object, building it once the document
+             * has been scanned a few times; NULL until then.  the scan counter
+             * is deliberately non-atomic - a lost increment just moves the
+             * build a scan earlier or later.  defined in jsobj.cpp.
+             */
+            const BSONFieldIndex* fieldIndexForScan( const char* objdata );
+
+            /** the field index if it has already been built, else NULL */
+            const BSONFieldIndex* builtFieldIndex() const { return fieldIndex.load(); }
 
             // these are called automatically by boost::intrusive_ptr
             friend void intrusive_ptr_add_ref(Holder* h) { h->refCount++; }
@@ -516,10 +616,16 @@ namespace mongo {
                 verify((int)h->refCount > 0); // make sure we haven't already freed the buffer
 #endif
                 if(--(h->refCount) == 0){
+                    BSONFieldIndex::destroy( h->fieldIndex.load() );
+                    if ( h->extData ) {
+                        free( h->extData );
+                    }
 #if defined(_DEBUG)
-                    unsigned sz = (unsigned&) *h->data;
-                    verify(sz < BSONObjMaxInternalSize * 3);
-                    memset(h->data, 0xdd, sz);
+                    else {
+                        unsigned sz = (unsigned&) *h->data;
+                        verify(sz < BSONObjMaxInternalSize * 3);
+                        memset(h->data, 0xdd, sz);
+                    }
 #endif
                     free(h);
                 }
@@ -577,6 +683,50 @@ namespace mongo {
         Status _okForStorage(bool root, bool deep) const;
     };
 
+    /**
+     * Shared ownership of one malloc'd allocation holding bson data for
+     * (possibly many) objects -- a wire message carrying a batch of documents,
+     * a builder's finished buffer, etc.  Built on the same ref-count BSONObj
+     * uses for a single owned object, so a BSONObj constructed over the buffer
+     * (see BSONObj(SharedBuffer, const char*)) participates in the ownership
+     * directly: the allocation is freed when the last SharedBuffer or aliasing
+     * BSONObj lets go.  Copying a SharedBuffer or aliasing an object never
+     * copies the bytes.
+     *
+     * The flip side: any one aliasing object keeps the entire allocation
+     * alive, so this is for consumers that use all (or nearly all) of the
+     * buffer, not for plucking one document out of a large message.
+     */
+    class MONGO_CLIENT_API SharedBuffer {
+    public:
+        SharedBuffer() {}
+
+        /**
+         * Take ownership of 'buf', which must have come from malloc()/realloc()
+         * -- e.g. a Message's buffer or a decouple()d BufBuilder's.  Freed with
+         * free() when the last reference goes.
+         */
+        static SharedBuffer takeOwnership( char* buf ) {
+            SharedBuffer b;
+            b._holder = BSONObj::Holder::makeForExternalData( buf );
+            return b;
+        }
+
+        /** true if this actually references a buffer */
+        bool isValid() const { return _holder.get() != 0; }
+
+        void reset() { _holder = NULL; }
+
+    private:
+        friend class BSONObj;
+        boost::intrusive_ptr< BSONObj::Holder > _holder;
+    };
+
+    inline BSONObj::BSONObj(const SharedBuffer& buffer, const char* objdata) {
+        _holder = buffer._holder;
+        init(objdata);
+    }
+
     std::ostream& operator<<( std::ostream &s, const BSONObj &o );
     std::ostream& operator<<( std::ostream &s, const BSONElement &e );
 
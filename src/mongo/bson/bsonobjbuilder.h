@@ -52,9 +52,10 @@ namespace mongo {
     class MONGO_CLIENT_API BSONObjBuilder : public BSONBuilderBase, private boost::noncopyable {
     public:
         /** @param initsize this is just a hint as to the final size of the object */
-        BSONObjBuilder(int initsize=512) : _b(_buf), _buf(initsize + sizeof(unsigned)), _offset( sizeof(unsigned) ), _s( this ) , _tracker(0) , _doneCalled(false) {
-            _b.appendNum((unsigned)0); // ref-count
-            _b.skip(4); /*leave room for size field and ref-count*/
+        BSONObjBuilder(int initsize=512) : _b(_buf), _buf(initsize + BSONObj::Holder::extraBytes), _offset( BSONObj::Holder::extraBytes ), _s( this ) , _tracker(0) , _doneCalled(false) {
+            // ref-count and lazy field index slots
+            memset( _b.skip( BSONObj::Holder::extraBytes ), 0, BSONObj::Holder::extraBytes );
+            _b.skip(4); /*leave room for size field*/
         }
 
         /** @param baseBuilder construct a BSONObjBuilder using an existing BufBuilder
@@ -64,8 +65,9 @@ namespace mongo {
             _b.skip( 4 );
         }
 
-        BSONObjBuilder( const BSONSizeTracker & tracker ) : _b(_buf) , _buf(tracker.getSize() + sizeof(unsigned) ), _offset( sizeof(unsigned) ), _s( this ) , _tracker( (BSONSizeTracker*)(&tracker) ) , _doneCalled(false) {
-            _b.appendNum((unsigned)0); // ref-count
+        BSONObjBuilder( const BSONSizeTracker & tracker ) : _b(_buf) , _buf(tracker.getSize() + BSONObj::Holder::extraBytes ), _offset( BSONObj::Holder::extraBytes ), _s( this ) , _tracker( (BSONSizeTracker*)(&tracker) ) , _doneCalled(false) {
+            // ref-count and lazy field index slots
+            memset( _b.skip( BSONObj::Holder::extraBytes ), 0, BSONObj::Holder::extraBytes );
             _b.skip(4);
         }
 
@@ -25,6 +25,7 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/oid.h"
 #include "mongo/bson/util/atomic_int.h"
+#include "mongo/util/concurrency/threadlocal.h"
 
 #define verify MONGO_verify
 
@@ -96,10 +97,36 @@ namespace mongo {
         ourMachineAndPid = x;
     }
 
-    void OID::init() {
-        static AtomicUInt inc = static_cast<unsigned>(
-            scoped_ptr<SecureRandom>(SecureRandom::create())->nextInt64());
+    /* Counter values are handed to threads in blocks so concurrent inserts
+       don't all bounce one cache line: a thread touches the shared source
+       once per kOIDIncBlockSize OIDs and walks through its block with plain
+       unsynchronized arithmetic.  The blocks partition the same 24-bit
+       sequence the old per-call atomic increment walked, so uniqueness
+       within a (machine, pid, second) is unchanged; a thread's values are
+       still increasing between its refills.
+    */
+    struct OIDIncSegment {
+        OIDIncSegment() : next(0), left(0) {}
+        unsigned next;
+        unsigned left; // values remaining in this thread's block
+    };
+
+    namespace {
+        const unsigned kOIDIncBlockSize = 1024;
+    }
+
+    TSP_DECLARE(OIDIncSegment, oidIncSegment)
+    TSP_DEFINE(OIDIncSegment, oidIncSegment)
 
+    static unsigned nextOIDIncBlock() {
+        // the random starting point makes collision with a previous
+        // incarnation of this pid within the same second unlikely
+        static AtomicUInt32 incBlockSource( static_cast<unsigned>(
+            scoped_ptr<SecureRandom>( SecureRandom::create() )->nextInt64() ) );
+        return incBlockSource.fetchAndAdd( kOIDIncBlockSize );
+    }
+
+    void OID::init() {
         {
             unsigned t = (unsigned) time(0);
             unsigned char *T = (unsigned char *) &t;
@@ -112,7 +139,13 @@ namespace mongo {
         _machineAndPid = ourMachineAndPid;
 
         {
-            int new_inc = inc++;
+            OIDIncSegment& seg = *oidIncSegment.getMake();
+            if ( 0 == seg.left ) {
+                seg.next = nextOIDIncBlock();
+                seg.left = kOIDIncBlockSize;
+            }
+            unsigned new_inc = seg.next++;
+            seg.left--;
             unsigned char *T = (unsigned char *) &new_inc;
             _inc[0] = T[2];
             _inc[1] = T[1];
@@ -49,6 +49,10 @@ namespace mongo {
         // for woCompare...
         unsigned descending(unsigned mask) const { return bits & mask; }
 
+        /** true if no field is descending.  comparison loops dispatch on this
+            once and run a specialization with no per-field direction test. */
+        bool allAscending() const { return bits == 0; }
+
         /*operator std::string() const {
             StringBuilder buf;
             for ( unsigned i=0; i<nkeys; i++)
@@ -27,13 +27,42 @@
 
 namespace mongo {
 
+    namespace {
+        // A pooled connection is handed out without a liveness check if it was returned to
+        // the pool, or vouched for by the background cleaner (taskDoWork, which the
+        // PeriodicTaskRunner fires roughly once a minute), this recently.  Older ones get
+        // the synchronous poke they always did.
+        const time_t kRecheckIdleConnectionSecs = 90;
+    }
+
     // ------ PoolForHost ------
 
     PoolForHost::~PoolForHost() {
         clear();
     }
 
+    int PoolForHost::numAvailable() const {
+        scoped_lock lk( _mutex );
+        return (int)_pool.size();
+    }
+
+    long long PoolForHost::numCreated() const {
+        scoped_lock lk( _mutex );
+        return _created;
+    }
+
+    ConnectionString::ConnectionType PoolForHost::type() const {
+        scoped_lock lk( _mutex );
+        verify(_created);
+        return _type;
+    }
+
     void PoolForHost::clear() {
+        scoped_lock lk( _mutex );
+        _clear();
+    }
+
+    void PoolForHost::_clear() {
         while ( ! _pool.empty() ) {
             StoredConnection sc = _pool.top();
             delete sc.conn;
@@ -42,8 +71,9 @@ namespace mongo {
     }
 
     void PoolForHost::done( DBConnectionPool * pool, DBClientBase * c ) {
+        scoped_lock lk( _mutex );
         if (c->isFailed()) {
-            reportBadConnectionAt(c->getSockCreationMicroSec());
+            _reportBadConnectionAt(c->getSockCreationMicroSec());
             pool->onDestroy(c);
             delete c;
         }
@@ -58,35 +88,45 @@ namespace mongo {
     }
 
     void PoolForHost::reportBadConnectionAt(uint64_t microSec) {
+        scoped_lock lk( _mutex );
+        _reportBadConnectionAt(microSec);
+    }
+
+    void PoolForHost::_reportBadConnectionAt(uint64_t microSec) {
         if (microSec != DBClientBase::INVALID_SOCK_CREATION_TIME &&
                 microSec > _minValidCreationTimeMicroSec) {
             _minValidCreationTimeMicroSec = microSec;
             log() << "Detected bad connection created at " << _minValidCreationTimeMicroSec
                     << " microSec, clearing pool for " << _hostName
                     << " of " << _pool.size() << " connections" << endl;
-            clear();
+            _clear();
         }
     }
 
     bool PoolForHost::isBadSocketCreationTime(uint64_t microSec) {
+        scoped_lock lk( _mutex );
         return microSec != DBClientBase::INVALID_SOCK_CREATION_TIME &&
                 microSec <= _minValidCreationTimeMicroSec;
     }
 
     DBClientBase * PoolForHost::get( DBConnectionPool * pool , double socketTimeout ) {
+        scoped_lock lk( _mutex );
 
         time_t now = time(0);
-        
+
         while ( ! _pool.empty() ) {
             StoredConnection sc = _pool.top();
             _pool.pop();
-            
-            if ( ! sc.ok( now ) )  {
+
+            // Only poke connections that have sat here long enough for the background
+            // cleaner to have missed them; anything it vouched for recently goes
+            // straight out, keeping the checkout path free of socket syscalls.
+            if ( now - sc.when >= kRecheckIdleConnectionSecs && ! sc.ok( now ) )  {
                 pool->onDestroy( sc.conn );
                 delete sc.conn;
                 continue;
             }
-            
+
             verify( sc.conn->getSoTimeout() == socketTimeout );
 
             return sc.conn;
@@ -97,6 +137,7 @@ namespace mongo {
     }
 
     void PoolForHost::flush() {
+        scoped_lock lk( _mutex );
         vector<StoredConnection> all;
         while ( ! _pool.empty() ) {
             StoredConnection c = _pool.top();
@@ -125,17 +166,23 @@ namespace mongo {
     }
 
     void PoolForHost::getStaleConnections( vector<DBClientBase*>& stale ) {
+        scoped_lock lk( _mutex );
+
         time_t now = time(0);
 
         vector<StoredConnection> all;
         while ( ! _pool.empty() ) {
             StoredConnection c = _pool.top();
             _pool.pop();
-            
-            if ( c.ok( now ) )
+
+            if ( c.ok( now ) ) {
+                // Vouch for the connection so get() can skip its own liveness check.
+                c.when = now;
                 all.push_back( c );
-            else
+            }
+            else {
                 stale.push_back( c.conn );
+            }
         }
 
         for ( size_t i=0; i<all.size(); i++ ) {
@@ -155,12 +202,14 @@ namespace mongo {
     }
 
     void PoolForHost::createdOne( DBClientBase * base) {
+        scoped_lock lk( _mutex );
         if ( _created == 0 )
             _type = base->type();
         _created++;
     }
 
     void PoolForHost::initializeHostName(const std::string& hostName) {
+        scoped_lock lk( _mutex );
         if (_hostName.empty()) {
             _hostName = hostName;
         }
@@ -178,23 +227,25 @@ namespace mongo {
           _hooks( new list<DBConnectionHook*>() ) { 
     }
 
+    boost::shared_ptr<PoolForHost> DBConnectionPool::_getPool( const PoolKey& key ) {
+        scoped_lock L(_mutex);
+        boost::shared_ptr<PoolForHost>& p = _pools[key];
+        if ( ! p ) {
+            p.reset( new PoolForHost() );
+            p->initializeHostName( key.ident );
+        }
+        return p;
+    }
+
     DBClientBase* DBConnectionPool::_get(const string& ident , double socketTimeout ) {
         uassert(17382, "Can't use connection pool during shutdown",
                 !inShutdown());
-        scoped_lock L(_mutex);
-        PoolForHost& p = _pools[PoolKey(ident,socketTimeout)];
-        p.initializeHostName(ident);
-        return p.get( this , socketTimeout );
+        return _getPool( PoolKey(ident,socketTimeout) )->get( this , socketTimeout );
     }
 
     DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout , DBClientBase* conn ) {
-        {
-            scoped_lock L(_mutex);
-            PoolForHost& p = _pools[PoolKey(host,socketTimeout)];
-            p.initializeHostName(host);
-            p.createdOne( conn );
-        }
-        
+        _getPool( PoolKey(host,socketTimeout) )->createdOne( conn );
+
         try {
             onCreate( conn );
             onHandedOut( conn );
@@ -251,8 +302,7 @@ namespace mongo {
     }
 
     void DBConnectionPool::release(const string& host, DBClientBase *c) {
-        scoped_lock L(_mutex);
-        _pools[PoolKey(host,c->getSoTimeout())].done(this,c);
+        _getPool( PoolKey(host,c->getSoTimeout()) )->done(this,c);
     }
 
 
@@ -261,31 +311,48 @@ namespace mongo {
     }
 
     void DBConnectionPool::flush() {
-        scoped_lock L(_mutex);
-        for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); i++ ) {
-            PoolForHost& p = i->second;
-            p.flush();
+        vector< boost::shared_ptr<PoolForHost> > pools;
+        {
+            scoped_lock L(_mutex);
+            for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); i++ ) {
+                pools.push_back( i->second );
+            }
+        }
+        for ( size_t i=0; i<pools.size(); i++ ) {
+            pools[i]->flush();
         }
     }
 
     void DBConnectionPool::clear() {
-        scoped_lock L(_mutex);
-        LOG(2) << "Removing connections on all pools owned by " << _name  << endl;
-        for (PoolMap::iterator iter = _pools.begin(); iter != _pools.end(); ++iter) {
-            iter->second.clear();
+        vector< boost::shared_ptr<PoolForHost> > pools;
+        {
+            scoped_lock L(_mutex);
+            LOG(2) << "Removing connections on all pools owned by " << _name  << endl;
+            for (PoolMap::iterator iter = _pools.begin(); iter != _pools.end(); ++iter) {
+                pools.push_back( iter->second );
+            }
+        }
+        for ( size_t i=0; i<pools.size(); i++ ) {
+            pools[i]->clear();
         }
     }
 
     void DBConnectionPool::removeHost( const string& host ) {
-        scoped_lock L(_mutex);
-        LOG(2) << "Removing connections from all pools for host: " << host << endl;
-        for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); ++i ) {
-            const string& poolHost = i->first.ident;
-            if ( !serverNameCompare()(host, poolHost) && !serverNameCompare()(poolHost, host) ) {
-                // hosts are the same
-                i->second.clear();
+        vector< boost::shared_ptr<PoolForHost> > pools;
+        {
+            scoped_lock L(_mutex);
+            LOG(2) << "Removing connections from all pools for host: " << host << endl;
+            for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); ++i ) {
+                const string& poolHost = i->first.ident;
+                if ( !serverNameCompare()(host, poolHost) && !serverNameCompare()(poolHost, host) ) {
+                    // hosts are the same
+                    pools.push_back( i->second );
+                }
             }
         }
+        for ( size_t i=0; i<pools.size(); i++ ) {
+            pools[i]->clear();
+        }
     }
 
     void DBConnectionPool::addHook( DBConnectionHook * hook ) {
@@ -327,26 +394,35 @@ namespace mongo {
 
         map<ConnectionString::ConnectionType,long long> createdByType;
         
-        BSONObjBuilder bb( b.subobjStart( "hosts" ) );
+        vector< pair< PoolKey, boost::shared_ptr<PoolForHost> > > pools;
         {
             scoped_lock lk( _mutex );
             for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
-                if ( i->second.numCreated() == 0 )
-                    continue;
+                pools.push_back( make_pair( i->first, i->second ) );
+            }
+        }
+
+        BSONObjBuilder bb( b.subobjStart( "hosts" ) );
+        for ( size_t i=0; i<pools.size(); i++ ) {
+            PoolForHost& p = *pools[i].second;
+            long long hostCreated = p.numCreated();
+            if ( hostCreated == 0 )
+                continue;
+
+            int hostAvail = p.numAvailable();
 
-                string s = str::stream() << i->first.ident << "::" << i->first.timeout;
+            string s = str::stream() << pools[i].first.ident << "::" << pools[i].first.timeout;
 
-                BSONObjBuilder temp( bb.subobjStart( s ) );
-                temp.append( "available" , i->second.numAvailable() );
-                temp.appendNumber( "created" , i->second.numCreated() );
-                temp.done();
+            BSONObjBuilder temp( bb.subobjStart( s ) );
+            temp.append( "available" , hostAvail );
+            temp.appendNumber( "created" , hostCreated );
+            temp.done();
 
-                avail += i->second.numAvailable();
-                created += i->second.numCreated();
+            avail += hostAvail;
+            created += hostCreated;
 
-                long long& x = createdByType[i->second.type()];
-                x += i->second.numCreated();
-            }
+            long long& x = createdByType[p.type()];
+            x += hostCreated;
         }
         bb.done();
         
@@ -425,29 +501,31 @@ namespace mongo {
             return false;
         }
 
-        {
-            scoped_lock sl(_mutex);
-            PoolForHost& pool = _pools[PoolKey(hostName, conn->getSoTimeout())];
-            if (pool.isBadSocketCreationTime(conn->getSockCreationMicroSec())) {
-                return false;
-            }
+        boost::shared_ptr<PoolForHost> pool = _getPool(PoolKey(hostName, conn->getSoTimeout()));
+        if (pool->isBadSocketCreationTime(conn->getSockCreationMicroSec())) {
+            return false;
         }
 
         return true;
     }
 
-    void DBConnectionPool::taskDoWork() { 
+    void DBConnectionPool::taskDoWork() {
         vector<DBClientBase*> toDelete;
-        
+
+        vector< boost::shared_ptr<PoolForHost> > pools;
         {
-            // we need to get the connections inside the lock
-            // but we can actually delete them outside
             scoped_lock lk( _mutex );
             for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
-                i->second.getStaleConnections( toDelete );
+                pools.push_back( i->second );
             }
         }
 
+        // Check liveness outside the map lock; a checkout for one host at most waits
+        // behind the poke of that host's own idle connections.
+        for ( size_t i=0; i<pools.size(); i++ ) {
+            pools[i]->getStaleConnections( toDelete );
+        }
+
         for ( size_t i=0; i<toDelete.size(); i++ ) {
             try {
                 onDestroy( toDelete[i] );
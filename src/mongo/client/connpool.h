@@ -30,15 +30,15 @@ namespace mongo {
     class DBConnectionPool;
 
     /**
-     * not thread safe
-     * thread safety is handled by DBConnectionPool
+     * Thread safe; guards its own state with an internal lock so that checkouts
+     * against different hosts never contend with each other.
      */
     class MONGO_CLIENT_API PoolForHost {
     public:
         PoolForHost()
-            : _created(0), _minValidCreationTimeMicroSec(0) {}
+            : _mutex("PoolForHost"), _created(0), _minValidCreationTimeMicroSec(0) {}
 
-        PoolForHost( const PoolForHost& other ) {
+        PoolForHost( const PoolForHost& other ) : _mutex("PoolForHost") {
             verify(other._pool.size() == 0);
             _created = other._created;
             _minValidCreationTimeMicroSec = other._minValidCreationTimeMicroSec;
@@ -47,12 +47,12 @@ namespace mongo {
 
         ~PoolForHost();
 
-        int numAvailable() const { return (int)_pool.size(); }
+        int numAvailable() const;
 
         void createdOne( DBClientBase * base );
-        long long numCreated() const { return _created; }
+        long long numCreated() const;
 
-        ConnectionString::ConnectionType type() const { verify(_created); return _type; }
+        ConnectionString::ConnectionType type() const;
 
         /**
          * gets a connection or return NULL
@@ -95,9 +95,19 @@ namespace mongo {
             bool ok( time_t now );
 
             DBClientBase* conn;
+
+            // last time this connection was known good: when it was returned to the
+            // pool, or when the background cleaner last poked it
             time_t when;
         };
 
+        // Unlocked helpers for use by methods that already hold _mutex.
+        void _clear();
+        void _reportBadConnectionAt(uint64_t microSec);
+
+        // Guards everything below.  Never held while talking to another pool.
+        mutable mongo::mutex _mutex;
+
         std::string _hostName;
         std::stack<StoredConnection> _pool;
 
@@ -199,8 +209,16 @@ namespace mongo {
             bool operator()( const PoolKey& a , const PoolKey& b ) const;
         };
 
-        typedef map<PoolKey,PoolForHost,poolKeyCompare> PoolMap; // servername -> pool
+        typedef map<PoolKey,boost::shared_ptr<PoolForHost>,poolKeyCompare> PoolMap; // servername -> pool
+
+        /**
+         * Returns the per-host pool for key, creating it if needed.  _mutex is held
+         * only for the map lookup; callers then operate under the host's own lock.
+         */
+        boost::shared_ptr<PoolForHost> _getPool( const PoolKey& key );
 
+        // Guards _pools (the map itself); each PoolForHost guards its own contents,
+        // so two checkouts against different hosts only share this brief lookup.
         mongo::mutex _mutex;
         string _name;
 
@@ -938,13 +938,49 @@ namespace mongo {
         int sslModeVal = sslGlobalParams.sslMode.load();
         if (sslModeVal == SSLGlobalParams::SSLMode_preferSSL ||
             sslModeVal == SSLGlobalParams::SSLMode_requireSSL) {
-            return p->secure( sslManager(), _server.host() );
+            if ( !p->secure( sslManager(), _server.host() ) )
+                return false;
         }
 #endif
 
+        if ( _compressWire ) {
+            _negotiateWireCompression();
+        }
+
         return true;
     }
 
+    void DBClientConnection::_negotiateWireCompression() {
+        try {
+            BSONObj res;
+            if ( !runCommand( "admin",
+                              BSON( "ismaster" << 1 << "compression" << BSON_ARRAY( "snappy" ) ),
+                              res ) )
+                return;
+            BSONElement offered = res["compression"];
+            if ( offered.type() != Array )
+                return; // server predates wire compression, or has it disabled
+            BSONObjIterator it( offered.Obj() );
+            while ( it.more() ) {
+                BSONElement alg = it.next();
+                if ( alg.type() == String && alg.str() == "snappy" ) {
+                    // The server enabled its side before replying (the reply
+                    // above may already have come back compressed); now both
+                    // directions are snappy-framed.
+                    p->setWireCompression( true );
+                    return;
+                }
+            }
+        }
+        catch ( const DBException& e ) {
+            // Connection is still usable uncompressed (or has failed outright,
+            // which the next operation will surface); don't let negotiation
+            // turn connect() into a throwing call.
+            LOG(1) << "wire compression negotiation with " << toString()
+                   << " failed: " << e.what() << endl;
+        }
+    }
+
     void DBClientConnection::logout(const string& dbname, BSONObj& info){
         authCache.erase(dbname);
         runCommand(dbname, BSON("logout" << 1), info);
@@ -22,6 +22,7 @@
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/client/host_load_tracker.h"
 #include "mongo/client/replica_set_monitor.h"
 #include "mongo/client/sasl_client_authenticate.h"
 #include "mongo/db/dbmessage.h"
@@ -510,9 +511,15 @@ namespace {
                         break;
                     }
 
-                    auto_ptr<DBClientCursor> cursor = conn->query(ns, query,
-                            nToReturn, nToSkip, fieldsToReturn, queryOptions,
-                            batchSize);
+                    auto_ptr<DBClientCursor> cursor;
+                    {
+                        // Feeds the per-member in-flight count and latency
+                        // average that host selection consults.
+                        HostLoadTracker::ScopedOp op( _lastSlaveOkHost.toString() );
+                        cursor = conn->query(ns, query,
+                                nToReturn, nToSkip, fieldsToReturn, queryOptions,
+                                batchSize);
+                    }
 
                     return checkSlaveQueryResult(cursor);
                 }
@@ -570,6 +577,7 @@ namespace {
                         break;
                     }
 
+                    HostLoadTracker::ScopedOp op( _lastSlaveOkHost.toString() );
                     return conn->findOne(ns,query,fieldsToReturn,queryOptions);
                 }
                 catch ( const DBException &dbExcep ) {
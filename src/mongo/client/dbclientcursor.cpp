@@ -135,6 +135,14 @@ namespace mongo {
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        // After the initial reply an exhaust cursor's server streams further
+        // batches on its own; sending a getMore of our own would desynchronize
+        // the connection.  Just read the next reply off the socket.
+        if ( opts & QueryOption_Exhaust ) {
+            exhaustReceiveMore();
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
@@ -205,6 +213,8 @@ namespace mongo {
         batch.nReturned = qr->nReturned;
         batch.pos = 0;
         batch.data = qr->data();
+        batch.sharedBuf.reset(); // drop our reference to the previous batch's buffer
+        batch.msgSize = batch.m->size();
 
         _client->checkResponse( batch.data, batch.nReturned, &retry, &host ); // watches for "not master"
 
@@ -256,6 +266,36 @@ namespace mongo {
         return o;
     }
 
+    BSONObj DBClientCursor::nextShared() {
+        DEV _assertIfNull();
+        if ( !_putBack.empty() ) {
+            BSONObj ret = _putBack.top(); // already owned -- see putBack()
+            _putBack.pop();
+            return ret;
+        }
+
+        uassert(17569, "DBClientCursor nextShared() called but more() is false",
+                batch.pos < batch.nReturned);
+
+        if ( !batch.sharedBuf.isValid() ) {
+            // First object of this batch: try to take over the message's
+            // buffer.  Pooled and multi-segment messages decline; fall back
+            // to copying the object out as getOwned() would.
+            batch.sharedBuf = batch.m->releaseShared();
+            if ( !batch.sharedBuf.isValid() ) {
+                batch.pos++;
+                BSONObj o(batch.data);
+                batch.data += o.objsize();
+                return o.getOwned();
+            }
+        }
+
+        batch.pos++;
+        BSONObj o(batch.sharedBuf, batch.data);
+        batch.data += o.objsize();
+        return o;
+    }
+
     void DBClientCursor::peek(vector<BSONObj>& v, int atMost) {
         int m = atMost;
 
@@ -69,6 +69,16 @@ namespace mongo {
         */
         BSONObj next();
 
+        /** like next(), but the returned object is owned without being copied
+            out of the network buffer: it shares ownership of the batch's
+            buffer and remains valid after the next batch is fetched or the
+            cursor is destroyed.  Each object returned this way keeps the
+            whole batch's allocation alive, so only use this when (nearly)
+            every object of every batch is consumed and retained -- e.g. the
+            oplog fetcher -- otherwise prefer next()/getOwned().
+        */
+        BSONObj nextShared();
+
         /**
             restore an object previously returned by next() to the cursor
          */
@@ -85,6 +95,17 @@ namespace mongo {
             return o;
         }
 
+        /** nextShared() with the same { $err : ... } check as nextSafe() */
+        BSONObj nextSafeShared() {
+            BSONObj o = nextShared();
+            if( strcmp(o.firstElementFieldName(), "$err") == 0 ) {
+                string s = "nextSafeShared(): " + o.toString();
+                LOG(5) << s;
+                uasserted(17568, s);
+            }
+            return o;
+        }
+
         /** peek ahead at items buffered for future next() calls.
             never requests new data from the server.  so peek only effective
             with what is already buffered.
@@ -121,6 +142,15 @@ namespace mongo {
 
         bool tailable() const { return (opts & QueryOption_CursorTailable) != 0; }
 
+        /** an exhaust cursor the server has not finished streaming batches for.
+            the connection carries replies we have not read yet, so it cannot be
+            reused for anything else until the stream ends or the socket is
+            dropped.
+        */
+        bool exhaustPending() const {
+            return (opts & QueryOption_Exhaust) != 0 && cursorId != 0;
+        }
+
         /** see ResultFlagType (constants.h) for flag values
             mostly these flags are for internal purposes -
             ResultFlag_ErrSet is the possible exception to that
@@ -184,6 +214,11 @@ namespace mongo {
 
         Message* getMessage(){ return batch.m.get(); }
 
+        /** wire size of the current batch's message, in bytes; 0 if no batch
+            has been received.  Unlike getMessage()->size() this stays valid
+            after nextShared() releases the buffer out of the message. */
+        int currentBatchMessageSize() const { return batch.msgSize; }
+
         /**
          * Used mainly to run commands on connections that doesn't support lazy initialization and
          * does not support commands through the call interface.
@@ -205,11 +240,15 @@ namespace mongo {
         class Batch : boost::noncopyable {
             friend class DBClientCursor;
             auto_ptr<Message> m;
+            // set on first nextShared() of a batch: the message's buffer,
+            // released so returned objects can share it without copying
+            SharedBuffer sharedBuf;
+            int msgSize; // m->size() at receive time; survives releaseShared()
             int nReturned;
             int pos;
             const char *data;
         public:
-            Batch() : m( new Message() ), nReturned(), pos(), data() { }
+            Batch() : m( new Message() ), msgSize(), nReturned(), pos(), data() { }
         };
 
     private:
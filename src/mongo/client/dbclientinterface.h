@@ -1196,7 +1196,8 @@ namespace mongo {
            Connect timeout is fixed, but short, at 5 seconds.
          */
         DBClientConnection(bool _autoReconnect=false, DBClientReplicaSet* cp=0, double so_timeout=0) :
-            clientSet(cp), _failed(false), autoReconnect(_autoReconnect), autoReconnectBackoff(1000, 2000), _so_timeout(so_timeout) {
+            clientSet(cp), _failed(false), autoReconnect(_autoReconnect), autoReconnectBackoff(1000, 2000), _so_timeout(so_timeout),
+            _compressWire(false) {
             _numConnections++;
         }
 
@@ -1302,6 +1303,15 @@ namespace mongo {
         void setSoTimeout(double timeout);
         double getSoTimeout() const { return _so_timeout; }
 
+        /**
+         * Requests snappy wire compression when (re)connecting; call before
+         * connect().  Negotiation rides on isMaster and quietly falls back to
+         * uncompressed transport against servers that don't offer snappy.
+         * Worthwhile on bandwidth-bound links (e.g. oplog tailing between
+         * datacenters); a cpu-for-bandwidth trade everywhere else.
+         */
+        void setWireCompression( bool tryCompress ) { _compressWire = tryCompress; }
+
         virtual bool lazySupported() const { return true; }
 
         static int getNumConnections() {
@@ -1346,7 +1356,9 @@ namespace mongo {
 
         map<string, BSONObj> authCache;
         double _so_timeout;
+        bool _compressWire;
         bool _connect( string& errmsg );
+        void _negotiateWireCompression();
 
         static AtomicUInt _numConnections;
         static bool _lazyKillCursor; // lazy means we piggy back kill cursors on next op
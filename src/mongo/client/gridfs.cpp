@@ -30,6 +30,7 @@
 #endif
 
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/util/md5.hpp"
 
 #ifndef MIN
 #define MIN(a,b) ( (a) < (b) ? (a) : (b) )
@@ -40,6 +41,10 @@ namespace mongo {
 
     const unsigned DEFAULT_CHUNK_SIZE = 256 * 1024;
 
+    // Chunk inserts are batched into messages of roughly this size, so the
+    // wire sees a few large inserts instead of one small message per chunk.
+    const unsigned MAX_PENDING_CHUNK_BYTES = 4 * 1024 * 1024;
+
     GridFSChunk::GridFSChunk( BSONObj o ) {
         _data = o;
     }
@@ -75,6 +80,22 @@ namespace mongo {
         return _chunkSize;
     }
 
+    void GridFS::_queueChunk( vector<BSONObj>& pending , unsigned& pendingBytes ,
+                              const GridFSChunk& chunk ) {
+        pending.push_back( chunk._data );
+        pendingBytes += chunk._data.objsize();
+        if ( pendingBytes >= MAX_PENDING_CHUNK_BYTES )
+            _flushChunks( pending , pendingBytes );
+    }
+
+    void GridFS::_flushChunks( vector<BSONObj>& pending , unsigned& pendingBytes ) {
+        if ( pending.empty() )
+            return;
+        _client.insert( _chunksNS.c_str() , pending );
+        pending.clear();
+        pendingBytes = 0;
+    }
+
     BSONObj GridFS::storeFile( const char* data , size_t length , const string& remoteName , const string& contentType) {
         char const * const end = data + length;
 
@@ -82,17 +103,28 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        md5_state_t md5state;
+        md5_init( &md5state );
+
+        vector<BSONObj> pending;
+        unsigned pendingBytes = 0;
+
         int chunkNumber = 0;
         while (data < end) {
             int chunkLen = MIN(_chunkSize, (unsigned)(end-data));
             GridFSChunk c(idObj, chunkNumber, data, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            md5_append( &md5state , (const md5_byte_t*)data , chunkLen );
+            _queueChunk( pending , pendingBytes , c );
 
             chunkNumber++;
             data += chunkLen;
         }
+        _flushChunks( pending , pendingBytes );
 
-        return insertFile(remoteName, id, length, contentType);
+        md5digest digest;
+        md5_finish( &md5state , digest );
+
+        return insertFile(remoteName, id, length, contentType, digestToString(digest));
     }
 
 
@@ -110,6 +142,12 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        md5_state_t md5state;
+        md5_init( &md5state );
+
+        vector<BSONObj> pending;
+        unsigned pendingBytes = 0;
+
         int chunkNumber = 0;
         gridfs_offset length = 0;
         while (!feof(fd)) {
@@ -126,20 +164,27 @@ namespace mongo {
             }
 
             GridFSChunk c(idObj, chunkNumber, buf, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            md5_append( &md5state , (const md5_byte_t*)buf , chunkLen );
+            _queueChunk( pending , pendingBytes , c );
 
             length += chunkLen;
             chunkNumber++;
             delete[] buf;
         }
+        _flushChunks( pending , pendingBytes );
 
         if (fd != stdin)
             fclose( fd );
 
-        return insertFile((remoteName.empty() ? fileName : remoteName), id, length, contentType);
+        md5digest digest;
+        md5_finish( &md5state , digest );
+
+        return insertFile((remoteName.empty() ? fileName : remoteName), id, length, contentType,
+                          digestToString(digest));
     }
 
-    BSONObj GridFS::insertFile(const string& name, const OID& id, gridfs_offset length, const string& contentType) {
+    BSONObj GridFS::insertFile(const string& name, const OID& id, gridfs_offset length,
+                               const string& contentType, const string& md5) {
         // Wait for any pending writebacks to finish
         BSONObj errObj = _client.getLastErrorDetailed();
         uassert( 16428,
@@ -147,16 +192,16 @@ namespace mongo {
                                << ", error: " << errObj,
                  DBClientWithCommands::getLastErrorString(errObj) == "" );
 
-        BSONObj res;
-        if ( ! _client.runCommand( _dbName.c_str() , BSON( "filemd5" << id << "root" << _prefix ) , res ) )
-            throw UserException( 9008 , "filemd5 failed" );
+        // The md5 was computed incrementally as the chunks streamed out, so
+        // there is no need for the filemd5 command, which would make the
+        // server re-read every chunk just to hash it.
 
         BSONObjBuilder file;
         file << "_id" << id
              << "filename" << name
              << "chunkSize" << _chunkSize
              << "uploadDate" << DATENOW
-             << "md5" << res["md5"]
+             << "md5" << md5
              ;
 
         if (length < 1024*1024*1024) { // 2^30
@@ -232,14 +277,37 @@ namespace mongo {
 
         const int num = getNumChunks();
 
-        for ( int i=0; i<num; i++ ) {
-            GridFSChunk c = getChunk( i );
+        // One query sorted by chunk number streams the whole file; every
+        // cursor batch carries many chunks, so the per-chunk round trip of
+        // getChunk() is paid only once per batch.
+        BSONObjBuilder b;
+        b.appendAs( _obj["_id"] , "files_id" );
+        auto_ptr<DBClientCursor> cursor =
+            _grid->_client.query( _grid->_chunksNS ,
+                                  Query( b.obj() ).sort( BSON( "n" << 1 ) ) );
+        uassert( 17437 , "query on chunks failed" , cursor.get() );
+
+        int n = 0;
+        while ( cursor->more() ) {
+            BSONObj o = cursor->nextSafe();
+            uassert( 17438 ,
+                     str::stream() << "chunk " << n << " missing for file "
+                                   << getFilename() << ", got chunk "
+                                   << o["n"].numberInt(),
+                     o["n"].numberInt() == n );
+            GridFSChunk c( o );
 
             int len;
             const char * data = c.data( len );
             out.write( data , len );
+            n++;
         }
 
+        uassert( 17439 ,
+                 str::stream() << "expected " << num << " chunks for file "
+                               << getFilename() << " but got " << n,
+                 n == num );
+
         return getContentLength();
     }
 
@@ -128,8 +128,19 @@ namespace mongo {
         string _chunksNS;
         unsigned int _chunkSize;
 
+        // queues a chunk for insertion, sending the pending batch once it is
+        // large enough
+        void _queueChunk( vector<BSONObj>& pending , unsigned& pendingBytes ,
+                          const GridFSChunk& chunk );
+
+        // sends any queued chunks
+        void _flushChunks( vector<BSONObj>& pending , unsigned& pendingBytes );
+
         // insert fileobject. All chunks must be in DB.
-        BSONObj insertFile(const string& name, const OID& id, gridfs_offset length, const string& contentType);
+        // md5 is the digest of the file's contents, computed while the chunks
+        // streamed out.
+        BSONObj insertFile(const string& name, const OID& id, gridfs_offset length,
+                           const string& contentType, const string& md5);
 
         friend class GridFile;
     };
@@ -0,0 +1,96 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/client/host_load_tracker.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    struct HostLoadTracker::Entry {
+        Entry() : outstanding( 0 ), ewmaMicros( -1 ) {}
+
+        AtomicInt32 outstanding;
+        AtomicInt64 ewmaMicros; // -1 until the first request completes
+    };
+
+    namespace {
+        HostLoadTracker globalHostLoadTracker;
+    }
+
+    // static
+    HostLoadTracker& HostLoadTracker::get() {
+        return globalHostLoadTracker;
+    }
+
+    HostLoadTracker::Entry* HostLoadTracker::_getEntry( const std::string& host ) {
+        scoped_spinlock lk( _lock );
+        Entry*& entry = _hosts[host];
+        if ( !entry )
+            entry = new Entry();
+        return entry;
+    }
+
+    const HostLoadTracker::Entry* HostLoadTracker::_findEntry(
+            const std::string& host ) const {
+        scoped_spinlock lk( _lock );
+        HostMap::const_iterator it = _hosts.find( host );
+        return it == _hosts.end() ? NULL : it->second;
+    }
+
+    void HostLoadTracker::opStarted( const std::string& host ) {
+        _getEntry( host )->outstanding.fetchAndAdd( 1 );
+    }
+
+    void HostLoadTracker::opFinished( const std::string& host , long long micros ) {
+        Entry* entry = _getEntry( host );
+        entry->outstanding.fetchAndSubtract( 1 );
+
+        // Same smoothing as the replica set monitor's ping latency: move a
+        // quarter of the way to the new sample.  The load/store pair can race
+        // with a concurrent update; losing a sample now and then is fine.
+        long long old = entry->ewmaMicros.load();
+        if ( old < 0 )
+            entry->ewmaMicros.store( micros );
+        else
+            entry->ewmaMicros.store( old + ( micros - old ) / 4 );
+    }
+
+    int HostLoadTracker::outstanding( const std::string& host ) const {
+        const Entry* entry = _findEntry( host );
+        return entry ? entry->outstanding.load() : 0;
+    }
+
+    long long HostLoadTracker::smoothedMicros( const std::string& host ) const {
+        const Entry* entry = _findEntry( host );
+        return entry ? entry->ewmaMicros.load() : -1;
+    }
+
+    void HostLoadTracker::appendInfo( BSONObjBuilder& b ) const {
+        BSONArrayBuilder arr( b.subarrayStart( "hostLoad" ) );
+        scoped_spinlock lk( _lock );
+        for ( HostMap::const_iterator it = _hosts.begin(); it != _hosts.end(); ++it ) {
+            BSONObjBuilder bb( arr.subobjStart() );
+            bb.append( "host", it->first );
+            bb.append( "outstanding", it->second->outstanding.load() );
+            bb.append( "avgRequestMs",
+                       static_cast<long long>( it->second->ewmaMicros.load() / 1000 ) );
+            bb.done();
+        }
+        arr.done();
+    }
+
+}  // namespace mongo
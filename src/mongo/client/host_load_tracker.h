@@ -0,0 +1,99 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "mongo/client/export_macros.h"
+#include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Process-wide record of how busy each remote host looks from here: how
+     * many of our requests are currently in flight to it, and a smoothed
+     * average of how long its recent requests took.
+     *
+     * The connection layers feed this (ShardConnection checkouts for shards,
+     * the slaveOk read paths of DBClientReplicaSet for individual set members)
+     * and host selection reads it, so a read that could go to any of several
+     * members can steer away from one that is slow or already has a queue of
+     * our requests - a member warming its page cache, say - instead of
+     * dragging every scatter-gather down to its speed.
+     *
+     * All methods are thread safe.  Entries are never removed; the map is
+     * bounded by the number of distinct hosts this process talks to.
+     */
+    class MONGO_CLIENT_API HostLoadTracker {
+    public:
+        static HostLoadTracker& get();
+
+        HostLoadTracker() {}
+
+        /** Records that a request to 'host' was dispatched. */
+        void opStarted( const std::string& host );
+
+        /**
+         * Records that a request to 'host' completed (in success or failure)
+         * after 'micros'.  Must pair with an earlier opStarted.
+         */
+        void opFinished( const std::string& host , long long micros );
+
+        /** Number of requests currently in flight from this process to 'host'. */
+        int outstanding( const std::string& host ) const;
+
+        /**
+         * Smoothed request latency for 'host' in microseconds, or -1 if no
+         * request to it has completed yet.
+         */
+        long long smoothedMicros( const std::string& host ) const;
+
+        /** Appends per-host load info, for shardConnPoolStats. */
+        void appendInfo( BSONObjBuilder& b ) const;
+
+        /** RAII helper bracketing one request to one host. */
+        class ScopedOp {
+        public:
+            explicit ScopedOp( const std::string& host ) : _host( host ) {
+                HostLoadTracker::get().opStarted( _host );
+            }
+            ~ScopedOp() {
+                HostLoadTracker::get().opFinished( _host , _timer.micros() );
+            }
+        private:
+            const std::string _host;
+            Timer _timer;
+        };
+
+    private:
+        struct Entry;
+
+        // Creates the entry if needed; returned pointers are never invalidated.
+        Entry* _getEntry( const std::string& host );
+        const Entry* _findEntry( const std::string& host ) const;
+
+        // Protects only lookup/creation in _hosts; the counters inside an
+        // Entry are atomics.
+        mutable SpinLock _lock;
+        typedef std::map<std::string, Entry*> HostMap;
+        HostMap _hosts;
+    };
+
+}  // namespace mongo
@@ -29,7 +29,10 @@
 #include "mongo/s/config.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/shard.h"
+#include "mongo/s/shard_key_encoding.h"
 #include "mongo/s/version_manager.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/socket_poll.h"
 
 namespace mongo {
 
@@ -253,6 +256,138 @@ namespace mongo {
         _done = true;
     }
 
+    // --------  ParallelSortMergeTree -----------
+
+    // defined in jsobj.cpp; woSortOrder compares missing fields as this
+    extern BSONObj staticNull;
+
+    ParallelSortMergeTree::ParallelSortMergeTree( FilteringClientCursor* cursors,
+                                                  int numCursors,
+                                                  const BSONObj& sortKey )
+        : _cursors( cursors ),
+          _numCursors( numCursors ),
+          _sortKey( sortKey ),
+          _usable( true ),
+          _keys( numCursors ),
+          _exhausted( numCursors, false ),
+          _tree( numCursors, -1 ) {
+
+        verify( numCursors > 1 );
+        verify( ! sortKey.isEmpty() );
+
+        for ( int i = 0; i < _numCursors; i++ ) {
+            _reload( i );
+            if ( ! _usable )
+                return;
+            _seed( i );
+        }
+    }
+
+    int ParallelSortMergeTree::best() const {
+        int winner = _tree[0];
+        if ( winner < 0 || _exhausted[winner] )
+            return -1;
+        return winner;
+    }
+
+    void ParallelSortMergeTree::advanced( int i ) {
+        _reload( i );
+        if ( ! _usable )
+            return;
+
+        // replay i's matches on the way to the root - winners move up,
+        // losers stay behind
+        int winner = i;
+        for ( int node = ( i + _numCursors ) / 2; node >= 1; node /= 2 ) {
+            if ( _lessThan( _tree[node], winner ) )
+                std::swap( winner, _tree[node] );
+        }
+        _tree[0] = winner;
+    }
+
+    bool ParallelSortMergeTree::_lessThan( int a, int b ) const {
+        if ( a < 0 )
+            return false; // an empty slot during seeding loses to everyone
+        if ( b < 0 )
+            return true;
+
+        if ( _exhausted[a] != _exhausted[b] )
+            return ! _exhausted[a]; // live streams sort before drained ones
+        if ( _exhausted[a] )
+            return a < b;
+
+        const int cmp = _keys[a].compare( _keys[b] );
+        if ( cmp != 0 )
+            return cmp < 0;
+        return a < b; // deterministic tie break by cursor position
+    }
+
+    void ParallelSortMergeTree::_reload( int leaf ) {
+        FilteringClientCursor& cursor = _cursors[leaf];
+
+        if ( ! cursor.more() ) {
+            _exhausted[leaf] = true;
+            _keys[leaf].clear();
+            if ( cursor.rawMData() )
+                cursor.rawMData()->pcState->done = true;
+            return;
+        }
+
+        _exhausted[leaf] = false;
+        if ( ! _encodeSortKey( cursor.peek(), &_keys[leaf] ) ) {
+            // can't represent this sort key; revert to the woSortOrder scan
+            _usable = false;
+        }
+    }
+
+    void ParallelSortMergeTree::_seed( int leaf ) {
+        int winner = leaf;
+        int node = ( leaf + _numCursors ) / 2;
+
+        while ( node >= 1 && _tree[node] >= 0 ) {
+            if ( _lessThan( _tree[node], winner ) )
+                std::swap( winner, _tree[node] );
+            node /= 2;
+        }
+
+        if ( node >= 1 )
+            _tree[node] = winner;
+        else
+            _tree[0] = winner;
+    }
+
+    bool ParallelSortMergeTree::_encodeSortKey( const BSONObj& doc,
+                                                std::string* encoded ) const {
+        encoded->clear();
+
+        // woSortOrder sorts an empty document before everything, as does the
+        // empty encoding
+        if ( doc.isEmpty() )
+            return true;
+
+        BSONObjIterator i( _sortKey );
+        while ( i.more() ) {
+            BSONElement f = i.next();
+
+            BSONElement value = doc.getFieldDotted( f.fieldName() );
+            if ( value.eoo() )
+                value = staticNull.firstElement(); // missing compares as null
+
+            const size_t fieldStart = encoded->size();
+            if ( ! encodeKeyElementForMemcmp( value, encoded ) )
+                return false;
+
+            if ( f.number() < 0 ) {
+                // each value's encoding is prefix-free, so inverting its
+                // bytes inverts its memcmp order
+                for ( size_t j = fieldStart; j < encoded->size(); j++ )
+                    ( *encoded )[j] = static_cast<char>( ~( *encoded )[j] );
+            }
+        }
+
+        return true;
+    }
+
     // --------  ParallelSortClusteredCursor -----------
 
     ParallelSortClusteredCursor::ParallelSortClusteredCursor( const QuerySpec& qSpec, const CommandInfo& cInfo )
@@ -290,6 +425,7 @@ namespace mongo {
         _numServers = _servers.size();
         _lastFrom = 0;
         _cursors = 0;
+        _mergeTree = 0;
 
         if( ! _qSpec.isEmpty() ){
 
@@ -911,6 +1047,72 @@ namespace mongo {
 
     }
 
+    namespace {
+
+        /**
+         * @return the raw socket fd behind a lazily-init'd shard cursor, or -1
+         * when there is nothing pollable (no conn, or not a plain single
+         * connection).
+         */
+        int lazyCursorSocketFd( const PCMData& mdata ) {
+            if ( !mdata.pcState || !mdata.pcState->conn )
+                return -1;
+            DBClientConnection* conn =
+                dynamic_cast<DBClientConnection*>( mdata.pcState->conn->getRawConn() );
+            if ( !conn || conn->isFailed() )
+                return -1;
+            return conn->port().psock->rawFD();
+        }
+
+        typedef map< Shard, PCMData >::iterator CursorMapIter;
+
+        /**
+         * Orders the shards so that the ones whose responses have already
+         * arrived are finished first - one slow shard then no longer delays
+         * handling (and possibly retrying) everyone else's replies.  Shards we
+         * cannot poll go first, in map order; if the wire stays quiet for a
+         * second the remainder is processed in map order as before, leaving
+         * the blocking recv to enforce socket timeouts.
+         */
+        void orderCursorsByReadiness( map< Shard, PCMData >& cursorMap,
+                                      vector<CursorMapIter>* order ) {
+            vector<CursorMapIter> pollable;
+
+            for ( CursorMapIter i = cursorMap.begin(); i != cursorMap.end(); ++i ) {
+                const bool needsFinish = i->second.pcState && !i->second.finished;
+                if ( needsFinish && isPollSupported() && lazyCursorSocketFd( i->second ) >= 0 )
+                    pollable.push_back( i );
+                else
+                    order->push_back( i );
+            }
+
+            while ( pollable.size() > 1 ) {
+
+                vector<pollfd> fds( pollable.size() );
+                for ( size_t i = 0; i < pollable.size(); i++ ) {
+                    fds[i].fd = lazyCursorSocketFd( pollable[i]->second );
+                    fds[i].events = POLLIN;
+                    fds[i].revents = 0;
+                }
+
+                if ( socketPoll( &fds[0], fds.size(), 1000 ) <= 0 )
+                    break;
+
+                vector<CursorMapIter> stillWaiting;
+                for ( size_t i = 0; i < pollable.size(); i++ ) {
+                    // errored sockets count as ready - their recv fails fast
+                    if ( fds[i].revents )
+                        order->push_back( pollable[i] );
+                    else
+                        stillWaiting.push_back( pollable[i] );
+                }
+                pollable.swap( stillWaiting );
+            }
+
+            order->insert( order->end(), pollable.begin(), pollable.end() );
+        }
+    }
+
     void ParallelSortClusteredCursor::finishInit(){
 
         bool returnPartial = ( _qSpec.options() & QueryOption_PartialResults );
@@ -922,8 +1124,13 @@ namespace mongo {
 
         LOG( pc ) << "finishing over " << _cursorMap.size() << " shards" << endl;
 
-        for( map< Shard, PCMData >::iterator i = _cursorMap.begin(), end = _cursorMap.end(); i != end; ++i ){
+        vector<CursorMapIter> finishOrder;
+        orderCursorsByReadiness( _cursorMap, &finishOrder );
+
+        for( vector<CursorMapIter>::const_iterator oi = finishOrder.begin();
+             oi != finishOrder.end(); ++oi ){
 
+            const CursorMapIter& i = *oi;
             const Shard& shard = i->first;
             PCMData& mdata = i->second;
 
@@ -1445,6 +1652,9 @@ namespace mongo {
             for( int i = 0; i < _numServers; i++ ) _cursors[i].release();
         }
 
+        delete _mergeTree;
+        _mergeTree = 0;
+
         delete [] _cursors;
         _cursors = 0;
 
@@ -1477,6 +1687,43 @@ namespace mongo {
     }
 
     BSONObj ParallelSortClusteredCursor::next() {
+
+        // For sorted results over more than one server, pick the next
+        // document through the merge tree instead of scanning every cursor.
+        if ( ! _sortKey.isEmpty() && _numServers > 1 ) {
+
+            if ( ! _mergeTree )
+                _mergeTree = new ParallelSortMergeTree( _cursors, _numServers, _sortKey );
+
+            if ( _mergeTree->usable() ) {
+                const int mergeFrom = _mergeTree->best();
+                uassert( 10019 ,  "no more elements" , mergeFrom >= 0 );
+
+                BSONObj ret;
+                try {
+                    ret = _cursors[mergeFrom].next();
+                }
+                catch ( ... ) {
+                    // the head documents are in an unknown state now; start
+                    // over if the caller retries
+                    delete _mergeTree;
+                    _mergeTree = 0;
+                    throw;
+                }
+
+                _lastFrom = mergeFrom;
+
+                if( _cursors[mergeFrom].rawMData() )
+                    _cursors[mergeFrom].rawMData()->pcState->count++;
+
+                // the merge tree may turn itself off here; the scan below
+                // takes over from wherever it stopped
+                _mergeTree->advanced( mergeFrom );
+
+                return ret;
+            }
+        }
+
         BSONObj best = BSONObj();
         int bestFrom = -1;
 
@@ -68,6 +68,7 @@ namespace mongo {
 
     class ParallelConnectionMetadata;
     class FilteringClientCursor;
+    class ParallelSortMergeTree;
 
     class MONGO_CLIENT_API CommandInfo {
     public:
@@ -229,6 +230,7 @@ namespace mongo {
         BSONObj _sortKey;
 
         FilteringClientCursor * _cursors;
+        ParallelSortMergeTree * _mergeTree;
         int _needToSkip;
 
         /**
@@ -291,6 +293,66 @@ namespace mongo {
         bool _done;
     };
 
+    /**
+     * Streaming k-way merge over the sorted cursor array above.
+     *
+     * Keeps a loser tree (a tournament tree whose internal nodes remember
+     * the loser of each match and whose root holds the overall winner) over
+     * each cursor's head document, so selecting the next document in sort
+     * order costs about log2(k) comparisons instead of the k - 1 of a linear
+     * scan.  Heads are compared through memcmp-comparable encodings of their
+     * sort key values, built once per document instead of one woSortOrder
+     * call per comparison.
+     *
+     * The encoding cannot represent every BSON value (see
+     * s/shard_key_encoding.h): on the first head document whose sort key
+     * fails to encode the tree permanently turns itself off - usable() goes
+     * false - and the caller reverts to the linear woSortOrder scan.
+     */
+    class MONGO_CLIENT_API ParallelSortMergeTree {
+    public:
+        /** Requires numCursors > 1 and a non-empty sortKey. */
+        ParallelSortMergeTree( FilteringClientCursor* cursors,
+                               int numCursors,
+                               const BSONObj& sortKey );
+
+        bool usable() const { return _usable; }
+
+        /**
+         * @return index of the cursor whose head document sorts first, or -1
+         * if every cursor is exhausted.  Only meaningful while usable().
+         */
+        int best() const;
+
+        /**
+         * Re-seeds cursor i's leaf after its head document was consumed
+         * with next().
+         */
+        void advanced( int i );
+
+    private:
+        /** @return true if cursor a's head sorts strictly before cursor b's. */
+        bool _lessThan( int a, int b ) const;
+
+        /** Re-encodes leaf's head; may clear _usable. */
+        void _reload( int leaf );
+
+        /** Plays leaf up the tree during construction, parking at the first
+         *  empty node. */
+        void _seed( int leaf );
+
+        bool _encodeSortKey( const BSONObj& doc, std::string* encoded ) const;
+
+        FilteringClientCursor* _cursors; // not owned
+        int _numCursors;
+        BSONObj _sortKey;
+        bool _usable;
+
+        std::vector<std::string> _keys; // encoded sort key of each cursor's head
+        std::vector<bool> _exhausted;
+        std::vector<int> _tree; // _tree[0] the winner, the rest losers
+    };
+
     /**
      * Generally clients should be using Strategy::commandOp() wherever possible - the Future API
      * does not handle versioning.
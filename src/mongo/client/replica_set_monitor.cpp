@@ -20,6 +20,7 @@
 #include <limits>
 
 #include "mongo/client/connpool.h"
+#include "mongo/client/host_load_tracker.h"
 #include "mongo/client/replica_set_monitor_internal.h"
 #include "mongo/util/concurrency/mutex.h" // for StaticObserver
 #include "mongo/util/background.h"
@@ -83,7 +84,8 @@ namespace {
         ReplicaSetMonitorWatcher():
             _monitorMutex("ReplicaSetMonitorWatcher::_safego"),
             _started(false),
-            _stopRequested(false) {
+            _stopRequested(false),
+            _checkRequested(false) {
         }
 
         ~ReplicaSetMonitorWatcher() {
@@ -119,6 +121,17 @@ namespace {
             _stopRequestedCV.notify_one();
         }
 
+        /**
+         * Wakes the watcher so the next round of checks starts now instead of at the end
+         * of the current sleep. Called when a monitor learns its primary went down, so
+         * rerouting doesn't have to wait out the polling interval.
+         */
+        void checkNow() {
+            scoped_lock sl( _monitorMutex );
+            _checkRequested = true;
+            _stopRequestedCV.notify_one();
+        }
+
     protected:
         void run() {
             log() << "starting"; // includes thread name in output
@@ -156,7 +169,11 @@ namespace {
                     break;
                 }
 
-                _stopRequestedCV.timed_wait(sl.boost(), boost::posix_time::seconds(10));
+                // skip the sleep if someone asked for a check while we were checking
+                if ( !_checkRequested ) {
+                    _stopRequestedCV.timed_wait(sl.boost(), boost::posix_time::seconds(10));
+                }
+                _checkRequested = false;
             }
         }
 
@@ -186,12 +203,13 @@ namespace {
             }
         }
 
-        // protects _started, _stopRequested
+        // protects _started, _stopRequested, _checkRequested
         mongo::mutex _monitorMutex;
         bool _started;
 
         boost::condition _stopRequestedCV;
         bool _stopRequested;
+        bool _checkRequested;
     } replicaSetMonitorWatcher;
 
     StaticObserver staticObserver;
@@ -258,10 +276,14 @@ namespace {
 
     HostAndPort ReplicaSetMonitor::getHostOrRefresh(const ReadPreferenceSetting& criteria) {
         {
-            boost::mutex::scoped_lock lk(_state->mutex);
-            HostAndPort out = _state->getMatchingHost(criteria);
-            if (!out.empty())
-                return out;
+            // Fast path: select against the latest published snapshot, so callers don't
+            // queue up on the mutex behind a refresh round that is off doing network IO.
+            const boost::shared_ptr<const Nodes> snap = _state->getSnapshot();
+            if (snap) {
+                HostAndPort out = _state->getMatchingHostIn(*snap, criteria);
+                if (!out.empty())
+                    return out;
+            }
         }
 
         {
@@ -295,11 +317,23 @@ namespace {
     }
 
     void ReplicaSetMonitor::failedHost(const HostAndPort& host) {
-        boost::mutex::scoped_lock lk(_state->mutex);
-        Node* node = _state->findNode(host);
-        if (node)
-            node->markFailed();
-        DEV _state->checkInvariants();
+        bool wasMaster = false;
+        {
+            boost::mutex::scoped_lock lk(_state->mutex);
+            Node* node = _state->findNode(host);
+            if (node) {
+                wasMaster = node->isMaster;
+                node->markFailed();
+                _state->publishSnapshot();
+            }
+            DEV _state->checkInvariants();
+        }
+
+        if (wasMaster) {
+            // losing the primary is what callers block on, so don't make rerouting wait
+            // out the rest of the watcher's polling interval to find the new one
+            replicaSetMonitorWatcher.checkNow();
+        }
     }
 
     bool ReplicaSetMonitor::isPrimary(const HostAndPort& host) const {
@@ -466,6 +500,7 @@ namespace {
 
         // If we haven't yet found a master, try contacting unconfirmed hosts
         if (_scan->hostsToScan.empty() && !_scan->foundUpMaster) {
+            scoped_spinlock lk(_set->selectionLock); // rand is shared with snapshot selection
             _scan->enqueAllUntriedHosts(_scan->possibleNodes, _set->rand);
             _scan->possibleNodes.clear();
         }
@@ -503,6 +538,8 @@ namespace {
                       << " more failed checks";
             }
 
+            _set->publishSnapshot();
+
             _set->currentScan.reset(); // Makes sure all other Refreshers in this round return DONE
             return NextStep(NextStep::DONE);
         }
@@ -552,6 +589,8 @@ namespace {
         // connectible host that is that claims to be in the set.
         _scan->foundAnyUpNodes = true;
 
+        _set->publishSnapshot();
+
         // TODO consider only notifying if we've updated a node or we've emptied waitingFor.
         _set->cv.notify_all();
 
@@ -567,8 +606,10 @@ namespace {
             _set->cv.notify_all();
 
         Node* node = _set->findNode(host);
-        if (node)
+        if (node) {
             node->markFailed();
+            _set->publishSnapshot();
+        }
     }
 
     ScanStatePtr Refresher::startNewScan(const SetState* set) {
@@ -596,12 +637,15 @@ namespace {
         }
 
         // shuffle the queue, but keep "up" nodes at the front
-        std::random_shuffle(scan->hostsToScan.begin(),
-                            scan->hostsToScan.begin() + upNodes,
-                            set->rand);
-        std::random_shuffle(scan->hostsToScan.begin() + upNodes,
-                            scan->hostsToScan.end(),
-                            set->rand);
+        {
+            scoped_spinlock lk(set->selectionLock); // rand is shared with snapshot selection
+            std::random_shuffle(scan->hostsToScan.begin(),
+                                scan->hostsToScan.begin() + upNodes,
+                                set->rand);
+            std::random_shuffle(scan->hostsToScan.begin() + upNodes,
+                                scan->hostsToScan.end(),
+                                set->rand);
+        }
 
         if (!set->lastSeenMaster.empty()) {
             // move lastSeenMaster to front of queue
@@ -647,7 +691,10 @@ namespace {
             // replace hostToScan queue with untried normal hosts. can both add and remove
             // hosts from the queue.
             _scan->hostsToScan.clear();
-            _scan->enqueAllUntriedHosts(reply.normalHosts, _set->rand);
+            {
+                scoped_spinlock lk(_set->selectionLock); // rand shared with snapshot selection
+                _scan->enqueAllUntriedHosts(reply.normalHosts, _set->rand);
+            }
 
             if (!_scan->waitingFor.empty()) {
                 // make sure we don't wait for any hosts that aren't considered members
@@ -875,37 +922,48 @@ namespace {
             nodes.push_back(Node(*it));
         }
 
+        publishSnapshot();
+
         DEV checkInvariants();
     }
 
     HostAndPort SetState::getMatchingHost(const ReadPreferenceSetting& criteria) const {
+        return getMatchingHostIn(nodes, criteria);
+    }
+
+    HostAndPort SetState::getMatchingHostIn(const Nodes& candidates,
+                                            const ReadPreferenceSetting& criteria) const {
         switch (criteria.pref) {
         // "Prefered" read preferences are defined in terms of other preferences
         case ReadPreference_PrimaryPreferred: {
-            HostAndPort out = getMatchingHost(ReadPreferenceSetting(ReadPreference_PrimaryOnly,
-                                                                    criteria.tags));
+            HostAndPort out = getMatchingHostIn(candidates,
+                                                ReadPreferenceSetting(ReadPreference_PrimaryOnly,
+                                                                      criteria.tags));
             // NOTE: the spec says we should use the primary even if tags don't match
             if (!out.empty())
                 return out;
-            return getMatchingHost(ReadPreferenceSetting(ReadPreference_SecondaryOnly,
-                                                         criteria.tags));
+            return getMatchingHostIn(candidates,
+                                     ReadPreferenceSetting(ReadPreference_SecondaryOnly,
+                                                           criteria.tags));
         }
 
         case ReadPreference_SecondaryPreferred: {
-            HostAndPort out =
-                getMatchingHost(ReadPreferenceSetting(ReadPreference_SecondaryOnly,
-                                                      criteria.tags));
+            HostAndPort out = getMatchingHostIn(candidates,
+                                                ReadPreferenceSetting(ReadPreference_SecondaryOnly,
+                                                                      criteria.tags));
             if (!out.empty())
                 return out;
             // NOTE: the spec says we should use the primary even if tags don't match
-            return getMatchingHost(ReadPreferenceSetting(ReadPreference_PrimaryOnly,
-                                                         criteria.tags));
+            return getMatchingHostIn(candidates,
+                                     ReadPreferenceSetting(ReadPreference_PrimaryOnly,
+                                                           criteria.tags));
         }
 
         case ReadPreference_PrimaryOnly: {
             // NOTE: isMaster implies isUp
-            Nodes::const_iterator it = std::find_if(nodes.begin(), nodes.end(), isMaster);
-            if (it == nodes.end())
+            Nodes::const_iterator it = std::find_if(candidates.begin(), candidates.end(),
+                                                    isMaster);
+            if (it == candidates.end())
                 return HostAndPort();
             return it->host;
         }
@@ -918,9 +976,9 @@ namespace {
                 BSONObj tag = tagElem.Obj();
 
                 std::vector<const Node*> matchingNodes;
-                for (size_t i = 0; i < nodes.size(); i++ ) {
-                    if (nodes[i].matches(criteria.pref) && nodes[i].matches(tag)) {
-                        matchingNodes.push_back(&nodes[i]);
+                for (size_t i = 0; i < candidates.size(); i++ ) {
+                    if (candidates[i].matches(criteria.pref) && candidates[i].matches(tag)) {
+                        matchingNodes.push_back(&candidates[i]);
                     }
                 }
 
@@ -941,15 +999,42 @@ namespace {
                     }
                 }
 
-                // of the remaining nodes, pick one at random (or use round-robin)
-                if (ReplicaSetMonitor::useDeterministicHostSelection) {
-                    // only in tests
-                    return matchingNodes[roundRobin++ % matchingNodes.size()]->host;
+                // Of the remaining nodes, pick two at random and take the less
+                // loaded one (two random choices avoid herding every thread
+                // onto a single host the moment its queue dips).  The random
+                // state is shared with snapshot-based callers that don't hold
+                // mutex, so it gets its own tiny lock; the load tracker is
+                // consulted outside it.
+                size_t first, second;
+                {
+                    scoped_spinlock lk(selectionLock);
+                    if (ReplicaSetMonitor::useDeterministicHostSelection) {
+                        // only in tests
+                        return matchingNodes[roundRobin++ % matchingNodes.size()]->host;
+                    }
+                    first = rand.nextInt32(matchingNodes.size());
+                    second = rand.nextInt32(matchingNodes.size());
                 }
-                else {
-                    // normal case
-                    return matchingNodes[rand.nextInt32(matchingNodes.size())]->host;
-                };
+
+                if (first == second)
+                    return matchingNodes[first]->host;
+
+                // Prefer the host with fewer of our requests already in
+                // flight; a host in page-cache warmup or with a deep queue
+                // accumulates outstanding requests long before its ping time
+                // degrades.  Break ties on smoothed request latency.
+                const HostLoadTracker& load = HostLoadTracker::get();
+                const std::string firstHost = matchingNodes[first]->host.toString();
+                const std::string secondHost = matchingNodes[second]->host.toString();
+                const int firstPending = load.outstanding(firstHost);
+                const int secondPending = load.outstanding(secondHost);
+                if (firstPending != secondPending)
+                    return matchingNodes[firstPending < secondPending ? first : second]->host;
+                const long long firstMicros = load.smoothedMicros(firstHost);
+                const long long secondMicros = load.smoothedMicros(secondHost);
+                if (firstMicros >= 0 && secondMicros >= 0 && secondMicros < firstMicros)
+                    return matchingNodes[second]->host;
+                return matchingNodes[first]->host;
             }
 
             return HostAndPort();
@@ -960,6 +1045,20 @@ namespace {
         }
     }
 
+    boost::shared_ptr<const Nodes> SetState::getSnapshot() const {
+        scoped_spinlock lk(selectionLock);
+        return snapshot;
+    }
+
+    void SetState::publishSnapshot() {
+        boost::shared_ptr<const Nodes> fresh = boost::make_shared<Nodes>(nodes);
+        {
+            scoped_spinlock lk(selectionLock);
+            snapshot.swap(fresh);
+        }
+        // the previous snapshot (now in 'fresh') is released here, outside the spinlock
+    }
+
     Node* SetState::findNode(const HostAndPort& host) {
         const Nodes::iterator it = std::lower_bound(nodes.begin(), nodes.end(), host, compareHosts);
         if (it == nodes.end() || it->host != host)
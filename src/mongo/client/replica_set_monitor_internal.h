@@ -32,6 +32,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/platform/cstdint.h"
 #include "mongo/platform/random.h"
+#include "mongo/util/concurrency/spin_lock.h"
 #include "mongo/util/net/hostandport.h"
 
 namespace mongo {
@@ -126,6 +127,26 @@ namespace mongo {
          */
         HostAndPort getMatchingHost(const ReadPreferenceSetting& criteria) const;
 
+        /**
+         * Like getMatchingHost, but selects among 'candidates' rather than nodes. Unlike
+         * every other method, this one may be called without holding mutex, which is how
+         * getHostOrRefresh selects against a snapshot while refreshes hold the mutex.
+         */
+        HostAndPort getMatchingHostIn(const Nodes& candidates,
+                                      const ReadPreferenceSetting& criteria) const;
+
+        /**
+         * Returns the latest immutable copy of nodes published by publishSnapshot, or
+         * NULL if nothing has been published yet.
+         */
+        boost::shared_ptr<const Nodes> getSnapshot() const;
+
+        /**
+         * Replaces the selection snapshot with a fresh copy of nodes. Call while holding
+         * mutex after changing any node's state.
+         */
+        void publishSnapshot();
+
         /**
          * Returns the Node with the given host, or NULL if no Node has that host.
          */
@@ -166,6 +187,16 @@ namespace mongo {
         Nodes nodes; // maintained sorted and unique by host
         ScanStatePtr currentScan; // NULL if no scan in progress
         int64_t latencyThresholdMicros;
+
+        // Guards the snapshot pointer and the random state below; only ever held for a few
+        // instructions, never while doing anything else. Safe to take with or without mutex
+        // held, but never take mutex while holding this.
+        mutable SpinLock selectionLock;
+
+        // Immutable copy of nodes read by getHostOrRefresh without taking mutex; replaced
+        // wholesale by publishSnapshot.
+        boost::shared_ptr<const Nodes> snapshot;
+
         mutable PseudoRandom rand; // only used for host selection to balance load
         mutable int roundRobin; // used when useDeterministicHostSelection is true
     };
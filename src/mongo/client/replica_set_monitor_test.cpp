@@ -287,6 +287,70 @@ TEST(ReplicaSetMonitorTests, CheckAllSeedsSerial) {
     }
 }
 
+TEST(ReplicaSetMonitorTests, SnapshotSelection) {
+    SetStatePtr state = boost::make_shared<SetState>("name", basicSeedsSet);
+
+    // the seed list is published right away, but everything in it is down
+    boost::shared_ptr<const Nodes> snap = state->getSnapshot();
+    ASSERT(snap);
+    ASSERT_EQUALS(snap->size(), basicSeeds.size());
+    ASSERT(state->getMatchingHostIn(
+                *snap,
+                ReadPreferenceSetting(ReadPreference_PrimaryOnly, TagSet())).empty());
+
+    Refresher refresher(state);
+    for (size_t i = 0; i < basicSeeds.size(); i++) {
+        NextStep ns = refresher.getNextStep();
+        ASSERT_EQUALS(ns.step, NextStep::CONTACT_HOST);
+        bool primary = ns.host.host() == "a";
+        refresher.receivedIsMaster(ns.host, -1, BSON(
+                "setName" << "name"
+             << "ismaster" << primary
+             << "secondary" << !primary
+             << "hosts" << BSON_ARRAY("a" << "b" << "c")
+             << "ok" << true
+             ));
+    }
+
+    // each reply published a fresh snapshot, usable without holding SetState::mutex
+    snap = state->getSnapshot();
+    ASSERT(snap);
+    ASSERT_EQUALS(snap->size(), basicSeeds.size());
+    HostAndPort master = state->getMatchingHostIn(
+            *snap, ReadPreferenceSetting(ReadPreference_PrimaryOnly, TagSet()));
+    ASSERT_EQUALS(master.host(), "a");
+}
+
+TEST(ReplicaSetMonitorTests, SnapshotUpdatedOnFailedHost) {
+    SetStatePtr state = boost::make_shared<SetState>("name", basicSeedsSet);
+    Refresher refresher(state);
+
+    for (size_t i = 0; i < basicSeeds.size(); i++) {
+        NextStep ns = refresher.getNextStep();
+        ASSERT_EQUALS(ns.step, NextStep::CONTACT_HOST);
+        bool primary = ns.host.host() == "a";
+        refresher.receivedIsMaster(ns.host, -1, BSON(
+                "setName" << "name"
+             << "ismaster" << primary
+             << "secondary" << !primary
+             << "hosts" << BSON_ARRAY("a" << "b" << "c")
+             << "ok" << true
+             ));
+    }
+
+    refresher.failedHost(HostAndPort("a"));
+
+    // the snapshot reflects the loss of the primary immediately
+    boost::shared_ptr<const Nodes> snap = state->getSnapshot();
+    ASSERT(snap);
+    ASSERT(state->getMatchingHostIn(
+                *snap,
+                ReadPreferenceSetting(ReadPreference_PrimaryOnly, TagSet())).empty());
+    ASSERT(!state->getMatchingHostIn(
+                *snap,
+                ReadPreferenceSetting(ReadPreference_SecondaryOnly, TagSet())).empty());
+}
+
 TEST(ReplicaSetMonitorTests, CheckAllSeedsParallel) {
     SetStatePtr state = boost::make_shared<SetState>("name", basicSeedsSet);
     Refresher refresher(state);
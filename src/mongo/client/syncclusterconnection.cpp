@@ -20,6 +20,7 @@
 
 #include "mongo/client/syncclusterconnection.h"
 
+#include "mongo/client/constants.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/dbmessage.h"
@@ -29,6 +30,9 @@
 
 namespace mongo {
 
+    // defined in dbclient.cpp
+    void assembleRequest( const string &ns, BSONObj query, int nToReturn, int nToSkip, const BSONObj *fieldsToReturn, int queryOptions, Message &toSend );
+
     SyncClusterConnection::SyncClusterConnection( const list<HostAndPort> & L, double socketTimeout) : _mutex("SyncClusterConnection"), _socketTimeout( socketTimeout ) {
         {
             stringstream s;
@@ -78,25 +82,104 @@ namespace mongo {
         return fsync( errmsg );
     }
 
-    bool SyncClusterConnection::fsync( string& errmsg ) {
-        bool ok = true;
-        errmsg = "";
+    void SyncClusterConnection::_queryOnAll( const string& ns,
+                                             const BSONObj& query,
+                                             int queryOptions,
+                                             vector<BSONObj>* results,
+                                             vector<string>* errors ) {
+        results->clear();
+        errors->clear();
+        results->resize( _conns.size() );
+        errors->resize( _conns.size() );
+
+        vector<bool> sent( _conns.size(), false );
         for ( size_t i=0; i<_conns.size(); i++ ) {
-            string singleErr;
             try {
-                // this is fsync=true
-                // which with journalling on is a journal commit
-                // without journalling, is a full fsync
-                _conns[i]->simpleCommand( "admin", NULL, "resetError" );
-                singleErr = _conns[i]->getLastError( true );
+                Message toSend;
+                assembleRequest( ns, query, 1, 0, 0, queryOptions, toSend );
+                _conns[i]->say( toSend );
+                sent[i] = true;
+            }
+            catch ( std::exception& e ) {
+                (*errors)[i] = e.what();
+            }
+            catch ( ... ) {
+                (*errors)[i] = "unknown failure";
+            }
+        }
 
-                if ( singleErr.size() == 0 )
+        for ( size_t i=0; i<_conns.size(); i++ ) {
+            if ( ! sent[i] )
+                continue;
+            try {
+                Message toRecv;
+                if ( ! _conns[i]->recv( toRecv ) ) {
+                    // socket exceptions in recv are written to the log, not thrown
+                    (*errors)[i] = "error receiving response - see logs";
                     continue;
-
+                }
+                QueryResult* qr = reinterpret_cast<QueryResult*>( toRecv.singleData() );
+                if ( qr->resultFlags() & ResultFlag_ErrSet ) {
+                    (*errors)[i] = BSONObj( qr->data() ).getStringField( "$err" );
+                    if ( (*errors)[i].empty() )
+                        (*errors)[i] = "unknown $err";
+                    continue;
+                }
+                if ( qr->nReturned > 0 )
+                    (*results)[i] = BSONObj( qr->data() ).getOwned();
             }
-            catch ( DBException& e ) {
-                singleErr = e.toString();
+            catch ( std::exception& e ) {
+                (*errors)[i] = e.what();
+            }
+            catch ( ... ) {
+                (*errors)[i] = "unknown failure";
             }
+        }
+    }
+
+    void SyncClusterConnection::_runCommandOnAll( const string& dbname,
+                                                  const BSONObj& cmd,
+                                                  vector<BSONObj>* results,
+                                                  vector<string>* errors ) {
+        BSONObj toSend = cmd;
+        if ( _runCommandHook ) {
+            BSONObjBuilder b;
+            b.appendElements( cmd );
+            _runCommandHook( &b );
+            toSend = b.obj();
+        }
+
+        _queryOnAll( dbname + ".$cmd", toSend, 0, results, errors );
+
+        if ( _postRunCommandHook ) {
+            for ( size_t i=0; i<results->size(); i++ ) {
+                if ( (*errors)[i].empty() )
+                    _postRunCommandHook( (*results)[i], _conns[i]->getServerAddress() );
+            }
+        }
+    }
+
+    bool SyncClusterConnection::fsync( string& errmsg ) {
+        bool ok = true;
+        errmsg = "";
+
+        // overlap the round trips to the nodes rather than paying for them
+        // sequentially
+        vector<BSONObj> resetRes, gleRes;
+        vector<string> resetErrors, gleErrors;
+        _runCommandOnAll( "admin", BSON( "resetError" << 1 ), &resetRes, &resetErrors );
+        // this is fsync=true
+        // which with journalling on is a journal commit
+        // without journalling, is a full fsync
+        _runCommandOnAll( "admin", BSON( "getlasterror" << 1 << "fsync" << 1 ),
+                          &gleRes, &gleErrors );
+
+        for ( size_t i=0; i<_conns.size(); i++ ) {
+            string singleErr = ! resetErrors[i].empty() ? resetErrors[i] :
+                               ! gleErrors[i].empty() ? gleErrors[i] :
+                               getLastErrorString( gleRes[i] );
+            if ( singleErr.size() == 0 )
+                continue;
             ok = false;
             errmsg += " " + _conns[i]->toString() + ":" + singleErr;
         }
@@ -107,21 +190,12 @@ namespace mongo {
         _lastErrors.clear();
         vector<string> errors;
 
+        _runCommandOnAll( "admin", BSON( "getlasterror" << 1 << "fsync" << 1 ),
+                          &_lastErrors, &errors );
+
         for ( size_t i=0; i<_conns.size(); i++ ) {
-            BSONObj res;
-            string err;
-            try {
-                if ( ! _conns[i]->runCommand( "admin" , BSON( "getlasterror" << 1 << "fsync" << 1 ) , res ) )
-                    err = "cmd failed: ";
-            }
-            catch ( std::exception& e ) {
-                err += e.what();
-            }
-            catch ( ... ) {
-                err += "unknown failure";
-            }
-            _lastErrors.push_back( res.getOwned() );
-            errors.push_back( err );
+            if ( errors[i].empty() && ! isOk( _lastErrors[i] ) )
+                errors[i] = "cmd failed: ";
         }
 
         verify( _lastErrors.size() == errors.size() && _lastErrors.size() == _conns.size() );
@@ -188,19 +262,21 @@ namespace mongo {
                 if ( ! prepare( errmsg ) )
                     throw UserException( PrepareConfigsFailedCode , (string)"SyncClusterConnection::findOne prepare failed: " + errmsg );
 
+                // send to all nodes up front so the round trips overlap
                 vector<BSONObj> all;
-                for ( size_t i=0; i<_conns.size(); i++ ) {
-                    all.push_back( _conns[i]->findOne( ns , query , 0 , queryOptions ).getOwned() );
-                }
+                vector<string> errors;
+                _queryOnAll( ns, query.obj, queryOptions, &all, &errors );
 
                 _checkLast();
-                
+
                 for ( size_t i=0; i<all.size(); i++ ) {
                     BSONObj temp = all[i];
-                    if ( isOk( temp ) )
+                    if ( errors[i].empty() && isOk( temp ) )
                         continue;
                     stringstream ss;
                     ss << "write $cmd failed on a node: " << temp.jsonString();
+                    if ( ! errors[i].empty() )
+                        ss << " " << errors[i];
                     ss << " " << _conns[i]->toString();
                     ss << " ns: " << ns;
                     ss << " cmd: " << query.toString();
@@ -472,7 +548,9 @@ namespace mongo {
             throw UserException( 13397 , (string)"SyncClusterConnection::say prepare failed: " + errmsg );
 
         for ( size_t i=0; i<_conns.size(); i++ ) {
-            _conns[i]->say( toSend );
+            // defer the write; it goes out in the same corked stretch as the
+            // getlasterror _checkLast() sends right behind it
+            _conns[i]->port().piggyBack( toSend );
         }
 
         // TODO: should we set actualServer??
@@ -129,6 +129,30 @@ namespace mongo {
         void _checkLast();
         void _connect( const std::string& host );
 
+        /**
+         * Runs the one-result query 'query' on every node concurrently: the
+         * request is sent to all nodes before any reply is received, so the
+         * three round trips overlap instead of accruing sequentially.  Fills in
+         * one result and one error string per node, positionally; a node that
+         * failed gets an empty result and a non-empty error.  Every reply that
+         * was sent for is received, so no connection is left with a stray
+         * response on the wire.
+         */
+        void _queryOnAll( const string& ns,
+                          const BSONObj& query,
+                          int queryOptions,
+                          vector<BSONObj>* results,
+                          vector<string>* errors );
+
+        /**
+         * Runs 'cmd' on every node via _queryOnAll, applying the run/post
+         * command hooks the way runCommand on a single connection would.
+         */
+        void _runCommandOnAll( const string& dbname,
+                               const BSONObj& cmd,
+                               vector<BSONObj>* results,
+                               vector<string>* errors );
+
         string _address;
         vector<string> _connAddresses;
         vector<DBClientConnection*> _conns;
@@ -0,0 +1,189 @@
+// admission_control.cpp
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/admission_control.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/d_concurrency.h"
+#include "mongo/db/lockstat.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    // Maximum concurrently running plain reads / writes.  0 (the default)
+    // disables gating of that kind.  The controller may run fewer tickets
+    // than this while the global lock is saturated.
+    MONGO_EXPORT_SERVER_PARAMETER(admissionReadTickets, int, 0);
+    MONGO_EXPORT_SERVER_PARAMETER(admissionWriteTickets, int, 0);
+
+    namespace {
+        const int kMinTickets = 4;
+
+        // fractions of wall time spent waiting on the global lock that drive
+        // the ticket counts down, respectively allow them back up
+        const double kHighLockWait = 0.5;
+        const double kLowLockWait = 0.1;
+    }
+
+    AdmissionController admissionController;
+
+    AdmissionController::AdmissionController()
+        : _readTickets( 0 ),
+          _writeTickets( 0 ),
+          _lastAcquireMicros( 0 ),
+          _lastSampleMillis( 0 ) {
+    }
+
+    static long long globalAcquireWaitMicros() {
+        LockStat* stat = Lock::globalLockStat();
+        return stat->getTimeAcquiring( 'R' ) + stat->getTimeAcquiring( 'W' ) +
+               stat->getTimeAcquiring( 'r' ) + stat->getTimeAcquiring( 'w' );
+    }
+
+    void AdmissionController::admit( int op, bool isCommand, Ticket* ticket ) {
+        FastTicketHolder* holder;
+        int configured;
+
+        if ( op == dbQuery || op == dbGetMore ) {
+            if ( isCommand )
+                return;
+            holder = &_readTickets;
+            configured = admissionReadTickets;
+        }
+        else if ( op == dbInsert || op == dbUpdate || op == dbDelete ) {
+            holder = &_writeTickets;
+            configured = admissionWriteTickets;
+        }
+        else {
+            // killCursors and friends are never gated
+            return;
+        }
+
+        if ( configured <= 0 )
+            return;
+
+        if ( holder->outof() == 0 ) {
+            // first gated op after the parameter was switched on;
+            // taskDoWork tunes from here
+            holder->resize( configured );
+        }
+
+        holder->waitForTicket();
+        ticket->_holder = holder;
+    }
+
+    void AdmissionController::taskDoWork() {
+        unsigned long long now = curTimeMillis64();
+        long long acquire = globalAcquireWaitMicros();
+
+        if ( _lastSampleMillis == 0 ) {
+            _lastSampleMillis = now;
+            _lastAcquireMicros = acquire;
+            return;
+        }
+
+        double intervalMicros = ( now - _lastSampleMillis ) * 1000.0;
+        double lockWaitRatio = intervalMicros > 0 ?
+            ( acquire - _lastAcquireMicros ) / intervalMicros : 0.0;
+
+        _lastSampleMillis = now;
+        _lastAcquireMicros = acquire;
+
+        _retune( &_readTickets, admissionReadTickets, lockWaitRatio );
+        _retune( &_writeTickets, admissionWriteTickets, lockWaitRatio );
+    }
+
+    void AdmissionController::_retune( FastTicketHolder* holder,
+                                       int configuredMax,
+                                       double lockWaitRatio ) {
+        int cur = holder->outof();
+        if ( configuredMax <= 0 || cur == 0 ) {
+            // gating off, or on but not used yet; admit() seeds the size
+            return;
+        }
+
+        int target = cur;
+        if ( lockWaitRatio > kHighLockWait ) {
+            // lock-saturated: let fewer ops in so the herd queues at the
+            // (cheap) ticket gate instead
+            target = cur / 2;
+        }
+        else if ( holder->waiters() > 0 && lockWaitRatio < kLowLockWait ) {
+            // ops are queueing at the gate but the lock has headroom
+            target = cur + std::max( 1, cur / 4 );
+        }
+
+        if ( target < kMinTickets )
+            target = kMinTickets;
+        if ( target > configuredMax )
+            target = configuredMax;
+
+        if ( target != cur ) {
+            LOG(1) << "admission control resizing tickets: " << cur << " -> " << target
+                   << " (lock wait ratio " << lockWaitRatio
+                   << ", queued " << holder->waiters() << ")" << endl;
+            holder->resize( target );
+        }
+    }
+
+    void AdmissionController::appendStats( BSONObjBuilder& b ) {
+        BSONObjBuilder reads( b.subobjStart( "reads" ) );
+        reads.append( "out", _readTickets.used() );
+        reads.append( "available", _readTickets.available() );
+        reads.append( "totalTickets", _readTickets.outof() );
+        reads.append( "queued", _readTickets.waiters() );
+        reads.done();
+
+        BSONObjBuilder writes( b.subobjStart( "writes" ) );
+        writes.append( "out", _writeTickets.used() );
+        writes.append( "available", _writeTickets.available() );
+        writes.append( "totalTickets", _writeTickets.outof() );
+        writes.append( "queued", _writeTickets.waiters() );
+        writes.done();
+    }
+
+    namespace {
+        class AdmissionSection : public ServerStatusSection {
+        public:
+            AdmissionSection() : ServerStatusSection( "admission" ) {}
+            virtual bool includeByDefault() const { return false; }
+
+            virtual BSONObj generateSection( const BSONElement& configElement ) const {
+                BSONObjBuilder b;
+                admissionController.appendStats( b );
+                return b.obj();
+            }
+        } admissionSection;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,95 @@
+// admission_control.h
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/ticketholder.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Gates how many plain reads and writes may run concurrently, so a surge
+     * of clients (for instance the reconnect herd after a failover) queues at
+     * a cheap ticket gate instead of piling onto the lock manager all at once.
+     *
+     * Off by default.  The admissionReadTickets / admissionWriteTickets
+     * server parameters set the maximum concurrent operations of each kind;
+     * the controller then adapts the live ticket counts below that maximum
+     * from the global lock's observed acquire-wait time and the depth of the
+     * ticket queues (see taskDoWork).
+     */
+    class AdmissionController : public PeriodicTask {
+    public:
+
+        /** Scoped ticket: released on destruction, if one was issued. */
+        class Ticket : boost::noncopyable {
+        public:
+            Ticket() : _holder(NULL) {}
+            ~Ticket() {
+                if ( _holder )
+                    _holder->release();
+            }
+        private:
+            friend class AdmissionController;
+            FastTicketHolder* _holder;
+        };
+
+        AdmissionController();
+
+        /**
+         * Blocks until the operation may run, storing what to release in
+         * *ticket.  Ungated operations -- commands, anything that is not a
+         * basic read or write, or everything while admission control is off
+         * -- leave *ticket empty and return immediately.
+         */
+        void admit( int op, bool isCommand, Ticket* ticket );
+
+        void appendStats( BSONObjBuilder& b );
+
+        virtual std::string taskName() const { return "AdmissionController"; }
+        virtual void taskDoWork();
+
+    private:
+        void _retune( FastTicketHolder* holder, int configuredMax, double lockWaitRatio );
+
+        FastTicketHolder _readTickets;
+        FastTicketHolder _writeTickets;
+
+        // global lock acquire-wait total and wall clock at the last sample
+        long long _lastAcquireMicros;
+        unsigned long long _lastSampleMillis;
+    };
+
+    extern AdmissionController admissionController;
+
+}  // namespace mongo
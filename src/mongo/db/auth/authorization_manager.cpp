@@ -54,6 +54,7 @@
 #include "mongo/platform/compiler.h"
 #include "mongo/platform/unordered_map.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/epoch_reclamation.h"
 #include "mongo/util/log.h"
 #include "mongo/util/map_util.h"
 #include "mongo/util/mongoutils/str.h"
@@ -248,6 +249,7 @@ namespace mongo {
         _authEnabled(false),
         _externalState(externalState),
         _version(schemaVersionInvalid),
+        _userCacheSnapshot(new UserCacheMap()),
         _cacheGeneration(0),
         _isFetchPhaseBusy(false) {
     }
@@ -258,6 +260,13 @@ namespace mongo {
             fassert(17265, it->second != internalSecurity.user);
             delete it->second ;
         }
+        delete _userCacheSnapshot.load();
+    }
+
+    void AuthorizationManager::_updateCacheSnapshot_inlock() {
+        UserCacheMap* fresh = new UserCacheMap(_userCache);
+        UserCacheMap* old = _userCacheSnapshot.swap(fresh);
+        EpochReclamation::retire(old);
     }
 
     Status AuthorizationManager::getAuthorizationVersion(int* version) {
@@ -559,6 +568,24 @@ namespace mongo {
             return Status::OK();
         }
 
+        // Fast path: serve cache hits from the immutable snapshot without touching _cacheMutex,
+        // so connection storms don't serialize here.  The epoch guard pins the snapshot and any
+        // User objects retired out of it, and tryIncrementRefCount() refuses to resurrect a
+        // reference count that already reached zero, so a user concurrently being torn down or
+        // invalidated sends us to the locked path below instead.
+        {
+            EpochReadGuard epochGuard;
+            const UserCacheMap* cache = _userCacheSnapshot.load();
+            UserCacheMap::const_iterator cit = cache->find(userName);
+            if (cit != cache->end() &&
+                cit->second->isValid() &&
+                cit->second->tryIncrementRefCount()) {
+
+                *acquiredUser = cit->second;
+                return Status::OK();
+            }
+        }
+
         unordered_map<UserName, User*>::iterator it;
 
         CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
@@ -624,6 +651,7 @@ namespace mongo {
         // NOTE: It is not safe to throw an exception from here to the end of the method.
         if (guard.isSameCacheGeneration()) {
             _userCache.insert(make_pair(userName, user.get()));
+            _updateCacheSnapshot_inlock();
             if (_version == schemaVersionInvalid)
                 _version = authzVersion;
         }
@@ -767,6 +795,7 @@ namespace mongo {
                     if (guard.isSameCacheGeneration()) {
                         _invalidateUserCache_inlock();
                         _userCache.insert(make_pair(userName, user.get()));
+                        _updateCacheSnapshot_inlock();
                     }
                     else {
                         user->invalidate();
@@ -809,6 +838,7 @@ namespace mongo {
             else {
                 _userCache.insert(make_pair(userName, *acquiredUser));
             }
+            _updateCacheSnapshot_inlock();
         }
         else {
             // If the cache generation changed while this thread was in fetch mode, the data
@@ -831,8 +861,12 @@ namespace mongo {
             if (user->isValid()) {
                 MONGO_COMPILER_VARIABLE_UNUSED bool erased = _userCache.erase(user->getName());
                 dassert(erased);
+                _updateCacheSnapshot_inlock();
             }
-            delete user;
+            // The user may still be visible in a snapshot pinned by a lock-free reader; its
+            // reference count is zero so no such reader can acquire it, but the memory must
+            // outlive the readers.
+            EpochReclamation::retire(user);
         }
     }
 
@@ -846,6 +880,7 @@ namespace mongo {
 
         User* user = it->second;
         _userCache.erase(it);
+        _updateCacheSnapshot_inlock();
         user->invalidate();
     }
 
@@ -862,6 +897,7 @@ namespace mongo {
                 ++it;
             }
         }
+        _updateCacheSnapshot_inlock();
     }
 
     void AuthorizationManager::invalidateUserCache() {
@@ -869,6 +905,11 @@ namespace mongo {
         _invalidateUserCache_inlock();
     }
 
+    uint64_t AuthorizationManager::getCacheGeneration() {
+        CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
+        return _cacheGeneration;
+    }
+
     void AuthorizationManager::_invalidateUserCache_inlock() {
         ++_cacheGeneration;
         for (unordered_map<UserName, User*>::iterator it = _userCache.begin();
@@ -877,6 +918,7 @@ namespace mongo {
             it->second->invalidate();
         }
         _userCache.clear();
+        _updateCacheSnapshot_inlock();
 
         // Reread the schema version before acquiring the next user.
         _version = schemaVersionInvalid;
@@ -46,6 +46,7 @@
 #include "mongo/db/auth/user_name_hash.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -369,6 +370,13 @@ namespace mongo {
          */
         void invalidateUserCache();
 
+        /**
+         * Returns the current generation of the user cache.  The generation is bumped every
+         * time part of the cache is invalidated, so consumers that memoize decisions derived
+         * from cached user data can compare generations to find out when to discard them.
+         */
+        uint64_t getCacheGeneration();
+
         /**
          * Parses privDoc and fully initializes the user object (credentials, roles, and privileges)
          * with the information extracted from the privilege document.
@@ -444,6 +452,13 @@ namespace mongo {
          */
         void _invalidateUserCache_inlock();
 
+        /**
+         * Publishes a fresh immutable snapshot of _userCache for the lock-free read path in
+         * acquireUser(), retiring the superseded snapshot through EpochReclamation.  Must be
+         * called after every mutation of _userCache, while holding _cacheMutex.
+         */
+        void _updateCacheSnapshot_inlock();
+
         /**
          * Fetches user information from a v2-schema user document for the named user,
          * and stores a pointer to a new user object into *acquiredUser on success.
@@ -479,13 +494,23 @@ namespace mongo {
          */
         int _version;
 
+        typedef unordered_map<UserName, User*> UserCacheMap;
+
         /**
          * Caches User objects with information about user privileges, to avoid the need to
          * go to disk to read user privilege documents whenever possible.  Every User object
          * has a reference count - the AuthorizationManager must not delete a User object in the
          * cache unless its reference count is zero.
          */
-        unordered_map<UserName, User*> _userCache;
+        UserCacheMap _userCache;
+
+        /**
+         * Immutable copy of _userCache, swapped in whole after every mutation, from which
+         * acquireUser() serves cache hits without taking _cacheMutex.  Readers pin it (and the
+         * User objects it references) with an EpochReadGuard; superseded snapshots and retired
+         * User objects are reclaimed once no reader can still hold them.  Never NULL.
+         */
+        AtomicWord<UserCacheMap*> _userCacheSnapshot;
 
         /**
          * Current generation of cached data.  Bumped every time part of the cache gets
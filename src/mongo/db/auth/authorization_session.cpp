@@ -51,8 +51,9 @@ namespace {
     const std::string ADMIN_DBNAME = "admin";
 }  // namespace
 
-    AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState) 
-        : _impersonationFlag(false) {
+    AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState)
+        : _authCheckCacheGeneration(0),
+          _impersonationFlag(false) {
         _externalState.reset(externalState);
     }
 
@@ -89,6 +90,8 @@ namespace {
             getAuthorizationManager().releaseUser(replacedUser);
         }
 
+        _invalidateAuthCheckCache();
+
         return Status::OK();
     }
 
@@ -102,6 +105,7 @@ namespace {
         if (removedUser) {
             getAuthorizationManager().releaseUser(removedUser);
         }
+        _invalidateAuthCheckCache();
     }
 
     UserNameIterator AuthorizationSession::getAuthenticatedUserNames() {
@@ -122,6 +126,7 @@ namespace {
 
     void AuthorizationSession::grantInternalAuthorization() {
         _authenticatedUsers.add(internalSecurity.user);
+        _invalidateAuthCheckCache();
     }
 
     Status AuthorizationSession::checkAuthForQuery(const NamespaceString& ns,
@@ -286,12 +291,37 @@ namespace {
 
     bool AuthorizationSession::isAuthorizedForActionsOnNamespace(const NamespaceString& ns,
                                                                  ActionType action) {
-        return isAuthorizedForPrivilege(Privilege(ResourcePattern::forExactNamespace(ns), action));
+        if (_externalState->shouldIgnoreAuthChecks())
+            return true;
+
+        // Fast path: this session has already proven it may perform "action" on "ns".
+        StringMap<ActionSet>::const_iterator it = _authCheckCache.find(ns.ns());
+        if (it != _authCheckCache.end() && it->second.contains(action))
+            return true;
+
+        if (!_isAuthorizedForPrivilege(
+                    Privilege(ResourcePattern::forExactNamespace(ns), action)))
+            return false;
+
+        _authCheckCache[ns.ns()].addAction(action);
+        return true;
     }
 
     bool AuthorizationSession::isAuthorizedForActionsOnNamespace(const NamespaceString& ns,
                                                                 const ActionSet& actions) {
-        return isAuthorizedForPrivilege(Privilege(ResourcePattern::forExactNamespace(ns), actions));
+        if (_externalState->shouldIgnoreAuthChecks())
+            return true;
+
+        StringMap<ActionSet>::const_iterator it = _authCheckCache.find(ns.ns());
+        if (it != _authCheckCache.end() && it->second.isSupersetOf(actions))
+            return true;
+
+        if (!_isAuthorizedForPrivilege(
+                    Privilege(ResourcePattern::forExactNamespace(ns), actions)))
+            return false;
+
+        _authCheckCache[ns.ns()].addAllActionsFromSet(actions);
+        return true;
     }
 
     static const int resourceSearchListCapacity = 5;
@@ -386,8 +416,25 @@ namespace {
         return false;
     }
 
+    void AuthorizationSession::_invalidateAuthCheckCache() {
+        _authCheckCache.clear();
+    }
+
     void AuthorizationSession::_refreshUserInfoAsNeeded() {
         AuthorizationManager& authMan = getAuthorizationManager();
+
+        // Discard memoized authorization decisions if any cached user data has been
+        // invalidated since they were recorded.  When the cache is empty (auth disabled,
+        // or no checks performed yet) there is nothing to discard, so don't pay for the
+        // generation lookup.
+        if (!_authCheckCache.empty()) {
+            const uint64_t cacheGeneration = authMan.getCacheGeneration();
+            if (cacheGeneration != _authCheckCacheGeneration) {
+                _invalidateAuthCheckCache();
+                _authCheckCacheGeneration = cacheGeneration;
+            }
+        }
+
         UserSet::iterator it = _authenticatedUsers.begin();
         while (it != _authenticatedUsers.end()) {
             User* user = *it;
@@ -453,6 +500,7 @@ namespace {
                     if (user != updatedUser) {
                         LOG(1) << "Updated session cache for V1 user " << name;
                         fassert(17226, _authenticatedUsers.replaceAt(it, updatedUser) == user);
+                        _invalidateAuthCheckCache();
                     }
                     getAuthorizationManager().releaseUser(user);
                     user = updatedUser;
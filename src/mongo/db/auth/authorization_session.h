@@ -41,6 +41,7 @@
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/auth/user_set.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -198,6 +199,10 @@ namespace mongo {
         // up-to-date information. May require a read lock on the "admin" db to read the user data.
         void _refreshUserInfoAsNeeded();
 
+        // Drops all memoized authorization decisions.  Must be called whenever the set of
+        // authenticated users on this session changes.
+        void _invalidateAuthCheckCache();
+
         // Checks if this connection is authorized for the given Privilege, ignoring whether or not
         // we should even be doing authorization checks in general.  Note: this may acquire a read
         // lock on the admin database (to update out-of-date user privilege information).
@@ -208,6 +213,16 @@ namespace mongo {
         // All Users who have been authenticated on this connection
         UserSet _authenticatedUsers;
 
+        // Memoized positive decisions for exact-namespace authorization checks: maps the
+        // namespace to the set of actions this session has already been shown to be
+        // authorized for.  Denials are never cached.  Cleared whenever the authenticated
+        // user set changes and whenever the AuthorizationManager's cache generation moves,
+        // so the steady-state auth check for a hot namespace is a single hash lookup.
+        StringMap<ActionSet> _authCheckCache;
+
+        // AuthorizationManager cache generation that _authCheckCache was built against.
+        uint64_t _authCheckCacheGeneration;
+
         // A vector of impersonated UserNames.  These are used in the auditing system.
         // They are not used for authz checks.
         std::vector<UserName> _impersonatedUserNames;
@@ -375,6 +375,50 @@ namespace {
         ASSERT_FALSE(authzSession->lookupUser(UserName("spencer", "test")));
     }
 
+    TEST_F(AuthorizationSessionTest, MemoizedNamespaceChecksDiscardedOnInvalidation) {
+        // Add a readWrite user
+        ASSERT_OK(managerState->insertPrivilegeDocument("admin",
+                BSON("user" << "spencer" <<
+                     "db" << "test" <<
+                     "credentials" << BSON("MONGODB-CR" << "a") <<
+                     "roles" << BSON_ARRAY(BSON("role" << "readWrite" <<
+                                                "db" << "test"))),
+                BSONObj()));
+        ASSERT_OK(authzSession->addAndAuthorizeUser(UserName("spencer", "test")));
+
+        // Repeated namespace checks hit the session's memoized decision cache.
+        ASSERT_TRUE(authzSession->isAuthorizedForActionsOnNamespace(
+                            NamespaceString("test.foo"), ActionType::insert));
+        ASSERT_TRUE(authzSession->isAuthorizedForActionsOnNamespace(
+                            NamespaceString("test.foo"), ActionType::insert));
+
+        User* user = authzSession->lookupUser(UserName("spencer", "test"));
+        ASSERT(user->isValid());
+
+        // Change the user to be read-only
+        int ignored;
+        managerState->remove(
+                AuthorizationManager::usersCollectionNamespace,
+                BSONObj(),
+                BSONObj(),
+                &ignored);
+        ASSERT_OK(managerState->insertPrivilegeDocument("admin",
+                BSON("user" << "spencer" <<
+                     "db" << "test" <<
+                     "credentials" << BSON("MONGODB-CR" << "a") <<
+                     "roles" << BSON_ARRAY(BSON("role" << "read" <<
+                                                "db" << "test"))),
+                BSONObj()));
+
+        // Invalidation must flush the memoized insert decision along with the user data.
+        authzManager->invalidateUserByName(user->getName());
+        authzSession->startRequest(); // Refreshes cached data for invalid users
+        ASSERT_TRUE(authzSession->isAuthorizedForActionsOnNamespace(
+                            NamespaceString("test.foo"), ActionType::find));
+        ASSERT_FALSE(authzSession->isAuthorizedForActionsOnNamespace(
+                            NamespaceString("test.foo"), ActionType::insert));
+    }
+
     TEST_F(AuthorizationSessionTest, UseOldUserInfoInFaceOfConnectivityProblems) {
         // Add a readWrite user
         ASSERT_OK(managerState->insertPrivilegeDocument("admin",
@@ -36,7 +36,7 @@ namespace mongo {
         _isValid(1) {}
 
     User::~User() {
-        dassert(_refCount == 0);
+        dassert(_refCount.load() == 0);
     }
 
     const UserName& User::getName() const {
@@ -60,7 +60,7 @@ namespace mongo {
     }
 
     uint32_t User::getRefCount() const {
-        return _refCount;
+        return _refCount.load();
     }
 
     const ActionSet User::getActionsForResource(const ResourcePattern& resource) const {
@@ -148,11 +148,23 @@ namespace mongo {
     }
 
     void User::incrementRefCount() {
-        ++_refCount;
+        _refCount.fetchAndAdd(1);
+    }
+
+    bool User::tryIncrementRefCount() {
+        uint32_t count = _refCount.load();
+        while (count > 0) {
+            const uint32_t seen = _refCount.compareAndSwap(count, count + 1);
+            if (seen == count)
+                return true;
+            count = seen;
+        }
+        // The count reached zero; the AuthorizationManager may already be destroying this object.
+        return false;
     }
 
     void User::decrementRefCount() {
-        dassert(_refCount > 0);
-        --_refCount;
+        dassert(_refCount.load() > 0);
+        _refCount.fetchAndSubtract(1);
     }
 } // namespace mongo
@@ -183,6 +183,16 @@ namespace mongo {
          */
         void incrementRefCount();
 
+        /**
+         * As incrementRefCount(), but refuses to resurrect a reference count that has already
+         * reached zero -- a count of zero means the AuthorizationManager may be tearing this
+         * object down.  Used by the lock-free cache read path; returns false if the caller must
+         * fall back to acquiring the user under the cache mutex.
+         *
+         * This method should *only* be called by the AuthorizationManager.
+         */
+        bool tryIncrementRefCount();
+
         /**
          * Decrements the reference count for this User object, which records how many threads have
          * a reference to it.  Once the reference count goes to zero, the AuthorizationManager is
@@ -213,10 +223,11 @@ namespace mongo {
         // AuthorizationManager::schemaVersion24 and schemaVersion26Final.
         int _schemaVersion;
 
-        // _refCount and _isInvalidated are modified exclusively by the AuthorizationManager
-        // _isInvalidated can be read by any consumer of User, but _refCount can only be
-        // meaningfully read by the AuthorizationManager, as _refCount is guarded by the AM's _lock
-        uint32_t _refCount;
+        // _refCount and _isInvalidated are modified exclusively by the AuthorizationManager.
+        // _isInvalidated can be read by any consumer of User.  _refCount is atomic so the
+        // AuthorizationManager's lock-free cache read path can take references without holding
+        // the cache mutex; all decrements still happen under that mutex.
+        AtomicUInt32 _refCount;
         AtomicUInt32 _isValid; // Using as a boolean
     };
 
@@ -0,0 +1,195 @@
+// background_compaction.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/background_compaction.h"
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/d_concurrency.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/structure/catalog/namespace_details.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    namespace {
+
+        // one background compaction at a time
+        SimpleMutex bgCompactionLock( "BackgroundCompaction" );
+        std::string bgCompactionNS; // empty when idle
+
+        // records relocated per lock acquisition
+        const int docsPerSlice = 100;
+
+        long long totalOpCount() {
+            return globalOpCounters.getInsert()->get() +
+                globalOpCounters.getQuery()->get() +
+                globalOpCounters.getUpdate()->get() +
+                globalOpCounters.getDelete()->get() +
+                globalOpCounters.getGetMore()->get() +
+                globalOpCounters.getCommand()->get();
+        }
+    }
+
+    bool BackgroundCompaction::start( const std::string& ns, std::string* errmsg ) {
+        SimpleMutex::scoped_lock lk( bgCompactionLock );
+        if ( !bgCompactionNS.empty() ) {
+            *errmsg = str::stream() << "background compaction already running on "
+                                    << bgCompactionNS;
+            return false;
+        }
+        bgCompactionNS = ns;
+        BackgroundCompaction* job = new BackgroundCompaction( ns );
+        job->go(); // self deleting
+        return true;
+    }
+
+    BackgroundCompaction::BackgroundCompaction( const std::string& ns )
+        : BackgroundJob( true /* selfDelete */ ),
+          _ns( ns ),
+          _docsMoved( 0 ),
+          _extentsFreed( 0 ) {
+    }
+
+    void BackgroundCompaction::run() {
+        Client::initThread( name().c_str() );
+        ON_BLOCK_EXIT_OBJ( cc(), &Client::shutdown );
+        cc().getAuthorizationSession()->grantInternalAuthorization();
+
+        log() << "background compaction of " << _ns << " starting" << endl;
+
+        {
+            Lock::DBWrite lk( _ns );
+            Client::Context ctx( _ns );
+            Collection* collection = ctx.db()->getCollection( _ns );
+            if ( collection )
+                _stopExtent = collection->details()->lastExtent();
+        }
+
+        try {
+            while ( !inShutdown() && !_stopExtent.isNull() ) {
+                Timer t;
+                const long long opsBefore = totalOpCount();
+
+                if ( !_compactSlice() )
+                    break;
+
+                // Throttle: take at most ~20% of wall time, and back off
+                // further the more foreground work ran during our slice.
+                const int sliceMillis = t.millis();
+                const long long foregroundOps = totalOpCount() - opsBefore;
+                long long sleep = 4LL * sliceMillis * ( 1 + foregroundOps / 100 );
+                sleepmillis( std::min( 10LL * 1000, std::max( 50LL, sleep ) ) );
+            }
+        }
+        catch ( const DBException& e ) {
+            warning() << "background compaction of " << _ns << " stopped: "
+                      << e.what() << endl;
+        }
+
+        log() << "background compaction of " << _ns << " finished: moved "
+              << _docsMoved << " documents, freed " << _extentsFreed
+              << " extents" << endl;
+
+        SimpleMutex::scoped_lock lk( bgCompactionLock );
+        bgCompactionNS.clear();
+    }
+
+    bool BackgroundCompaction::_compactSlice() {
+        Lock::DBWrite lk( _ns );
+        Client::Context ctx( _ns );
+
+        Collection* collection = ctx.db()->getCollection( _ns );
+        if ( !collection || collection->isCapped() ) {
+            // dropped out from under us; we're done
+            return false;
+        }
+
+        NamespaceDetails* d = collection->details();
+
+        const DiskLoc extLoc = d->firstExtent();
+        if ( extLoc.isNull() || extLoc == _stopExtent || extLoc == d->lastExtent() )
+            return false;
+
+        Extent* e = extLoc.ext();
+
+        if ( extLoc != _currentExtent ) {
+            // Starting on a new extent: relocations must not allocate out of
+            // the extent being drained, so give up the free space collected
+            // so far.  compact does the same, for all extents at once.
+            d->orphanDeletedList();
+            _currentExtent = extLoc;
+        }
+
+        for ( int moved = 0; moved < docsPerSlice; moved++ ) {
+            const DiskLoc loc = e->firstRecord;
+            if ( loc.isNull() )
+                break;
+
+            StatusWith<DiskLoc> newLoc = collection->relocateDocument( loc );
+            uassertStatusOK( newLoc.getStatus() );
+            _docsMoved++;
+
+            // A concurrent remove can put space in this extent back on the
+            // deleted list and the copy may have landed in it; orphan again
+            // so the drain keeps making progress.
+            const DiskLoc moveTo = newLoc.getValue();
+            if ( moveTo.a() == extLoc.a() &&
+                 moveTo.getOfs() >= extLoc.getOfs() &&
+                 moveTo.getOfs() < extLoc.getOfs() + e->length ) {
+                d->orphanDeletedList();
+            }
+        }
+
+        getDur().commitIfNeeded();
+
+        if ( e->firstRecord.isNull() ) {
+            // drained; unlink the extent and free it, as compact does
+            verify( d->firstExtent() == extLoc );
+            verify( d->lastExtent() != extLoc );
+            DiskLoc newFirst = e->xnext;
+            d->firstExtent().writing() = newFirst;
+            newFirst.ext()->xprev.writing().Null();
+            getDur().writing( e )->markEmpty();
+            ctx.db()->getExtentManager().freeExtents( extLoc, extLoc );
+            getDur().commitIfNeeded();
+            _extentsFreed++;
+        }
+
+        return true;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,86 @@
+// background_compaction.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/util/background.h"
+
+namespace mongo {
+
+    /**
+     * Incremental alternative to the compact command: drains a collection's
+     * extents from the front in small write-locked slices, relocating each
+     * record through the normal index-maintenance and cursor-invalidation
+     * paths, and frees every extent it empties.  Between slices it sleeps in
+     * proportion to its own cost and the foreground operation rate, so a
+     * busy primary keeps serving while the collection shrinks.
+     *
+     * Kicked off by { compact: <coll>, background: true }.  Only one runs at
+     * a time; the job self-deletes when it finishes.
+     */
+    class BackgroundCompaction : public BackgroundJob {
+    public:
+        /**
+         * Starts a background compaction of 'ns'.
+         * @return false (and sets errmsg) if one is already running
+         */
+        static bool start( const std::string& ns, std::string* errmsg );
+
+        virtual std::string name() const { return "BackgroundCompaction"; }
+        virtual void run();
+
+    private:
+        explicit BackgroundCompaction( const std::string& ns );
+
+        /**
+         * Relocates up to a slice's worth of records out of the collection's
+         * first extent, freeing the extent once it is empty.
+         * @return true if there is more work to do
+         */
+        bool _compactSlice();
+
+        std::string _ns;
+
+        // the last extent that existed when the job started; everything past
+        // it was allocated since (much of it by our own relocations), so the
+        // drain stops there
+        DiskLoc _stopExtent;
+
+        // the extent currently being drained, Null before the first slice
+        DiskLoc _currentExtent;
+
+        long long _docsMoved;
+        int _extentsFreed;
+    };
+
+}  // namespace mongo
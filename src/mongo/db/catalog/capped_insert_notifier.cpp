@@ -0,0 +1,90 @@
+// capped_insert_notifier.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/catalog/capped_insert_notifier.h"
+
+#include <map>
+
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    CappedInsertNotifier::CappedInsertNotifier()
+        : _mutex( "CappedInsertNotifier" ), _count( 0 ) {
+    }
+
+    void CappedInsertNotifier::notifyOfInsert() {
+        notifyAll();
+    }
+
+    void CappedInsertNotifier::notifyAll() {
+        scoped_lock lk( _mutex );
+        _count++;
+        _cond.notify_all();
+    }
+
+    unsigned long long CappedInsertNotifier::getCount() const {
+        scoped_lock lk( _mutex );
+        return _count;
+    }
+
+    void CappedInsertNotifier::waitForInsert( unsigned long long prevCount,
+                                              unsigned millis ) const {
+        Timer t;
+        scoped_lock lk( _mutex );
+        while ( _count == prevCount ) {
+            int left = millis - t.millis();
+            if ( left <= 0 )
+                return;
+            _cond.timed_wait( lk.boost(), boost::posix_time::milliseconds( left ) );
+        }
+    }
+
+    namespace {
+        mongo::mutex registryMutex( "cappedInsertNotifierRegistry" );
+        typedef std::map< std::string, boost::shared_ptr<CappedInsertNotifier> > NotifierMap;
+        // allocated on first use, intentionally never freed
+        NotifierMap* registry = NULL;
+    }
+
+    boost::shared_ptr<CappedInsertNotifier> CappedInsertNotifier::forNamespace(
+            const StringData& ns ) {
+        scoped_lock lk( registryMutex );
+        if ( !registry )
+            registry = new NotifierMap();
+        boost::shared_ptr<CappedInsertNotifier>& n = (*registry)[ ns.toString() ];
+        if ( !n )
+            n.reset( new CappedInsertNotifier() );
+        return n;
+    }
+
+}
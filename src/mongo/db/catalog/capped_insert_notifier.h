@@ -0,0 +1,100 @@
+// capped_insert_notifier.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
+
+#include "mongo/base/string_data.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Wakes threads tailing a capped collection when a document is inserted
+     * into it.  Writers bump a counter under the collection's write lock;
+     * awaitData getMores that came up empty park here instead of sleeping on
+     * a fixed polling interval, so a tailing reader observes new documents
+     * with signal latency instead of poll latency and idle tailers burn no
+     * cycles.  This generalizes what waitForNewerOplogEntry already does for
+     * the oplog to arbitrary capped collections.
+     *
+     * Notifiers are looked up by namespace (see forNamespace) rather than
+     * held only by the Collection object so a waiter needs no lock and is
+     * unaffected by the collection being dropped while it sleeps; a drop
+     * simply leaves the notifier silent and the waiter times out.
+     */
+    class CappedInsertNotifier {
+    public:
+        CappedInsertNotifier();
+
+        /**
+         * Called after a document has been inserted; the caller still holds
+         * the write lock, so anyone woken and then acquiring the read lock
+         * sees the new document.
+         */
+        void notifyOfInsert();
+
+        /**
+         * Wakes every waiter without a document having arrived.  Called when
+         * the collection goes away (drop, rename, database close) so waiters
+         * re-scan promptly -- and find their cursor dead -- instead of
+         * sitting out the rest of their timeout.
+         */
+        void notifyAll();
+
+        /** Current value of the insert counter, to pass to waitForInsert. */
+        unsigned long long getCount() const;
+
+        /**
+         * Blocks until the insert counter moves past prevCount, or for at
+         * most millis.  prevCount must have been read (via getCount) before
+         * the caller's last empty scan of the collection, so an insert that
+         * raced with that scan makes this return immediately.
+         */
+        void waitForInsert( unsigned long long prevCount, unsigned millis ) const;
+
+        /**
+         * The shared notifier for ns, created on first use.  Entries are
+         * kept for the life of the process (the registry is bounded by the
+         * number of distinct capped namespaces ever tailed or written).
+         */
+        static boost::shared_ptr<CappedInsertNotifier> forNamespace( const StringData& ns );
+
+    private:
+        mutable mongo::mutex _mutex;
+        mutable boost::condition _cond;
+
+        // number of inserts since this notifier was created; guarded by _mutex
+        unsigned long long _count;
+    };
+
+}
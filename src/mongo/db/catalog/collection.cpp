@@ -33,15 +33,20 @@
 #include "mongo/base/counter.h"
 #include "mongo/base/owned_pointer_map.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/commands/dbhash.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/catalog/capped_insert_notifier.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/index_create.h"
+#include "mongo/db/catalog/materialized_projection.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/query/query_result_cache.h"
 #include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/storage/extent.h"
 #include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/storage/record_compression.h"
 #include "mongo/db/structure/collection_iterator.h"
 
 #include "mongo/db/pdfile.h" // XXX-ERH
@@ -86,6 +91,7 @@ namespace mongo {
                                                          details,
                                                          &database->getExtentManager(),
                                                          _ns.coll() == "system.indexes" ) );
+            _cappedNotifier = CappedInsertNotifier::forNamespace( fullNS );
         }
         else {
             _recordStore.reset( new SimpleRecordStoreV1( _ns.ns(),
@@ -99,6 +105,10 @@ namespace mongo {
 
     Collection::~Collection() {
         verify( ok() );
+        // unpark tailing awaitData getMores so they notice the collection is
+        // gone instead of waiting out their full timeout
+        if ( _cappedNotifier )
+            _cappedNotifier->notifyAll();
         _magic = 0;
     }
 
@@ -130,11 +140,13 @@ namespace mongo {
     }
 
     CollectionIterator* Collection::getIterator( const DiskLoc& start, bool tailable,
-                                                     const CollectionScanParams::Direction& dir) const {
+                                                     const CollectionScanParams::Direction& dir,
+                                                     bool adviseDontNeed,
+                                                     bool cooperative ) const {
         verify( ok() );
         if ( _details->isCapped() )
             return new CappedIterator( this, start, tailable, dir );
-        return new FlatIterator( this, start, dir );
+        return new FlatIterator( this, start, dir, adviseDontNeed, cooperative );
     }
 
     int64_t Collection::countTableScan( const MatchExpression* expression ) {
@@ -152,6 +164,11 @@ namespace mongo {
         return count;
     }
 
+    void Collection::_noteWriteForResultCache() {
+        if ( _details->isUserFlagSet( NamespaceDetails::Flag_ResultCache ) )
+            QueryResultCache::get().invalidate( _ns.ns() );
+    }
+
     BSONObj Collection::docFor( const DiskLoc& loc ) {
         Record* rec = getExtentManager()->recordFor( loc );
         return BSONObj::make( rec->accessed() );
@@ -165,6 +182,14 @@ namespace mongo {
         if ( !loc.isOK() )
             return loc;
 
+        // we never saw the document, so any running dbHash digest is now stale
+        dbHashNoteDigestInvalid( _ns.ns() );
+
+        _noteWriteForResultCache();
+
+        if ( _cappedNotifier )
+            _cappedNotifier->notifyOfInsert();
+
         return StatusWith<DiskLoc>( loc );
     }
 
@@ -187,6 +212,11 @@ namespace mongo {
         StatusWith<DiskLoc> status = _insertDocument( docToInsert, enforceQuota );
         if ( status.isOK() ) {
             _details->paddingFits();
+            dbHashNoteInsert( _ns.ns(), docToInsert );
+            _noteWriteForResultCache();
+            if ( _cappedNotifier )
+                _cappedNotifier->notifyOfInsert();
+            MaterializedProjections::global.onInsert( _database, _ns.ns(), docToInsert );
         }
 
         return status;
@@ -209,6 +239,10 @@ namespace mongo {
         if ( !status.isOK() )
             return StatusWith<DiskLoc>( status );
 
+        dbHashNoteInsert( _ns.ns(), doc );
+
+        _noteWriteForResultCache();
+
         return loc;
     }
 
@@ -220,8 +254,17 @@ namespace mongo {
         //       under the RecordStore, this feels broken since that should be a
         //       collection access method probably
 
-        StatusWith<DiskLoc> loc = _recordStore->insertRecord( docToInsert.objdata(),
-                                                              docToInsert.objsize(),
+        const char* recData = docToInsert.objdata();
+        int recLen = docToInsert.objsize();
+        BufBuilder compressed;
+        if ( _details->isUserFlagSet( NamespaceDetails::Flag_CompressRecords ) &&
+             compressRecordData( docToInsert, &compressed ) ) {
+            recData = compressed.buf();
+            recLen = compressed.len();
+        }
+
+        StatusWith<DiskLoc> loc = _recordStore->insertRecord( recData,
+                                                              recLen,
                                                               enforceQuota ? largestFileNumberInQuota() : 0 );
         if ( !loc.isOK() )
             return loc;
@@ -273,6 +316,12 @@ namespace mongo {
         _recordStore->deleteRecord( loc );
 
         _infoCache.notifyOfWriteOp();
+
+        dbHashNoteDelete( _ns.ns(), doc );
+
+        _noteWriteForResultCache();
+
+        MaterializedProjections::global.onDelete( _database, _ns.ns(), doc );
     }
 
     Counter64 moveCounter;
@@ -325,7 +374,18 @@ namespace mongo {
             }
         }
 
-        if ( oldRecord->netLength() < objNew.objsize() ) {
+        // For compressed collections the fit and in-place decisions below are made on the
+        // compressed image of the new document.
+        const char* newRecData = objNew.objdata();
+        int newRecLen = objNew.objsize();
+        BufBuilder compressedNew;
+        if ( _details->isUserFlagSet( NamespaceDetails::Flag_CompressRecords ) &&
+             compressRecordData( objNew, &compressedNew ) ) {
+            newRecData = compressedNew.buf();
+            newRecLen = compressedNew.len();
+        }
+
+        if ( oldRecord->netLength() < newRecLen ) {
             // doesn't fit, have to move to new location
 
             if ( _details->isCapped() )
@@ -354,6 +414,9 @@ namespace mongo {
                 // insert successful, now lets deallocate the old location
                 // remember its already unindexed
                 _recordStore->deleteRecord( oldLocation );
+                dbHashNoteUpdate( _ns.ns(), objOld, objNew );
+                _noteWriteForResultCache();
+                MaterializedProjections::global.onUpdate( _database, _ns.ns(), objOld, objNew );
             }
             else {
                 // new doc insert failed, so lets re-index the old document and location
@@ -386,12 +449,30 @@ namespace mongo {
         _cursorCache.invalidateDocument(oldLocation, INVALIDATION_MUTATION);
 
         //  update in place
-        int sz = objNew.objsize();
-        memcpy(getDur().writingPtr(oldRecord->data(), sz), objNew.objdata(), sz);
+        int sz = newRecLen;
+        memcpy(getDur().writingPtr(oldRecord->data(), sz), newRecData, sz);
+
+        dbHashNoteUpdate( _ns.ns(), objOld, objNew );
+
+        _noteWriteForResultCache();
+
+        MaterializedProjections::global.onUpdate( _database, _ns.ns(), objOld, objNew );
 
         return StatusWith<DiskLoc>( oldLocation );
     }
 
+    bool Collection::wantsInPlaceUpdateNotes() const {
+        return dbHashHasDigests()
+            || _details->isUserFlagSet( NamespaceDetails::Flag_ResultCache )
+            || MaterializedProjections::global.hasProjections( _ns.ns() );
+    }
+
+    void Collection::noteInPlaceUpdate( const BSONObj& objOld, const BSONObj& objNew ) {
+        dbHashNoteUpdate( _ns.ns(), objOld, objNew );
+        _noteWriteForResultCache();
+        MaterializedProjections::global.onUpdate( _database, _ns.ns(), objOld, objNew );
+    }
+
     int64_t Collection::storageSize( int* numExtents, BSONArrayBuilder* extentInfo ) const {
         if ( _details->firstExtent().isNull() ) {
             if ( numExtents )
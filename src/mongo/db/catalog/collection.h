@@ -32,28 +32,28 @@
 
 #include <string>
 
+#include <boost/shared_ptr.hpp>
+
 #include "mongo/base/string_data.h"
 #include "mongo/db/catalog/collection_cursor_cache.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/structure/collection_iterator.h"
 #include "mongo/db/structure/record_store.h"
 #include "mongo/db/catalog/collection_info_cache.h"
 #include "mongo/platform/cstdint.h"
 
 namespace mongo {
 
+    class CappedInsertNotifier;
     class Database;
     class ExtentManager;
     class NamespaceDetails;
     class IndexCatalog;
     class MultiIndexBlock;
 
-    class CollectionIterator;
-    class FlatIterator;
-    class CappedIterator;
-
     class OpDebug;
 
     class DocWriter {
@@ -128,6 +128,8 @@ namespace mongo {
 
         CollectionCursorCache* cursorCache() const { return &_cursorCache; }
 
+        SharedScanCoordinator* sharedScanCoordinator() const { return &_sharedScanCoordinator; }
+
         bool requiresIdIndex() const;
 
         BSONObj docFor( const DiskLoc& loc );
@@ -136,9 +138,15 @@ namespace mongo {
         /**
          * canonical to get all would be
          * getIterator( DiskLoc(), false, CollectionScanParams::FORWARD )
+         * @param adviseDontNeed see CollectionScanParams::adviseDontNeed;
+         *        ignored for capped collections
+         * @param cooperative see CollectionScanParams::cooperative;
+         *        ignored for capped collections
          */
         CollectionIterator* getIterator( const DiskLoc& start, bool tailable,
-                                         const CollectionScanParams::Direction& dir) const;
+                                         const CollectionScanParams::Direction& dir,
+                                         bool adviseDontNeed = false,
+                                         bool cooperative = false ) const;
 
 
         /**
@@ -174,12 +182,31 @@ namespace mongo {
                                             bool enforceQuota,
                                             OpDebug* debug );
 
+        /**
+         * bookkeeping for an update applied straight to the record's bytes
+         * (the in-place damage path in ops/update.cpp), which never comes
+         * through updateDocument().  performs the same notes updateDocument()
+         * does.  'objOld' must be a copy taken before the bytes were patched;
+         * check wantsInPlaceUpdateNotes() first to skip that copy when this
+         * would be a no-op.
+         */
+        void noteInPlaceUpdate( const BSONObj& objOld, const BSONObj& objNew );
+        bool wantsInPlaceUpdateNotes() const;
+
         int64_t storageSize( int* numExtents = NULL, BSONArrayBuilder* extentInfo = NULL ) const;
 
         // -----------
 
         StatusWith<CompactStats> compact( const CompactOptions* options );
 
+        /**
+         * moves the document @ loc into freshly allocated space, keeping the
+         * indexes current and invalidating cursors on the old location.  used
+         * by background compaction to drain extents.
+         * @return the new location of the doc
+         */
+        StatusWith<DiskLoc> relocateDocument( const DiskLoc& loc );
+
         // -----------
 
 
@@ -215,6 +242,12 @@ namespace mongo {
         StatusWith<DiskLoc> _insertDocument( const BSONObj& doc,
                                              bool enforceQuota );
 
+        /**
+         * drops cached query replies for this collection, if it participates in
+         * the result cache (collMod {resultCache: true}).  call on every write.
+         */
+        void _noteWriteForResultCache();
+
         void _compactExtent(const DiskLoc diskloc, int extentNumber,
                             MultiIndexBlock& indexesToInsertTo,
                             const CompactOptions* compactOptions, CompactStats* stats );
@@ -231,6 +264,11 @@ namespace mongo {
         NamespaceDetails* _details;
         Database* _database;
         scoped_ptr<RecordStore> _recordStore;
+
+        // set iff capped; signalled after each insert so tailing awaitData
+        // getMores wake instead of polling
+        boost::shared_ptr<CappedInsertNotifier> _cappedNotifier;
+
         CollectionInfoCache _infoCache;
         IndexCatalog _indexCatalog;
 
@@ -239,6 +277,10 @@ namespace mongo {
         // should be about the data.
         mutable CollectionCursorCache _cursorCache;
 
+        // mutable for the same reason: cooperative scans are read only users
+        // that need somewhere to rendezvous.
+        mutable SharedScanCoordinator _sharedScanCoordinator;
+
         friend class Database;
         friend class FlatIterator;
         friend class CappedIterator;
@@ -37,6 +37,7 @@
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/client.h"
 #include "mongo/db/query/runner.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/random.h"
 #include "mongo/util/startup_test.h"
 
@@ -107,18 +108,36 @@ namespace mongo {
         int64_t nextSeed();
 
     private:
-        SimpleMutex _mutex;
+        // The id registry is split across a fixed number of partitions, each with its
+        // own lock, picked by the low bits of the collection id, so cursor-id lookups
+        // for different collections rarely contend.
+        static const unsigned kNumPartitions = 8;
 
         typedef unordered_map<unsigned,string> Map;
-        Map _idToNS;
-        unsigned _nextId;
 
+        struct Partition {
+            Partition() : mutex( "GlobalCursorIdCache::Partition" ) {}
+
+            SimpleMutex mutex;
+            Map idToNS;
+        };
+
+        Partition& _partitionForId( unsigned id );
+        std::size_t _size();
+
+        Partition _partitions[kNumPartitions];
+        AtomicUInt32 _nextId;
+
+        // Guards '_secureRandom' only.
+        SimpleMutex _randomMutex;
         SecureRandom* _secureRandom;
     } _globalCursorIdCache;
 
+    const unsigned GlobalCursorIdCache::kNumPartitions;
+
     GlobalCursorIdCache::GlobalCursorIdCache()
-        : _mutex( "GlobalCursorIdCache" ),
-          _nextId( 0 ),
+        : _nextId( 0 ),
+          _randomMutex( "GlobalCursorIdCache" ),
           _secureRandom( NULL ) {
     }
 
@@ -126,8 +145,21 @@ namespace mongo {
         // we're just going to leak everything, as it doesn't matter
     }
 
+    GlobalCursorIdCache::Partition& GlobalCursorIdCache::_partitionForId( unsigned id ) {
+        return _partitions[ id & ( kNumPartitions - 1 ) ];
+    }
+
+    std::size_t GlobalCursorIdCache::_size() {
+        size_t total = 0;
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            SimpleMutex::scoped_lock lk( _partitions[p].mutex );
+            total += _partitions[p].idToNS.size();
+        }
+        return total;
+    }
+
     int64_t GlobalCursorIdCache::nextSeed() {
-        SimpleMutex::scoped_lock lk( _mutex );
+        SimpleMutex::scoped_lock lk( _randomMutex );
         if ( !_secureRandom )
             _secureRandom = SecureRandom::create();
         return _secureRandom->nextInt64();
@@ -136,17 +168,18 @@ namespace mongo {
     unsigned GlobalCursorIdCache::created( const std::string& ns ) {
         static const unsigned MAX_IDS = 1000 * 1000 * 1000;
 
-        SimpleMutex::scoped_lock lk( _mutex );
-
-        fassert( 17359, _idToNS.size() < MAX_IDS );
+        fassert( 17359, _size() < MAX_IDS );
 
         for ( unsigned i = 0; i <= MAX_IDS; i++ ) {
-            unsigned id = ++_nextId;
+            unsigned id = _nextId.addAndFetch( 1 );
             if ( id == 0 )
                 continue;
-            if ( _idToNS.count( id ) > 0 )
+
+            Partition& partition = _partitionForId( id );
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            if ( partition.idToNS.count( id ) > 0 )
                 continue;
-            _idToNS[id] = ns;
+            partition.idToNS[id] = ns;
             return id;
         }
 
@@ -154,18 +187,20 @@ namespace mongo {
     }
 
     void GlobalCursorIdCache::destroyed( unsigned id, const std::string& ns ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        invariant( ns == _idToNS[id] );
-        _idToNS.erase( id );
+        Partition& partition = _partitionForId( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        invariant( ns == partition.idToNS[id] );
+        partition.idToNS.erase( id );
     }
 
     bool GlobalCursorIdCache::eraseCursor(CursorId id, bool checkAuth) {
         string ns;
         {
-            SimpleMutex::scoped_lock lk( _mutex );
             unsigned nsid = idFromCursorId( id );
-            Map::const_iterator it = _idToNS.find( nsid );
-            if ( it == _idToNS.end() ) {
+            Partition& partition = _partitionForId( nsid );
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            Map::const_iterator it = partition.idToNS.find( nsid );
+            if ( it == partition.idToNS.end() ) {
                 return false;
             }
             ns = it->second;
@@ -224,9 +259,12 @@ namespace mongo {
 
     std::size_t GlobalCursorIdCache::timeoutCursors( unsigned millisSinceLastCall ) {
         vector<string> todo;
-        {
-            SimpleMutex::scoped_lock lk( _mutex );
-            for ( Map::const_iterator i = _idToNS.begin(); i != _idToNS.end(); ++i )
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            for ( Map::const_iterator i = partition.idToNS.begin();
+                  i != partition.idToNS.end();
+                  ++i )
                 todo.push_back( i->second );
         }
 
@@ -278,9 +316,11 @@ namespace mongo {
     // --------------------------
 
 
+    const unsigned CollectionCursorCache::kNumPartitions;
+
     CollectionCursorCache::CollectionCursorCache( const StringData& ns )
         : _ns( ns.toString() ),
-          _mutex( "CollectionCursorCache" ) {
+          _randomMutex( "CollectionCursorCache" ) {
         _collectionCacheRuntimeId = _globalCursorIdCache.created( _ns );
         _random.reset( new PseudoRandom( _globalCursorIdCache.nextSeed() ) );
     }
@@ -290,180 +330,226 @@ namespace mongo {
         _globalCursorIdCache.destroyed( _collectionCacheRuntimeId, _ns );
     }
 
-    void CollectionCursorCache::invalidateAll( bool collectionGoingAway ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+    CollectionCursorCache::Partition& CollectionCursorCache::_partitionForCursorId( CursorId id ) {
+        return _partitions[ static_cast<unsigned>( id ) & ( kNumPartitions - 1 ) ];
+    }
 
-        for ( RunnerSet::iterator it = _nonCachedRunners.begin();
-              it != _nonCachedRunners.end();
-              ++it ) {
+    CollectionCursorCache::Partition& CollectionCursorCache::_partitionForRunner( Runner* runner ) {
+        // shift off the alignment zeroes so neighbouring allocations spread out
+        const size_t raw = reinterpret_cast<size_t>( runner ) >> 4;
+        return _partitions[ raw & ( kNumPartitions - 1 ) ];
+    }
 
-            // we kill the runner, but it deletes itself
-            Runner* runner = *it;
-            runner->kill();
-            invariant( runner->collection() == NULL );
-        }
-        _nonCachedRunners.clear();
+    void CollectionCursorCache::invalidateAll( bool collectionGoingAway ) {
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+
+            for ( RunnerSet::iterator it = partition.nonCachedRunners.begin();
+                  it != partition.nonCachedRunners.end();
+                  ++it ) {
+
+                // we kill the runner, but it deletes itself
+                Runner* runner = *it;
+                runner->kill();
+                invariant( runner->collection() == NULL );
+            }
+            partition.nonCachedRunners.clear();
 
-        if ( collectionGoingAway ) {
-            // we're going to wipe out the world
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
+            if ( collectionGoingAway ) {
+                // we're going to wipe out the world
+                for ( CursorMap::const_iterator i = partition.cursors.begin();
+                      i != partition.cursors.end();
+                      ++i ) {
+                    ClientCursor* cc = i->second;
 
-                cc->kill();
+                    cc->kill();
 
-                invariant( cc->getRunner() == NULL || cc->getRunner()->collection() == NULL );
+                    invariant( cc->getRunner() == NULL || cc->getRunner()->collection() == NULL );
 
-                // If there is a pinValue >= 100, somebody is actively using the CC and we do
-                // not delete it.  Instead we notify the holder that we killed it.  The holder
-                // will then delete the CC.
-                // pinvalue is <100, so there is nobody actively holding the CC.  We can
-                // safely delete it as nobody is holding the CC.
+                    // If there is a pinValue >= 100, somebody is actively using the CC and we do
+                    // not delete it.  Instead we notify the holder that we killed it.  The holder
+                    // will then delete the CC.
+                    // pinvalue is <100, so there is nobody actively holding the CC.  We can
+                    // safely delete it as nobody is holding the CC.
 
-                if (cc->pinValue() < 100) {
-                    delete cc;
+                    if (cc->pinValue() < 100) {
+                        delete cc;
+                    }
                 }
             }
-        }
-        else {
-            CursorMap newMap;
+            else {
+                CursorMap newMap;
+
+                // collection will still be around, just all Runners are invalid
+                for ( CursorMap::const_iterator i = partition.cursors.begin();
+                      i != partition.cursors.end();
+                      ++i ) {
+                    ClientCursor* cc = i->second;
+
+                    if (cc->isAggCursor) {
+                        // Aggregation cursors don't have their lifetime bound to the underlying collection.
+                        newMap[i->first] = i->second;
+                        continue;
+                    }
+
+                    // Note that a valid ClientCursor state is "no cursor no runner."  This is because
+                    // the set of active cursor IDs in ClientCursor is used as representation of query
+                    // state.  See sharding_block.h.  TODO(greg,hk): Move this out.
+                    if (NULL == cc->getRunner() ) {
+                        newMap.insert( *i );
+                        continue;
+                    }
+
+                    if (cc->pinValue() < 100) {
+                        cc->kill();
+                        delete cc;
+                    }
+                    else {
+                        // this is pinned, so still alive, so we leave around
+                        // we kill the Runner to signal
+                        if ( cc->getRunner() )
+                            cc->getRunner()->kill();
+                        newMap.insert( *i );
+                    }
 
-            // collection will still be around, just all Runners are invalid
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
-
-                if (cc->isAggCursor) {
-                    // Aggregation cursors don't have their lifetime bound to the underlying collection.
-                    newMap[i->first] = i->second;
-                    continue;
-                }
-
-                // Note that a valid ClientCursor state is "no cursor no runner."  This is because
-                // the set of active cursor IDs in ClientCursor is used as representation of query
-                // state.  See sharding_block.h.  TODO(greg,hk): Move this out.
-                if (NULL == cc->getRunner() ) {
-                    newMap.insert( *i );
-                    continue;
-                }
-
-                if (cc->pinValue() < 100) {
-                    cc->kill();
-                    delete cc;
-                }
-                else {
-                    // this is pinned, so still alive, so we leave around
-                    // we kill the Runner to signal
-                    if ( cc->getRunner() )
-                        cc->getRunner()->kill();
-                    newMap.insert( *i );
                 }
 
+                partition.cursors = newMap;
             }
-
-            _cursors = newMap;
         }
     }
 
     void CollectionCursorCache::invalidateDocument( const DiskLoc& dl,
                                                     InvalidationType type ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-
-        for ( RunnerSet::iterator it = _nonCachedRunners.begin();
-              it != _nonCachedRunners.end();
-              ++it ) {
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-            Runner* runner = *it;
-            runner->invalidate(dl, type);
-        }
+            for ( RunnerSet::iterator it = partition.nonCachedRunners.begin();
+                  it != partition.nonCachedRunners.end();
+                  ++it ) {
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            Runner* runner = i->second->getRunner();
-            if ( runner ) {
+                Runner* runner = *it;
                 runner->invalidate(dl, type);
             }
+
+            for ( CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                Runner* runner = i->second->getRunner();
+                if ( runner ) {
+                    runner->invalidate(dl, type);
+                }
+            }
         }
     }
 
     std::size_t CollectionCursorCache::timeoutCursors( unsigned millisSinceLastCall ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        size_t totalTimedOut = 0;
 
-        vector<ClientCursor*> toDelete;
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            if ( cc->shouldTimeout( millisSinceLastCall ) )
-                toDelete.push_back( cc );
-        }
+            vector<ClientCursor*> toDelete;
 
-        for ( vector<ClientCursor*>::const_iterator i = toDelete.begin(); i != toDelete.end(); ++i ) {
-            ClientCursor* cc = *i;
-            _deregisterCursor_inlock( cc );
-            cc->kill();
-            delete cc;
+            for ( CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                ClientCursor* cc = i->second;
+                if ( cc->shouldTimeout( millisSinceLastCall ) )
+                    toDelete.push_back( cc );
+            }
+
+            for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
+                  i != toDelete.end();
+                  ++i ) {
+                ClientCursor* cc = *i;
+                partition.cursors.erase( cc->cursorid() );
+                cc->kill();
+                delete cc;
+            }
+
+            totalTimedOut += toDelete.size();
         }
 
-        return toDelete.size();
+        return totalTimedOut;
     }
 
     void CollectionCursorCache::registerRunner( Runner* runner ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        const std::pair<RunnerSet::iterator, bool> result = _nonCachedRunners.insert(runner);
+        Partition& partition = _partitionForRunner( runner );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        const std::pair<RunnerSet::iterator, bool> result =
+            partition.nonCachedRunners.insert(runner);
         invariant(result.second); // make sure this was inserted
     }
 
     void CollectionCursorCache::deregisterRunner( Runner* runner ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        _nonCachedRunners.erase( runner );
+        Partition& partition = _partitionForRunner( runner );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        partition.nonCachedRunners.erase( runner );
     }
 
     ClientCursor* CollectionCursorCache::find( CursorId id ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorMap::const_iterator it = _cursors.find( id );
-        if ( it == _cursors.end() )
+        Partition& partition = _partitionForCursorId( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        CursorMap::const_iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() )
             return NULL;
         return it->second;
     }
 
     void CollectionCursorCache::getCursorIds( std::set<CursorId>* openCursors ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            openCursors->insert( cc->cursorid() );
+            for ( CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                ClientCursor* cc = i->second;
+                openCursors->insert( cc->cursorid() );
+            }
         }
     }
 
     size_t CollectionCursorCache::numCursors(){
-        SimpleMutex::scoped_lock lk( _mutex );
-        return _cursors.size();
+        size_t total = 0;
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            SimpleMutex::scoped_lock lk( _partitions[p].mutex );
+            total += _partitions[p].cursors.size();
+        }
+        return total;
     }
 
-    CursorId CollectionCursorCache::_allocateCursorId_inlock() {
+    CursorId CollectionCursorCache::registerCursor( ClientCursor* cc ) {
+        invariant( cc );
+
         for ( int i = 0; i < 10000; i++ ) {
-            unsigned mypart = static_cast<unsigned>( _random->nextInt32() );
+            unsigned mypart;
+            {
+                SimpleMutex::scoped_lock lk( _randomMutex );
+                mypart = static_cast<unsigned>( _random->nextInt32() );
+            }
             CursorId id = cursorIdFromParts( _collectionCacheRuntimeId, mypart );
-            if ( _cursors.count( id ) == 0 )
-                return id;
+
+            Partition& partition = _partitionForCursorId( id );
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            if ( partition.cursors.count( id ) > 0 )
+                continue;
+            partition.cursors[id] = cc;
+            return id;
         }
         fassertFailed( 17360 );
     }
 
-    CursorId CollectionCursorCache::registerCursor( ClientCursor* cc ) {
-        invariant( cc );
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorId id = _allocateCursorId_inlock();
-        _cursors[id] = cc;
-        return id;
-    }
-
     void CollectionCursorCache::deregisterCursor( ClientCursor* cc ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        _deregisterCursor_inlock( cc );
-    }
-
-    void CollectionCursorCache::_deregisterCursor_inlock( ClientCursor* cc ) {
         invariant( cc );
         CursorId id = cc->cursorid();
-        _cursors.erase( id );
+        Partition& partition = _partitionForCursorId( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        partition.cursors.erase( id );
     }
 
 }
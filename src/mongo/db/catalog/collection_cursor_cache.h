@@ -110,20 +110,37 @@ namespace mongo {
         static std::size_t timeoutCursorsGlobal( unsigned millisSinceLastCall );
 
     private:
-        CursorId _allocateCursorId_inlock();
-        void _deregisterCursor_inlock( ClientCursor* cc );
+        // Both the cursor registry and the non-cached runner registry are split across
+        // a fixed number of partitions, each guarded by its own lock. A cursor lives in
+        // the partition picked by the low bits of its id, a runner in the one picked by
+        // its pointer, so registration, getMore pins, and deregistration of different
+        // cursors rarely contend, and the invalidation walks only ever hold one
+        // partition's lock at a time. Exclusive access to the whole cache during drops
+        // is provided by the database-level lock, not by these mutexes.
+        static const unsigned kNumPartitions = 8;
+
+        typedef unordered_set<Runner*> RunnerSet;
+        typedef std::map<CursorId,ClientCursor*> CursorMap;
+
+        struct Partition {
+            Partition() : mutex( "CollectionCursorCache::Partition" ) {}
+
+            SimpleMutex mutex;
+            CursorMap cursors;
+            RunnerSet nonCachedRunners;
+        };
+
+        Partition& _partitionForCursorId( CursorId id );
+        Partition& _partitionForRunner( Runner* runner );
 
         string _ns;
         unsigned _collectionCacheRuntimeId;
-        scoped_ptr<PseudoRandom> _random;
-
-        SimpleMutex _mutex;
 
-        typedef unordered_set<Runner*> RunnerSet;
-        RunnerSet _nonCachedRunners;
+        // Guards '_random' only; held just long enough to draw the next id candidate.
+        SimpleMutex _randomMutex;
+        scoped_ptr<PseudoRandom> _random;
 
-        typedef std::map<CursorId,ClientCursor*> CursorMap;
-        CursorMap _cursors;
+        Partition _partitions[kNumPartitions];
     };
 
 }
@@ -34,6 +34,7 @@
 #include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/db/structure/catalog/namespace_details-inl.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_cache_persistence.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/util/debug_util.h"
 
@@ -46,7 +47,8 @@ namespace mongo {
         : _collection( collection ),
           _keysComputed( false ),
           _planCache(new PlanCache(collection->ns().ns())),
-          _querySettings(new QuerySettings()) { }
+          _querySettings(new QuerySettings()),
+          _planCacheRestoreChecked( false ) { }
 
     void CollectionInfoCache::reset() {
         Lock::assertWriteLocked( _collection->ns().ns() );
@@ -89,6 +91,14 @@ namespace mongo {
     }
 
     PlanCache* CollectionInfoCache::getPlanCache() const {
+        if (!_planCacheRestoreChecked) {
+            // First use since startup: install any plans persisted by the previous
+            // instance.  Set the flag before restoring so a concurrent or re-entrant
+            // call cannot loop; a racing double restore is harmless since staged
+            // entries can only be claimed once.
+            _planCacheRestoreChecked = true;
+            restorePlanCacheEntries(_collection, _planCache.get());
+        }
         return _planCache.get();
     }
 
@@ -106,6 +106,10 @@ namespace mongo {
         // Includes index filters.
         boost::scoped_ptr<QuerySettings> _querySettings;
 
+        // Whether getPlanCache() has checked the plan cache persistence staging
+        // area for entries saved by the previous instance.
+        mutable bool _planCacheRestoreChecked;
+
         void computeIndexKeys();
     };
 
@@ -40,14 +40,19 @@
 #include "mongo/db/background.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/catalog/materialized_projection.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/structure/catalog/index_details.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_result_cache.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/index_advisor.h"
+#include "mongo/db/stats/operation_latency_histogram.h"
+#include "mongo/db/stats/working_set_stats.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
 
@@ -416,6 +421,11 @@ namespace mongo {
         LOG(1) << "\t dropIndexes done" << endl;
 
         Top::global.collectionDropped( fullns );
+        LatencyStats::global.collectionDropped( fullns );
+        WorkingSetStats::global.collectionDropped( fullns );
+        IndexAdvisor::global.collectionDropped( fullns );
+        MaterializedProjections::global.collectionDropped( fullns );
+        QueryResultCache::get().invalidate( fullns.toString() );
 
         Status s = _dropNS( fullns );
 
@@ -542,6 +552,10 @@ namespace mongo {
         }
 
         Top::global.collectionDropped( fromNS.toString() );
+        LatencyStats::global.collectionDropped( fromNS );
+        WorkingSetStats::global.collectionDropped( fromNS );
+        IndexAdvisor::global.collectionDropped( fromNS );
+        MaterializedProjections::global.collectionDropped( fromNS );
 
         return Status::OK();
     }
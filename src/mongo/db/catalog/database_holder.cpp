@@ -38,26 +38,35 @@
 
 namespace mongo {
 
-    Database* DatabaseHolder::getOrCreate( const string& ns, const string& path, bool& justCreated ) {
+    size_t DatabaseHolder::_bucketFor( const string& db , const string& path ) {
+        StringData::Hasher hash;
+        return ( hash( db ) ^ ( hash( path ) << 1 ) ) & ( NumBuckets - 1 );
+    }
+
+    DatabaseHolder::Entry* DatabaseHolder::_find( const string& db , const string& path ) const {
+        for ( Entry* e = _buckets[ _bucketFor( db , path ) ].load(); e; e = e->next ) {
+            if ( e->db == db && e->path == path )
+                return e;
+        }
+        return 0;
+    }
+
+    Database* DatabaseHolder::getOrCreate( const string& ns , const string& path , bool& justCreated ) {
         string dbname = _todb( ns );
         {
-            SimpleMutex::scoped_lock lk(_m);
             Lock::assertAtLeastReadLocked(ns);
-            DBs& m = _paths[path];
-            {
-                DBs::iterator i = m.find(dbname);
-                if( i != m.end() ) {
-                    justCreated = false;
-                    return i->second;
-                }
+            Entry* e = _find( dbname , path );
+            if ( e ) {
+                justCreated = false;
+                return e->database;
             }
 
             // todo: protect against getting sprayed with requests for different db names that DNE -
-            //       that would make the DBs map very large.  not clear what to do to handle though,
+            //       that would make the registry very large.  not clear what to do to handle though,
             //       perhaps just log it, which is what we do here with the "> 40" :
             bool cant = !Lock::isWriteLocked(ns);
             if( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1)) ||
-                m.size() > 40 || cant || DEBUG_BUILD ) {
+                _size.load() > 40 || cant || DEBUG_BUILD ) {
                 log() << "opening db: "
                       << (path == storageGlobalParams.dbpath ? "" : path) << ' ' << dbname
                       << endl;
@@ -69,32 +78,58 @@ namespace mongo {
         // once we start creating a new database
         cc().writeHappened();
 
-        // this locks _m for defensive checks, so we don't want to be locked right here :
+        // this reads the registry for defensive checks, so we create it before
+        // taking the writers' mutex :
         Database *db = new Database( dbname.c_str() , justCreated , path );
 
         {
             SimpleMutex::scoped_lock lk(_m);
-            DBs& m = _paths[path];
-            verify( m[dbname] == 0 );
-            m[dbname] = db;
-            _size++;
+            AtomicWord<Entry*>& bucket = _buckets[ _bucketFor( dbname , path ) ];
+            verify( _find( dbname , path ) == 0 );
+            // push at the head; concurrent lock free readers see either the
+            // old head or the fully constructed new entry
+            bucket.store( new Entry( path , dbname , db , bucket.load() ) );
+            _size.addAndFetch(1);
         }
 
         return db;
     }
 
+    void DatabaseHolder::erase( const string& ns , const string& path ) {
+        // a global write lock means no reader can be walking a chain, so
+        // unlinking and deleting the entry here is safe
+        verify( Lock::isW() );
+        string dbname = _todb( ns );
+
+        SimpleMutex::scoped_lock lk(_m);
+        AtomicWord<Entry*>& bucket = _buckets[ _bucketFor( dbname , path ) ];
+        Entry* prev = 0;
+        for ( Entry* e = bucket.load(); e; prev = e, e = e->next ) {
+            if ( e->db == dbname && e->path == path ) {
+                if ( prev )
+                    prev->next = e->next;
+                else
+                    bucket.store( e->next );
+                delete e;
+                _size.subtractAndFetch(1);
+                return;
+            }
+        }
+    }
+
     bool DatabaseHolder::closeAll( const string& path , BSONObjBuilder& result , bool force ) {
         log() << "DatabaseHolder::closeAll path:" << path << endl;
         verify( Lock::isW() );
         getDur().commitNow(); // bad things happen if we close a DB with outstanding writes
 
-        map<string,Database*>& m = _paths[path];
-        _size -= m.size();
-
         set< string > dbs;
-        for ( map<string,Database*>::iterator i = m.begin(); i != m.end(); i++ ) {
-            wassert( i->second->path() == path );
-            dbs.insert( i->first );
+        for ( int b = 0; b < NumBuckets; b++ ) {
+            for ( Entry* e = _buckets[b].load(); e; e = e->next ) {
+                if ( e->path == path ) {
+                    wassert( e->database->path() == path );
+                    dbs.insert( e->db );
+                }
+            }
         }
 
         currentClient.get()->getContext()->_clear();
@@ -32,35 +32,48 @@
 
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
 
-namespace mongo { 
+namespace mongo {
 
     /**
      * path + dbname -> Database
+     *
+     * Looked up for essentially every operation entering mongod, so the read
+     * path is lock free: entries hang off a fixed array of hash buckets whose
+     * heads are published atomically, and lookups just walk their bucket's
+     * chain without writing any shared state.  This is safe because
+     *   - entries are only ever pushed at the head of a chain, fully
+     *     constructed, so a concurrent reader sees either the old head or the
+     *     new one;
+     *   - entries are only unlinked and deleted while globally write locked
+     *     (see erase/closeAll), which excludes every reader.
+     * Writers (open/close of a database -- rare) serialize on _m.
      */
     class DatabaseHolder {
-        typedef map<string,Database*> DBs;
-        typedef map<string,DBs> Paths;
-        // todo: we want something faster than this if called a lot:
-        mutable SimpleMutex _m;
-        Paths _paths;
-        int _size;
+        /** bucket chain node.  path/db/database never change after construction;
+            next only changes while globally write locked. */
+        struct Entry : boost::noncopyable {
+            Entry( const string& p , const string& d , Database* dbp , Entry* n )
+                : path(p), db(d), database(dbp), next(n) {}
+            const string path;
+            const string db;
+            Database* const database;
+            Entry* next;
+        };
+
+        enum { NumBuckets = 128 }; // power of two
+
+        mutable SimpleMutex _m;    // serializes writers only; readers never take it
+        AtomicWord<Entry*> _buckets[NumBuckets];
+        AtomicInt32 _size;
     public:
-        DatabaseHolder() : _m("dbholder"),_size(0) { }
+        DatabaseHolder() : _m("dbholder") { }
 
         bool __isLoaded( const string& ns , const string& path ) const {
-            SimpleMutex::scoped_lock lk(_m);
-            Paths::const_iterator x = _paths.find( path );
-            if ( x == _paths.end() )
-                return false;
-            const DBs& m = x->second;
-
-            string db = _todb( ns );
-
-            DBs::const_iterator it = m.find(db);
-            return it != m.end();
+            return _find( _todb( ns ) , path ) != 0;
         }
-        // must be write locked as otherwise isLoaded could go false->true on you 
+        // must be write locked as otherwise isLoaded could go false->true on you
         // in the background and you might not expect that.
         bool _isLoaded( const string& ns , const string& path ) const {
             Lock::assertWriteLocked(ns);
@@ -68,49 +81,40 @@ namespace mongo {
         }
 
         Database * get( const string& ns , const string& path ) const {
-            SimpleMutex::scoped_lock lk(_m);
             Lock::assertAtLeastReadLocked(ns);
-            Paths::const_iterator x = _paths.find( path );
-            if ( x == _paths.end() )
-                return 0;
-            const DBs& m = x->second;
-            string db = _todb( ns );
-            DBs::const_iterator it = m.find(db);
-            if ( it != m.end() )
-                return it->second;
-            return 0;
+            Entry* e = _find( _todb( ns ) , path );
+            return e ? e->database : 0;
         }
 
         Database* getOrCreate( const string& ns , const string& path , bool& justCreated );
 
-        void erase( const string& ns , const string& path ) {
-            SimpleMutex::scoped_lock lk(_m);
-            verify( Lock::isW() );
-            DBs& m = _paths[path];
-            _size -= (int)m.erase( _todb( ns ) );
-        }
+        void erase( const string& ns , const string& path );
 
         /** @param force - force close even if something underway - use at shutdown */
         bool closeAll( const string& path , BSONObjBuilder& result, bool force );
 
         // "info" as this is informational only could change on you if you are not write locked
-        int sizeInfo() const { return _size; }
+        int sizeInfo() const { return _size.load(); }
 
         /**
          * gets all unique db names, ignoring paths
          * need some lock
          */
         void getAllShortNames( set<string>& all ) const {
-            SimpleMutex::scoped_lock lk(_m);
-            for ( Paths::const_iterator i=_paths.begin(); i!=_paths.end(); i++ ) {
-                DBs m = i->second;
-                for( DBs::const_iterator j=m.begin(); j!=m.end(); j++ ) {
-                    all.insert( j->first );
+            for ( int b = 0; b < NumBuckets; b++ ) {
+                for ( Entry* e = _buckets[b].load(); e; e = e->next ) {
+                    all.insert( e->db );
                 }
             }
         }
 
     private:
+        static size_t _bucketFor( const string& db , const string& path );
+
+        /** lock free lookup; caller must hold at least a read lock on the db
+            so the entry can't be deleted out from under it */
+        Entry* _find( const string& db , const string& path ) const;
+
         static string _todb( const string& ns ) {
             string d = __todb( ns );
             uassert( 13280 , (string)"invalid db name: " + ns , NamespaceString::validDBName( d ) );
@@ -128,11 +132,11 @@ namespace mongo {
     };
 
     DatabaseHolder& dbHolderUnchecked();
-    inline const DatabaseHolder& dbHolder() { 
+    inline const DatabaseHolder& dbHolder() {
         dassert( Lock::isLocked() );
         return dbHolderUnchecked();
     }
-    inline DatabaseHolder& dbHolderW() { 
+    inline DatabaseHolder& dbHolderW() {
         dassert( Lock::isW() );
         return dbHolderUnchecked();
     }
@@ -0,0 +1,253 @@
+// index_build_checkpoint.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/catalog/index_build_checkpoint.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/scoped_array.hpp>
+#include <cctype>
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/file.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+    // Seconds between checkpoints of a resumable foreground index build.
+    // <= 0 disables checkpointing.
+    MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildCheckpointIntervalSecs, int, 600);
+
+    namespace {
+        const int kCheckpointVersion = 1;
+    }
+
+    IndexBuildCheckpoint::IndexBuildCheckpoint( const std::string& ns,
+                                                const BSONObj& indexInfo,
+                                                IndexAccessMethod* bulk )
+        : _ns( ns ),
+          _indexInfo( indexInfo.getOwned() ),
+          _indexName( indexInfo["name"].String() ),
+          _bulk( bulk ),
+          _broken( false ) {
+    }
+
+    void IndexBuildCheckpoint::noteIndexed( const DiskLoc& loc ) {
+        if ( _broken )
+            return;
+
+        int interval = internalIndexBuildCheckpointIntervalSecs;
+        if ( interval <= 0 )
+            return;
+
+        if ( _sinceLastSave.seconds() < interval )
+            return;
+
+        try {
+            _save( loc );
+        }
+        catch ( const std::exception& e ) {
+            warning() << "index build checkpoint failed for " << _ns
+                      << " index: " << _indexName << " error: " << e.what();
+            _broken = true;
+        }
+        _sinceLastSave.reset();
+    }
+
+    void IndexBuildCheckpoint::_save( const DiskLoc& loc ) {
+        BSONObjBuilder b;
+        b.append( "version", kCheckpointVersion );
+        b.append( "ns", _ns );
+        b.append( "spec", _indexInfo );
+        b.append( "lastLoc", BSON( "file" << loc.a() << "ofs" << loc.getOfs() ) );
+        if ( !_bulk->saveBulkCheckpoint( &b ) ) {
+            _broken = true;
+            return;
+        }
+        BSONObj state = b.obj();
+
+        // Temp write, fsync, rename: a crash mid-save leaves the previous
+        // checkpoint document in place.
+        const std::string path = _statePath( _ns, _indexName );
+        const std::string tmpPath = path + ".tmp";
+
+        boost::filesystem::create_directories( _resumeRoot() );
+        boost::filesystem::remove( tmpPath );
+        {
+            File f;
+            f.open( tmpPath.c_str() );
+            f.write( 0, state.objdata(), state.objsize() );
+            f.fsync();
+            if ( f.bad() ) {
+                _broken = true;
+                return;
+            }
+        }
+        boost::filesystem::rename( tmpPath, path );
+
+        LOG(1) << "index build checkpoint saved for " << _ns
+               << " index: " << _indexName << " at " << loc.toString();
+    }
+
+    // static
+    BSONObj IndexBuildCheckpoint::load( const std::string& ns, const BSONObj& indexInfo ) {
+        std::string indexName;
+        try {
+            indexName = indexInfo["name"].String();
+            const std::string path = _statePath( ns, indexName );
+            if ( !boost::filesystem::exists( path ) )
+                return BSONObj();
+
+            BSONObj state;
+            {
+                const boost::uintmax_t len = boost::filesystem::file_size( path );
+                if ( len < 5 ||
+                     len > static_cast<boost::uintmax_t>( BSONObjMaxInternalSize ) ) {
+                    discard( ns, indexName );
+                    return BSONObj();
+                }
+
+                boost::scoped_array<char> buf( new char[len] );
+                File f;
+                f.open( path.c_str(), true );
+                f.read( 0, buf.get(), static_cast<unsigned>( len ) );
+                if ( f.bad() || !validateBSON( buf.get(), len ).isOK() ) {
+                    discard( ns, indexName );
+                    return BSONObj();
+                }
+                state = BSONObj( buf.get() ).getOwned();
+            }
+
+            BSONObj lastLoc;
+            if ( state["lastLoc"].type() == Object )
+                lastLoc = state["lastLoc"].Obj();
+
+            if ( kCheckpointVersion != state["version"].numberInt() ||
+                 ns != state["ns"].str() ||
+                 state["spec"].type() != Object ||
+                 !indexInfo.binaryEqual( state["spec"].Obj() ) ||
+                 !lastLoc["file"].isNumber() ||
+                 !lastLoc["ofs"].isNumber() ) {
+                discard( ns, indexName );
+                return BSONObj();
+            }
+
+            return state;
+        }
+        catch ( const std::exception& e ) {
+            warning() << "could not load index build checkpoint for " << ns
+                      << " error: " << e.what();
+            if ( !indexName.empty() )
+                discard( ns, indexName );
+            return BSONObj();
+        }
+    }
+
+    // static
+    DiskLoc IndexBuildCheckpoint::lastLoc( const BSONObj& state ) {
+        BSONObj loc = state["lastLoc"].Obj();
+        return DiskLoc( loc["file"].numberInt(), loc["ofs"].numberInt() );
+    }
+
+    // static
+    void IndexBuildCheckpoint::discard( const std::string& ns, const std::string& indexName ) {
+        try {
+            const std::string path = _statePath( ns, indexName );
+            boost::filesystem::remove( path );
+            boost::filesystem::remove( path + ".tmp" );
+            boost::filesystem::remove_all( runDir( ns, indexName ) );
+        }
+        catch ( const std::exception& e ) {
+            warning() << "could not remove index build checkpoint for " << ns
+                      << " index: " << indexName << " error: " << e.what();
+        }
+    }
+
+    // static
+    void IndexBuildCheckpoint::discardDocument( const std::string& ns,
+                                                const std::string& indexName ) {
+        try {
+            const std::string path = _statePath( ns, indexName );
+            boost::filesystem::remove( path );
+            boost::filesystem::remove( path + ".tmp" );
+        }
+        catch ( const std::exception& e ) {
+            warning() << "could not remove index build checkpoint for " << ns
+                      << " index: " << indexName << " error: " << e.what();
+        }
+    }
+
+    // static
+    void IndexBuildCheckpoint::discardAll() {
+        try {
+            boost::filesystem::remove_all( _resumeRoot() );
+        }
+        catch ( const std::exception& e ) {
+            warning() << "could not clean index build resume directory: " << e.what();
+        }
+    }
+
+    // static
+    std::string IndexBuildCheckpoint::runDir( const std::string& ns,
+                                              const std::string& indexName ) {
+        return _resumeRoot() + "/" + _baseName( ns, indexName ) + ".runs";
+    }
+
+    // static
+    std::string IndexBuildCheckpoint::_statePath( const std::string& ns,
+                                                  const std::string& indexName ) {
+        return _resumeRoot() + "/" + _baseName( ns, indexName ) + ".checkpoint";
+    }
+
+    // static
+    std::string IndexBuildCheckpoint::_resumeRoot() {
+        return storageGlobalParams.dbpath + "/_index_build_resume";
+    }
+
+    // static
+    std::string IndexBuildCheckpoint::_baseName( const std::string& ns,
+                                                 const std::string& indexName ) {
+        // Index names can contain anything, so sanitize for the filesystem.
+        // A collision between sanitized names is harmless: the ns and spec
+        // stored in the document are what load() actually trusts.
+        std::string name = ns + "." + indexName;
+        for ( size_t i = 0; i < name.size(); i++ ) {
+            char c = name[i];
+            if ( !isalnum( static_cast<unsigned char>( c ) ) &&
+                 c != '.' && c != '-' && c != '_' ) {
+                name[i] = '_';
+            }
+        }
+        return name;
+    }
+
+}  // namespace mongo
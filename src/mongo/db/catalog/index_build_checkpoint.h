@@ -0,0 +1,127 @@
+// index_build_checkpoint.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    class IndexAccessMethod;
+
+    /**
+     * Crash-resumable progress for a foreground (bulk) index build.
+     *
+     * While the build scans the collection, an instance of this class
+     * periodically persists the external sorter's finished runs (see
+     * IndexAccessMethod::saveBulkCheckpoint) and the scan position under
+     * <dbpath>/_index_build_resume.  If the server dies mid-build, the
+     * restart rebuild (IndexRebuilder) finds the state, seeds the new bulk
+     * with the persisted runs and continues the scan after the last
+     * checkpointed record instead of rescanning and re-sorting everything.
+     *
+     * The state document is written to a temp file and renamed into place,
+     * so a crash during a save leaves the previous checkpoint intact.  Run
+     * files not yet referenced by the document are simply ignored on resume.
+     *
+     * A given (ns, index name) has at most one build at a time - the catalog
+     * guarantees that - so names derived from the pair can't collide between
+     * concurrent builds.  All failures here are swallowed: losing a
+     * checkpoint only costs resumability, never build correctness.
+     */
+    class IndexBuildCheckpoint {
+    public:
+        /**
+         * @param bulk the access method from initiateBulk, already prepared
+         *        with prepareResumableBulk; not owned
+         */
+        IndexBuildCheckpoint( const std::string& ns,
+                              const BSONObj& indexInfo,
+                              IndexAccessMethod* bulk );
+
+        /**
+         * Call after each record is handed to the bulk; writes a checkpoint
+         * once the configured interval has passed.  'loc' must be the
+         * location of that record.  Never throws.
+         */
+        void noteIndexed( const DiskLoc& loc );
+
+        /** Directory a resumable build's sorted runs live in. */
+        static std::string runDir( const std::string& ns, const std::string& indexName );
+
+        /**
+         * Loads persisted state for this build.  Returns an empty object -
+         * and removes whatever was found - when there is none or it doesn't
+         * match 'indexInfo'.
+         */
+        static BSONObj load( const std::string& ns, const BSONObj& indexInfo );
+
+        /** The scan position recorded in a document returned by load(). */
+        static DiskLoc lastLoc( const BSONObj& state );
+
+        /** Removes the state document and run files for this build. */
+        static void discard( const std::string& ns, const std::string& indexName );
+
+        /**
+         * Removes just the state document, leaving the run files to their
+         * owners (the sorter's iterators delete them as the merge drains).
+         * Called right before the bulk commit: past that point the runs may
+         * reference records that dropDups deletes, so a crash must restart
+         * the build rather than resume it.
+         */
+        static void discardDocument( const std::string& ns, const std::string& indexName );
+
+        /**
+         * Removes the whole resume directory.  Called once the startup
+         * rebuild pass has finished: anything still there belongs to an
+         * unfinished index that no longer exists.
+         */
+        static void discardAll();
+
+    private:
+        void _save( const DiskLoc& loc );
+
+        static std::string _resumeRoot();
+        static std::string _baseName( const std::string& ns, const std::string& indexName );
+        static std::string _statePath( const std::string& ns, const std::string& indexName );
+
+        const std::string _ns;
+        const BSONObj _indexInfo;
+        const std::string _indexName;
+        IndexAccessMethod* const _bulk; // not owned
+        Timer _sinceLastSave;
+        bool _broken; // a save failed; don't keep trying
+    };
+
+}  // namespace mongo
@@ -58,6 +58,7 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/rs.h" // this is ugly
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/stats/index_usage_tracker.h"
 #include "mongo/db/storage/data_file.h"
 #include "mongo/db/structure/catalog/namespace_details-inl.h"
 #include "mongo/util/assert_util.h"
@@ -838,6 +839,8 @@ namespace mongo {
 
         _collection->_database->_clearCollectionCache( indexNamespace );
 
+        IndexUsageTracker::global.indexDropped( indexNamespace );
+
         _checkMagic();
 
         return Status::OK();
@@ -1073,6 +1076,12 @@ namespace mongo {
         return entry->accessMethod();
     }
 
+    const IndexCatalogEntry* IndexCatalog::getEntry( const IndexDescriptor* desc ) const {
+        const IndexCatalogEntry* entry = _entries.find( desc );
+        massert( 17468, "cannot find index entry", entry );
+        return entry;
+    }
+
     IndexAccessMethod* IndexCatalog::_createAccessMethod( const IndexDescriptor* desc,
                                                           IndexCatalogEntry* entry ) {
         const string& type = desc->getAccessMethodName();
@@ -104,6 +104,9 @@ namespace mongo {
         IndexAccessMethod* getIndex( const IndexDescriptor* desc );
         const IndexAccessMethod* getIndex( const IndexDescriptor* desc ) const;
 
+        // never returns NULL
+        const IndexCatalogEntry* getEntry( const IndexDescriptor* desc ) const;
+
         class IndexIterator {
         public:
             bool more();
@@ -47,7 +47,9 @@
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_build_checkpoint.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 
@@ -79,7 +81,9 @@ namespace mongo {
     unsigned long long addExistingToIndex( Collection* collection,
                                            const IndexDescriptor* descriptor,
                                            IndexAccessMethod* accessMethod,
-                                           bool shouldYield ) {
+                                           bool shouldYield,
+                                           const DiskLoc& resumeFromLoc,
+                                           IndexBuildCheckpoint* checkpoint ) {
 
         string ns = collection->ns().ns(); // our copy for sanity
 
@@ -104,7 +108,9 @@ namespace mongo {
         unsigned long long n = 0;
         unsigned long long numDropped = 0;
 
-        auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
+        auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns,
+                                                                InternalPlanner::FORWARD,
+                                                                resumeFromLoc));
 
         // We're not delegating yielding to the runner because we need to know when a yield
         // happens.
@@ -119,6 +125,11 @@ namespace mongo {
         BSONObj js;
         DiskLoc loc;
         while (Runner::RUNNER_ADVANCED == runner->getNext(&js, &loc)) {
+            if (loc == resumeFromLoc) {
+                // The scan starts at resumeFromLoc inclusively and the
+                // checkpointed record itself was already indexed.
+                continue;
+            }
             try {
                 if ( !dupsAllowed && dropDups ) {
                     LastError::Disabled led( lastError.get() );
@@ -166,6 +177,11 @@ namespace mongo {
             progress.hit();
 
             getDur().commitIfNeeded();
+
+            if (checkpoint) {
+                checkpoint->noteIndexed(loc);
+            }
+
             if (shouldYield && yieldPolicy.shouldYield()) {
                 if (!yieldPolicy.yieldAndCheckIfOK(runner.get())) {
                     uasserted(12584, "cursor gone during bg index");
@@ -242,42 +258,86 @@ namespace mongo {
         if ( bulk )
             log() << "\t building index using bulk method";
 
-        unsigned long long n = addExistingToIndex( collection,
-                                                   btreeState->descriptor(),
-                                                   iam,
-                                                   doInBackground );
+        // A bulk (foreground) build can checkpoint its progress so a crash
+        // mid-build resumes here instead of starting over.  Pointless when
+        // the rebuild-on-restart pass is disabled.
+        DiskLoc resumeFromLoc;
+        scoped_ptr<IndexBuildCheckpoint> checkpoint;
+        if ( bulk && serverGlobalParams.indexBuildRetry && !inDBRepair ) {
+            BSONObj state = IndexBuildCheckpoint::load( ns, idxInfo );
+            if ( bulk->prepareResumableBulk(
+                     IndexBuildCheckpoint::runDir( ns, idx->indexName() ), state ) ) {
+                checkpoint.reset( new IndexBuildCheckpoint( ns, idxInfo, bulk ) );
+                if ( !state.isEmpty() ) {
+                    resumeFromLoc = IndexBuildCheckpoint::lastLoc( state );
+                    log() << "\t resuming index build from checkpoint at "
+                          << resumeFromLoc.toString();
+                }
+            }
+            else if ( !state.isEmpty() ) {
+                // checkpoint exists but can't be used; rebuild from scratch
+                IndexBuildCheckpoint::discard( ns, idx->indexName() );
+            }
+        }
+
+        unsigned long long n = 0;
+        try {
+            n = addExistingToIndex( collection,
+                                    btreeState->descriptor(),
+                                    iam,
+                                    doInBackground,
+                                    resumeFromLoc,
+                                    checkpoint.get() );
+
+            if ( bulk ) {
+                if ( checkpoint ) {
+                    // The checkpoint only covers the scan phase.  From here
+                    // on dropDups may delete records the persisted runs point
+                    // at, so a crash below must restart the build.
+                    IndexBuildCheckpoint::discardDocument( ns, idx->indexName() );
+                }
+
+                LOG(1) << "\t bulk commit starting";
+                std::set<DiskLoc> dupsToDrop;
 
-        if ( bulk ) {
-            LOG(1) << "\t bulk commit starting";
-            std::set<DiskLoc> dupsToDrop;
+                Status status = btreeState->accessMethod()->commitBulk( bulk,
+                                                                        mayInterrupt,
+                                                                        &dupsToDrop );
+                massert( 17398,
+                         str::stream() << "commitBulk failed: " << status.toString(),
+                         status.isOK() );
 
-            Status status = btreeState->accessMethod()->commitBulk( bulk,
-                                                                    mayInterrupt,
-                                                                    &dupsToDrop );
-            massert( 17398,
-                     str::stream() << "commitBulk failed: " << status.toString(),
-                     status.isOK() );
+                if ( dupsToDrop.size() )
+                    log() << "\t bulk dropping " << dupsToDrop.size() << " dups";
 
-            if ( dupsToDrop.size() )
-                log() << "\t bulk dropping " << dupsToDrop.size() << " dups";
+                for( set<DiskLoc>::const_iterator i = dupsToDrop.begin(); i != dupsToDrop.end(); ++i ) {
+                    BSONObj toDelete;
+                    collection->deleteDocument( *i,
+                                                false /* cappedOk */,
+                                                true /* noWarn */,
+                                                &toDelete );
+                    if ( isMaster( ns.c_str() ) ) {
+                        logOp( "d", ns.c_str(), toDelete );
+                    }
 
-            for( set<DiskLoc>::const_iterator i = dupsToDrop.begin(); i != dupsToDrop.end(); ++i ) {
-                BSONObj toDelete;
-                collection->deleteDocument( *i,
-                                            false /* cappedOk */,
-                                            true /* noWarn */,
-                                            &toDelete );
-                if ( isMaster( ns.c_str() ) ) {
-                    logOp( "d", ns.c_str(), toDelete );
-                }
-                
-                getDur().commitIfNeeded();
+                    getDur().commitIfNeeded();
 
-                RARELY if ( mayInterrupt ) {
-                    killCurrentOp.checkForInterrupt();
+                    RARELY if ( mayInterrupt ) {
+                        killCurrentOp.checkForInterrupt();
+                    }
                 }
             }
         }
+        catch ( ... ) {
+            // An in-process failure tears the unfinished index down entirely,
+            // so a checkpoint for it could never be resumed.
+            if ( checkpoint )
+                IndexBuildCheckpoint::discard( ns, idx->indexName() );
+            throw;
+        }
+
+        if ( checkpoint )
+            IndexBuildCheckpoint::discard( ns, idx->indexName() );
 
         verify( !btreeState->head().isNull() );
         MONGO_TLOG(0) << "build index done.  scanned " << n << " total records. "
@@ -0,0 +1,595 @@
+// materialized_projection.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/catalog/materialized_projection.h"
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/ops/insert.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/query_planner_common.h"
+#include "mongo/db/structure/collection_iterator.h"
+#include "mongo/platform/unordered_set.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+
+        /** true if path's top-level field is one of the projected fields */
+        bool topLevelProjected( const std::set<std::string>& fields, const char* path ) {
+            const char* dot = strchr( path, '.' );
+            const std::string top = dot ? std::string( path, dot - path ) : std::string( path );
+            return fields.count( top ) > 0;
+        }
+
+        /**
+         * Can 'def' answer a query with this parsed form?  The caller has
+         * already rejected special queries (explain, hint, snapshot, text,
+         * $where, geo, ...) and collected the fields the filter touches.
+         */
+        bool canAnswer( const MaterializedProjections::Def& def,
+                        const LiteParsedQuery& pq,
+                        const unordered_set<std::string>& filterFields ) {
+
+            // the query must repeat every definition equality verbatim, so
+            // each of its results is guaranteed to be in the projection
+            BSONObjIterator fi( def.filter );
+            while ( fi.more() ) {
+                BSONElement fe = fi.next();
+                BSONElement qe = pq.getFilter()[fe.fieldName()];
+                if ( qe.eoo() || !qe.valuesEqual( fe ) )
+                    return false;
+                if ( qe.type() == Object || qe.type() == Array || qe.type() == RegEx )
+                    return false;
+            }
+
+            // every field the residual filter examines must be stored
+            for ( unordered_set<std::string>::const_iterator it = filterFields.begin();
+                  it != filterFields.end(); ++it ) {
+                if ( !topLevelProjected( def.fields, it->c_str() ) )
+                    return false;
+            }
+
+            // sort fields must be stored too
+            BSONObjIterator si( pq.getSort() );
+            while ( si.more() ) {
+                BSONElement e = si.next();
+                if ( e.fieldName()[0] == '$' || !e.isNumber() )
+                    return false;
+                if ( !topLevelProjected( def.fields, e.fieldName() ) )
+                    return false;
+            }
+
+            // and the query's own projection must be a plain inclusion within
+            // the stored fields; without one we would have to return whole
+            // documents, which the projection no longer has
+            const BSONObj& proj = pq.getProj();
+            if ( proj.isEmpty() )
+                return false;
+            BSONObjIterator pi( proj );
+            while ( pi.more() ) {
+                BSONElement e = pi.next();
+                if ( str::equals( e.fieldName(), "_id" ) )
+                    continue; // in- or excluded, always stored
+                if ( strchr( e.fieldName(), '$' ) || e.isABSONObj() || !e.trueValue() )
+                    return false;
+                if ( !topLevelProjected( def.fields, e.fieldName() ) )
+                    return false;
+            }
+
+            return true;
+        }
+    }
+
+    BSONObj MaterializedProjections::project( const std::set<std::string>& fields,
+                                              const BSONObj& doc ) {
+        BSONObjBuilder b;
+        BSONObjIterator i( doc );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            if ( fields.count( e.fieldName() ) )
+                b.append( e );
+        }
+        return b.obj();
+    }
+
+    Status MaterializedProjections::add( const Def& def ) {
+        SimpleMutex::scoped_lock lk( _lock );
+        std::vector<Def>& defs = _defs[def.sourceNS];
+        for ( size_t i = 0; i < defs.size(); i++ ) {
+            if ( defs[i].name == def.name )
+                return Status( ErrorCodes::DuplicateKey,
+                               str::stream() << "projection '" << def.name
+                                             << "' already exists for " << def.sourceNS );
+        }
+        defs.push_back( def );
+        _count.fetchAndAdd( 1 );
+        return Status::OK();
+    }
+
+    bool MaterializedProjections::remove( const StringData& sourceNS,
+                                          const StringData& name,
+                                          std::string* targetNS ) {
+        SimpleMutex::scoped_lock lk( _lock );
+        DefMap::iterator i = _defs.find( sourceNS.toString() );
+        if ( i == _defs.end() )
+            return false;
+        std::vector<Def>& defs = i->second;
+        for ( size_t j = 0; j < defs.size(); j++ ) {
+            if ( defs[j].name != name )
+                continue;
+            if ( targetNS )
+                *targetNS = defs[j].targetNS;
+            defs.erase( defs.begin() + j );
+            if ( defs.empty() )
+                _defs.erase( i );
+            _count.fetchAndSubtract( 1 );
+            return true;
+        }
+        return false;
+    }
+
+    void MaterializedProjections::collectionDropped( const StringData& ns ) {
+        if ( _count.loadRelaxed() == 0 )
+            return;
+
+        SimpleMutex::scoped_lock lk( _lock );
+
+        // source dropped: all its projections go
+        DefMap::iterator i = _defs.find( ns.toString() );
+        if ( i != _defs.end() ) {
+            _count.fetchAndSubtract( static_cast<unsigned>( i->second.size() ) );
+            _defs.erase( i );
+        }
+
+        // someone dropped a target directly: deactivate that definition
+        for ( i = _defs.begin(); i != _defs.end(); ) {
+            std::vector<Def>& defs = i->second;
+            for ( size_t j = 0; j < defs.size(); ) {
+                if ( defs[j].targetNS == ns ) {
+                    defs.erase( defs.begin() + j );
+                    _count.fetchAndSubtract( 1 );
+                }
+                else {
+                    j++;
+                }
+            }
+            if ( defs.empty() )
+                _defs.erase( i++ );
+            else
+                ++i;
+        }
+    }
+
+    bool MaterializedProjections::_lookup( const StringData& ns, std::vector<Def>* out ) const {
+        SimpleMutex::scoped_lock lk( _lock );
+        DefMap::const_iterator i = _defs.find( ns.toString() );
+        if ( i == _defs.end() )
+            return false;
+        *out = i->second;
+        return true;
+    }
+
+    void MaterializedProjections::_deactivate( const Def& def, const std::string& why ) {
+        warning() << "deactivating materialized projection " << def.targetNS
+                  << ": " << why << endl;
+        remove( def.sourceNS, def.name, NULL );
+    }
+
+    std::string MaterializedProjections::retargetNS( const CanonicalQuery& cq ) {
+        if ( _count.loadRelaxed() == 0 )
+            return "";
+
+        const LiteParsedQuery& pq = cq.getParsed();
+
+        if ( QueryPlannerCommon::hasNode( cq.root(), MatchExpression::WHERE ) ||
+             QueryPlannerCommon::hasNode( cq.root(), MatchExpression::TEXT ) ||
+             QueryPlannerCommon::hasNode( cq.root(), MatchExpression::GEO_NEAR ) )
+            return "";
+
+        unordered_set<std::string> filterFields;
+        QueryPlannerIXSelect::getFields( cq.root(), "", &filterFields );
+
+        SimpleMutex::scoped_lock lk( _lock );
+        DefMap::iterator i = _defs.find( pq.ns() );
+        if ( i == _defs.end() )
+            return "";
+        for ( size_t j = 0; j < i->second.size(); j++ ) {
+            Def& def = i->second[j];
+            if ( !canAnswer( def, pq, filterFields ) )
+                continue;
+            def.hits++;
+            return def.targetNS;
+        }
+        return "";
+    }
+
+    std::vector<std::string> MaterializedProjections::targetsFor( const StringData& sourceNS ) const {
+        std::vector<std::string> out;
+        if ( _count.loadRelaxed() == 0 )
+            return out;
+        SimpleMutex::scoped_lock lk( _lock );
+        DefMap::const_iterator i = _defs.find( sourceNS.toString() );
+        if ( i == _defs.end() )
+            return out;
+        for ( size_t j = 0; j < i->second.size(); j++ )
+            out.push_back( i->second[j].targetNS );
+        return out;
+    }
+
+    void MaterializedProjections::_applyToTarget( Database* db, const Def& def,
+                                                  const BSONObj& oldDoc,
+                                                  const BSONObj& newDoc ) {
+        const bool was = !oldDoc.isEmpty() && def.matcher->matchesBSON( oldDoc );
+        const bool is = !newDoc.isEmpty() && def.matcher->matchesBSON( newDoc );
+        if ( !was && !is )
+            return;
+
+        Collection* target = db->getCollection( def.targetNS );
+        if ( !target ) {
+            _deactivate( def, "target collection is missing" );
+            return;
+        }
+
+        BSONElement id = ( is ? newDoc : oldDoc )["_id"];
+        if ( id.eoo() )
+            return; // source doc has no _id; nothing to key the copy by
+
+        DiskLoc loc;
+        if ( was )
+            loc = Helpers::findById( target, id.wrap( "_id" ) );
+
+        if ( !is ) {
+            if ( !loc.isNull() )
+                target->deleteDocument( loc );
+            return;
+        }
+
+        BSONObj projected = project( def.fields, newDoc );
+        StatusWith<DiskLoc> res = loc.isNull() ?
+            target->insertDocument( projected, false ) :
+            target->updateDocument( loc, projected, false, NULL );
+        if ( !res.isOK() )
+            _deactivate( def, res.getStatus().toString() );
+    }
+
+    bool MaterializedProjections::hasProjections( const StringData& sourceNS ) const {
+        if ( _count.loadRelaxed() == 0 )
+            return false;
+        SimpleMutex::scoped_lock lk( _lock );
+        return _defs.find( sourceNS.toString() ) != _defs.end();
+    }
+
+    void MaterializedProjections::onInsert( Database* db, const StringData& ns,
+                                            const BSONObj& doc ) {
+        if ( _count.loadRelaxed() == 0 )
+            return;
+        std::vector<Def> defs;
+        if ( !_lookup( ns, &defs ) )
+            return;
+        for ( size_t i = 0; i < defs.size(); i++ )
+            _applyToTarget( db, defs[i], BSONObj(), doc );
+    }
+
+    void MaterializedProjections::onUpdate( Database* db, const StringData& ns,
+                                            const BSONObj& oldDoc, const BSONObj& newDoc ) {
+        if ( _count.loadRelaxed() == 0 )
+            return;
+        std::vector<Def> defs;
+        if ( !_lookup( ns, &defs ) )
+            return;
+        for ( size_t i = 0; i < defs.size(); i++ )
+            _applyToTarget( db, defs[i], oldDoc, newDoc );
+    }
+
+    void MaterializedProjections::onDelete( Database* db, const StringData& ns,
+                                            const BSONObj& doc ) {
+        if ( _count.loadRelaxed() == 0 )
+            return;
+        std::vector<Def> defs;
+        if ( !_lookup( ns, &defs ) )
+            return;
+        for ( size_t i = 0; i < defs.size(); i++ )
+            _applyToTarget( db, defs[i], doc, BSONObj() );
+    }
+
+    void MaterializedProjections::append( const StringData& dbname, BSONObjBuilder& b ) const {
+        SimpleMutex::scoped_lock lk( _lock );
+        BSONArrayBuilder arr( b.subarrayStart( "projections" ) );
+        const std::string prefix = dbname.toString() + '.';
+        for ( DefMap::const_iterator i = _defs.begin(); i != _defs.end(); ++i ) {
+            if ( i->first.compare( 0, prefix.size(), prefix ) != 0 )
+                continue;
+            for ( size_t j = 0; j < i->second.size(); j++ ) {
+                const Def& def = i->second[j];
+                BSONObjBuilder pb( arr.subobjStart() );
+                pb.append( "source", def.sourceNS );
+                pb.append( "target", def.targetNS );
+                pb.append( "name", def.name );
+                pb.append( "filter", def.filter );
+                BSONArrayBuilder fa( pb.subarrayStart( "fields" ) );
+                for ( std::set<std::string>::const_iterator f = def.fields.begin();
+                      f != def.fields.end(); ++f ) {
+                    fa.append( *f );
+                }
+                fa.done();
+                pb.appendNumber( "hits", def.hits );
+                pb.done();
+            }
+        }
+        arr.done();
+    }
+
+    MaterializedProjections MaterializedProjections::global;
+
+    // -------- commands --------
+
+    class CmdMaterializeProjection : public Command {
+    public:
+        CmdMaterializeProjection() : Command( "materializeProjection" ) {}
+
+        virtual bool logTheOp() { return false; } // per-node, like an index choice
+        virtual bool slaveOk() const { return false; }
+        virtual LockType locktype() const { return WRITE; }
+        virtual void help( stringstream& help ) const {
+            help << "create and maintain a filtered projection of a collection.\n"
+                    "{ materializeProjection: \"coll\", name: \"active\", "
+                    "filter: { status: \"active\" }, fields: [ \"a\", \"b\" ] }\n"
+                    "filter must be scalar equalities; _id and the filter fields are "
+                    "always stored.  The backfill scans the whole collection under "
+                    "the database write lock.  Definitions do not survive a restart: "
+                    "re-run this command (it rebuilds the projection).";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::reIndex);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool /*fromRepl*/) {
+
+            const string sourceNS = dbname + '.' + cmdObj.firstElement().valuestrsafe();
+            const string name = cmdObj["name"].valuestrsafe();
+
+            if ( name.empty() || name.find( '.' ) != string::npos ||
+                 name.find( '$' ) != string::npos ) {
+                errmsg = "need a projection name without '.' or '$'";
+                return false;
+            }
+            if ( sourceNS.find( ".proj." ) != string::npos ) {
+                errmsg = "cannot materialize a projection of a projection";
+                return false;
+            }
+
+            Status allowed = userAllowedWriteNS( sourceNS );
+            if ( !allowed.isOK() )
+                return appendCommandStatus( result, allowed );
+
+            Collection* source = cc().database()->getCollection( sourceNS );
+            if ( !source ) {
+                errmsg = "ns not found";
+                return false;
+            }
+            if ( source->isCapped() ) {
+                errmsg = "cannot materialize a projection of a capped collection";
+                return false;
+            }
+            if ( !source->getIndexCatalog()->findIdIndex() ) {
+                errmsg = "source collection must have an _id index";
+                return false;
+            }
+
+            MaterializedProjections::Def def;
+            def.sourceNS = sourceNS;
+            def.targetNS = sourceNS + ".proj." + name;
+            def.name = name;
+            def.hits = 0;
+
+            // the filter: a non-empty conjunction of scalar equalities, so
+            // retargeting only has to check the query repeats them verbatim
+            if ( cmdObj["filter"].type() != Object ) {
+                errmsg = "need a filter document";
+                return false;
+            }
+            def.filter = cmdObj["filter"].Obj().getOwned();
+            if ( def.filter.isEmpty() ) {
+                errmsg = "filter cannot be empty";
+                return false;
+            }
+            BSONObjIterator fi( def.filter );
+            while ( fi.more() ) {
+                BSONElement e = fi.next();
+                if ( e.fieldName()[0] == '$' || strstr( e.fieldName(), ".$" ) ) {
+                    errmsg = "filter must be plain field equalities";
+                    return false;
+                }
+                switch ( e.type() ) {
+                case Object: case Array: case RegEx: case jstNULL:
+                case Undefined: case EOO:
+                    errmsg = str::stream() << "filter value for '" << e.fieldName()
+                                           << "' must be a scalar";
+                    return false;
+                default:
+                    break;
+                }
+                def.fields.insert( str::before( e.fieldName(), '.' ) );
+            }
+
+            StatusWithMatchExpression parsed = MatchExpressionParser::parse( def.filter );
+            if ( !parsed.isOK() )
+                return appendCommandStatus( result, parsed.getStatus() );
+            def.matcher.reset( parsed.getValue() );
+
+            if ( cmdObj["fields"].type() != Array ) {
+                errmsg = "need a fields array of top-level field names";
+                return false;
+            }
+            BSONObjIterator fields( cmdObj["fields"].Obj() );
+            while ( fields.more() ) {
+                BSONElement e = fields.next();
+                if ( e.type() != String || e.str().empty() ||
+                     e.str().find( '.' ) != string::npos ||
+                     e.str().find( '$' ) != string::npos ) {
+                    errmsg = "fields must be top-level field names";
+                    return false;
+                }
+                def.fields.insert( e.str() );
+            }
+            def.fields.insert( "_id" );
+
+            // a projection collection from a previous incarnation of this
+            // definition (e.g. before a restart) is stale; rebuild it
+            if ( cc().database()->getCollection( def.targetNS ) ) {
+                Status s = cc().database()->dropCollection( def.targetNS );
+                if ( !s.isOK() )
+                    return appendCommandStatus( result, s );
+            }
+            Collection* target = cc().database()->createCollection( def.targetNS );
+            verify( target );
+
+            // backfill; we hold the database write lock throughout, so no
+            // writes can interleave before the definition goes live
+            long long docs = 0;
+            scoped_ptr<CollectionIterator> it( source->getIterator(
+                DiskLoc(), false, CollectionScanParams::FORWARD ) );
+            while ( !it->isEOF() ) {
+                DiskLoc loc = it->getNext();
+                BSONObj doc = source->docFor( loc );
+                if ( !def.matcher->matchesBSON( doc ) )
+                    continue;
+                StatusWith<DiskLoc> res = target->insertDocument(
+                    MaterializedProjections::project( def.fields, doc ), false );
+                if ( !res.isOK() ) {
+                    cc().database()->dropCollection( def.targetNS );
+                    return appendCommandStatus( result, res.getStatus() );
+                }
+                docs++;
+            }
+
+            Status s = MaterializedProjections::global.add( def );
+            if ( !s.isOK() ) {
+                cc().database()->dropCollection( def.targetNS );
+                return appendCommandStatus( result, s );
+            }
+
+            MONGO_TLOG(0) << "CMD: materializeProjection " << def.targetNS
+                          << " (" << docs << " documents)" << endl;
+
+            result.append( "target", def.targetNS );
+            result.appendNumber( "documents", docs );
+            return true;
+        }
+
+    } cmdMaterializeProjection;
+
+    class CmdDropProjection : public Command {
+    public:
+        CmdDropProjection() : Command( "dropProjection" ) {}
+
+        virtual bool logTheOp() { return false; }
+        virtual bool slaveOk() const { return false; }
+        virtual LockType locktype() const { return WRITE; }
+        virtual void help( stringstream& help ) const {
+            help << "drop a materialized projection and its collection.\n"
+                    "{ dropProjection: \"coll\", name: \"active\" }";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::reIndex);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool /*fromRepl*/) {
+
+            const string sourceNS = dbname + '.' + cmdObj.firstElement().valuestrsafe();
+            const string name = cmdObj["name"].valuestrsafe();
+
+            std::string targetNS;
+            if ( !MaterializedProjections::global.remove( sourceNS, name, &targetNS ) ) {
+                errmsg = "no such projection";
+                return false;
+            }
+
+            if ( cc().database()->getCollection( targetNS ) ) {
+                Status s = cc().database()->dropCollection( targetNS );
+                if ( !s.isOK() )
+                    return appendCommandStatus( result, s );
+            }
+            result.append( "target", targetNS );
+            return true;
+        }
+
+    } cmdDropProjection;
+
+    class CmdListProjections : public Command {
+    public:
+        CmdListProjections() : Command( "listProjections" ) {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream& help ) const {
+            help << "list this database's materialized projections and how often "
+                    "queries were retargeted to them";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::dbStats);
+            out->push_back(Privilege(ResourcePattern::forDatabaseName(dbname), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool /*fromRepl*/) {
+            MaterializedProjections::global.append( dbname, result );
+            return true;
+        }
+
+    } cmdListProjections;
+
+}  // namespace mongo
@@ -0,0 +1,155 @@
+// materialized_projection.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/base/status.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class CanonicalQuery;
+    class Database;
+    class MatchExpression;
+
+    /**
+     * Materialized filtered projections: server-maintained copies of the hot
+     * slice of a collection, created with the materializeProjection command.
+     * A projection of test.foo named "active" lives in the real collection
+     * test.foo.proj.active and holds, for every source document matching the
+     * definition's filter, just the definition's top-level fields (always
+     * including _id and the filter fields).
+     *
+     * The copy is maintained synchronously: Collection::insertDocument,
+     * updateDocument and deleteDocument call the on*() hooks below under the
+     * database write lock, so the projection is never behind its source.
+     * Queries whose shape a projection can answer exactly (see retargetNS)
+     * are silently run against the projection collection instead, trading a
+     * little write cost for reads that fetch and filter a fraction of the
+     * bytes.
+     *
+     * Definitions are in memory only; after a restart the projection
+     * collections persist as stale snapshots and the materializeProjection
+     * command rebuilds them.  A definition whose maintenance fails is
+     * deactivated with a warning rather than left serving wrong answers.
+     */
+    class MaterializedProjections {
+    public:
+        struct Def {
+            std::string sourceNS;
+            std::string targetNS;
+            std::string name;
+            BSONObj filter;                 // conjunction of scalar equalities
+            std::set<std::string> fields;   // top-level names; always has _id
+
+            // parsed form of 'filter'; shared so Def stays copyable
+            boost::shared_ptr<MatchExpression> matcher;
+
+            long long hits;                 // queries retargeted so far
+        };
+
+        MaterializedProjections() : _lock( "MaterializedProjections" ) {}
+
+        /**
+         * Registers a validated definition.  The caller (the command) has
+         * already built and backfilled the target collection under the write
+         * lock.  Fails if the source already has a projection of that name.
+         */
+        Status add( const Def& def );
+
+        /**
+         * Unregisters source's projection 'name'; returns false if there is
+         * no such projection.  Dropping the target collection is the
+         * caller's job.
+         */
+        bool remove( const StringData& sourceNS, const StringData& name, std::string* targetNS );
+
+        /** deactivates any definition whose source or target is ns */
+        void collectionDropped( const StringData& ns );
+
+        /**
+         * The target namespace to run this query against instead, or "" if no
+         * projection of cq's collection can answer it exactly.  A projection
+         * qualifies when the query repeats all the definition's equalities
+         * verbatim, every field the filter and sort touch is projected, and
+         * the query asks for an inclusion projection within the projected
+         * fields.
+         */
+        std::string retargetNS( const CanonicalQuery& cq );
+
+        /**
+         * Target namespaces of ns's projections.  getMore uses this to find
+         * a cursor that runQuery silently opened on a projection collection.
+         */
+        std::vector<std::string> targetsFor( const StringData& sourceNS ) const;
+
+        /** whether ns has any projections; cheap enough for hot write paths */
+        bool hasProjections( const StringData& sourceNS ) const;
+
+        /**
+         * Write-time maintenance, called by Collection under the database
+         * write lock.  Cheap no-ops while no projections exist anywhere.
+         */
+        void onInsert( Database* db, const StringData& ns, const BSONObj& doc );
+        void onUpdate( Database* db, const StringData& ns,
+                       const BSONObj& oldDoc, const BSONObj& newDoc );
+        void onDelete( Database* db, const StringData& ns, const BSONObj& doc );
+
+        /** definitions (and hit counts) for one database, for listProjections */
+        void append( const StringData& dbname, BSONObjBuilder& b ) const;
+
+        /** keeps doc's fields that are in 'fields', in document order */
+        static BSONObj project( const std::set<std::string>& fields, const BSONObj& doc );
+
+        static MaterializedProjections global;
+
+    private:
+        typedef std::map< std::string, std::vector<Def> > DefMap; // source ns -> defs
+
+        bool _lookup( const StringData& ns, std::vector<Def>* out ) const;
+        void _deactivate( const Def& def, const std::string& why );
+        void _applyToTarget( Database* db, const Def& def,
+                             const BSONObj& oldDoc, const BSONObj& newDoc );
+
+        mutable SimpleMutex _lock;
+        DefMap _defs;
+        AtomicUInt32 _count; // total definitions; write hooks bail when 0
+    };
+
+}  // namespace mongo
@@ -462,25 +462,12 @@ namespace mongo {
 
     } handshakeCmd;
 
-    int Client::recommendedYieldMicros( int * writers , int * readers, bool needExact ) {
-        int num = 0;
-        int w = 0;
-        int r = 0;
-        {
-            scoped_lock bl(clientsMutex);
-            for ( set<Client*>::iterator i=clients.begin(); i!=clients.end(); ++i ) {
-                Client* c = *i;
-                if ( c->lockState().hasLockPending() ) {
-                    num++;
-                    if ( c->lockState().hasAnyWriteLock() )
-                        w++;
-                    else
-                        r++;
-                }
-                if (num > 100 && !needExact)
-                    break;
-            }
-        }
+    int Client::recommendedYieldMicros( int * writers , int * readers ) {
+        // read the lock layer's queued-waiter counters instead of scanning
+        // every Client under clientsMutex - this runs at every potential
+        // yield point, and the scan was O(connections) with a mutex held
+        int w = pendingLockWriters();
+        int r = pendingLockReaders();
 
         if ( writers )
             *writers = w;
@@ -565,6 +552,7 @@ namespace mongo {
         fastmodinsert = false;
         upsert = false;
         keyUpdates = 0;  // unsigned, so -1 not possible
+        planningTimeMicros = 0;
         planSummary = "";
         
         exceptionInfo.reset();
@@ -633,7 +621,9 @@ namespace mongo {
         OPDEBUG_TOSTRING_HELP_BOOL( fastmodinsert );
         OPDEBUG_TOSTRING_HELP_BOOL( upsert );
         OPDEBUG_TOSTRING_HELP( keyUpdates );
-        
+        if ( planningTimeMicros > 0 )
+            s << " planningTimeMicros:" << planningTimeMicros;
+
         if ( extra.len() )
             s << " " << extra.str();
 
@@ -727,6 +717,8 @@ namespace mongo {
         OPDEBUG_APPEND_BOOL( fastmodinsert );
         OPDEBUG_APPEND_BOOL( upsert );
         OPDEBUG_APPEND_NUMBER( keyUpdates );
+        if ( planningTimeMicros > 0 )
+            b.appendNumber( "planningTimeMicros" , planningTimeMicros );
 
         b.appendNumber( "numYield" , curop.numYields() );
         b.append( "lockStats" , curop.lockStat().report() );
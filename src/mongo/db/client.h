@@ -73,8 +73,7 @@ namespace mongo {
         static int getActiveClientCount( int& writers , int& readers );
         class Context;
         ~Client();
-        static int recommendedYieldMicros( int * writers = 0 , int * readers = 0,
-                                           bool needExact = false );
+        static int recommendedYieldMicros( int * writers = 0 , int * readers = 0 );
         /** each thread which does db operations has a Client object in TLS.
          *  call this when your thread starts.
         */
@@ -53,6 +53,7 @@
 #include "mongo/platform/random.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/timer.h"
+#include "mongo/util/timer_wheel.h"
 
 namespace mongo {
 
@@ -308,7 +309,7 @@ namespace mongo {
     }
 
     //
-    // ClientCursorMonitor
+    // Client cursor monitoring
     //
 
     // Used by sayMemoryStatus below.
@@ -325,9 +326,9 @@ namespace mongo {
     };
 
     /**
-     * called once a minute from killcursors thread
+     * called once a minute from the timer wheel thread
      */
-    void sayMemoryStatus() { 
+    void sayMemoryStatus() {
         static time_t last;
         static Mem mlast;
         try {
@@ -364,23 +365,28 @@ namespace mongo {
         }
     }
 
-    void ClientCursorMonitor::run() {
-        Client::initThread("clientcursormon");
-        Client& client = cc();
-        Timer t;
-        const int Secs = 4;
-        unsigned n = 0;
-        while ( ! inShutdown() ) {
-            cursorStatsTimedOut.increment( CollectionCursorCache::timeoutCursorsGlobal( t.millisReset() ) );
-            sleepsecs(Secs);
-            if( ++n % (60/Secs) == 0 /*once a minute*/ ) {
-                sayMemoryStatus();
-            }
+    namespace {
+
+        // Measures the interval between sweeps; timeoutCursorsGlobal ages cursors by
+        // the elapsed time it is handed.
+        Timer cursorTimeoutClock;
+
+        void sweepTimedOutCursors() {
+            if ( inShutdown() )
+                return;
+            cursorStatsTimedOut.increment(
+                CollectionCursorCache::timeoutCursorsGlobal( cursorTimeoutClock.millisReset() ) );
         }
-        client.shutdown();
-    }
 
-    ClientCursorMonitor clientCursorMonitor;
+    } // namespace
+
+    void startClientCursorMonitor() {
+        TimerWheel* wheel = globalTimerWheel();
+        if ( !wheel )
+            return;
+        wheel->schedulePeriodic( "clientcursormon", sweepTimedOutCursors, 4 );
+        wheel->schedulePeriodic( "memstatus", sayMemoryStatus, 60 );
+    }
 
     //
     // cursorInfo command.
@@ -148,7 +148,6 @@ namespace mongo {
         static long long totalOpen();
 
     private:
-        friend class ClientCursorMonitor;
         friend class ClientCursorPin;
         friend class CmdCursorInfo;
 
@@ -231,11 +230,10 @@ namespace mongo {
         ClientCursor* _cursor;
     };
 
-    /** thread for timing out old cursors */
-    class ClientCursorMonitor : public BackgroundJob {
-    public:
-        string name() const { return "ClientCursorMonitor"; }
-        void run();
-    };
+    /**
+     * Registers the periodic jobs that time out old cursors and report process
+     * memory status; they run on the shared timer wheel thread.
+     */
+    void startClientCursorMonitor();
 
 } // namespace mongo
@@ -30,8 +30,11 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/base/init.h"
 #include "mongo/base/status.h"
+#include "mongo/bson/util/atomic_int.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/auth/action_set.h"
@@ -53,6 +56,7 @@
 #include "mongo/db/pdfile.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/util/queue.h"
 
 namespace mongo {
 
@@ -274,6 +278,294 @@ namespace mongo {
         }
     }
 
+    extern bool inDBRepair;
+
+    /* one unit of work handed from a clone reader thread to the thread that
+       owns the write lock.  to_ns is empty for the sentinel a reader pushes
+       when it exits. */
+    struct CloneBatch {
+        CloneBatch() : size(0), done(false) {}
+        string from_ns;
+        string to_ns;
+        vector<BSONObj> docs;
+        int size;           // total bytes of BSON in docs
+        bool done;          // last batch of this collection
+    };
+
+    size_t cloneBatchSize(CloneBatch* const& b) { return b->size; }
+
+    /* cap the bytes of fetched-but-not-yet-inserted documents.  must stay
+       comfortably above the per-batch flush threshold below or push() would
+       never unblock. */
+    const size_t maxQueuedCloneBytes = 64 * 1024 * 1024;
+    const int cloneBatchBytes = 4 * 1024 * 1024;
+
+    /* shared between the clone reader threads and the inserting thread */
+    struct ParallelCloneState {
+        ParallelCloneState() : queue( maxQueuedCloneBytes, cloneBatchSize ),
+                               failed(false), _errMutex("parallelClone") {}
+
+        void setError( const string& msg ) {
+            scoped_lock lk( _errMutex );
+            if ( _errmsg.empty() )
+                _errmsg = msg;
+            failed = true;
+        }
+
+        string getError() {
+            scoped_lock lk( _errMutex );
+            return _errmsg;
+        }
+
+        string masterHost;
+        bool slaveOk;
+        bool snapshot;
+        vector< pair<string,string> > collections;   // from_ns -> to_ns
+
+        BlockingQueue<CloneBatch*> queue;
+        AtomicUInt nextCollection;
+        volatile bool failed;
+
+    private:
+        mongo::mutex _errMutex;
+        string _errmsg;
+    };
+
+    /* the per-batch half of parallelCloneReadCollection, below.  holds pointers
+       into that function's locals; the copies boost::function makes share them. */
+    struct ParallelCloneBatchHandler {
+        void operator()( DBClientCursorBatchIterator& i ) {
+            while ( i.moreInCurrentBatch() ) {
+                /* bailing out mid-stream poisons an exhaust connection, but on
+                   failure the reader thread discards it anyway */
+                uassert( 17566, "parallel clone aborted", !state->failed );
+
+                BSONObj tmp = i.nextSafe();
+
+                /* assure object is valid.  doing this here keeps the check off
+                   the thread that holds the write lock. */
+                const Status status = validateBSON(tmp.objdata(), tmp.objsize());
+                if (!status.isOK()) {
+                    out() << "Cloner: skipping corrupt object from " << from_ns
+                          << ": " << status.reason();
+                    continue;
+                }
+
+                CloneBatch* b = batch->get();
+                b->size += tmp.objsize();
+                b->docs.push_back( tmp.getOwned() );
+                if ( b->size >= cloneBatchBytes ) {
+                    state->queue.push( batch->release() );
+                    batch->reset( new CloneBatch() );
+                    (*batch)->from_ns = from_ns;
+                    (*batch)->to_ns = to_ns;
+                }
+            }
+        }
+
+        string from_ns;
+        string to_ns;
+        ParallelCloneState* state;
+        auto_ptr<CloneBatch>* batch; // owned by parallelCloneReadCollection
+    };
+
+    void parallelCloneReadCollection( DBClientBase* conn, const string& from_ns,
+                                      const string& to_ns, ParallelCloneState* state ) {
+        Query q;
+        if ( state->snapshot )
+            q.snapshot();
+        int options = QueryOption_NoCursorTimeout |
+                      ( state->slaveOk ? QueryOption_SlaveOk : 0 );
+
+        auto_ptr<CloneBatch> batch( new CloneBatch() );
+        batch->from_ns = from_ns;
+        batch->to_ns = to_ns;
+
+        ParallelCloneBatchHandler handler;
+        handler.from_ns = from_ns;
+        handler.to_ns = to_ns;
+        handler.state = state;
+        handler.batch = &batch;
+
+        /* runs as an exhaust stream when the connection supports it (it does for
+           a direct mongod source): the server sends batch after batch with no
+           getMore round trips.  flow control comes for free - when the shared
+           queue fills up, push() blocks this thread, we stop reading the socket,
+           and TCP backpressure paces the sender. */
+        conn->query( boost::function<void(DBClientCursorBatchIterator &)>( handler ),
+                     from_ns, q, 0, options );
+
+        batch->done = true;
+        state->queue.push( batch.release() );
+    }
+
+    /* body of one clone reader thread: opens its own connection to the source
+       and streams collections into the shared queue until none are left */
+    void parallelCloneReader( ParallelCloneState* state ) {
+        Client::initThread( "cloneReader" );
+        try {
+            string errmsg;
+            ConnectionString cs = ConnectionString::parse( state->masterHost, errmsg );
+            auto_ptr<DBClientBase> conn( cs.connect( errmsg ) );
+            uassert( 17445, str::stream() << "clone reader couldn't connect to "
+                                          << state->masterHost << ": " << errmsg,
+                     conn.get() && replAuthenticate( conn.get() ) );
+
+            while ( !state->failed ) {
+                unsigned i = state->nextCollection++;
+                if ( i >= state->collections.size() )
+                    break;
+                parallelCloneReadCollection( conn.get(),
+                                             state->collections[i].first,
+                                             state->collections[i].second,
+                                             state );
+            }
+        }
+        catch ( const DBException& e ) {
+            state->setError( e.toString() );
+        }
+        catch ( const std::exception& e ) {
+            state->setError( e.what() );
+        }
+
+        /* wake the inserting thread even on failure; an empty to_ns marks the
+           exit of one reader */
+        state->queue.push( new CloneBatch() );
+        cc().shutdown();
+    }
+
+    bool Cloner::parallelClone(Client::Context& context, const string& masterHost,
+                               const CloneOptions& opts, const string& todb,
+                               const list<BSONObj>& toClone, string& errmsg) {
+
+        ParallelCloneState state;
+        state.masterHost = masterHost;
+        state.slaveOk = opts.slaveOk;
+        state.snapshot = opts.snapshot;
+
+        /* create the target collections up front while we hold the write lock,
+           so the insert loop below never has to apply creation options */
+        for ( list<BSONObj>::const_iterator i=toClone.begin(); i != toClone.end(); i++ ) {
+            BSONObj collection = *i;
+            LOG(2) << "  really will clone: " << collection << endl;
+            const char * from_name = collection["name"].valuestr();
+            BSONObj options = collection.getObjectField("options");
+
+            /* change name "<fromdb>.collection" -> <todb>.collection */
+            const char *p = strchr(from_name, '.');
+            verify(p);
+            string to_name = todb + p;
+
+            {
+                string err;
+                /* we defer building id index for performance - building it in batch is much faster */
+                userCreateNS(to_name.c_str(), options, err, opts.logForRepl, false);
+            }
+            LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
+
+            state.collections.push_back( make_pair( string( from_name ), to_name ) );
+        }
+
+        int numReaders = opts.numParallelCollections;
+        if ( numReaders > (int)state.collections.size() )
+            numReaders = state.collections.size();
+
+        log() << "cloning " << state.collections.size() << " collections from "
+              << masterHost << " with " << numReaders << " reader threads" << endl;
+
+        vector< boost::shared_ptr<boost::thread> > readers;
+        for ( int i = 0; i < numReaders; i++ ) {
+            readers.push_back( boost::shared_ptr<boost::thread>(
+                    new boost::thread( boost::bind( parallelCloneReader, &state ) ) ) );
+        }
+
+        int64_t numSeen = 0;
+        time_t saveLast = time( 0 );
+        int readersRunning = numReaders;
+        try {
+            mayInterrupt( opts.mayBeInterrupted );
+            dbtempreleaseif r( opts.mayYield );
+
+            while ( readersRunning ) {
+                auto_ptr<CloneBatch> batch( state.queue.blockingPop() );
+                if ( batch->to_ns.empty() ) {
+                    readersRunning--;
+                    continue;
+                }
+                if ( state.failed )
+                    continue; // just drain so the readers can exit
+
+                mayInterrupt( opts.mayBeInterrupted );
+
+                Lock::GlobalWrite lk;
+                context.relocked();
+
+                Collection* collection = context.db()->getCollection( batch->to_ns );
+                if ( !collection ) {
+                    collection = context.db()->createCollection( batch->to_ns.c_str() );
+                    verify( collection );
+                }
+
+                for (vector<BSONObj>::const_iterator j = batch->docs.begin();
+                     j != batch->docs.end();
+                     ++j) {
+
+                    StatusWith<DiskLoc> loc = collection->insertDocument( *j, true );
+                    if ( !loc.isOK() ) {
+                        error() << "error: exception cloning object in " << batch->from_ns
+                                << ' ' << loc.toString() << " obj:" << *j;
+                    }
+                    uassertStatusOK( loc.getStatus() );
+                    if ( opts.logForRepl )
+                        logOp("i", batch->to_ns.c_str(), *j);
+                    ++numSeen;
+                }
+
+                getDur().commitIfNeeded();
+
+                if ( batch->done ) {
+                    /* we need dropDups to be true as we didn't do a true snapshot and this is before
+                       applying oplog operations that occur during the initial sync.  inDBRepair
+                       makes dropDups be true. */
+                    bool old = inDBRepair;
+                    try {
+                        inDBRepair = true;
+                        collection->getIndexCatalog()->ensureHaveIdIndex();
+                        inDBRepair = old;
+                    }
+                    catch(...) {
+                        inDBRepair = old;
+                        throw;
+                    }
+                }
+
+                RARELY if ( time( 0 ) - saveLast > 60 ) {
+                    log() << numSeen << " objects cloned so far by parallel clone";
+                    saveLast = time( 0 );
+                }
+            }
+        }
+        catch ( const DBException& e ) {
+            /* keep draining until every reader has exited, otherwise a reader
+               blocked in push() would be stuck forever */
+            state.setError( e.toString() );
+            while ( readersRunning ) {
+                auto_ptr<CloneBatch> batch( state.queue.blockingPop() );
+                if ( batch->to_ns.empty() )
+                    readersRunning--;
+            }
+        }
+
+        for ( size_t i = 0; i < readers.size(); i++ )
+            readers[i]->join();
+
+        if ( state.failed ) {
+            errmsg = state.getError();
+            return false;
+        }
+        return true;
+    }
+
     bool Cloner::validateQueryResults(const auto_ptr<DBClientCursor>& cur,
                                       int32_t* errCode,
                                       string& errmsg) {
@@ -336,8 +628,6 @@ namespace mongo {
         return true;
     }
 
-    extern bool inDBRepair;
-
     bool Cloner::go(Client::Context& context,
                     const string& masterHost, const CloneOptions& opts, set<string>* clonedColls,
                     string& errmsg, int* errCode) {
@@ -447,49 +737,57 @@ namespace mongo {
             }
         }
 
-        for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
-            {
-                mayInterrupt( opts.mayBeInterrupted );
-                dbtempreleaseif r( opts.mayYield );
-            }
-            BSONObj collection = *i;
-            LOG(2) << "  really will clone: " << collection << endl;
-            const char * from_name = collection["name"].valuestr();
-            BSONObj options = collection.getObjectField("options");
-
-            /* change name "<fromdb>.collection" -> <todb>.collection */
-            const char *p = strchr(from_name, '.');
-            verify(p);
-            string to_name = todb + p;
+        if ( opts.numParallelCollections > 1 && toClone.size() > 1 && !masterSameProcess ) {
+            /* reader threads need their own connections, so the source must be
+               a remote host */
+            if ( !parallelClone( context, masterHost, opts, todb, toClone, errmsg ) )
+                return false;
+        }
+        else {
+            for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
+                {
+                    mayInterrupt( opts.mayBeInterrupted );
+                    dbtempreleaseif r( opts.mayYield );
+                }
+                BSONObj collection = *i;
+                LOG(2) << "  really will clone: " << collection << endl;
+                const char * from_name = collection["name"].valuestr();
+                BSONObj options = collection.getObjectField("options");
 
-            {
-                string err;
-                const char *toname = to_name.c_str();
-                /* we defer building id index for performance - building it in batch is much faster */
-                userCreateNS(toname, options, err, opts.logForRepl, false);
-            }
-            LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
-            Query q;
-            if( opts.snapshot )
-                q.snapshot();
-            copy(context,from_name, to_name.c_str(), false, opts.logForRepl, masterSameProcess,
-                 opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, q);
+                /* change name "<fromdb>.collection" -> <todb>.collection */
+                const char *p = strchr(from_name, '.');
+                verify(p);
+                string to_name = todb + p;
 
-            {
-                /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
-                   that occur during the initial sync.  inDBRepair makes dropDups be true.
-                   */
-                bool old = inDBRepair;
-                try {
-                    inDBRepair = true;
-                    Collection* c = cc().database()->getCollection( to_name );
-                    if ( c )
-                        c->getIndexCatalog()->ensureHaveIdIndex();
-                    inDBRepair = old;
+                {
+                    string err;
+                    const char *toname = to_name.c_str();
+                    /* we defer building id index for performance - building it in batch is much faster */
+                    userCreateNS(toname, options, err, opts.logForRepl, false);
                 }
-                catch(...) {
-                    inDBRepair = old;
-                    throw;
+                LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
+                Query q;
+                if( opts.snapshot )
+                    q.snapshot();
+                copy(context,from_name, to_name.c_str(), false, opts.logForRepl, masterSameProcess,
+                     opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, q);
+
+                {
+                    /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
+                       that occur during the initial sync.  inDBRepair makes dropDups be true.
+                       */
+                    bool old = inDBRepair;
+                    try {
+                        inDBRepair = true;
+                        Collection* c = cc().database()->getCollection( to_name );
+                        if ( c )
+                            c->getIndexCatalog()->ensureHaveIdIndex();
+                        inDBRepair = old;
+                    }
+                    catch(...) {
+                        inDBRepair = old;
+                        throw;
+                    }
                 }
             }
         }
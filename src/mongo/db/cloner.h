@@ -93,6 +93,17 @@ namespace mongo {
                   bool masterSameProcess, bool slaveOk, bool mayYield, bool mayBeInterrupted,
                   Query q);
 
+        /**
+         * clone the data of several collections at once: reader threads stream
+         * the source collections over their own connections into a bounded
+         * queue while this thread inserts the batches under the write lock.
+         * used when CloneOptions::numParallelCollections > 1 and the source is
+         * a remote host.  @see parallelCloneReader
+         */
+        bool parallelClone(Client::Context& context, const string& masterHost,
+                           const CloneOptions& opts, const string& todb,
+                           const list<BSONObj>& toClone, string& errmsg);
+
         struct Fun;
         auto_ptr<DBClientBase> _conn;
     };
@@ -109,6 +120,8 @@ namespace mongo {
 
             syncData = true;
             syncIndexes = true;
+
+            numParallelCollections = 1;
         }
 
         string fromDB;
@@ -123,6 +136,12 @@ namespace mongo {
 
         bool syncData;
         bool syncIndexes;
+
+        /* clone up to this many collections concurrently, each over its own
+           connection to the source.  1 (the default) preserves the old
+           one-collection-at-a-time behavior; >1 only takes effect when the
+           source is a remote host. */
+        int numParallelCollections;
     };
 
 } // namespace mongo
@@ -0,0 +1,93 @@
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjiterator.h"
+
+namespace mongo {
+
+    /**
+     * Declarative list of the fields a command (or other hot BSON parser)
+     * consumes, built once at startup.  bind() then walks an incoming object
+     * exactly once and drops each recognized field's BSONElement into a
+     * caller-provided slot array, replacing one BSONObj::getField linear scan
+     * per field with a single pass over the document.
+     *
+     * Typical use is a file-static struct next to the command that owns the
+     * schema and the slot indices add() returned; run() binds into a stack
+     * array and reads the slots.  Unrecognized fields are simply skipped, so
+     * commands keep their existing behavior for extra fields.
+     */
+    class CommandArgSchema {
+    public:
+        /** Registers "fieldName" and returns the slot bind() will fill for it. */
+        int add(const std::string& fieldName) {
+            _fields.push_back(fieldName);
+            return _fields.size() - 1;
+        }
+
+        int nSlots() const { return _fields.size(); }
+
+        /**
+         * Fills slots[i] with the element whose field name was registered in
+         * slot i, or a default (eoo) element if the field is absent.  As with
+         * getField, the first occurrence of a repeated field wins.  "slots"
+         * must have room for nSlots() elements.
+         *
+         * Returns the total number of fields in obj, recognized or not, so
+         * callers that also need nFields() don't pay another pass.
+         */
+        int bind(const BSONObj& obj, BSONElement* slots) const {
+            for (size_t i = 0; i < _fields.size(); i++) {
+                slots[i] = BSONElement();
+            }
+            int nFields = 0;
+            BSONObjIterator it(obj);
+            while (it.more()) {
+                BSONElement e = it.next();
+                nFields++;
+                for (size_t i = 0; i < _fields.size(); i++) {
+                    if (slots[i].eoo() && _fields[i] == e.fieldName()) {
+                        slots[i] = e;
+                        break;
+                    }
+                }
+            }
+            return nFields;
+        }
+
+    private:
+        std::vector<std::string> _fields;
+    };
+
+}  // namespace mongo
@@ -25,6 +25,7 @@
 #include "mongo/db/auth/resource_pattern.h"
 #include "mongo/db/client_basic.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/util/buffer_pool.h"
 
 namespace mongo {
 
@@ -255,6 +256,6 @@ namespace mutablebson {
                                           bool fromRepl);
     };
 
-    bool _runCommands(const char *ns, BSONObj& jsobj, BufBuilder &b, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions);
+    bool _runCommands(const char *ns, BSONObj& jsobj, PooledBufBuilder &b, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions);
 
 } // namespace mongo
@@ -0,0 +1,254 @@
+// bulk_load.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include <map>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/background.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/ops/insert.h"
+#include "mongo/db/storage/extent.h"
+#include "mongo/util/log.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Bulk load mode for initial imports:
+     *
+     *   { beginLoad: "coll", sizeMB: <optional preallocation> }
+     *   ... ordinary inserts ...
+     *   { commitLoad: "coll" }
+     *
+     * beginLoad saves the collection's secondary index definitions and drops
+     * the indexes (the _id index stays), so every insert until commitLoad
+     * pays only the append and the _id key - no secondary key generation or
+     * btree maintenance per document.  commitLoad rebuilds the saved indexes
+     * with the bulk builder (external sort plus sequential btree
+     * construction), which also verifies unique constraints over the whole
+     * data set at once.
+     *
+     * Neither command is replicated: the inserts in between replicate
+     * normally, so secondaries just index per document as usual.  If the
+     * server goes down between begin and commit, the collection is left with
+     * only its _id index and the client must re-create the others (the same
+     * state mongorestore --noIndexRestore leaves behind).
+     */
+    namespace {
+        SimpleMutex loadsLock( "bulkLoads" );
+
+        // ns -> secondary index specs to rebuild at commitLoad
+        std::map< std::string, std::vector<BSONObj> > activeLoads;
+    }
+
+    class CmdBeginLoad : public Command {
+    public:
+        CmdBeginLoad() : Command( "beginLoad" ) {}
+
+        virtual bool logTheOp() { return false; } // bulk load is per-node
+        virtual bool slaveOk() const { return false; }
+        virtual LockType locktype() const { return WRITE; }
+        virtual void help( stringstream& help ) const {
+            help << "start bulk loading a collection: defer its secondary indexes until "
+                    "commitLoad and optionally preallocate extents.\n"
+                    "{ beginLoad: \"coll\", sizeMB: <num> }";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::reIndex);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool /*fromRepl*/) {
+
+            const string ns = dbname + '.' + cmdObj.firstElement().valuestrsafe();
+
+            Status allowed = userAllowedWriteNS( ns );
+            if ( !allowed.isOK() )
+                return appendCommandStatus( result, allowed );
+
+            Collection* collection = cc().database()->getCollection( ns );
+            result.appendBool( "createdCollectionAutomatically", collection == NULL );
+            if ( !collection ) {
+                collection = cc().database()->createCollection( ns );
+                verify( collection );
+            }
+
+            if ( collection->isCapped() ) {
+                errmsg = "cannot bulk load a capped collection";
+                return false;
+            }
+
+            BackgroundOperation::assertNoBgOpInProgForNs( ns );
+
+            {
+                SimpleMutex::scoped_lock lk( loadsLock );
+                if ( activeLoads.count( ns ) ) {
+                    errmsg = "bulk load already in progress for this collection";
+                    return false;
+                }
+            }
+
+            // save the secondary index definitions, then drop the indexes;
+            // inserts until commitLoad maintain only the _id index
+            std::vector<BSONObj> specs;
+            IndexCatalog::IndexIterator it =
+                collection->getIndexCatalog()->getIndexIterator( false );
+            while ( it.more() ) {
+                IndexDescriptor* desc = it.next();
+                if ( desc->isIdIndex() )
+                    continue;
+                specs.push_back( desc->infoObj().getOwned() );
+            }
+
+            if ( !specs.empty() ) {
+                Status s = collection->getIndexCatalog()->dropAllIndexes( false );
+                if ( !s.isOK() )
+                    return appendCommandStatus( result, s );
+            }
+
+            // optional extent preallocation so the load never stalls on
+            // file allocation mid-stream
+            long long preallocated = 0;
+            if ( cmdObj["sizeMB"].isNumber() ) {
+                long long want = cmdObj["sizeMB"].numberLong() * 1024 * 1024;
+                while ( preallocated < want ) {
+                    long long left = want - preallocated;
+                    int chunk = left > Extent::maxSize() ?
+                        Extent::maxSize() : static_cast<int>( left );
+                    Extent* e = collection->increaseStorageSize( chunk, true );
+                    if ( !e )
+                        break;
+                    preallocated += e->length;
+                }
+            }
+
+            {
+                SimpleMutex::scoped_lock lk( loadsLock );
+                activeLoads[ns] = specs;
+            }
+
+            MONGO_TLOG(0) << "CMD: beginLoad " << ns << " deferring "
+                          << specs.size() << " index(es)" << endl;
+
+            result.appendNumber( "indexesDeferred", static_cast<long long>( specs.size() ) );
+            if ( preallocated )
+                result.appendNumber( "preallocatedBytes", preallocated );
+            return true;
+        }
+
+    } cmdBeginLoad;
+
+    class CmdCommitLoad : public Command {
+    public:
+        CmdCommitLoad() : Command( "commitLoad" ) {}
+
+        virtual bool logTheOp() { return false; }
+        virtual bool slaveOk() const { return false; }
+        virtual LockType locktype() const { return WRITE; }
+        virtual void help( stringstream& help ) const {
+            help << "finish a bulk load started with beginLoad: bulk-build the deferred "
+                    "secondary indexes, verifying unique constraints.\n"
+                    "{ commitLoad: \"coll\" }";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::reIndex);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool /*fromRepl*/) {
+
+            const string ns = dbname + '.' + cmdObj.firstElement().valuestrsafe();
+
+            std::vector<BSONObj> specs;
+            {
+                SimpleMutex::scoped_lock lk( loadsLock );
+                std::map< std::string, std::vector<BSONObj> >::iterator i =
+                    activeLoads.find( ns );
+                if ( i == activeLoads.end() ) {
+                    errmsg = "no bulk load in progress for this collection";
+                    return false;
+                }
+                specs = i->second;
+            }
+
+            Collection* collection = cc().database()->getCollection( ns );
+            if ( !collection ) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            MONGO_TLOG(0) << "CMD: commitLoad " << ns << " building "
+                          << specs.size() << " index(es)" << endl;
+
+            long long built = 0;
+            for ( size_t i = 0; i < specs.size(); i++ ) {
+                Status s = collection->getIndexCatalog()->createIndex( specs[i], true );
+                if ( s.code() == ErrorCodes::IndexAlreadyExists )
+                    s = Status::OK();
+                if ( !s.isOK() ) {
+                    // leave the unbuilt specs registered so commitLoad can be
+                    // retried once the offending data is fixed
+                    SimpleMutex::scoped_lock lk( loadsLock );
+                    activeLoads[ns] = std::vector<BSONObj>( specs.begin() + i, specs.end() );
+                    result.append( "failedIndex", specs[i] );
+                    result.appendNumber( "indexesBuilt", built );
+                    return appendCommandStatus( result, s );
+                }
+                built++;
+            }
+
+            {
+                SimpleMutex::scoped_lock lk( loadsLock );
+                activeLoads.erase( ns );
+            }
+
+            result.appendNumber( "indexesBuilt", built );
+            return true;
+        }
+
+    } cmdCommitLoad;
+
+}  // namespace mongo
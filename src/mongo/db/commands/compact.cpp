@@ -35,6 +35,7 @@
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/background.h"
+#include "mongo/db/background_compaction.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/d_concurrency.h"
@@ -69,7 +70,8 @@ namespace mongo {
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
                 "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
                 "  force - allows to run on a replica set primary\n"
-                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
+                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n"
+                "  background - compact incrementally in small locked slices, throttled by load. safe on a primary; returns immediately\n";
         }
         CompactCmd() : Command("compact") { }
 
@@ -90,7 +92,9 @@ namespace mongo {
                 return false;
             }
 
-            if( isCurrentlyAReplSetPrimary() && !cmdObj["force"].trueValue() ) {
+            const bool background = cmdObj["background"].trueValue();
+
+            if( isCurrentlyAReplSetPrimary() && !background && !cmdObj["force"].trueValue() ) {
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
             }
@@ -108,6 +112,16 @@ namespace mongo {
                 return false;
             }
 
+            if ( background ) {
+                if ( cmdObj.hasElement( "preservePadding" ) ||
+                     cmdObj.hasElement( "paddingFactor" ) ||
+                     cmdObj.hasElement( "paddingBytes" ) ) {
+                    errmsg = "cannot mix background and padding options; "
+                        "background compaction uses the collection's normal allocation";
+                    return false;
+                }
+            }
+
             CompactOptions compactOptions;
 
             if ( cmdObj["preservePadding"].trueValue() ) {
@@ -157,6 +171,13 @@ namespace mongo {
                 return false;
             }
 
+            if ( background ) {
+                if ( !BackgroundCompaction::start( ns.ns(), &errmsg ) )
+                    return false;
+                result.append( "info", "background compaction started" );
+                return true;
+            }
+
             log() << "compact " << ns << " begin, options: " << compactOptions.toString();
 
             std::vector<BSONObj> indexesInProg = stopIndexBuilds(db, cmdObj);
@@ -30,9 +30,14 @@
 
 #include "mongo/db/commands/dbhash.h"
 
+#include <cstdio>
+#include <cstring>
+
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/util/md5.hpp"
 #include "mongo/util/timer.h"
@@ -48,13 +53,40 @@ namespace mongo {
                          BSONObj* patt,
                          const BSONObj* fullObj,
                          bool forMigrateCleanup ) {
+        if ( *opstr == 'c' ) {
+            // a command (drop, rename, ...) can rewrite collections without going
+            // through the Collection write path, so be conservative and forget
+            // every digest in its database
+            dbhashCmd.invalidateDigestsForDatabase( nsToDatabaseSubstring( ns ) );
+        }
         dbhashCmd.wipeCacheForCollection( ns );
     }
 
+    void dbHashNoteInsert( const StringData& ns, const BSONObj& doc ) {
+        dbhashCmd.noteInsert( ns, doc );
+    }
+
+    void dbHashNoteUpdate( const StringData& ns, const BSONObj& oldDoc, const BSONObj& newDoc ) {
+        dbhashCmd.noteUpdate( ns, oldDoc, newDoc );
+    }
+
+    void dbHashNoteDelete( const StringData& ns, const BSONObj& doc ) {
+        dbhashCmd.noteDelete( ns, doc );
+    }
+
+    void dbHashNoteDigestInvalid( const StringData& ns ) {
+        dbhashCmd.invalidateDigest( ns );
+    }
+
+    bool dbHashHasDigests() {
+        return dbhashCmd.hasDigests();
+    }
+
     // ----
 
     DBHashCmd::DBHashCmd()
         : Command( "dbHash", false, "dbhash" ),
+          _digestsMutex( "_digestsMutex" ),
           _cachedHashedMutex( "_cachedHashedMutex" ){
     }
 
@@ -129,9 +161,118 @@ namespace mongo {
         return hash;
     }
 
+    unsigned long long DBHashCmd::hashDoc( const BSONObj& doc ) {
+        md5digest d;
+        md5( doc.objdata(), doc.objsize(), d );
+        unsigned long long h = 0;
+        memcpy( &h, d, sizeof( h ) );
+        return h;
+    }
+
+    string DBHashCmd::digestToHashString( unsigned long long digest ) {
+        char buf[17];
+        snprintf( buf, sizeof( buf ), "%016llx", digest );
+        return buf;
+    }
+
+    string DBHashCmd::hashCollectionIncremental( const string& fullCollectionName,
+                                                 bool* fromCache ) {
+        {
+            scoped_lock lk( _digestsMutex );
+            DigestMap::const_iterator it = _digests.find( fullCollectionName );
+            if ( it != _digests.end() ) {
+                *fromCache = true;
+                return digestToHashString( it->second );
+            }
+        }
+
+        *fromCache = false;
+
+        Collection* collection = cc().database()->getCollection( fullCollectionName );
+        if ( !collection )
+            return "";
+
+        // capped collections age documents out inside the record store, where the
+        // write hooks can't see it, so they always get the full scan
+        if ( collection->isCapped() )
+            return hashCollection( fullCollectionName, fromCache );
+
+        // seed the running digest with one full scan; we hold the db read lock, so
+        // the documents can't change underneath us. the scan can be in any order,
+        // the digest doesn't depend on it.
+        auto_ptr<Runner> runner( InternalPlanner::collectionScan( fullCollectionName ) );
+
+        unsigned long long digest = 0;
+        Runner::RunnerState state;
+        BSONObj c;
+        while (Runner::RUNNER_ADVANCED == (state = runner->getNext(&c, NULL))) {
+            digest += hashDoc( c );
+        }
+        if (Runner::RUNNER_EOF != state) {
+            warning() << "error while hashing, db dropped? ns=" << fullCollectionName << endl;
+            return "";
+        }
+
+        scoped_lock lk( _digestsMutex );
+        _digests[fullCollectionName] = digest;
+        _numDigests.store( static_cast<int>( _digests.size() ) );
+        return digestToHashString( digest );
+    }
+
+    void DBHashCmd::noteInsert( const StringData& ns, const BSONObj& doc ) {
+        if ( _numDigests.load() == 0 )
+            return;
+        scoped_lock lk( _digestsMutex );
+        DigestMap::iterator it = _digests.find( ns.toString() );
+        if ( it != _digests.end() )
+            it->second += hashDoc( doc );
+    }
+
+    void DBHashCmd::noteUpdate( const StringData& ns, const BSONObj& oldDoc, const BSONObj& newDoc ) {
+        if ( _numDigests.load() == 0 )
+            return;
+        scoped_lock lk( _digestsMutex );
+        DigestMap::iterator it = _digests.find( ns.toString() );
+        if ( it != _digests.end() )
+            it->second += hashDoc( newDoc ) - hashDoc( oldDoc );
+    }
+
+    void DBHashCmd::noteDelete( const StringData& ns, const BSONObj& doc ) {
+        if ( _numDigests.load() == 0 )
+            return;
+        scoped_lock lk( _digestsMutex );
+        DigestMap::iterator it = _digests.find( ns.toString() );
+        if ( it != _digests.end() )
+            it->second -= hashDoc( doc );
+    }
+
+    void DBHashCmd::invalidateDigest( const StringData& ns ) {
+        if ( _numDigests.load() == 0 )
+            return;
+        scoped_lock lk( _digestsMutex );
+        _digests.erase( ns.toString() );
+        _numDigests.store( static_cast<int>( _digests.size() ) );
+    }
+
+    void DBHashCmd::invalidateDigestsForDatabase( const StringData& dbName ) {
+        if ( _numDigests.load() == 0 )
+            return;
+        const string prefix = dbName.toString() + ".";
+        scoped_lock lk( _digestsMutex );
+        DigestMap::iterator it = _digests.lower_bound( prefix );
+        while ( it != _digests.end() && it->first.compare( 0, prefix.size(), prefix ) == 0 ) {
+            _digests.erase( it++ );
+        }
+        _numDigests.store( static_cast<int>( _digests.size() ) );
+    }
+
     bool DBHashCmd::run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
         Timer timer;
 
+        // with fullScan every collection is re-hashed with a scan instead of being
+        // served from its running digest; use it to verify the digests themselves
+        const bool fullScan = cmdObj["fullScan"].trueValue();
+
         set<string> desiredCollections;
         if ( cmdObj["collections"].type() == Array ) {
             BSONObjIterator i( cmdObj["collections"].Obj() );
@@ -176,7 +317,9 @@ namespace mongo {
                 continue;
 
             bool fromCache = false;
-            string hash = hashCollection( fullCollectionName, &fromCache );
+            string hash = fullScan ?
+                hashCollection( fullCollectionName, &fromCache ) :
+                hashCollectionIncremental( fullCollectionName, &fromCache );
 
             bb.append( shortCollectionName, hash );
 
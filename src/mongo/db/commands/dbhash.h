@@ -31,6 +31,7 @@
 #pragma once
 
 #include "mongo/db/commands.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
@@ -41,6 +42,20 @@ namespace mongo {
                          const BSONObj* fullObj,
                          bool forMigrateCleanup );
 
+    /**
+     * write-path hooks called by Collection with the affected document(s) so the
+     * incremental dbHash digests stay current; cheap no-ops until a dbHash run
+     * has seeded a digest for the collection
+     */
+    void dbHashNoteInsert( const StringData& ns, const BSONObj& doc );
+    void dbHashNoteUpdate( const StringData& ns, const BSONObj& oldDoc, const BSONObj& newDoc );
+    void dbHashNoteDelete( const StringData& ns, const BSONObj& doc );
+    /** forget a collection's digest, for writes the hooks above can't describe */
+    void dbHashNoteDigestInvalid( const StringData& ns );
+    /** whether any collection has a seeded digest, so hot write paths can skip
+        pre-image work that only feeds the hooks above */
+    bool dbHashHasDigests();
+
     class DBHashCmd : public Command {
     public:
         DBHashCmd();
@@ -55,12 +70,43 @@ namespace mongo {
 
         void wipeCacheForCollection( const StringData& ns );
 
+        // ---- incremental digest maintenance, see dbHashNote* above ----
+
+        void noteInsert( const StringData& ns, const BSONObj& doc );
+        void noteUpdate( const StringData& ns, const BSONObj& oldDoc, const BSONObj& newDoc );
+        void noteDelete( const StringData& ns, const BSONObj& doc );
+        void invalidateDigest( const StringData& ns );
+        bool hasDigests() const { return _numDigests.load() > 0; }
+        /** forget every digest in a database, e.g. after a command op on it */
+        void invalidateDigestsForDatabase( const StringData& dbName );
+
     private:
 
         bool isCachable( const StringData& ns ) const;
 
         string hashCollection( const string& fullCollectionName, bool* fromCache );
 
+        /**
+         * serves the collection's hash from its running digest, seeding the
+         * digest with one full scan the first time. the digest is an
+         * order-independent function of the documents, so nodes with the same
+         * data report the same value.
+         */
+        string hashCollectionIncremental( const string& fullCollectionName, bool* fromCache );
+
+        static unsigned long long hashDoc( const BSONObj& doc );
+        static string digestToHashString( unsigned long long digest );
+
+        // collections with a seeded running digest (sum mod 2^64 of per-doc
+        // hashes); absence means not seeded yet
+        typedef map<string,unsigned long long> DigestMap;
+        DigestMap _digests;
+        mutex _digestsMutex;
+
+        // gate so the per-write hooks don't touch _digestsMutex while no
+        // collection has been seeded
+        AtomicWord<int> _numDigests;
+
         map<string,string> _cachedHashed;
         mutex _cachedHashedMutex;
 
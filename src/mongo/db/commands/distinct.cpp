@@ -43,6 +43,7 @@
 #include "mongo/db/query/get_runner.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/type_explain.h"
+#include "mongo/platform/unordered_set.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
@@ -85,6 +86,13 @@ namespace mongo {
             BSONArrayBuilder arr( bb );
             BSONElementSet values;
 
+            // Exact-bytes pre-filter in front of 'values'.  Repeated values usually arrive
+            // with identical type and representation, and a hash probe on the raw bytes is
+            // much cheaper than the ordered set's full element comparisons.  Values that
+            // compare equal but are encoded differently (e.g. 1 vs 1.0) miss here and fall
+            // through to 'values', which remains authoritative.
+            unordered_set<string> seenExact;
+
             long long nscanned = 0; // locations looked at
             long long nscannedObjects = 0; // full objects looked at
             long long n = 0; // matches
@@ -125,6 +133,13 @@ namespace mongo {
 
                 for (BSONElementSet::iterator it = elts.begin(); it != elts.end(); ++it) {
                     BSONElement elt = *it;
+
+                    string rawValue;
+                    rawValue.reserve(1 + elt.valuesize());
+                    rawValue.push_back((char)elt.type());
+                    rawValue.append(elt.value(), elt.valuesize());
+                    if (!seenExact.insert(rawValue).second) { continue; }
+
                     if (values.count(elt)) { continue; }
                     int currentBufPos = bb.len();
 
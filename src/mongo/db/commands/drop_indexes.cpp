@@ -244,15 +244,25 @@ namespace mongo {
             }
             result.appendNumber( "nIndexesWas", collection->getIndexCatalog()->numIndexesTotal() );
 
-            Status s = collection->getIndexCatalog()->dropAllIndexes( true );
-            if ( !s.isOK() ) {
-                errmsg = "dropIndexes failed";
-                return appendCommandStatus( result, s );
-            }
-
+            // Rebuild the indexes one at a time rather than dropping them all up front.
+            // Each index is dropped immediately before its replacement is built into
+            // fresh extents, so a failure part way through leaves every other index
+            // intact (previously it left the collection with no indexes at all) and
+            // peak disk usage is bounded by one index instead of the whole set.
             for ( list<BSONObj>::iterator i=all.begin(); i!=all.end(); i++ ) {
                 BSONObj o = *i;
                 LOG(1) << "reIndex ns: " << toDeleteNs << " index: " << o << endl;
+
+                IndexDescriptor* desc =
+                    collection->getIndexCatalog()->findIndexByName( o.getStringField( "name" ) );
+                if ( desc ) {
+                    Status s = collection->getIndexCatalog()->dropIndex( desc );
+                    if ( !s.isOK() ) {
+                        errmsg = "dropIndex failed";
+                        return appendCommandStatus( result, s );
+                    }
+                }
+
                 Status s = collection->getIndexCatalog()->createIndex( o, false );
                 if ( !s.isOK() )
                     return appendCommandStatus( result, s );
@@ -29,6 +29,7 @@
 */
 
 #include "mongo/db/client.h"
+#include "mongo/db/command_arg_schema.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/field_parser.h"
@@ -76,6 +77,22 @@ namespace mongo {
     */
     BSONObj *getLastErrorDefault = 0;
 
+    namespace {
+        // Schema for the one-pass scan of the gle command object.  wOpTime
+        // and wElectionId are bound into slots here; the write concern
+        // fields themselves are parsed by WriteConcernOptions.
+        struct GLEArgs {
+            CommandArgSchema schema;
+            int wOpTime;
+            int wElectionId;
+            GLEArgs() {
+                wOpTime = schema.add("wOpTime");
+                wElectionId = schema.add("wElectionId");
+            }
+        };
+        const GLEArgs gleArgs;
+    }
+
     class CmdGetLastError : public Command {
     public:
         CmdGetLastError() : Command("getLastError", false, "getlasterror") { }
@@ -136,9 +153,15 @@ namespace mongo {
             // for sharding; also useful in general for debugging
             result.appendNumber( "connectionId" , c.getConnectionId() );
 
+            // One pass over cmdObj binds the fields we read below and counts
+            // the rest, replacing a full getField scan per field.
+            BSONElement gleSlots[2];
+            const int nFields = gleArgs.schema.bind(cmdObj, gleSlots);
+
             OpTime lastOpTime;
             BSONField<OpTime> wOpTimeField("wOpTime");
-            FieldParser::FieldState extracted = FieldParser::extract(cmdObj, wOpTimeField, 
+            FieldParser::FieldState extracted = FieldParser::extract(gleSlots[gleArgs.wOpTime],
+                                                                     wOpTimeField,
                                                                      &lastOpTime, &errmsg);
             if (!extracted) {
                 result.append("badGLE", cmdObj);
@@ -153,7 +176,7 @@ namespace mongo {
             
             OID electionId;
             BSONField<OID> wElectionIdField("wElectionId");
-            extracted = FieldParser::extract(cmdObj, wElectionIdField, 
+            extracted = FieldParser::extract(gleSlots[gleArgs.wElectionId], wElectionIdField,
                                              &electionId, &errmsg);
             if (!extracted) {
                 result.append("badGLE", cmdObj);
@@ -177,8 +200,7 @@ namespace mongo {
 
             BSONObj writeConcernDoc = cmdObj;
             // Use the default options if we have no gle options aside from wOpTime/wElectionId
-            const int nFields = cmdObj.nFields();
-            bool useDefaultGLEOptions = (nFields == 1) || 
+            bool useDefaultGLEOptions = (nFields == 1) ||
                 (nFields == 2 && lastOpTimePresent) ||
                 (nFields == 3 && lastOpTimePresent && electionIdPresent);
 
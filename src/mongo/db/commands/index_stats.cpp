@@ -38,6 +38,7 @@
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/util/descriptive_stats.h"
+#include "mongo/util/quantile_sketch.h"
 
 namespace mongo {
 
@@ -65,24 +66,77 @@ namespace mongo {
         double fillRatio;
     };
 
+    /**
+     * Replacement for SummaryEstimators: the exact basic estimators plus a
+     * mergeable QuantileSketch for the quantiles, so the stats for a level or
+     * subtree could be summed into a larger area's without re-walking it.
+     */
+    template <class Sample>
+    class SketchedEstimators {
+    public:
+        static const int quantiles = 99;
+
+        SketchedEstimators(double gamma, double minValue)
+            : _sketch(gamma, QuantileSketch::MaxBuckets, minValue) {
+        }
+
+        SketchedEstimators& operator<<(const Sample sample) {
+            _basic << sample;
+            _sketch.record(static_cast<double>(sample));
+            return *this;
+        }
+
+        void merge(const SketchedEstimators& other) {
+            _sketch.merge(other._sketch);
+        }
+
+        /**
+         * Same shape as SummaryEstimators::statisticSummaryToBSONObj; the
+         * quantiles come from the sketch, so they are available from the
+         * first sample onward rather than after 2 * quantiles + 3 of them.
+         */
+        BSONObj statisticSummaryToBSONObj() const {
+            BSONObjBuilder b;
+            _basic.appendBasicToBSONObjBuilder(b);
+            if (_basic.count() > 0) {
+                BSONObjBuilder quantilesBuilder(b.subobjStart("quantiles"));
+                for (int i = 1; i <= quantiles; i++) {
+                    const double probability = i * 1. / (quantiles + 1);
+                    quantilesBuilder.append(string(mongoutils::str::stream() << probability),
+                                            _sketch.quantile(probability));
+                }
+                quantilesBuilder.doneFast();
+            }
+            return b.obj();
+        }
+
+    private:
+        BasicEstimators<Sample> _basic;
+        QuantileSketch _sketch;
+    };
+
     /**
      * Aggregates and statistics for some part of the tree:
      *     the entire tree, a level or a certain subtree.
      */
     class AreaStats {
     public:
-        static const int quantiles = 99;
-
         boost::optional<NodeInfo> nodeInfo;
 
         unsigned int numBuckets;
-        SummaryEstimators<double, quantiles> bsonRatio;
-        SummaryEstimators<double, quantiles> fillRatio;
-        SummaryEstimators<double, quantiles> keyNodeRatio;
-        SummaryEstimators<unsigned int, quantiles> keyCount;
-        SummaryEstimators<unsigned int, quantiles> usedKeyCount;
-
-        AreaStats() : numBuckets(0) {
+        // the ratios live in (0, ~2], the counts in [1, keys-per-bucket]
+        SketchedEstimators<double> bsonRatio;
+        SketchedEstimators<double> fillRatio;
+        SketchedEstimators<double> keyNodeRatio;
+        SketchedEstimators<unsigned int> keyCount;
+        SketchedEstimators<unsigned int> usedKeyCount;
+
+        AreaStats() : numBuckets(0),
+                      bsonRatio(1.03, .01),
+                      fillRatio(1.03, .01),
+                      keyNodeRatio(1.03, .01),
+                      keyCount(1.05, 1.),
+                      usedKeyCount(1.05, 1.) {
         }
 
         virtual ~AreaStats() {
@@ -416,15 +470,15 @@ namespace mongo {
      *           keyCount: { (stats about the number of keys in a bucket)
      *               count: <number of samples>,
      *               mean: <mean>
-     *    (optional) stddev: <standard deviation>
-     *    (optional) min: <minimum value (number of keys for the bucket that has the least)>
-     *    (optional) max: <maximum value (number of keys for the bucket that has the most)>
+     *               stddev: <standard deviation>
+     *               min: <minimum value (number of keys for the bucket that has the least)>
+     *               max: <maximum value (number of keys for the bucket that has the most)>
      *    (optional) quantiles: {
      *                   0.01: <1st percentile>, 0.02: ..., 0.09: ..., 0.25: <1st quartile>,
      *                   0.5: <median>, 0.75: <3rd quartile>, 0.91: ..., 0.98: ..., 0.99: ...
      *               }
-     *    (optional fields are only present if there are enough samples to compute sensible
-     *     estimates)
+     *    (the quantiles, estimated by a log-bucket sketch, are present whenever there is at
+     *     least one sample)
      *           }
      *           usedKeyCount: <stats about the number of used keys in a bucket>
      *               (same structure as keyCount)
@@ -32,6 +32,9 @@
 
 #include "mongo/db/commands/mr.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/connpool.h"
 #include "mongo/client/parallel.h"
 #include "mongo/db/auth/authorization_session.h"
@@ -48,6 +51,7 @@
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/range_preserver.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/s/collection_metadata.h"
@@ -62,6 +66,12 @@ namespace mongo {
 
         AtomicUInt Config::JOB_NUMBER;
 
+        // Number of threads used to run the in-memory reduce of the map phase; the
+        // reduce function is required to be pure, so key groups can be reduced
+        // independently, each worker on a private JS scope.  Values below 2 keep
+        // the reduce on the command thread.
+        MONGO_EXPORT_SERVER_PARAMETER(mrParallelReduceThreads, int, 4);
+
         JSFunction::JSFunction( const std::string& type , const BSONElement& e ) {
             _type = type;
             _code = e._asCode();
@@ -71,7 +81,11 @@ namespace mongo {
         }
 
         void JSFunction::init( State * state ) {
-            _scope = state->scope();
+            init( state->scope() );
+        }
+
+        void JSFunction::init( Scope * scope ) {
+            _scope = scope;
             verify( _scope );
             _scope->init( &_wantedScope );
 
@@ -284,6 +298,7 @@ namespace mongo {
 
                 mapper.reset( new JSMapper( cmdObj["map"] ) );
                 reducer.reset( new JSReducer( cmdObj["reduce"] ) );
+                reduceCodeHolder = cmdObj["reduce"].wrap().getOwned();
                 if ( cmdObj["finalize"].type() && cmdObj["finalize"].trueValue() )
                     finalizer.reset( new JSFinalizer( cmdObj["finalize"] ) );
 
@@ -1033,6 +1048,17 @@ namespace mongo {
             long nSize = 0;
             _dupCount = 0;
 
+            // the multi-value key groups are independent of one another (the reduce
+            // function must be pure), so they can be farmed out to worker threads
+            vector<const BSONList*> toReduce;
+            for ( InMemory::iterator i=_temp->begin(); i!=_temp->end(); ++i ) {
+                if ( i->second.size() > 1 )
+                    toReduce.push_back( &i->second );
+            }
+            vector<BSONObj> reduced;
+            const bool parallel = _tryParallelReduce( toReduce, &reduced );
+
+            size_t reducedIdx = 0;
             for ( InMemory::iterator i=_temp->begin(); i!=_temp->end(); ++i ) {
                 BSONObj key = i->first;
                 BSONList& all = i->second;
@@ -1050,7 +1076,8 @@ namespace mongo {
                 }
                 else if ( all.size() > 1 ) {
                     // several values, reduce and add to map
-                    BSONObj res = _config.reducer->reduce( all );
+                    BSONObj res = parallel ? reduced[reducedIdx++]
+                                           : _config.reducer->reduce( all );
                     _add( n.get() , res , nSize );
                 }
             }
@@ -1060,6 +1087,71 @@ namespace mongo {
             _size = nSize;
         }
 
+        bool State::_tryParallelReduce( const vector<const BSONList*>& groups ,
+                                        vector<BSONObj>* results ) {
+            const int threads = mrParallelReduceThreads;
+            if ( threads < 2 || !globalScriptEngine )
+                return false;
+            // each worker compiles the reduce function into a fresh scope, so tiny
+            // batches are cheaper to reduce in place
+            if ( groups.size() < 64 ||
+                 groups.size() < static_cast<size_t>( threads ) * 4 )
+                return false;
+
+            results->resize( groups.size() );
+            vector<string> errors( threads );
+            vector<long long> counts( threads, 0 );
+
+            boost::thread_group workers;
+            for ( int t = 0; t < threads; t++ ) {
+                workers.create_thread( boost::bind( &State::_reducePartition, this,
+                                                    static_cast<size_t>( t ),
+                                                    static_cast<size_t>( threads ),
+                                                    boost::cref( groups ),
+                                                    results,
+                                                    &errors[t],
+                                                    &counts[t] ) );
+            }
+            workers.join_all();
+
+            for ( int t = 0; t < threads; t++ ) {
+                _config.reducer->numReduces += counts[t];
+                uassert( 17577,
+                         str::stream() << "parallel reduce failed: " << errors[t],
+                         errors[t].empty() );
+            }
+            return true;
+        }
+
+        void State::_reducePartition( size_t workerId , size_t numWorkers ,
+                                      const vector<const BSONList*>& groups ,
+                                      vector<BSONObj>* results ,
+                                      string* error , long long* numReduces ) {
+            Client::initThread( "mr_reduce" );
+            try {
+                JSReducer reducer( _config.reduceCodeHolder.firstElement() );
+                scoped_ptr<Scope> scope( globalScriptEngine->newScope() );
+                if ( ! _config.scopeSetup.isEmpty() )
+                    scope->init( &_config.scopeSetup );
+                reducer.init( scope.get() );
+
+                // reduce must be pure; forbid db access so a misbehaving function
+                // fails cleanly here instead of racing the command thread
+                Scope::NoDBAccess no = scope->disableDBAccess( "can't access db inside reduce" );
+                for ( size_t i = workerId; i < groups.size(); i += numWorkers ) {
+                    (*results)[i] = reducer.reduce( *groups[i] );
+                }
+                *numReduces = reducer.numReduces;
+            }
+            catch ( const std::exception& e ) {
+                *error = e.what();
+            }
+            catch ( ... ) {
+                *error = "unknown error in parallel reduce worker";
+            }
+            cc().shutdown();
+        }
+
         /**
          * Dumps the entire in memory map to the inc collection.
          */
@@ -98,6 +98,9 @@ namespace mongo {
 
             virtual void init( State * state );
 
+            /** binds to an explicit scope, e.g. a parallel reduce worker's private one */
+            void init( Scope * scope );
+
             Scope * scope() const { return _scope; }
             ScriptingFunction func() const { return _func; }
 
@@ -126,6 +129,9 @@ namespace mongo {
             JSReducer( const BSONElement& code ) : _func( "_reduce" , code ) {}
             virtual void init( State * state );
 
+            /** binds to an explicit scope; used by parallel reduce workers */
+            void init( Scope * scope ) { _func.init( scope ); }
+
             virtual BSONObj reduce( const BSONList& tuples );
             virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
 
@@ -194,6 +200,10 @@ namespace mongo {
             BSONObj mapParams;
             BSONObj scopeSetup;
 
+            // owned copy of the raw reduce element, so parallel reduce workers can
+            // build private reducers bound to their own scopes
+            BSONObj reduceCodeHolder;
+
             // output tables
             string incLong;
             string tempNamespace;
@@ -328,6 +338,22 @@ namespace mongo {
 
             void _add( InMemory* im , const BSONObj& a , long& size );
 
+            /**
+             * Reduces the multi-value key groups across worker threads, each with a
+             * private JS scope, filling results in the same order as groups.
+             * @return false when the parallel path is disabled or the batch is too
+             *         small to be worth the thread and scope setup; results is then
+             *         untouched and the caller reduces serially.
+             */
+            bool _tryParallelReduce( const std::vector<const BSONList*>& groups ,
+                                     std::vector<BSONObj>* results );
+
+            /** thread body for _tryParallelReduce; reduces groups[workerId::numWorkers] */
+            void _reducePartition( size_t workerId , size_t numWorkers ,
+                                   const std::vector<const BSONList*>& groups ,
+                                   std::vector<BSONObj>* results ,
+                                   std::string* error , long long* numReduces );
+
             scoped_ptr<Scope> _scope;
             bool _onDisk; // if the end result of this map reduce is disk or not
 
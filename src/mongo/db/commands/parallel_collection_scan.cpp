@@ -28,6 +28,8 @@
 *    it in the license file.
 */
 
+#include "mongo/db/commands/parallel_collection_scan.h"
+
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
@@ -37,129 +39,143 @@
 
 namespace mongo {
 
-
-    class ParallelCollectionScanCmd : public Command {
-    public:
-
-        struct ExtentInfo {
-            ExtentInfo( DiskLoc dl, size_t s )
-                : diskLoc(dl), size(s) {
-            }
-            DiskLoc diskLoc;
-            size_t size;
-        };
-
-        class ExtentRunner : public Runner {
-        public:
-            ExtentRunner( const StringData& ns,
-                          Database* db,
-                          Collection* collection,
-                          const vector<ExtentInfo>& extents )
-                : _ns( ns.toString() ),
-                  _collection( collection ),
-                  _extents( extents ),
-                  _extentManager( db->getExtentManager() ) {
-
-                invariant( _extents.size() > 0 );
-
-                _touchExtent( 0 );
-                _currentExtent = 0;
-                _currentRecord = _getExtent( _currentExtent )->firstRecord;
-                if ( _currentRecord.isNull() )
-                    _advance();
-            }
-            ~ExtentRunner() {
-            }
-
-            virtual RunnerState getNext(BSONObj* objOut, DiskLoc* dlOut) {
-                if ( _collection == NULL )
-                    return RUNNER_DEAD;
-                if ( _currentRecord.isNull() )
-                    return RUNNER_EOF;
-
-                if ( objOut )
-                    *objOut = _collection->docFor( _currentRecord );
-                if ( dlOut )
-                    *dlOut = _currentRecord;
+    ExtentRunner::ExtentRunner( const StringData& ns,
+                                Database* db,
+                                Collection* collection,
+                                const vector<ExtentInfo>& extents )
+        : _ns( ns.toString() ),
+          _collection( collection ),
+          _extents( extents ),
+          _extentManager( db->getExtentManager() ) {
+
+        invariant( _extents.size() > 0 );
+
+        _touchExtent( 0 );
+        _currentExtent = 0;
+        _currentRecord = _getExtent( _currentExtent )->firstRecord;
+        if ( _currentRecord.isNull() )
+            _advance();
+    }
+
+    ExtentRunner::~ExtentRunner() {
+    }
+
+    Runner::RunnerState ExtentRunner::getNext(BSONObj* objOut, DiskLoc* dlOut) {
+        if ( _collection == NULL )
+            return RUNNER_DEAD;
+        if ( _currentRecord.isNull() )
+            return RUNNER_EOF;
+
+        if ( objOut )
+            *objOut = _collection->docFor( _currentRecord );
+        if ( dlOut )
+            *dlOut = _currentRecord;
+        _advance();
+        return RUNNER_ADVANCED;
+    }
+
+    bool ExtentRunner::isEOF() {
+        return _collection == NULL || _currentRecord.isNull();
+    }
+
+    void ExtentRunner::kill() {
+        _collection = NULL;
+    }
+
+    void ExtentRunner::setYieldPolicy(YieldPolicy policy) {
+        invariant( false );
+    }
+
+    void ExtentRunner::saveState() {}
+
+    bool ExtentRunner::restoreState() { return true; }
+
+    const string& ExtentRunner::ns() { return _ns; }
+
+    void ExtentRunner::invalidate(const DiskLoc& dl, InvalidationType type) {
+        switch ( type ) {
+        case INVALIDATION_DELETION:
+            if ( dl == _currentRecord )
                 _advance();
-                return RUNNER_ADVANCED;
-            }
-
-            virtual bool isEOF() {
-                return _collection == NULL || _currentRecord.isNull();
-            }
-            virtual void kill() {
-                _collection = NULL;
-            }
-            virtual void setYieldPolicy(YieldPolicy policy) {
-                invariant( false );
-            }
-            virtual void saveState() {}
-            virtual bool restoreState() { return true;}
-            virtual const string& ns() { return _ns; }
-            virtual void invalidate(const DiskLoc& dl, InvalidationType type) {
-                switch ( type ) {
-                case INVALIDATION_DELETION:
-                    if ( dl == _currentRecord )
-                        _advance();
-                    break;
-                case INVALIDATION_MUTATION:
-                    // no-op
-                    break;
-                }
-            }
-            virtual const Collection* collection() {
-                return _collection;
-            }
-            virtual Status getInfo(TypeExplain** explain, PlanInfo** planInfo) const {
-                return Status( ErrorCodes::InternalError, "no" );
-            }
-        private:
-
-            /**
-             * @return if more data
-             */
-            bool _advance() {
-
-                while ( _currentRecord.isNull() ) {
-                    // need to move to next extent
-                    if ( _currentExtent + 1 >= _extents.size() )
-                        return false;
-                    _currentExtent++;
-                    _touchExtent( _currentExtent );
-                    _currentRecord = _getExtent( _currentExtent )->firstRecord;
-                    if ( !_currentRecord.isNull() )
-                        return true;
-                    // if we're here, the extent was empty, keep looking
-                }
-
-                // we're in an extent, advance
-                _currentRecord = _extentManager.getNextRecordInExtent( _currentRecord );
-                if ( _currentRecord.isNull() ) {
-                    // finished this extent, need to move to the next one
-                    return _advance();
-                }
+            break;
+        case INVALIDATION_MUTATION:
+            // no-op
+            break;
+        }
+    }
+
+    const Collection* ExtentRunner::collection() {
+        return _collection;
+    }
+
+    Status ExtentRunner::getInfo(TypeExplain** explain, PlanInfo** planInfo) const {
+        return Status( ErrorCodes::InternalError, "no" );
+    }
+
+    bool ExtentRunner::_advance() {
+
+        while ( _currentRecord.isNull() ) {
+            // need to move to next extent
+            if ( _currentExtent + 1 >= _extents.size() )
+                return false;
+            _currentExtent++;
+            _touchExtent( _currentExtent );
+            _currentRecord = _getExtent( _currentExtent )->firstRecord;
+            if ( !_currentRecord.isNull() )
                 return true;
-            }
+            // if we're here, the extent was empty, keep looking
+        }
 
-            Extent* _getExtent( size_t offset ) {
-                DiskLoc dl = _extents[offset].diskLoc;
-                return _extentManager.getExtent( dl );
+        // we're in an extent, advance
+        _currentRecord = _extentManager.getNextRecordInExtent( _currentRecord );
+        if ( _currentRecord.isNull() ) {
+            // finished this extent, need to move to the next one
+            return _advance();
+        }
+        return true;
+    }
+
+    Extent* ExtentRunner::_getExtent( size_t offset ) {
+        DiskLoc dl = _extents[offset].diskLoc;
+        return _extentManager.getExtent( dl );
+    }
+
+    void ExtentRunner::_touchExtent( size_t offset ) {
+        Extent* e = _getExtent( offset );
+        touch_pages( reinterpret_cast<const char*>(e), e->length );
+    }
+
+    vector< vector<ExtentInfo> > partitionCollectionExtents( Database* db,
+                                                             Collection* collection,
+                                                             size_t maxBuckets ) {
+        vector< vector<ExtentInfo> > buckets;
+
+        const ExtentManager& extentManager = db->getExtentManager();
+
+        DiskLoc extentDiskLoc = collection->details()->firstExtent();
+        int extentNumber = 0;
+        while (!extentDiskLoc.isNull()) {
+
+            Extent* thisExtent = extentManager.getExtent( extentDiskLoc );
+            ExtentInfo info( extentDiskLoc, thisExtent->length );
+            if ( buckets.size() < maxBuckets ) {
+                vector<ExtentInfo> v;
+                v.push_back( info );
+                buckets.push_back( v );
             }
-
-            void _touchExtent( size_t offset ) {
-                Extent* e = _getExtent( offset );
-                touch_pages( reinterpret_cast<const char*>(e), e->length );
+            else {
+                buckets[ extentNumber % buckets.size() ].push_back( info );
             }
 
-            string _ns;
-            Collection* _collection;
-            vector<ExtentInfo> _extents;
-            ExtentManager& _extentManager;
+            extentDiskLoc = thisExtent->xnext;
+            extentNumber++;
+        }
+
+        return buckets;
+    }
 
-            size_t _currentExtent;
-            DiskLoc _currentRecord;
-        };
+    class ParallelCollectionScanCmd : public Command {
+    public:
 
         // ------------------------------------------------
 
@@ -204,30 +220,10 @@ namespace mongo {
                                                     "numCursors has to be between 1 and 10000" <<
                                                     " was: " << numCursors ) );
 
-            vector< vector<ExtentInfo> > buckets;
-
-            const ExtentManager& extentManager = db->getExtentManager();
+            vector< vector<ExtentInfo> > buckets =
+                partitionCollectionExtents( db, collection, numCursors );
 
             {
-                DiskLoc extentDiskLoc = collection->details()->firstExtent();
-                int extentNumber = 0;
-                while (!extentDiskLoc.isNull()) {
-
-                    Extent* thisExtent = extentManager.getExtent( extentDiskLoc );
-                    ExtentInfo info( extentDiskLoc, thisExtent->length );
-                    if ( buckets.size() < numCursors ) {
-                        vector<ExtentInfo> v;
-                        v.push_back( info );
-                        buckets.push_back( v );
-                    }
-                    else {
-                        buckets[ extentNumber % buckets.size() ].push_back( info );
-                    }
-
-                    extentDiskLoc = thisExtent->xnext;
-                    extentNumber++;
-                }
-
                 BSONArrayBuilder bucketsBuilder;
                 for ( size_t i = 0; i < buckets.size(); i++ ) {
 
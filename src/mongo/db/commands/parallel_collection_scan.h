@@ -0,0 +1,106 @@
+// parallel_collection_scan.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/query/runner.h"
+
+namespace mongo {
+
+    class Collection;
+    class Database;
+    class Extent;
+    class ExtentManager;
+
+    struct ExtentInfo {
+        ExtentInfo( DiskLoc dl, size_t s )
+            : diskLoc(dl), size(s) {
+        }
+        DiskLoc diskLoc;
+        size_t size;
+    };
+
+    /**
+     * Runner over a fixed list of extents, in extent order.  Used by the
+     * parallelCollectionScan command and by the parallel aggregation scan in
+     * pipeline_d.cpp, which run several of these side by side over disjoint
+     * extent ranges of the same collection.
+     */
+    class ExtentRunner : public Runner {
+    public:
+        ExtentRunner( const StringData& ns,
+                      Database* db,
+                      Collection* collection,
+                      const std::vector<ExtentInfo>& extents );
+        ~ExtentRunner();
+
+        virtual RunnerState getNext(BSONObj* objOut, DiskLoc* dlOut);
+        virtual bool isEOF();
+        virtual void kill();
+        virtual void setYieldPolicy(YieldPolicy policy);
+        virtual void saveState();
+        virtual bool restoreState();
+        virtual const string& ns();
+        virtual void invalidate(const DiskLoc& dl, InvalidationType type);
+        virtual const Collection* collection();
+        virtual Status getInfo(TypeExplain** explain, PlanInfo** planInfo) const;
+
+    private:
+        /**
+         * @return if more data
+         */
+        bool _advance();
+
+        Extent* _getExtent( size_t offset );
+
+        void _touchExtent( size_t offset );
+
+        string _ns;
+        Collection* _collection;
+        std::vector<ExtentInfo> _extents;
+        ExtentManager& _extentManager;
+
+        size_t _currentExtent;
+        DiskLoc _currentRecord;
+    };
+
+    /**
+     * Round-robins the collection's extents into at most maxBuckets buckets,
+     * one per intended cursor.  Returns fewer buckets than requested when the
+     * collection has fewer extents.  Caller must hold a read lock.
+     */
+    std::vector< std::vector<ExtentInfo> > partitionCollectionExtents( Database* db,
+                                                                       Collection* collection,
+                                                                       size_t maxBuckets );
+
+}  // namespace mongo
@@ -235,7 +235,10 @@ namespace mongo {
             {
                 Client::Context srcCtx( source );
                 Collection* sourceColl = srcCtx.db()->getCollection( source );
-                sourceIt.reset( sourceColl->getIterator( DiskLoc(), false, CollectionScanParams::FORWARD ) );
+                // single pass over the source; advise the OS to reclaim pages behind us
+                sourceIt.reset( sourceColl->getIterator( DiskLoc(), false,
+                                                         CollectionScanParams::FORWARD,
+                                                         true ) );
             }
 
             Collection* targetColl = NULL;
@@ -41,6 +41,7 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/util/net/listen.h"
+#include "mongo/util/numa.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/version.h"
@@ -110,9 +111,23 @@ namespace mongo {
             result.appendDate( "localTime" , jsTime() );
 
             timeBuilder.appendNumber( "after basic" , Listener::getElapsedTimeMillis() - start );
-            
+
+            // --- delta mode
+            //
+            // serverStatus({delta: <epochs doc from the last reply>}) skips
+            // sections whose change epoch still matches that doc, and returns a
+            // fresh "epochs" doc to pass on the next poll.  Sections that don't
+            // track an epoch are always regenerated.  First poll: {delta: {}}.
+            BSONObj prevEpochs;
+            bool deltaMode = false;
+            if ( cmdObj["delta"].type() == Object ) {
+                deltaMode = true;
+                prevEpochs = cmdObj["delta"].Obj();
+            }
+            BSONObjBuilder epochsBuilder;
+
             // --- all sections
-            
+
             for ( SectionMap::const_iterator i = _sections->begin(); i != _sections->end(); ++i ) {
                 ServerStatusSection* section = i->second;
                 
@@ -130,7 +145,19 @@ namespace mongo {
                 
                 if ( ! include )
                     continue;
-                
+
+                if ( deltaMode ) {
+                    const unsigned long long epoch = section->changeEpoch();
+                    if ( epoch ) {
+                        epochsBuilder.append( section->getSectionName(),
+                                              static_cast<long long>( epoch ) );
+                        BSONElement prev = prevEpochs[section->getSectionName()];
+                        if ( prev.isNumber() &&
+                             static_cast<unsigned long long>( prev.numberLong() ) == epoch )
+                            continue; // unchanged since the client's last poll
+                    }
+                }
+
                 BSONObj data = section->generateSection(e);
                 if ( data.isEmpty() )
                     continue;
@@ -140,6 +167,9 @@ namespace mongo {
                                           Listener::getElapsedTimeMillis() - start );
             }
 
+            if ( deltaMode )
+                result.append( "epochs", epochsBuilder.obj() );
+
             // --- counters
             bool includeMetricTree = MetricTree::theMetricTree != NULL;
             if ( cmdObj["metrics"].type() && !cmdObj["metrics"].trueValue() )
@@ -279,6 +309,14 @@ namespace mongo {
                 return bb.obj();
             }
 
+            virtual unsigned long long changeEpoch() const {
+                // totalCreated only grows; fold in the current count so closes
+                // move the epoch too
+                return ( static_cast<unsigned long long>(
+                             Listener::globalConnectionNumber.load() ) << 20 )
+                       + Listener::globalTicketHolder.used();
+            }
+
         } connections;
 
         class ExtraInfo : public ServerStatusSection {
@@ -298,6 +336,26 @@ namespace mongo {
         } extraInfo;
 
 
+        class Numa : public ServerStatusSection {
+        public:
+            Numa() : ServerStatusSection( "numa" ){}
+            virtual bool includeByDefault() const { return false; }
+
+            BSONObj generateSection(const BSONElement& configElement) const {
+                BSONObjBuilder bb;
+                bb.append( "numNodes", numaNodeCount() );
+                // true when started with --numaInterleave and the policy took effect;
+                // running under numactl --interleave instead shows up as the absence
+                // of the NUMA startup warning, not here
+                bb.append( "interleaveApplied", numaInterleaveApplied() );
+                return bb.obj();
+            }
+
+            // fixed after startup
+            virtual unsigned long long changeEpoch() const { return 1; }
+        } numaSection;
+
+
         class Asserts : public ServerStatusSection {
         public:
             Asserts() : ServerStatusSection( "asserts" ){}
@@ -312,7 +370,14 @@ namespace mongo {
                 asserts.append( "rollovers" , assertionCount.rollovers );
                 return asserts.obj();
             }
-                
+
+            virtual unsigned long long changeEpoch() const {
+                // the counts only grow, so their sum is a change fingerprint
+                return static_cast<unsigned long long>( assertionCount.regular ) +
+                       assertionCount.warning + assertionCount.msg +
+                       assertionCount.user + assertionCount.rollovers;
+            }
+
         } asserts;
 
 
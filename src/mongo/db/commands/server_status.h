@@ -76,6 +76,15 @@ namespace mongo {
          */
         virtual BSONObj generateSection(const BSONElement& configElement) const = 0;
 
+        /**
+         * a cheap fingerprint of this section's contents, used by
+         * serverStatus({delta: <epochs>}) to skip serializing sections that
+         * have not changed since the client's last poll.  must be far cheaper
+         * to compute than generateSection().  returning 0 (the default) means
+         * the section does not track changes and is always regenerated.
+         */
+        virtual unsigned long long changeEpoch() const { return 0; }
+
     private:
         const string _sectionName;
     };
@@ -30,6 +30,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/quantile_sketch.h"
 
 namespace mongo {
 
@@ -37,6 +38,15 @@ namespace {
 
     // Helper classes and functions
 
+    // record size quantiles reported per extent and for the whole namespace
+    const double kRecBytesQuantiles[] = { .25, .5, .75, .9, .99 };
+    const int kNumRecBytesQuantiles = 5;
+
+    /** record size sketch; ~10% relative error, covers any record length */
+    QuantileSketch makeRecBytesSketch() {
+        return QuantileSketch(1.1, QuantileSketch::MaxBuckets, 32.);
+    }
+
     /**
      * Available subcommands.
      */
@@ -419,7 +429,7 @@ namespace {
      */
     void processRecord(const DiskLoc& dl, const DiskLoc& prevDl, const Record* r, int extentOfs,
                        const AnalyzeParams& params, vector<DiskStorageData>& sliceData,
-                       BSONArrayBuilder* recordsArrayBuilder) {
+                       QuantileSketch& recBytesSketch, BSONArrayBuilder* recordsArrayBuilder) {
         killCurrentOp.checkForInterrupt();
 
         BSONObj obj = dl.obj();
@@ -446,6 +456,12 @@ namespace {
             }
         }
 
+        if (spansRequestedArea) {
+            // whole records, not apportioned to slices: the sketch answers
+            // "how are record sizes distributed", not "where are the bytes"
+            recBytesSketch.record(recBytes);
+        }
+
         if (recordsArrayBuilder != NULL && spansRequestedArea) {
             DEV {
                 int startsAt = dl.getOfs() - extentOfs;
@@ -489,6 +505,11 @@ namespace {
      *       outOfOrderRecs: <number of records that follow - in the record linked list -
      *                        a record that is located further in the extent>
      * (opt) freeRecsPerBucket: [ ... ],
+     *       recBytesQuantiles: { count: ..., quantiles: { 0.25: ..., 0.5: ..., ... } }
+     *                          (record size distribution for whole records, estimated by a
+     *                           mergeable log-bucket sketch; for a whole-namespace analysis
+     *                           the per-extent sketches are merged and also reported at the
+     *                           top level)
      * The nth element in the freeRecsPerBucket array is the count of deleted records in the
      * nth bucket of the deletedList.
      * The characteristic field dotted path is specified in params.characteristicField.
@@ -525,7 +546,8 @@ namespace {
      */
     bool analyzeDiskStorage(const NamespaceDetails* nsd, const Extent* ex,
                                                const AnalyzeParams& params, string& errmsg,
-                                               BSONObjBuilder& result) {
+                                               BSONObjBuilder& result,
+                                               QuantileSketch* namespaceRecBytes) {
         bool isCapped = nsd->isCapped();
 
         result.append("extentHeaderBytes", Extent::HeaderSize());
@@ -547,10 +569,12 @@ namespace {
         Database* db = cc().database();
         ExtentManager& extentManager = db->getExtentManager();
 
+        QuantileSketch recBytesSketch = makeRecBytesSketch();
+
         DiskLoc prevDl = ex->firstRecord;
         for (DiskLoc dl = ex->firstRecord; !dl.isNull(); dl = extentManager.getNextRecordInExtent(dl)) {
             r = dl.rec();
-            processRecord(dl, prevDl, r, extentOfs, params, sliceData,
+            processRecord(dl, prevDl, r, extentOfs, params, sliceData, recBytesSketch,
                           recordsArrayBuilder.get());
             prevDl = dl;
         }
@@ -598,6 +622,16 @@ namespace {
         } else {
             sliceData[0].appendToBSONObjBuilder(result, processingDeletedRecords);
         }
+
+        {
+            BSONObjBuilder sketchBuilder(result.subobjStart("recBytesQuantiles"));
+            recBytesSketch.appendSummary(kRecBytesQuantiles, kNumRecBytesQuantiles,
+                                         &sketchBuilder);
+            sketchBuilder.doneFast();
+        }
+        if (namespaceRecBytes != NULL) {
+            namespaceRecBytes->merge(recBytesSketch);
+        }
         return true;
     }
 
@@ -678,7 +712,8 @@ namespace {
      *               granularity
      */
     bool analyzeExtent(const NamespaceDetails* nsd, const Extent* ex, SubCommand subCommand,
-                       AnalyzeParams& params, string& errmsg, BSONObjBuilder& outputBuilder) {
+                       AnalyzeParams& params, string& errmsg, BSONObjBuilder& outputBuilder,
+                       QuantileSketch* namespaceRecBytes = NULL) {
 
         params.startOfs = max(0, params.startOfs);
         params.endOfs = min(params.endOfs, ex->length);
@@ -698,7 +733,8 @@ namespace {
                 (params.granularity * (params.numberOfSlices - 1));
         switch (subCommand) {
             case SUBCMD_DISK_STORAGE:
-                return analyzeDiskStorage(nsd, ex, params, errmsg, outputBuilder);
+                return analyzeDiskStorage(nsd, ex, params, errmsg, outputBuilder,
+                                          namespaceRecBytes);
             case SUBCMD_PAGES_IN_RAM:
                 return analyzePagesInRAM(ex, params, errmsg, outputBuilder);
         }
@@ -732,6 +768,9 @@ namespace {
                 globalParams.granularity = ceilingDiv(storageSize, globalParams.numberOfSlices);
             }
 
+            // built by merging the per-extent sketches
+            QuantileSketch namespaceRecBytes = makeRecBytesSketch();
+
             BSONArrayBuilder extentsArrayBuilder(outputBuilder.subarrayStart("extents"));
             for (Extent* curExtent = em.getExtent(dl);
                  curExtent != NULL;
@@ -744,10 +783,18 @@ namespace {
                                                  // extents
                 BSONObjBuilder extentBuilder(extentsArrayBuilder.subobjStart());
                 success = analyzeExtent(nsd, curExtent, subCommand, extentParams, errmsg,
-                                        extentBuilder);
+                                        extentBuilder, &namespaceRecBytes);
                 extentBuilder.doneFast();
             }
             extentsArrayBuilder.doneFast();
+
+            if (subCommand == SUBCMD_DISK_STORAGE) {
+                BSONObjBuilder sketchBuilder(
+                        outputBuilder.subobjStart("recBytesQuantiles"));
+                namespaceRecBytes.appendSummary(kRecBytesQuantiles, kNumRecBytesQuantiles,
+                                                &sketchBuilder);
+                sketchBuilder.doneFast();
+            }
         }
         if (!success) return false;
         result.appendElements(outputBuilder.obj());
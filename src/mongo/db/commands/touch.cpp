@@ -32,15 +32,25 @@
 
 #include "mongo/pch.h"
 
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <boost/thread/thread.hpp>
+
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/curop-inl.h"
 #include "mongo/db/structure/catalog/namespace_details.h"
@@ -48,6 +58,9 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/platform/posix_fadvise.h"
+#include "mongo/util/mmap.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/touch_pages.h"
 
@@ -58,8 +71,28 @@ namespace mongo {
         size_t length;
     };
 
-    /** @return numRanges touched */
-    int touchNs( const std::string& ns ) {
+    /** enumerate the index namespaces of ns, so each btree can be touched or
+        reported on separately */
+    static std::vector<std::string> indexNamespaces( const std::string& ns ) {
+        std::vector<std::string> indexes;
+
+        Client::ReadContext ctx(ns);
+        NamespaceDetails *nsd = nsdetails(ns);
+        massert( 16153, "namespace does not exist", nsd );
+
+        NamespaceDetails::IndexIterator ii = nsd->ii();
+        while ( ii.more() ) {
+            IndexDetails& idx = ii.next();
+            indexes.push_back( idx.indexNamespace() );
+        }
+        return indexes;
+    }
+
+    /** @param rateMBPerSec if positive, sleep between extents as needed to keep
+               the touch at or below this rate, so a background warm doesn't
+               monopolize disk bandwidth
+        @return numRanges touched */
+    int touchNs( const std::string& ns, double rateMBPerSec = 0 ) {
         std::vector< touch_location > ranges;
         boost::scoped_ptr<LockMongoFilesShared> mongoFilesLock;
         {
@@ -87,8 +120,19 @@ namespace mongo {
         ProgressMeterHolder pm(cc().curop()->setMessage(progress_msg.c_str(),
                                                         "Touch Progress",
                                                         ranges.size()));
+        Timer timer;
+        long long bytesTouched = 0;
         for ( std::vector< touch_location >::iterator it = ranges.begin(); it != ranges.end(); ++it ) {
             touch_pages( it->root, it->length );
+            bytesTouched += it->length;
+            if ( rateMBPerSec > 0 ) {
+                // pause as needed to stay at or below the requested rate
+                const long long targetMillis = static_cast<long long>(
+                    bytesTouched / ( rateMBPerSec * 1024 * 1024 / 1000 ) );
+                const long long aheadMillis = targetMillis - timer.millis();
+                if ( aheadMillis > 0 )
+                    sleepmillis( aheadMillis );
+            }
             pm.hit();
             killCurrentOp.checkForInterrupt();
         }
@@ -97,6 +141,183 @@ namespace mongo {
         return static_cast<int>( ranges.size() );
     }
 
+    /** count resident vs total pages over the extents of ns via mincore().
+        caller must have checked ProcessInfo::blockCheckSupported().
+        @return false if the residency of some extent could not be determined */
+    static bool residencyNs( const std::string& ns,
+                             long long* residentPages,
+                             long long* totalPages ) {
+        *residentPages = 0;
+        *totalPages = 0;
+
+        Client::ReadContext ctx(ns);
+
+        Database* db = ctx.ctx().db();
+        ExtentManager& em = db->getExtentManager();
+
+        Collection* collection = db->getCollection( ns );
+        uassert( 17440, "namespace does not exist", collection );
+
+        std::vector<char> out;
+        Extent* ext = em.getExtent( collection->details()->firstExtent() );
+        while ( ext ) {
+            const size_t numPages =
+                ( ext->length + g_minOSPageSizeBytes - 1 ) / g_minOSPageSizeBytes;
+            if ( ! ProcessInfo::pagesInMemory( ext, numPages, &out ) )
+                return false;
+            *totalPages += numPages;
+            for ( size_t i = 0; i < numPages; i++ ) {
+                if ( out[i] )
+                    (*residentPages)++;
+            }
+            ext = em.getNextExtent( ext );
+        }
+        return true;
+    }
+
+    /** per-namespace resident/total page counts for ns and each of its indexes:
+        { "<ns>": { residentPages: n, totalPages: n, percent: p }, ... } */
+    static BSONObj residencyReport( const std::string& ns ) {
+        uassert( 17441,
+                 "cannot check page residency on this platform",
+                 ProcessInfo::blockCheckSupported() );
+
+        std::vector<std::string> namespaces;
+        namespaces.push_back( ns );
+        std::vector<std::string> indexes = indexNamespaces( ns );
+        namespaces.insert( namespaces.end(), indexes.begin(), indexes.end() );
+
+        BSONObjBuilder b;
+        for ( std::vector<std::string>::const_iterator it = namespaces.begin();
+              it != namespaces.end();
+              it++ ) {
+            long long resident = 0;
+            long long total = 0;
+            uassert( 17442,
+                     str::stream() << "could not check residency of " << *it,
+                     residencyNs( *it, &resident, &total ) );
+            BSONObjBuilder sub( b.subobjStart( *it ) );
+            sub.append( "residentPages", resident );
+            sub.append( "totalPages", total );
+            sub.append( "percent", total ? 100.0 * resident / total : 0.0 );
+            sub.done();
+        }
+        return b.obj();
+    }
+
+    /** hint the OS to drop its cached pages for every extent of ns (fadvise
+        DONTNEED).  only clean page cache pages are dropped, and the private
+        (journal) view is untouched, so this is safe with journaling enabled;
+        it is advisory only.
+        @return numRanges hinted, or -1 where fadvise is unsupported */
+    static int evictNs( const std::string& ns ) {
+#if defined(POSIX_FADV_DONTNEED)
+        // gather each extent's file path and byte range under the read lock; the
+        // fadvise calls go to the page cache through a plain fd, not through the
+        // mapping, so no lock is needed for them
+        std::map< std::string, std::vector< std::pair<off_t, off_t> > > byFile;
+        {
+            Client::ReadContext ctx(ns);
+
+            Database* db = ctx.ctx().db();
+            ExtentManager& em = db->getExtentManager();
+
+            Collection* collection = db->getCollection( ns );
+            uassert( 17443, "namespace does not exist", collection );
+
+            Extent* ext = em.getExtent( collection->details()->firstExtent() );
+            while ( ext ) {
+                const std::string path = em.fileName( ext->myLoc.a() ).string();
+                byFile[path].push_back(
+                    std::make_pair( static_cast<off_t>( ext->myLoc.getOfs() ),
+                                    static_cast<off_t>( ext->length ) ) );
+                ext = em.getNextExtent( ext );
+            }
+        }
+
+        int numRanges = 0;
+        for ( std::map< std::string, std::vector< std::pair<off_t, off_t> > >::const_iterator
+                  fit = byFile.begin();
+              fit != byFile.end();
+              fit++ ) {
+            const int fd = open( fit->first.c_str(), O_RDONLY );
+            if ( fd < 0 ) {
+                warning() << "touch: cannot open " << fit->first << " to evict: "
+                          << errnoWithDescription() << endl;
+                continue;
+            }
+            const std::vector< std::pair<off_t, off_t> >& fileRanges = fit->second;
+            for ( size_t i = 0; i < fileRanges.size(); i++ ) {
+                if ( posix_fadvise( fd, fileRanges[i].first, fileRanges[i].second,
+                                    POSIX_FADV_DONTNEED ) ) {
+                    warning() << "touch: posix_fadvise fails " << fit->first << ' '
+                              << errnoWithDescription() << endl;
+                    break;
+                }
+                numRanges++;
+            }
+            close( fd );
+            killCurrentOp.checkForInterrupt();
+        }
+        return numRanges;
+#else
+        return -1;
+#endif
+    }
+
+    static bool performTouch( const std::string& ns,
+                              std::string& errmsg,
+                              bool touch_data,
+                              bool touch_indexes,
+                              double rateMBPerSec,
+                              BSONObjBuilder& result ) {
+
+        if (touch_data) {
+            log() << "touching namespace " << ns << endl;
+            Timer t;
+            int numRanges = touchNs( ns, rateMBPerSec );
+            result.append( "data", BSON( "numRanges" << numRanges <<
+                                         "millis" << t.millis() ) );
+            log() << "touching namespace " << ns << " complete" << endl;
+        }
+
+        if (touch_indexes) {
+            Timer t;
+            std::vector< std::string > indexes = indexNamespaces( ns );
+
+            int numRanges = 0;
+
+            for ( std::vector<std::string>::const_iterator it = indexes.begin();
+                  it != indexes.end();
+                  it++ ) {
+                numRanges += touchNs( *it, rateMBPerSec );
+            }
+
+            result.append( "indexes", BSON( "num" << static_cast<int>(indexes.size()) <<
+                                            "numRanges" << numRanges <<
+                                            "millis" << t.millis() ) );
+
+        }
+        return true;
+    }
+
+    static void touchBackgroundThread( const std::string ns,
+                                       bool touch_data,
+                                       bool touch_indexes,
+                                       double rateMBPerSec ) {
+        Client::initThread( "touchBackground" );
+        try {
+            std::string errmsg;
+            BSONObjBuilder result;
+            performTouch( ns, errmsg, touch_data, touch_indexes, rateMBPerSec, result );
+            log() << "background touch of " << ns << ": " << result.done() << endl;
+        }
+        catch ( const DBException& e ) {
+            log() << "background touch of " << ns << " failed: " << e.what() << endl;
+        }
+        cc().shutdown();
+    }
+
     class TouchCmd : public Command {
     public:
         virtual LockType locktype() const { return NONE; }
@@ -108,7 +329,14 @@ namespace mongo {
             help << "touch collection\n"
                 "Page in all pages of memory containing every extent for the given collection\n"
                 "{ touch : <collection_name>, [data : true] , [index : true] }\n"
-                " at least one of data or index must be true; default is both are false\n";
+                " at least one of data or index must be true; default is both are false\n"
+                "options:\n"
+                "  rateMBPerSec : <n>  limit the touch to about n MB/s of reads\n"
+                "  background : true   return at once; warm in a background thread\n"
+                "  evict : true        instead of paging in, hint the OS to drop its\n"
+                "                      cached pages for the selected extents\n"
+                "  residency : true    report resident vs total pages for the collection\n"
+                "                      and its indexes instead of touching anything\n";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
@@ -119,24 +347,29 @@ namespace mongo {
         }
         TouchCmd() : Command("touch") { }
 
-        virtual bool run(const string& db, 
-                         BSONObj& cmdObj, 
-                         int, 
-                         string& errmsg, 
-                         BSONObjBuilder& result, 
+        virtual bool run(const string& db,
+                         BSONObj& cmdObj,
+                         int,
+                         string& errmsg,
+                         BSONObjBuilder& result,
                          bool fromRepl) {
             string coll = cmdObj.firstElement().valuestr();
             if( coll.empty() || db.empty() ) {
                 errmsg = "no collection name specified";
                 return false;
             }
-                        
+
             string ns = db + '.' + coll;
             if ( ! NamespaceString::normal(ns.c_str()) ) {
                 errmsg = "bad namespace name";
                 return false;
             }
 
+            if ( cmdObj["residency"].trueValue() ) {
+                result.append( "residency", residencyReport( ns ) );
+                return true;
+            }
+
             bool touch_indexes( cmdObj["index"].trueValue() );
             bool touch_data( cmdObj["data"].trueValue() );
 
@@ -144,57 +377,98 @@ namespace mongo {
                 errmsg = "must specify at least one of (data:true, index:true)";
                 return false;
             }
-            bool ok = touch( ns, errmsg, touch_data, touch_indexes, result );
+
+            if ( cmdObj["evict"].trueValue() ) {
+                return evict( ns, errmsg, touch_data, touch_indexes, result );
+            }
+
+            double rateMBPerSec = cmdObj["rateMBPerSec"].number();
+            if ( rateMBPerSec < 0 ) {
+                errmsg = "rateMBPerSec cannot be negative";
+                return false;
+            }
+
+            if ( cmdObj["background"].trueValue() ) {
+                boost::thread touchThread( boost::bind( touchBackgroundThread,
+                                                        ns, touch_data, touch_indexes,
+                                                        rateMBPerSec ) );
+                result.append( "note", "touch started in background" );
+                return true;
+            }
+
+            bool ok = performTouch( ns, errmsg, touch_data, touch_indexes,
+                                    rateMBPerSec, result );
             return ok;
         }
 
-        bool touch( std::string& ns, 
-                    std::string& errmsg, 
-                    bool touch_data, 
-                    bool touch_indexes, 
+        bool evict( const std::string& ns,
+                    std::string& errmsg,
+                    bool evict_data,
+                    bool evict_indexes,
                     BSONObjBuilder& result ) {
 
-            if (touch_data) {
-                log() << "touching namespace " << ns << endl;
+            if (evict_data) {
                 Timer t;
-                int numRanges = touchNs( ns );
+                int numRanges = evictNs( ns );
+                if ( numRanges < 0 ) {
+                    errmsg = "eviction hints are not supported on this platform";
+                    return false;
+                }
                 result.append( "data", BSON( "numRanges" << numRanges <<
                                              "millis" << t.millis() ) );
-                log() << "touching namespace " << ns << " complete" << endl;
             }
 
-            if (touch_indexes) {
+            if (evict_indexes) {
                 Timer t;
-                // enumerate indexes
-                std::vector< std::string > indexes;
-                {
-                    Client::ReadContext ctx(ns);
-                    NamespaceDetails *nsd = nsdetails(ns);
-                    massert( 16153, "namespace does not exist", nsd );
-
-                    NamespaceDetails::IndexIterator ii = nsd->ii(); 
-                    while ( ii.more() ) {
-                        IndexDetails& idx = ii.next();
-                        indexes.push_back( idx.indexNamespace() );
-                    }
-                }
+                std::vector< std::string > indexes = indexNamespaces( ns );
 
                 int numRanges = 0;
 
-                for ( std::vector<std::string>::const_iterator it = indexes.begin(); 
-                      it != indexes.end(); 
+                for ( std::vector<std::string>::const_iterator it = indexes.begin();
+                      it != indexes.end();
                       it++ ) {
-                    numRanges += touchNs( *it );
+                    int n = evictNs( *it );
+                    if ( n < 0 ) {
+                        errmsg = "eviction hints are not supported on this platform";
+                        return false;
+                    }
+                    numRanges += n;
                 }
 
                 result.append( "indexes", BSON( "num" << static_cast<int>(indexes.size()) <<
                                                 "numRanges" << numRanges <<
                                                 "millis" << t.millis() ) );
-
             }
             return true;
         }
-        
+
     };
     static TouchCmd touchCmd;
+
+    namespace {
+
+        /** "residency" serverStatus section: pass a full collection namespace,
+            e.g. serverStatus({residency: "test.foo"}), to get the same
+            resident-page report as {touch: ..., residency: true} */
+        class ResidencySection : public ServerStatusSection {
+        public:
+            ResidencySection() : ServerStatusSection( "residency" ) {}
+
+            virtual bool includeByDefault() const { return false; }
+
+            virtual BSONObj generateSection( const BSONElement& configElement ) const {
+                if ( configElement.type() != String ) {
+                    return BSON( "note" << "pass a full collection namespace, e.g. "
+                                 "serverStatus({residency: \"test.foo\"}), for a report" );
+                }
+                try {
+                    return residencyReport( configElement.String() );
+                }
+                catch ( const DBException& e ) {
+                    return BSON( "error" << e.what() );
+                }
+            }
+        } residencySection;
+
+    }  // namespace
 }
@@ -28,17 +28,133 @@
  *    it in the license file.
  */
 
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/catalog/database.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/parallel_collection_scan.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/runner.h"
 #include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/extent_manager.h"
 #include "mongo/db/catalog/collection.h"
 
 namespace mongo {
 
+    namespace {
+
+        /**
+         * Record scan results for one bucket of extents.  Each worker thread fills
+         * one of these independently; validateNS() merges them after the join.
+         */
+        struct RecordScanResult {
+            RecordScanResult() : n(0), nInvalid(0), nQuantizedSize(0), nPowerOf2QuantizedSize(0),
+                                 len(0), nlen(0), bsonLen(0) { }
+
+            int n;
+            int nInvalid;
+            long long nQuantizedSize;
+            long long nPowerOf2QuantizedSize;
+            long long len;
+            long long nlen;
+            long long bsonLen;
+            set<DiskLoc> recs;     // at most maxTrackedRecs entries
+            vector<string> errors; // non-empty means the range did not validate
+        };
+
+        /**
+         * Walks the record chains of one bucket of extents, filling in *out.  Runs on
+         * its own thread during a parallel validate.  Only reads the memory-mapped
+         * files, which cannot move because the validate command thread holds the
+         * database read lock for the duration of the scan.
+         */
+        void scanExtentRange(const string& ns,
+                             const ExtentManager* extentManager,
+                             const vector<ExtentInfo>* extents,
+                             bool full,
+                             size_t maxTrackedRecs,
+                             RecordScanResult* out) {
+            try {
+                for (size_t i = 0; i < extents->size(); i++) {
+                    DiskLoc cl = extentManager->getExtent( (*extents)[i].diskLoc )->firstRecord;
+                    while ( !cl.isNull() ) {
+                        out->n++;
+                        if ( out->recs.size() < maxTrackedRecs )
+                            out->recs.insert(cl);
+
+                        Record *r = extentManager->recordFor(cl);
+                        out->len += r->lengthWithHeaders();
+                        out->nlen += r->netLength();
+
+                        if ( r->lengthWithHeaders() ==
+                                NamespaceDetails::quantizeAllocationSpace
+                                    ( r->lengthWithHeaders() ) ) {
+                            ++out->nQuantizedSize;
+                        }
+
+                        if ( r->lengthWithHeaders() ==
+                                NamespaceDetails::quantizePowerOf2AllocationSpace
+                                    ( r->lengthWithHeaders() - 1 ) ) {
+                            ++out->nPowerOf2QuantizedSize;
+                        }
+
+                        if (full) {
+                            BSONObj obj = BSONObj::make(r);
+                            const Status status = validateBSON(obj.objdata(), obj.objsize());
+                            if (!status.isOK()) {
+                                out->nInvalid++;
+                                log() << "Invalid bson detected in " << ns
+                                      << ": " << status.reason();
+                            }
+                            else {
+                                out->bsonLen += obj.objsize();
+                            }
+                        }
+
+                        cl = extentManager->getNextRecordInExtent(cl);
+                    }
+                }
+                // stream progress so long validates are observable from the log
+                log() << "validate: finished extent range of " << ns
+                      << ": " << out->n << " objects, " << out->len << " bytes" << endl;
+            }
+            catch (const DBException& e) {
+                out->errors.push_back( str::stream() << "exception scanning extent range: "
+                                                     << e.what() );
+            }
+            catch (...) {
+                out->errors.push_back( "unknown exception scanning extent range" );
+            }
+        }
+
+        /**
+         * Validates one index on its own thread during a parallel validate.
+         * fullValidate only reads btree buckets, so concurrent traversals of
+         * different indexes are safe under the read lock held by the command.
+         */
+        void validateIndexWorker(IndexAccessMethod* iam,
+                                 const string& indexNs,
+                                 int64_t* numKeys,
+                                 string* error) {
+            try {
+                log() << "validating index " << indexNs << endl;
+                iam->validate(numKeys);
+            }
+            catch (const DBException& e) {
+                *error = e.what();
+            }
+            catch (...) {
+                *error = "unknown exception";
+            }
+        }
+
+    }
+
     class ValidateCmd : public Command {
     public:
         ValidateCmd() : Command( "validate" ) {}
@@ -48,7 +164,8 @@ namespace mongo {
         }
 
         virtual void help(stringstream& h) const { h << "Validate contents of a namespace by scanning its data structures for correctness.  Slow.\n"
-                                                        "Add full:true option to do a more thorough check"; }
+                                                        "Add full:true option to do a more thorough check\n"
+                                                        "Add parallel:<n> to spread the record scan and index validation over n threads"; }
 
         virtual LockType locktype() const { return READ; }
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -99,6 +216,17 @@ namespace mongo {
             const bool full = cmdObj["full"].trueValue();
             const bool scanData = full || cmdObj["scandata"].trueValue();
 
+            // {parallel: n} fans the record scan and index validation out over n
+            // threads working on disjoint extent ranges — the same partitioning the
+            // parallelCollectionScan command hands out.  Capped collections are
+            // always scanned serially because the out-of-order check depends on
+            // walking the record chain in collection order.
+            int parallel = cmdObj["parallel"].numberInt();
+            if ( parallel < 1 )
+                parallel = 1;
+            else if ( parallel > 64 )
+                parallel = 64;
+
             NamespaceDetails* nsd = collection->details();
 
             bool valid = true;
@@ -233,63 +361,111 @@ namespace mongo {
                     int outOfOrder = 0;
                     DiskLoc cl_last;
 
-                    DiskLoc cl;
-                    Runner::RunnerState state;
-                    auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
-                    while (Runner::RUNNER_ADVANCED == (state = runner->getNext(NULL, &cl))) {
-                        n++;
-
-                        if ( n < 1000000 )
-                            recs.insert(cl);
-                        if ( nsd->isCapped() ) {
-                            if ( cl < cl_last )
-                                outOfOrder++;
-                            cl_last = cl;
+                    const size_t maxTrackedRecs = 1000000;
+
+                    if ( parallel > 1 && !nsd->isCapped() ) {
+                        Database* db = cc().database();
+                        vector< vector<ExtentInfo> > buckets =
+                            partitionCollectionExtents( db, collection, parallel );
+
+                        vector<RecordScanResult> partials( buckets.size() );
+                        vector< boost::shared_ptr<boost::thread> > threads;
+                        for ( size_t i = 0; i < buckets.size(); i++ ) {
+                            threads.push_back( boost::shared_ptr<boost::thread>(
+                                new boost::thread( boost::bind( scanExtentRange,
+                                                                ns,
+                                                                &db->getExtentManager(),
+                                                                &buckets[i],
+                                                                full,
+                                                                maxTrackedRecs,
+                                                                &partials[i] ) ) ) );
                         }
-
-                        Record *r = cl.rec();
-                        len += r->lengthWithHeaders();
-                        nlen += r->netLength();
-                        
-                        if ( r->lengthWithHeaders() ==
-                                NamespaceDetails::quantizeAllocationSpace
-                                    ( r->lengthWithHeaders() ) ) {
-                            // Count the number of records having a size consistent with
-                            // the quantizeAllocationSpace quantization implementation.
-                            ++nQuantizedSize;
+                        for ( size_t i = 0; i < threads.size(); i++ ) {
+                            threads[i]->join();
                         }
-
-                        if ( r->lengthWithHeaders() ==
-                                NamespaceDetails::quantizePowerOf2AllocationSpace
-                                    ( r->lengthWithHeaders() - 1 ) ) {
-                            // Count the number of records having a size consistent with the
-                            // quantizePowerOf2AllocationSpace quantization implementation.
-                            // Because of SERVER-8311, power of 2 quantization is not idempotent and
-                            // r->lengthWithHeaders() - 1 must be checked instead of the record
-                            // length itself.
-                            ++nPowerOf2QuantizedSize;
+                        killCurrentOp.checkForInterrupt();
+
+                        for ( size_t i = 0; i < partials.size(); i++ ) {
+                            const RecordScanResult& p = partials[i];
+                            n += p.n;
+                            nInvalid += p.nInvalid;
+                            nQuantizedSize += p.nQuantizedSize;
+                            nPowerOf2QuantizedSize += p.nPowerOf2QuantizedSize;
+                            len += p.len;
+                            nlen += p.nlen;
+                            bsonLen += p.bsonLen;
+                            if ( recs.size() < maxTrackedRecs )
+                                recs.insert( p.recs.begin(), p.recs.end() );
+                            for ( size_t j = 0; j < p.errors.size(); j++ ) {
+                                errors << p.errors[j];
+                                valid = false;
+                            }
                         }
+                        if ( nInvalid > 0 ) {
+                            valid = false;
+                            errors << "invalid bson object detected (see logs for more info)";
+                        }
+                    }
+                    else {
+                        DiskLoc cl;
+                        Runner::RunnerState state;
+                        auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
+                        while (Runner::RUNNER_ADVANCED == (state = runner->getNext(NULL, &cl))) {
+                            n++;
+
+                            if ( n < 1000000 )
+                                recs.insert(cl);
+                            if ( nsd->isCapped() ) {
+                                if ( cl < cl_last )
+                                    outOfOrder++;
+                                cl_last = cl;
+                            }
 
-                        if (full){
-                            BSONObj obj = BSONObj::make(r);
-                            const Status status = validateBSON(obj.objdata(), obj.objsize());
-                            if (!status.isOK()) {
-                                valid = false;
-                                if (nInvalid == 0) // only log once;
-                                    errors << "invalid bson object detected (see logs for more info)";
+                            Record *r = cl.rec();
+                            len += r->lengthWithHeaders();
+                            nlen += r->netLength();
 
-                                nInvalid++;
-                                log() << "Invalid bson detected in " << ns
-                                      << ": " << status.reason();
+                            if ( r->lengthWithHeaders() ==
+                                    NamespaceDetails::quantizeAllocationSpace
+                                        ( r->lengthWithHeaders() ) ) {
+                                // Count the number of records having a size consistent with
+                                // the quantizeAllocationSpace quantization implementation.
+                                ++nQuantizedSize;
                             }
-                            else {
-                                bsonLen += obj.objsize();
+
+                            if ( r->lengthWithHeaders() ==
+                                    NamespaceDetails::quantizePowerOf2AllocationSpace
+                                        ( r->lengthWithHeaders() - 1 ) ) {
+                                // Count the number of records having a size consistent with the
+                                // quantizePowerOf2AllocationSpace quantization implementation.
+                                // Because of SERVER-8311, power of 2 quantization is not
+                                // idempotent and r->lengthWithHeaders() - 1 must be checked
+                                // instead of the record length itself.
+                                ++nPowerOf2QuantizedSize;
+                            }
+
+                            if (full){
+                                BSONObj obj = BSONObj::make(r);
+                                const Status status = validateBSON(obj.objdata(), obj.objsize());
+                                if (!status.isOK()) {
+                                    valid = false;
+                                    if (nInvalid == 0) // only log once;
+                                        errors << "invalid bson object detected "
+                                                  "(see logs for more info)";
+
+                                    nInvalid++;
+                                    log() << "Invalid bson detected in " << ns
+                                          << ": " << status.reason();
+                                }
+                                else {
+                                    bsonLen += obj.objsize();
+                                }
                             }
                         }
-                    }
-                    if (Runner::RUNNER_EOF != state) {
-                        // TODO: more descriptive logging.
-                        warning() << "Internal error while reading collection " << ns << endl;
+                        if (Runner::RUNNER_EOF != state) {
+                            // TODO: more descriptive logging.
+                            warning() << "Internal error while reading collection " << ns << endl;
+                        }
                     }
                     if ( nsd->isCapped() && !nsd->capLooped() ) {
                         result.append("cappedOutOfOrder", outOfOrder);
@@ -379,18 +555,60 @@ namespace mongo {
 
                     result.append("nIndexes", indexCatalog->numIndexesReady() );
                     BSONObjBuilder indexes; // not using subObjStart to be exception safe
+
+                    vector<IndexDescriptor*> descriptors;
                     IndexCatalog::IndexIterator i = indexCatalog->getIndexIterator(false);
                     while( i.more() ) {
-                        IndexDescriptor* descriptor = i.next();
-                        log() << "validating index " << descriptor->indexNamespace() << endl;
-                        IndexAccessMethod* iam = indexCatalog->getIndex( descriptor );
-                        verify( iam );
-
-                        int64_t keys;
-                        iam->validate(&keys);
-                        indexes.appendNumber(descriptor->indexNamespace(),
-                                             static_cast<long long>(keys));
-                        idxn++;
+                        descriptors.push_back( i.next() );
+                    }
+
+                    if ( parallel > 1 ) {
+                        // validate the indexes' btrees concurrently, one thread each
+                        vector<int64_t> keyCounts( descriptors.size(), 0 );
+                        vector<string> indexErrors( descriptors.size() );
+                        vector< boost::shared_ptr<boost::thread> > threads;
+                        for ( size_t j = 0; j < descriptors.size(); j++ ) {
+                            IndexAccessMethod* iam = indexCatalog->getIndex( descriptors[j] );
+                            verify( iam );
+                            threads.push_back( boost::shared_ptr<boost::thread>(
+                                new boost::thread( boost::bind(
+                                        validateIndexWorker,
+                                        iam,
+                                        descriptors[j]->indexNamespace(),
+                                        &keyCounts[j],
+                                        &indexErrors[j] ) ) ) );
+                        }
+                        for ( size_t j = 0; j < threads.size(); j++ ) {
+                            threads[j]->join();
+                        }
+                        killCurrentOp.checkForInterrupt();
+
+                        for ( size_t j = 0; j < descriptors.size(); j++ ) {
+                            if ( !indexErrors[j].empty() ) {
+                                errors << ( "exception validating index "
+                                            + descriptors[j]->indexNamespace()
+                                            + ": " + indexErrors[j] );
+                                valid = false;
+                                continue;
+                            }
+                            indexes.appendNumber(descriptors[j]->indexNamespace(),
+                                                 static_cast<long long>(keyCounts[j]));
+                            idxn++;
+                        }
+                    }
+                    else {
+                        for ( size_t j = 0; j < descriptors.size(); j++ ) {
+                            IndexDescriptor* descriptor = descriptors[j];
+                            log() << "validating index " << descriptor->indexNamespace() << endl;
+                            IndexAccessMethod* iam = indexCatalog->getIndex( descriptor );
+                            verify( iam );
+
+                            int64_t keys;
+                            iam->validate(&keys);
+                            indexes.appendNumber(descriptor->indexNamespace(),
+                                                 static_cast<long long>(keys));
+                            idxn++;
+                        }
                     }
                     result.append("keysPerIndex", indexes.done());
                 }
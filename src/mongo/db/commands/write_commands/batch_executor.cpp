@@ -607,7 +607,11 @@ namespace mongo {
     static void singleInsert( const BatchItemRef& insertItem,
                               const BSONObj& normalInsert,
                               Collection* collection,
-                              WriteOpResult* result );
+                              WriteOpResult* result,
+                              std::vector<BSONObj>* groupedInserts );
+
+    static void flushGroupedInserts( const std::string& ns,
+                                     std::vector<BSONObj>* groupedInserts );
 
     static void singleCreateIndex( const BatchItemRef& insertItem,
                                    const BSONObj& normalInsert,
@@ -781,6 +785,14 @@ namespace mongo {
                     // Perform writes inside write lock
                     //
 
+                    // Oplog entries for the documents written under this lock
+                    // acquisition, logged as one group when the sub-batch ends.
+                    // Flushed early every few MB so journal commit checks stay
+                    // about as frequent as they were when done per document.
+                    vector<BSONObj> groupedInserts;
+                    const int maxGroupedInsertBytes = 4 * 1024 * 1024;
+                    int groupedInsertBytes = 0;
+
                     while ( collection
                             && currInsertItem->getItemIndex()
                                < static_cast<int>( request.sizeWriteOps() ) ) {
@@ -802,7 +814,14 @@ namespace mongo {
                             singleInsert( *currInsertItem,
                                           normalInsertDoc,
                                           collection,
-                                          &currResult );
+                                          &currResult,
+                                          &groupedInserts );
+
+                            groupedInsertBytes += normalInsertDoc.objsize();
+                            if ( groupedInsertBytes >= maxGroupedInsertBytes ) {
+                                flushGroupedInserts( nss.ns(), &groupedInserts );
+                                groupedInsertBytes = 0;
+                            }
                         }
                         else {
                             // Try the create index
@@ -832,6 +851,10 @@ namespace mongo {
                                                                 + 1 ) );
                         currResult.reset();
                     }
+
+                    // Documents written before a fault or error still get
+                    // their oplog entries, written while we hold the lock.
+                    flushGroupedInserts( nss.ns(), &groupedInserts );
                 }
 
             } // END WRITE LOCK
@@ -976,7 +999,8 @@ namespace mongo {
     static void singleInsert( const BatchItemRef& insertItem,
                               const BSONObj& normalInsert,
                               Collection* collection,
-                              WriteOpResult* result ) {
+                              WriteOpResult* result,
+                              std::vector<BSONObj>* groupedInserts ) {
 
         const string& insertNS = insertItem.getRequest()->getNS();
 
@@ -991,8 +1015,10 @@ namespace mongo {
                 result->error = toWriteError( status.getStatus() );
             }
             else {
-                logOp( "i", insertNS.c_str(), normalInsert );
-                getDur().commitIfNeeded();
+                // The oplog entry and journal commit check are deferred so
+                // the whole sub-batch can be logged as one group - see
+                // flushGroupedInserts().
+                groupedInserts->push_back( normalInsert );
                 result->stats.n = 1;
             }
         }
@@ -1010,6 +1036,24 @@ namespace mongo {
 
     }
 
+    /**
+     * Writes the grouped oplog entries for a sub-batch of inserts and lets the
+     * journal commit if it's accumulated enough.  Must be called inside the
+     * write lock that covered the inserts, before it is released.
+     */
+    static void flushGroupedInserts( const string& ns,
+                                     std::vector<BSONObj>* groupedInserts ) {
+
+        if ( groupedInserts->empty() )
+            return;
+
+        Lock::assertWriteLocked( ns );
+
+        logInsertOps( ns.c_str(), *groupedInserts );
+        getDur().commitIfNeeded();
+        groupedInserts->clear();
+    }
+
     /**
      * Perform a single index insert into a collection.  Requires the index descriptor be
      * preprocessed and the collection already has been created.
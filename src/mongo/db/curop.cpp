@@ -34,6 +34,10 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/matcher.h"
+#include "mongo/db/op_deadline_monitor.h"
+#include "mongo/db/stats/index_advisor.h"
+#include "mongo/db/stats/operation_latency_histogram.h"
+#include "mongo/db/stats/query_shape_profiler.h"
 #include "mongo/util/fail_point_service.h"
 
 namespace mongo {
@@ -61,6 +65,7 @@ namespace mongo {
             _client->_curOp = this;
         _start = 0;
         _active = false;
+        _deadlineRegistered = false;
         _reset();
         _op = 0;
         _opNum = _nextOpNum++;
@@ -78,6 +83,11 @@ namespace mongo {
         _end = 0;
         _maxTimeMicros = 0;
         _maxTimeTracker.reset();
+        if (_deadlineRegistered) {
+            opDeadlineMonitor.deregisterDeadline(this);
+            _deadlineRegistered = false;
+        }
+        _maxTimeExpired.store(0);
         _message = "";
         _progressMeter.finished();
         _killPending.store(0);
@@ -85,6 +95,8 @@ namespace mongo {
         _numYields = 0;
         _expectedLatencyMs = 0;
         _lockStat.reset();
+        _memAccounted.store(0);
+        _memPeakAccounted = 0;
     }
 
     void CurOp::reset() {
@@ -92,6 +104,7 @@ namespace mongo {
         _start = 0;
         _opNum = _nextOpNum++;
         _ns[0] = 0;
+        _nsi = InternedString();
         _debug.reset();
         _query.reset();
         _active = true; // this should be last for ui clarity
@@ -164,6 +177,11 @@ namespace mongo {
     }
 
     CurOp::~CurOp() {
+        if (_deadlineRegistered) {
+            opDeadlineMonitor.deregisterDeadline(this);
+            _deadlineRegistered = false;
+        }
+
         killCurrentOp.notifyAllWaiters();
 
         if ( _wrapped ) {
@@ -175,6 +193,18 @@ namespace mongo {
 
     void CurOp::setNS( const StringData& ns ) {
         ns.substr( 0, Namespace::MaxNsLen ).copyTo( _ns, true );
+        _internNS();
+    }
+
+    void CurOp::_internNS() {
+        // Interning here, outside any stats mutex, lets Top key its usage map by
+        // a stable handle instead of rehashing the namespace per operation.
+        // "?" placeholder namespaces are per-op noise; don't fill the table
+        // with them.
+        if ( _ns[0] && _ns[0] != '?' )
+            _nsi = internString( _ns );
+        else
+            _nsi = InternedString();
     }
 
 
@@ -187,6 +217,7 @@ namespace mongo {
             // operation is assigned a start time.
             if (_maxTimeMicros > 0) {
                 _maxTimeTracker.setTimeLimit(_start, _maxTimeMicros);
+                _armDeadline();
             }
         }
     }
@@ -196,6 +227,7 @@ namespace mongo {
 
         strncpy( _ns, context->ns(), Namespace::MaxNsLen);
         _ns[Namespace::MaxNsLen] = 0;
+        _internNS();
 
         _dbprofile = std::max( context->_db ? context->_db->getProfilingLevel() : 0 , _dbprofile );
     }
@@ -207,7 +239,13 @@ namespace mongo {
         if ( _client ) {
             const LockState& ls = _client->lockState();
             verify( ls.threadState() );
-            Top::global.record( _ns , _op , ls.hasAnyWriteLock() ? 1 : -1 , micros , _isCommand );
+            if ( _nsi.isEmpty() )
+                Top::global.record( _ns , _op , ls.hasAnyWriteLock() ? 1 : -1 , micros , _isCommand );
+            else
+                Top::global.record( _nsi , _op , ls.hasAnyWriteLock() ? 1 : -1 , micros , _isCommand );
+            LatencyStats::global.record( _ns , _op , _isCommand , micros );
+            QueryShapeProfiler::global.record( *this , _isCommand , micros );
+            IndexAdvisor::global.record( *this , _debug , _isCommand , micros );
         }
     }
 
@@ -268,6 +306,10 @@ namespace mongo {
             b.append("killPending", true);
 
         b.append( "numYields" , _numYields );
+
+        if ( _memAccounted.load() )
+            b.appendNumber( "memUsed" , _memAccounted.load() );
+
         b.append( "lockStats" , _lockStat.report() );
 
         return b.obj();
@@ -308,6 +350,11 @@ namespace mongo {
 
         if (_maxTimeMicros == 0) {
             // 0 is "allow to run indefinitely".
+            if (_deadlineRegistered) {
+                opDeadlineMonitor.deregisterDeadline(this);
+                _deadlineRegistered = false;
+            }
+            _maxTimeExpired.store(0);
             return;
         }
 
@@ -317,9 +364,16 @@ namespace mongo {
         // enabling the tracker.
         if (isStarted()) {
             _maxTimeTracker.setTimeLimit(startTime(), _maxTimeMicros);
+            _armDeadline();
         }
     }
 
+    void CurOp::_armDeadline() {
+        _maxTimeExpired.store(0);
+        opDeadlineMonitor.registerDeadline(this, startTime() + _maxTimeMicros);
+        _deadlineRegistered = true;
+    }
+
     bool CurOp::maxTimeHasExpired() {
         if (MONGO_FAIL_POINT(maxTimeNeverTimeOut)) {
             return false;
@@ -327,6 +381,11 @@ namespace mongo {
         if (_maxTimeMicros > 0 && MONGO_FAIL_POINT(maxTimeAlwaysTimeOut)) {
             return true;
         }
+        if (_deadlineRegistered) {
+            // Deadline enforcement is delegated to the OpDeadlineMonitor thread, which flips
+            // _maxTimeExpired when the limit passes; the hot path only pays for this load.
+            return _maxTimeExpired.loadRelaxed() != 0;
+        }
         return _maxTimeTracker.checkTimeLimit();
     }
 
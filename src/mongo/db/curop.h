@@ -37,6 +37,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/structure/catalog/namespace.h"
 #include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/interned_string.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/time_support.h"
@@ -167,6 +168,7 @@ namespace mongo {
         bool fastmodinsert;  // upsert of an $operation. builds a default object
         bool upsert;         // true if the update actually did an insert
         int keyUpdates;
+        long long planningTimeMicros; // time spent in QueryPlanner::plan (0 if no planning ran)
         ThreadSafeString planSummary; // a brief string describing the query solution
 
         // New Query Framework debugging/profiling info
@@ -232,11 +234,22 @@ namespace mongo {
          * Checks whether this operation has been running longer than its time limit.  Returns
          * false if not, or if the operation has no time limit.
          *
+         * Once a deadline has been registered with the OpDeadlineMonitor this only reads the
+         * per-op expiration word flipped by the monitor thread, so it is cheap enough to call
+         * per document.
+         *
          * Note that KillCurrentOp objects are responsible for interrupting CurOp objects that
          * have exceeded their allotted time; CurOp objects do not interrupt themselves.
          */
         bool maxTimeHasExpired();
 
+        /**
+         * Called by the OpDeadlineMonitor thread when this operation's time limit passes.
+         * Safe to call from another thread; only flips an atomic word observed by
+         * maxTimeHasExpired().
+         */
+        void markMaxTimeExpired() { _maxTimeExpired.store(1); }
+
         /**
          * Returns the number of microseconds remaining for this operation's time limit, or the
          * special value 0 if the operation has no time limit.
@@ -274,6 +287,24 @@ namespace mongo {
         }
         int elapsedSeconds() { return elapsedMillis() / 1000; }
 
+        //
+        // Methods for per-op memory accounting.
+        //
+
+        /**
+         * Adjusts the number of bytes currently buffered on behalf of this operation
+         * (sort and hash stage buffers and the like).  Stages report deltas as their
+         * buffers grow and shrink; the running total shows up as "memUsed" in
+         * db.currentOp().  Atomic because currentOp reads it from another thread.
+         */
+        void adjustMemAccounted(long long bytes) {
+            const long long now = _memAccounted.addAndFetch(bytes);
+            if (now > _memPeakAccounted)
+                _memPeakAccounted = now; // only this op's thread writes the peak
+        }
+        long long memAccounted() const { return _memAccounted.load(); }
+        long long memPeakAccounted() const { return _memPeakAccounted; }
+
         void setQuery(const BSONObj& query) { _query.set( query ); }
         Client * getClient() const { return _client; }
         
@@ -328,6 +359,7 @@ namespace mongo {
     private:
         friend class Client;
         void _reset();
+        void _internNS();
 
         static AtomicUInt _nextOpNum;
         Client * _client;
@@ -342,6 +374,9 @@ namespace mongo {
         int _dbprofile;                  // 0=off, 1=slow, 2=all
         AtomicUInt _opNum;               // todo: simple being "unsigned" may make more sense here
         char _ns[Namespace::MaxNsLen+2];
+        // interned copy of _ns, set alongside it; empty for "?" placeholder
+        // namespaces so stats recording falls back to the raw characters
+        InternedString _nsi;
         HostAndPort _remote;             // CAREFUL here with thread safety
         CachedBSONObj _query;            // CachedBSONObj is thread safe
         OpDebug _debug;
@@ -350,6 +385,11 @@ namespace mongo {
         AtomicInt32 _killPending;
         int _numYields;
         LockStat _lockStat;
+
+        // Bytes currently buffered on behalf of this op and its high-water mark;
+        // see adjustMemAccounted().  The peak is owner-thread only.
+        AtomicInt64 _memAccounted;
+        long long _memPeakAccounted;
         // _notifyList is protected by the global killCurrentOp's mtx.
         std::vector<bool*> _notifyList;
         
@@ -361,6 +401,17 @@ namespace mongo {
         // Time limit for this operation.  0 if the operation has no time limit.
         uint64_t _maxTimeMicros;
 
+        // Nonzero once the OpDeadlineMonitor thread has observed this operation's deadline
+        // passing.  Written by the monitor thread, read (relaxed) by the owning thread.
+        AtomicInt32 _maxTimeExpired;
+
+        // Whether this operation's deadline is (or was) registered with the
+        // OpDeadlineMonitor.  Owner-thread only.
+        bool _deadlineRegistered;
+
+        /** Registers this operation's deadline with the OpDeadlineMonitor. */
+        void _armDeadline();
+
         /** Nested class that implements tracking of a time limit for a CurOp object. */
         class MaxTimeTracker {
             MONGO_DISALLOW_COPYING(MaxTimeTracker);
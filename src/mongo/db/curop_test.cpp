@@ -77,6 +77,17 @@ namespace mongo {
             ASSERT_TRUE(curOp.maxTimeHasExpired());
         }
 
+        // Clearing the time limit also clears a previously recorded expiration.
+        TEST(TimeHasExpired, ResetOnClear) {
+            CurOp curOp(NULL);
+            curOp.setMaxTimeMicros(intervalShort);
+            curOp.ensureStarted();
+            sleepmicros(intervalLong);
+            ASSERT_TRUE(curOp.maxTimeHasExpired());
+            curOp.setMaxTimeMicros(0);
+            ASSERT_FALSE(curOp.maxTimeHasExpired());
+        }
+
         // Short operation + long timeout => time should not expire.
         TEST(TimeHasExpired, NegSimple) {
             CurOp curOp(NULL);
@@ -32,6 +32,7 @@
 
 #include "mongo/db/d_concurrency.h"
 
+#include "mongo/base/parse_number.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
@@ -39,6 +40,7 @@
 #include "mongo/db/dur.h"
 #include "mongo/db/lockstat.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/server.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/mapsf.h"
@@ -56,14 +58,16 @@
 
 #define MONGOD_CONCURRENCY_LEVEL_GLOBAL 0
 #define MONGOD_CONCURRENCY_LEVEL_DB 1
+#define MONGOD_CONCURRENCY_LEVEL_COLLECTION 2
 
 #ifndef MONGOD_CONCURRENCY_LEVEL
 #define MONGOD_CONCURRENCY_LEVEL MONGOD_CONCURRENCY_LEVEL_DB
 #endif
 
-namespace mongo { 
+namespace mongo {
 
     static const bool DB_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_DB );
+    static const bool COLLECTION_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_COLLECTION );
 
     inline LockState& lockState() { 
         return cc().lockState();
@@ -95,6 +99,9 @@ namespace mongo {
     typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMap;
     static DBLocksMap dblocks;
 
+    /* ns->lock, for collection-level locking.  Like dblocks these are never deleted. */
+    static DBLocksMap collLocks;
+
     /* we don't want to touch dblocks too much as a mutex is involved.  thus party for that, 
        this is here...
     */
@@ -192,12 +199,23 @@ namespace mongo {
             q.unlock_W(); 
         }
 
-        // todo timing stats? : 
+        // todo timing stats? :
         void W_to_R()                        { q.W_to_R(); }
         void R_to_W()                        { q.R_to_W(); }
         bool w_to_X() { return q.w_to_X(); }
         void X_to_w() { q.X_to_w(); }
 
+        // scheduling policy tunables; see the qlockWriterBatchSize and
+        // qlockReaderAdmissionLimit server parameters below
+        void setMaxConsecutiveQueueJumpingWrites(int n) {
+            q.setMaxConsecutiveQueueJumpingWrites(n);
+        }
+        int getMaxConsecutiveQueueJumpingWrites() {
+            return q.getMaxConsecutiveQueueJumpingWrites();
+        }
+        void setReaderAdmissionLimit(int n) { q.setReaderAdmissionLimit(n); }
+        int getReaderAdmissionLimit() { return q.getReaderAdmissionLimit(); }
+
     private:
         void _unlock_R() {
             wassert( threadState() == 'R' );
@@ -210,6 +228,75 @@ namespace mongo {
     LockStat* Lock::globalLockStat() {
         return &qlk.stats;
     }
+
+    namespace {
+        /** how many queue-jumping W grants in a row before waiting readers get a turn.
+            0 means unlimited (the pre-existing fully greedy behavior). */
+        class QLockWriterBatchSizeSetting : public ServerParameter {
+        public:
+            QLockWriterBatchSizeSetting() :
+                ServerParameter(ServerParameterSet::getGlobal(), "qlockWriterBatchSize") {}
+
+            virtual void append(BSONObjBuilder& b, const std::string& name) {
+                b << name << qlk.getMaxConsecutiveQueueJumpingWrites();
+            }
+
+            virtual Status set(const BSONElement& newValueElement) {
+                int newValue;
+                if (!newValueElement.coerce(&newValue) || newValue < 0)
+                    return Status(ErrorCodes::BadValue, str::stream() <<
+                                  "Invalid value for qlockWriterBatchSize: " << newValueElement);
+                qlk.setMaxConsecutiveQueueJumpingWrites(newValue);
+                return Status::OK();
+            }
+
+            virtual Status setFromString(const std::string& str) {
+                int newValue;
+                Status status = parseNumberFromString(str, &newValue);
+                if (!status.isOK())
+                    return status;
+                if (newValue < 0)
+                    return Status(ErrorCodes::BadValue, mongoutils::str::stream() <<
+                                  "Invalid value for qlockWriterBatchSize: " << newValue);
+                qlk.setMaxConsecutiveQueueJumpingWrites(newValue);
+                return Status::OK();
+            }
+        } qlockWriterBatchSizeSetting;
+
+        /** how many readers may be admitted while a W lock is waiting before the
+            group is closed.  0 means unlimited. */
+        class QLockReaderAdmissionLimitSetting : public ServerParameter {
+        public:
+            QLockReaderAdmissionLimitSetting() :
+                ServerParameter(ServerParameterSet::getGlobal(), "qlockReaderAdmissionLimit") {}
+
+            virtual void append(BSONObjBuilder& b, const std::string& name) {
+                b << name << qlk.getReaderAdmissionLimit();
+            }
+
+            virtual Status set(const BSONElement& newValueElement) {
+                int newValue;
+                if (!newValueElement.coerce(&newValue) || newValue < 0)
+                    return Status(ErrorCodes::BadValue, str::stream() <<
+                                  "Invalid value for qlockReaderAdmissionLimit: "
+                                  << newValueElement);
+                qlk.setReaderAdmissionLimit(newValue);
+                return Status::OK();
+            }
+
+            virtual Status setFromString(const std::string& str) {
+                int newValue;
+                Status status = parseNumberFromString(str, &newValue);
+                if (!status.isOK())
+                    return status;
+                if (newValue < 0)
+                    return Status(ErrorCodes::BadValue, mongoutils::str::stream() <<
+                                  "Invalid value for qlockReaderAdmissionLimit: " << newValue);
+                qlk.setReaderAdmissionLimit(newValue);
+                return Status::OK();
+            }
+        } qlockReaderAdmissionLimitSetting;
+    }
     
     int Lock::isLocked() {
         return threadState();
@@ -270,6 +357,9 @@ namespace mongo {
     bool Lock::dbLevelLockingEnabled() {
         return DB_LEVEL_LOCKING_ENABLED;
     }
+    bool Lock::collectionLevelLockingEnabled() {
+        return COLLECTION_LEVEL_LOCKING_ENABLED;
+    }
 
     RWLockRecursive &Lock::ParallelBatchWriterMode::_batchLock = *(new RWLockRecursive("special"));
     void Lock::ParallelBatchWriterMode::iAmABatchParticipant() {
@@ -538,7 +628,7 @@ namespace mongo {
             DBLocksMap::ref r(dblocks);
             WrapperForRWLock*& lock = r[db];
             if( lock == 0 )
-                lock = new WrapperForRWLock(db);
+                lock = new WrapperForRWLock(db, COLLECTION_LEVEL_LOCKING_ENABLED);
             ls.lockedOther( db , 1 , lock );
         }
         else { 
@@ -728,7 +818,7 @@ namespace mongo {
             DBLocksMap::ref r(dblocks);
             WrapperForRWLock*& lock = r[db];
             if( lock == 0 )
-                lock = new WrapperForRWLock(db);
+                lock = new WrapperForRWLock(db, COLLECTION_LEVEL_LOCKING_ENABLED);
             ls.lockedOther( db , -1 , lock );
         }
         else { 
@@ -740,6 +830,100 @@ namespace mongo {
         _weLocked = ls.otherLock();
     }
 
+    Lock::CollectionWrite::CollectionWrite( const StringData& ns )
+        : ScopedLock( 'w' ), _locked_w(false), _dbLocked(0), _collLocked(0), _what(ns.toString()) {
+        lockCollection( _what );
+    }
+
+    Lock::CollectionWrite::~CollectionWrite() {
+        unlockCollection();
+    }
+
+    void Lock::CollectionWrite::_tempRelease() {
+        unlockCollection();
+    }
+    void Lock::CollectionWrite::_relock() {
+        lockCollection( _what );
+    }
+
+    void Lock::CollectionWrite::lockCollection(const string& ns) {
+        fassert( 18501, !ns.empty() );
+        LockState& ls = lockState();
+
+        StringData db = nsToDatabaseSubstring( ns );
+        size_t dot = ns.find( '.' );
+        StringData coll = dot == string::npos ? StringData() : StringData( ns ).substr( dot + 1 );
+
+        // Cases we don't (yet) handle at collection granularity: writes to db-level metadata
+        // (system.*), nestable dbs, db-only namespaces, and nested lock states.  For those we
+        // degrade to a full db lock, which is always correct.
+        if ( !COLLECTION_LEVEL_LOCKING_ENABLED ||
+             coll.empty() ||
+             coll.startsWith( "system." ) ||
+             n( db ) != notnestable ||
+             ls.threadState() != 0 ) {
+            _fallback.reset( new DBWrite( ns ) );
+            return;
+        }
+
+        Acquiring a(this,ls);
+        _locked_w = false;
+        _dbLocked = 0;
+        _collLocked = 0;
+
+        massert( 18502 , "can't get a CollectionWrite while having a read lock" , ! ls.hasAnyReadLock() );
+
+        // database lock in intent-write mode first (same ordering as DBWrite::lockDB);
+        // bookkept like a write so assertWriteLocked() on the db holds for catalog updates
+        // done on our behalf (extent/record allocation etc)
+        {
+            DBLocksMap::ref r(dblocks);
+            WrapperForRWLock*& lock = r[db];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(db, COLLECTION_LEVEL_LOCKING_ENABLED);
+            ls.lockedOther( db , 1 , lock );
+        }
+        ls.otherLock()->lock_intent();
+        _dbLocked = ls.otherLock();
+
+        // then the global intent lock
+        qlk.lock_w();
+        _locked_w = true;
+
+        // then the collection itself, exclusive
+        WrapperForRWLock* collLock;
+        {
+            DBLocksMap::ref r(collLocks);
+            WrapperForRWLock*& lock = r[ns];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(ns);
+            collLock = lock;
+        }
+        collLock->lock();
+        _collLocked = collLock;
+    }
+
+    void Lock::CollectionWrite::unlockCollection() {
+        if( _fallback ) {
+            _fallback.reset();
+            return;
+        }
+        if( _collLocked ) {
+            recordTime();  // for lock stats
+            _collLocked->unlock();
+            _collLocked = 0;
+        }
+        if( _locked_w ) {
+            qlk.unlock_w();
+            _locked_w = false;
+        }
+        if( _dbLocked ) {
+            lockState().unlockedOther();
+            _dbLocked->unlock_intent();
+            _dbLocked = 0;
+        }
+    }
+
     Lock::DBWrite::UpgradeToExclusive::UpgradeToExclusive() {
         fassert( 16187, lockState().threadState() == 'w' );
 
@@ -826,7 +1010,7 @@ namespace mongo {
             {
                 BSONObjBuilder ttt( t.subobjStart( "currentQueue" ) );
                 int w=0, r=0;
-                Client::recommendedYieldMicros( &w , &r, true );
+                Client::recommendedYieldMicros( &w , &r );
                 ttt.append( "total" , w + r );
                 ttt.append( "readers" , r );
                 ttt.append( "writers" , w );
@@ -60,8 +60,9 @@ namespace mongo {
         static void assertAtLeastReadLocked(const StringData& ns);
         static void assertWriteLocked(const StringData& ns);
 
-        static bool dbLevelLockingEnabled(); 
-        
+        static bool dbLevelLockingEnabled();
+        static bool collectionLevelLockingEnabled();
+
         static LockStat* globalLockStat();
         static LockStat* nestableLockStat( Nestable db );
 
@@ -109,6 +110,9 @@ namespace mongo {
             /** @return micros since we started acquiring */
             long long acquireFinished( LockStat* stat );
 
+            /** 'r','w','R','W' : what this lock acquires/holds */
+            char lockType() const { return _type; }
+
             // Accrue elapsed lock time since last we called reset
             void recordTime();
             // Start recording a new period, starting now()
@@ -205,7 +209,37 @@ namespace mongo {
             bool _nested;
         };
 
-        // lock this database for reading. do not shared_lock globally first, that is handledin herein. 
+        /**
+         * Write lock a single collection: intent ('w') at the global level, intent-write on the
+         * database lock, exclusive on the collection itself.  Writers of different collections in
+         * the same database can then proceed in parallel, while whole-db DBWrite/DBRead holders
+         * still conflict with us at the database lock.
+         *
+         * Only engaged when built with MONGOD_CONCURRENCY_LEVEL_COLLECTION; otherwise (and for
+         * nestable dbs, db-only namespaces, system collections, and nested lock states) this
+         * degrades to a plain DBWrite.
+         */
+        class CollectionWrite : public ScopedLock {
+            void lockCollection(const string& ns);
+            void unlockCollection();
+
+        protected:
+            void _tempRelease();
+            void _relock();
+
+        public:
+            CollectionWrite(const StringData& ns);
+            virtual ~CollectionWrite();
+
+        private:
+            bool _locked_w;               // global intent
+            WrapperForRWLock* _dbLocked;  // db lock held in intent mode
+            WrapperForRWLock* _collLocked; // collection lock held exclusive
+            scoped_ptr<DBWrite> _fallback; // set when we degraded to db-level locking
+            const string _what;
+        };
+
+        // lock this database for reading. do not shared_lock globally first, that is handledin herein.
         class DBRead : public ScopedLock {
             void lockTop(LockState&);
             void lockNestable(Nestable db);
@@ -32,14 +32,11 @@
 
 #include "mongo/db/d_globals.h"
 
-#include "mongo/db/clientcursor.h"
 #include "mongo/util/concurrency/rwlock.h"
 
-namespace mongo { 
+namespace mongo {
 
-    DGlobals::DGlobals() :
-        clientCursorMonitor( *(new ClientCursorMonitor()) )
-    {
+    DGlobals::DGlobals() {
     }
 
     DGlobals d;
@@ -38,14 +38,9 @@
 namespace mongo { 
 
     class RWLockRecursive;
-    class ClientCursorMonitor;
 
-    struct DGlobals : boost::noncopyable { 
+    struct DGlobals : boost::noncopyable {
         DGlobals();
-
-        // these are intentionally never deleted:
-        ClientCursorMonitor& clientCursorMonitor;
-
     };
 
     extern DGlobals d;
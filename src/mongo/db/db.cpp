@@ -62,14 +62,17 @@
 #include "mongo/db/log_process_details.h"
 #include "mongo/db/mongod_options.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/plan_cache_persistence.h"
 #include "mongo/db/range_deleter_service.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/repl_start.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/repl/replication_server_status.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/restapi.h"
 #include "mongo/db/startup_warnings.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/metrics_stream.h"
 #include "mongo/db/stats/snapshots.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/ttl.h"
@@ -79,10 +82,13 @@
 #include "mongo/util/background.h"
 #include "mongo/util/cmdline_utils/censor_cmdline.h"
 #include "mongo/util/concurrency/task.h"
+#include "mongo/util/concurrency/work_stealing_pool.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/exception_filter_win32.h"
+#include "mongo/util/file.h"
 #include "mongo/util/file_allocator.h"
 #include "mongo/util/net/message_server.h"
+#include "mongo/util/numa.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/ntservice.h"
 #include "mongo/util/options_parser/startup_options.h"
@@ -92,6 +98,8 @@
 #include "mongo/util/stacktrace.h"
 #include "mongo/util/startup_test.h"
 #include "mongo/util/text.h"
+#include "mongo/util/timer.h"
+#include "mongo/util/timer_wheel.h"
 #include "mongo/util/version_reporting.h"
 
 #if !defined(_WIN32)
@@ -358,6 +366,89 @@ namespace mongo {
         }
     }
 
+    // Threads used to pull database catalog files into the OS cache before the
+    // serial startup checks; 0 disables prefetching.
+    MONGO_EXPORT_SERVER_PARAMETER(startupWarmCatalogThreads, int, 8);
+
+    /**
+     * Reads the first 'len' bytes of 'file' (or the whole file if 'len' is 0)
+     * to pull its pages into the OS cache.  Purely advisory; errors are only
+     * logged.
+     */
+    static void prefetchFile(const boost::filesystem::path& file, fileofs len) {
+        try {
+            File f;
+            f.open(file.string().c_str(), /*readOnly*/ true);
+            if (!f.is_open() || f.bad())
+                return;
+
+            const unsigned chunkSize = 4 * 1024 * 1024;
+            boost::scoped_array<char> buf(new char[chunkSize]);
+
+            fileofs remaining = f.len();
+            if (len > 0 && len < remaining)
+                remaining = len;
+
+            fileofs offset = 0;
+            while (remaining > 0 && !f.bad()) {
+                unsigned n = remaining > chunkSize ? chunkSize
+                                                   : static_cast<unsigned>(remaining);
+                f.read(offset, buf.get(), n);
+                offset += n;
+                remaining -= n;
+            }
+        }
+        catch (const std::exception& e) {
+            LOG(1) << "startup prefetch of " << file.string() << " failed: "
+                   << e.what() << endl;
+        }
+    }
+
+    /**
+     * Pulls every database's namespace file, and the headers of its data
+     * files, into the OS cache with a worker pool.  The startup checks below
+     * (and the index rebuilder after them) then page-fault against warm cache
+     * instead of cold disk.  Those checks run serially under the global lock
+     * and do small reads scattered across one set of files per database, so
+     * with many databases on rotating disks the seeks, not the checks, are
+     * where boot time goes; doing the reads in parallel up front collapses
+     * that.
+     */
+    static void prefetchCatalogFiles(const vector<string>& dbNames) {
+        if (startupWarmCatalogThreads <= 0 || dbNames.empty())
+            return;
+
+        Timer t;
+        int nThreads = startupWarmCatalogThreads;
+        if (nThreads > static_cast<int>(dbNames.size()))
+            nThreads = static_cast<int>(dbNames.size());
+        WorkStealingPool pool(nThreads);
+
+        for (vector<string>::const_iterator it = dbNames.begin(); it != dbNames.end(); ++it) {
+            boost::filesystem::path dbDir(storageGlobalParams.dbpath);
+            if (storageGlobalParams.directoryperdb)
+                dbDir /= *it;
+
+            // The whole namespace file: the version checks and the index
+            // rebuilder walk most of it.
+            pool.schedule(prefetchFile, dbDir / (*it + ".ns"), fileofs(0));
+
+            // Just the headers of the data files; the version checks read the
+            // first header and the extent manager opens the rest lazily.
+            for (int n = 0; ; ++n) {
+                string fileName = str::stream() << *it << "." << n;
+                boost::filesystem::path dataFile = dbDir / fileName;
+                if (!boost::filesystem::exists(dataFile))
+                    break;
+                pool.schedule(prefetchFile, dataFile, fileofs(8192));
+            }
+        }
+
+        pool.join();
+        LOG(1) << "prefetched catalog files for " << dbNames.size() << " databases in "
+               << t.millis() << "ms" << endl;
+    }
+
     // ran at startup.
     static void repairDatabasesAndCheckVersion(bool shouldClearNonLocalTmpCollections) {
         //        LastError * le = lastError.get( true );
@@ -366,6 +457,11 @@ namespace mongo {
         Lock::GlobalWrite lk;
         vector< string > dbNames;
         getDatabaseNames( dbNames );
+
+        // Warm the OS cache for every database's catalog files in parallel
+        // before touching them one at a time below.
+        prefetchCatalogFiles( dbNames );
+
         for ( vector< string >::iterator i = dbNames.begin(); i != dbNames.end(); ++i ) {
             string dbName = *i;
             LOG(1) << "\t" << dbName << endl;
@@ -531,13 +627,21 @@ namespace mongo {
                 }
 
                 Date_t start = jsTime();
-                int numFiles = MemoryMappedFile::flushAll( true );
+                // spread the msyncs over half the sync interval so the background
+                // flush arrives as a trickle instead of an I/O storm that stalls
+                // journal writes on a shared device; the whole paced pass is still
+                // one checkpoint as far as journal recovery is concerned
+                int flushTimeMillis = 0;
+                int numFiles = MemoryMappedFile::flushAllPaced(
+                        (long long)(storageGlobalParams.syncdelay * 1000 / 2),
+                        &flushTimeMillis );
                 time_flushing = (int) (jsTime() - start);
 
-                _flushed(time_flushing);
+                _flushed(flushTimeMillis);
 
-                if( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1)) || time_flushing >= 10000 ) {
-                    log() << "flushing mmaps took " << time_flushing << "ms " << " for " << numFiles << " files" << endl;
+                if( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1)) || flushTimeMillis >= 10000 ) {
+                    log() << "flushing mmaps took " << flushTimeMillis << "ms (paced over "
+                          << time_flushing << "ms) for " << numFiles << " files" << endl;
                 }
             }
         }
@@ -643,6 +747,15 @@ namespace mongo {
 #endif // __linux__
     }
 
+    static void timerWheelThreadInit() {
+        Client::initThread( "timerwheel" );
+    }
+
+    static void timerWheelThreadCleanup() {
+        if ( haveClient() )
+            cc().shutdown();
+    }
+
     void _initAndListen(int listenPort ) {
 
         Client::initThread("initandlisten");
@@ -660,6 +773,25 @@ namespace mongo {
             l << ( is32bit ? " 32" : " 64" ) << "-bit host=" << getHostNameCached() << endl;
         }
         DEV log() << "_DEBUG build (which is slower)" << endl;
+
+        if (mongodGlobalParams.numaInterleave) {
+            // must happen before the datafiles are mapped; only pages faulted in after
+            // this call follow the interleave policy
+            if (numaNodeCount() > 1) {
+                Status interleaveStatus = numaInterleaveAllNodes();
+                if (interleaveStatus.isOK()) {
+                    log() << "interleaving memory allocation across " << numaNodeCount()
+                          << " NUMA nodes" << endl;
+                }
+                else {
+                    warning() << "--numaInterleave: " << interleaveStatus.reason() << endl;
+                }
+            }
+            else {
+                log() << "--numaInterleave: only one NUMA node detected, nothing to do" << endl;
+            }
+        }
+
         logStartupWarnings();
 #if defined(_WIN32)
         printTargetMinOS();
@@ -737,9 +869,18 @@ namespace mongo {
         /* this is for security on certain platforms (nonce generation) */
         srand((unsigned) (curTimeMicros() ^ startupSrandTimer.micros()));
 
-        snapshotThread.go();
-        d.clientCursorMonitor.go();
+        // Periodic maintenance jobs share one timer wheel thread; give it a Client
+        // since some of them (cursor timeouts, stats snapshots) touch db state.
+        if ( TimerWheel* wheel = globalTimerWheel() )
+            wheel->setThreadHooks( timerWheelThreadInit, timerWheelThreadCleanup );
+
+        startStatsSnapshots();
+        metricsStreamThread.go();
+        startClientCursorMonitor();
         PeriodicTask::startRunningPeriodicTasks();
+        startPlanCachePersistence();
+        startProfileWriter();
+        RamLog::startAsyncWrites();
         if (missingRepl) {
             // a warning was logged earlier
         }
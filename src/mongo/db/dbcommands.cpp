@@ -65,6 +65,7 @@
 #include "mongo/db/query/get_runner.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/query/query_result_cache.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
@@ -475,7 +476,7 @@ namespace mongo {
             string ns = parseNs(dbname, cmdObj);
             string err;
             int errCode;
-            long long n = runCount(ns, cmdObj, err, errCode);
+            long long n = runCount(ns, cmdObj, err, errCode, &result);
             long long nn = n;
             bool ok = true;
             if ( n == -1 ) {
@@ -1125,6 +1126,40 @@ namespace mongo {
                         result.appendBool( "usePowerOf2Sizes_new", newPowerOf2 );
                     }
                 }
+                else if ( str::equals( "compressRecords", e.fieldName() ) ) {
+                    bool oldCompress = nsd->isUserFlagSet(NamespaceDetails::Flag_CompressRecords);
+                    bool newCompress = e.trueValue();
+
+                    if ( oldCompress != newCompress ) {
+                        // change userFlags; only affects records written from here on
+                        result.appendBool( "compressRecords_old", oldCompress );
+
+                        newCompress ? nsd->setUserFlag( NamespaceDetails::Flag_CompressRecords ) :
+                                      nsd->clearUserFlag( NamespaceDetails::Flag_CompressRecords );
+                        nsd->syncUserFlags( ns ); // must keep system.namespaces up-to-date
+
+                        result.appendBool( "compressRecords_new", newCompress );
+                    }
+                }
+                else if ( str::equals( "resultCache", e.fieldName() ) ) {
+                    bool oldResultCache = nsd->isUserFlagSet(NamespaceDetails::Flag_ResultCache);
+                    bool newResultCache = e.trueValue();
+
+                    if ( oldResultCache != newResultCache ) {
+                        // change userFlags
+                        result.appendBool( "resultCache_old", oldResultCache );
+
+                        newResultCache ? nsd->setUserFlag( NamespaceDetails::Flag_ResultCache ) :
+                                         nsd->clearUserFlag( NamespaceDetails::Flag_ResultCache );
+                        nsd->syncUserFlags( ns ); // must keep system.namespaces up-to-date
+
+                        if ( !newResultCache ) {
+                            QueryResultCache::get().invalidate( ns );
+                        }
+
+                        result.appendBool( "resultCache_new", newResultCache );
+                    }
+                }
                 else if ( str::equals( "index", e.fieldName() ) ) {
                     BSONObj indexObj = e.Obj();
                     BSONObj keyPattern = indexObj.getObjectField( "keyPattern" );
@@ -1571,7 +1606,7 @@ namespace mongo {
 
        returns true if ran a cmd
     */
-    bool _runCommands(const char *ns, BSONObj& _cmdobj, BufBuilder &b, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions) {
+    bool _runCommands(const char *ns, BSONObj& _cmdobj, PooledBufBuilder &b, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions) {
         string dbname = nsToDatabase( ns );
 
         LOG(2) << "run command " << ns << ' ' << _cmdobj << endl;
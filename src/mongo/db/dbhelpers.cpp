@@ -51,9 +51,11 @@
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/s/d_logic.h"
+#include "mongo/util/io_throttle.h"
 
 namespace mongo {
 
@@ -314,12 +316,20 @@ namespace mongo {
         return findShardKeyIndexPattern_inlock( ns, shardKeyPattern, indexPattern );
     }
 
+    // Max number of documents removeRange deletes per write lock acquisition.
+    MONGO_EXPORT_SERVER_PARAMETER( rangeDeleterBatchSize, int, 128 );
+
+    // Minimum pause between removeRange batches, independent of lock contention
+    // and replication lag.
+    MONGO_EXPORT_SERVER_PARAMETER( rangeDeleterBatchDelayMS, int, 0 );
+
     long long Helpers::removeRange( const KeyRange& range,
                                     bool maxInclusive,
                                     bool secondaryThrottle,
                                     RemoveSaver* callback,
                                     bool fromMigrate,
-                                    bool onlyRemoveOrphanedDocs )
+                                    bool onlyRemoveOrphanedDocs,
+                                    RemoveRangeStats* stats )
     {
         Timer rangeRemoveTimer;
         const string& ns = range.ns;
@@ -355,10 +365,18 @@ namespace mongo {
         Client& c = cc();
 
         long long numDeleted = 0;
-        
+        long long numBatches = 0;
+
         long long millisWaitingForReplication = 0;
+        long long millisSleeping = 0;
+
+        const int batchSize = std::max( 1, rangeDeleterBatchSize );
+
+        bool done = false;
+        while ( !done ) {
+            long long batchDocs = 0;
+            long long batchBytes = 0;
 
-        while ( 1 ) {
             // Scoping for write lock.
             {
                 Client::WriteContext ctx(ns);
@@ -373,79 +391,131 @@ namespace mongo {
                                                                    InternalPlanner::FORWARD,
                                                                    InternalPlanner::IXSCAN_FETCH));
 
-                runner->setYieldPolicy(Runner::YIELD_AUTO);
-
-                DiskLoc rloc;
-                BSONObj obj;
-                Runner::RunnerState state;
-                // This may yield so we cannot touch nsd after this.
-                state = runner->getNext(&obj, &rloc);
-                runner.reset();
-                if (Runner::RUNNER_EOF == state) { break; }
+                // Collect up to batchSize documents to delete. The runner does not yield
+                // and we hold the write lock until the whole batch has been deleted, so
+                // the DiskLocs (and the unowned BSONObjs pointing into the data files)
+                // stay valid: deleting one record never moves another.
+                typedef std::pair<DiskLoc, BSONObj> LocAndDoc;
+                vector<LocAndDoc> batch;
+                batch.reserve( batchSize );
 
+                CollectionMetadataPtr metadataNow;
                 if ( onlyRemoveOrphanedDocs ) {
-                    // Do a final check in the write lock to make absolutely sure that our
-                    // collection hasn't been modified in a way that invalidates our migration
-                    // cleanup.
-
                     // We should never be able to turn off the sharding state once enabled, but
                     // in the future we might want to.
                     verify(shardingState.enabled());
 
-                    // In write lock, so will be the most up-to-date version
-                    CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
+                    // In write lock, so will be the most up-to-date version. One snapshot
+                    // covers the whole batch - the lock is not released in between.
+                    metadataNow = shardingState.getCollectionMetadata( ns );
+                }
 
-                    bool docIsOrphan;
-                    if ( metadataNow ) {
-                        KeyPattern kp( metadataNow->getKeyPattern() );
-                        BSONObj key = kp.extractSingleKey( obj );
-                        docIsOrphan = !metadataNow->keyBelongsToMe( key )
-                            && !metadataNow->keyIsPending( key );
-                    }
-                    else {
-                        docIsOrphan = false;
+                while ( static_cast<int>( batch.size() ) < batchSize ) {
+                    DiskLoc rloc;
+                    BSONObj obj;
+                    if ( Runner::RUNNER_ADVANCED != runner->getNext(&obj, &rloc) ) {
+                        done = true;
+                        break;
                     }
 
-                    if ( !docIsOrphan ) {
-                        warning() << "aborting migration cleanup for chunk " << min << " to " << max
-                                  << ( metadataNow ? (string) " at document " + obj.toString() : "" )
-                                  << ", collection " << ns << " has changed " << endl;
-                        break;
+                    if ( onlyRemoveOrphanedDocs ) {
+                        // Do a final check in the write lock to make absolutely sure that our
+                        // collection hasn't been modified in a way that invalidates our
+                        // migration cleanup.
+
+                        bool docIsOrphan;
+                        if ( metadataNow ) {
+                            KeyPattern kp( metadataNow->getKeyPattern() );
+                            BSONObj key = kp.extractSingleKey( obj );
+                            docIsOrphan = !metadataNow->keyBelongsToMe( key )
+                                && !metadataNow->keyIsPending( key );
+                        }
+                        else {
+                            docIsOrphan = false;
+                        }
+
+                        if ( !docIsOrphan ) {
+                            warning() << "aborting migration cleanup for chunk "
+                                      << min << " to " << max
+                                      << ( metadataNow ?
+                                           (string) " at document " + obj.toString() : "" )
+                                      << ", collection " << ns << " has changed " << endl;
+                            done = true;
+                            break;
+                        }
                     }
+
+                    batch.push_back( make_pair( rloc, obj ) );
                 }
 
-                if ( callback )
-                    callback->goingToDelete( obj );
+                // A delete would invalidate the runner, so stop it before touching anything.
+                runner.reset();
+
+                for ( size_t i = 0; i < batch.size(); i++ ) {
+                    if ( callback )
+                        callback->goingToDelete( batch[i].second );
 
-                logOp("d", ns.c_str(), obj["_id"].wrap(), 0, 0, fromMigrate);
-                c.database()->getCollection( ns )->deleteDocument( rloc );
-                numDeleted++;
+                    logOp("d", ns.c_str(), batch[i].second["_id"].wrap(), 0, 0, fromMigrate);
+                    batchBytes += batch[i].second.objsize();
+                    collection->deleteDocument( batch[i].first );
+                    numDeleted++;
+                }
+
+                batchDocs = batch.size();
+                if ( batchDocs > 0 )
+                    numBatches++;
             }
 
+            // Charge the batch's bytes against the maintenance I/O budget
+            // now that the write lock has been released; with a limit set
+            // this paces the next batch.
+            if ( batchBytes > 0 )
+                IoThrottle::global.request( IoThrottle::Maintenance, batchBytes );
+
             Timer secondaryThrottleTime;
 
-            if ( secondaryThrottle && numDeleted > 0 ) {
+            if ( secondaryThrottle && batchDocs > 0 ) {
                 if ( ! waitForReplication( c.getLastOp(), 2, 60 /* seconds to wait */ ) ) {
                     warning() << "replication to secondaries for removeRange at least 60 seconds behind" << endl;
                 }
                 millisWaitingForReplication += secondaryThrottleTime.millis();
             }
-            
+
+            if ( done )
+                break;
+
             if ( ! Lock::isLocked() ) {
-                int micros = ( 2 * Client::recommendedYieldMicros() ) - secondaryThrottleTime.micros();
+                // Pace the next batch: always honor the configured minimum delay, stretch
+                // it when other clients are queued up on the locks we just released, and
+                // count any time already spent throttling on the secondaries against it.
+                int micros = rangeDeleterBatchDelayMS * 1000;
+                int contentionMicros = 2 * Client::recommendedYieldMicros();
+                if ( contentionMicros > micros )
+                    micros = contentionMicros;
+                micros -= secondaryThrottleTime.micros();
                 if ( micros > 0 ) {
                     LOG(1) << "Helpers::removeRangeUnlocked going to sleep for " << micros << " micros" << endl;
+                    Timer sleepTime;
                     sleepmicros( micros );
+                    millisSleeping += sleepTime.millis();
                 }
             }
         }
-        
+
         if ( secondaryThrottle )
-            log() << "Helpers::removeRangeUnlocked time spent waiting for replication: "  
+            log() << "Helpers::removeRangeUnlocked time spent waiting for replication: "
                   << millisWaitingForReplication << "ms" << endl;
-        
+
         LOG(1) << "end removal of " << min << " to " << max << " in " << ns
-               << " (took " << rangeRemoveTimer.millis() << "ms)" << endl;
+               << " (took " << rangeRemoveTimer.millis() << "ms"
+               << ", " << numBatches << " batches)" << endl;
+
+        if ( stats ) {
+            stats->numDeleted = numDeleted;
+            stats->numBatches = numBatches;
+            stats->millisWaitingForReplication = millisWaitingForReplication;
+            stats->millisSleeping = millisSleeping;
+        }
 
         return numDeleted;
     }
@@ -139,6 +139,24 @@ namespace mongo {
          */
         static BSONObj inferKeyPattern( const BSONObj& o );
 
+        /**
+         * Progress and pacing counters for a single removeRange call, for callers
+         * (e.g. the range deleter) that want to report how the deletion was paced.
+         */
+        struct RemoveRangeStats {
+            RemoveRangeStats():
+                numDeleted(0),
+                numBatches(0),
+                millisWaitingForReplication(0),
+                millisSleeping(0) {
+            }
+
+            long long numDeleted;
+            long long numBatches;
+            long long millisWaitingForReplication;
+            long long millisSleeping;
+        };
+
         /**
          * Takes a namespace range, specified by a min and max and qualified by an index pattern,
          * and removes all the documents in that range found by iterating
@@ -147,10 +165,16 @@ namespace mongo {
          * keyPattern={a:1,b:1} since it can be extended to {a:100,b:minKey}, but
          * min={b:100} is not compatible).
          *
+         * Deletes in batches of up to rangeDeleterBatchSize documents per write lock
+         * acquisition and sleeps between batches so foreground operations can make
+         * progress (see the comments in the implementation for the pacing policy).
+         *
          * Caller must hold a write lock on 'ns'
          *
          * Returns -1 when no usable index exists
          *
+         * If 'stats' is non-NULL it is filled in, even when the call fails partway.
+         *
          * Does oplog the individual document deletions.
          * // TODO: Refactor this mechanism, it is growing too large
          */
@@ -159,7 +183,8 @@ namespace mongo {
                                       bool secondaryThrottle = false,
                                       RemoveSaver* callback = NULL,
                                       bool fromMigrate = false,
-                                      bool onlyRemoveOrphanedDocs = false );
+                                      bool onlyRemoveOrphanedDocs = false,
+                                      RemoveRangeStats* stats = NULL );
 
 
         // TODO: This will supersede Chunk::MaxObjectsPerChunk
@@ -54,24 +54,31 @@ namespace mongo {
     }
 
 
+    namespace {
+        // Deleter for shared message segments whose bytes belong to the caller.
+        void deleteNothing( char* ) {}
+    }
+
     void replyToQuery(int queryResultFlags,
                       AbstractMessagingPort* p, Message& requestMsg,
                       void *data, int size,
                       int nReturned, int startingFrom,
-                      long long cursorId 
+                      long long cursorId
                       ) {
-        BufBuilder b(32768);
-        b.skip(sizeof(QueryResult));
-        b.appendBuf(data, size);
-        QueryResult *qr = (QueryResult *) b.buf();
+        // The reply goes out as two segments -- the QueryResult header and the
+        // caller's result buffer -- via the scatter/gather send, so the
+        // documents are never copied.  The caller's bytes only need to stay
+        // valid for this call: reply() sends synchronously.
+        QueryResult *qr = (QueryResult *) malloc(sizeof(QueryResult));
         qr->_resultFlags() = queryResultFlags;
-        qr->len = b.len();
         qr->setOperation(opReply);
         qr->cursorId = cursorId;
         qr->startingFrom = startingFrom;
         qr->nReturned = nReturned;
-        b.decouple();
-        Message resp(qr, true);
+        Message resp;
+        resp.appendData((char*)qr, sizeof(QueryResult)); // sets len; owns qr
+        resp.appendSharedData(boost::shared_ptr<char>((char*)data, deleteNothing),
+                              (char*)data, size);
         p->reply(requestMsg, resp, requestMsg.header()->id);
     }
 
@@ -91,12 +98,13 @@ namespace mongo {
     }
 
     void replyToQuery( int queryResultFlags, Message& response, const BSONObj& resultObj ) {
-        BufBuilder bufBuilder;
+        PooledBufBuilder bufBuilder;
         bufBuilder.skip( sizeof( QueryResult ));
         bufBuilder.appendBuf( reinterpret_cast< void *>(
                 const_cast< char* >( resultObj.objdata() )), resultObj.objsize() );
 
         QueryResult* queryResult = reinterpret_cast< QueryResult* >( bufBuilder.buf() );
+        int allocSize = bufBuilder.getSize();
         bufBuilder.decouple();
 
         queryResult->_resultFlags() = queryResultFlags;
@@ -106,7 +114,7 @@ namespace mongo {
         queryResult->startingFrom = 0;
         queryResult->nReturned = 1;
 
-        response.setData( queryResult, true ); // transport will free
+        response.setPooledData( queryResult, allocSize ); // recycled after send
     }
 
 }
@@ -293,6 +293,8 @@ namespace mongo {
         ~DbResponse() { delete response; }
     };
 
+    /* sends the reply before returning; 'data' is referenced, not copied, and
+       only needs to stay valid for the duration of the call. */
     void replyToQuery(int queryResultFlags,
                       AbstractMessagingPort* p, Message& requestMsg,
                       void *data, int size,
@@ -79,6 +79,7 @@
 #include "mongo/db/dur.h"
 #include "mongo/db/dur_commitjob.h"
 #include "mongo/db/dur_journal.h"
+#include "mongo/db/dur_journalwriter.h"
 #include "mongo/db/dur_recover.h"
 #include "mongo/db/dur_stats.h"
 #include "mongo/db/storage_options.h"
@@ -222,6 +223,29 @@ namespace mongo {
             _impl = nonDurableImpl;
         }
 
+        /** Commit scheduler for user-acknowledged writes.
+
+            Connections about to block on a journal acknowledgment (getLastError
+            with j:true / fsync:true) nudge the journal thread through this
+            condition variable instead of silently joining the next periodic
+            group commit.  The journal thread keeps a batching deadline of a
+            third of the commit interval once acknowledgments are pending, and
+            commits immediately when a full batch of waiters has formed, so a
+            burst of writer connections shares one early commit rather than
+            each paying the full interval.  All satisfied waiters are released
+            together by the commit's notifyAll.
+        */
+        static mongo::mutex ackSchedulerMutex("durAckScheduler");
+        static boost::condition ackSchedulerCond;
+
+        // this many pending j:true waiters trigger an immediate group commit
+        static const unsigned ackBatchThreshold = 32;
+
+        static void nudgeCommitScheduler() {
+            scoped_lock lk(ackSchedulerMutex);
+            ackSchedulerCond.notify_one();
+        }
+
         bool DurableImpl::commitNow() {
             stats.curr->_earlyCommits++;
             groupCommit(0);
@@ -230,10 +254,26 @@ namespace mongo {
         }
 
         bool DurableImpl::awaitCommit() {
+            nudgeCommitScheduler();
             commitJob._notify.awaitBeyondNow();
             return true;
         }
 
+        unsigned long long DurableImpl::commitEpoch() {
+            return commitJob._notify.now();
+        }
+
+        void DurableImpl::awaitCommitOf(unsigned long long epoch) {
+            if( epoch && !commitJob._notify.done(epoch) ) {
+                nudgeCommitScheduler();
+                commitJob._notify.waitFor(epoch);
+            }
+        }
+
+        bool DurableImpl::hasCommitted(unsigned long long epoch) {
+            return epoch == 0 || commitJob._notify.done(epoch);
+        }
+
         /** Declare that a file has been created
             Normally writes are applied only after journaling, for safety.  But here the file
             is created first, and the journal will just replay the creation if the create didn't
@@ -578,13 +618,17 @@ namespace mongo {
 
         static bool _groupCommitWithLimitedLocks() {
             unspoolWriteIntents(); // in case we were doing some writing ourself (likely impossible with limitedlocks version)
-            AlignedBuilder &ab = __theBuilder;
+
+            // grab a pooled buffer before taking any locks.  this blocks when both buffers
+            // are still in flight, which is what bounds the pipeline depth.
+            JournalWriter::Buffer *b = journalWriter.newBuffer();
+            AlignedBuilder &ab = b->builder;
 
             verify( ! Lock::isLocked() );
 
             // do we need this to be greedy, so that it can start working fairly soon?
             // probably: as this is a read lock, it wouldn't change anything if only reads anyway.
-            // also needs to stop greed. our time to work before clearing lk1 is not too bad, so 
+            // also needs to stop greed. our time to work before clearing lk1 is not too bad, so
             // not super critical, but likely 'correct'.  todo.
             scoped_ptr<Lock::GlobalRead> lk1( new Lock::GlobalRead() );
 
@@ -595,41 +639,30 @@ namespace mongo {
             if( !commitJob.hasWritten() ) {
                 // getlasterror request could have came after the data was already committed
                 commitJob.committingNotifyCommitted();
+                journalWriter.putBack(b);
                 return true;
             }
 
-            JSectHeader h;
-            // need to be in readlock (writes excluded) for this as write intent stuctures point into 
-            // the private mmap for their actual data.  i suppose we could lock individual databases 
-            // and do them one at a time or in parallel (surely the latter would make sense if one went 
+            // need to be in readlock (writes excluded) for this as write intent stuctures point into
+            // the private mmap for their actual data.  i suppose we could lock individual databases
+            // and do them one at a time or in parallel (surely the latter would make sense if one went
             // that route...)
-            PREPLOGBUFFER(h,ab); 
-
-            LockMongoFilesShared lk3;
+            PREPLOGBUFFER(b->header,ab);
+            b->commitNumber = commitJob.commitNumber();
 
-            unsigned abLen = ab.len();
             commitJob.committingReset(); // must be reset before allowing anyone to write
             DEV verify( !commitJob.hasWritten() );
 
-            // release the readlock -- allowing others to now write while we are writing to the journal (etc.)
+            // release the readlock -- allowing others to now write while the writer thread
+            // journals and applies this commit.  we can then prep the next commit while the
+            // last is still being fsynced.
             lk1.reset();
 
             // ****** now other threads can do writes ******
 
-            WRITETOJOURNAL(h, ab);
-            verify( abLen == ab.len() ); // a check that no one touched the builder while we were doing work. if so, our locking is wrong.
-
-            // data is now in the journal, which is sufficient for acknowledging getLastError.
-            // (ok to crash after that)
-            commitJob.committingNotifyCommitted();
-
-            // note the higher-up-the-chain locking of filesLockedFsync is important here, 
-            // as we are not in Lock::GlobalRead anymore. private view readers won't see 
-            // anything as we do this, but external viewers of the datafiles will see them 
-            // mutating.
-            WRITETODATAFILES(h, ab);
-            verify( abLen == ab.len() ); // check again wasn't modded
-            ab.reset();
+            // stage 2 happens on the journal writer thread: WRITETOJOURNAL, notify
+            // getlasterror waiters, WRITETODATAFILES (under LockMongoFilesShared).
+            journalWriter.write(b);
 
             // can't : d.dbMutex._remapPrivateViewRequested = true;
             // (writes have happened we released)
@@ -664,6 +697,11 @@ namespace mongo {
         static void _groupCommit(Lock::GlobalWrite *lgw) {
             LOG(4) << "_groupCommit " << endl;
 
+            // drain the pipelined journal writer first: below we append to the journal
+            // synchronously and may REMAPPRIVATEVIEW, both of which require every queued
+            // commit to be fully written to the journal and the datafiles.
+            journalWriter.flush();
+
             // We are 'R' or 'W'
             assertLockedForCommitting();
 
@@ -805,6 +843,7 @@ namespace mongo {
             }
             else {
                 verify( inShutdown() );
+                journalWriter.flush(); // queued commits reference the views that are going away
                 if( commitJob.hasWritten() ) {
                     log() << "journal warning files are closing outside locks with writes pending" << endl;
                 }
@@ -840,16 +879,28 @@ namespace mongo {
                 try {
                     stats.rotate();
 
-                    // commit sooner if one or more getLastError j:true is pending
-                    sleepmillis(oneThird);
-                    for( unsigned i = 1; i <= 2; i++ ) {
-                        if( commitJob._notify.nWaiting() )
-                            break;
-                        if( commitJob.bytes() > UncommittedBytesLimit / 2  )
-                            break;
-                        sleepmillis(oneThird);
+                    // Wait for a commit trigger: the commit interval expiring, a
+                    // batch of getLastError j:true acknowledgments forming, or too
+                    // many uncommitted bytes.  Waiters signal ackSchedulerCond via
+                    // nudgeCommitScheduler(); a waiter that signals before it is
+                    // visible in nWaiting() is still picked up no later than the
+                    // next oneThird timeout.
+                    {
+                        Timer t;
+                        scoped_lock lk(ackSchedulerMutex);
+                        while( t.millis() < (int)ms ) {
+                            const unsigned nAck = commitJob._notify.nWaiting();
+                            if( nAck >= ackBatchThreshold )
+                                break;       // full batch -- commit right away
+                            if( commitJob.bytes() > UncommittedBytesLimit / 2 )
+                                break;
+                            if( nAck && t.millis() >= (int)oneThird )
+                                break;       // batching deadline for pending acks
+                            ackSchedulerCond.timed_wait(
+                                    lk.boost(), boost::posix_time::milliseconds(oneThird));
+                        }
                     }
-                                        
+
                     //DEV log() << "privateMapBytes=" << privateMapBytes << endl;
 
                     durThreadGroupCommit();
@@ -909,6 +960,7 @@ namespace mongo {
 
             preallocateFiles();
 
+            journalWriter.start();
             boost::thread t(durThread);
         }
 
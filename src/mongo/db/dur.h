@@ -104,6 +104,28 @@ namespace mongo {
             */
             virtual bool awaitCommit() = 0;
 
+            /** Token in the journal's commit sequence.  Capture one after a
+                write, then pass it to awaitCommitOf() to wait until a group
+                commit begun after the capture -- and hence containing the
+                write -- has reached the journal.
+                @return 0 if --dur is off.
+            */
+            virtual unsigned long long commitEpoch() = 0;
+
+            /** Wait until the group commit covering 'epoch' (from
+                commitEpoch()) has reached the journal.  Returns immediately
+                if that already happened, if epoch is 0, or if --dur is off.
+            */
+            virtual void awaitCommitOf(unsigned long long epoch) = 0;
+
+            /** Nonblocking companion to awaitCommitOf(): true if the group
+                commit covering 'epoch' has already reached the journal.
+                Lets a thread check completion between servicing other work
+                and only block - via awaitCommitOf() - once it has nothing
+                else to do.  Always true if epoch is 0 or --dur is off.
+            */
+            virtual bool hasCommitted(unsigned long long epoch) = 0;
+
             /** Commit immediately.
 
                 Generally, you do not want to do this often, as highly granular committing may affect
@@ -200,6 +222,9 @@ namespace mongo {
             void declareWriteIntent(void *, unsigned);
             void createdFile(const std::string& filename, unsigned long long len) { }
             bool awaitCommit() { return false; }
+            unsigned long long commitEpoch() { return 0; }
+            void awaitCommitOf(unsigned long long) { }
+            bool hasCommitted(unsigned long long) { return true; }
             bool commitNow();
             bool commitIfNeeded(bool);
             bool isCommitNeeded() const { return false; }
@@ -215,6 +240,9 @@ namespace mongo {
             void declareWriteIntent(void *, unsigned);
             void createdFile(const std::string& filename, unsigned long long len);
             bool awaitCommit();
+            unsigned long long commitEpoch();
+            void awaitCommitOf(unsigned long long epoch);
+            bool hasCommitted(unsigned long long epoch);
             bool commitNow();
             bool isCommitNeeded() const;
             bool commitIfNeeded(bool);
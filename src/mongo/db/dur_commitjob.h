@@ -172,6 +172,10 @@ namespace mongo {
                 groupCommitMutex.dassertLocked();
                 _notify.notifyAll(_commitNumber); 
             }
+            /** the commit epoch of the commit currently in progress; captured by the journal
+                writer pipeline so it can notify waiters from another thread */
+            NotifyAll::When commitNumber() const { return _commitNumber; }
+
             /** we use the commitjob object over and over, calling reset() rather than reconstructing */
             void committingReset() {
                 groupCommitMutex.dassertLocked();
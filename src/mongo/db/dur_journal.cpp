@@ -48,11 +48,14 @@
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
 #include "mongo/util/concurrency/race.h"
+#include "mongo/util/concurrency/work_stealing_pool.h"
 #include "mongo/util/file.h"
+#include "mongo/util/io_throttle.h"
 #include "mongo/util/logfile.h"
 #include "mongo/util/mmap.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/listen.h" // getelapsedtimemillis
+#include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/timer.h"
 
@@ -90,6 +93,7 @@ namespace mongo {
         BOOST_STATIC_ASSERT( sizeof(Checksum) == 16 );
         BOOST_STATIC_ASSERT( sizeof(JHeader) == 8192 );
         BOOST_STATIC_ASSERT( sizeof(JSectHeader) == 20 );
+        BOOST_STATIC_ASSERT( sizeof(JBlockHeader) == 8 );
         BOOST_STATIC_ASSERT( sizeof(JSectFooter) == 32 );
         BOOST_STATIC_ASSERT( sizeof(JEntry) == 12 );
         BOOST_STATIC_ASSERT( sizeof(LSNFile) == 88 );
@@ -99,6 +103,12 @@ namespace mongo {
         void removeOldJournalFile(boost::filesystem::path p);
 
         boost::filesystem::path getJournalDir() {
+            // --journalPath lets the journal live on its own device, so the
+            // sequential journal appends don't contend with datafile i/o
+            // (previously this required symlinking <dbpath>/journal).
+            if (!storageGlobalParams.journalPath.empty()) {
+                return boost::filesystem::path(storageGlobalParams.journalPath);
+            }
             boost::filesystem::path p(storageGlobalParams.dbpath);
             p /= "journal";
             return p;
@@ -727,16 +737,41 @@ namespace mongo {
             j.journal(h, uncompressed);
             stats.curr->_writeToJournalMicros += t.micros();
         }
+        // a worker compresses one block of the section payload into its
+        // preassigned slice of the output buffer
+        static void compressJournalBlock(const char* raw, unsigned rawLen,
+                                         char* out, size_t* compressedLenOut) {
+            size_t len = 0;
+            rawCompress(raw, rawLen, out, &len);
+            *compressedLenOut = len;
+        }
+
+        // only the journal writer thread compresses, so lazy creation is single threaded
+        static WorkStealingPool* journalCompressPool() {
+            static WorkStealingPool* pool = NULL;
+            if ( pool == NULL ) {
+                int n = static_cast<int>( ProcessInfo().getNumCores() );
+                pool = new WorkStealingPool( std::min( 4, std::max( 2, n ) ) );
+            }
+            return pool;
+        }
+
         void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
             RACECHECK
             static AlignedBuilder b(32*1024*1024);
             /* buffer to journal will be
                JSectHeader
-               compressed operations
+               compressed operations -- JBlockHeader-framed blocks, see dur_journalformat.h
                JSectFooter
             */
+            const unsigned blockBytes = kJournalCompressBlockBytes;
+            const unsigned nBlocks = (uncompressed.len() + blockBytes - 1) / blockBytes;
+
+            // each block gets a fixed-capacity slot up front; frames are
+            // compacted to their real lengths afterwards
+            const unsigned frameCap = sizeof(JBlockHeader) + maxCompressedLength(blockBytes);
             const unsigned headTailSize = sizeof(JSectHeader) + sizeof(JSectFooter);
-            const unsigned max = maxCompressedLength(uncompressed.len()) + headTailSize;
+            const unsigned max = nBlocks * frameCap + headTailSize;
             b.reset(max);
 
             {
@@ -744,11 +779,52 @@ namespace mongo {
                 b.appendStruct(h);
             }
 
-            size_t compressedLength = 0;
-            rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
-            verify( compressedLength < 0xffffffff );
-            verify( compressedLength < max );
-            b.skip(compressedLength);
+            static std::vector<size_t> compressedLens;
+            compressedLens.assign(nBlocks, 0);
+
+            if( nBlocks <= 1 ) {
+                // common case: compress in place, no pool handoff
+                if( nBlocks == 1 ) {
+                    compressJournalBlock(uncompressed.buf(), uncompressed.len(),
+                                         b.atOfs(sizeof(JSectHeader) + sizeof(JBlockHeader)),
+                                         &compressedLens[0]);
+                }
+            }
+            else {
+                // fan the blocks out; each worker writes into a disjoint slot of b
+                WorkStealingPool* pool = journalCompressPool();
+                for( unsigned i = 0; i < nBlocks; i++ ) {
+                    const unsigned rawOfs = i * blockBytes;
+                    const unsigned rawLen = std::min(blockBytes, uncompressed.len() - rawOfs);
+                    pool->schedule(&compressJournalBlock,
+                                   uncompressed.buf() + rawOfs,
+                                   rawLen,
+                                   b.atOfs(sizeof(JSectHeader) + i * frameCap + sizeof(JBlockHeader)),
+                                   &compressedLens[i]);
+                }
+                pool->join();
+            }
+
+            // compact the slots into contiguous frames.  slot i's payload never
+            // precedes its final position, so left-to-right memmoves are safe.
+            unsigned writeOfs = sizeof(JSectHeader);
+            for( unsigned i = 0; i < nBlocks; i++ ) {
+                verify( compressedLens[i] > 0 && compressedLens[i] <= maxCompressedLength(blockBytes) );
+
+                JBlockHeader bh;
+                bh.rawLen = std::min(blockBytes, uncompressed.len() - i * blockBytes);
+                bh.compressedLen = (unsigned) compressedLens[i];
+
+                char* dst = b.atOfs(writeOfs);
+                const char* src = b.atOfs(sizeof(JSectHeader) + i * frameCap + sizeof(JBlockHeader));
+                if( dst + sizeof(JBlockHeader) != src ) {
+                    memmove(dst + sizeof(JBlockHeader), src, bh.compressedLen);
+                }
+                memcpy(dst, &bh, sizeof(JBlockHeader));
+                writeOfs += sizeof(JBlockHeader) + bh.compressedLen;
+            }
+            verify( writeOfs < max );
+            b.skip(writeOfs - sizeof(JSectHeader));
 
             // footer
             unsigned L = 0xffffffff;
@@ -769,6 +845,11 @@ namespace mongo {
                 dassert( b.len() % Alignment == 0 );
             }
 
+            // consult the journal I/O budget before taking the log file
+            // mutex; with a limit set this trades commit latency for device
+            // headroom, so it defaults to unlimited
+            IoThrottle::global.request(IoThrottle::Journal, L);
+
             try {
                 SimpleMutex::scoped_lock lk(_curLogFileMutex);
 
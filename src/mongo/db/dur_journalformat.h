@@ -49,9 +49,13 @@ namespace mongo {
             // x4142 is asci--readable if you look at the file with head/less -- thus the starting values were near
             // that.  simply incrementing the version # is safe on a fwd basis.
 #if defined(_NOCOMPRESS)
-            enum { CurrentVersion = 0x4148 };
+            enum { CurrentVersion = 0x4148, PriorVersion = 0x4148 };
 #else
-            enum { CurrentVersion = 0x4149 };
+            // 0x4149 compressed each section's payload as one snappy stream;
+            // 0x414a frames the payload into independently compressed blocks
+            // (JBlockHeader) so large sections compress on several cores.  we
+            // still recover 0x4149 files written by the previous release.
+            enum { CurrentVersion = 0x414a, PriorVersion = 0x4149 };
 #endif
             unsigned short _version;
 
@@ -67,7 +71,9 @@ namespace mongo {
             char reserved3[8026]; // 8KB total for the file header
             char txt2[2];         // "\n\n" at the end
 
-            bool versionOk() const { return _version == CurrentVersion; }
+            bool versionOk() const {
+                return _version == CurrentVersion || _version == PriorVersion;
+            }
             bool valid() const { return magic[0] == 'j' && txt2[1] == '\n' && fileId; }
         };
 
@@ -94,6 +100,19 @@ namespace mongo {
             }
         };
 
+        /** one compressed block within a section's payload (file version 0x414a and up).
+            each block covers up to kJournalCompressBlockBytes of the uncompressed buffer
+            and is compressed independently, so a large group commit can be compressed by
+            several cores at once and the frames simply concatenated.
+        */
+        struct JBlockHeader {
+            unsigned rawLen;        // uncompressed bytes this block covers
+            unsigned compressedLen; // snappy bytes following this header
+        };
+
+        /** uncompressed bytes covered by each JBlockHeader frame (last block may cover less) */
+        const unsigned kJournalCompressBlockBytes = 4 * 1024 * 1024;
+
         /** an individual write operation within a group commit section.  Either the entire section should
             be applied, or nothing.  (We check the md5 for the whole section before doing anything on recovery.)
         */
@@ -0,0 +1,133 @@
+// @file dur_journalwriter.cpp
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/dur_journalwriter.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/client.h"
+#include "mongo/db/dur_commitjob.h"
+#include "mongo/util/mmap.h"
+
+namespace mongo {
+    namespace dur {
+
+        // see dur.cpp / dur_journal.cpp / dur_writetodatafiles.cpp
+        void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed);
+        void WRITETODATAFILES(const JSectHeader& h, AlignedBuilder& uncompressed);
+
+        JournalWriter journalWriter;
+
+        JournalWriter::JournalWriter() : _inFlight(0) {
+            for( int i = 0; i < kPipelineDepth; i++ )
+                _pool.push( new Buffer() );
+        }
+
+        void JournalWriter::start() {
+            boost::thread t( boost::bind( &JournalWriter::writerThread, this ) );
+        }
+
+        JournalWriter::Buffer* JournalWriter::newBuffer() {
+            return _pool.blockingPop();
+        }
+
+        void JournalWriter::write(Buffer* b) {
+            {
+                scoped_lock lk(_inFlightMutex);
+                _inFlight++;
+            }
+            _queue.push(b);
+        }
+
+        void JournalWriter::flush() {
+            scoped_lock lk(_inFlightMutex);
+            while( _inFlight > 0 )
+                _inFlightDrained.wait(lk.boost());
+        }
+
+        void JournalWriter::writerThread() {
+            Client::initThread("durWriter");
+
+            while( true ) {
+                Buffer* b;
+                if( !_queue.blockingPop( b, 1 /*second, so we notice shutdown*/ ) ) {
+                    if( inShutdown() )
+                        break;
+                    continue;
+                }
+
+                try {
+                    const unsigned abLen = b->builder.len();
+
+                    WRITETOJOURNAL(b->header, b->builder);
+
+                    // data is now in the journal, which is sufficient for acknowledging
+                    // getlasterror j:true.  (ok to crash after that.)
+                    commitJob._notify.notifyAll(b->commitNumber);
+
+                    {
+                        // keep the mapped files around while we write to the shared view
+                        LockMongoFilesShared lk;
+                        WRITETODATAFILES(b->header, b->builder);
+                    }
+                    verify( abLen == b->builder.len() ); // no one should touch an in-flight buffer
+                    b->builder.reset();
+                }
+                catch(DBException& e ) {
+                    log() << "dbexception in journal writer thread causing immediate shutdown: "
+                          << e.toString() << endl;
+                    mongoAbort("durwriter1");
+                }
+                catch(std::ios_base::failure& e) {
+                    log() << "ios_base exception in journal writer thread causing immediate shutdown: "
+                          << e.what() << endl;
+                    mongoAbort("durwriter2");
+                }
+                catch(std::exception& e) {
+                    log() << "exception in journal writer thread causing immediate shutdown: "
+                          << e.what() << endl;
+                    mongoAbort("durwriter3");
+                }
+
+                {
+                    scoped_lock lk(_inFlightMutex);
+                    if( --_inFlight == 0 )
+                        _inFlightDrained.notify_all();
+                }
+                _pool.push(b);
+            }
+
+            cc().shutdown();
+        }
+
+    } // namespace dur
+} // namespace mongo
@@ -0,0 +1,101 @@
+// @file dur_journalwriter.h
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <boost/thread/condition.hpp>
+
+#include "mongo/db/dur_journalformat.h"
+#include "mongo/util/alignedbuilder.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/synchronization.h"
+#include "mongo/util/queue.h"
+
+namespace mongo {
+    namespace dur {
+
+        /** Pipelines the back half of group commit.
+         *
+         *  Stage 1 (the dur thread, see _groupCommitWithLimitedLocks): collect intents and run
+         *  PREPLOGBUFFER into a Buffer, then hand it to us.  Stage 2 (our writer thread):
+         *  compress and synchronously append the buffer to the journal, wake getLastError
+         *  j:true waiters, then apply the writes to the shared view (WRITETODATAFILES).
+         *
+         *  With two pooled buffers the dur thread can prep commit N+1 while commit N is being
+         *  fsynced, so journal latency no longer stalls intent collection.
+         *
+         *  flush() drains the pipeline; it must complete before REMAPPRIVATEVIEW and before
+         *  mapped files close, since queued buffers point into the shared view.
+         */
+        class JournalWriter : boost::noncopyable {
+        public:
+            struct Buffer : boost::noncopyable {
+                Buffer() : commitNumber(0), builder(4 * 1024 * 1024) {}
+                JSectHeader header;
+                NotifyAll::When commitNumber;
+                AlignedBuilder builder;
+            };
+
+            JournalWriter();
+
+            /** start the writer thread. called once from dur::startup(). */
+            void start();
+
+            /** get an empty buffer to prep into.  blocks when both pooled buffers are in
+                flight, which is what bounds the pipeline depth. */
+            Buffer* newBuffer();
+
+            /** queue a prepped buffer for the writer thread.  we own it until it returns to
+                the pool after WRITETODATAFILES. */
+            void write(Buffer* b);
+
+            /** return an unused buffer to the pool (the "nothing to commit" case). */
+            void putBack(Buffer* b) { _pool.push(b); }
+
+            /** block until everything queued has reached the journal and the datafiles. */
+            void flush();
+
+        private:
+            void writerThread();
+
+            static const int kPipelineDepth = 2;
+
+            BlockingQueue<Buffer*> _queue;
+            BlockingQueue<Buffer*> _pool;
+
+            mongo::mutex _inFlightMutex;
+            boost::condition _inFlightDrained;
+            int _inFlight; // buffers handed out or queued but not yet fully written
+        };
+
+        extern JournalWriter journalWriter;
+
+    } // namespace dur
+} // namespace mongo
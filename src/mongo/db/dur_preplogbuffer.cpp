@@ -95,6 +95,10 @@ namespace mongo {
 
             JEntry e;
             e.len = min(i->length(), (unsigned)(mmf->length() - ofs)); //don't write past end of file
+
+            // remember which chunks of the private view this intent dirtied so that
+            // REMAPPRIVATEVIEW can remap just those instead of the whole view
+            mmf->markDirtyRange(ofs, e.len);
             verify( ofs <= 0x80000000 );
             e.ofs = (unsigned) ofs;
             e.setFileNo( mmf->fileSuffixNo() );
@@ -33,6 +33,7 @@
 #include "mongo/db/dur_recover.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <sys/stat.h>
 
@@ -115,20 +116,42 @@ namespace mongo {
             const bool _doDurOps;
             string _uncompressed;
         public:
-            JournalSectionIterator(const JSectHeader& h, const void *compressed, unsigned compressedLen, bool doDurOpsRecovering) :
+            JournalSectionIterator(const JSectHeader& h, const void *compressed, unsigned compressedLen,
+                                   bool doDurOpsRecovering, unsigned journalVersion) :
                 _h(h),
                 _lastDbName(0)
                 , _doDurOps(doDurOpsRecovering)
             {
                 verify( doDurOpsRecovering );
-                bool ok = uncompress((const char *)compressed, compressedLen, &_uncompressed);
-                if( !ok ) { 
-                    // it should always be ok (i think?) as there is a previous check to see that the JSectFooter is ok
-                    log() << "couldn't uncompress journal section" << endl;
-                    msgasserted(15874, "couldn't uncompress journal section");
+                verify( compressedLen == _h.sectionLen() - sizeof(JSectFooter) - sizeof(JSectHeader) );
+
+                if( journalVersion >= JHeader::CurrentVersion ) {
+                    // the payload is a sequence of JBlockHeader-framed,
+                    // independently compressed blocks
+                    BufReader frames(compressed, compressedLen);
+                    string block;
+                    while( !frames.atEof() ) {
+                        JBlockHeader bh;
+                        frames.read(bh);
+                        const void* data = frames.skip(bh.compressedLen);
+                        bool ok = uncompress((const char *)data, bh.compressedLen, &block);
+                        if( !ok || block.size() != bh.rawLen ) {
+                            log() << "couldn't uncompress journal section block" << endl;
+                            msgasserted(15874, "couldn't uncompress journal section");
+                        }
+                        _uncompressed.append(block);
+                    }
+                }
+                else {
+                    // prior versions compressed the whole payload as one snappy stream
+                    bool ok = uncompress((const char *)compressed, compressedLen, &_uncompressed);
+                    if( !ok ) {
+                        // it should always be ok (i think?) as there is a previous check to see that the JSectFooter is ok
+                        log() << "couldn't uncompress journal section" << endl;
+                        msgasserted(15874, "couldn't uncompress journal section");
+                    }
                 }
                 const char *p = _uncompressed.c_str();
-                verify( compressedLen == _h.sectionLen() - sizeof(JSectFooter) - sizeof(JSectHeader) );
                 _entries = auto_ptr<BufReader>( new BufReader(p, _uncompressed.size()) );
             }
 
@@ -349,6 +372,131 @@ namespace mongo {
             return mmf;
         }
 
+        namespace {
+
+            // parallel section apply: don't spin up threads for small sections,
+            // and don't use more workers than this even on big machines - memcpy
+            // into page cache saturates quickly
+            const size_t minEntriesToApplyInParallel = 512;
+            const unsigned maxApplyWorkers = 8;
+
+            /** One worker's share of a section: every entry for the data files
+                assigned to it, in section order.  The main thread resolves
+                entries to mapped files before any worker runs, so workers only
+                copy bytes.
+            */
+            class SectionEntryApplier {
+            public:
+                SectionEntryApplier() : _failed(false), _writePastEof(false) { }
+
+                void add(DurableMappedFile* mmf, const ParsedJournalEntry* entry) {
+                    _work.push_back(make_pair(mmf, entry));
+                }
+
+                size_t size() const { return _work.size(); }
+
+                bool failed() const { return _failed; }
+
+                bool writePastEof() const { return _writePastEof; }
+
+                void operator()() {
+                    try {
+                        for( vector<Work>::const_iterator i = _work.begin(); i != _work.end(); ++i ) {
+                            DurableMappedFile *mmf = i->first;
+                            const JEntry *e = i->second->e;
+                            if( (e->ofs + e->len) <= mmf->length() ) {
+                                verify( mmf->view_write() );
+                                verify( e->srcData() );
+                                memcpy((char*)mmf->view_write() + e->ofs, e->srcData(), e->len);
+                            }
+                            else {
+                                // write past end of file.  permissible during recovery
+                                // (same as the serial path); fatal in WRITETODATAFILES -
+                                // the coordinating thread asserts on this flag.
+                                _writePastEof = true;
+                            }
+                        }
+                    }
+                    catch(...) {
+                        // rethrowing across the thread boundary isn't possible;
+                        // the coordinating thread asserts on this flag
+                        _failed = true;
+                    }
+                }
+
+            private:
+                typedef pair<DurableMappedFile*, const ParsedJournalEntry*> Work;
+                vector<Work> _work;
+                bool _failed;
+                bool _writePastEof;
+            };
+
+        }
+
+        bool RecoveryJob::tryApplyEntriesInParallel(const vector<ParsedJournalEntry>& entries) {
+            if( entries.size() < minEntriesToApplyInParallel )
+                return false;
+
+            unsigned nWorkers = boost::thread::hardware_concurrency();
+            if( nWorkers > maxApplyWorkers )
+                nWorkers = maxApplyWorkers;
+            if( nWorkers < 2 )
+                return false;
+
+            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                if( !i->e ) {
+                    // a DurOp (file create / drop db) orders against the basic
+                    // writes around it, so such sections replay serially
+                    return false;
+                }
+            }
+
+            // Resolve each entry's data file once, up front, and send all entries
+            // for a given file to the same worker.  Same-file writes thus keep
+            // their section order, and writes to different files are to disjoint
+            // mappings, so the workers never race.
+            Last last;
+            map<DurableMappedFile*, unsigned> workerByFile;
+            vector<SectionEntryApplier> workers(nWorkers);
+            unsigned nextWorker = 0;
+            unsigned long long totalBytes = 0;
+
+            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                verify( i->dbName );
+                verify( (size_t)strnlen(i->dbName, MaxDatabaseNameLen) < MaxDatabaseNameLen );
+
+                DurableMappedFile *mmf = last.newEntry(*i, *this);
+                pair<map<DurableMappedFile*, unsigned>::iterator, bool> r =
+                    workerByFile.insert( make_pair(mmf, nextWorker % nWorkers) );
+                if( r.second )
+                    nextWorker++;
+                workers[r.first->second].add(mmf, &*i);
+                totalBytes += i->e->len;
+            }
+
+            if( workerByFile.size() < 2 )
+                return false; // single data file - nothing to overlap
+
+            vector< boost::shared_ptr<boost::thread> > threads;
+            for( unsigned w = 0; w < nWorkers; ++w ) {
+                if( workers[w].size() )
+                    threads.push_back( boost::shared_ptr<boost::thread>(
+                                           new boost::thread( boost::ref(workers[w]) ) ) );
+            }
+            for( unsigned t = 0; t < threads.size(); ++t ) {
+                threads[t]->join();
+            }
+            for( unsigned w = 0; w < nWorkers; ++w ) {
+                massert( 17563, "Trying to write past end of file in WRITETODATAFILES",
+                         _recovering || !workers[w].writePastEof() );
+                massert( 17436, "error applying journal section in parallel",
+                         !workers[w].failed() );
+            }
+
+            stats.curr->_writeToDataFilesBytes += totalBytes;
+            return true;
+        }
+
         void RecoveryJob::applyEntries(const vector<ParsedJournalEntry> &entries) {
             bool apply = (storageGlobalParams.durOptions &
                           StorageGlobalParams::DurScanOnly) == 0;
@@ -357,16 +505,19 @@ namespace mongo {
             if( dump )
                 log() << "BEGIN section" << endl;
 
-            Last last;
-            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
-                applyEntry(last, *i, apply, dump);
+            if( !apply || dump || !tryApplyEntriesInParallel(entries) ) {
+                Last last;
+                for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                    applyEntry(last, *i, apply, dump);
+                }
             }
 
             if( dump )
                 log() << "END section" << endl;
         }
 
-        void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len, const JSectFooter *f) {
+        void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len,
+                                         const JSectFooter *f, unsigned journalVersion) {
             LockMongoFilesShared lkFiles; // for RecoveryJob::Last
             scoped_lock lk(_mx);
             RACECHECK
@@ -391,7 +542,8 @@ namespace mongo {
 
             auto_ptr<JournalSectionIterator> i;
             if( _recovering ) {
-                i = auto_ptr<JournalSectionIterator>(new JournalSectionIterator(*h, p, len, _recovering));
+                i = auto_ptr<JournalSectionIterator>(
+                        new JournalSectionIterator(*h, p, len, _recovering, journalVersion));
             }
             else { 
                 i = auto_ptr<JournalSectionIterator>(new JournalSectionIterator(*h, /*after header*/p, /*w/out header*/len));
@@ -436,6 +588,7 @@ namespace mongo {
         bool RecoveryJob::processFileBuffer(const void *p, unsigned len) {
             try {
                 unsigned long long fileId;
+                unsigned journalVersion = 0;
                 BufReader br(p,len);
 
                 {
@@ -460,6 +613,7 @@ namespace mongo {
                         uasserted(13536, str::stream() << "journal version number mismatch " << h._version);
                     }
                     fileId = h.fileId;
+                    journalVersion = h._version;
                     if (storageGlobalParams.durOptions &
                         StorageGlobalParams::DurDumpJournal) {
                         log() << "JHeader::fileId=" << fileId << endl;
@@ -483,7 +637,8 @@ namespace mongo {
                     const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
                     const char *data = hdr + sizeof(JSectHeader);
                     const char *footer = data + dataLen;
-                    processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
+                    processSection((const JSectHeader*) hdr, data, dataLen,
+                                   (const JSectFooter*) footer, journalVersion);
 
                     // ctrl c check
                     killCurrentOp.checkForInterrupt(false);
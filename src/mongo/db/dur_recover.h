@@ -61,8 +61,12 @@ namespace mongo {
             void go(vector<boost::filesystem::path>& files);
             ~RecoveryJob();
 
-            /** @param data data between header and footer. compressed if recovering. */
-            void processSection(const JSectHeader *h, const void *data, unsigned len, const JSectFooter *f);
+            /** @param data data between header and footer. compressed if recovering.
+                @param journalVersion JHeader::_version of the file being recovered;
+                       selects the payload format (single snappy stream vs framed
+                       blocks).  unused when not recovering. */
+            void processSection(const JSectHeader *h, const void *data, unsigned len,
+                                const JSectFooter *f, unsigned journalVersion = 0);
 
             void close(); // locks and calls _close()
 
@@ -71,6 +75,13 @@ namespace mongo {
             void write(Last& last, const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const vector<ParsedJournalEntry> &entries);
+
+            /** apply a section's basic writes across a small worker pool, all
+                entries for a given data file on one worker so same-file writes
+                keep their section order.  used both during recovery and by the
+                steady-state WRITETODATAFILES path for large group commits.
+                @return false if the section must take the serial path */
+            bool tryApplyEntriesInParallel(const vector<ParsedJournalEntry>& entries);
             bool processFileBuffer(const void *, unsigned len);
             bool processFile(boost::filesystem::path journalfile);
             void _close(); // doesn't lock
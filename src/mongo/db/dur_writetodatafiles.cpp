@@ -34,6 +34,7 @@
 #include "mongo/db/dur_recover.h"
 #include "mongo/db/dur_stats.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/io_throttle.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
@@ -84,8 +85,9 @@ namespace mongo {
             that which is going to be a remapped on its private view - but that might not be all
             views.
 
-            (2) todo should we do this using N threads?  would be quite easy
-                see Hackenberg paper table 5 and 6.  2 threads might be a good balance.
+            (2) large sections are applied across a small worker pool, one data file
+                per worker (see RecoveryJob::tryApplyEntriesInParallel).  see
+                Hackenberg paper table 5 and 6 on why a handful of threads is enough.
 
             (3) with enough work, we could do this outside the read lock.  it's a bit tricky though.
                 - we couldn't do it from the private views then as they may be changing.  would have to then
@@ -102,6 +104,11 @@ namespace mongo {
 #ifdef _WIN32
             SimpleMutex::scoped_lock _globalFlushMutex(globalFlushMutex);
 #endif
+            // pace the write-back against the flush class's I/O budget; the
+            // journal already has these writes, so delaying them only defers
+            // remapping, it doesn't affect durability
+            IoThrottle::global.request(IoThrottle::Flush, uncompressed.len());
+
             Timer t;
             WRITETODATAFILES_Impl1(h, uncompressed);
             unsigned long long m = t.micros();
@@ -49,6 +49,7 @@ namespace mongo {
 
     PlanStage::StageState TwoDNear::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
         if (!_initted) {
             _initted = true;
 
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/and_hash.h"
 
+#include "mongo/db/client.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/exec/and_common-inl.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -54,6 +56,7 @@ namespace mongo {
           _hashingChildren(true),
           _currentChild(0),
           _memUsage(0),
+          _memReported(0),
           _maxMemUsage(kDefaultMaxMemUsageBytes) {}
 
     AndHashStage::AndHashStage(WorkingSet* ws, const MatchExpression* filter, size_t maxMemUsage)
@@ -62,6 +65,7 @@ namespace mongo {
           _hashingChildren(true),
           _currentChild(0),
           _memUsage(0),
+          _memReported(0),
           _maxMemUsage(maxMemUsage) {}
 
     AndHashStage::~AndHashStage() {
@@ -94,6 +98,16 @@ namespace mongo {
 
     PlanStage::StageState AndHashStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
+
+        // Keep the op-wide memory accounting (db.currentOp() "memUsed") in step with our
+        // buffered data.  At most one work() call behind, since the buffer only changes
+        // inside work().
+        if (_memUsage != _memReported) {
+            cc().curop()->adjustMemAccounted(static_cast<long long>(_memUsage) -
+                                             static_cast<long long>(_memReported));
+            _memReported = _memUsage;
+        }
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -212,6 +226,14 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
+        // Most of the last child's locs aren't in the intersection; the bloom filter
+        // rejects them without a hash table walk.
+        if (!_bloom.mayContain(member->loc)) {
+            _ws->free(*out);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
         DataMap::iterator it = _dataMap.find(member->loc);
         if (_dataMap.end() == it) {
             // Child's output wasn't in every previous child.  Throw it out.
@@ -275,6 +297,7 @@ namespace mongo {
             verify(_dataMap.end() == _dataMap.find(member->loc));
 
             _dataMap[member->loc] = id;
+            _bloom.add(member->loc);
 
             // Update memory stats.
             _memUsage += member->getMemUsage();
@@ -340,8 +363,10 @@ namespace mongo {
             }
 
             verify(member->hasLoc());
-            if (_dataMap.end() == _dataMap.find(member->loc)) {
-                // Ignore.  It's not in any previous child.
+            if (!_bloom.mayContain(member->loc) ||
+                _dataMap.end() == _dataMap.find(member->loc)) {
+                // Ignore.  It's not in any previous child.  The bloom filter rejects
+                // most such probes before we touch _dataMap at all.
             }
             else {
                 // We have a hit.  Copy data into the WSM we already have.
@@ -365,7 +390,7 @@ namespace mongo {
             // Keep elements of _dataMap that are in _seenMap.
             DataMap::iterator it = _dataMap.begin();
             while (it != _dataMap.end()) {
-                if (_seenMap.end() == _seenMap.find(it->first)) {
+                if (!_seenMap.contains(it->first)) {
                     DataMap::iterator toErase = it;
                     ++it;
 
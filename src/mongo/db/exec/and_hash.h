@@ -33,6 +33,7 @@
 
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/exec/diskloc_filter.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/platform/unordered_set.h"
@@ -104,10 +105,15 @@ namespace mongo {
         typedef unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> DataMap;
         DataMap _dataMap;
 
+        // Bloom filter over the first child's locs.  Probes from later children mostly miss,
+        // and the filter rejects them without touching _dataMap.  Never updated on erase, so
+        // it may return stale positives; those just fall through to the authoritative map.
+        DiskLocBloomFilter _bloom;
+
         // Keeps track of what elements from _dataMap subsequent children have seen.
-        // Only used while _hashingChildren.
-        typedef unordered_set<DiskLoc, DiskLoc::Hasher> SeenMap;
-        SeenMap _seenMap;
+        // Only used while _hashingChildren.  Flat open-addressing set: insert/lookup only,
+        // cleared after each child, so it needs no removal support.
+        DiskLocFlatSet _seenMap;
 
         // True if we're still intersecting _children[0..._children.size()-1].
         bool _hashingChildren;
@@ -124,6 +130,9 @@ namespace mongo {
         // For simplicity, results in _lookAheadResults do not count towards the limit.
         size_t _memUsage;
 
+        // What we last reported to CurOp's per-op memory accounting; see work().
+        size_t _memReported;
+
         // Upper limit for buffered data memory usage.
         // Defaults to 32 MB (See kMaxBytes in and_hash.cpp).
         size_t _maxMemUsage;
@@ -51,6 +51,7 @@ namespace mongo {
 
     PlanStage::StageState AndSortedStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -50,6 +50,7 @@ namespace mongo {
 
     PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
         if (_nsDropped) { return PlanStage::DEAD; }
 
         if (NULL == _iter) {
@@ -61,7 +62,9 @@ namespace mongo {
 
             _iter.reset( collection->getIterator( _params.start,
                                                   _params.tailable,
-                                                  _params.direction ) );
+                                                  _params.direction,
+                                                  _params.adviseDontNeed,
+                                                  _params.cooperative ) );
 
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
@@ -107,6 +110,11 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState CollectionScan::workBatch(size_t maxOut,
+                                                    std::vector<WorkingSetID>* out) {
+        return batchViaWork(this, maxOut, out);
+    }
+
     bool CollectionScan::isEOF() {
         if ((0 != _params.maxScan) && (_specificStats.docsTested >= _params.maxScan)) {
             return true;
@@ -51,6 +51,7 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxOut, std::vector<WorkingSetID>* out);
         virtual bool isEOF();
 
         virtual void invalidate(const DiskLoc& dl, InvalidationType type);
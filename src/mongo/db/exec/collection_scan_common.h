@@ -41,7 +41,9 @@ namespace mongo {
         CollectionScanParams() : start(DiskLoc()),
                                  direction(FORWARD),
                                  tailable(false),
-                                 maxScan(0) { }
+                                 maxScan(0),
+                                 adviseDontNeed(false),
+                                 cooperative(false) { }
 
         // What collection?
         string ns;
@@ -57,6 +59,20 @@ namespace mongo {
 
         // If non-zero, how many documents will we look at?
         size_t maxScan;
+
+        // If true, hint to the OS that pages this scan faults in will not be needed again
+        // soon, so a one-off scan of a cold collection (dbhash, validate, backups) does not
+        // evict the hot working set from the page cache.  Advisory only; correctness is
+        // unaffected.  Ignored for capped collections.
+        bool adviseDontNeed;
+
+        // If true, this scan may join a sweep another full scan of the same collection
+        // already has in flight: it starts at that scan's current extent and wraps
+        // around at the end to cover what it skipped, so concurrent scans fault each
+        // extent once between them.  Documents come back out of natural order, so only
+        // set this when the consumer imposes its own order (or none).  Requires a full
+        // forward scan (start isNull, not tailable); ignored for capped collections.
+        bool cooperative;
     };
 
 }  // namespace mongo
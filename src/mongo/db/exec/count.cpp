@@ -30,6 +30,7 @@
 
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/stats/index_usage_tracker.h"
 
 namespace mongo {
 
@@ -40,7 +41,9 @@ namespace mongo {
           _btreeCursor(NULL),
           _params(params),
           _hitEnd(false),
-          _shouldDedup(params.descriptor->isMultikey()) { }
+          _shouldDedup(params.descriptor->isMultikey()) {
+        IndexUsageTracker::global.recordAccess(_descriptor->indexNamespace());
+    }
 
     void Count::initIndexCursor() {
         CursorOptions cursorOptions;
@@ -0,0 +1,160 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/diskloc.h"
+
+namespace mongo {
+
+    /**
+     * Strong 64-bit mix of a DiskLoc for the probabilistic/flat structures below.
+     * DiskLoc::Hasher xors two (often identity) int hashes, which clusters badly
+     * for linear probing and bloom indexing; this runs the packed loc through a
+     * multiplicative finalizer instead.
+     */
+    inline unsigned long long dedicatedDiskLocHash(const DiskLoc& loc) {
+        unsigned long long x =
+            (static_cast<unsigned long long>(static_cast<unsigned int>(loc.a())) << 32)
+            | static_cast<unsigned int>(loc.getOfs());
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    /**
+     * Fixed-size bloom filter over DiskLocs.  Sized to stay cache resident so a
+     * membership probe that misses costs two bit tests instead of a hash table
+     * walk.  False positives only cost the lookup that would have happened
+     * anyway, so the filter may go stale (elements removed from the backing
+     * structure are not removed here) and degrades gracefully toward plain
+     * table performance when overfull.
+     */
+    class DiskLocBloomFilter {
+    public:
+        DiskLocBloomFilter() : _words(kNumWords, 0) {}
+
+        void add(const DiskLoc& loc) {
+            const unsigned long long h = dedicatedDiskLocHash(loc);
+            _words[word(h)] |= bit(h);
+            _words[word(h >> 32)] |= bit(h >> 32);
+        }
+
+        /** false means 'loc' was definitely never add()ed. */
+        bool mayContain(const DiskLoc& loc) const {
+            const unsigned long long h = dedicatedDiskLocHash(loc);
+            return (_words[word(h)] & bit(h))
+                && (_words[word(h >> 32)] & bit(h >> 32));
+        }
+
+        void clear() { _words.assign(kNumWords, 0); }
+
+    private:
+        // 2^20 bits = 128KB: small enough to sit in L2, large enough that the
+        // false positive rate stays low for typical intersection inputs.
+        static const size_t kNumBits = 1 << 20;
+        static const size_t kNumWords = kNumBits / 64;
+
+        static size_t word(unsigned long long h) { return (h & (kNumBits - 1)) >> 6; }
+        static unsigned long long bit(unsigned long long h) { return 1ULL << (h & 63); }
+
+        std::vector<unsigned long long> _words;
+    };
+
+    /**
+     * Open-addressing set of DiskLocs with linear probing.  A DiskLoc is 8
+     * bytes, so the table is a flat array of them -- no per-entry allocation
+     * and at most one cache line touched for most probes.  The null DiskLoc
+     * marks an empty slot and therefore cannot be stored; supports insert,
+     * lookup and clear but not removal (no tombstones needed).
+     */
+    class DiskLocFlatSet {
+    public:
+        DiskLocFlatSet() : _slots(kInitialSlots), _size(0) {}
+
+        /** 'loc' must not be null. */
+        void insert(const DiskLoc& loc) {
+            dassert(!loc.isNull());
+            if ((_size + 1) * 3 > _slots.size() * 2) {
+                grow();
+            }
+            if (insertInto(_slots, loc)) {
+                ++_size;
+            }
+        }
+
+        bool contains(const DiskLoc& loc) const {
+            const size_t mask = _slots.size() - 1;
+            for (size_t i = dedicatedDiskLocHash(loc) & mask; ; i = (i + 1) & mask) {
+                if (_slots[i] == loc) { return true; }
+                if (_slots[i].isNull()) { return false; }
+            }
+        }
+
+        size_t size() const { return _size; }
+
+        void clear() {
+            _slots.assign(kInitialSlots, DiskLoc());
+            _size = 0;
+        }
+
+    private:
+        static const size_t kInitialSlots = 64; // power of two
+
+        /** @return true if 'loc' was not already present. */
+        static bool insertInto(std::vector<DiskLoc>& slots, const DiskLoc& loc) {
+            const size_t mask = slots.size() - 1;
+            for (size_t i = dedicatedDiskLocHash(loc) & mask; ; i = (i + 1) & mask) {
+                if (slots[i] == loc) { return false; }
+                if (slots[i].isNull()) {
+                    slots[i] = loc;
+                    return true;
+                }
+            }
+        }
+
+        void grow() {
+            std::vector<DiskLoc> bigger(_slots.size() * 2);
+            for (size_t i = 0; i < _slots.size(); ++i) {
+                if (!_slots[i].isNull()) {
+                    insertInto(bigger, _slots[i]);
+                }
+            }
+            _slots.swap(bigger);
+        }
+
+        std::vector<DiskLoc> _slots; // kept at most 2/3 full
+        size_t _size;
+    };
+
+}  // namespace mongo
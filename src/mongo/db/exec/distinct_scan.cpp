@@ -33,6 +33,7 @@
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/stats/index_usage_tracker.h"
 
 namespace mongo {
 
@@ -42,7 +43,9 @@ namespace mongo {
           _iam(params.descriptor->getIndexCatalog()->getIndex(params.descriptor)),
           _btreeCursor(NULL),
           _hitEnd(false),
-          _params(params) { }
+          _params(params) {
+        IndexUsageTracker::global.recordAccess(_descriptor->indexNamespace());
+    }
 
     void DistinctScan::initIndexCursor() {
         // Create an IndexCursor over the btree we're distinct-ing over.
@@ -87,6 +90,7 @@ namespace mongo {
 
     PlanStage::StageState DistinctScan::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         if (NULL == _btreeCursor.get()) {
             // First call to work().  Perform cursor init.
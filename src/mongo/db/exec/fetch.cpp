@@ -45,6 +45,11 @@ namespace mongo {
     FetchStage::~FetchStage() { }
 
     bool FetchStage::isEOF() {
+        if (!_batchedInput.empty()) {
+            // workBatch(...) is holding child results we haven't processed yet.
+            return false;
+        }
+
         if (WorkingSet::INVALID_ID != _idBeingPagedIn) {
             // We asked our parent for a page-in but he didn't get back to us.  We still need to
             // return the result that _idBeingPagedIn refers to.
@@ -68,6 +73,7 @@ namespace mongo {
 
     PlanStage::StageState FetchStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -138,6 +144,118 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState FetchStage::workBatch(size_t maxOut, std::vector<WorkingSetID>* out) {
+        ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
+
+        if (hasStashedStatus()) { return unstashStatus(out); }
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        // If we asked our parent for a page-in, finish that fetch first; it is our oldest result.
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            if (PlanStage::ADVANCED == fetchCompleted(&id)) {
+                out->push_back(id);
+            }
+        }
+
+        // Filtered-out documents consume budget too; see batchViaWork in plan_stage.h.
+        size_t processed = 0;
+        while (out->size() < maxOut && processed < maxOut) {
+            if (_batchedInput.empty()) {
+                // Ask the child for more.
+                if (_child->isEOF()) {
+                    break;
+                }
+                _childBatch.clear();
+                StageState status = _child->workBatch(maxOut - out->size(), &_childBatch);
+
+                if (PlanStage::ADVANCED == status) {
+                    _batchedInput.insert(_batchedInput.end(),
+                                         _childBatch.begin(), _childBatch.end());
+                    continue;
+                }
+                else if (PlanStage::NEED_TIME == status) {
+                    ++_commonStats.needTime;
+                    if (out->empty()) { return status; }
+                    break;
+                }
+                else if (PlanStage::IS_EOF == status) {
+                    break;
+                }
+                else {
+                    // NEED_FETCH, FAILURE or DEAD.
+                    WorkingSetID id = _childBatch.empty() ? WorkingSet::INVALID_ID
+                                                          : _childBatch[0];
+                    if (PlanStage::FAILURE == status && WorkingSet::INVALID_ID == id) {
+                        mongoutils::str::stream ss;
+                        ss << "fetch stage failed to read in results from child";
+                        Status failStatus(ErrorCodes::InternalError, ss);
+                        id = WorkingSetCommon::allocateStatusMember(_ws, failStatus);
+                    }
+                    if (PlanStage::NEED_FETCH == status) {
+                        ++_commonStats.needFetch;
+                    }
+                    if (out->empty()) {
+                        if (PlanStage::NEED_FETCH == status || PlanStage::FAILURE == status) {
+                            out->push_back(id);
+                        }
+                        return status;
+                    }
+                    stashStatus(status, id);
+                    break;
+                }
+            }
+
+            ++processed;
+            WorkingSetID id = _batchedInput.front();
+            WorkingSetMember* member = _ws->get(id);
+
+            if (member->hasObj()) {
+                // Either the child's result already carried an object, or an invalidation
+                // while it was queued here forced a fetch.
+                ++_specificStats.alreadyHasObj;
+            }
+            else {
+                // We need a valid loc to fetch from and this is the only state that has one.
+                verify(WorkingSetMember::LOC_AND_IDX == member->state);
+                verify(member->hasLoc());
+
+                Record* record = member->loc.rec();
+                const char* data = record->dataNoThrowing();
+
+                if (!recordInMemory(data)) {
+                    if (!out->empty()) {
+                        // Deliver what we have; the page-in request stays at the head of the
+                        // queue for the next call.
+                        return PlanStage::ADVANCED;
+                    }
+                    verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
+                    _batchedInput.pop_front();
+                    _idBeingPagedIn = id;
+                    out->push_back(id);
+                    ++_commonStats.needFetch;
+                    return PlanStage::NEED_FETCH;
+                }
+
+                // Don't need index data anymore as we have an obj.
+                member->keyData.clear();
+                member->obj = BSONObj(data);
+                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            }
+
+            _batchedInput.pop_front();
+            WorkingSetID outId = WorkingSet::INVALID_ID;
+            if (PlanStage::ADVANCED == returnIfMatches(member, id, &outId)) {
+                out->push_back(outId);
+            }
+        }
+
+        if (!out->empty()) { return PlanStage::ADVANCED; }
+        return isEOF() ? PlanStage::IS_EOF : PlanStage::NEED_TIME;
+    }
+
     void FetchStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
@@ -162,6 +280,15 @@ namespace mongo {
                 WorkingSetCommon::fetchAndInvalidateLoc(member);
             }
         }
+
+        // Child results queued by workBatch(...) get the same treatment.
+        for (std::deque<WorkingSetID>::const_iterator it = _batchedInput.begin();
+             it != _batchedInput.end(); ++it) {
+            WorkingSetMember* member = _ws->get(*it);
+            if (member->hasLoc() && (member->loc == dl)) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+            }
+        }
     }
 
     PlanStage::StageState FetchStage::fetchCompleted(WorkingSetID* out) {
@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <deque>
+#include <vector>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -50,6 +53,7 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxOut, std::vector<WorkingSetID>* out);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
@@ -81,6 +85,13 @@ namespace mongo {
         // a "please page this in" result and hold on to the WSID until the next call to work(...).
         WorkingSetID _idBeingPagedIn;
 
+        // Child results pulled by workBatch(...) that we haven't processed yet, oldest first.
+        // invalidate(...) must fix these up just like _idBeingPagedIn.
+        std::deque<WorkingSetID> _batchedInput;
+
+        // Scratch space for pulling a batch from our child; keeps its allocation across calls.
+        std::vector<WorkingSetID> _childBatch;
+
         // Stats
         CommonStats _commonStats;
         FetchStats _specificStats;
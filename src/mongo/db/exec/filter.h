@@ -40,7 +40,7 @@ namespace mongo {
      */
     class WorkingSetMatchableDocument : public MatchableDocument {
     public:
-        WorkingSetMatchableDocument(WorkingSetMember* wsm) : _wsm(wsm) { }
+        WorkingSetMatchableDocument(WorkingSetMember* wsm) : _wsm(wsm), _iteratorUsed(false) { }
         virtual ~WorkingSetMatchableDocument() { }
 
         // This is only called by a $where query.  The query system must be smart enough to realize
@@ -54,7 +54,15 @@ namespace mongo {
             // BSONElementIterator does some interesting things with arrays that I don't think
             // SimpleArrayElementIterator does.
             if (_wsm->hasObj()) {
-                return new BSONElementIterator(path, _wsm->obj);
+                // Reuse an inline iterator for the common one-at-a-time case, as
+                // BSONMatchableDocument does; a filter with many leaves hops
+                // through here once per leaf per document.
+                if (_iteratorUsed) {
+                    return new BSONElementIterator(path, _wsm->obj);
+                }
+                _iteratorUsed = true;
+                _iterator.reset(path, _wsm->obj);
+                return &_iterator;
             }
 
             // NOTE: This (kind of) duplicates code in WorkingSetMember::getFieldDotted.
@@ -89,18 +97,26 @@ namespace mongo {
         }
 
         virtual void releaseIterator( ElementIterator* iterator ) const {
-            delete iterator;
+            if (iterator == &_iterator) {
+                _iteratorUsed = false;
+            }
+            else {
+                delete iterator;
+            }
         }
 
     private:
         WorkingSetMember* _wsm;
+        mutable BSONElementIterator _iterator;
+        mutable bool _iteratorUsed;
     };
 
     class IndexKeyMatchableDocument : public MatchableDocument {
     public:
         IndexKeyMatchableDocument(const BSONObj& key,
                                   const BSONObj& keyPattern)
-            : _keyPattern(keyPattern), _key(key) { }
+            : _keyPattern(keyPattern), _key(key),
+              _iterator(BSONElement()), _iteratorUsed(false) { }
 
         BSONObj toBSON() const {
             // Planning shouldn't let this happen.
@@ -120,6 +136,13 @@ namespace mongo {
                     if (Array == keyDataElt.type()) {
                         return new SimpleArrayElementIterator(keyDataElt, true);
                     }
+                    else if (!_iteratorUsed) {
+                        // Reuse an inline iterator as BSONMatchableDocument
+                        // does - one allocation saved per leaf per key.
+                        _iteratorUsed = true;
+                        _iterator.reset(keyDataElt);
+                        return &_iterator;
+                    }
                     else {
                         return new SingleElementElementIterator(keyDataElt);
                     }
@@ -135,12 +158,19 @@ namespace mongo {
         }
 
         virtual void releaseIterator(ElementIterator* iterator) const {
-            delete iterator;
+            if (iterator == &_iterator) {
+                _iteratorUsed = false;
+            }
+            else {
+                delete iterator;
+            }
         }
 
     private:
         BSONObj _keyPattern;
         BSONObj _key;
+        mutable SingleElementElementIterator _iterator;
+        mutable bool _iteratorUsed;
     };
 
     /**
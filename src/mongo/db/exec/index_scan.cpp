@@ -33,6 +33,7 @@
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/stats/index_usage_tracker.h"
 
 namespace {
 
@@ -60,6 +61,8 @@ namespace mongo {
 
         _iam = _descriptor->getIndexCatalog()->getIndex(_descriptor);
 
+        IndexUsageTracker::global.recordAccess(_descriptor->indexNamespace());
+
         if (_params.doNotDedup) {
             _shouldDedup = false;
         }
@@ -125,6 +128,7 @@ namespace mongo {
 
     PlanStage::StageState IndexScan::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         if (NULL == _indexCursor.get()) {
             // First call to work().  Perform cursor init.
@@ -193,6 +197,11 @@ namespace mongo {
         return PlanStage::NEED_TIME;
     }
 
+    PlanStage::StageState IndexScan::workBatch(size_t maxOut,
+                                               std::vector<WorkingSetID>* out) {
+        return batchViaWork(this, maxOut, out);
+    }
+
     bool IndexScan::isEOF() {
         if (NULL == _indexCursor.get()) {
             // Have to call work() at least once.
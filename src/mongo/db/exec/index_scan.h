@@ -86,6 +86,7 @@ namespace mongo {
         virtual ~IndexScan() { }
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxOut, std::vector<WorkingSetID>* out);
         virtual bool isEOF();
         virtual void prepareToYield();
         virtual void recoverFromYield();
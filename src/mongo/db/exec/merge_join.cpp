@@ -0,0 +1,338 @@
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/exec/merge_join.h"
+
+#include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+    // Cap on the bytes buffered in equal-key runs and unreturned joined
+    // documents.  A run only grows while consecutive keys are equal, so this
+    // is a guard against degenerate data, not a working limit.
+    const size_t kMaxJoinedBytes = 32 * 1024 * 1024;
+}
+
+namespace mongo {
+
+    MergeJoinStage::MergeJoinStage(const MergeJoinStageParams& params, WorkingSet* ws,
+                                   const MatchExpression* filter,
+                                   PlanStage* left, PlanStage* right)
+        : _ws(ws),
+          _filter(filter),
+          _joinFields(params.joinFields),
+          _direction(params.direction),
+          _memUsage(0) {
+        verify(_joinFields >= 1);
+        _left.stage = left;
+        _right.stage = right;
+    }
+
+    MergeJoinStage::~MergeJoinStage() {
+        delete _left.stage;
+        delete _right.stage;
+    }
+
+    bool MergeJoinStage::isEOF() {
+        // Done when nothing is buffered and either side can't produce another
+        // row: a lone look-ahead on the surviving side has nothing to match.
+        return _joined.empty()
+            && _left.run.empty()
+            && _right.run.empty()
+            && ((_left.eof && !_left.haveNext) || (_right.eof && !_right.haveNext));
+    }
+
+    PlanStage::StageState MergeJoinStage::work(WorkingSetID* out) {
+        ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        // Return a joined document if we have one ready.
+        if (!_joined.empty()) {
+            BSONObj obj = _joined.front();
+            _joined.pop_front();
+            _memUsage -= obj.objsize();
+
+            WorkingSetID id = _ws->allocate();
+            WorkingSetMember* member = _ws->get(id);
+            member->obj = obj;
+            member->state = WorkingSetMember::OWNED_OBJ;
+
+            if (Filter::passes(member, _filter)) {
+                *out = id;
+                ++_commonStats.advanced;
+                return PlanStage::ADVANCED;
+            }
+
+            _ws->free(id);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        // Keep both look-aheads filled.
+        if (!_left.haveNext && !_left.eof) { return workChild(&_left, out); }
+        if (!_right.haveNext && !_right.eof) { return workChild(&_right, out); }
+
+        if (_left.run.empty()) {
+            // No runs are being collected.  Compare the two look-ahead keys and
+            // either discard the smaller row or, on a match, seed the runs.
+            if (!_left.haveNext || !_right.haveNext) {
+                // One side is exhausted, so no more matches are possible.
+                return PlanStage::IS_EOF;
+            }
+
+            const int cmp = compareKeys(_left.next.key, _right.next.key);
+            if (cmp < 0) {
+                _left.haveNext = false;
+                _left.next = BufferedRow();
+            }
+            else if (cmp > 0) {
+                _right.haveNext = false;
+                _right.next = BufferedRow();
+            }
+            else {
+                _memUsage += _left.next.key.objsize() + _right.next.key.objsize();
+                _left.run.push_back(_left.next);
+                _left.haveNext = false;
+                _left.next = BufferedRow();
+                _right.run.push_back(_right.next);
+                _right.haveNext = false;
+                _right.next = BufferedRow();
+                ++_specificStats.runsMatched;
+            }
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        // Runs are being collected.  Extend them while the look-ahead keys still
+        // equal the run key.  (The look-aheads were refilled above, so a side
+        // without one is at EOF and its run is complete.)
+        const BSONObj& runKey = _left.run.front().key;
+        if (_left.haveNext && 0 == compareKeys(_left.next.key, runKey)) {
+            _memUsage += _left.next.key.objsize();
+            _left.run.push_back(_left.next);
+            _left.haveNext = false;
+            _left.next = BufferedRow();
+            if (_memUsage > kMaxJoinedBytes) { return memLimitExceeded(out); }
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        if (_right.haveNext && 0 == compareKeys(_right.next.key, runKey)) {
+            _memUsage += _right.next.key.objsize();
+            _right.run.push_back(_right.next);
+            _right.haveNext = false;
+            _right.next = BufferedRow();
+            if (_memUsage > kMaxJoinedBytes) { return memLimitExceeded(out); }
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        // Both runs are complete; emit their cross product.
+        return buildJoinedRows(out);
+    }
+
+    PlanStage::StageState MergeJoinStage::workChild(Side* side, WorkingSetID* out) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState code = side->stage->work(&id);
+
+        if (PlanStage::ADVANCED == code) {
+            WorkingSetMember* member = _ws->get(id);
+
+            // We join on index keys; a child that can't provide one (plus a
+            // location to fetch the document from) is a malformed plan.
+            if (member->keyData.empty() || !member->hasLoc()) {
+                _ws->free(id);
+                Status status(ErrorCodes::BadValue,
+                              "merge join child returned a result without index key data");
+                *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                return PlanStage::FAILURE;
+            }
+
+            // Copy what the join needs out of the member and recycle it.
+            side->next.loc = member->loc;
+            side->next.doc = BSONObj();
+
+            BSONObjBuilder keyBob;
+            BSONObjIterator it(member->keyData[0].keyData);
+            for (size_t i = 0; i < _joinFields && it.more(); ++i) {
+                keyBob.append(it.next());
+            }
+            side->next.key = keyBob.obj();
+
+            side->haveNext = true;
+            _ws->free(id);
+
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        else if (PlanStage::IS_EOF == code) {
+            side->eof = true;
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        else if (PlanStage::FAILURE == code) {
+            *out = id;
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case 'id' is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == id) {
+                mongoutils::str::stream ss;
+                ss << "merge join stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+            }
+            return code;
+        }
+        else {
+            if (PlanStage::NEED_FETCH == code) {
+                *out = id;
+                ++_commonStats.needFetch;
+            }
+            else if (PlanStage::NEED_TIME == code) {
+                ++_commonStats.needTime;
+            }
+            return code;
+        }
+    }
+
+    PlanStage::StageState MergeJoinStage::buildJoinedRows(WorkingSetID* out) {
+        // Fetch each right-hand document once, not once per pair.
+        vector<BSONObj> rightDocs;
+        rightDocs.reserve(_right.run.size());
+        for (std::deque<BufferedRow>::const_iterator it = _right.run.begin();
+             it != _right.run.end(); ++it) {
+            rightDocs.push_back(fetchRow(*it));
+        }
+
+        for (std::deque<BufferedRow>::const_iterator it = _left.run.begin();
+             it != _left.run.end(); ++it) {
+            BSONObj leftDoc = fetchRow(*it);
+            for (size_t i = 0; i < rightDocs.size(); ++i) {
+                BSONObjBuilder bob;
+                bob.append("left", leftDoc);
+                bob.append("right", rightDocs[i]);
+                BSONObj joined = bob.obj();
+                _memUsage += joined.objsize();
+                _joined.push_back(joined);
+                ++_specificStats.pairsBuffered;
+            }
+        }
+
+        for (std::deque<BufferedRow>::const_iterator it = _left.run.begin();
+             it != _left.run.end(); ++it) {
+            _memUsage -= it->key.objsize() + it->doc.objsize();
+        }
+        for (std::deque<BufferedRow>::const_iterator it = _right.run.begin();
+             it != _right.run.end(); ++it) {
+            _memUsage -= it->key.objsize() + it->doc.objsize();
+        }
+        _left.run.clear();
+        _right.run.clear();
+
+        if (_memUsage > kMaxJoinedBytes) { return memLimitExceeded(out); }
+
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    BSONObj MergeJoinStage::fetchRow(const BufferedRow& row) {
+        if (!row.doc.isEmpty()) { return row.doc; }
+        return row.loc.obj();
+    }
+
+    void MergeJoinStage::materialize(BufferedRow* row) {
+        // Forced fetch: the document is going away (or changing), so copy it
+        // out now.  _joined already holds owned objects and is unaffected.
+        row->doc = row->loc.obj().getOwned();
+        row->loc = DiskLoc();
+        _memUsage += row->doc.objsize();
+        ++_specificStats.forcedFetches;
+    }
+
+    void MergeJoinStage::invalidateSide(Side* side, const DiskLoc& dl) {
+        if (side->haveNext && dl == side->next.loc) {
+            materialize(&side->next);
+        }
+        for (std::deque<BufferedRow>::iterator it = side->run.begin();
+             it != side->run.end(); ++it) {
+            if (dl == it->loc) {
+                materialize(&*it);
+            }
+        }
+    }
+
+    void MergeJoinStage::invalidate(const DiskLoc& dl, InvalidationType type) {
+        ++_commonStats.invalidates;
+        _left.stage->invalidate(dl, type);
+        _right.stage->invalidate(dl, type);
+
+        invalidateSide(&_left, dl);
+        invalidateSide(&_right, dl);
+    }
+
+    void MergeJoinStage::prepareToYield() {
+        ++_commonStats.yields;
+        _left.stage->prepareToYield();
+        _right.stage->prepareToYield();
+    }
+
+    void MergeJoinStage::recoverFromYield() {
+        ++_commonStats.unyields;
+        _left.stage->recoverFromYield();
+        _right.stage->recoverFromYield();
+    }
+
+    int MergeJoinStage::compareKeys(const BSONObj& lhs, const BSONObj& rhs) const {
+        // Index keys have empty field names; compare values only.  The
+        // direction flips the ordering but not equality.
+        return _direction * lhs.woCompare(rhs, BSONObj(), false);
+    }
+
+    PlanStage::StageState MergeJoinStage::memLimitExceeded(WorkingSetID* out) {
+        mongoutils::str::stream ss;
+        ss << "merge join buffered more than " << kMaxJoinedBytes << " bytes of data";
+        Status status(ErrorCodes::InternalError, ss);
+        *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        return PlanStage::FAILURE;
+    }
+
+    PlanStageStats* MergeJoinStage::getStats() {
+        _commonStats.isEOF = isEOF();
+
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_MERGE_JOIN));
+        ret->specific.reset(new MergeJoinStats(_specificStats));
+        ret->children.push_back(_left.stage->getStats());
+        ret->children.push_back(_right.stage->getStats());
+        return ret.release();
+    }
+
+}  // namespace mongo
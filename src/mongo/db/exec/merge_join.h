@@ -0,0 +1,173 @@
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+    // External params for the merge join stage.  Declared below.
+    class MergeJoinStageParams;
+
+    /**
+     * Joins the outputs of two children on index key equality.  Each child must
+     * produce index keys (practically speaking, both children are IndexScans,
+     * possibly over different collections) in the same order on the leading
+     * 'joinFields' components of its key; those components are the join key.
+     *
+     * The two streams are advanced in lockstep, classic sort-merge style: the
+     * side with the smaller key is advanced, and when the keys are equal the
+     * full run of equal-keyed rows is buffered from both sides and the cross
+     * product is emitted, one document of the form
+     *
+     *   { left: <left document>, right: <right document> }
+     *
+     * per work() call.  This replaces an N+1 client-side lookup pattern with a
+     * single streamed join over two sorted scans.
+     *
+     * Exposed through the stageDebug command; not (yet) produced by the query
+     * planner.
+     */
+    class MergeJoinStage : public PlanStage {
+    public:
+        /**
+         * Takes ownership of 'left' and 'right'.  'filter', which may be NULL,
+         * applies to the joined documents and is not owned.
+         */
+        MergeJoinStage(const MergeJoinStageParams& params, WorkingSet* ws,
+                       const MatchExpression* filter, PlanStage* left, PlanStage* right);
+        virtual ~MergeJoinStage();
+
+        virtual bool isEOF();
+        virtual StageState work(WorkingSetID* out);
+
+        virtual void prepareToYield();
+        virtual void recoverFromYield();
+        virtual void invalidate(const DiskLoc& dl, InvalidationType type);
+
+        PlanStageStats* getStats();
+
+    private:
+        // A row pulled off a child, reduced to what the join needs.
+        struct BufferedRow {
+            BufferedRow() { }
+
+            // Where the document lives, unless it was invalidated from under us.
+            DiskLoc loc;
+
+            // Owned copy of the leading 'joinFields' components of the index key.
+            BSONObj key;
+
+            // Owned copy of the document.  Set eagerly only when 'loc' is
+            // invalidated; otherwise the document is fetched when the row joins.
+            BSONObj doc;
+        };
+
+        // One side of the join.
+        struct Side {
+            Side() : stage(NULL), eof(false), haveNext(false) { }
+
+            PlanStage* stage;  // Owned by the enclosing stage.
+
+            bool eof;
+
+            // The look-ahead row: the last row pulled off 'stage', not yet
+            // assigned to a run or discarded.
+            bool haveNext;
+            BufferedRow next;
+
+            // The run of rows whose keys all equal the current run key.
+            std::deque<BufferedRow> run;
+        };
+
+        // Works the side's child once to refill side->next.  Returns NEED_TIME on
+        // progress; anything else is passed through to our caller.
+        StageState workChild(Side* side, WorkingSetID* out);
+
+        // Emits the cross product of the two completed runs into _joined and
+        // clears the runs.
+        StageState buildJoinedRows(WorkingSetID* out);
+
+        // Returns the row's document, fetching it if it wasn't forced into
+        // memory by an invalidation.
+        static BSONObj fetchRow(const BufferedRow& row);
+
+        // Force-fetches a buffered row's document ahead of an invalidation.
+        void materialize(BufferedRow* row);
+        void invalidateSide(Side* side, const DiskLoc& dl);
+
+        int compareKeys(const BSONObj& lhs, const BSONObj& rhs) const;
+
+        StageState memLimitExceeded(WorkingSetID* out);
+
+        // Not owned by us.
+        WorkingSet* _ws;
+
+        // Not owned by us.
+        const MatchExpression* _filter;
+
+        // How many leading index key components form the join key.
+        size_t _joinFields;
+
+        // 1 if the children produce join keys in ascending order, -1 if descending.
+        int _direction;
+
+        Side _left;
+        Side _right;
+
+        // Joined documents (owned) waiting to be returned.
+        std::deque<BSONObj> _joined;
+
+        // Bytes buffered in the runs and in _joined, to bound equal-key runs.
+        size_t _memUsage;
+
+        // Stats
+        CommonStats _commonStats;
+        MergeJoinStats _specificStats;
+    };
+
+    // Parameters that must be provided to a MergeJoinStage
+    class MergeJoinStageParams {
+    public:
+        MergeJoinStageParams() : joinFields(1), direction(1) { }
+
+        // How many leading index key components form the join key.
+        size_t joinFields;
+
+        // The order both children produce join keys in: 1 ascending, -1 descending.
+        int direction;
+    };
+
+}  // namespace mongo
@@ -57,6 +57,7 @@ namespace mongo {
 
     PlanStage::StageState MergeSortStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -210,6 +211,20 @@ namespace mongo {
         if (_dedup) { _seen.erase(dl); }
     }
 
+    MergeSortStage::StageWithValueComparison::StageWithValueComparison(WorkingSet* ws,
+                                                                       BSONObj pattern)
+        : _ws(ws) {
+        // Flatten the pattern once; operator() runs per heap comparison.
+        BSONObjIterator it(pattern);
+        while (it.more()) {
+            BSONElement patternElt = it.next();
+            SortPart part;
+            part.fieldName = patternElt.fieldName();
+            part.reversed = (-1 == patternElt.number());
+            _parts.push_back(part);
+        }
+    }
+
     // Is lhs less than rhs?  Note that priority_queue is a max heap by default so we invert
     // the return from the expected value.
     bool MergeSortStage::StageWithValueComparison::operator()(
@@ -218,20 +233,18 @@ namespace mongo {
         WorkingSetMember* lhsMember = _ws->get(lhs->id);
         WorkingSetMember* rhsMember = _ws->get(rhs->id);
 
-        BSONObjIterator it(_pattern);
-        while (it.more()) {
-            BSONElement patternElt = it.next();
-            string fn = patternElt.fieldName();
+        for (size_t i = 0; i < _parts.size(); ++i) {
+            const SortPart& part = _parts[i];
 
             BSONElement lhsElt;
-            verify(lhsMember->getFieldDotted(fn, &lhsElt));
+            verify(lhsMember->getFieldDotted(part.fieldName, &lhsElt));
 
             BSONElement rhsElt;
-            verify(rhsMember->getFieldDotted(fn, &rhsElt));
+            verify(rhsMember->getFieldDotted(part.fieldName, &rhsElt));
 
             // false means don't compare field name.
             int x = lhsElt.woCompare(rhsElt, false);
-            if (-1 == patternElt.number()) { x = -x; }
+            if (part.reversed) { x = -x; }
             if (x != 0) { return x > 0; }
         }
 
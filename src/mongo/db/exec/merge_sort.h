@@ -114,16 +114,23 @@ namespace mongo {
         // The comparison function used in our priority queue.
         class StageWithValueComparison {
         public:
-            StageWithValueComparison(WorkingSet* ws, BSONObj pattern)
-                : _ws(ws), _pattern(pattern) {}
+            StageWithValueComparison(WorkingSet* ws, BSONObj pattern);
 
             // Is lhs less than rhs?  Note that priority_queue is a max heap by default so we invert
             // the return from the expected value.
             bool operator()(const MergingRef& lhs, const MergingRef& rhs);
 
         private:
+            // One entry per field of the sort pattern, extracted at construction so each
+            // comparison walks a flat array instead of re-parsing the pattern object and
+            // building field name strings.
+            struct SortPart {
+                std::string fieldName;
+                bool reversed;
+            };
+
             WorkingSet* _ws;
-            BSONObj _pattern;
+            std::vector<SortPart> _parts;
         };
 
         // The min heap of the results we're returning.
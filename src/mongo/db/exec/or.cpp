@@ -48,6 +48,7 @@ namespace mongo {
 
     PlanStage::StageState OrStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -0,0 +1,330 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/exec/parallel_gather.h"
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/commands/parallel_collection_scan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/queue.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollscanThreads, int, 0);
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollscanMinSizeMB, int, 256);
+
+    namespace {
+        // Documents a worker reads per lock acquisition / queue push.
+        const int kGatherBatchBytes = 1024 * 1024;
+
+        const size_t kMaxGatherWorkers = 64;
+    }
+
+    typedef std::vector<BSONObj> GatherBatch;
+
+    /**
+     * State shared between the consuming ParallelGatherStage and its scan
+     * workers.  Held by shared_ptr so it outlives whichever side exits first;
+     * the workers are detached threads.
+     */
+    struct ParallelGatherState {
+        ParallelGatherState( const string& theNs, const BSONObj& theFilter, size_t numWorkers )
+            : ns( theNs ),
+              filter( theFilter ),
+              queue( 4 * numWorkers + 1 ),
+              activeWorkers( numWorkers ),
+              shutdown( 0 ),
+              docsTested( 0 ),
+              errMutex( "ParallelGatherState" ) {
+        }
+
+        const string ns;
+        const BSONObj filter; // owned; workers parse private MatchExpressions from it
+
+        BlockingQueue<GatherBatch> queue; // batches of owned, already-filtered documents
+        AtomicInt32 activeWorkers;
+        AtomicInt32 shutdown;
+        AtomicInt64 docsTested;
+
+        mongo::mutex errMutex;
+        string errMsg; // first worker failure, reported by the consumer
+
+        void noteError( const string& msg ) {
+            scoped_lock lk( errMutex );
+            if ( errMsg.empty() )
+                errMsg = msg;
+        }
+    };
+
+    namespace {
+
+        /**
+         * Drives one extent-range cursor (as created for parallelCollectionScan)
+         * to EOF, filtering documents under a read lock and pushing the matches
+         * onto the shared queue.  The cursor lives in the collection cursor cache
+         * between batches, so drops and deletions are handled by the usual
+         * invalidation machinery.
+         */
+        void parallelGatherWorker( boost::shared_ptr<ParallelGatherState> state,
+                                   long long cursorId ) {
+            Client::initThread( "queryParallelScan" );
+
+            bool cursorGone = false;
+            try {
+                scoped_ptr<MatchExpression> filter;
+                if ( !state->filter.isEmpty() ) {
+                    StatusWithMatchExpression parsed =
+                        MatchExpressionParser::parse( state->filter );
+                    uassertStatusOK( parsed.getStatus() );
+                    filter.reset( parsed.getValue() );
+                }
+
+                while ( !state->shutdown.load() ) {
+                    GatherBatch batch;
+                    bool done = false;
+                    long long tested = 0;
+                    {
+                        Client::ReadContext ctx( state->ns );
+                        Collection* collection = ctx.ctx().db()->getCollection( state->ns );
+                        if ( !collection ) {
+                            cursorGone = done = true; // died with the collection
+                        }
+                        else {
+                            ClientCursorPin pin( collection, cursorId );
+                            ClientCursor* cursor = pin.c();
+                            if ( !cursor ) {
+                                cursorGone = done = true; // killed while we yielded
+                            }
+                            else {
+                                BSONObj obj;
+                                Runner::RunnerState runnerState;
+                                int bytes = 0;
+                                while ( ( runnerState =
+                                              cursor->getRunner()->getNext( &obj, NULL ) )
+                                            == Runner::RUNNER_ADVANCED ) {
+                                    tested++;
+                                    bytes += obj.objsize();
+                                    if ( NULL == filter.get() ||
+                                         filter->matchesBSON( obj, NULL ) )
+                                        batch.push_back( obj.getOwned() );
+                                    if ( bytes > kGatherBatchBytes )
+                                        break;
+                                }
+                                if ( runnerState != Runner::RUNNER_ADVANCED ) {
+                                    done = true;
+                                    pin.deleteUnderlying();
+                                    cursorGone = true;
+                                }
+                            }
+                        }
+                    }
+                    if ( tested )
+                        state->docsTested.fetchAndAdd( tested );
+                    if ( !batch.empty() )
+                        state->queue.push( batch ); // may block; the stage dtor drains the queue
+                    if ( done )
+                        break;
+                }
+
+                if ( !cursorGone ) {
+                    // shut down before EOF; toss our cursor
+                    Client::ReadContext ctx( state->ns );
+                    Collection* collection = ctx.ctx().db()->getCollection( state->ns );
+                    if ( collection ) {
+                        ClientCursorPin pin( collection, cursorId );
+                        if ( pin.c() )
+                            pin.deleteUnderlying();
+                    }
+                }
+            }
+            catch ( const DBException& e ) {
+                state->noteError( e.toString() );
+            }
+            catch ( const std::exception& e ) {
+                state->noteError( e.what() );
+            }
+
+            state->activeWorkers.subtractAndFetch( 1 );
+            cc().shutdown();
+        }
+
+    }  // namespace
+
+    ParallelGatherStage::ParallelGatherStage(const ParallelGatherParams& params,
+                                             WorkingSet* workingSet)
+        : _workingSet(workingSet),
+          _params(params),
+          _started(false),
+          _dead(false),
+          _batchPos(0) { }
+
+    ParallelGatherStage::~ParallelGatherStage() {
+        if (_state) {
+            // Workers check the flag between batches; clearing the queue frees any
+            // worker blocked pushing into it.  We don't join: the detached workers
+            // keep the state alive through their shared_ptr copies, and this can
+            // run from cursor-kill paths that hold locks the workers want.
+            _state->shutdown.store(1);
+            _state->queue.clear();
+        }
+    }
+
+    PlanStage::StageState ParallelGatherStage::work(WorkingSetID* out) {
+        ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
+
+        if (_dead) { return PlanStage::DEAD; }
+
+        if (!_started) { return _open(); }
+
+        if (_batchPos >= _batch.size()) {
+            _batch.clear();
+            _batchPos = 0;
+
+            // Read the worker count before popping: a batch pushed after a failed
+            // pop but before the last worker exits is picked up on the next call.
+            const bool workersDone = (0 == _state->activeWorkers.load());
+
+            if (!_state->queue.tryPop(_batch)) {
+                if (!workersDone) {
+                    // Don't block on the queue -- we hold a read lock.  Nap and
+                    // give the runner above a chance to yield or notice a kill.
+                    sleepmillis(1);
+                    ++_commonStats.needTime;
+                    return PlanStage::NEED_TIME;
+                }
+
+                string err;
+                {
+                    scoped_lock lk(_state->errMutex);
+                    err = _state->errMsg;
+                }
+                if (!err.empty()) {
+                    *out = WorkingSetCommon::allocateStatusMember(
+                        _workingSet,
+                        Status(ErrorCodes::InternalError,
+                               "parallel collection scan failed: " + err));
+                    return PlanStage::FAILURE;
+                }
+                return PlanStage::IS_EOF;
+            }
+        }
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->obj = _batch[_batchPos++];
+        member->state = WorkingSetMember::OWNED_OBJ;
+        *out = id;
+        ++_commonStats.advanced;
+        return PlanStage::ADVANCED;
+    }
+
+    PlanStage::StageState ParallelGatherStage::workBatch(size_t maxOut,
+                                                         std::vector<WorkingSetID>* out) {
+        return batchViaWork(this, maxOut, out);
+    }
+
+    bool ParallelGatherStage::isEOF() {
+        if (_dead) { return true; }
+        if (!_started) { return false; }
+        return _batchPos >= _batch.size()
+            && 0 == _state->activeWorkers.load()
+            && _state->queue.empty();
+    }
+
+    void ParallelGatherStage::invalidate(const DiskLoc& dl, InvalidationType type) {
+        ++_commonStats.invalidates;
+        // Everything we hold is an owned copy, and the workers' cursors get their
+        // own notifications through the collection cursor cache.
+    }
+
+    void ParallelGatherStage::prepareToYield() {
+        ++_commonStats.yields;
+        // Nothing to save; the workers run against their own cursors and locks.
+    }
+
+    void ParallelGatherStage::recoverFromYield() {
+        ++_commonStats.unyields;
+    }
+
+    PlanStage::StageState ParallelGatherStage::_open() {
+        Database* db = cc().database();
+        Collection* collection = db ? db->getCollection(_params.ns) : NULL;
+        if (NULL == collection) {
+            _dead = true;
+            return PlanStage::DEAD;
+        }
+
+        size_t numWorkers = static_cast<size_t>(internalQueryParallelCollscanThreads);
+        if (numWorkers < 1) { numWorkers = 1; }
+        if (numWorkers > kMaxGatherWorkers) { numWorkers = kMaxGatherWorkers; }
+
+        // Fewer extents than workers just means fewer workers.
+        vector< vector<ExtentInfo> > buckets =
+            partitionCollectionExtents(db, collection, numWorkers);
+
+        _state = boost::make_shared<ParallelGatherState>(_params.ns,
+                                                         _params.filter,
+                                                         buckets.size());
+        _specificStats.numWorkers = buckets.size();
+
+        for (size_t i = 0; i < buckets.size(); i++) {
+            auto_ptr<Runner> runner(new ExtentRunner(_params.ns, db, collection, buckets[i]));
+            ClientCursor* cursor = new ClientCursor(collection, runner.release());
+            // thread object destruction detaches; workers hold the state alive
+            // through their shared_ptr copy
+            boost::thread(boost::bind(parallelGatherWorker, _state, cursor->cursorid()));
+        }
+
+        _started = true;
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStageStats* ParallelGatherStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        if (_state) {
+            _specificStats.docsTested = static_cast<size_t>(_state->docsTested.load());
+        }
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_PARALLEL_GATHER));
+        ret->specific.reset(new ParallelGatherStats(_specificStats));
+        return ret.release();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    class WorkingSet;
+    struct ParallelGatherState;
+
+    // Worker threads an eligible table scan is fanned out over; below 2 disables
+    // parallel scans.  Defined in parallel_gather.cpp, also read by
+    // fillOutPlannerParams in get_runner.cpp.
+    extern int internalQueryParallelCollscanThreads;
+
+    // Collections smaller than this (data size, in MB) stay on the regular
+    // single-threaded collection scan.
+    extern int internalQueryParallelCollscanMinSizeMB;
+
+    struct ParallelGatherParams {
+        ParallelGatherParams() { }
+
+        std::string ns;
+
+        // The raw query predicate; each worker parses a private MatchExpression
+        // from it so matching needs no cross-thread state.  May be empty.
+        BSONObj filter;
+    };
+
+    /**
+     * Scans a collection with several worker threads, each covering a disjoint set
+     * of extents (the same partitioning the parallelCollectionScan command uses)
+     * and applying the query filter, and returns the matching documents in
+     * whatever order the workers produce them.
+     *
+     * Documents come out as OWNED_OBJ copies, so yields and invalidations can't
+     * touch them; the workers' cursors live in the collection cursor cache between
+     * batches and are covered by the ordinary invalidation machinery.  work()
+     * never blocks on the queue while the caller's read lock is held: when the
+     * queue is empty it naps briefly and returns NEED_TIME so the runner above
+     * can yield or notice a kill.
+     */
+    class ParallelGatherStage : public PlanStage {
+    public:
+        ParallelGatherStage(const ParallelGatherParams& params, WorkingSet* workingSet);
+        virtual ~ParallelGatherStage();
+
+        virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxOut, std::vector<WorkingSetID>* out);
+        virtual bool isEOF();
+
+        virtual void invalidate(const DiskLoc& dl, InvalidationType type);
+        virtual void prepareToYield();
+        virtual void recoverFromYield();
+
+        virtual PlanStageStats* getStats();
+
+    private:
+        /** Partitions the extents, creates the workers' cursors and starts the threads. */
+        StageState _open();
+
+        // WorkingSet is not owned by us.
+        WorkingSet* _workingSet;
+
+        ParallelGatherParams _params;
+
+        bool _started;
+        bool _dead;
+
+        // Shared with the (detached) worker threads, which keep it alive through
+        // their own shared_ptr copies.
+        boost::shared_ptr<ParallelGatherState> _state;
+
+        // Batch popped from the shared queue, handed out one document per work().
+        std::vector<BSONObj> _batch;
+        size_t _batchPos;
+
+        // Stats
+        CommonStats _commonStats;
+        ParallelGatherStats _specificStats;
+    };
+
+}  // namespace mongo
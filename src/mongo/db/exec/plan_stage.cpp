@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/exec/plan_stage.h"
+
+namespace mongo {
+
+    // The default batched work: loop work() with dynamic dispatch.  See batchViaWork in
+    // plan_stage.h for the statically dispatched version leaf stages use, and for the
+    // reasoning behind the budget and status handling below.
+    PlanStage::StageState PlanStage::workBatch(size_t maxOut, std::vector<WorkingSetID>* out) {
+        if (hasStashedStatus()) {
+            return unstashStatus(out);
+        }
+
+        for (size_t i = 0; i < maxOut; i++) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            StageState state = work(&id);
+
+            if (ADVANCED == state) {
+                out->push_back(id);
+            }
+            else if (NEED_TIME == state) {
+                // try again within this batch's budget
+            }
+            else if (IS_EOF == state) {
+                break;
+            }
+            else {
+                // NEED_FETCH, FAILURE or DEAD: deliver buffered results first and hand the
+                // status out on the next call, or return it now if nothing is buffered.
+                if (out->empty()) {
+                    if (NEED_FETCH == state || FAILURE == state) {
+                        out->push_back(id);
+                    }
+                    return state;
+                }
+                stashStatus(state, id);
+                break;
+            }
+        }
+
+        if (!out->empty()) {
+            return ADVANCED;
+        }
+        return isEOF() ? IS_EOF : NEED_TIME;
+    }
+
+}  // namespace mongo
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/invalidation_type.h"
@@ -102,6 +104,10 @@ namespace mongo {
      */
     class PlanStage {
     public:
+        PlanStage() : _stashedState(NEED_TIME),
+                      _stashedId(WorkingSet::INVALID_ID),
+                      _hasStashedStatus(false) { }
+
         virtual ~PlanStage() { }
 
         /**
@@ -171,6 +177,21 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Batched form of work().  Appends up to 'maxOut' ADVANCED results to 'out' and returns
+         * ADVANCED if it produced at least one, so pulling a batch through a stage tree costs a
+         * handful of virtual calls per batch instead of one chain of them per document.
+         *
+         * Any other return value arrives with no results pending: for NEED_FETCH and FAILURE a
+         * single WSID is appended to 'out' (possibly INVALID_ID for FAILURE), mirroring work()'s
+         * out parameter.  A batch may be cut short by any internal state change; callers must not
+         * read anything into a batch smaller than 'maxOut'.
+         *
+         * The default implementation loops work() and is correct for every stage; stages override
+         * it to process batches natively.
+         */
+        virtual StageState workBatch(size_t maxOut, std::vector<WorkingSetID>* out);
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
@@ -220,6 +241,85 @@ namespace mongo {
          * Caller owns returned pointer.
          */
         virtual PlanStageStats* getStats() = 0;
+
+    protected:
+        //
+        // Helpers for workBatch() implementations.  NEED_FETCH, FAILURE and DEAD may only reach
+        // the caller once; a batching stage that hits one of them while it already has results
+        // to deliver stashes it here and returns it from its next call.
+        //
+
+        void stashStatus(StageState state, WorkingSetID id) {
+            verify(!_hasStashedStatus);
+            _stashedState = state;
+            _stashedId = id;
+            _hasStashedStatus = true;
+        }
+
+        bool hasStashedStatus() const { return _hasStashedStatus; }
+
+        /** Returns the stashed status, appending its WSID to 'out' when the status carries one. */
+        StageState unstashStatus(std::vector<WorkingSetID>* out) {
+            verify(_hasStashedStatus);
+            _hasStashedStatus = false;
+            if (NEED_FETCH == _stashedState || FAILURE == _stashedState) {
+                out->push_back(_stashedId);
+            }
+            return _stashedState;
+        }
+
+        /**
+         * workBatch() by looping work().  Stages without child stages call this with their
+         * concrete type so the per-document work() call is qualified and dispatches statically;
+         * the default workBatch() in plan_stage.cpp is the dynamically dispatched equivalent.
+         *
+         * Every work() call consumes budget whether or not it yields a result, so a stage that
+         * answers NEED_TIME indefinitely (e.g. a scan whose filter rejects everything) cannot
+         * starve the yield checks above us.
+         */
+        template <class T>
+        StageState batchViaWork(T* self, size_t maxOut, std::vector<WorkingSetID>* out) {
+            if (hasStashedStatus()) {
+                return unstashStatus(out);
+            }
+
+            for (size_t i = 0; i < maxOut; i++) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                StageState state = self->T::work(&id);
+
+                if (ADVANCED == state) {
+                    out->push_back(id);
+                }
+                else if (NEED_TIME == state) {
+                    // try again within this batch's budget
+                }
+                else if (IS_EOF == state) {
+                    break;
+                }
+                else {
+                    // NEED_FETCH, FAILURE or DEAD: deliver buffered results first and hand the
+                    // status out on the next call, or return it now if nothing is buffered.
+                    if (out->empty()) {
+                        if (NEED_FETCH == state || FAILURE == state) {
+                            out->push_back(id);
+                        }
+                        return state;
+                    }
+                    stashStatus(state, id);
+                    break;
+                }
+            }
+
+            if (!out->empty()) {
+                return ADVANCED;
+            }
+            return self->T::isEOF() ? IS_EOF : NEED_TIME;
+        }
+
+    private:
+        StageState _stashedState;
+        WorkingSetID _stashedId;
+        bool _hasStashedStatus;
     };
 
 }  // namespace mongo
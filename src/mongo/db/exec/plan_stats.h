@@ -38,6 +38,7 @@
 #include "mongo/db/geo/hash.h"
 #include "mongo/db/query/stage_types.h"
 #include "mongo/platform/cstdint.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -62,6 +63,8 @@ namespace mongo {
                         advanced(0),
                         needTime(0),
                         needFetch(0),
+                        timedWorks(0),
+                        timedWorksMicros(0),
                         isEOF(false) { }
 
         // Count calls into the stage.
@@ -83,9 +86,48 @@ namespace mongo {
 
         // TODO: keep track of total yield time / fetch time for a plan (done by runner)
 
+        // One in every ScopedWorkTimer::kSampleEvery work() calls is wall-clock timed,
+        // inclusive of descendant stages.  Scale timedWorksMicros by the sample rate
+        // (works / timedWorks) to estimate total time spent in a stage's subtree.
+        size_t timedWorks;
+        long long timedWorksMicros;
+
         bool isEOF;
     };
 
+    /**
+     * Times one in every kSampleEvery work() calls of a stage and attributes the
+     * elapsed wall time - inclusive of descendant stages - to the stage's
+     * CommonStats.  Construct right after bumping CommonStats::works:
+     *
+     *   ++_commonStats.works;
+     *   ScopedWorkTimer workTimer(&_commonStats);
+     *
+     * The unsampled path is one modulo; a sampled call adds two clock reads, so
+     * the timing can't meaningfully distort what it measures even for trivial
+     * stages like LIMIT.
+     */
+    class ScopedWorkTimer {
+    public:
+        static const size_t kSampleEvery = 16;
+
+        explicit ScopedWorkTimer(CommonStats* stats)
+            : _stats(stats->works % kSampleEvery == 1 ? stats : NULL)
+            , _startMicros(_stats ? curTimeMicros64() : 0) { }
+
+        ~ScopedWorkTimer() {
+            if (_stats) {
+                _stats->timedWorks++;
+                _stats->timedWorksMicros +=
+                    static_cast<long long>(curTimeMicros64() - _startMicros);
+            }
+        }
+
+    private:
+        CommonStats* _stats; // NULL if this call isn't sampled
+        unsigned long long _startMicros;
+    };
+
     // The universal container for a stage's stats.
     struct PlanStageStats {
         PlanStageStats(const CommonStats& c, StageType t) : stageType(t), common(c) { }
@@ -195,6 +237,21 @@ namespace mongo {
         size_t docsTested;
     };
 
+    struct ParallelGatherStats : public SpecificStats {
+        ParallelGatherStats() : docsTested(0), numWorkers(0) { }
+
+        virtual SpecificStats* clone() const {
+            ParallelGatherStats* specific = new ParallelGatherStats(*this);
+            return specific;
+        }
+
+        // How many documents did the workers check against the filter, all told?
+        size_t docsTested;
+
+        // How many scan threads the collection's extents were split across.
+        size_t numWorkers;
+    };
+
     struct DistinctScanStats : public SpecificStats {
         DistinctScanStats() : keysExamined(0) { }
 
@@ -311,7 +368,7 @@ namespace mongo {
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0), memUsage(0), memLimit(0) { }
+        SortStats() : forcedFetches(0), memUsage(0), memLimit(0), spills(0) { }
 
         virtual ~SortStats() { }
 
@@ -328,6 +385,9 @@ namespace mongo {
 
         // What's our memory limit?
         size_t memLimit;
+
+        // How many times did we write the buffer out to a sorted run on disk?
+        size_t spills;
     };
 
     struct MergeSortStats : public SpecificStats {
@@ -349,6 +409,28 @@ namespace mongo {
         size_t forcedFetches;
     };
 
+    struct MergeJoinStats : public SpecificStats {
+        MergeJoinStats() : runsMatched(0),
+                           pairsBuffered(0),
+                           forcedFetches(0) { }
+
+        virtual ~MergeJoinStats() { }
+
+        virtual SpecificStats* clone() const {
+            MergeJoinStats* specific = new MergeJoinStats(*this);
+            return specific;
+        }
+
+        // How many distinct join key values had rows on both sides?
+        size_t runsMatched;
+
+        // How many joined documents we've built.
+        size_t pairsBuffered;
+
+        // How many records were we forced to fetch as the result of an invalidation?
+        size_t forcedFetches;
+    };
+
     struct ShardingFilterStats : public SpecificStats {
         ShardingFilterStats() : chunkSkips(0) { }
 
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/projection.h"
 
+#include <algorithm>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -37,20 +39,200 @@
 
 namespace mongo {
 
+    namespace {
+
+        /** @return 'field's position in 'keyPattern', or -1 if it's absent */
+        int keySlot(const BSONObj& keyPattern, const char* field) {
+            int slot = 0;
+            BSONObjIterator it(keyPattern);
+            while (it.more()) {
+                if (mongoutils::str::equals(it.next().fieldName(), field)) {
+                    return slot;
+                }
+                ++slot;
+            }
+            return -1;
+        }
+
+    }  // namespace
+
     ProjectionStage::ProjectionStage(BSONObj projObj,
                                      const MatchExpression* fullExpression,
                                      WorkingSet* ws,
                                      PlanStage* child)
         : _exec(new ProjectionExec(projObj, fullExpression)),
           _ws(ws),
-          _child(child) { }
+          _child(child),
+          _projObj(projObj.getOwned()),
+          _canTransformFromKey(canTransformFromIndexKey(projObj)),
+          _includeId(false),
+          _numKeyFields(0) {
+
+        if (_canTransformFromKey) {
+            // Precompute what transformFromDocument() needs: which fields to
+            // keep and a slot for each so the walk can stop early.
+            BSONElement idElt = _projObj["_id"];
+            _includeId = idElt.eoo() || idElt.trueValue();
+
+            size_t slot = _includeId ? 1 : 0;  // _id owns slot 0 when included
+            BSONObjIterator it(_projObj);
+            while (it.more()) {
+                BSONElement e = it.next();
+                if (mongoutils::str::equals("_id", e.fieldName())) { continue; }
+                if (_includedFields.find(e.fieldName()) == _includedFields.end()) {
+                    _includedFields[e.fieldName()] = slot++;
+                }
+            }
+            _seenScratch.resize(slot);
+        }
+    }
 
     ProjectionStage::~ProjectionStage() { }
 
     bool ProjectionStage::isEOF() { return _child->isEOF(); }
 
+    // static
+    bool ProjectionStage::canTransformFromIndexKey(const BSONObj& projObj) {
+        bool includesAField = false;
+
+        BSONObjIterator it(projObj);
+        while (it.more()) {
+            BSONElement e = it.next();
+
+            // $meta, $slice, $elemMatch, ... all need the general transform.
+            if (!e.isNumber() && !e.isBoolean()) { return false; }
+
+            if (mongoutils::str::equals("_id", e.fieldName())) {
+                if (e.trueValue()) { includesAField = true; }
+                continue;
+            }
+
+            // Exclusions need the document.
+            if (!e.trueValue()) { return false; }
+
+            // Projections of dotted fields aren't covered.
+            if (mongoutils::str::contains(e.fieldName(), '.')) { return false; }
+
+            includesAField = true;
+        }
+
+        return includesAField;
+    }
+
+    void ProjectionStage::computeKeySlots(const BSONObj& keyPattern) {
+        _keyPattern = keyPattern.getOwned();
+        _keyFieldNames.clear();
+        _keySlots.clear();
+
+        _numKeyFields = _keyPattern.nFields();
+        _keyElts.resize(_numKeyFields);
+
+        // Order matches the general transform: _id first when included, then
+        // the spec's fields in spec order.  Fields absent from the key are
+        // silently dropped, as WorkingSetMember::getFieldDotted would do.
+        bool includeID = true;
+        BSONElement idElt = _projObj["_id"];
+        if (!idElt.eoo() && !idElt.trueValue()) {
+            includeID = false;
+        }
+
+        if (includeID) {
+            int slot = keySlot(_keyPattern, "_id");
+            if (slot >= 0) {
+                _keyFieldNames.push_back("_id");
+                _keySlots.push_back(slot);
+            }
+        }
+
+        BSONObjIterator specIt(_projObj);
+        while (specIt.more()) {
+            BSONElement specElt = specIt.next();
+            if (mongoutils::str::equals("_id", specElt.fieldName())) { continue; }
+
+            int slot = keySlot(_keyPattern, specElt.fieldName());
+            if (slot >= 0) {
+                _keyFieldNames.push_back(specElt.fieldName());
+                _keySlots.push_back(slot);
+            }
+        }
+    }
+
+    bool ProjectionStage::transformFromIndexKey(WorkingSetMember* member) {
+        if (!_canTransformFromKey) { return false; }
+
+        // The general transform prefers the document whenever one is
+        // present, and intersection plans can carry several keys.
+        if (member->hasObj() || 1 != member->keyData.size()) { return false; }
+
+        const IndexKeyDatum& keyDatum = member->keyData[0];
+        if (!_keyPattern.binaryEqual(keyDatum.indexKeyPattern)) {
+            computeKeySlots(keyDatum.indexKeyPattern);
+        }
+
+        // One pass over the key collects every value...
+        BSONObjIterator keyIt(keyDatum.keyData);
+        for (int i = 0; i < _numKeyFields; ++i) {
+            verify(keyIt.more());
+            _keyElts[i] = keyIt.next();
+        }
+
+        // ...and the output copies each value's bytes exactly once.
+        BSONObjBuilder bob;
+        for (size_t i = 0; i < _keySlots.size(); ++i) {
+            bob.appendAs(_keyElts[_keySlots[i]], _keyFieldNames[i]);
+        }
+
+        member->state = WorkingSetMember::OWNED_OBJ;
+        member->obj = bob.obj();
+        member->keyData.clear();
+        member->loc = DiskLoc();
+        return true;
+    }
+
+    bool ProjectionStage::transformFromDocument(WorkingSetMember* member) {
+        if (!_canTransformFromKey || !member->hasObj()) { return false; }
+
+        std::fill(_seenScratch.begin(), _seenScratch.end(), 0);
+        size_t remaining = _seenScratch.size();
+
+        BSONObjBuilder bob;
+        BSONObjIterator it(member->obj);
+        while (it.more()) {
+            BSONElement elt = it.next();
+
+            // An element we don't keep costs only its length-prefix skip in
+            // it.next(); nothing below runs for it.
+            size_t slot;
+            if (mongoutils::str::equals("_id", elt.fieldName())) {
+                if (!_includeId) { continue; }
+                slot = 0;
+            }
+            else {
+                StringMap<size_t>::const_iterator fieldIt =
+                    _includedFields.find(elt.fieldName());
+                if (fieldIt == _includedFields.end()) { continue; }
+                slot = fieldIt->second;
+            }
+
+            bob.append(elt);
+            if (!_seenScratch[slot]) {
+                _seenScratch[slot] = 1;
+                // Once every projected field has been copied, the tail of a
+                // wide document doesn't need to be walked at all.
+                if (0 == --remaining) { break; }
+            }
+        }
+
+        member->state = WorkingSetMember::OWNED_OBJ;
+        member->obj = bob.obj();
+        member->keyData.clear();
+        member->loc = DiskLoc();
+        return true;
+    }
+
     PlanStage::StageState ProjectionStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         WorkingSetID id = WorkingSet::INVALID_ID;
         StageState status = _child->work(&id);
@@ -59,12 +241,18 @@ namespace mongo {
         // tailable cursor and isEOF() would be true even if it had more data...
         if (PlanStage::ADVANCED == status) {
             WorkingSetMember* member = _ws->get(id);
-            Status projStatus = _exec->transform(member);
-            if (!projStatus.isOK()) {
-                warning() << "Couldn't execute projection, status = "
-                          << projStatus.toString() << endl;
-                *out = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
-                return PlanStage::FAILURE;
+
+            // Covered results copy values straight out of the index key, and
+            // fetched documents with simple inclusion specs are decoded in a
+            // single pass; everything else takes the general transform.
+            if (!transformFromIndexKey(member) && !transformFromDocument(member)) {
+                Status projStatus = _exec->transform(member);
+                if (!projStatus.isOK()) {
+                    warning() << "Couldn't execute projection, status = "
+                              << projStatus.toString() << endl;
+                    *out = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+                    return PlanStage::FAILURE;
+                }
             }
 
             *out = id;
@@ -33,6 +33,7 @@
 #include "mongo/db/exec/projection_exec.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -58,12 +59,74 @@ namespace mongo {
         PlanStageStats* getStats();
 
     private:
+        /**
+         * Could this projection ever be computed straight from an index key?
+         * True only for simple inclusion projections of non-dotted fields -
+         * nothing that needs the document, match details or computed data.
+         */
+        static bool canTransformFromIndexKey(const BSONObj& projObj);
+
+        /**
+         * Fast path for covered results: builds the projection by copying
+         * values straight out of 'member's single index key, skipping
+         * ProjectionExec and its per-field scans of the key pattern.
+         *
+         * @return false if 'member' isn't a covered result this stage can
+         * handle that way; the caller then runs the general transform.
+         */
+        bool transformFromIndexKey(WorkingSetMember* member);
+
+        /**
+         * Fast path for simple inclusion projections of fetched documents:
+         * walks the document's top-level fields exactly once, copying the
+         * projected ones and skipping the rest by their length prefix, and
+         * stops as soon as every projected field has been seen.
+         *
+         * @return false if the spec or 'member' needs the general transform.
+         */
+        bool transformFromDocument(WorkingSetMember* member);
+
+        /**
+         * Maps each output field to its position in 'keyPattern', in the
+         * order the general transform would emit them.
+         */
+        void computeKeySlots(const BSONObj& keyPattern);
+
         scoped_ptr<ProjectionExec> _exec;
 
         // _ws is not owned by us.
         WorkingSet* _ws;
         scoped_ptr<PlanStage> _child;
 
+        // The projection spec, kept for the covered fast path.
+        BSONObj _projObj;
+
+        // Is _projObj simple enough for transformFromIndexKey()?  The same
+        // criteria (top-level inclusions only) enable transformFromDocument().
+        bool _canTransformFromKey;
+
+        // Does the projection include _id?  Only used on the fast paths.
+        bool _includeId;
+
+        // Projected field -> slot in _seenScratch (_id implicitly gets slot 0
+        // when included).
+        StringMap<size_t> _includedFields;
+
+        // Per-document scratch marking which projected fields were seen, so
+        // the document walk can stop once all of them have been copied.
+        std::vector<char> _seenScratch;
+
+        // The key pattern the slots below were computed against.
+        BSONObj _keyPattern;
+        int _numKeyFields;
+
+        // Output fields in emission order: name and position in the key.
+        std::vector<std::string> _keyFieldNames;
+        std::vector<int> _keySlots;
+
+        // Scratch space for one decoded key, sized to _numKeyFields.
+        std::vector<BSONElement> _keyElts;
+
         // Stats
         CommonStats _commonStats;
     };
@@ -132,6 +132,7 @@ namespace mongo {
         }
         if (isEOF()) { return PlanStage::IS_EOF; }
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         // If we haven't opened up our very first ixscan+fetch children, do it.  This is kind of
         // heavy so we don't want to do it in the ctor.
@@ -180,6 +181,18 @@ namespace mongo {
         }
         verify(_innerRadius <= _outerRadius);
 
+        // Results measured during earlier annuli that belong to this one are ready to go;
+        // their locs are in _seenLocs so the scan below won't process them again.
+        while (!_futureResults.empty()) {
+            Result next = _futureResults.top();
+            if (_outerRadiusInclusive ? next.distance > _outerRadius
+                                      : next.distance >= _outerRadius) {
+                break;
+            }
+            _futureResults.pop();
+            _results.push(next);
+        }
+
         // We might have just grown our radius beyond anything reasonable.
         if (isEOF()) { return; }
 
@@ -240,15 +253,19 @@ namespace mongo {
         // TODO Speed improvements:
         //
         // 0. Modify fetch to preserve key data and test for intersection w/annulus.
-        //
-        // 1. keep track of what we've seen in this scan and possibly ignore it.
-        //
-        // 2. keep track of results we've returned before and ignore them.
 
         WorkingSetMember* member = _ws->get(*out);
         // Must have an object in order to get geometry out of it.
         verify(member->hasObj());
 
+        // Annulus covers overlap, so every annulus scan returns documents we've already
+        // measured: results from earlier shells, rejects, and parked future results.
+        // Drop them before doing any geometry work.
+        if (member->hasLoc() && _seenLocs.end() != _seenLocs.find(member->loc)) {
+            _ws->free(*out);
+            return PlanStage::NEED_TIME;
+        }
+
         // Get all the fields with that name from the document.
         BSONElementSet geom;
         member->obj.getFieldsDotted(_params.nearQuery.field, geom, false);
@@ -279,20 +296,36 @@ namespace mongo {
             }
         }
 
-        // If the distance to the doc satisfies our distance criteria, add it to our buffered
-        // results.
-        if (minDistance >= _innerRadius &&
-            (_outerRadiusInclusive ? minDistance <= _outerRadius : minDistance < _outerRadius)) {
+        // Whatever happens below we have measured this document; never measure it again.
+        if (member->hasLoc()) {
+            _seenLocs.insert(member->loc);
+        }
+
+        // Below the annulus: either under the query's minimum distance, or already
+        // returned by an earlier shell.  Out for good either way.
+        // Beyond the maximum distance: can never qualify.
+        if (minDistance < _innerRadius || minDistance > _maxDistance) {
+            _ws->free(*out);
+            return PlanStage::NEED_TIME;
+        }
+
+        // It qualifies now or it will qualify in a later shell; buffer it either way so
+        // the document is fetched and measured exactly once over the whole search.
+        if (_params.addDistMeta) {
+            member->addComputed(new GeoDistanceComputedData(minDistance));
+        }
+        if (_params.addPointMeta) {
+            member->addComputed(new GeoNearPointComputedData(minDistanceObj));
+        }
+        if (member->hasLoc()) {
+            _invalidationMap[member->loc] = *out;
+        }
+
+        if (_outerRadiusInclusive ? minDistance <= _outerRadius : minDistance < _outerRadius) {
             _results.push(Result(*out, minDistance));
-            if (_params.addDistMeta) {
-                member->addComputed(new GeoDistanceComputedData(minDistance));
-            }
-            if (_params.addPointMeta) {
-                member->addComputed(new GeoNearPointComputedData(minDistanceObj));
-            }
-            if (member->hasLoc()) {
-                _invalidationMap[member->loc] = *out;
-            }
+        }
+        else {
+            _futureResults.push(Result(*out, minDistance));
         }
 
         return PlanStage::NEED_TIME;
@@ -315,8 +348,12 @@ namespace mongo {
             _child->invalidate(dl, type);
         }
 
-        // _results is a queue of results that we will return for the current shell we're on.
-        // If a result is in _results and has a DiskLoc it will be in _invalidationMap as well.
+        // The loc may be reused for another document after this, so it must not keep
+        // suppressing scan results.
+        _seenLocs.erase(dl);
+
+        // _results and _futureResults queue results that we will return, now or in a later
+        // shell.  If such a result has a DiskLoc it will be in _invalidationMap as well.
         // It's safe to return the result w/o the DiskLoc.
         unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher>::iterator it
             = _invalidationMap.find(dl);
@@ -334,6 +371,8 @@ namespace mongo {
     bool S2NearStage::isEOF() {
         if (!_worked) { return false; }
         if (_failed) { return true; }
+        // Anything measured early and parked for a later shell must still be returned.
+        if (!_results.empty()) { return false; }
         // We're only done if we exhaust the search space.
         return _innerRadius >= _maxDistance;
     }
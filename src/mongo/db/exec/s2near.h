@@ -116,6 +116,18 @@ namespace mongo {
         // We compute an annulus of results and cache it here.
         priority_queue<Result> _results;
 
+        // Results whose distance lies beyond the current annulus but within _maxDistance.
+        // Annulus covers overlap (a coarse cell intersects many shells), so without this a
+        // document is fetched and measured once per annulus until its own shell comes up.
+        // We measure it the first time we see it, park it here, and move it into _results
+        // when the annulus containing it is reached (see nextAnnulus()).
+        priority_queue<Result> _futureResults;
+
+        // Locs we have already measured: returned, buffered (in _results or
+        // _futureResults), or rejected for good.  Later annulus scans skip these without
+        // recomputing any distances.  Erased on invalidation since a loc may be reused.
+        unordered_set<DiskLoc, DiskLoc::Hasher> _seenLocs;
+
         // For fast invalidation.  Perhaps not worth it.
         unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> _invalidationMap;
 
@@ -29,13 +29,106 @@
 #include "mongo/db/exec/shard_filter.h"
 
 #include "mongo/db/keypattern.h"
+#include "mongo/s/collection_metadata.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
+    ShardKeyFilter::ShardKeyFilter(const CollectionMetadataPtr& metadata)
+        : _metadata(metadata),
+          _keyPattern(metadata ? metadata->getKeyPattern() : BSONObj()),
+          _useFallback(false) {
+
+        if (!_metadata) {
+            return;
+        }
+
+        BSONForEach(e, _metadata->getKeyPattern()) {
+            _fields.push_back(e.fieldName());
+        }
+
+        // Hashed keys have to materialize the hash of the field value, and
+        // belongsToMe() keeps its key elements in a fixed-size buffer.
+        _useFallback = str::equals(
+                            _metadata->getKeyPattern().firstElement().valuestrsafe(), "hashed")
+                       || _fields.size() > kMaxKeyFields;
+        if (_useFallback) {
+            return;
+        }
+
+        const RangeMap& ranges = _metadata->getRangesMap();
+        for (RangeMap::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+            _ranges.push_back(make_pair(it->first, it->second));
+        }
+    }
+
+    bool ShardKeyFilter::belongsToMe(const BSONObj& doc) const {
+        if (_useFallback) {
+            return _fallback(doc);
+        }
+
+        // Mirrors keyBelongsToMe(): everything belongs to an unsharded collection,
+        // nothing belongs to a shard that owns no ranges.
+        if (_fields.empty()) {
+            return true;
+        }
+        if (_ranges.empty()) {
+            return false;
+        }
+
+        BSONElement keyElems[kMaxKeyFields];
+        for (size_t i = 0; i < _fields.size(); i++) {
+            keyElems[i] = doc.getFieldDotted(_fields[i]);
+            if (keyElems[i].eoo()) {
+                // Key field missing from the document; let the metadata path
+                // decide what the extracted key means.
+                return _fallback(doc);
+            }
+        }
+
+        // Find the last range whose min is <= the key...
+        size_t lo = 0;
+        size_t hi = _ranges.size();
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (_compareToBoundary(keyElems, _ranges[mid].first) < 0) {
+                hi = mid;
+            }
+            else {
+                lo = mid + 1;
+            }
+        }
+        if (0 == lo) {
+            // ...the key sorts below every owned range.
+            return false;
+        }
+        return _compareToBoundary(keyElems, _ranges[lo - 1].second) < 0;
+    }
+
+    int ShardKeyFilter::_compareToBoundary(const BSONElement* keyElems,
+                                           const BSONObj& boundary) const {
+        BSONObjIterator it(boundary);
+        for (size_t i = 0; i < _fields.size(); i++) {
+            if (!it.more()) {
+                // The boundary is a strict prefix of the key, so it sorts first.
+                return 1;
+            }
+            const int x = keyElems[i].woCompare(it.next(), false);
+            if (x != 0) {
+                return x > 0 ? 1 : -1;
+            }
+        }
+        return it.more() ? -1 : 0;
+    }
+
+    bool ShardKeyFilter::_fallback(const BSONObj& doc) const {
+        return _metadata->keyBelongsToMe(_keyPattern.extractSingleKey(doc));
+    }
+
     ShardFilterStage::ShardFilterStage(const CollectionMetadataPtr& metadata,
                                        WorkingSet* ws,
                                        PlanStage* child)
-        : _ws(ws), _child(child), _metadata(metadata) { }
+        : _ws(ws), _child(child), _metadata(metadata), _filter(metadata) { }
 
     ShardFilterStage::~ShardFilterStage() { }
 
@@ -43,6 +136,7 @@ namespace mongo {
 
     PlanStage::StageState ShardFilterStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         // If we've returned as many results as we're limited to, isEOF will be true.
         if (isEOF()) { return PlanStage::IS_EOF; }
@@ -53,12 +147,9 @@ namespace mongo {
             // If we're sharded make sure that we don't return any data that hasn't been migrated
             // off of our shared yet.
             if (_metadata) {
-                KeyPattern kp(_metadata->getKeyPattern());
-
                 WorkingSetMember* member = _ws->get(*out);
 
-                // This performs excessive BSONObj creation but that's OK for now.
-                if (!_metadata->keyBelongsToMe(kp.extractSingleKey(member->obj))) {
+                if (!_filter.belongsToMe(member->obj)) {
                     _ws->free(*out);
                     ++_specificStats.chunkSkips;
                     return PlanStage::NEED_TIME;
@@ -30,6 +30,7 @@
 
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/keypattern.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/d_logic.h"
@@ -37,6 +38,54 @@
 
 namespace mongo {
 
+    /**
+     * Precompiled form of CollectionMetadata::keyBelongsToMe for the per-document
+     * path of ShardFilterStage.
+     *
+     * At construction this snapshots the metadata's contiguous owned ranges into a
+     * flat interval table and the shard-key pattern into a list of field paths.
+     * belongsToMe() then pulls the key fields out of the document as BSONElements
+     * and binary searches the table — no BSONObj is built per document.  Hashed
+     * shard keys and documents missing a key field fall back to extracting the key
+     * and asking the metadata, preserving its semantics exactly.
+     *
+     * The referenced metadata must outlive this object; the stage holds it.
+     */
+    class ShardKeyFilter {
+    public:
+        explicit ShardKeyFilter(const CollectionMetadataPtr& metadata);
+
+        /**
+         * Returns true if 'doc' belongs to this shard per the metadata this filter
+         * was compiled from.  Must not be called when constructed with NULL
+         * metadata.
+         */
+        bool belongsToMe(const BSONObj& doc) const;
+
+    private:
+        // Fixed size of the on-stack key element buffer in belongsToMe();
+        // patterns with more fields use the fallback path.
+        static const size_t kMaxKeyFields = 8;
+
+        // Returns <0, 0 or >0 as the extracted key elements compare to 'boundary',
+        // with BSONObj::woCompare semantics (boundary field names match by
+        // construction).
+        int _compareToBoundary(const BSONElement* keyElems, const BSONObj& boundary) const;
+
+        // Extracts the key as a BSONObj and asks the metadata.
+        bool _fallback(const BSONObj& doc) const;
+
+        const CollectionMetadataPtr _metadata;
+
+        KeyPattern _keyPattern;       // for fallback extraction
+        vector<string> _fields;       // shard-key field paths, in pattern order
+        bool _useFallback;            // hashed pattern or too many fields
+
+        // Owned ranges [min, max), ascending by min.  The BSONObjs share the
+        // immutable metadata's buffers.
+        vector<pair<BSONObj, BSONObj> > _ranges;
+    };
+
     /**
      * This stage drops documents that didn't belong to the shard we're executing on at the time of
      * construction. This matches the contract for sharded cursorids which guarantees that a
@@ -97,6 +146,10 @@ namespace mongo {
         // Note: it is important that this is the metadata from the time this stage is constructed.
         // See class comment for details.
         const CollectionMetadataPtr _metadata;
+
+        // Compiled from _metadata; answers belongsToMe() without building a
+        // BSONObj per document.
+        ShardKeyFilter _filter;
     };
 
 }  // namespace mongo
@@ -41,6 +41,7 @@ namespace mongo {
 
     PlanStage::StageState SkipStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
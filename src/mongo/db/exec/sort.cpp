@@ -30,12 +30,16 @@
 
 #include <algorithm>
 
+#include "mongo/db/client.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/exec/working_set_computed_data.h"
 #include "mongo/db/index/btree_key_generator.h"
 #include "mongo/db/query/lite_parsed_query.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage_options.h"
 
 namespace mongo {
 
@@ -43,6 +47,32 @@ namespace mongo {
 
     const size_t kMaxBytes = 32 * 1024 * 1024;
 
+    // If true, an unlimited sort that outgrows the in-memory limit spills to
+    // sorted runs on disk and stream-merges them, instead of failing with
+    // Overflow.  Sorts with a limit are already memory-bounded and never
+    // spill.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecExternalSort, bool, true);
+
+    namespace {
+        // Compares the (sortKey, document) pairs read back from spilled runs.
+        // The DiskLoc tie-breaker is not available once a document has been
+        // spilled, so equal keys come back in arbitrary run order.
+        class SpilledRunComparator {
+        public:
+            typedef std::pair<BSONObj, BSONObj> Data;
+
+            explicit SpilledRunComparator(const BSONObj& pattern) : _pattern(pattern) {}
+
+            int operator()(const Data& lhs, const Data& rhs) const {
+                // False means ignore field names.
+                return lhs.first.woCompare(rhs.first, _pattern, false);
+            }
+
+        private:
+            BSONObj _pattern;
+        };
+    }
+
     SortStageKeyGenerator::SortStageKeyGenerator(const BSONObj& sortSpec, const BSONObj& queryObj) {
         _hasBounds = false;
         _sortHasMeta = false;
@@ -261,7 +291,8 @@ namespace mongo {
           _limit(params.limit),
           _sorted(false),
           _resultIterator(_data.end()),
-          _memUsage(0) {
+          _memUsage(0),
+          _memReported(0) {
         dassert(_limit >= 0);
     }
 
@@ -270,11 +301,27 @@ namespace mongo {
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
-        return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
+        if (!_child->isEOF() || !_sorted) {
+            return false;
+        }
+        if (NULL != _mergeIter.get()) {
+            return !_mergeIter->more();
+        }
+        return _data.end() == _resultIterator;
     }
 
     PlanStage::StageState SortStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
+
+        // Keep the op-wide memory accounting (db.currentOp() "memUsed") in step with our
+        // buffered data.  At most one work() call behind, since the buffer only changes
+        // inside work().
+        if (_memUsage != _memReported) {
+            cc().curop()->adjustMemAccounted(static_cast<long long>(_memUsage) -
+                                             static_cast<long long>(_memReported));
+            _memReported = _memUsage;
+        }
 
         if (NULL == _sortKeyGen) {
             // This is heavy and should be done as part of work().
@@ -290,6 +337,15 @@ namespace mongo {
         }
 
         if (_memUsage > kMaxBytes) {
+            if (0 == _limit && internalQueryExecExternalSort) {
+                // Dump the buffer to a sorted run on disk and keep gathering;
+                // the runs are stream-merged once the child is exhausted.
+                sortBuffer();
+                spillBufferedData();
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
             mongoutils::str::stream ss;
             ss << "sort stage buffered data usage of " << _memUsage
                << " bytes exceeds internal limit of " << kMaxBytes << " bytes";
@@ -337,7 +393,20 @@ namespace mongo {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
                 sortBuffer();
-                _resultIterator = _data.begin();
+                if (_spilledRuns.empty()) {
+                    _resultIterator = _data.begin();
+                }
+                else {
+                    // The in-memory remainder becomes one more run and we
+                    // stream results out of a merge of all the runs.
+                    if (!_data.empty()) {
+                        spillBufferedData();
+                    }
+                    _mergeIter.reset(SortedRunIterator::merge(
+                            _spilledRuns,
+                            SortOptions(),
+                            SpilledRunComparator(_sortKeyGen->getSortComparator())));
+                }
                 _sorted = true;
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -368,8 +437,24 @@ namespace mongo {
         }
 
         // Returning results.
-        verify(_resultIterator != _data.end());
         verify(_sorted);
+
+        if (NULL != _mergeIter.get()) {
+            // Results stream from the merge of the spilled runs.  The
+            // documents are owned copies, so they come back in fresh
+            // OWNED_OBJ members with no DiskLoc.
+            verify(_mergeIter->more());
+            std::pair<BSONObj, BSONObj> next = _mergeIter->next();
+            WorkingSetID id = _ws->allocate();
+            WorkingSetMember* spilledMember = _ws->get(id);
+            spilledMember->obj = next.second.getOwned();
+            spilledMember->state = WorkingSetMember::OWNED_OBJ;
+            *out = id;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        verify(_resultIterator != _data.end());
         *out = _resultIterator->wsid;
         _resultIterator++;
 
@@ -534,4 +619,35 @@ namespace mongo {
         }
     }
 
+    void SortStage::spillBufferedData() {
+        // Sorts with a limit are bounded by the limit, not by spilling.
+        verify(0 == _limit);
+
+        SortOptions opts;
+        opts.tempDir = storageGlobalParams.dbpath + "/_tmp";
+        SortedFileWriter<BSONObj, BSONObj> writer(opts);
+
+        // _data is already sorted (see sortBuffer()), so the run can be
+        // written front to back.  Each document is serialized into the run
+        // file, so the WorkingSetMember can be freed immediately.
+        for (vector<SortableDataItem>::const_iterator it = _data.begin();
+             it != _data.end(); ++it) {
+
+            WorkingSetMember* member = _ws->get(it->wsid);
+            writer.addAlreadySorted(it->sortKey, member->obj);
+            if (member->hasLoc()) {
+                _wsidByDiskLoc.erase(member->loc);
+            }
+            _ws->free(it->wsid);
+        }
+
+        _data.clear();
+        _memUsage = 0;
+        _spilledRuns.push_back(boost::shared_ptr<SortedRunIterator>(writer.done()));
+        ++_specificStats.spills;
+    }
+
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj, mongo::BSONObj, mongo::SpilledRunComparator);
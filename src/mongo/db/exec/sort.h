@@ -38,6 +38,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/index_bounds.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -216,10 +217,25 @@ namespace mongo {
          */
         void sortBuffer();
 
+        /**
+         * Writes the (sorted) contents of _data to a sorted run file on disk,
+         * freeing the buffered WorkingSetMembers, so gathering can continue
+         * past the in-memory limit.  Only legal when _limit == 0.
+         */
+        void spillBufferedData();
+
         // Comparator for data buffer
         // Initialization follows sort key generator
         scoped_ptr<WorkingSetComparator> _sortKeyComparator;
 
+        // Sorted (sortKey, document) runs written by spillBufferedData().  If
+        // any exist when the child hits EOF, results stream from _mergeIter,
+        // which merges them, instead of from _data.  Spilled documents are
+        // owned copies, so they need no DiskLoc invalidation tracking.
+        typedef SortIteratorInterface<BSONObj, BSONObj> SortedRunIterator;
+        std::vector<boost::shared_ptr<SortedRunIterator> > _spilledRuns;
+        boost::scoped_ptr<SortedRunIterator> _mergeIter;
+
         // The data we buffer and sort.
         // _data will contain sorted data when all data is gathered
         // and sorted.
@@ -247,6 +263,9 @@ namespace mongo {
 
         // The usage in bytes of all buffered data that we're sorting.
         size_t _memUsage;
+
+        // What we last reported to CurOp's per-op memory accounting; see work().
+        size_t _memReported;
     };
 
 }  // namespace mongo
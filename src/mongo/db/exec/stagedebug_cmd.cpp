@@ -36,6 +36,7 @@
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/limit.h"
+#include "mongo/db/exec/merge_join.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
 #include "mongo/db/exec/skip.h"
@@ -78,6 +79,8 @@ namespace mongo {
      * node -> {skip: {args: {node: node, num: posint}}}
      * node -> {sort: {args: {node: node, pattern: objWithSortCriterion }}}
      * node -> {mergeSort: {args: {nodes: [node, node], pattern: objWithSortCriterion}}}
+     * node -> {mergeJoin: {filter: {filter},
+     *                      args: {left: node, right: node, joinFields: posint, direction: -1/1}}}
      * node -> {cscan: {filter: {filter}, args: {name: "collectionname" }}}
      *
      * Forthcoming Nodes:
@@ -346,6 +349,34 @@ namespace mongo {
                 }
                 return mergeStage.release();
             }
+            else if ("mergeJoin" == nodeName) {
+                uassert(17570, "Left node argument must be provided to mergeJoin",
+                        nodeArgs["left"].isABSONObj());
+                uassert(17571, "Right node argument must be provided to mergeJoin",
+                        nodeArgs["right"].isABSONObj());
+
+                MergeJoinStageParams params;
+                if (nodeArgs["joinFields"].isNumber()) {
+                    uassert(17572, "joinFields argument to mergeJoin must be positive",
+                            nodeArgs["joinFields"].numberInt() >= 1);
+                    params.joinFields = nodeArgs["joinFields"].numberInt();
+                }
+                if (nodeArgs["direction"].isNumber()) {
+                    params.direction = (1 == nodeArgs["direction"].numberInt()) ? 1 : -1;
+                }
+
+                PlanStage* leftNode = parseQuery(dbname, nodeArgs["left"].Obj(), workingSet,
+                                                 exprs);
+                uassert(17573, "Can't parse left sub-node of mergeJoin: "
+                               + nodeArgs["left"].Obj().toString(), NULL != leftNode);
+                PlanStage* rightNode = parseQuery(dbname, nodeArgs["right"].Obj(), workingSet,
+                                                  exprs);
+                uassert(17574, "Can't parse right sub-node of mergeJoin: "
+                               + nodeArgs["right"].Obj().toString(), NULL != rightNode);
+
+                // takes ownership of both children
+                return new MergeJoinStage(params, workingSet, matcher, leftNode, rightNode);
+            }
             else if ("text" == nodeName) {
                 string ns = nodeArgs["name"].String();
                 string search = nodeArgs["search"].String();
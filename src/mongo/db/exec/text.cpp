@@ -59,6 +59,7 @@ namespace mongo {
 
     PlanStage::StageState TextStage::work(WorkingSetID* out) {
         ++_commonStats.works;
+        ScopedWorkTimer workTimer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -38,21 +38,35 @@ namespace mongo {
     WorkingSet::WorkingSet() : _freeList(INVALID_ID) { }
 
     WorkingSet::~WorkingSet() {
-        for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
+        // Members are owned by the blocks, not the holders.
+        for (size_t i = 0; i < _memberBlocks.size(); i++) {
+            delete[] _memberBlocks[i];
         }
     }
 
     WorkingSetID WorkingSet::allocate() {
         if (_freeList == INVALID_ID) {
-            // The free list is empty so we need to make a single new WSM to return. This relies on
-            // vector::resize being amortized O(1) for efficient allocation. Note that the free list
-            // remains empty until something is returned by a call to free().
-            WorkingSetID id = _data.size();
-            _data.resize(_data.size() + 1);
-            _data.back().nextFreeOrSelf = id;
-            _data.back().member = new WorkingSetMember();
-            return id;
+            // The free list is empty so we allocate members a block at a time.  One new[] serves
+            // the next kMemberBlockSize allocate() calls, and since free() pushes members back on
+            // the free list, a long scan that frees as it goes does O(1) allocations, not O(n).
+            const WorkingSetID firstId = _data.size();
+            _data.resize(_data.size() + kMemberBlockSize);
+
+            WorkingSetMember* block = new WorkingSetMember[kMemberBlockSize];
+            _memberBlocks.push_back(block);
+
+            for (size_t i = 0; i < kMemberBlockSize; i++) {
+                const WorkingSetID id = firstId + i;
+                _data[id].member = &block[i];
+                if (i > 0) {
+                    // All but the first member of the block go on the free list.
+                    _data[id].nextFreeOrSelf = _freeList;
+                    _freeList = id;
+                }
+            }
+
+            _data[firstId].nextFreeOrSelf = firstId; // in use
+            return firstId;
         }
 
         // Pop the head off the free list and return it.
@@ -102,6 +102,11 @@ namespace mongo {
         const unordered_set<WorkingSetID>& getFlagged() const;
 
     private:
+        // How many members we allocate per new[] when the free list runs dry.  Members (and the
+        // capacity of their key vectors) are recycled through the free list, so a scan does one
+        // block allocation per kMemberBlockSize live results rather than one per row.
+        static const size_t kMemberBlockSize = 64;
+
         struct MemberHolder {
             MemberHolder();
             ~MemberHolder();
@@ -109,7 +114,7 @@ namespace mongo {
             // Free list link if freed. Points to self if in use.
             WorkingSetID nextFreeOrSelf;
 
-            // Owning pointer
+            // Not owned here; points into an element of _memberBlocks.
             WorkingSetMember* member;
         };
 
@@ -122,6 +127,9 @@ namespace mongo {
         // If _freeList == INVALID_ID, the free list is empty and all elements in _data are in use.
         WorkingSetID _freeList;
 
+        // Blocks of members referenced by _data; owned here, freed in the destructor.
+        vector<WorkingSetMember*> _memberBlocks;
+
         // An insert-only set of WorkingSetIDs that have been flagged for review.
         unordered_set<WorkingSetID> _flagged;
     };
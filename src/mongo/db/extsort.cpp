@@ -63,14 +63,26 @@ namespace mongo {
     }
 
     BSONObjExternalSorter::BSONObjExternalSorter(const ExternalSortComparison* comp,
-                                                 long maxFileSize)
+                                                 long maxFileSize,
+                                                 const std::string& tempDir)
         : _mayInterrupt(boost::make_shared<bool>(false))
         , _sorter(Sorter<BSONObj, DiskLoc>::make(
-                    SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
+                    SortOptions().TempDir(tempDir.empty() ?
+                                              storageGlobalParams.dbpath + "/_tmp" :
+                                              tempDir)
                                  .ExtSortAllowed()
                                  .MaxMemoryUsageBytes(maxFileSize),
                     ComparatorWithInterruptCheck(comp, _mayInterrupt)))
     {}
+
+    BSONObjExternalSorter::Iterator* BSONObjExternalSorter::mergeIterators(
+            const std::vector<boost::shared_ptr<Iterator> >& iters,
+            const ExternalSortComparison* comp) {
+        return Iterator::merge(
+                iters,
+                SortOptions(),
+                ComparatorWithInterruptCheck(comp, boost::make_shared<bool>(false)));
+    }
 }
 
 #include "mongo/db/sorter/sorter.cpp"
@@ -54,7 +54,15 @@ namespace mongo {
         typedef pair<BSONObj, DiskLoc> Data;
         typedef SortIteratorInterface<BSONObj, DiskLoc> Iterator;
 
-        BSONObjExternalSorter(const ExternalSortComparison* comp, long maxFileSize=100*1024*1024);
+        /**
+         * @param tempDir where sorted run files spill; defaults (empty) to
+         *        <dbpath>/_tmp, which is wiped at startup.  Pass a directory
+         *        that survives restarts when the runs are checkpointed via
+         *        persistRunFiles().
+         */
+        BSONObjExternalSorter(const ExternalSortComparison* comp,
+                              long maxFileSize=100*1024*1024,
+                              const std::string& tempDir = "");
 
         void add( const BSONObj& o, const DiskLoc& loc, bool mayInterrupt ) {
             *_mayInterrupt = mayInterrupt;
@@ -63,6 +71,22 @@ namespace mongo {
 
         auto_ptr<Iterator> iterator() { return auto_ptr<Iterator>(_sorter->done()); }
 
+        /**
+         * Returns an iterator over the merged output of several sorters' iterators,
+         * comparing with comp.  For use when sorted runs were produced by more than
+         * one sorter concurrently.  Caller owns the result.
+         */
+        static Iterator* mergeIterators(const std::vector<boost::shared_ptr<Iterator> >& iters,
+                                        const ExternalSortComparison* comp);
+
+        /** See Sorter::persistRunFiles() / adoptPersistedRunFiles(). */
+        bool persistRunFiles( std::vector<std::string>* fileNames ) {
+            return _sorter->persistRunFiles( fileNames );
+        }
+        bool adoptPersistedRunFiles( const std::vector<std::string>& fileNames ) {
+            return _sorter->adoptPersistedRunFiles( fileNames );
+        }
+
         void sort( bool mayInterrupt ) { *_mayInterrupt = mayInterrupt; }
         int numFiles() { return _sorter->numFiles(); }
         long getCurSizeSoFar() { return _sorter->memUsed(); }
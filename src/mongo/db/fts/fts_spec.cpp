@@ -180,20 +180,23 @@ namespace mongo {
 
             unsigned numTokens = 0;
 
+            string term; // reused across tokens so lowercasing doesn't allocate per token
             Tokenizer i( tools.language, raw );
             while ( i.more() ) {
                 Token t = i.next();
                 if ( t.type != Token::TEXT )
                     continue;
 
-                string term = t.data.toString();
+                term.assign( t.data.rawData(), t.data.size() );
                 makeLower( &term );
                 if ( tools.stopwords->isStopWord( term ) ) {
                     continue;
                 }
-                term = tools.stemmer->stem( term );
+                // view into the stemmer's buffer; the table copies the key
+                // only the first time a term is seen
+                StringData stemmed = tools.stemmer->stemView( term );
 
-                ScoreHelperStruct& data = terms[term];
+                ScoreHelperStruct& data = terms[stemmed];
 
                 if ( data.exp ) {
                     data.exp *= 2;
@@ -40,6 +40,7 @@
 #include "mongo/db/fts/stop_words.h"
 #include "mongo/db/fts/tokenizer.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -50,7 +51,11 @@ namespace mongo {
         extern const double DEFAULT_WEIGHT;
 
         typedef std::map<string,double> Weights; // TODO cool map
-        typedef unordered_map<string,double> TermFrequencyMap;
+
+        // open-addressing table hashed on StringData, so lookups don't have
+        // to materialize a std::string key; the key is only copied when a
+        // term is first inserted
+        typedef StringMap<double> TermFrequencyMap;
 
         struct ScoreHelperStruct {
             ScoreHelperStruct()
@@ -60,7 +65,7 @@ namespace mongo {
             double count;
             double exp;
         };
-        typedef unordered_map<string,ScoreHelperStruct> ScoreHelperMap;
+        typedef StringMap<ScoreHelperStruct> ScoreHelperMap;
 
         class FTSSpec {
 
@@ -52,8 +52,12 @@ namespace mongo {
         }
 
         string Stemmer::stem( const StringData& word ) const {
+            return stemView( word ).toString();
+        }
+
+        StringData Stemmer::stemView( const StringData& word ) const {
             if ( !_stemmer )
-                return word.toString();
+                return word;
 
             const sb_symbol* sb_sym = sb_stemmer_stem( _stemmer,
                                                        (const sb_symbol*)word.rawData(),
@@ -64,7 +68,7 @@ namespace mongo {
                 abort();
             }
 
-            return string( (const char*)(sb_sym), sb_stemmer_length( _stemmer ) );
+            return StringData( (const char*)(sb_sym), sb_stemmer_length( _stemmer ) );
         }
 
     }
@@ -52,6 +52,15 @@ namespace mongo {
             ~Stemmer();
 
             std::string stem( const StringData& word ) const;
+
+            /**
+             * Stems 'word' into the stemmer's internal buffer and returns a
+             * view of the result, avoiding a string allocation per call.  The
+             * view is only valid until the next stem on this stemmer (or
+             * until 'word' is destroyed, for languages without a stemmer);
+             * copy it if the term has to outlive that.
+             */
+            StringData stemView( const StringData& word ) const;
         private:
             struct sb_stemmer* _stemmer;
         };
@@ -49,5 +49,21 @@ namespace mongo {
             ASSERT_EQUALS( "Unite", s.stem( "United" ) );
         }
 
+        TEST( English, StemView ) {
+            Stemmer s( languageEnglishV2 );
+            ASSERT_EQUALS( "run", s.stemView( "running" ).toString() );
+            // view stays valid until the next stem on this stemmer
+            StringData view = s.stemView( "jumping" );
+            ASSERT_EQUALS( "jump", view.toString() );
+        }
+
+        TEST( English, StemViewNoStemmer ) {
+            StatusWithFTSLanguage swl = FTSLanguage::make( "none", TEXT_INDEX_VERSION_2 );
+            ASSERT_OK( swl.getStatus() );
+            Stemmer s( *swl.getValue() );
+            std::string word = "running";
+            ASSERT_EQUALS( "running", s.stemView( word ).toString() );
+        }
+
     }
 }
@@ -74,6 +74,7 @@ namespace mongo {
             bool _previousWhiteSpace;
             const StringData _raw;
             bool _english;
+            const Token::Type* _typeTable; // 256-entry classification table
         };
 
     }
@@ -38,19 +38,106 @@
 
 namespace mongo {
 
-    Hasher::Hasher( HashSeed seed ) : _seed( seed ) {
+    Md5Hasher::Md5Hasher( HashSeed seed ) : _seed( seed ) {
         md5_init( &_md5State );
         md5_append( &_md5State , reinterpret_cast< const md5_byte_t * >( & _seed ) , sizeof( _seed ) );
     }
 
-    void Hasher::addData( const void * keyData , size_t numBytes ) {
+    void Md5Hasher::addData( const void * keyData , size_t numBytes ) {
         md5_append( &_md5State , static_cast< const md5_byte_t * >( keyData ), numBytes );
     }
 
-    void Hasher::finish( HashDigest out ) {
+    void Md5Hasher::finish( HashDigest out ) {
         md5_finish( &_md5State , out );
     }
 
+    namespace {
+        inline unsigned long long rotl64( unsigned long long x , int b ) {
+            return ( x << b ) | ( x >> ( 64 - b ) );
+        }
+    }
+
+    SipHasher::SipHasher( HashSeed seed ) : _buffered( 0 ) , _totalLen( 0 ) {
+        // the 128-bit SipHash key is derived from the 32-bit seed; the seed
+        // participates the same way it does for Md5Hasher: picking among a
+        // family of hash functions
+        const unsigned long long k0 =
+            static_cast<unsigned long long>( static_cast<unsigned int>( seed ) );
+        const unsigned long long k1 = ~k0;
+        _v0 = 0x736f6d6570736575ULL ^ k0;
+        _v1 = 0x646f72616e646f6dULL ^ k1;
+        _v2 = 0x6c7967656e657261ULL ^ k0;
+        _v3 = 0x7465646279746573ULL ^ k1;
+    }
+
+    void SipHasher::_compress( unsigned long long m ) {
+        _v3 ^= m;
+        for ( int i = 0; i < 2; i++ ) {
+            _v0 += _v1; _v1 = rotl64( _v1, 13 ); _v1 ^= _v0; _v0 = rotl64( _v0, 32 );
+            _v2 += _v3; _v3 = rotl64( _v3, 16 ); _v3 ^= _v2;
+            _v0 += _v3; _v3 = rotl64( _v3, 21 ); _v3 ^= _v0;
+            _v2 += _v1; _v1 = rotl64( _v1, 17 ); _v1 ^= _v2; _v2 = rotl64( _v2, 32 );
+        }
+        _v0 ^= m;
+    }
+
+    void SipHasher::addData( const void * keyData , size_t numBytes ) {
+        const unsigned char* p = static_cast<const unsigned char*>( keyData );
+        _totalLen += numBytes;
+
+        while ( numBytes > 0 ) {
+            const size_t take = std::min( numBytes , sizeof( _buf ) - _buffered );
+            memcpy( _buf + _buffered , p , take );
+            _buffered += take;
+            p += take;
+            numBytes -= take;
+
+            if ( _buffered == sizeof( _buf ) ) {
+                // assemble little-endian so the result is byte-order independent
+                unsigned long long m = 0;
+                for ( int i = 7; i >= 0; i-- )
+                    m = ( m << 8 ) | _buf[i];
+                _compress( m );
+                _buffered = 0;
+            }
+        }
+    }
+
+    void SipHasher::finish( HashDigest out ) {
+        // final block: the leftover bytes, zero padded, with the low byte of
+        // the total length in the top byte (per the SipHash spec)
+        unsigned long long m =
+            static_cast<unsigned long long>( _totalLen & 0xff ) << 56;
+        for ( size_t i = 0; i < _buffered; i++ )
+            m |= static_cast<unsigned long long>( _buf[i] ) << ( 8 * i );
+        _compress( m );
+
+        _v2 ^= 0xff;
+        for ( int i = 0; i < 4; i++ ) {
+            _v0 += _v1; _v1 = rotl64( _v1, 13 ); _v1 ^= _v0; _v0 = rotl64( _v0, 32 );
+            _v2 += _v3; _v3 = rotl64( _v3, 16 ); _v3 ^= _v2;
+            _v0 += _v3; _v3 = rotl64( _v3, 21 ); _v3 ^= _v0;
+            _v2 += _v1; _v1 = rotl64( _v1, 17 ); _v1 ^= _v2; _v2 = rotl64( _v2, 32 );
+        }
+
+        const unsigned long long r = _v0 ^ _v1 ^ _v2 ^ _v3;
+        for ( int i = 0; i < 8; i++ )
+            out[i] = static_cast<unsigned char>( r >> ( 8 * i ) );
+        memset( out + 8 , 0 , 8 );
+    }
+
+    Hasher* HasherFactory::createHasher( HashSeed seed , int hashVersion ) {
+        switch ( hashVersion ) {
+        case BSONElementHasher::HASH_VERSION_MD5:
+            return new Md5Hasher( seed );
+        case BSONElementHasher::HASH_VERSION_SIPHASH:
+            return new SipHasher( seed );
+        default: ;
+        }
+        msgasserted( 17446, mongoutils::str::stream()
+                     << "unsupported hashVersion " << hashVersion );
+    }
+
     long long int BSONElementHasher::hash64( const BSONElement& e , HashSeed seed ){
         scoped_ptr<Hasher> h( HasherFactory::createHasher( seed ) );
         recursiveHash( h.get() , e , false );
@@ -61,6 +148,21 @@ namespace mongo {
         return *reinterpret_cast< long long int * >( d );
     }
 
+    long long int BSONElementHasher::hash64( const BSONElement& e ,
+                                             HashSeed seed ,
+                                             int hashVersion ) {
+        if ( hashVersion == HASH_VERSION_SIPHASH ) {
+            // hot path for v1 hashed indexes: no heap allocation per key
+            SipHasher h( seed );
+            recursiveHash( &h , e , false );
+            HashDigest d;
+            h.finish( d );
+            return *reinterpret_cast< long long int * >( d );
+        }
+        massert( 17447, "unsupported hashVersion", hashVersion == HASH_VERSION_MD5 );
+        return hash64( e , seed );
+    }
+
     void BSONElementHasher::recursiveHash( Hasher* h ,
                                            const BSONElement& e ,
                                            bool includeFieldName ) {
@@ -106,9 +208,12 @@ namespace mongo {
 
     struct HasherUnitTest : public StartupTest {
         void run() {
-            // Hard-coded check to ensure the hash function is consistent across platforms
+            // Hard-coded checks to ensure the hash functions are consistent across platforms
             BSONObj o = BSON( "check" << 42 );
             verify( BSONElementHasher::hash64( o.firstElement(), 0 ) == -944302157085130861LL );
+            verify( BSONElementHasher::hash64( o.firstElement(), 0,
+                                               BSONElementHasher::HASH_VERSION_SIPHASH )
+                    == 6613585930625236513LL );
         }
     } hasherUnitTest;
 }
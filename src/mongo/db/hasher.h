@@ -46,30 +46,69 @@ namespace mongo {
     class Hasher : private boost::noncopyable {
     public:
 
-        explicit Hasher( HashSeed seed );
-        ~Hasher() { };
+        virtual ~Hasher() { };
 
         //pointer to next part of input key, length in bytes to read
-        void addData( const void * keyData , size_t numBytes );
+        virtual void addData( const void * keyData , size_t numBytes ) = 0;
 
         //finish computing the hash, put the result in the digest
         //only call this once per Hasher
-        void finish( HashDigest out );
+        virtual void finish( HashDigest out ) = 0;
+    };
+
+    /* The original hasher: MD5 seeded with "seed".  This is hashVersion 0 and
+     * what all hashed indexes and hashed shard keys use by default.
+     */
+    class Md5Hasher : public Hasher {
+    public:
+
+        explicit Md5Hasher( HashSeed seed );
+        virtual ~Md5Hasher() { };
+
+        virtual void addData( const void * keyData , size_t numBytes );
+        virtual void finish( HashDigest out );
 
     private:
         md5_state_t _md5State;
         HashSeed _seed;
     };
 
+    /* SipHash-2-4 keyed from "seed".  This is hashVersion 1; it produces a
+     * 64-bit result (stored in the first 8 bytes of the digest, remainder
+     * zeroed) and is much cheaper than MD5, which matters on the insert path
+     * of hashed indexes.  Cheap enough to live on the stack -- no factory
+     * allocation needed.
+     */
+    class SipHasher : public Hasher {
+    public:
+
+        explicit SipHasher( HashSeed seed );
+        virtual ~SipHasher() { };
+
+        virtual void addData( const void * keyData , size_t numBytes );
+        virtual void finish( HashDigest out );
+
+    private:
+        void _compress( unsigned long long m );
+
+        unsigned long long _v0, _v1, _v2, _v3;
+        unsigned char _buf[8];
+        size_t _buffered;
+        unsigned long long _totalLen;
+    };
+
     class HasherFactory : private boost::noncopyable  {
     public:
-        /* Eventually this may be a more sophisticated factory
-         * for creating other hashers, but for now use MD5.
-         */
+        /* For callers predating hash versions; always MD5 (hashVersion 0). */
         static Hasher* createHasher( HashSeed seed ) {
-            return new Hasher( seed );
+            return new Md5Hasher( seed );
         }
 
+        /* Creates the hasher for the given hashVersion; asserts on unknown
+         * versions.
+         */
+        static Hasher* createHasher( HashSeed seed , int hashVersion );
+
     private:
         HasherFactory();
     };
@@ -86,6 +125,14 @@ namespace mongo {
          */
         static const int DEFAULT_HASH_SEED = 0;
 
+        /* Known hashVersion values.  Version 0 (MD5) is the default and the
+         * only version valid for hashed shard keys; version 1 (SipHash-2-4)
+         * may be requested per index via the "hashVersion" field of the index
+         * spec.  The two versions produce unrelated hash values.
+         */
+        static const int HASH_VERSION_MD5 = 0;
+        static const int HASH_VERSION_SIPHASH = 1;
+
         /* This computes a 64-bit hash of the value part of BSONElement "e",
          * preceded by the seed "seed".  Squashes element (and any sub-elements)
          * of the same canonical type, so hash({a:{b:4}}) will be the same
@@ -100,6 +147,12 @@ namespace mongo {
          */
         static long long int hash64( const BSONElement& e , HashSeed seed );
 
+        /* As above but with an explicit hashVersion; hash64( e, seed ) is
+         * equivalent to hash64( e, seed, HASH_VERSION_MD5 ).  Version 1 skips
+         * the factory allocation entirely and hashes on the stack.
+         */
+        static long long int hash64( const BSONElement& e , HashSeed seed , int hashVersion );
+
         /* This incrementally computes the hash of BSONElement "e"
          * using hash function "h".  If "includeFieldName" is true,
          * then the name of the field is hashed in between the type of
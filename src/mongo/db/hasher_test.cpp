@@ -381,5 +381,35 @@ namespace {
         ASSERT_EQUALS( hashIt( o ), 501342939894575968LL );
     }
 
+    // hashVersion 1 (SipHash) tests
+
+    long long hashItV1( const BSONObj& object, int seed ) {
+        return BSONElementHasher::hash64( object.firstElement(), seed,
+                                          BSONElementHasher::HASH_VERSION_SIPHASH );
+    }
+
+    // Fixed value so the v1 hash stays consistent across platforms and releases
+    TEST( BSONElementHasher, FastHashKnownResult ) {
+        BSONObj o = BSON( "check" << 42 );
+        ASSERT_EQUALS( hashItV1( o, 0 ), 6613585930625236513LL );
+        ASSERT_EQUALS( hashItV1( o, 0x5eed ), -3607264044799998796LL );
+    }
+
+    // v1 squashes numeric types the same way v0 does
+    TEST( BSONElementHasher, FastHashConsistentForIntLongAndDouble ) {
+        long long int intHash = hashItV1( BSON("a" << 3), 0 );
+        ASSERT_EQUALS( intHash, hashItV1( BSON("a" << 3LL), 0 ) );
+        ASSERT_EQUALS( intHash, hashItV1( BSON("a" << 3.1), 0 ) );
+    }
+
+    TEST( BSONElementHasher, FastHashSeedMatters ) {
+        ASSERT_NOT_EQUALS( hashItV1( BSON("a" << 4), 0 ), hashItV1( BSON("a" << 4), 1 ) );
+    }
+
+    // the two versions are unrelated hash functions
+    TEST( BSONElementHasher, FastHashDiffersFromMd5 ) {
+        ASSERT_NOT_EQUALS( hashItV1( BSON("a" << 4), 0 ), hashIt( BSON("a" << 4), 0 ) );
+    }
+
 } // namespace
 } // namespace mongo
@@ -0,0 +1,144 @@
+// health_fast_lane.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/health_fast_lane.h"
+
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/util/background.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    namespace {
+
+        bool isHeartbeatName( const char* name ) {
+            return str::equals( name, "isMaster" ) || str::equals( name, "ismaster" ) ||
+                   str::equals( name, "ping" );
+        }
+
+        mongo::mutex refresherStartMutex( "HealthFastLane" );
+        bool refresherStarted = false;
+    }
+
+    class HealthFastLane::Refresher : public BackgroundJob {
+    public:
+        Refresher() : BackgroundJob( true /* selfDelete */ ) {}
+
+        virtual string name() const { return "HealthFastLane"; }
+
+        virtual void run() {
+            Client::initThread( "healthFastLane" );
+            while ( !inShutdown() ) {
+                try {
+                    HealthFastLane::global._refresh();
+                }
+                catch ( const std::exception& e ) {
+                    warning() << "health fast lane refresh failed: " << e.what() << endl;
+                }
+                sleepmillis( kRefreshMillis );
+            }
+            cc().shutdown();
+        }
+    };
+
+    void HealthFastLane::_refresh() {
+        Command* c = Command::findCommand( "isMaster" );
+        if ( !c )
+            return;
+
+        BSONObj cmd = BSON( "isMaster" << 1 );
+        string errmsg;
+        BSONObjBuilder b;
+        if ( !c->run( "admin", cmd, 0, errmsg, b, false ) )
+            return;
+        b.append( "ok", 1.0 );
+        BSONObj reply = b.obj();
+
+        SimpleMutex::scoped_lock lk( _lock );
+        _isMasterReply = reply;
+        _builtAt = curTimeMillis64();
+    }
+
+    bool HealthFastLane::handle( Message& m, DbResponse& dbresponse ) {
+        BSONObj query;
+        int ntoreturn;
+        try {
+            DbMessage d( m );
+            QueryMessage q( d );
+            query = q.query;
+            ntoreturn = q.ntoreturn;
+        }
+        catch ( const AssertionException& ) {
+            return false; // let the normal path report the malformed message
+        }
+
+        // only the bare heartbeat forms; anything else (forShell, compression
+        // lists, wrapped queries, ...) takes the full command path
+        if ( ntoreturn != 1 && ntoreturn != -1 )
+            return false;
+        if ( query.nFields() != 1 )
+            return false;
+        const char* name = query.firstElementFieldName();
+        if ( !isHeartbeatName( name ) )
+            return false;
+
+        {
+            scoped_lock lk( refresherStartMutex );
+            if ( !refresherStarted ) {
+                refresherStarted = true;
+                ( new Refresher() )->go();
+            }
+        }
+
+        BSONObj reply;
+        if ( str::equals( name, "ping" ) ) {
+            reply = BSON( "ok" << 1.0 );
+        }
+        else {
+            SimpleMutex::scoped_lock lk( _lock );
+            if ( _builtAt == 0 || curTimeMillis64() - _builtAt > kMaxAgeMillis )
+                return false; // cold or stale; the refresher will catch up
+            reply = _isMasterReply;
+        }
+
+        globalOpCounters.gotCommand();
+        replyToQuery( 0, m, dbresponse, reply );
+        return true;
+    }
+
+    HealthFastLane HealthFastLane::global;
+
+}  // namespace mongo
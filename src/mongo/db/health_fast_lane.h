@@ -0,0 +1,84 @@
+// health_fast_lane.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class Message;
+    struct DbResponse;
+
+    /**
+     * Answers heartbeat-class commands ({ isMaster: 1 } and { ping: 1 } with
+     * no other fields) from a cached reply at the top of assembleResponse,
+     * before command dispatch, CurOp bookkeeping or admission control.  A
+     * saturated mongod then still answers driver and ReplicaSetMonitor
+     * health checks promptly instead of looking dead and triggering false
+     * failovers.
+     *
+     * The isMaster reply is rebuilt every kRefreshMillis by a dedicated
+     * background thread running the real command, so topology changes show
+     * up within a beat.  Requests with extra fields (forShell, compression
+     * negotiation, ...) and requests arriving while the cache is cold or
+     * stale fall through to the normal path.
+     */
+    class HealthFastLane {
+    public:
+        static const int kRefreshMillis = 250;
+
+        // serve nothing older than this; a wedged refresher must not pin a
+        // stale topology reply
+        static const int kMaxAgeMillis = 5000;
+
+        HealthFastLane() : _lock( "HealthFastLane" ), _builtAt( 0 ) {}
+
+        /**
+         * True if 'm' was answered here.  Only call for dbQuery messages on
+         * a $cmd namespace; starts the refresher thread lazily.
+         */
+        bool handle( Message& m, DbResponse& dbresponse );
+
+        static HealthFastLane global;
+
+    private:
+        class Refresher;
+
+        /** Rebuilds the cached isMaster reply; runs on the refresher. */
+        void _refresh();
+
+        SimpleMutex _lock;
+        BSONObj _isMasterReply;
+        unsigned long long _builtAt; // millis; 0 until the first refresh
+    };
+
+}  // namespace mongo
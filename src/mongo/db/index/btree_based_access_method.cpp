@@ -42,19 +42,34 @@
 #include "mongo/db/pdfile.h"
 #include "mongo/db/pdfile_private.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/sort_phase_one.h"
 #include "mongo/db/structure/btree/btreebuilder.h"
+#include "mongo/db/structure/btree/ordered_key.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/work_stealing_pool.h"
 #include "mongo/util/progress_meter.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
     BtreeBasedAccessMethod::BtreeBasedAccessMethod(IndexCatalogEntry* btreeState)
-        : _btreeState(btreeState), _descriptor(btreeState->descriptor()) {
+        : _btreeState(btreeState),
+          _descriptor(btreeState->descriptor()),
+          _sketchPrimeMutex("countSketchPrime") {
 
         verify(0 == _descriptor->version() || 1 == _descriptor->version());
         _interface = BtreeInterface::interfaces[_descriptor->version()];
     }
 
+    void BtreeBasedAccessMethod::getKeysBulk(const vector<BSONObj>& objs,
+                                             vector<BSONObjSet>* keysOut) {
+        keysOut->resize(objs.size());
+        for (size_t i = 0; i < objs.size(); i++) {
+            getKeys(objs[i], &(*keysOut)[i]);
+        }
+    }
+
     // Find the keys for obj, put them in the tree pointing to loc
     Status BtreeBasedAccessMethod::insert(const BSONObj& obj, const DiskLoc& loc,
             const InsertDeleteOptions& options, int64_t* numInserted) {
@@ -65,26 +80,34 @@ namespace mongo {
         // Delegate to the subclass.
         getKeys(obj, &keys);
 
+        // The set iterates in sorted order, so consecutive keys tend to land in the same
+        // bucket and the batched insert below can skip most root-to-leaf descents.
+        vector<BSONObj> sortedKeys(keys.begin(), keys.end());
+
         Status ret = Status::OK();
 
-        for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+        size_t cursor = 0;
+        size_t skipped = 0;
+        while (cursor < sortedKeys.size()) {
             try {
-                _interface->bt_insert(_btreeState,
-                                      _btreeState->head(),
-                                      loc,
-                                      *i,
-                                      options.dupsAllowed,
-                                      true);
-                ++*numInserted;
+                _interface->bt_insert_batch(_btreeState,
+                                            _btreeState->head(),
+                                            loc,
+                                            sortedKeys,
+                                            options.dupsAllowed,
+                                            &cursor);
             } catch (AssertionException& e) {
+                // 'cursor' indexes the key that failed; keys before it were applied.
                 if (10287 == e.getCode() && !_btreeState->isReady()) {
                     // This is the duplicate key exception.  We ignore it for some reason in BG
                     // indexing.
                     DEV log() << "info: key already in index during bg indexing (ok)\n";
+                    ++cursor;
+                    ++skipped;
                 } else if (!options.dupsAllowed) {
                     // Assuming it's a duplicate key exception.  Clean up any inserted keys.
-                    for (BSONObjSet::const_iterator j = keys.begin(); j != i; ++j) {
-                        removeOneKey(*j, loc);
+                    for (size_t j = 0; j < cursor; ++j) {
+                        removeOneKey(sortedKeys[j], loc);
                     }
                     *numInserted = 0;
                     return Status(ErrorCodes::DuplicateKey, e.what(), e.getCode());
@@ -93,14 +116,26 @@ namespace mongo {
                               << _descriptor->indexNamespace()
                               << obj["_id"] << endl;
                     ret = Status(ErrorCodes::InternalError, e.what(), e.getCode());
+                    ++cursor;
+                    ++skipped;
                 }
             }
         }
 
+        *numInserted = cursor - skipped;
+
         if (*numInserted > 1) {
             _btreeState->setMultikey();
         }
 
+        // Only count clean inserts; on the rare partial-failure paths the
+        // sketch is left alone and just drifts a little.
+        if (_countSketch.isPrimed() && *numInserted == static_cast<int64_t>(sortedKeys.size())) {
+            for (size_t i = 0; i < sortedKeys.size(); ++i) {
+                _countSketch.noteInsert(sortedKeys[i]);
+            }
+        }
+
         return ret;
     }
 
@@ -143,6 +178,9 @@ namespace mongo {
 
             if (thisKeyOK) {
                 ++*numDeleted;
+                if (_countSketch.isPrimed()) {
+                    _countSketch.noteRemove(*i);
+                }
             } else if (options.logIfError) {
                 log() << "unindex failed (key too big?) " << _descriptor->indexNamespace()
                       << " key: " << *i << " " << loc.obj()["_id"] << endl;
@@ -229,6 +267,55 @@ namespace mongo {
     }
 
 
+    const IndexCountSketch* BtreeBasedAccessMethod::getCountSketch() {
+        if (!_btreeState->isReady()) {
+            return NULL;
+        }
+
+        if (_countSketch.isPrimed()) {
+            return &_countSketch;
+        }
+
+        // Prime with one walk of the index.  Concurrent counts can race to
+        // get here, so serialize them; writers hold the database write lock
+        // and are already excluded by our caller's read lock.
+        SimpleMutex::scoped_lock lk(_sketchPrimeMutex);
+        if (_countSketch.isPrimed()) {
+            return &_countSketch;
+        }
+
+        Timer t;
+        _countSketch.reset();
+
+        // the first entry is at or after MinKey in every field
+        BSONObjBuilder firstKey;
+        BSONObjIterator pat(_descriptor->keyPattern());
+        while (pat.more()) {
+            pat.next();
+            firstKey.appendMinKey("");
+        }
+
+        IndexCursor* rawCursor;
+        Status status = newCursor(&rawCursor);
+        if (!status.isOK()) {
+            return NULL;
+        }
+        auto_ptr<IndexCursor> cursor(rawCursor);
+
+        cursor->seek(firstKey.obj());
+        while (!cursor->isEOF()) {
+            _countSketch.noteInsert(cursor->getKey());
+            cursor->next();
+        }
+        _countSketch.notePrimed();
+
+        LOG(1) << "primed count sketch for " << _descriptor->indexNamespace()
+               << " keys: " << _countSketch.totalKeys()
+               << " took: " << t.millis() << "ms";
+
+        return &_countSketch;
+    }
+
     Status BtreeBasedAccessMethod::validate(int64_t* numKeys) {
         *numKeys = _interface->fullValidate(_btreeState,
                                             _btreeState->head(),
@@ -302,6 +389,15 @@ namespace mongo {
                                 data->loc);
         }
 
+        if (_countSketch.isPrimed()) {
+            for (size_t i = 0; i < data->added.size(); ++i) {
+                _countSketch.noteInsert(*data->added[i]);
+            }
+            for (size_t i = 0; i < data->removed.size(); ++i) {
+                _countSketch.noteRemove(*data->removed[i]);
+            }
+        }
+
         *numUpdated = data->added.size();
 
         return Status::OK();
@@ -309,9 +405,52 @@ namespace mongo {
 
     // -------
 
+    // During a bulk build on a V1 index each key is encoded once with
+    // encodeOrderedKey() where possible, so the external sort compares keys
+    // with a single memcmp instead of decoding both sides field by field on
+    // every comparison.  The sorter still carries BSONObj, so the encoding
+    // rides in a one-field wrapper object: "o" holds the encoded bytes, and
+    // keys the encoding cannot represent stay unchanged under "b".
+    static BSONObj wrapOrderedKey( const BSONObj& key, const Ordering& ord ) {
+        BufBuilder bytes( key.objsize() + 16 );
+        if ( !encodeOrderedKey( key, ord, bytes ) )
+            return BSON( "b" << key );
+        BSONObjBuilder b( bytes.len() + 16 );
+        b.appendBinData( "o", bytes.len(), BinDataGeneral, bytes.buf() );
+        return b.obj();
+    }
+
+    static BSONObj unwrapOrderedKey( const BSONObj& wrapped, const Ordering& ord ) {
+        BSONElement e = wrapped.firstElement();
+        if ( *e.fieldName() == 'b' )
+            return e.Obj();
+        int len;
+        const char* data = e.binData( len );
+        return decodeOrderedKey( data, len, ord );
+    }
+
+    // -------
+
+    // Number of threads generating keys and producing sorted runs during a
+    // foreground (bulk) index build.  <= 1 keeps the single-threaded build.
+    MONGO_EXPORT_SERVER_PARAMETER(internalIndexBulkSortThreads, int, 0);
+
+    namespace {
+        const int kMaxBulkSortThreads = 16;
+        // records handed to a sort worker at a time; copies are batched so the
+        // producing scan doesn't bounce to a worker queue for every record
+        const size_t kBulkSortBatchDocs = 64;
+        // default sorter memory budget (matches BSONObjExternalSorter's);
+        // split across the shards of a parallel sort
+        const long kBulkSorterMemBytes = 100 * 1024 * 1024;
+    }
+
     class BtreeBulk : public IndexAccessMethod {
     public:
-        BtreeBulk( BtreeBasedAccessMethod* real ) {
+        BtreeBulk( BtreeBasedAccessMethod* real )
+            : _orderedSort( false ),
+              _nextShard( 0 ),
+              _sortErrMutex( "BtreeBulk" ) {
             _real = real;
         }
 
@@ -321,11 +460,30 @@ namespace mongo {
                               const DiskLoc& loc,
                               const InsertDeleteOptions& options,
                               int64_t* numInserted) {
-            BSONObjSet keys;
-            _real->getKeys(obj, &keys);
-            _phase1.addKeys(keys, loc, false);
+            if ( _sortPool ) {
+                {
+                    SimpleMutex::scoped_lock lk( _sortErrMutex );
+                    if ( !_firstSortError.empty() )
+                        return Status( ErrorCodes::InternalError,
+                                       "parallel index sort failed: " + _firstSortError );
+                }
+
+                // Own a copy: the record's memory may be remapped (journal
+                // commit) before a worker picks the batch up.
+                _pendingBatch->push_back( std::make_pair( obj.getOwned(), loc ) );
+                if ( _pendingBatch->size() >= kBulkSortBatchDocs )
+                    dispatchBatch();
+
+                // Keys aren't generated until a worker runs, so this reports
+                // records rather than keys.  Current bulk callers ignore it.
+                if ( numInserted )
+                    *numInserted += 1;
+                return Status::OK();
+            }
+
+            size_t nKeys = addDocToPhaseOne( &_phase1, obj, loc );
             if ( numInserted )
-                *numInserted += keys.size();
+                *numInserted += nKeys;
             return Status::OK();
         }
 
@@ -367,6 +525,57 @@ namespace mongo {
             return Status::OK();
         }
 
+        virtual bool prepareResumableBulk( const std::string& runDir,
+                                           const BSONObj& state ) {
+            if ( _sortPool ) {
+                // a parallel sort spreads its runs over per-shard sorters;
+                // only the single-sorter serial build checkpoints
+                return false;
+            }
+
+            // Recreate the sorter so its runs land under runDir, which
+            // survives the startup wipe of <dbpath>/_tmp.
+            _phase1.sorter.reset( new BSONObjExternalSorter( _phase1.sortCmp.get(),
+                                                             kBulkSorterMemBytes,
+                                                             runDir ) );
+            if ( state.isEmpty() )
+                return true;
+
+            if ( state["runs"].type() != Array )
+                return false;
+
+            std::vector<std::string> runFiles;
+            BSONObjIterator it( state["runs"].Obj() );
+            while ( it.more() )
+                runFiles.push_back( it.next().String() );
+
+            if ( runFiles.empty() || !_phase1.sorter->adoptPersistedRunFiles( runFiles ) )
+                return false;
+
+            _phase1.n = static_cast<unsigned long long>( state["n"].numberLong() );
+            _phase1.nkeys = static_cast<unsigned long long>( state["nkeys"].numberLong() );
+            _phase1.multi = state["multi"].trueValue();
+            return true;
+        }
+
+        virtual bool saveBulkCheckpoint( BSONObjBuilder* state ) {
+            if ( _sortPool )
+                return false;
+
+            std::vector<std::string> runFiles;
+            if ( !_phase1.sorter->persistRunFiles( &runFiles ) || runFiles.empty() )
+                return false;
+
+            state->appendNumber( "n", static_cast<long long>( _phase1.n ) );
+            state->appendNumber( "nkeys", static_cast<long long>( _phase1.nkeys ) );
+            state->appendBool( "multi", _phase1.multi );
+            BSONArrayBuilder runs( state->subarrayStart( "runs" ) );
+            for ( size_t i = 0; i < runFiles.size(); i++ )
+                runs.append( runFiles[i] );
+            runs.done();
+            return true;
+        }
+
         virtual Status touch(const BSONObj& obj) {
             return _notAllowed();
         }
@@ -393,7 +602,14 @@ namespace mongo {
             BtreeBuilder<V> btBuilder(dupsAllowed, entry);
 
             BSONObj keyLast;
-            scoped_ptr<BSONObjExternalSorter::Iterator> i( _phase1.sorter->iterator() );
+
+            // A parallel sort left its k-way merge in _mergedIter; a serial
+            // build drains its single sorter directly.
+            scoped_ptr<BSONObjExternalSorter::Iterator> i;
+            if ( _mergedIter )
+                i.swap( _mergedIter );
+            else
+                i.reset( _phase1.sorter->iterator().release() );
 
             // verifies that pm and op refer to the same ProgressMeter
             ProgressMeter& pm = op->setMessage("Index Bulk Build: (2/3) btree bottom up",
@@ -404,14 +620,16 @@ namespace mongo {
             while( i->more() ) {
                 RARELY if ( mayInterrupt ) killCurrentOp.checkForInterrupt();
                 ExternalSortDatum d = i->next();
+                BSONObj key = _orderedSort ?
+                    unwrapOrderedKey( d.first, entry->ordering() ) : d.first;
 
                 try {
                     if ( !dupsAllowed && dropDups ) {
                         LastError::Disabled led( lastError.get() );
-                        btBuilder.addKey(d.first, d.second);
+                        btBuilder.addKey(key, d.second);
                     }
                     else {
-                        btBuilder.addKey(d.first, d.second);
+                        btBuilder.addKey(key, d.second);
                     }
                 }
                 catch( AssertionException& e ) {
@@ -453,12 +671,159 @@ namespace mongo {
 
         // -------
 
+        typedef std::vector< std::pair<BSONObj, DiskLoc> > BulkDocBatch;
+
+        // One slice of a parallel sort: a worker generates keys into the
+        // shard's own sorter so sorted runs are produced concurrently.  The
+        // mutex is normally uncontended -- batches for a shard are pinned to
+        // one worker and only a work steal makes two workers meet here.
+        struct SortShard {
+            SortShard() : mutex( "BtreeBulk::SortShard" ) {}
+            SimpleMutex mutex;
+            SortPhaseOne phase1;
+        };
+
+        /**
+         * Switches this bulk to parallel mode: nThreads workers each own a
+         * shard, so key generation and sorted-run production run off the
+         * scanning thread.  Call before the first insert().
+         */
+        void startParallelSort( int nThreads ) {
+            for ( int i = 0; i < nThreads; i++ ) {
+                boost::shared_ptr<SortShard> shard( new SortShard() );
+                shard->phase1.sortCmp = _phase1.sortCmp;
+                shard->phase1.sorter.reset(
+                    new BSONObjExternalSorter( shard->phase1.sortCmp.get(),
+                                               kBulkSorterMemBytes / nThreads ) );
+                _shards.push_back( shard );
+            }
+            _pendingBatch.reset( new BulkDocBatch() );
+            _pendingBatch->reserve( kBulkSortBatchDocs );
+            _sortPool.reset( new threadpool::WorkStealingPool( nThreads ) );
+        }
+
+        /// Hands the pending batch to the next shard's worker.
+        void dispatchBatch() {
+            BulkDocBatch* batch = _pendingBatch.release();
+            const unsigned shard = _nextShard++ % _shards.size();
+            try {
+                _sortPool->scheduleOn( shard,
+                                       boost::bind( &BtreeBulk::sortBatchTask,
+                                                    this, shard, batch ) );
+            }
+            catch ( ... ) {
+                delete batch;
+                throw;
+            }
+            _pendingBatch.reset( new BulkDocBatch() );
+            _pendingBatch->reserve( kBulkSortBatchDocs );
+        }
+
+        /// Runs on a sort worker.
+        void sortBatchTask( unsigned shardNum, BulkDocBatch* batchRaw ) {
+            scoped_ptr<BulkDocBatch> batch( batchRaw );
+            SortShard& shard = *_shards[shardNum];
+            try {
+                std::vector<BSONObj> docs( batch->size() );
+                for ( size_t i = 0; i < batch->size(); i++ )
+                    docs[i] = (*batch)[i].first;
+                std::vector<BSONObjSet> keys;
+                _real->getKeysBulk( docs, &keys );
+
+                SimpleMutex::scoped_lock lk( shard.mutex );
+                for ( size_t i = 0; i < batch->size(); i++ ) {
+                    addKeysToPhaseOne( &shard.phase1, keys[i], (*batch)[i].second );
+                }
+            }
+            catch ( const std::exception& e ) {
+                // surfaced by the next insert() or by finishSort()
+                SimpleMutex::scoped_lock lk( _sortErrMutex );
+                if ( _firstSortError.empty() )
+                    _firstSortError = e.what();
+            }
+        }
+
+        /**
+         * Completes parallel run production: flushes the last batch, waits
+         * for the workers, folds per-shard counts into _phase1 and sets up
+         * the k-way merge that commit() will drain.  The merge itself stays
+         * single threaded because BtreeBuilder consumes keys strictly in
+         * order.  No-op for a serial build.
+         */
+        Status finishSort() {
+            if ( !_sortPool )
+                return Status::OK();
+
+            if ( !_pendingBatch->empty() )
+                dispatchBatch();
+            _sortPool->join();
+
+            {
+                SimpleMutex::scoped_lock lk( _sortErrMutex );
+                if ( !_firstSortError.empty() )
+                    return Status( ErrorCodes::InternalError,
+                                   "parallel index sort failed: " + _firstSortError );
+            }
+
+            std::vector< boost::shared_ptr<BSONObjExternalSorter::Iterator> > iters;
+            for ( size_t i = 0; i < _shards.size(); i++ ) {
+                SortPhaseOne& p = _shards[i]->phase1;
+                _phase1.n += p.n;
+                _phase1.nkeys += p.nkeys;
+                _phase1.multi = _phase1.multi || p.multi;
+                iters.push_back(
+                    boost::shared_ptr<BSONObjExternalSorter::Iterator>(
+                        p.sorter->iterator().release() ) );
+            }
+            _mergedIter.reset(
+                BSONObjExternalSorter::mergeIterators( iters, _phase1.sortCmp.get() ) );
+            return Status::OK();
+        }
+
+        /// Generates (and for v1 encodes) keys for obj and feeds them to phase1.
+        size_t addDocToPhaseOne( SortPhaseOne* phase1, const BSONObj& obj, const DiskLoc& loc ) {
+            BSONObjSet keys;
+            _real->getKeys(obj, &keys);
+            return addKeysToPhaseOne( phase1, keys, loc );
+        }
+
+        /// The second half of addDocToPhaseOne, for callers that generated
+        /// keys in a batch via getKeysBulk().
+        size_t addKeysToPhaseOne( SortPhaseOne* phase1, const BSONObjSet& keys, const DiskLoc& loc ) {
+            if ( _orderedSort ) {
+                const Ordering& ord = _real->_btreeState->ordering();
+                BSONObjSet wrapped;
+                for ( BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i ) {
+                    wrapped.insert( wrapOrderedKey( *i, ord ) );
+                }
+                phase1->addKeys( wrapped, loc, false );
+            }
+            else {
+                phase1->addKeys( keys, loc, false );
+            }
+            return keys.size();
+        }
+
+        // -------
+
         Status _notAllowed() const {
             return Status( ErrorCodes::InternalError, "cannot use bulk for this yet" );
         }
 
         BtreeBasedAccessMethod* _real; // now owned here
         SortPhaseOne _phase1;
+        bool _orderedSort; // keys in _phase1 are wrapOrderedKey()-wrapped
+
+        // parallel sort state; empty (and _sortPool NULL) for a serial build
+        std::vector< boost::shared_ptr<SortShard> > _shards;
+        unsigned _nextShard;
+        std::auto_ptr<BulkDocBatch> _pendingBatch;
+        scoped_ptr<BSONObjExternalSorter::Iterator> _mergedIter;
+        SimpleMutex _sortErrMutex;
+        std::string _firstSortError;
+        // declared last: its destructor joins outstanding tasks before the
+        // shards they reference go away
+        scoped_ptr<threadpool::WorkStealingPool> _sortPool;
     };
 
     int oldCompare(const BSONObj& l,const BSONObj& r, const Ordering &o); // key.cpp
@@ -497,6 +862,39 @@ namespace mongo {
         const Ordering _ordering;
     };
 
+    // for keys wrapped with wrapOrderedKey(); when both sides carry an
+    // encoding this is a single memcmp, otherwise (rare: a key with an
+    // unencodable field on either side) we unwrap and compare the old way.
+    class BtreeExternalSortComparisonOrdered : public ExternalSortComparison {
+    public:
+        BtreeExternalSortComparisonOrdered(const BSONObj& ordering)
+            : _ordering(Ordering::make(ordering)) {
+        }
+
+        virtual ~BtreeExternalSortComparisonOrdered() { }
+
+        virtual int compare(const ExternalSortDatum& l, const ExternalSortDatum& r) const {
+            BSONElement le = l.first.firstElement();
+            BSONElement re = r.first.firstElement();
+            int x;
+            if (*le.fieldName() == 'o' && *re.fieldName() == 'o') {
+                int llen, rlen;
+                const char* ld = le.binData(llen);
+                const char* rd = re.binData(rlen);
+                x = compareOrderedKeys(ld, llen, rd, rlen);
+            }
+            else {
+                x = unwrapOrderedKey(l.first, _ordering).woCompare(
+                        unwrapOrderedKey(r.first, _ordering),
+                        _ordering, /*considerfieldname*/false);
+            }
+            if (x) { return x; }
+            return l.second.compare(r.second);
+        }
+    private:
+        const Ordering _ordering;
+    };
+
     ExternalSortComparison* BtreeBasedAccessMethod::getComparison(int version,
                                                                   const BSONObj& keyPattern) {
 
@@ -517,12 +915,28 @@ namespace mongo {
             return NULL;
 
         auto_ptr<BtreeBulk> bulk( new BtreeBulk( this ) );
-        bulk->_phase1.sortCmp.reset( getComparison( _descriptor->version(),
-                                                    _descriptor->keyPattern() ) );
+        if ( 1 == _descriptor->version() ) {
+            // encode keys once so the sort's comparisons are memcmps
+            bulk->_orderedSort = true;
+            bulk->_phase1.sortCmp.reset(
+                new BtreeExternalSortComparisonOrdered( _descriptor->keyPattern() ) );
+        }
+        else {
+            bulk->_phase1.sortCmp.reset( getComparison( _descriptor->version(),
+                                                        _descriptor->keyPattern() ) );
+        }
 
         bulk->_phase1.sorter.reset( new BSONObjExternalSorter(bulk->_phase1.sortCmp.get()) );
         bulk->_phase1.sorter->hintNumObjects( _btreeState->collection()->numRecords() );
 
+        int sortThreads = internalIndexBulkSortThreads;
+        if ( sortThreads > kMaxBulkSortThreads )
+            sortThreads = kMaxBulkSortThreads;
+        if ( sortThreads > 1 ) {
+            log() << "\t bulk index sort using " << sortThreads << " threads";
+            bulk->startParallelSort( sortThreads );
+        }
+
         return bulk.release();
     }
 
@@ -544,6 +958,11 @@ namespace mongo {
         string ns = _btreeState->collection()->ns().ns();
 
         BtreeBulk* bulk = static_cast<BtreeBulk*>( bulkRaw );
+
+        Status sortStatus = bulk->finishSort();
+        if ( !sortStatus.isOK() )
+            return sortStatus;
+
         if ( bulk->_phase1.multi )
             _btreeState->setMultikey();
 
@@ -559,5 +978,14 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool BtreeBasedAccessMethod::prepareResumableBulk( const std::string& runDir,
+                                                       const BSONObj& state ) {
+        return false;
+    }
+
+    bool BtreeBasedAccessMethod::saveBulkCheckpoint( BSONObjBuilder* state ) {
+        return false;
+    }
+
 
 }  // namespace mongo
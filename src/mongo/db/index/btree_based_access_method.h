@@ -35,8 +35,10 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/index/btree_interface.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_count_sketch.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -89,6 +91,13 @@ namespace mongo {
                                    bool mayInterrupt,
                                    std::set<DiskLoc>* dups );
 
+        // Checkpointing is only meaningful on the bulk returned by
+        // initiateBulk; on the real access method both decline.
+        virtual bool prepareResumableBulk( const std::string& runDir,
+                                           const BSONObj& state );
+
+        virtual bool saveBulkCheckpoint( BSONObjBuilder* state );
+
         virtual Status touch(const BSONObj& obj);
 
         virtual Status validate(int64_t* numKeys);
@@ -96,6 +105,10 @@ namespace mongo {
         // XXX: consider migrating callers to use IndexCursor instead
         virtual DiskLoc findSingle( const BSONObj& key ) const;
 
+        // Primes the sketch with one (non-yielding) index walk on first use;
+        // NULL while the index is still building.
+        virtual const IndexCountSketch* getCountSketch();
+
         // exposed for testing, used for bulk commit
         static ExternalSortComparison* getComparison(int version,
                                                      const BSONObj& keyPattern);
@@ -109,9 +122,24 @@ namespace mongo {
 
         virtual void getKeys(const BSONObj &obj, BSONObjSet *keys) = 0;
 
+        // Computes keys for a batch of documents in one call; keysOut is
+        // resized to objs.size() with one key set per document.  The default
+        // just loops over getKeys(); access methods that can amortize
+        // per-document setup (e.g. hashed) override it.  Used by the bulk
+        // builder, which already hands documents to its sort workers in
+        // batches.
+        virtual void getKeysBulk(const std::vector<BSONObj>& objs,
+                                 std::vector<BSONObjSet>* keysOut);
+
         IndexCatalogEntry* _btreeState; // owned by IndexCatalogEntry
         const IndexDescriptor* _descriptor;
 
+        // approximate-count support; see index_count_sketch.h.  Updated by
+        // insert/remove/update once primed, which happens lazily in
+        // getCountSketch().
+        IndexCountSketch _countSketch;
+        SimpleMutex _sketchPrimeMutex;
+
         // There are 2 types of Btree disk formats.  We put them both behind one interface.
         BtreeInterface* _interface;
 
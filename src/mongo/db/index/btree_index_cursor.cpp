@@ -31,10 +31,12 @@
 #include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/prefetch.h"
 #include "mongo/platform/unordered_set.h"
 
 namespace mongo {
@@ -119,6 +121,70 @@ namespace mongo {
         skipUnusedKeys();
     }
 
+    Status BtreeIndexCursor::seekTowards(const BSONObj& position) {
+        if (isEOF() || _keyOffset < 0) {
+            // No finger to start from (or our bucket was deleted); plain seek.
+            return seek(position);
+        }
+
+        const DiskLoc start = findFingerStart(position);
+
+        _keyOffset = 0;
+
+        // Unused out parameter.
+        bool found;
+
+        _bucket = _interface->locate(_btreeState,
+                                     start,
+                                     position,
+                                     _keyOffset,
+                                     found,
+                                     1 == _direction ? minDiskLoc : maxDiskLoc,
+                                     _direction);
+
+        skipUnusedKeys();
+
+        return Status::OK();
+    }
+
+    DiskLoc BtreeIndexCursor::findFingerStart(const BSONObj& position) const {
+        const DiskLoc head = _btreeState->head();
+        if (_bucket.isNull()) { return head; }
+
+        try {
+            DiskLoc loc = _bucket;
+            while (!loc.isNull() && loc != head) {
+                int n = _interface->nKeys(_btreeState, loc);
+
+                // A bucket's subtree spans a contiguous key range that includes
+                // everything strictly between its first and last keys, so once
+                // 'position' falls strictly inside that range the descent below
+                // this bucket finds it -- including any duplicates -- without
+                // touching the levels above.  Strict comparison matters: a key
+                // equal to a bucket boundary can have duplicates in a sibling
+                // subtree.
+                if (n > 0 &&
+                    position.woCompare(_interface->keyAt(_btreeState, loc, 0),
+                                       _btreeState->ordering(), false) > 0 &&
+                    position.woCompare(_interface->keyAt(_btreeState, loc, n - 1),
+                                       _btreeState->ordering(), false) < 0) {
+                    return loc;
+                }
+
+                loc = _interface->parentAt(_btreeState, loc);
+            }
+        }
+        catch (const UserException& e) {
+            if (BtreeInterface::deletedBucketCode != e.getCode()) {
+                throw;
+            }
+            // The finger bucket was deleted out from under us; descend from the
+            // root like a plain seek would.
+        }
+
+        return head;
+    }
+
     bool BtreeIndexCursor::pointsAt(const BtreeIndexCursor& other) {
         // XXX: do we need this
         if (isEOF()) {
@@ -225,9 +291,12 @@ namespace mongo {
 
         bool found;
 
-        // Why don't we just call seek?  Because we want to pass _savedLoc.
+        // Why don't we just call seek?  Because we want to pass _savedLoc.  Start
+        // from the finger rather than the root: after a yield the key has usually
+        // only moved to a nearby bucket (think multi updates walking a range), so
+        // climbing from where we were is much cheaper than a fresh descent.
         _bucket = _interface->locate(_btreeState,
-                                     _btreeState->head(),
+                                     findFingerStart(_savedKey),
                                      _savedKey,
                                      _keyOffset,
                                      found,
@@ -274,7 +343,17 @@ namespace mongo {
 
     // Move to the next/prev. key.  Used by normal getNext and also skipping unused keys.
     void BtreeIndexCursor::advance(const char* caller) {
+        const DiskLoc oldBucket = _bucket;
         _bucket = _interface->advance(_btreeState, _bucket, _keyOffset, _direction, caller);
+        if (!_bucket.isNull() && _bucket != oldBucket) {
+            // We crossed into a new bucket; hint the read-ahead machinery so the
+            // buckets after this one (and the records their keys point at) fault
+            // in off-thread while we work through this bucket.
+            prefetchIndexBuckets(_btreeState->descriptor()->parentNS(),
+                                 _btreeState->descriptor()->indexName(),
+                                 _bucket,
+                                 _direction);
+        }
     }
 
 }  // namespace mongo
@@ -66,6 +66,19 @@ namespace mongo {
          */
         void seek(const BSONObj& position, bool afterKey);
 
+        /**
+         * Finger search: seek to 'position' starting from the cursor's
+         * current location rather than the root.  Climbs from the current
+         * bucket only as far as needed before descending again, so bursts of
+         * nearby-key lookups cost a couple of bucket touches instead of a
+         * full root-to-leaf descent each.  Lands exactly where
+         * seek(position) would; falls back to a root descent when the cursor
+         * is at EOF, its bucket was deleted, or 'position' is far away.
+         *
+         * Btree-specific.
+         */
+        Status seekTowards(const BSONObj& position);
+
         Status skip(const BSONObj &keyBegin, int keyBeginLen, bool afterKey,
                     const vector<const BSONElement*>& keyEnd,
                     const vector<bool>& keyEndInclusive);
@@ -102,6 +115,11 @@ namespace mongo {
 
         bool isSavedPositionValid();
 
+        // Climb from the current bucket to the closest ancestor whose keys bracket
+        // 'position', i.e. the smallest subtree a descent for it can start from.
+        // Returns the head bucket if there is no usable finger.
+        DiskLoc findFingerStart(const BSONObj& position) const;
+
         // Move to the next/prev. key.  Used by normal getNext and also skipping unused keys.
         void advance(const char* caller);
 
@@ -66,6 +66,20 @@ namespace mongo {
                                                                       toplevel);
         }
 
+        virtual int bt_insert_batch(IndexCatalogEntry* btreeState,
+                                    const DiskLoc thisLoc,
+                                    const DiskLoc recordLoc,
+                                    const vector<BSONObj>& keys,
+                                    bool dupsallowed,
+                                    size_t* cursor) {
+            return getBucket( btreeState, thisLoc )->bt_insert_batch(btreeState,
+                                                                     thisLoc,
+                                                                     recordLoc,
+                                                                     keys,
+                                                                     dupsallowed,
+                                                                     cursor);
+        }
+
         virtual bool unindex(IndexCatalogEntry* btreeState,
                              const DiskLoc thisLoc,
                              const BSONObj& key,
@@ -196,6 +210,18 @@ namespace mongo {
             }
         }
 
+        virtual DiskLoc parentAt(const IndexCatalogEntry* btreeState,
+                                 DiskLoc bucket) const {
+            verify(!bucket.isNull());
+            const BtreeBucket<Version> *b = getBucket(btreeState,bucket);
+            if (b->getN() == b->INVALID_N_SENTINEL) {
+                // A deallocated bucket's parent field is meaningless (BtreeBuilder
+                // even reuses it as a list link), so don't hand it out.
+                throw UserException(deletedBucketCode, "parentAt bucket deleted");
+            }
+            return b->getParent();
+        }
+
         virtual string dupKeyError(const IndexCatalogEntry* btreeState,
                                    DiskLoc bucket,
                                    const BSONObj& keyObj) const {
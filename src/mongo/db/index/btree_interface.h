@@ -58,6 +58,13 @@ namespace mongo {
                               bool dupsallowed,
                               bool toplevel = true) = 0;
 
+        virtual int bt_insert_batch(IndexCatalogEntry* btreeState,
+                                    const DiskLoc thisLoc,
+                                    const DiskLoc recordLoc,
+                                    const vector<BSONObj>& keys,
+                                    bool dupsallowed,
+                                    size_t* cursor) = 0;
+
         virtual bool unindex(IndexCatalogEntry* btreeState,
                              const DiskLoc thisLoc,
                              const BSONObj& key,
@@ -147,6 +154,15 @@ namespace mongo {
         virtual void keyAndRecordAt(const IndexCatalogEntry* btreeState,
                                     DiskLoc bucket, int keyOffset, BSONObj* keyOut,
                                     DiskLoc* recordOut) const = 0;
+
+        /**
+         * Get the location of bucket's parent, which isNull() for the head
+         * bucket.  Lets a cursor climb the tree instead of re-descending from
+         * the root.  Throws deletedBucketCode if 'bucket' was deleted (a
+         * deleted bucket's parent link is not maintained).
+         */
+        virtual DiskLoc parentAt(const IndexCatalogEntry* btreeState,
+                                 DiskLoc bucket) const = 0;
     };
 
 }  // namespace mongo
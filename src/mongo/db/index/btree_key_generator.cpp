@@ -26,6 +26,8 @@
 *    it in the license file.
 */
 
+#include <cstring>
+
 #include "mongo/db/index/btree_key_generator.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -34,6 +36,8 @@ namespace mongo {
     // Used in scanandorder.cpp to inforatively error when we try to sort keys with parallel arrays.
     const int BtreeKeyGenerator::ParallelArraysCode = 10088;
 
+    const size_t BtreeKeyGenerator::kMaxFastFields;
+
     BtreeKeyGenerator::BtreeKeyGenerator(vector<const char*> fieldNames, vector<BSONElement> fixed, 
                                          bool isSparse)
         : _fieldNames(fieldNames), _isSparse(isSparse), _fixed(fixed) {
@@ -48,9 +52,27 @@ namespace mongo {
         nullEltBuilder.appendNull("");
         _nullObj = nullEltBuilder.obj();
         _nullElt = _nullObj.firstElement();
+
+        // The V0 and V1 implementations only diverge when arrays, dotted paths or
+        // pre-fixed elements are involved, so one fast path serves both versions.
+        _fastPathEligible = !fieldNames.empty() && fieldNames.size() <= kMaxFastFields;
+        for (size_t i = 0; i < fieldNames.size() && _fastPathEligible; ++i) {
+            if (*fieldNames[i] == '\0' || strchr(fieldNames[i], '.')) {
+                _fastPathEligible = false;
+            }
+        }
+        for (size_t i = 0; i < fixed.size() && _fastPathEligible; ++i) {
+            if (!fixed[i].eoo()) {
+                _fastPathEligible = false;
+            }
+        }
     }
 
     void BtreeKeyGenerator::getKeys(const BSONObj &obj, BSONObjSet *keys) const {
+        if (getKeysFast(obj, keys)) {
+            return;
+        }
+
         // These are mutated as part of the getKeys call.  :|
         vector<const char*> fieldNames(_fieldNames);
         vector<BSONElement> fixed(_fixed);
@@ -60,6 +82,53 @@ namespace mongo {
         }
     }
 
+    bool BtreeKeyGenerator::getKeysFast(const BSONObj &obj, BSONObjSet *keys) const {
+        if (!_fastPathEligible) {
+            return false;
+        }
+
+        const size_t numFields = _fieldNames.size();
+        BSONElement found[kMaxFastFields];
+
+        // One pass over the document's top level, matching elements to pattern
+        // fields by name.  Only the first occurrence of a repeated document field
+        // counts, same as getField() in the general implementations.
+        size_t remaining = numFields;
+        BSONObjIterator it(obj);
+        while (remaining > 0 && it.more()) {
+            BSONElement e = it.next();
+            const char* name = e.fieldName();
+            for (size_t i = 0; i < numFields; ++i) {
+                if (found[i].eoo() && strcmp(name, _fieldNames[i]) == 0) {
+                    if (e.type() == Array) {
+                        // Multikey -- only the general path knows how to expand
+                        // arrays (and reject parallel ones).
+                        return false;
+                    }
+                    found[i] = e;
+                    --remaining;
+                }
+            }
+        }
+
+        if (_isSparse && remaining == numFields) {
+            // No indexed fields present; a sparse index skips the document.
+            return true;
+        }
+
+        BSONObjBuilder b(_sizeTracker);
+        for (size_t i = 0; i < numFields; ++i) {
+            if (found[i].eoo()) {
+                b.appendNull("");
+            }
+            else {
+                b.appendAs(found[i], "");
+            }
+        }
+        keys->insert(b.obj());
+        return true;
+    }
+
     static void assertParallelArrays( const char *first, const char *second ) {
         stringstream ss;
         ss << "cannot index parallel arrays [" << first << "] [" << second << "]";
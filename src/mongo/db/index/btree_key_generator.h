@@ -56,9 +56,25 @@ namespace mongo {
         BSONElement _nullElt; // jstNull
         BSONSizeTracker _sizeTracker;
     private:
+        // Most indexes are over plain top-level field names -- no dotted paths and,
+        // for most documents, no arrays.  For those we can build the one key in a
+        // single pass over the document, skipping the vector copies and recursion
+        // the general implementations need.  Eligibility of the key pattern is
+        // decided once, at construction.
+        static const size_t kMaxFastFields = 8;
+
+        /**
+         * Attempts to generate keys for 'obj' without going through getKeysImpl.
+         * Returns true if it produced the (possibly empty, if sparse) key set,
+         * false if 'obj' or the pattern needs the general path.
+         */
+        bool getKeysFast(const BSONObj &obj, BSONObjSet *keys) const;
+
         // We have V0 and V1.  Sigh.
         virtual void getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
                                  const BSONObj &obj, BSONObjSet *keys) const = 0;
+
+        bool _fastPathEligible;
         vector<BSONElement> _fixed;
     };
 
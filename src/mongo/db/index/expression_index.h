@@ -47,6 +47,21 @@ namespace mongo {
             return bob.obj();
         }
 
+        /**
+         * As above, but hashes with the seed and hashVersion of the index
+         * described by 'indexInfoObj' so bounds match what the index actually
+         * stores.  Falls back to the defaults (seed 0, version 0 / MD5) for
+         * fields absent from the spec.
+         */
+        static BSONObj hash(const BSONElement& value, const BSONObj& indexInfoObj) {
+            HashSeed seed = indexInfoObj["seed"].eoo() ?
+                BSONElementHasher::DEFAULT_HASH_SEED : indexInfoObj["seed"].numberInt();
+            int hashVersion = indexInfoObj["hashVersion"].numberInt();
+            BSONObjBuilder bob;
+            bob.append("", BSONElementHasher::hash64(value, seed, hashVersion));
+            return bob.obj();
+        }
+
         // TODO: what should we really pass in for indexInfoObj?
         static void cover2dsphere(const S2Region& region,
                                   const BSONObj& indexInfoObj,
@@ -314,6 +314,21 @@ namespace mongo {
                                             int hashVersion,
                                             bool isSparse,
                                             BSONObjSet* keys) {
+        BSONObj nullObj = BSON("" << BSONNULL);
+        BSONObj missingKey = BSON("" << makeSingleHashKey(nullObj.firstElement(),
+                                                          seed,
+                                                          hashVersion));
+        getHashKeys(obj, hashedField, seed, hashVersion, isSparse, missingKey, keys);
+    }
+
+    // static
+    void ExpressionKeysPrivate::getHashKeys(const BSONObj& obj,
+                                            const string& hashedField,
+                                            HashSeed seed,
+                                            int hashVersion,
+                                            bool isSparse,
+                                            const BSONObj& missingKey,
+                                            BSONObjSet* keys) {
 
         const char* cstr = hashedField.c_str();
         BSONElement fieldVal = obj.getFieldDottedOrArray(cstr);
@@ -325,8 +340,7 @@ namespace mongo {
             keys->insert(key);
         }
         else if (!isSparse) {
-            BSONObj nullObj = BSON("" << BSONNULL);
-            keys->insert(BSON("" << makeSingleHashKey(nullObj.firstElement(), seed, hashVersion)));
+            keys->insert(missingKey);
         }
     }
 
@@ -334,8 +348,10 @@ namespace mongo {
     long long int ExpressionKeysPrivate::makeSingleHashKey(const BSONElement& e,
                                                            HashSeed seed,
                                                            int v) {
-        massert(16767, "Only HashVersion 0 has been defined" , v == 0 );
-        return BSONElementHasher::hash64(e, seed);
+        massert(16767, "Only HashVersions 0 and 1 have been defined",
+                v == BSONElementHasher::HASH_VERSION_MD5 ||
+                v == BSONElementHasher::HASH_VERSION_SIPHASH );
+        return BSONElementHasher::hash64(e, seed, v);
     }
 
     // static
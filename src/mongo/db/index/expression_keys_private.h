@@ -82,6 +82,19 @@ namespace mongo {
                                 bool isSparse,
                                 BSONObjSet* keys);
 
+        /**
+         * As above, but takes the key to emit when the hashed field is missing
+         * so callers that generate keys for many documents (HashAccessMethod)
+         * don't re-hash null per document.
+         */
+        static void getHashKeys(const BSONObj& obj,
+                                const std::string& hashedField,
+                                HashSeed seed,
+                                int hashVersion,
+                                bool isSparse,
+                                const BSONObj& missingKey,
+                                BSONObjSet* keys);
+
         /**
          * Hashing function used by both getHashKeys and the cursors we create.
          * Exposed for testing in dbtests/namespacetests.cpp and
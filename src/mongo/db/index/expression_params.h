@@ -92,6 +92,10 @@ namespace mongo {
             // accordingly.  Defaults to 0 if "hashVersion" is not included in the index spec or if
             // the value of "hashversion" is not a number
             *versionOut = infoObj["hashVersion"].numberInt();
+            uassert(17448,
+                    "unsupported hashVersion, only 0 (md5) and 1 (siphash) are defined",
+                    *versionOut == BSONElementHasher::HASH_VERSION_MD5 ||
+                    *versionOut == BSONElementHasher::HASH_VERSION_SIPHASH);
 
             // Get the hashfield name
             BSONElement firstElt = infoObj.getObjectField("key").firstElement();
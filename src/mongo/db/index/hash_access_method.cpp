@@ -50,10 +50,26 @@ namespace mongo {
                                           &_seed,
                                           &_hashVersion,
                                           &_hashedField);
+
+        BSONObj nullObj = BSON("" << BSONNULL);
+        _missingKey = BSON("" << ExpressionKeysPrivate::makeSingleHashKey(nullObj.firstElement(),
+                                                                          _seed,
+                                                                          _hashVersion));
     }
 
     void HashAccessMethod::getKeys(const BSONObj& obj, BSONObjSet* keys) {
-        ExpressionKeysPrivate::getHashKeys(obj, _hashedField, _seed, _hashVersion, _descriptor->isSparse(), keys);
+        ExpressionKeysPrivate::getHashKeys(obj, _hashedField, _seed, _hashVersion,
+                                           _descriptor->isSparse(), _missingKey, keys);
+    }
+
+    void HashAccessMethod::getKeysBulk(const std::vector<BSONObj>& objs,
+                                       std::vector<BSONObjSet>* keysOut) {
+        const bool isSparse = _descriptor->isSparse();
+        keysOut->resize(objs.size());
+        for (size_t i = 0; i < objs.size(); i++) {
+            ExpressionKeysPrivate::getHashKeys(objs[i], _hashedField, _seed, _hashVersion,
+                                               isSparse, _missingKey, &(*keysOut)[i]);
+        }
     }
 
 }  // namespace mongo
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "mongo/base/status.h"
 #include "mongo/db/hasher.h"  // For HashSeed.
@@ -56,6 +57,11 @@ namespace mongo {
     private:
         virtual void getKeys(const BSONObj& obj, BSONObjSet* keys);
 
+        // Batch entry point used by the bulk builder; hoists the per-document
+        // setup (sparseness lookup, missing-field key) out of the loop.
+        virtual void getKeysBulk(const std::vector<BSONObj>& objs,
+                                 std::vector<BSONObjSet>* keysOut);
+
         // Only one of our fields is hashed.  This is the field name for it.
         string _hashedField;
 
@@ -65,6 +71,8 @@ namespace mongo {
         // _hashVersion defaults to zero.
         int _hashVersion;
 
+        // The key emitted for documents missing the hashed field (the hash of
+        // null); computed once here rather than per document.
         BSONObj _missingKey;
     };
 
@@ -35,6 +35,7 @@
 
 namespace mongo {
 
+    class IndexCountSketch;
     class UpdateTicket;
     struct InsertDeleteOptions;
 
@@ -110,6 +111,13 @@ namespace mongo {
          */
         virtual Status newCursor(IndexCursor **out) const = 0;
 
+        /**
+         * Access methods that maintain a sketch of their keys for approximate
+         * counting return it here, priming it on first use.  Others return
+         * NULL, as does an index that is still being built.
+         */
+        virtual const IndexCountSketch* getCountSketch() { return NULL; }
+
         // ------ index level operations ------
 
 
@@ -169,6 +177,27 @@ namespace mongo {
         virtual Status commitBulk( IndexAccessMethod* bulk,
                                    bool mayInterrupt,
                                    std::set<DiskLoc>* dups ) = 0;
+
+        /**
+         * Only on the IndexAccessMethod returned by initiateBulk, before the
+         * first insert: makes the build resumable after a crash.  Sorted runs
+         * are written under 'runDir' (which must survive a restart) and
+         * 'state' - a document written by an earlier saveBulkCheckpoint, or
+         * empty for a fresh build - is adopted.  Returns false when this
+         * access method or configuration cannot checkpoint, or when 'state'
+         * is unusable; the caller then runs a normal, non-resumable build.
+         */
+        virtual bool prepareResumableBulk( const std::string& runDir,
+                                           const BSONObj& state ) = 0;
+
+        /**
+         * Only after a successful prepareResumableBulk: flushes buffered keys
+         * to a crash-safe sorted run and appends this build's progress (run
+         * files, record and key counts) to 'state'.  The caller persists the
+         * document along with the scan position.  Returns false on failure;
+         * the build continues, it just is no longer resumable.
+         */
+        virtual bool saveBulkCheckpoint( BSONObjBuilder* state ) = 0;
     };
 
     /**
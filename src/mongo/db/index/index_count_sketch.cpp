@@ -0,0 +1,78 @@
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/index/index_count_sketch.h"
+
+#include <cstring>
+
+#include "mongo/db/hasher.h"
+
+namespace mongo {
+
+    IndexCountSketch::IndexCountSketch() {
+        reset();
+    }
+
+    void IndexCountSketch::reset() {
+        _primed = false;
+        _totalKeys = 0;
+        memset( _buckets, 0, sizeof( _buckets ) );
+    }
+
+    int IndexCountSketch::_bucketFor( const BSONObj& key ) {
+        long long h = 0;
+        BSONObjIterator it( key );
+        while ( it.more() ) {
+            // same canonical-type squashing as hashed indexes, so the query
+            // side doesn't have to reproduce the stored key's numeric type
+            h = h * 31 + BSONElementHasher::hash64( it.next(),
+                                                    BSONElementHasher::DEFAULT_HASH_SEED,
+                                                    BSONElementHasher::HASH_VERSION_SIPHASH );
+        }
+        return static_cast<int>( static_cast<unsigned long long>( h ) & ( kBuckets - 1 ) );
+    }
+
+    void IndexCountSketch::noteInsert( const BSONObj& key ) {
+        _buckets[_bucketFor( key )]++;
+        _totalKeys++;
+    }
+
+    void IndexCountSketch::noteRemove( const BSONObj& key ) {
+        long long& b = _buckets[_bucketFor( key )];
+        // clamp defensively; the mutation path can drift on rare error paths
+        if ( b > 0 )
+            b--;
+        if ( _totalKeys > 0 )
+            _totalKeys--;
+    }
+
+    long long IndexCountSketch::estimateEq( const BSONObj& key ) const {
+        return _buckets[_bucketFor( key )];
+    }
+
+}  // namespace mongo
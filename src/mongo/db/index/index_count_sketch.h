@@ -0,0 +1,97 @@
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * A small fixed-size sketch of the keys in one index, used to answer
+     * approximate equality counts without scanning the index.
+     *
+     * The sketch is a hashed histogram: every key is hashed into one of
+     * kBuckets counters.  The hash squashes numeric types the same way the
+     * hashed index code does, so the key for {a: 1} and a query for
+     * {a: 1.0} land in the same bucket.  An equality estimate is the value
+     * of the matching bucket; since other keys can only add to a bucket,
+     * never subtract from it, the estimate is an upper bound on the true
+     * count and overshoots by totalKeys()/kBuckets in expectation.
+     *
+     * The sketch starts cold and is primed by a single walk of the index
+     * the first time an approximate count asks for it; after that the index
+     * mutation path keeps it current with noteInsert()/noteRemove().  The
+     * sketch counts index *keys*, so it only describes document counts for
+     * non-multikey indexes.
+     *
+     * Not thread safe; callers rely on the same locking that protects the
+     * index itself (mutators hold the database write lock, readers at least
+     * a read lock).
+     */
+    class IndexCountSketch {
+        MONGO_DISALLOW_COPYING( IndexCountSketch );
+    public:
+        static const int kBuckets = 4096;
+
+        IndexCountSketch();
+
+        /**
+         * true once a full index walk has populated the sketch; estimates
+         * from an unprimed sketch are meaningless
+         */
+        bool isPrimed() const { return _primed; }
+        void notePrimed() { _primed = true; }
+
+        /** zeroes all counters and marks the sketch unprimed */
+        void reset();
+
+        void noteInsert( const BSONObj& key );
+        void noteRemove( const BSONObj& key );
+
+        long long totalKeys() const { return _totalKeys; }
+
+        /**
+         * upper bound on the number of index entries equal to 'key', where
+         * 'key' is in index-key form (empty field names)
+         */
+        long long estimateEq( const BSONObj& key ) const;
+
+        /** expected overcount of estimateEq() due to hash collisions */
+        long long expectedError() const { return _totalKeys / kBuckets; }
+
+    private:
+        static int _bucketFor( const BSONObj& key );
+
+        bool _primed;
+        long long _totalKeys;
+        long long _buckets[kBuckets];
+    };
+
+}  // namespace mongo
@@ -35,6 +35,7 @@
 #include "mongo/db/pdfile.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_build_checkpoint.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
@@ -65,6 +66,11 @@ namespace mongo {
                 db->namespaceIndex().getNamespaces(collNames, /* onlyCollections */ true);
             }
             checkNS(collNames);
+
+            // Builds that could resume have consumed their checkpoints by
+            // now; whatever is left belongs to unfinished indexes that no
+            // longer exist.
+            IndexBuildCheckpoint::discardAll();
         }
         catch (const DBException&) {
             warning() << "index rebuilding did not complete" << endl;
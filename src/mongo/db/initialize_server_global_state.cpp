@@ -44,6 +44,8 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/security_key.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/logger/async_appender.h"
 #include "mongo/logger/logger.h"
 #include "mongo/logger/console_appender.h"
 #include "mongo/logger/message_event.h"
@@ -186,6 +188,24 @@ namespace mongo {
             _exit(EXIT_FAILURE);
     }
 
+    // When true, the global log domain's appender is wrapped in an
+    // AsyncAppender: encoding and the write syscall move to a dedicated
+    // writer thread, so heavily logging request threads only pay for a
+    // queue insertion.  Off by default because messages queued but not yet
+    // written are lost if the process aborts, which matters when reading
+    // the log tail after a crash.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(logAsync, bool, false);
+
+    namespace {
+        logger::MessageLogDomain::AppenderAutoPtr maybeMakeAsync(
+                logger::MessageLogDomain::AppenderAutoPtr appender) {
+            if (logAsync) {
+                appender.reset(new logger::AsyncAppender(appender.release()));
+            }
+            return appender;
+        }
+    }  // namespace
+
     MONGO_INITIALIZER_GENERAL(ServerLogRedirection,
                               ("GlobalLogManager", "EndStartupOptionHandling", "ForkServer"),
                               ("default"))(
@@ -214,9 +234,9 @@ namespace mongo {
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
             manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
+                    maybeMakeAsync(MessageLogDomain::AppenderAutoPtr(
                             new SyslogAppender<MessageEventEphemeral>(
-                                    new logger::MessageEventWithContextEncoder)));
+                                    new logger::MessageEventWithContextEncoder))));
             manager->getNamedDomain("javascriptOutput")->attachAppender(
                     MessageLogDomain::AppenderAutoPtr(
                             new SyslogAppender<MessageEventEphemeral>(
@@ -272,9 +292,9 @@ namespace mongo {
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
             manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
+                    maybeMakeAsync(MessageLogDomain::AppenderAutoPtr(
                             new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
+                                    new MessageEventDetailsEncoder, writer.getValue()))));
             manager->getNamedDomain("javascriptOutput")->attachAppender(
                     MessageLogDomain::AppenderAutoPtr(
                             new RotatableFileAppender<MessageEventEphemeral>(
@@ -289,6 +309,16 @@ namespace mongo {
             }
         }
         else {
+            if (logAsync) {
+                // Replace the console appender installed by the LogManager
+                // constructor with an asynchronous one.
+                LogManager* manager = logger::globalLogManager();
+                manager->getGlobalDomain()->clearAppenders();
+                manager->getGlobalDomain()->attachAppender(
+                        maybeMakeAsync(MessageLogDomain::AppenderAutoPtr(
+                                new logger::ConsoleAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder))));
+            }
             logger::globalLogManager()->getNamedDomain("javascriptOutput")->attachAppender(
                     MessageLogDomain::AppenderAutoPtr(
                             new logger::ConsoleAppender<MessageEventEphemeral>(
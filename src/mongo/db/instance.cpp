@@ -41,17 +41,20 @@
 
 #include "mongo/base/status.h"
 #include "mongo/bson/util/atomic_int.h"
+#include "mongo/db/admission_control.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/background.h"
+#include "mongo/db/catalog/capped_insert_notifier.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/db/health_fast_lane.h"
 #include "mongo/db/dur_commitjob.h"
 #include "mongo/db/dur_journal.h"
 #include "mongo/db/dur_recover.h"
@@ -354,6 +357,10 @@ namespace mongo {
             if( strstr(ns, ".$cmd") ) {
                 isCommand = true;
                 opwrite(m);
+                // bare isMaster/ping heartbeats answer from a cached reply so
+                // health checks stay cheap while the node is saturated
+                if ( HealthFastLane::global.handle( m, dbresponse ) )
+                    return;
                 if( strstr(ns, ".$cmd.sys.") ) {
                     if( strstr(ns, "$cmd.sys.inprog") ) {
                         inProgCmd(m, dbresponse);
@@ -416,6 +423,16 @@ namespace mongo {
             c.newTopLevelRequest();
         }
 
+        // Admission control: gate plain reads and writes before they start
+        // acquiring locks.  Commands, nested operations (DBDirectClient
+        // running inside another op) and god/internal clients are never
+        // gated.  The ticket, if one was issued, is held for the whole
+        // operation.
+        AdmissionController::Ticket admissionTicket;
+        if ( !nestedOp.get() && !c.isGod() ) {
+            admissionController.admit( op, isCommand, &admissionTicket );
+        }
+
         CurOp& currentOp = *currentOpP;
         currentOp.reset(remote,op);
 
@@ -688,6 +705,8 @@ namespace mongo {
         bool exhaust = false;
         QueryResult* msgdata = 0;
         OpTime last;
+        shared_ptr<CappedInsertNotifier> cappedNotifier;
+        unsigned long long cappedInsertCount = 0;
         while( 1 ) {
             bool isCursorAuthorized = false;
             try {
@@ -709,7 +728,8 @@ namespace mongo {
                         last = OpTime::getLast(lk);
                     }
                     else {
-                        last.waitForDifferent(1000/*ms*/);
+                        // parked until logOp signals a newer, durable entry
+                        waitForNewerOplogEntry(last, 1000/*ms*/);
                     }
                 }
 
@@ -750,12 +770,33 @@ namespace mongo {
                     }
                 }
                 pass++;
-                if (debug)
-                    sleepmillis(20);
-                else
-                    sleepmillis(2);
-                
-                // note: the 1100 is beacuse of the waitForDifferent above
+                if (str::startsWith(ns, "local.oplog.")) {
+                    // no polling sleep; waitForNewerOplogEntry above parks us
+                    // until there is something new to return
+                }
+                else if (!cappedNotifier) {
+                    // first empty pass: note the insert count, then scan once
+                    // more before parking.  an insert that raced with the scan
+                    // above bumped the count already, so the wait started after
+                    // the next empty pass returns immediately and nothing is
+                    // missed.
+                    cappedNotifier = CappedInsertNotifier::forNamespace(ns);
+                    cappedInsertCount = cappedNotifier->getCount();
+                }
+                else {
+                    // parked until something is inserted into the capped
+                    // collection or it is dropped (its destructor signals the
+                    // notifier), for the remainder of the ~4s await window.
+                    // an idle tail costs one wakeup per getMore, not one per
+                    // polling interval.
+                    int left = 4000 - timer->millis();
+                    if ( left < 1 )
+                        left = 1;
+                    cappedNotifier->waitForInsert(cappedInsertCount, left);
+                    cappedInsertCount = cappedNotifier->getCount();
+                }
+
+                // note: the 1100 is beacuse of the 1000ms oplog wait above
                 // should eventually clean this up a bit
                 curop.setExpectedLatencyMs( 1100 + timer->millis() );
                 
@@ -884,8 +925,12 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( true ) {
             try {
-                Lock::DBWrite lk(ns);
-                
+                // collection-exclusive when built with
+                // MONGOD_CONCURRENCY_LEVEL_COLLECTION, so inserts into
+                // different collections of one db run in parallel; degrades
+                // to a plain db write lock otherwise
+                Lock::CollectionWrite lk(ns);
+
                 // CONCURRENCY TODO: is being read locked in big log sufficient here?
                 // writelock is used to synchronize stepdowns w/ writes
                 uassert( 10058 , "not master", isMasterNs(ns) );
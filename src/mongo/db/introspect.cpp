@@ -39,8 +39,10 @@
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/util/async_sink.h"
 #include "mongo/util/goodies.h"
 
 namespace {
@@ -49,8 +51,14 @@ namespace {
 
 namespace mongo {
 
+    // If true, profile() hands finished documents to a background writer thread
+    // instead of taking the database lock and inserting on the operation thread.
+    // Readers of system.profile may then lag completed operations by the (normally
+    // tiny) drain latency; set to false for strict read-after-op visibility.
+    MONGO_EXPORT_SERVER_PARAMETER(profileAsyncWrites, bool, true);
+
 namespace {
-    void _appendUserInfo(const Client& c,
+    void _appendUserInfo(const char* ns,
                          BSONObjBuilder& builder,
                          AuthorizationSession* authSession) {
         UserNameIterator nameIter = authSession->getAuthenticatedUserNames();
@@ -59,7 +67,7 @@ namespace {
         if (nameIter.more())
             bestUser = *nameIter;
 
-        StringData opdb( nsToDatabaseSubstring( c.ns() ) );
+        StringData opdb( nsToDatabaseSubstring( ns ) );
 
         BSONArrayBuilder allUsers(builder.subarrayStart("allUsers"));
         for ( ; nameIter.more(); nameIter.next()) {
@@ -79,10 +87,13 @@ namespace {
     }
 } // namespace
 
-    static void _profile(const Client& c, CurOp& currentOp, BufBuilder& profileBufBuilder) {
-        Database *db = c.database();
-        DEV verify( db );
-
+    /**
+     * Builds the profile document for "currentOp" into "profileBufBuilder" and
+     * returns it.  Needs only the operation thread's own state (the Client and
+     * its CurOp), not the database lock.
+     */
+    static BSONObj _buildProfileDocument(const Client& c, CurOp& currentOp,
+                                         BufBuilder& profileBufBuilder) {
         // build object
         BSONObjBuilder b(profileBufBuilder);
 
@@ -93,7 +104,7 @@ namespace {
         b.append("client", c.clientAddress());
 
         AuthorizationSession * authSession = c.getAuthorizationSession();
-        _appendUserInfo(c, b, authSession);
+        _appendUserInfo(currentOp.getNS(), b, authSession);
 
         BSONObj p = b.done();
 
@@ -106,7 +117,7 @@ namespace {
             BSONObjBuilder b(profileBufBuilder);
             b.appendDate("ts", jsTime());
             b.append("client", c.clientAddress() );
-            _appendUserInfo(c, b, authSession);
+            _appendUserInfo(currentOp.getNS(), b, authSession);
 
             b.append("err", "profile line too large (max is 100KB)");
 
@@ -118,6 +129,16 @@ namespace {
             p = b.done();
         }
 
+        return p;
+    }
+
+    /**
+     * Inserts a finished profile document into "db"'s profiling collection.
+     * The caller must hold the database lock and have a Context open on it.
+     */
+    static void _insertProfileDocument(Database* db, const BSONObj& p) {
+        DEV verify( db );
+
         // write: not replicated
         // get or create the profiling collection
         Collection* profileCollection = getOrCreateProfileCollection(db);
@@ -126,16 +147,89 @@ namespace {
         }
     }
 
+namespace {
+
+    const size_t maxQueuedProfileDocs = 128;
+
+    /**
+     * A profile document finished on the operation thread, waiting for the
+     * writer thread to insert it into <db>.system.profile.
+     */
+    struct ProfileEntry {
+        ProfileEntry() {}
+        ProfileEntry(const std::string& ns, const BSONObj& doc) : ns(ns), doc(doc) {}
+
+        std::string ns; // namespace of the profiled operation
+        BSONObj doc;    // owned profile document
+    };
+
+    /**
+     * Drains queued profile documents into their profiling collections, taking
+     * the per-insert database lock on its own thread rather than the operation
+     * thread's.
+     */
+    class ProfileWriter : public AsyncSink<ProfileEntry> {
+    public:
+        ProfileWriter() : AsyncSink<ProfileEntry>("profile writer", maxQueuedProfileDocs) {}
+
+    protected:
+        virtual void onDrainerThreadStart() {
+            Client::initThread("profileWriter");
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+        }
+
+        virtual void consume(const ProfileEntry& entry) {
+            try {
+                Lock::DBWrite lk( entry.ns );
+                if (dbHolder()._isLoaded(nsToDatabase(entry.ns), storageGlobalParams.dbpath)) {
+                    Client::Context cx(entry.ns, storageGlobalParams.dbpath);
+                    _insertProfileDocument(cx.db(), entry.doc);
+                }
+                else {
+                    mongo::log() << "note: not profiling because db went away - probably a close on: "
+                                 << entry.ns << endl;
+                }
+            }
+            catch (const AssertionException& assertionEx) {
+                warning() << "Caught Assertion while trying to profile against "
+                          << entry.ns << ": " << assertionEx.toString() << endl;
+            }
+        }
+    };
+
+    // Set once by startProfileWriter() during startup, read-only thereafter.
+    // Leaked so profiling works until the very end of shutdown.
+    ProfileWriter* profileWriter = NULL;
+
+} // namespace
+
+    void startProfileWriter() {
+        if ( !profileWriter ) {
+            profileWriter = new ProfileWriter();
+            profileWriter->start();
+        }
+    }
+
     void profile(const Client& c, int op, CurOp& currentOp) {
         // initialize with 1kb to start, to avoid realloc later
         // doing this outside the dblock to improve performance
         BufBuilder profileBufBuilder(1024);
 
+        BSONObj p = _buildProfileDocument(c, currentOp, profileBufBuilder);
+
+        if (profileAsyncWrites && profileWriter) {
+            // getOwned() copies the document out of profileBufBuilder; the
+            // operation thread pays only for that copy and the enqueue, and the
+            // writer thread takes the database lock.
+            profileWriter->push(ProfileEntry(currentOp.getNS(), p.getOwned()));
+            return;
+        }
+
         try {
             Lock::DBWrite lk( currentOp.getNS() );
             if (dbHolder()._isLoaded(nsToDatabase(currentOp.getNS()), storageGlobalParams.dbpath)) {
                 Client::Context cx(currentOp.getNS(), storageGlobalParams.dbpath);
-                _profile(c, currentOp, profileBufBuilder);
+                _insertProfileDocument(cx.db(), p);
             }
             else {
                 mongo::log() << "note: not profiling because db went away - probably a close on: "
@@ -47,6 +47,14 @@ namespace mongo {
 
     void profile(const Client& c, int op, CurOp& currentOp);
 
+    /**
+     * Spawns the background thread that performs profile document inserts when
+     * the profileAsyncWrites server parameter is enabled.  Call once during
+     * startup; until then (and in processes that never call it) profile()
+     * inserts synchronously on the operation thread.
+     */
+    void startProfileWriter();
+
     /**
      * Get (or create) the profile collection
      *
@@ -21,6 +21,7 @@
 
 #include "mongo/db/jsobj.h"
 
+#include <algorithm>
 #include <limits>
 #include <cmath>
 
@@ -56,6 +57,91 @@ namespace mongo {
 
     BSONElement eooElement;
 
+    /* shared marker for "object has too few fields to be worth indexing" */
+    BSONFieldIndex BSONFieldIndex::_declined;
+
+    namespace {
+        /* below this many top level fields a linear scan wins over building
+           and searching the index */
+        const size_t minIndexedFields = 8;
+
+        /* a document must be walked this many times before the index is built */
+        const unsigned fieldScansBeforeIndex = 2;
+    }
+
+    unsigned BSONFieldIndex::hashName( const StringData& name ) {
+        // FNV-1a
+        unsigned h = 2166136261u;
+        for ( size_t i = 0; i < name.size(); i++ ) {
+            h ^= static_cast<unsigned char>( name[i] );
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    BSONFieldIndex* BSONFieldIndex::make( const char* objdata ) {
+        BSONObj obj( objdata );
+        std::vector<Entry> entries;
+        BSONObjIterator i( obj );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            Entry entry;
+            entry.hash = hashName( e.fieldName() );
+            entry.offset = static_cast<int>( e.rawdata() - objdata );
+            entries.push_back( entry );
+        }
+
+        if ( entries.size() < minIndexedFields )
+            return &_declined;
+
+        BSONFieldIndex* idx = new BSONFieldIndex();
+        idx->_entries.swap( entries );
+        std::sort( idx->_entries.begin(), idx->_entries.end() );
+        return idx;
+    }
+
+    int BSONFieldIndex::find( const char* objdata, const StringData& name ) const {
+        const unsigned h = hashName( name );
+
+        // find the first entry with hash h
+        size_t lo = 0;
+        size_t hi = _entries.size();
+        while ( lo < hi ) {
+            const size_t mid = ( lo + hi ) / 2;
+            if ( _entries[mid].hash < h )
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        // entries with equal hashes are ordered by offset, so the first name
+        // match is the first occurrence in the document
+        for ( ; lo < _entries.size() && _entries[lo].hash == h; lo++ ) {
+            const char* fieldName = objdata + _entries[lo].offset + 1; // +1 skips the type byte
+            if ( name == fieldName )
+                return _entries[lo].offset;
+        }
+        return -1;
+    }
+
+    const BSONFieldIndex* BSONObj::Holder::fieldIndexForScan( const char* objdata ) {
+        BSONFieldIndex* idx = fieldIndex.load();
+        if ( idx )
+            return idx;
+
+        if ( ++fieldScans < fieldScansBeforeIndex )
+            return NULL;
+
+        idx = BSONFieldIndex::make( objdata );
+        BSONFieldIndex* const prev = fieldIndex.compareAndSwap( NULL, idx );
+        if ( prev ) {
+            // another thread won the race to build it
+            BSONFieldIndex::destroy( idx );
+            return prev;
+        }
+        return idx;
+    }
+
     GENOIDLabeler GENOID;
 
     DateNowLabeler DATENOW;
@@ -498,14 +584,11 @@ namespace mongo {
         return validateBSON( objdata(), objsize() ).isOK();
     }
 
-    int BSONObj::woCompare(const BSONObj& r, const Ordering &o, bool considerFieldName) const {
-        if ( isEmpty() )
-            return r.isEmpty() ? 0 : -1;
-        if ( r.isEmpty() )
-            return 1;
-
-        BSONObjIterator i(*this);
-        BSONObjIterator j(r);
+    // anyDescending=false is the common case and drops the per-field
+    // direction test and mask bookkeeping from the loop
+    template< bool anyDescending >
+    static int woCompareOrdered( BSONObjIterator& i, BSONObjIterator& j,
+                                 const Ordering &o, bool considerFieldName ) {
         unsigned mask = 1;
         while ( 1 ) {
             // so far, equal...
@@ -520,16 +603,31 @@ namespace mongo {
             int x;
             {
                 x = l.woCompare( r, considerFieldName );
-                if( o.descending(mask) )
+                if( anyDescending && o.descending(mask) )
                     x = -x;
             }
             if ( x != 0 )
                 return x;
-            mask <<= 1;
+            if ( anyDescending )
+                mask <<= 1;
         }
         return -1;
     }
 
+    int BSONObj::woCompare(const BSONObj& r, const Ordering &o, bool considerFieldName) const {
+        if ( isEmpty() )
+            return r.isEmpty() ? 0 : -1;
+        if ( r.isEmpty() )
+            return 1;
+
+        BSONObjIterator i(*this);
+        BSONObjIterator j(r);
+        // dispatch once on the precomputed direction bits
+        if ( o.allAscending() )
+            return woCompareOrdered<false>( i, j, o, considerFieldName );
+        return woCompareOrdered<true>( i, j, o, considerFieldName );
+    }
+
     /* well ordered compare */
     int BSONObj::woCompare(const BSONObj &r, const BSONObj &idxKey,
                            bool considerFieldName) const {
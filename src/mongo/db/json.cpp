@@ -1073,7 +1073,18 @@ namespace mongo {
                 ++q;
             }
             else {
-                result->push_back(*q++);
+                // Append the whole run of ordinary characters in one shot
+                // rather than a byte at a time; escapes, control characters and
+                // terminals are rare.
+                const char* runStart = q;
+                do {
+                    q++;
+                } while (q < _input_end &&
+                         *q != '\\' &&
+                         !(0x00 <= *q && *q <= 0x1F) &&
+                         !match(*q, terminalSet) &&
+                         (allowedSet == NULL || match(*q, allowedSet)));
+                result->append(runStart, q - runStart);
             }
         }
         if (q < _input_end) {
@@ -47,7 +47,9 @@ namespace mongo {
         BSONObjBuilder a( b.subobjStart( "timeAcquiringMicros" ) );
         _append( a , timeAcquiring );
         a.done();
-        
+
+        _appendHisto( b );
+
         return b.obj();
     }
 
@@ -79,6 +81,44 @@ namespace mongo {
         }
     }
 
+    void LockStat::_appendHisto( BSONObjBuilder& builder ) const {
+        BSONObjBuilder h;
+        for ( int i = 0; i < N; i++ ) {
+            bool any = false;
+            for ( int j = 0; j < NumAcquireBuckets; j++ ) {
+                if ( acquireBuckets[i][j].load() ) {
+                    any = true;
+                    break;
+                }
+            }
+            if ( !any )
+                continue;
+
+            BSONObjBuilder state( h.subobjStart( string( 1, nameFor( i ) ) ) );
+            for ( int j = 0; j < NumAcquireBuckets; j++ ) {
+                long long count = acquireBuckets[i][j].load();
+                if ( !count )
+                    continue;
+                if ( j == NumAcquireBuckets - 1 )
+                    state.append( "inf", count );
+                else
+                    state.append( BSONObjBuilder::numStr( 1 << ( 2 * j ) ), count );
+            }
+            state.done();
+        }
+        BSONObj histo = h.obj();
+        if ( !histo.isEmpty() )
+            builder.append( "acquireWaitHistogramMicros", histo );
+    }
+
+    // bucket b holds waits of at most 4^b micros; the last bucket is unbounded
+    unsigned LockStat::bucketFor( long long micros ) {
+        unsigned b = 0;
+        while ( b < NumAcquireBuckets - 1 && micros > ( 1LL << ( 2 * b ) ) )
+            b++;
+        return b;
+    }
+
     unsigned LockStat::mapNo(char type) {
         switch( type ) { 
         case 'R' : return 0;
@@ -104,6 +144,7 @@ namespace mongo {
 
     void LockStat::recordAcquireTimeMicros( char type , long long micros ) {
         timeAcquiring[mapNo(type)].fetchAndAdd( micros );
+        acquireBuckets[mapNo(type)][bucketFor(micros)].fetchAndAdd( 1 );
     }
     void LockStat::recordLockTimeMicros( char type , long long micros ) {
         timeLocked[mapNo(type)].fetchAndAdd( micros );
@@ -113,6 +154,8 @@ namespace mongo {
         for ( int i = 0; i < N; i++ ) {
             timeAcquiring[i].store(0);
             timeLocked[i].store(0);
+            for ( int j = 0; j < NumAcquireBuckets; j++ )
+                acquireBuckets[i][j].store(0);
         }
     }
 }
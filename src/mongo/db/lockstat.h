@@ -38,9 +38,13 @@ namespace mongo {
 
     class BSONObj;
 
-    class LockStat { 
+    class LockStat {
         enum { N = 4 };
     public:
+        // acquire wait histogram: bucket b counts waits of at most 4^b micros,
+        // the last bucket is unbounded
+        enum { NumAcquireBuckets = 12 };
+
         void recordAcquireTimeMicros( char type , long long micros );
         void recordLockTimeMicros( char type , long long micros );
 
@@ -50,14 +54,23 @@ namespace mongo {
         void report( StringBuilder& builder ) const;
 
         long long getTimeLocked( char type ) const { return timeLocked[mapNo(type)].load(); }
+        long long getTimeAcquiring( char type ) const { return timeAcquiring[mapNo(type)].load(); }
+
+        long long getAcquireBucket( char type, unsigned bucket ) const {
+            return acquireBuckets[mapNo(type)][bucket].load();
+        }
     private:
         static void _append( BSONObjBuilder& builder, const AtomicInt64* data );
-        
+        void _appendHisto( BSONObjBuilder& builder ) const;
+        static unsigned bucketFor( long long micros );
+
         // RWrw
         // in micros
         AtomicInt64 timeAcquiring[N];
         AtomicInt64 timeLocked[N];
 
+        AtomicInt64 acquireBuckets[N][NumAcquireBuckets];
+
         static unsigned mapNo(char type);
         static char nameFor(unsigned offset);
     };
@@ -36,10 +36,21 @@
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/client.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
+    // queued-waiter pressure, maintained by Acquiring/AcquiringParallelWriter
+    // below; this is what the yield arbiter reads.  the counts cover every
+    // ScopedLock acquisition - global and db level alike - which is exactly
+    // the set of waiters the old per-yield client scan used to count.
+    static AtomicWord<int> pendingReaderCount;
+    static AtomicWord<int> pendingWriterCount;
+
+    int pendingLockReaders() { return pendingReaderCount.load(); }
+    int pendingLockWriters() { return pendingWriterCount.load(); }
+
     LockState::LockState() 
         : _batchWriter(false),
           _recursive(0),
@@ -247,10 +258,13 @@ namespace mongo {
     Acquiring::Acquiring( Lock::ScopedLock* lock,  LockState& ls )
         : _lock( lock ), _ls( ls ){
         _ls._lockPending = true;
+        _pendingWrite = lock && ( lock->lockType() == 'w' || lock->lockType() == 'W' );
+        ( _pendingWrite ? pendingWriterCount : pendingReaderCount ).fetchAndAdd( 1 );
     }
 
     Acquiring::~Acquiring() {
         _ls._lockPending = false;
+        ( _pendingWrite ? pendingWriterCount : pendingReaderCount ).fetchAndAdd( -1 );
         LockStat* stat = _ls.getRelevantLockStat();
         if ( stat && _lock ) {
             // increment the global stats for this counter
@@ -261,10 +275,12 @@ namespace mongo {
     AcquiringParallelWriter::AcquiringParallelWriter( LockState& ls )
         : _ls( ls ) {
         _ls._lockPendingParallelWriter = true;
+        pendingWriterCount.fetchAndAdd( 1 );
     }
-    
+
     AcquiringParallelWriter::~AcquiringParallelWriter() {
         _ls._lockPendingParallelWriter = false;
+        pendingWriterCount.fetchAndAdd( -1 );
     }
 
 }
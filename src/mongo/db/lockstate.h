@@ -32,6 +32,7 @@
 #pragma once
 
 #include "mongo/db/d_concurrency.h"
+#include "mongo/util/concurrency/qlock.h"
 
 namespace mongo {
 
@@ -126,25 +127,44 @@ namespace mongo {
     class WrapperForRWLock : boost::noncopyable {
         SimpleRWLock rw;
         SimpleMutex m;
+        QLock q;
         bool sharedLatching;
+        bool intentLatching;
     public:
         string name() const { return rw.name; }
         LockStat stats;
-        WrapperForRWLock(const StringData& name)
-            : rw(name), m(name) {
+        /**
+         * @param supportsIntent if true, back this lock with a QLock so that in addition to
+         *        shared/exclusive we can grab it in intent-write ('w') mode; intent holders are
+         *        compatible with each other but conflict with shared and exclusive holders.
+         *        Used for database locks when collection-level locking is compiled in.
+         */
+        WrapperForRWLock(const StringData& name, bool supportsIntent = false)
+            : rw(name), m(name), intentLatching(supportsIntent) {
             // For the local datbase, all operations are short,
             // either writing one entry, or doing a tail.
             // In tests, use a SimpleMutex is much faster for the local db.
             sharedLatching = name != "local";
         }
-        void lock()          { if ( sharedLatching ) { rw.lock(); } else { m.lock(); } }
-        void lock_shared()   { if ( sharedLatching ) { rw.lock_shared(); } else { m.lock(); } }
-        void unlock()        { if ( sharedLatching ) { rw.unlock(); } else { m.unlock(); } }
-        void unlock_shared() { if ( sharedLatching ) { rw.unlock_shared(); } else { m.unlock(); } }
+        void lock()          { if ( intentLatching ) { q.lock_W(); } else if ( sharedLatching ) { rw.lock(); } else { m.lock(); } }
+        void lock_shared()   { if ( intentLatching ) { q.lock_R(); } else if ( sharedLatching ) { rw.lock_shared(); } else { m.lock(); } }
+        void unlock()        { if ( intentLatching ) { q.unlock_W(); } else if ( sharedLatching ) { rw.unlock(); } else { m.unlock(); } }
+        void unlock_shared() { if ( intentLatching ) { q.unlock_R(); } else if ( sharedLatching ) { rw.unlock_shared(); } else { m.unlock(); } }
+        // intent-write; degenerates to exclusive when intent latching isn't compiled in
+        void lock_intent()   { if ( intentLatching ) { q.lock_w(); } else { lock(); } }
+        void unlock_intent() { if ( intentLatching ) { q.unlock_w(); } else { unlock(); } }
     };
 
     class ScopedLock;
 
+    /** process-wide counts of threads currently inside Acquiring, i.e. blocked
+        (or about to block) getting a lock, split by whether a read or a write
+        lock is wanted.  lock-free to read, so yield points can poll actual
+        queued-waiter pressure every iteration instead of scanning the client
+        list under clientsMutex.  see Client::recommendedYieldMicros(). */
+    int pendingLockReaders();
+    int pendingLockWriters();
+
     class Acquiring {
     public:
         Acquiring( Lock::ScopedLock* lock, LockState& ls );
@@ -152,6 +172,7 @@ namespace mongo {
     private:
         Lock::ScopedLock* _lock;
         LockState& _ls;
+        bool _pendingWrite; // which pending counter we bumped
     };
         
     class AcquiringParallelWriter {
@@ -38,9 +38,32 @@ namespace mongo {
     Status ElementPath::init( const StringData& path ) {
         _shouldTraverseLeafArray = true;
         _fieldRef.parse( path );
+
+        // parse every suffix of the path now, so that iterators descending
+        // into arrays never re-parse per document.  the suffix of a suffix is
+        // a suffix of this path, so the sub-paths share one set of objects.
+        _suffixes.clear();
+        const size_t n = _fieldRef.numParts();
+        for ( size_t i = 1; i < n; i++ ) {
+            boost::shared_ptr<ElementPath> suffix( new ElementPath() );
+            suffix->_shouldTraverseLeafArray = _shouldTraverseLeafArray;
+            suffix->_fieldRef.parse( _fieldRef.dottedField( i ) );
+            _suffixes.push_back( suffix );
+        }
+        for ( size_t i = 0; i < _suffixes.size(); i++ ) {
+            for ( size_t j = i + 1; j < _suffixes.size(); j++ )
+                _suffixes[i]->_suffixes.push_back( _suffixes[j] );
+        }
+
         return Status::OK();
     }
 
+    void ElementPath::setTraverseLeafArray( bool b ) {
+        _shouldTraverseLeafArray = b;
+        for ( size_t i = 0; i < _suffixes.size(); i++ )
+            _suffixes[i]->_shouldTraverseLeafArray = b;
+    }
+
     // -----
 
     ElementIterator::~ElementIterator(){
@@ -87,11 +110,13 @@ namespace mongo {
     // ------
     BSONElementIterator::BSONElementIterator() {
         _path = NULL;
+        _subCursor = NULL;
     }
 
     BSONElementIterator::BSONElementIterator( const ElementPath* path, const BSONObj& context )
         : _path( path ), _context( context ) {
         _state = BEGIN;
+        _subCursor = NULL;
         //log() << "path: " << path.fieldRef().dottedField() << " context: " << context << endl;
     }
 
@@ -104,13 +129,29 @@ namespace mongo {
         _state = BEGIN;
         _next.reset();
 
-        _subCursor.reset();
-        _subCursorPath.reset();
+        // _subIterator stays allocated so the next document reuses it
+        _subCursor = NULL;
+    }
+
+    BSONElementIterator* BSONElementIterator::_startSubIterator( const ElementPath* path,
+                                                                 const BSONObj& context ) {
+        if ( _subIterator )
+            _subIterator->reset( path, context );
+        else
+            _subIterator.reset( new BSONElementIterator( path, context ) );
+        _subCursor = _subIterator.get();
+        return _subCursor;
     }
 
 
+    BSONElementIterator::ArrayIterationState::ArrayIterationState()
+        : startOfRest( 0 ), hasMore( false ), nextPieceOfPathIsNumber( false ),
+          _iterator( BSONObj() ), _iteratorActive( false ) {
+    }
+
     void BSONElementIterator::ArrayIterationState::reset( const FieldRef& ref, int start ) {
-        restOfPath = ref.dottedField( start ).toString();
+        restOfPath = ref.dottedField( start );
+        startOfRest = start;
         hasMore = restOfPath.size() > 0;
         if ( hasMore ) {
             nextPieceOfPath = ref.getPart( start );
@@ -119,6 +160,7 @@ namespace mongo {
         else {
             nextPieceOfPathIsNumber = false;
         }
+        _iteratorActive = false;
     }
 
     bool BSONElementIterator::ArrayIterationState::isArrayOffsetMatch( const StringData& fieldName ) const {
@@ -130,15 +172,16 @@ namespace mongo {
 
     void BSONElementIterator::ArrayIterationState::startIterator( BSONElement e ) {
         _theArray = e;
-        _iterator.reset( new BSONObjIterator( _theArray.Obj() ) );
+        _iterator = BSONObjIterator( _theArray.Obj() );
+        _iteratorActive = true;
     }
 
     bool BSONElementIterator::ArrayIterationState::more() {
-        return _iterator && _iterator->more();
+        return _iteratorActive && _iterator.more();
     }
 
     BSONElement BSONElementIterator::ArrayIterationState::next() {
-        _current = _iterator->next();
+        _current = _iterator.next();
         return _current;
     }
 
@@ -149,7 +192,7 @@ namespace mongo {
             if ( _subCursor->more() )
                 return true;
 
-            _subCursor.reset();
+            _subCursor = NULL;
 
             if ( _arrayIterationState.isArrayOffsetMatch( _arrayIterationState._current.fieldName() ) ) {
                 if ( _arrayIterationState.nextEntireRest() ) {
@@ -158,10 +201,8 @@ namespace mongo {
                     return true;
                 }
 
-                _subCursorPath.reset( new ElementPath() );
-                _subCursorPath->init( _arrayIterationState.restOfPath.substr( _arrayIterationState.nextPieceOfPath.size() + 1 ) );
-                _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
-                _subCursor.reset( new BSONElementIterator( _subCursorPath.get(), _arrayIterationState._current.Obj() ) );
+                _startSubIterator( _path->suffixPath( _arrayIterationState.startOfRest + 1 ),
+                                   _arrayIterationState._current.Obj() );
                 _arrayIterationState._current = BSONElement();
                 return more();
             }
@@ -213,11 +254,8 @@ namespace mongo {
                 // i have deeper to go
 
                 if ( x.type() == Object ) {
-                    _subCursorPath.reset( new ElementPath() );
-                    _subCursorPath->init( _arrayIterationState.restOfPath );
-                    _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
-
-                    _subCursor.reset( new BSONElementIterator( _subCursorPath.get(), x.Obj() ) );
+                    _startSubIterator( _path->suffixPath( _arrayIterationState.startOfRest ),
+                                       x.Obj() );
                     return more();
                 }
 
@@ -230,12 +268,11 @@ namespace mongo {
                     }
 
                     if ( x.isABSONObj() ) {
-                        _subCursorPath.reset( new ElementPath() );
-                        _subCursorPath->init( _arrayIterationState.restOfPath.substr( _arrayIterationState.nextPieceOfPath.size() + 1 ) );
-                        _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
-                        BSONElementIterator* real = new BSONElementIterator( _subCursorPath.get(), _arrayIterationState._current.Obj() );
-                        _subCursor.reset( real );
-                        real->_arrayIterationState.reset( _subCursorPath->fieldRef(), 0 );
+                        const ElementPath* restPath =
+                            _path->suffixPath( _arrayIterationState.startOfRest + 1 );
+                        BSONElementIterator* real =
+                            _startSubIterator( restPath, _arrayIterationState._current.Obj() );
+                        real->_arrayIterationState.reset( restPath->fieldRef(), 0 );
                         real->_arrayIterationState.startIterator( x );
                         real->_state = IN_ARRAY;
                         _arrayIterationState._current = BSONElement();
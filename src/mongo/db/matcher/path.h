@@ -30,7 +30,10 @@
 
 #pragma once
 
+#include <vector>
+
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "mongo/base/status.h"
 #include "mongo/base/string_data.h"
@@ -44,14 +47,31 @@ namespace mongo {
     public:
         Status init( const StringData& path );
 
-        void setTraverseLeafArray( bool b ) { _shouldTraverseLeafArray = b; }
+        void setTraverseLeafArray( bool b );
 
         const FieldRef& fieldRef() const { return _fieldRef; }
         bool shouldTraverseLeafArray() const { return _shouldTraverseLeafArray; }
 
+        /**
+         * The path with its first 'offset' parts stripped ("b.c" for "a.b.c"
+         * at offset 1), parsed once at init() time.  Iterators descending
+         * into arrays use these instead of re-parsing the remaining path for
+         * every document; they stay valid as long as this ElementPath does.
+         * offset 0 returns this path itself.
+         */
+        const ElementPath* suffixPath( size_t offset ) const {
+            if ( offset == 0 )
+                return this;
+            dassert( offset <= _suffixes.size() );
+            return _suffixes[offset - 1].get();
+        }
+
     private:
         FieldRef _fieldRef;
         bool _shouldTraverseLeafArray;
+
+        // [0] holds parts 1..n, [1] holds parts 2..n, ...
+        std::vector< boost::shared_ptr<ElementPath> > _suffixes;
     };
 
     class ElementIterator {
@@ -92,6 +112,11 @@ namespace mongo {
         }
         virtual ~SingleElementElementIterator(){}
 
+        void reset( BSONElement e ) {
+            _seen = false;
+            _element.reset( e, BSONElement(), false );
+        }
+
         virtual bool more() { return !_seen; }
         virtual Context next() { _seen = true; return _element; }
 
@@ -126,6 +151,12 @@ namespace mongo {
         Context next();
 
     private:
+        /**
+         * Points the sub-cursor at 'path' over 'context', reusing the
+         * already-allocated iterator after the first array element.
+         */
+        BSONElementIterator* _startSubIterator( const ElementPath* path, const BSONObj& context );
+
         const ElementPath* _path;
         BSONObj _context;
 
@@ -134,6 +165,8 @@ namespace mongo {
 
         struct ArrayIterationState {
 
+            ArrayIterationState();
+
             void reset( const FieldRef& ref, int start );
             void startIterator( BSONElement theArray );
 
@@ -143,20 +176,24 @@ namespace mongo {
             bool isArrayOffsetMatch( const StringData& fieldName ) const;
             bool nextEntireRest() const { return nextPieceOfPath.size() == restOfPath.size(); }
 
-            string restOfPath;
+            StringData restOfPath; // into the ElementPath's FieldRef
+            int startOfRest;       // the part index restOfPath begins at
             bool hasMore;
             StringData nextPieceOfPath;
             bool nextPieceOfPathIsNumber;
 
             BSONElement _theArray;
             BSONElement _current;
-            boost::scoped_ptr<BSONObjIterator> _iterator;
+            BSONObjIterator _iterator; // only valid when _iteratorActive
+            bool _iteratorActive;
         };
 
         ArrayIterationState _arrayIterationState;
 
-        boost::scoped_ptr<ElementIterator> _subCursor;
-        boost::scoped_ptr<ElementPath> _subCursorPath;
+        // non-NULL while descending into an array element; points into
+        // _subIterator, which is kept allocated for reuse
+        BSONElementIterator* _subCursor;
+        boost::scoped_ptr<BSONElementIterator> _subIterator;
     };
 
 }
@@ -361,6 +361,23 @@ namespace mongo {
         ASSERT( !i.more() );
     }
 
+    TEST( Path, SuffixPathsParsedAtInit ) {
+        ElementPath p;
+        ASSERT( p.init( "a.b.c" ).isOK() );
+
+        ASSERT_EQUALS( &p, p.suffixPath( 0 ) );
+        ASSERT_EQUALS( "b.c", p.suffixPath( 1 )->fieldRef().dottedField() );
+        ASSERT_EQUALS( "c", p.suffixPath( 2 )->fieldRef().dottedField() );
+
+        // the suffix of a suffix is shared with the original path
+        ASSERT_EQUALS( p.suffixPath( 2 ), p.suffixPath( 1 )->suffixPath( 1 ) );
+
+        // leaf array traversal propagates to the suffixes
+        ASSERT( p.suffixPath( 2 )->shouldTraverseLeafArray() );
+        p.setTraverseLeafArray( false );
+        ASSERT( !p.suffixPath( 2 )->shouldTraverseLeafArray() );
+    }
+
     TEST( SingleElementElementIterator, Simple1 ) {
         BSONObj obj = BSON( "x" << 3 << "y" << 5 );
         SingleElementElementIterator i( obj["y"] );
@@ -373,4 +390,19 @@ namespace mongo {
 
     }
 
+    TEST( SingleElementElementIterator, Reset1 ) {
+        BSONObj obj = BSON( "x" << 3 << "y" << 5 );
+        SingleElementElementIterator i( obj["y"] );
+
+        ASSERT( i.more() );
+        ASSERT_EQUALS( 5, i.next().element().numberInt() );
+        ASSERT( !i.more() );
+
+        i.reset( obj["x"] );
+
+        ASSERT( i.more() );
+        ASSERT_EQUALS( 3, i.next().element().numberInt() );
+        ASSERT( !i.more() );
+    }
+
 }
@@ -161,6 +161,10 @@ namespace mongo {
                 "print some diagnostic system information")
                                          .setSources(moe::SourceAllLegacy);
 
+        general_options.addOptionChaining("numaInterleave", "numaInterleave", moe::Switch,
+                "interleave memory allocation across NUMA nodes, like "
+                "numactl --interleave=all (linux only)");
+
         // Storage Options
 
 #ifdef _WIN32
@@ -274,6 +278,10 @@ namespace mongo {
         general_options.addOptionChaining("storage.journal.commitIntervalMs",
                 "journalCommitInterval", moe::Unsigned, "how often to group/batch commit (ms)");
 
+        general_options.addOptionChaining("storage.journal.path", "journalPath", moe::String,
+                "directory for journal files (e.g. on a separate device); "
+                "defaults to <dbpath>/journal");
+
         // Deprecated option that we don't want people to use for performance reasons
         options->addOptionChaining("nopreallocj", "nopreallocj", moe::Switch,
                 "don't preallocate journal files")
@@ -529,6 +537,9 @@ namespace mongo {
         if (params.count("cpu")) {
             serverGlobalParams.cpu = true;
         }
+        if (params.count("numaInterleave")) {
+            mongodGlobalParams.numaInterleave = true;
+        }
         if (params.count("noauth") ||
             (params.count("security.authentication") &&
              params["security.authentication"].as<std::string>() == "optional")) {
@@ -584,6 +595,12 @@ namespace mongo {
         if (params.count("storage.journal.debugFlags")) {
             storageGlobalParams.durOptions = params["storage.journal.debugFlags"].as<int>();
         }
+        if (params.count("storage.journal.path")) {
+            storageGlobalParams.journalPath = params["storage.journal.path"].as<string>();
+            if (storageGlobalParams.journalPath.empty()) {
+                return Status(ErrorCodes::BadValue, "journalPath must not be empty");
+            }
+        }
         if (params.count("nohints")) {
             storageGlobalParams.useHints = false;
         }
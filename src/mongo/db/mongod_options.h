@@ -47,11 +47,13 @@ namespace mongo {
         bool upgrade;
         bool repair;
         bool scriptingEnabled; // --noscripting
+        bool numaInterleave; // --numaInterleave
 
         MongodGlobalParams() :
             upgrade(0),
             repair(0),
-            scriptingEnabled(true)
+            scriptingEnabled(true),
+            numaInterleave(false)
         { }
     };
 
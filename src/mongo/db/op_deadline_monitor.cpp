@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/op_deadline_monitor.h"
+
+#include <limits>
+
+#include "mongo/db/curop.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    const uint64_t OpDeadlineMonitor::kNoDeadline = std::numeric_limits<uint64_t>::max();
+
+    OpDeadlineMonitor opDeadlineMonitor;
+
+    OpDeadlineMonitor::OpDeadlineMonitor()
+        : _mtx("OpDeadlineMonitor"),
+          _nearestDeadlineMicros(kNoDeadline),
+          _started(false) {
+    }
+
+    void OpDeadlineMonitor::registerDeadline(CurOp* op, uint64_t deadlineEpochMicros) {
+        scoped_lock lk(_mtx);
+        if (!_started) {
+            _started = true;
+            go();
+        }
+        _deadlines[op] = deadlineEpochMicros;
+        if (deadlineEpochMicros < _nearestDeadlineMicros) {
+            _nearestDeadlineMicros = deadlineEpochMicros;
+            _condvar.notify_one();
+        }
+    }
+
+    void OpDeadlineMonitor::deregisterDeadline(CurOp* op) {
+        scoped_lock lk(_mtx);
+        _deadlines.erase(op);
+        // _nearestDeadlineMicros may now be stale (too near); the monitor thread just wakes
+        // up, finds nothing expired, and recomputes.
+    }
+
+    void OpDeadlineMonitor::run() {
+        scoped_lock lk(_mtx);
+        while (!inShutdown()) {
+            uint64_t now = curTimeMicros64();
+
+            // Sleep until the nearest deadline arrives or a nearer one is registered.
+            while (_nearestDeadlineMicros > now) {
+                if (_nearestDeadlineMicros == kNoDeadline) {
+                    _condvar.wait(lk.boost());
+                }
+                else {
+                    _condvar.timed_wait(
+                            lk.boost(),
+                            boost::posix_time::microseconds(_nearestDeadlineMicros - now));
+                }
+                if (inShutdown())
+                    return;
+                now = curTimeMicros64();
+            }
+
+            // Sweep: flip the expired word on every op whose deadline has passed, and
+            // recompute the nearest remaining deadline.
+            _nearestDeadlineMicros = kNoDeadline;
+            DeadlineMap::iterator i = _deadlines.begin();
+            while (i != _deadlines.end()) {
+                if (i->second <= now) {
+                    i->first->markMaxTimeExpired();
+                    _deadlines.erase(i++);
+                }
+                else {
+                    if (i->second < _nearestDeadlineMicros)
+                        _nearestDeadlineMicros = i->second;
+                    ++i;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/condition.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/cstdint.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class CurOp;
+
+    /**
+     * Centralized enforcement of per-operation time limits (maxTimeMS).
+     *
+     * An operation with a time limit registers its absolute deadline here once, at the point
+     * where the limit is armed, and deregisters when it finishes.  A single background thread
+     * sleeps until the nearest registered deadline and, on expiration, flips the owning CurOp's
+     * "max time expired" word (CurOp::markMaxTimeExpired()).  Execution paths then only have to
+     * read that per-op word -- via CurOp::maxTimeHasExpired(), called from
+     * KillCurrentOp::checkForInterrupt() -- instead of consulting a clock per document.
+     *
+     * The monitor thread is started lazily on first registration, so tools and tests that
+     * never set a time limit pay nothing.
+     *
+     * Lifetime: a CurOp must deregister before it is destroyed or reset for reuse; the monitor
+     * only touches ops that are currently registered, under its own mutex.
+     */
+    class OpDeadlineMonitor : public BackgroundJob {
+        MONGO_DISALLOW_COPYING(OpDeadlineMonitor);
+    public:
+        OpDeadlineMonitor();
+
+        virtual std::string name() const { return "OpDeadlineMonitor"; }
+
+        /**
+         * Start (or move) deadline tracking for "op".  The monitor will call
+         * op->markMaxTimeExpired() once the wall clock passes "deadlineEpochMicros" (units of
+         * microseconds since the epoch).
+         */
+        void registerDeadline(CurOp* op, uint64_t deadlineEpochMicros);
+
+        /**
+         * Stop deadline tracking for "op".  Safe to call whether or not the deadline has
+         * already fired; a no-op if "op" is not registered.
+         */
+        void deregisterDeadline(CurOp* op);
+
+    protected:
+        virtual void run();
+
+    private:
+        // Sentinel deadline meaning "nothing registered"; the monitor thread waits untimed.
+        static const uint64_t kNoDeadline;
+
+        typedef unordered_map<CurOp*, uint64_t> DeadlineMap;
+
+        mongo::mutex _mtx;            // protects all fields below
+        boost::condition _condvar;    // signaled when a nearer deadline is registered
+        DeadlineMap _deadlines;       // op -> absolute deadline, micros since epoch
+        uint64_t _nearestDeadlineMicros;
+        bool _started;                // monitor thread spawned?
+    };
+
+    extern OpDeadlineMonitor opDeadlineMonitor;
+}
@@ -34,6 +34,9 @@
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_count_sketch.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/query/get_runner.h"
 #include "mongo/util/elapsed_tracker.h"
 
@@ -65,7 +68,56 @@ namespace mongo {
         return num;
     }
 
-    long long runCount( const string& ns, const BSONObj &cmd, string &err, int &errCode ) {
+    /**
+     * Tries to answer the count from an index's count sketch instead of a
+     * scan.  Only handles a single top-level equality predicate backed by a
+     * single-field, non-multikey, non-sparse index; anything else returns
+     * false and the caller runs the exact count.
+     */
+    static bool runApproxCount( Collection* collection, const BSONObj& query,
+                                BSONObjBuilder* extraInfo, long long* out ) {
+        if ( query.nFields() != 1 )
+            return false;
+
+        BSONElement e = query.firstElement();
+        if ( e.type() == RegEx )
+            return false;
+        if ( e.type() == Object && e.Obj().firstElementFieldName()[0] == '$' )
+            return false; // an operator, not an equality on a subdocument
+        if ( e.type() == Array )
+            return false; // array equality needs multikey semantics
+
+        IndexCatalog* catalog = collection->getIndexCatalog();
+        IndexDescriptor* desc = catalog->findIndexByKeyPattern( BSON( e.fieldName() << 1 ) );
+        if ( NULL == desc )
+            desc = catalog->findIndexByKeyPattern( BSON( e.fieldName() << -1 ) );
+        if ( NULL == desc )
+            return false;
+
+        // the sketch counts index keys, which only match document counts for
+        // non-multikey indexes; sparse indexes miss null-equality matches
+        if ( desc->isSparse() || catalog->isMultikey( desc ) )
+            return false;
+
+        const IndexCountSketch* sketch = catalog->getIndex( desc )->getCountSketch();
+        if ( NULL == sketch )
+            return false;
+
+        BSONObjBuilder keyBob;
+        keyBob.appendAs( e, "" );
+        *out = sketch->estimateEq( keyBob.obj() );
+
+        if ( extraInfo ) {
+            extraInfo->appendBool( "approximate", true );
+            // estimateEq() is an upper bound; other keys hashing into the
+            // same bucket inflate it by about this much on average
+            extraInfo->appendNumber( "approxErrorBound", sketch->expectedError() );
+        }
+        return true;
+    }
+
+    long long runCount( const string& ns, const BSONObj &cmd, string &err, int &errCode,
+                        BSONObjBuilder* extraInfo ) {
         // Lock 'ns'.
         Client::Context cx(ns);
         Collection* collection = cx.db()->getCollection(ns);
@@ -84,6 +136,13 @@ namespace mongo {
             return applySkipLimit(collection->numRecords(), cmd);
         }
 
+        if (cmd["approx"].trueValue()) {
+            long long approx;
+            if (runApproxCount(collection, query, extraInfo, &approx)) {
+                return applySkipLimit(approx, cmd);
+            }
+        }
+
         Runner* rawRunner;
         long long skip = cmd["skip"].numberLong();
         long long limit = cmd["limit"].numberLong();
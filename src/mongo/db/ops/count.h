@@ -35,11 +35,17 @@ namespace mongo {
     /**
      * 'ns' is the namespace we're counting on.
      *
-     * { count: "collectionname"[, query: <query>] }
+     * { count: "collectionname"[, query: <query>][, approx: <bool>] }
+     *
+     * With approx:true, simple equality queries may be answered from a
+     * per-index sketch instead of an index scan; 'extraInfo', if provided,
+     * then gets "approximate" and "approxErrorBound" fields describing the
+     * answer.  Queries the sketch cannot handle fall back to an exact count.
      *
      * @return -1 on ns does not exist error and other errors, 0 on other errors, otherwise the
      * match count.
      */
-    long long runCount(const std::string& ns, const BSONObj& cmd, string& err, int& errCode );
+    long long runCount(const std::string& ns, const BSONObj& cmd, string& err, int& errCode,
+                       BSONObjBuilder* extraInfo = NULL );
 
 } // namespace mongo
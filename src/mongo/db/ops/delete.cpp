@@ -46,8 +46,10 @@ namespace mongo {
        pattern: the "where" clause / criteria
        justOne: stop after 1 match
        god:     allow access to system namespaces, and don't yield
+       limit:   if > 0, stop after this many deletes
     */
-    long long deleteObjects(const StringData& ns, BSONObj pattern, bool justOne, bool logop, bool god) {
+    long long deleteObjects(const StringData& ns, BSONObj pattern, bool justOne, bool logop,
+                            bool god, long long limit) {
         if (!god) {
             if (ns.find( ".system.") != string::npos) {
                 // note a delete from system.indexes would corrupt the db if done here, as there are
@@ -131,7 +133,7 @@ namespace mongo {
                 }
             }
 
-            if (justOne) {
+            if (justOne || (limit && nDeleted >= limit)) {
                 break;
             }
 
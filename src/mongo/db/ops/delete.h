@@ -35,10 +35,13 @@
 namespace mongo {
 
     // If justOne is true, deletedId is set to the id of the deleted object.
+    // limit, when > 0, stops the delete after that many documents even if
+    // more match; callers (e.g. the TTL monitor) use it to delete in batches.
     long long deleteObjects(const StringData& ns,
                             BSONObj pattern,
                             bool justOne,
                             bool logop = false,
-                            bool god = false);
+                            bool god = false,
+                            long long limit = 0);
 
 }
@@ -46,7 +46,11 @@ namespace mongo {
 
         bool firstElementIsId = doc.firstElement().fieldNameStringData() == "_id";
         bool hasTimestampToFix = false;
+        int numIdFields = 0;
+        BSONElement idElt;
         {
+            // One scan collects everything needed both to validate the document and
+            // to decide below how (and whether) it has to be rewritten.
             BSONObjIterator i( doc );
             while ( i.more() ) {
                 BSONElement e = i.next();
@@ -55,7 +59,6 @@ namespace mongo {
                     // we replace Timestamp(0,0) at the top level with a correct value
                     // in the fast pass, we just mark that we want to swap
                     hasTimestampToFix = true;
-                    break;
                 }
 
                 const char* fieldName = e.fieldName();
@@ -88,6 +91,8 @@ namespace mongo {
                         if ( !s.isOK() )
                             return StatusWith<BSONObj>( s );
                     }
+                    if ( numIdFields++ == 0 )
+                        idElt = e;
                 }
 
             }
@@ -96,7 +101,33 @@ namespace mongo {
         if ( firstElementIsId && !hasTimestampToFix )
             return StatusWith<BSONObj>( BSONObj() );
 
-        bool hadId = firstElementIsId;
+        if ( !hasTimestampToFix && numIdFields <= 1 ) {
+            // No element needs rewriting; the result is the input bytes with a
+            // single _id element in front. Assemble it with raw buffer copies
+            // instead of re-appending every field through the builder.
+            BSONObjBuilder b( doc.objsize() + 16 );
+            BufBuilder& raw = b.bb();
+
+            const char* elemsBegin = doc.objdata() + 4; // skip the length word
+            const char* elemsEnd = doc.objdata() + doc.objsize() - 1; // stop before the EOO
+
+            if ( numIdFields == 0 ) {
+                b.appendOID( "_id", NULL, true );
+                raw.appendBuf( elemsBegin, elemsEnd - elemsBegin );
+            }
+            else {
+                const char* idBegin = idElt.rawdata();
+                const char* idEnd = idBegin + idElt.size();
+                raw.appendBuf( idBegin, idEnd - idBegin );
+                raw.appendBuf( elemsBegin, idBegin - elemsBegin );
+                raw.appendBuf( idEnd, elemsEnd - idEnd );
+            }
+            return StatusWith<BSONObj>( b.obj() );
+        }
+
+        // A zero Timestamp needs to be replaced and/or extra _id fields dropped,
+        // so rebuild the document field by field.
+        bool hadId = numIdFields > 0;
 
         BSONObjIterator i( doc );
 
@@ -105,15 +136,11 @@ namespace mongo {
             b.append( doc.firstElement() );
             i.next();
         }
+        else if ( hadId ) {
+            b.append( idElt );
+        }
         else {
-            BSONElement e = doc["_id"];
-            if ( e.type() ) {
-                b.append( e );
-                hadId = true;
-            }
-            else {
-                b.appendOID( "_id", NULL, true );
-            }
+            b.appendOID( "_id", NULL, true );
         }
 
         while ( i.more() ) {
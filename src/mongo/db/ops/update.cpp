@@ -52,6 +52,7 @@
 #include "mongo/db/queryutil.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/record.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/platform/unordered_set.h"
@@ -59,6 +60,21 @@
 namespace mongo {
 
     namespace mb = mutablebson;
+
+    // A multi-update releases its lock after modifying this many documents,
+    // whether or not anybody is queued for the lock yet.  The automatic yield
+    // policy only reacts to lock pressure, and once an update dominates the
+    // writer queue each of its yields is a token one; deterministic slice
+    // boundaries (plus the pause below) turn a monster update into a stream
+    // of bounded-latency operations instead.  Zero or negative disables
+    // slicing.
+    MONGO_EXPORT_SERVER_PARAMETER(updateSliceDocs, int, 10000);
+
+    // Microseconds a sliced multi-update sleeps at each slice boundary, so
+    // big updates can be paced to let readers, the journal and secondaries
+    // keep up.  Zero just releases and reacquires the lock.
+    MONGO_EXPORT_SERVER_PARAMETER(updateSlicePauseMicros, int, 0);
+
     namespace {
 
         const char idFieldName[] = "_id";
@@ -538,6 +554,25 @@ namespace mongo {
             (cq && QueryPlannerCommon::hasNode(cq->root(), MatchExpression::ATOMIC)) ||
             isQueryIsolated(request.getQuery());
 
+        // Broad multi-updates run in slices of updateSliceDocs modified
+        // documents, with a forced lock release (and optional pause) at each
+        // slice boundary, and advertise their progress in currentOp.
+        // Isolated updates may not yield at all, and replication paces its
+        // own batches.
+        const int sliceDocs =
+            (request.isMulti() && !isolated && !request.isFromReplication()) ?
+            updateSliceDocs : 0;
+
+        scoped_ptr<ProgressMeterHolder> sliceProgress;
+        if (sliceDocs > 0) {
+            ProgressMeter& pm = cc().curop()->setMessage("sliced multi-update",
+                                                         "Multi-Update Progress",
+                                                         0 /* total unknown */);
+            pm.showTotal(false);
+            pm.setUnits("docs");
+            sliceProgress.reset(new ProgressMeterHolder(pm));
+        }
+
         //
         // We'll start assuming we have one or more documents for this update. (Otherwise,
         // we'll fall-back to insert case (if upsert is true).)
@@ -642,47 +677,62 @@ namespace mongo {
             opDebug->nscannedObjects++;
             numMatched++;
 
-            // Ask the driver to apply the mods. It may be that the driver can apply those "in
-            // place", that is, some values of the old document just get adjusted without any
-            // change to the binary layout on the bson layer. It may be that a whole new
-            // document is needed to accomodate the new bson layout of the resulting document.
-            doc.reset(oldObj, mutablebson::Document::kInPlaceEnabled);
             BSONObj logObj;
+            const char* source = NULL;
 
+            const std::vector<FieldRef*>* immutableFields = NULL;
+            if (lifecycle && !(request.isFromReplication() || request.isFromMigration()))
+                immutableFields = lifecycle->getImmutableFields();
+
+            // Counter-style updates -- a few $set/$inc mods over existing fixed-width
+            // scalars -- can be computed as byte patches straight off the old document.
+            // When the driver manages that, the mutable document machinery below is
+            // skipped entirely.
+            const bool usedFastPath =
+                driver->tryFastPathUpdate(oldObj, immutableFields, &damages, &source, &logObj);
 
             FieldRefSet updatedFields;
 
-            Status status = Status::OK();
-            if (!driver->needMatchDetails()) {
-                // If we don't need match details, avoid doing the rematch
-                status = driver->update(StringData(), &doc, &logObj, &updatedFields);
-            }
-            else {
-                // If there was a matched field, obtain it.
-                MatchDetails matchDetails;
-                matchDetails.requestElemMatchKey();
+            if (!usedFastPath) {
+                // Ask the driver to apply the mods. It may be that the driver can apply
+                // those "in place", that is, some values of the old document just get
+                // adjusted without any change to the binary layout on the bson layer. It
+                // may be that a whole new document is needed to accomodate the new bson
+                // layout of the resulting document.
+                doc.reset(oldObj, mutablebson::Document::kInPlaceEnabled);
+
+                Status status = Status::OK();
+                if (!driver->needMatchDetails()) {
+                    // If we don't need match details, avoid doing the rematch
+                    status = driver->update(StringData(), &doc, &logObj, &updatedFields);
+                }
+                else {
+                    // If there was a matched field, obtain it.
+                    MatchDetails matchDetails;
+                    matchDetails.requestElemMatchKey();
 
-                dassert(cq);
-                verify(cq->root()->matchesBSON(oldObj, &matchDetails));
+                    dassert(cq);
+                    verify(cq->root()->matchesBSON(oldObj, &matchDetails));
 
-                string matchedField;
-                if (matchDetails.hasElemMatchKey())
-                    matchedField = matchDetails.elemMatchKey();
+                    string matchedField;
+                    if (matchDetails.hasElemMatchKey())
+                        matchedField = matchDetails.elemMatchKey();
 
-                // TODO: Right now, each mod checks in 'prepare' that if it needs positional
-                // data, that a non-empty StringData() was provided. In principle, we could do
-                // that check here in an else clause to the above conditional and remove the
-                // checks from the mods.
+                    // TODO: Right now, each mod checks in 'prepare' that if it needs positional
+                    // data, that a non-empty StringData() was provided. In principle, we could do
+                    // that check here in an else clause to the above conditional and remove the
+                    // checks from the mods.
 
-                status = driver->update(matchedField, &doc, &logObj, &updatedFields);
-            }
+                    status = driver->update(matchedField, &doc, &logObj, &updatedFields);
+                }
 
-            if (!status.isOK()) {
-                uasserted(16837, status.reason());
-            }
+                if (!status.isOK()) {
+                    uasserted(16837, status.reason());
+                }
 
-            // Ensure _id exists and is first
-            uassertStatusOK(ensureIdAndFirst(doc));
+                // Ensure _id exists and is first
+                uassertStatusOK(ensureIdAndFirst(doc));
+            }
 
             // If the driver applied the mods in place, we can ask the mutable for what
             // changed. We call those changes "damages". :) We use the damages to inform the
@@ -696,17 +746,13 @@ namespace mongo {
             // ourselves.
             bool docWasModified = false;
             BSONObj newObj;
-            const char* source = NULL;
-            bool inPlace = doc.getInPlaceUpdates(&damages, &source);
+            bool inPlace = usedFastPath || doc.getInPlaceUpdates(&damages, &source);
 
             // If something changed in the document, verify that no immutable fields were changed
-            // and data is valid for storage.
-            if ((!inPlace || !damages.empty()) ) {
+            // and data is valid for storage. The fast path above has already vetted its mods
+            // against the immutable fields and cannot make a document invalid for storage.
+            if (!usedFastPath && (!inPlace || !damages.empty()) ) {
                 if (!(request.isFromReplication() || request.isFromMigration())) {
-                    const std::vector<FieldRef*>* immutableFields = NULL;
-                    if (lifecycle)
-                        immutableFields = lifecycle->getImmutableFields();
-
                     uassertStatusOK(validate(oldObj,
                                              updatedFields,
                                              doc,
@@ -729,6 +775,15 @@ namespace mongo {
 
                     collection->details()->paddingFits();
 
+                    // This path bypasses Collection::updateDocument and with it the
+                    // bookkeeping done there (e.g. the incremental dbHash digest).
+                    // The byte patches below destroy the pre-image those notes need,
+                    // so copy it first -- but only when someone is listening.
+                    const bool notesWanted = collection->wantsInPlaceUpdateNotes();
+                    BSONObj preImage;
+                    if (notesWanted)
+                        preImage = oldObj.getOwned();
+
                     // All updates were in place. Apply them via durability and writing pointer.
                     mutablebson::DamageVector::const_iterator where = damages.begin();
                     const mutablebson::DamageVector::const_iterator end = damages.end();
@@ -741,6 +796,9 @@ namespace mongo {
                     }
                     docWasModified = true;
                     opDebug->fastmod = true;
+
+                    if (notesWanted)
+                        collection->noteInPlaceUpdate(preImage, oldObj);
                 }
 
                 newObj = oldObj;
@@ -780,8 +838,11 @@ namespace mongo {
             }
 
             // Only record doc modifications if they wrote (exclude no-ops)
-            if (docWasModified)
+            if (docWasModified) {
                 opDebug->nModified++;
+                if (sliceProgress)
+                    sliceProgress->hit();
+            }
 
             if (!request.isMulti()) {
                 break;
@@ -789,6 +850,20 @@ namespace mongo {
 
             // Opportunity for journaling to write during the update.
             getDur().commitIfNeeded();
+
+            // End of slice: give up the lock even though nobody may be
+            // queued for it yet, pause if so configured, and recover exactly
+            // as after an automatic yield.
+            if (sliceDocs > 0 && docWasModified &&
+                (opDebug->nModified % sliceDocs == 0)) {
+                runner->saveState();
+                RunnerYieldPolicy::staticYield(
+                        updateSlicePauseMicros > 0 ? updateSlicePauseMicros : 0);
+                uassert(17576,
+                        "Update could not restore runner state after a slice boundary.",
+                        runner->restoreState());
+                uassertStatusOK(recoverFromYield(request, driver, collection));
+            }
         }
 
         // TODO: Can this be simplified?
@@ -28,6 +28,9 @@
 
 #include "mongo/db/ops/update_driver.h"
 
+#include <cctype>
+#include <limits>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/base/string_data.h"
 #include "mongo/bson/mutable/algorithm.h"
@@ -46,13 +49,85 @@ namespace mongo {
     namespace str = mongoutils::str;
     namespace mb = mongo::mutablebson;
 
+    namespace {
+
+        // Value types with a fixed-width representation; a new value of the same type
+        // can be patched over the old one byte for byte.
+        bool isFixedWidthType(BSONType type) {
+            switch (type) {
+            case NumberDouble:
+            case NumberInt:
+            case NumberLong:
+            case Bool:
+            case Date:
+            case Timestamp:
+            case jstOID:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        // A strictly numeric path part without leading zeros (except "0" itself), the
+        // only form the mods accept as an array index.
+        bool isArrayIndex(const StringData& part) {
+            if (part.empty() || (part.size() > 1 && part[0] == '0'))
+                return false;
+            for (size_t i = 0; i < part.size(); i++) {
+                if (!isdigit(static_cast<unsigned char>(part[i])))
+                    return false;
+            }
+            return true;
+        }
+
+        // Walks 'field' down 'obj' the way the mods resolve paths: objects by field
+        // name, arrays by plain numeric index. Returns eoo when the path doesn't lead
+        // to an element that already exists.
+        BSONElement findFieldInObject(const BSONObj& obj, const FieldRef& field) {
+            BSONObj current = obj;
+            for (size_t i = 0; true; i++) {
+                BSONElement elem = current.getField(field.getPart(i));
+                if (elem.eoo())
+                    return BSONElement();
+
+                if (i == field.numParts() - 1)
+                    return elem;
+
+                if (elem.type() == Object)
+                    current = elem.embeddedObject();
+                else if (elem.type() == Array && isArrayIndex(field.getPart(i + 1)))
+                    current = elem.embeddedObject();
+                else
+                    return BSONElement();
+            }
+        }
+
+        // Records one byte patch: 'size' bytes at 'newValue' replace the value bytes of
+        // 'target' inside 'obj'.
+        void appendDamage(const BSONObj& obj,
+                          const BSONElement& target,
+                          const void* newValue,
+                          size_t size,
+                          mb::DamageVector* damages,
+                          BufBuilder* source) {
+            mb::DamageEvent event;
+            event.sourceOffset = source->len();
+            event.targetOffset = target.value() - obj.objdata();
+            event.size = size;
+            damages->push_back(event);
+            source->appendBuf(newValue, size);
+        }
+
+    } // namespace
+
     UpdateDriver::UpdateDriver(const Options& opts)
         : _replacementMode(false)
         , _indexedFields(NULL)
         , _logOp(opts.logOp)
         , _modOptions(opts.modOptions)
         , _affectIndices(false)
-        , _positional(false) {
+        , _positional(false)
+        , _fastPathEligible(true) {
     }
 
     UpdateDriver::~UpdateDriver() {
@@ -84,6 +159,7 @@ namespace mongo {
 
             // Register the fact that this driver will only do full object replacements.
             _replacementMode = true;
+            _fastPathEligible = false;
 
             return Status::OK();
         }
@@ -133,6 +209,19 @@ namespace mongo {
         // replacement.
         _replacementMode = false;
 
+        // Conflicting mods (e.g. two $incs over the same field) must keep going through
+        // the regular path, which knows how to report them.
+        if (_fastPathEligible && _fastPathMods.size() > 1) {
+            FieldRefSet fields;
+            for (size_t i = 0; i < _fastPathMods.size(); i++) {
+                const FieldRef* conflict;
+                if (!fields.insert(_fastPathMods[i].field, &conflict)) {
+                    _fastPathEligible = false;
+                    break;
+                }
+            }
+        }
+
         return Status::OK();
     }
 
@@ -160,6 +249,33 @@ namespace mongo {
 
         _mods.push_back(mod.release());
 
+        // Track whether the update expression as a whole qualifies for the binary path
+        // of tryFastPathUpdate; one mod outside the $set/$inc-of-a-fixed-width-scalar
+        // shape disqualifies the expression.
+        if (_fastPathEligible) {
+            if (!positional &&
+                (type == modifiertable::MOD_SET || type == modifiertable::MOD_INC) &&
+                isFixedWidthType(elem.type())) {
+
+                auto_ptr<FieldRef> field(new FieldRef(elem.fieldName()));
+                if (field->getPart(0) == "_id") {
+                    // _id is immutable; leave anything near it to the regular path.
+                    _fastPathEligible = false;
+                }
+                else {
+                    FastPathMod fastMod;
+                    fastMod.type = type;
+                    fastMod.arg = elem;
+                    fastMod.field = field.get();
+                    _fastPathMods.push_back(fastMod);
+                    _fastPathFields.mutableVector().push_back(field.release());
+                }
+            }
+            else {
+                _fastPathEligible = false;
+            }
+        }
+
         return Status::OK();
     }
 
@@ -376,6 +492,125 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool UpdateDriver::tryFastPathUpdate(const BSONObj& obj,
+                                         const std::vector<FieldRef*>* immutableFields,
+                                         mutablebson::DamageVector* damages,
+                                         const char** source,
+                                         BSONObj* logOpRec) {
+        if (!_fastPathEligible || _fastPathMods.empty())
+            return false;
+
+        // The regular path gives a document without an _id one; those documents are
+        // not ours to patch.
+        if (obj["_id"].eoo())
+            return false;
+
+        _affectIndices = false;
+        damages->clear();
+        _fastPathBuf.reset();
+
+        BSONObjBuilder setBuilder;
+
+        for (size_t i = 0; i < _fastPathMods.size(); i++) {
+            const FastPathMod& fastMod = _fastPathMods[i];
+            const FieldRef& field = *fastMod.field;
+
+            // Touching an indexed field means index keys must be rebuilt, which only
+            // the regular path knows how to arrange.
+            if (_indexedFields && _indexedFields->mightBeIndexed(field.dottedField()))
+                return false;
+
+            // Leave anything near an immutable field (e.g. the shard key) to the
+            // regular path's validation.
+            if (immutableFields) {
+                for (size_t j = 0; j < immutableFields->size(); j++) {
+                    const FieldRef& immutable = *(*immutableFields)[j];
+                    if (immutable == field ||
+                        immutable.isPrefixOf(field) ||
+                        field.isPrefixOf(immutable))
+                        return false;
+                }
+            }
+
+            const BSONElement current = findFieldInObject(obj, field);
+            if (current.eoo())
+                return false;
+
+            if (fastMod.type == modifiertable::MOD_SET) {
+                // Only a value of the very same layout can be patched over the old one.
+                if (current.type() != fastMod.arg.type())
+                    return false;
+
+                // Same no-op rule as ModifierSet: an equal value writes nothing and
+                // logs nothing.
+                if (current.valuesEqual(fastMod.arg))
+                    continue;
+
+                appendDamage(obj, current, fastMod.arg.value(), fastMod.arg.valuesize(),
+                             damages, &_fastPathBuf);
+                setBuilder.appendAs(fastMod.arg, field.dottedField());
+            }
+            else {
+                // $inc. Bail out whenever the sum would come out as a different type --
+                // promotion to NumberLong or NumberDouble changes the layout -- or
+                // whenever the regular path would report an error; the type and
+                // promotion rules below mirror those of SafeNum.
+                switch (current.type()) {
+                case NumberInt: {
+                    if (fastMod.arg.type() != NumberInt)
+                        return false; // mixed operands promote
+                    const long long sum =
+                        static_cast<long long>(current._numberInt()) + fastMod.arg._numberInt();
+                    if (sum < std::numeric_limits<int>::min() ||
+                        sum > std::numeric_limits<int>::max())
+                        return false; // overflows into NumberLong
+                    const int value = static_cast<int>(sum);
+                    if (value == current._numberInt())
+                        continue;
+                    appendDamage(obj, current, &value, sizeof(value), damages, &_fastPathBuf);
+                    setBuilder.append(field.dottedField(), value);
+                    break;
+                }
+                case NumberLong: {
+                    if (fastMod.arg.type() == NumberDouble)
+                        return false; // promotes to NumberDouble
+                    const long long lhs = current._numberLong();
+                    const long long rhs = fastMod.arg.numberLong();
+                    if ((rhs > 0 && lhs > std::numeric_limits<long long>::max() - rhs) ||
+                        (rhs < 0 && lhs < std::numeric_limits<long long>::min() - rhs))
+                        return false; // the regular path reports the overflow
+                    const long long value = lhs + rhs;
+                    if (value == lhs)
+                        continue;
+                    appendDamage(obj, current, &value, sizeof(value), damages, &_fastPathBuf);
+                    setBuilder.append(field.dottedField(), value);
+                    break;
+                }
+                case NumberDouble: {
+                    const double value = current._numberDouble() + fastMod.arg.numberDouble();
+                    if (value == current._numberDouble())
+                        continue;
+                    appendDamage(obj, current, &value, sizeof(value), damages, &_fastPathBuf);
+                    setBuilder.append(field.dottedField(), value);
+                    break;
+                }
+                default:
+                    // $inc of a non-numeric field; the regular path owns the error.
+                    return false;
+                }
+            }
+        }
+
+        if (_logOp && logOpRec) {
+            const BSONObj setObj = setBuilder.obj();
+            if (!setObj.isEmpty())
+                *logOpRec = BSON("$set" << setObj);
+        }
+
+        *source = _fastPathBuf.buf();
+        return true;
+    }
+
     size_t UpdateDriver::numMods() const {
         return _mods.size();
     }
@@ -443,6 +678,9 @@ namespace mongo {
         _indexedFields = NULL;
         _replacementMode = false;
         _positional = false;
+        _fastPathEligible = true;
+        _fastPathMods.clear();
+        _fastPathFields.clear();
     }
 
 } // namespace mongo
@@ -33,7 +33,9 @@
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/status.h"
+#include "mongo/bson/mutable/damage_vector.h"
 #include "mongo/bson/mutable/document.h"
+#include "mongo/db/field_ref.h"
 #include "mongo/db/field_ref_set.h"
 #include "mongo/db/index_set.h"
 #include "mongo/db/jsobj.h"
@@ -98,6 +100,27 @@ namespace mongo {
                       BSONObj* logOpRec = NULL,
                       FieldRefSet* updatedFields = NULL);
 
+        /**
+         * Attempts to turn the mods into plain byte patches against 'obj', without
+         * building a mutablebson::Document at all. This is only possible when every mod
+         * is a non-positional $set or $inc of a fixed-width scalar over an existing
+         * element of identical layout, and no targeted field is indexed, immutable, or
+         * in conflict with another mod -- the shape of a counter workload.
+         *
+         * On success, returns true and fills in 'damages' with patches whose bytes live
+         * in a buffer owned by this driver, returned through 'source' and valid until
+         * the next call. If the driver is in '_logOp' mode and 'logOpRec' is not NULL,
+         * also fills in the latter with the corresponding oplog entry.
+         *
+         * Returns false when the mods don't qualify; the caller should fall back on
+         * update(), which handles the general case (and owns reporting its errors).
+         */
+        bool tryFastPathUpdate(const BSONObj& obj,
+                               const std::vector<FieldRef*>* immutableFields,
+                               mutablebson::DamageVector* damages,
+                               const char** source,
+                               BSONObj* logOpRec);
+
         //
         // Accessors
         //
@@ -149,6 +172,23 @@ namespace mongo {
         // Collection of update mod instances. Owned here.
         vector<ModifierInterface*> _mods;
 
+        // One parsed mod that qualifies for tryFastPathUpdate: a non-positional $set or
+        // $inc whose argument is a fixed-width scalar.
+        struct FastPathMod {
+            modifiertable::ModifierType type;
+            BSONElement arg; // view into the update expression
+            const FieldRef* field; // owned by '_fastPathFields'
+        };
+
+        // True only if every mod in '_mods' has a counterpart in '_fastPathMods' and no
+        // two of them target conflicting fields.
+        bool _fastPathEligible;
+        vector<FastPathMod> _fastPathMods;
+        OwnedPointerVector<FieldRef> _fastPathFields;
+
+        // Backing store for the damage source bytes handed out by tryFastPathUpdate.
+        BufBuilder _fastPathBuf;
+
         // What are the list of fields in the collection over which the update is going to be
         // applied that participate in indices?
         //
@@ -28,6 +28,11 @@
 
 #include "mongo/db/ops/update_driver.h"
 
+#include <boost/scoped_array.hpp>
+#include <cstring>
+#include <limits>
+#include <vector>
+
 #include "mongo/base/string_data.h"
 #include "mongo/bson/mutable/document.h"
 #include "mongo/bson/mutable/mutable_bson_test_utils.h"
@@ -38,8 +43,10 @@
 namespace {
 
     using mongo::BSONObj;
+    using mongo::FieldRef;
     using mongo::fromjson;
     using mongo::IndexPathSet;
+    using mongo::mutablebson::DamageVector;
     using mongo::mutablebson::Document;
     using mongo::StringData;
     using mongo::UpdateDriver;
@@ -170,4 +177,168 @@ namespace {
 
         ASSERT_NOT_OK(driver.populateDocumentWithQueryFields(fromjson("{a:{$all:[1, 2]}}"), doc));
     }
+
+    // Copies 'obj' and replays the damages over the copy, the way the update path does
+    // against the record store.
+    BSONObj applyDamages(const BSONObj& obj, const DamageVector& damages, const char* source) {
+        boost::scoped_array<char> buf(new char[obj.objsize()]);
+        std::memcpy(buf.get(), obj.objdata(), obj.objsize());
+        for (size_t i = 0; i < damages.size(); i++) {
+            std::memcpy(buf.get() + damages[i].targetOffset,
+                        source + damages[i].sourceOffset,
+                        damages[i].size);
+        }
+        return BSONObj(buf.get()).getOwned();
+    }
+
+    TEST(FastPath, IncInt) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{n:1}}")));
+
+        const BSONObj obj = fromjson("{_id:1, n:1}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_TRUE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+        ASSERT_EQUALS(damages.size(), 1U);
+        ASSERT_EQUALS(fromjson("{_id:1, n:2}"), applyDamages(obj, damages, source));
+    }
+
+    TEST(FastPath, DottedPaths) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{'a.b':1}, $set:{'a.c':true}}")));
+
+        const BSONObj obj = fromjson("{_id:1, a:{b:1, c:false}}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_TRUE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+        ASSERT_EQUALS(damages.size(), 2U);
+        ASSERT_EQUALS(fromjson("{_id:1, a:{b:2, c:true}}"), applyDamages(obj, damages, source));
+    }
+
+    TEST(FastPath, LogsSetOfResult) {
+        UpdateDriver::Options opts;
+        opts.logOp = true;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{n:2}}")));
+
+        const BSONObj obj = fromjson("{_id:1, n:3}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_TRUE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+        ASSERT_EQUALS(fromjson("{$set:{n:5}}"), logObj);
+    }
+
+    TEST(FastPath, NoOpWritesAndLogsNothing) {
+        UpdateDriver::Options opts;
+        opts.logOp = true;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{n:0}, $set:{b:true}}")));
+
+        const BSONObj obj = fromjson("{_id:1, n:1, b:true}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_TRUE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+        ASSERT_TRUE(damages.empty());
+        ASSERT_TRUE(logObj.isEmpty());
+    }
+
+    TEST(FastPath, MissingFieldGoesToRegularPath) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{n:1}}")));
+
+        const BSONObj obj = fromjson("{_id:1}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_FALSE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+    }
+
+    TEST(FastPath, TypeChangeGoesToRegularPath) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$set:{n:2.5}}")));
+
+        // 'n' is a NumberInt; $set of a NumberDouble changes the layout.
+        const BSONObj obj = fromjson("{_id:1, n:1}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_FALSE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+    }
+
+    TEST(FastPath, IntOverflowGoesToRegularPath) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{n:1}}")));
+
+        // The sum promotes to NumberLong, which the byte patch cannot represent.
+        const BSONObj obj = BSON("_id" << 1 << "n" << std::numeric_limits<int>::max());
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_FALSE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+    }
+
+    TEST(FastPath, IndexedFieldGoesToRegularPath) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{n:1}}")));
+
+        IndexPathSet indexes;
+        indexes.addPath("n");
+        driver.refreshIndexKeys(&indexes);
+
+        const BSONObj obj = fromjson("{_id:1, n:1}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_FALSE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+    }
+
+    TEST(FastPath, ImmutableFieldGoesToRegularPath) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{'a.b':1}}")));
+
+        FieldRef shardKey("a");
+        std::vector<FieldRef*> immutableFields;
+        immutableFields.push_back(&shardKey);
+
+        const BSONObj obj = fromjson("{_id:1, a:{b:1}}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_FALSE(driver.tryFastPathUpdate(obj, &immutableFields, &damages, &source, &logObj));
+    }
+
+    TEST(FastPath, OtherModsGoToRegularPath) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{n:1}, $push:{arr:1}}")));
+
+        const BSONObj obj = fromjson("{_id:1, n:1, arr:[]}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_FALSE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+    }
+
+    TEST(FastPath, ConflictingModsGoToRegularPath) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{n:1}, $set:{n:5}}")));
+
+        const BSONObj obj = fromjson("{_id:1, n:1}");
+        DamageVector damages;
+        const char* source = NULL;
+        BSONObj logObj;
+        ASSERT_FALSE(driver.tryFastPathUpdate(obj, NULL, &damages, &source, &logObj));
+    }
 } // unnamed namespace
@@ -42,6 +42,7 @@
 #include "mongo/db/diskloc.h"
 #include "mongo/db/storage/data_file.h"
 #include "mongo/db/storage/durable_mapped_file.h"
+#include "mongo/db/storage/record_compression.h"
 #include "mongo/db/storage/extent.h"
 #include "mongo/db/structure/catalog/namespace_details-inl.h"
 #include "mongo/db/namespace_string.h"
@@ -87,7 +88,13 @@ namespace mongo {
     BOOST_STATIC_ASSERT( 16 == sizeof(DeletedRecord) );
 
     inline BSONObj BSONObj::make(const Record* r ) {
-        return BSONObj( r->data() );
+        const char* data = r->data();
+        if ( isCompressedRecordData( data ) ) {
+            // Flag_CompressRecords collections store snappy-compressed bodies; the format
+            // is self-describing so readers need no catalog lookup.
+            return uncompressRecordObj( data );
+        }
+        return BSONObj( data );
     }
 
 } // namespace mongo
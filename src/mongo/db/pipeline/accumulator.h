@@ -45,6 +45,26 @@ namespace mongo {
             processInternal(input, merging);
         }
 
+        /// True if this accumulator has typed batch kernels (below).
+        virtual bool hasBatchKernels() const { return false; }
+
+        /** Process a homogeneous run of numeric inputs in one call; equivalent
+         *  to boxing each element and calling process(v, false), but kernel
+         *  overrides run a tight loop over the typed buffer instead.  Only
+         *  meaningful for non-merging input.  A run of NumberInt values is
+         *  carried in the long buffer with fromInts set, so int-only semantics
+         *  (e.g. $sum's result type) are preserved.
+         */
+        virtual void processDoubles(const double* vals, size_t n) {
+            for (size_t i = 0; i < n; i++)
+                processInternal(Value(vals[i]), false);
+        }
+        virtual void processLongs(const long long* vals, size_t n, bool fromInts) {
+            for (size_t i = 0; i < n; i++)
+                processInternal(fromInts ? Value(static_cast<int>(vals[i])) : Value(vals[i]),
+                                false);
+        }
+
         /** Marks the end of the evaluate() phase and return accumulated result.
          *  toBeMerged should be true when the outputs will be merged by process().
          */
@@ -123,6 +143,9 @@ namespace mongo {
     class AccumulatorSum : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
+        virtual bool hasBatchKernels() const { return true; }
+        virtual void processDoubles(const double* vals, size_t n);
+        virtual void processLongs(const long long* vals, size_t n, bool fromInts);
         virtual Value getValue(bool toBeMerged) const;
         virtual const char* getOpName() const;
         virtual void reset();
@@ -141,6 +164,9 @@ namespace mongo {
     class AccumulatorMinMax : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
+        virtual bool hasBatchKernels() const { return true; }
+        virtual void processDoubles(const double* vals, size_t n);
+        virtual void processLongs(const long long* vals, size_t n, bool fromInts);
         virtual Value getValue(bool toBeMerged) const;
         virtual const char* getOpName() const;
         virtual void reset();
@@ -175,6 +201,9 @@ namespace mongo {
     class AccumulatorAvg : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
+        virtual bool hasBatchKernels() const { return true; }
+        virtual void processDoubles(const double* vals, size_t n);
+        virtual void processLongs(const long long* vals, size_t n, bool fromInts);
         virtual Value getValue(bool toBeMerged) const;
         virtual const char* getOpName() const;
         virtual void reset();
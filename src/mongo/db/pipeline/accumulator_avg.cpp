@@ -58,6 +58,22 @@ namespace {
         }
     }
 
+    void AccumulatorAvg::processDoubles(const double* vals, size_t n) {
+        double t = 0;
+        for (size_t i = 0; i < n; i++)
+            t += vals[i];
+        _total += t;
+        _count += n;
+    }
+
+    void AccumulatorAvg::processLongs(const long long* vals, size_t n, bool fromInts) {
+        double t = 0;
+        for (size_t i = 0; i < n; i++)
+            t += static_cast<double>(vals[i]);
+        _total += t;
+        _count += n;
+    }
+
     intrusive_ptr<Accumulator> AccumulatorAvg::create() {
         return new AccumulatorAvg();
     }
@@ -45,6 +45,52 @@ namespace mongo {
         }
     }
 
+    void AccumulatorMinMax::processDoubles(const double* vals, size_t n) {
+        if (n == 0)
+            return;
+        double best = vals[0];
+        bool sawNaN = (best != best);
+        if (_sense == 1) {
+            for (size_t i = 1; i < n; i++) {
+                sawNaN = sawNaN || (vals[i] != vals[i]);
+                if (vals[i] < best)
+                    best = vals[i];
+            }
+        }
+        else {
+            for (size_t i = 1; i < n; i++) {
+                sawNaN = sawNaN || (vals[i] != vals[i]);
+                if (vals[i] > best)
+                    best = vals[i];
+            }
+        }
+        if (sawNaN) {
+            // NaN defeats < and >; let Value::compare order these one by one
+            for (size_t i = 0; i < n; i++)
+                processInternal(Value(vals[i]), false);
+            return;
+        }
+        // one boxed comparison against the running result
+        processInternal(Value(best), false);
+    }
+
+    void AccumulatorMinMax::processLongs(const long long* vals, size_t n, bool fromInts) {
+        if (n == 0)
+            return;
+        long long best = vals[0];
+        if (_sense == 1) {
+            for (size_t i = 1; i < n; i++)
+                if (vals[i] < best)
+                    best = vals[i];
+        }
+        else {
+            for (size_t i = 1; i < n; i++)
+                if (vals[i] > best)
+                    best = vals[i];
+        }
+        processInternal(fromInts ? Value(static_cast<int>(best)) : Value(best), false);
+    }
+
     Value AccumulatorMinMax::getValue(bool toBeMerged) const {
         return _val;
     }
@@ -56,6 +56,33 @@ namespace mongo {
         }
     }
 
+    void AccumulatorSum::processDoubles(const double* vals, size_t n) {
+        if (n == 0)
+            return;
+        totalType = Value::getWidestNumeric(totalType, NumberDouble);
+        double t = 0;
+        for (size_t i = 0; i < n; i++)
+            t += vals[i];
+        doubleTotal += t;
+    }
+
+    void AccumulatorSum::processLongs(const long long* vals, size_t n, bool fromInts) {
+        if (n == 0)
+            return;
+        totalType = Value::getWidestNumeric(totalType, fromInts ? NumberInt : NumberLong);
+        long long lt = 0;
+        double dt = 0;
+        for (size_t i = 0; i < n; i++) {
+            lt += vals[i];
+            dt += static_cast<double>(vals[i]);
+        }
+        // mirrors processInternal: the long total only matters while the
+        // result is still integral; the double total is always maintained
+        if (totalType == NumberInt || totalType == NumberLong)
+            longTotal += lt;
+        doubleTotal += dt;
+    }
+
     intrusive_ptr<Accumulator> AccumulatorSum::create() {
         return new AccumulatorSum();
     }
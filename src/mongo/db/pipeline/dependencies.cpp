@@ -138,8 +138,14 @@ namespace {
     Document documentHelper(const BSONObj& bson, const Document& neededFields) {
         MutableDocument md(neededFields.size());
 
+        // Wide documents are usually mostly fields the pipeline never touches, so stop
+        // scanning as soon as every needed field at this level has been seen.  That makes
+        // extraction cost track the size of the dependency set rather than the width of
+        // the input document.
+        size_t remaining = neededFields.size();
+
         BSONObjIterator it(bson);
-        while (it.more()) {
+        while (remaining && it.more()) {
             BSONElement bsonElement (it.next());
             StringData fieldName = bsonElement.fieldNameStringData();
             Value isNeeded = neededFields[fieldName];
@@ -147,6 +153,8 @@ namespace {
             if (isNeeded.missing())
                 continue;
 
+            remaining--;
+
             if (isNeeded.getType() == Bool) {
                 md.addField(fieldName, Value(bsonElement));
                 continue;
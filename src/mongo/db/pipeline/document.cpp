@@ -40,30 +40,38 @@ namespace mongo {
     using namespace mongoutils;
 
     Position DocumentStorage::findField(StringData requested) const {
-        int reqSize = requested.size(); // get size calculation out of the way if needed
-
         if (_numFields >= HASH_TAB_MIN) { // hash lookup
-            const unsigned bucket = bucketForKey(requested);
-
-            Position pos = _hashTab[bucket];
-            while (pos.found()) {
-                const ValueElement& elem = getField(pos);
-                if (elem.nameLen == reqSize
-                    && memcmp(requested.rawData(), elem._name, reqSize) == 0) {
-                    return pos;
-                }
+            return findField(requested, hashKey(requested));
+        }
 
-                // possible collision
-                pos = elem.nextCollision;
+        // linear scan
+        const int reqSize = requested.size();
+        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+            if (it->nameLen == reqSize
+                && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
+                return it.position();
             }
         }
-        else { // linear scan
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
-                if (it->nameLen == reqSize
-                    && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
-                    return it.position();
-                }
+
+        // if we got here, there's no such field
+        return Position();
+    }
+
+    Position DocumentStorage::findField(StringData requested, unsigned hash) const {
+        dassert(_numFields >= HASH_TAB_MIN);
+
+        const int reqSize = requested.size();
+
+        Position pos = _hashTab[hash & _hashTabMask];
+        while (pos.found()) {
+            const ValueElement& elem = getField(pos);
+            if (elem.nameLen == reqSize
+                && memcmp(requested.rawData(), elem._name, reqSize) == 0) {
+                return pos;
             }
+
+            // possible collision
+            pos = elem.nextCollision;
         }
 
         // if we got here, there's no such field
@@ -71,6 +79,11 @@ namespace mongo {
     }
 
     Value& DocumentStorage::appendField(StringData name) {
+        // the hash is only consulted once the table is in use
+        return appendField(name, _numFields >= HASH_TAB_MIN ? hashKey(name) : 0);
+    }
+
+    Value& DocumentStorage::appendField(StringData name, unsigned hash) {
         Position pos = getNextPosition();
         const int nameSize = name.size();
 
@@ -100,7 +113,7 @@ namespace mongo {
         _numFields++;
 
         if (_numFields > HASH_TAB_MIN) {
-            addFieldToHashTable(pos);
+            addFieldToHashTable(pos, hash);
         }
         else if (_numFields == HASH_TAB_MIN) {
             // adds all fields to hash table (including the one we just added)
@@ -111,13 +124,11 @@ namespace mongo {
     }
 
     // Call after adding field to _fields and increasing _numFields
-    void DocumentStorage::addFieldToHashTable(Position pos) {
+    void DocumentStorage::addFieldToHashTable(Position pos, unsigned hash) {
         ValueElement& elem = getField(pos);
         elem.nextCollision = Position();
 
-        const unsigned bucket = bucketForKey(elem.nameSD());
-
-        Position* posPtr = &_hashTab[bucket];
+        Position* posPtr = &_hashTab[hash & _hashTabMask];
         while (posPtr->found()) {
             // collision: walk links and add new to end
             posPtr = &getField(*posPtr).nextCollision;
@@ -220,7 +231,21 @@ namespace mongo {
         BSONObjIterator it(bson);
         while(it.more()) {
             BSONElement bsonElement(it.next());
-            md.addField(bsonElement.fieldNameStringData(), Value(bsonElement));
+            // When 'bson' owns its buffer, long strings reference it instead of
+            // being copied out.
+            md.addField(bsonElement.fieldNameStringData(), Value(bsonElement, bson));
+        }
+
+        *this = md.freeze();
+    }
+
+    Document::Document(const BSONObj& bson, const BSONObj& owner) {
+        MutableDocument md(bson.nFields());
+
+        BSONObjIterator it(bson);
+        while(it.more()) {
+            BSONElement bsonElement(it.next());
+            md.addField(bsonElement.fieldNameStringData(), Value(bsonElement, owner));
         }
 
         *this = md.freeze();
@@ -269,7 +294,7 @@ namespace mongo {
             }
 
             // Note: this will not parse out metadata in embedded documents.
-            md.addField(elem.fieldNameStringData(), Value(elem));
+            md.addField(elem.fieldNameStringData(), Value(elem, bson));
         }
 
         return md.freeze();
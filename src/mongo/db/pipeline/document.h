@@ -71,6 +71,12 @@ namespace mongo {
         /// Create a new Document deep-converted from the given BSONObj.
         explicit Document(const BSONObj& bson);
 
+        /** Create a new Document converted from 'bson', whose buffer is kept alive
+         *  by 'owner'; long string Values reference that buffer rather than copying
+         *  out of it. Used when converting subobjects of an owned BSONObj.
+         */
+        Document(const BSONObj& bson, const BSONObj& owner);
+
         void swap(Document& rhs) { _storage.swap(rhs._storage); }
 
         /// Look up a field by key name. Returns Value() if no such field. O(1)
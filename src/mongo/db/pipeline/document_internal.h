@@ -208,9 +208,18 @@ namespace mongo {
             return *(_firstElement->plusBytes(pos.index));
         }
         Value& getField(StringData name) {
-            Position pos = findField(name);
+            if (_numFields < HASH_TAB_MIN) { // linear scan, nothing gets hashed
+                Position pos = findField(name);
+                if (!pos.found())
+                    return appendField(name);
+                return getField(pos).val;
+            }
+
+            // hash the name once for both the lookup and a possible append
+            const unsigned hash = hashKey(name);
+            Position pos = findField(name, hash);
             if (!pos.found())
-                return appendField(name); // TODO: find a way to avoid hashing name twice
+                return appendField(name, hash);
             return getField(pos).val;
         }
 
@@ -261,11 +270,17 @@ namespace mongo {
         /// Same as lastElement->next() or firstElement() if empty.
         const ValueElement* end() const { return _firstElement->plusBytes(_usedBytes); }
 
+        /// Hashed findField for use when the table is known to be active
+        Position findField(StringData name, unsigned hash) const;
+
+        /// appendField that reuses a hash computed by the caller
+        Value& appendField(StringData name, unsigned hash);
+
         /// Allocates space in _buffer. Copies existing data if there is any.
         void alloc(unsigned newSize);
 
         /// Call after adding field to _buffer and increasing _numFields
-        void addFieldToHashTable(Position pos);
+        void addFieldToHashTable(Position pos, unsigned hash);
 
         // assumes _hashTabMask is (power of two) - 1
         unsigned hashTabBuckets() const { return _hashTabMask + 1; }
@@ -284,15 +299,11 @@ namespace mongo {
             return out;
         }
 
-        unsigned bucketForKey(StringData name) const {
-            return hashKey(name) & _hashTabMask;
-        }
-
         /// Adds all fields to the hash table
         void rehash() {
             hashTabInit();
             for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance())
-                addFieldToHashTable(it.position());
+                addFieldToHashTable(it.position(), hashKey(it->nameSD()));
         }
 
         enum {
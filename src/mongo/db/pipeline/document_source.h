@@ -484,6 +484,11 @@ namespace mongo {
         /// Spill groups map to disk and returns an iterator to the file.
         shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+        /// Merge several spilled runs into a single bigger run, bounding the number of spill
+        /// files open at once and the fan-in of the final merge.
+        shared_ptr<Sorter<Value, Value>::Iterator> mergeSpilledRuns(
+                const vector<shared_ptr<Sorter<Value, Value>::Iterator> >& runs);
+
         // Only used by spill. Would be function-local if that were legal in C++03.
         class SpillSTLComparator;
 
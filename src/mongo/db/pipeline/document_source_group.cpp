@@ -345,12 +345,131 @@ namespace mongo {
                 return Value::compare(lhs.first, rhs.first);
             }
         };
+
+        // how many spilled runs we accumulate before collapsing them into one
+        const size_t kMaxSpilledRuns = 32;
+
+        /** Whether 'expr' is a plain $$ROOT.<field> path reading the given
+            top level field.  The merger built by getMergeSource() only uses
+            expressions of this shape, which lets populate() read the field
+            straight out of the input document. */
+        bool isTopLevelRootField(const intrusive_ptr<Expression>& expr, const string& field) {
+            const ExpressionFieldPath* efp =
+                dynamic_cast<const ExpressionFieldPath*>(expr.get());
+            if (!efp)
+                return false;
+
+            const FieldPath& path = efp->getFieldPath();
+            return path.getPathLength() == 2
+                && path.getFieldName(0) == "ROOT"
+                && path.getFieldName(1) == field;
+        }
+    }
+
+    namespace {
+        /** Typed staging buffer feeding an Accumulator's batch kernels.
+            Collects a homogeneous numeric run for one accumulator so it can be
+            applied with a single kernel call - a tight loop over a flat array -
+            instead of one boxed process() per value. */
+        class NumericStage {
+        public:
+            NumericStage() : _type(EOO) {}
+
+            /** Stage 'v' for later application.  Returns false - staging
+                nothing - when 'v' is not numeric, doesn't match the type of
+                the values already staged, or the buffer is full; the caller
+                then flushes and either retries or processes 'v' directly. */
+            bool add(const Value& v) {
+                const BSONType t = v.getType();
+                if (t != NumberDouble && t != NumberInt && t != NumberLong)
+                    return false;
+                if (_type == EOO)
+                    _type = t;
+                else if (t != _type)
+                    return false;
+                if (t == NumberDouble) {
+                    if (_doubles.size() >= kMaxStaged)
+                        return false;
+                    _doubles.push_back(v.getDouble());
+                }
+                else {
+                    if (_longs.size() >= kMaxStaged)
+                        return false;
+                    _longs.push_back(t == NumberInt ? v.getInt() : v.getLong());
+                }
+                return true;
+            }
+
+            /** apply and clear anything staged */
+            void flush(Accumulator* acc) {
+                if (_type == EOO)
+                    return;
+                if (!_doubles.empty()) {
+                    acc->processDoubles(&_doubles[0], _doubles.size());
+                    _doubles.clear();
+                }
+                if (!_longs.empty()) {
+                    acc->processLongs(&_longs[0], _longs.size(), _type == NumberInt);
+                    _longs.clear();
+                }
+                _type = EOO;
+            }
+
+        private:
+            static const size_t kMaxStaged = 256;
+
+            BSONType _type; // EOO when nothing is staged
+            vector<double> _doubles;
+            vector<long long> _longs;
+        };
+
+        /** apply every accumulator's staged run and forget the run */
+        void flushStagedRun(vector<NumericStage>* stages, vector<Accumulator*>* accs) {
+            for (size_t i = 0; i < accs->size(); i++)
+                (*stages)[i].flush((*accs)[i]);
+            accs->clear();
+        }
     }
 
     void DocumentSourceGroup::populate() {
         const size_t numAccumulators = vpAccumulatorFactory.size();
         dassert(numAccumulators == vpExpression.size());
 
+        // Staging state for the typed batch kernels: while consecutive inputs
+        // land in the same group, numeric arguments for kernel-capable
+        // accumulators are buffered per accumulator and applied a run at a
+        // time.  Merging input may be non-numeric state documents, so the
+        // whole mechanism is off when merging.
+        vector<NumericStage> stages;
+        vector<char> batchable(numAccumulators, 0);
+        vector<Accumulator*> stagedAccs; // the staged run's accumulators
+        Value stagedId;                  // the staged run's group id
+        bool anyBatchable = false;
+        if (!_doingMerge) {
+            for (size_t i = 0; i < numAccumulators; i++) {
+                batchable[i] = vpAccumulatorFactory[i]()->hasBatchKernels();
+                if (batchable[i])
+                    anyBatchable = true;
+            }
+            if (anyBatchable)
+                stages.resize(numAccumulators);
+        }
+
+        // Combiner fast path for the merge half of a split pipeline: the
+        // merger only evaluates $$ROOT._id and $$ROOT.<field> over the
+        // partial-accumulator documents the shards send back.  Recognize
+        // that shape and read the fields out of each input document
+        // directly, skipping the Variables and Expression machinery per
+        // document - with many shards the mongos merge core spends much of
+        // its time there.
+        bool mergeFastPath = _doingMerge
+            && _idExpressions.size() == 1
+            && isTopLevelRootField(_idExpressions[0], "_id");
+        for (size_t i = 0; mergeFastPath && i < numAccumulators; i++) {
+            if (!isTopLevelRootField(vpExpression[i], vFieldName[i]))
+                mergeFastPath = false;
+        }
+
         // pushed to on spill()
         vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
         int memoryUsageBytes = 0;
@@ -361,14 +480,34 @@ namespace mongo {
                 uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
                                " Pass allowDiskUse:true to opt in.",
                         _extSortAllowed);
+                // staged values must reach their accumulators before the
+                // group states are serialized out
+                flushStagedRun(&stages, &stagedAccs);
                 sortedFiles.push_back(spill());
                 memoryUsageBytes = 0;
+
+                // High cardinality groupings can spill many runs.  Collapse them periodically so
+                // neither the number of open spill files nor the fan-in of the final merge grows
+                // with input size; the intermediate merge is a sequential read of each run and
+                // one sequential write.
+                if (sortedFiles.size() >= kMaxSpilledRuns) {
+                    shared_ptr<Sorter<Value, Value>::Iterator> merged =
+                        mergeSpilledRuns(sortedFiles);
+                    sortedFiles.clear();
+                    sortedFiles.push_back(merged);
+                }
             }
 
-            _variables->setRoot(*input);
+            Value id;
+            if (mergeFastPath) {
+                id = (*input)["_id"];
+            }
+            else {
+                _variables->setRoot(*input);
 
-            /* get the _id value */
-            Value id = computeId(_variables.get());
+                /* get the _id value */
+                id = computeId(_variables.get());
+            }
 
             /* treat missing values the same as NULL SERVER-4674 */
             if (id.missing())
@@ -397,15 +536,43 @@ namespace mongo {
                 }
             }
 
+            if (anyBatchable &&
+                (stagedAccs.empty() || Value::compare(id, stagedId) != 0)) {
+                // run break: this document starts a new run; apply whatever
+                // was staged for the previous group.  Raw Accumulator
+                // pointers stay valid across GroupsMap rehashes (only
+                // spill() destroys them, and it flushes first).
+                flushStagedRun(&stages, &stagedAccs);
+                for (size_t i = 0; i < numAccumulators; i++)
+                    stagedAccs.push_back(group[i].get());
+                stagedId = id;
+            }
+
             /* tickle all the accumulators for the group we found */
             dassert(numAccumulators == group.size());
             for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
+                if (anyBatchable && batchable[i]) {
+                    const Value arg = vpExpression[i]->evaluate(_variables.get());
+                    if (!stages[i].add(arg)) {
+                        // full buffer or a type change: drain and retry (a
+                        // non-numeric value just goes the boxed route)
+                        stages[i].flush(group[i].get());
+                        if (!stages[i].add(arg))
+                            group[i]->process(arg, _doingMerge);
+                    }
+                }
+                else if (mergeFastPath) {
+                    group[i]->process((*input)[vFieldName[i]], /*merging=*/true);
+                }
+                else {
+                    group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
+                }
                 memoryUsageBytes += group[i]->memUsageForSorter();
             }
 
             // We are done with the ROOT document so release it.
-            _variables->clearRoot();
+            if (!mergeFastPath)
+                _variables->clearRoot();
 
             DEV {
                 // In debug mode, spill every time we have a duplicate id to stress merge logic.
@@ -414,11 +581,15 @@ namespace mongo {
                         && !_extSortAllowed // don't change behavior when testing external sort
                         && sortedFiles.size() < 20 // don't open too many FDs
                         ) {
+                    flushStagedRun(&stages, &stagedAccs);
                     sortedFiles.push_back(spill());
                 }
             }
         }
 
+        // apply the last staged run
+        flushStagedRun(&stages, &stagedAccs);
+
         // These blocks do any final steps necessary to prepare to output results.
         if (!sortedFiles.empty()) {
             _spilled = true;
@@ -496,6 +667,22 @@ namespace mongo {
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
 
+    shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::mergeSpilledRuns(
+            const vector<shared_ptr<Sorter<Value, Value>::Iterator> >& runs) {
+        scoped_ptr<Sorter<Value, Value>::Iterator> merged(
+                Sorter<Value, Value>::Iterator::merge(runs, SortOptions(), SorterComparator()));
+
+        // Same-id entries from different runs stay adjacent in the output; they are combined
+        // later by getNextSpilled(), not here.
+        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
+        while (merged->more()) {
+            pair<Value, Value> data = merged->next();
+            writer.addAlreadySorted(data.first, data.second);
+        }
+
+        return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
+    }
+
     void DocumentSourceGroup::parseIdExpression(BSONElement groupField,
                                                 const VariablesParseState& vps) {
         if (groupField.type() == Object && !groupField.Obj().isEmpty()) {
@@ -147,23 +147,41 @@ namespace mongo {
         if (_unstarted)
             start();
 
-        // purge eof cursors and release their connections
-        while (!_cursors.empty() && !(*_currentCursor)->cursor.more()) {
+        while (!_cursors.empty()) {
+            // Prefer a cursor with results already buffered locally: blocking
+            // in getMore on one shard while other shards' batches sit in our
+            // receive buffers would pace the whole merge on the slowest
+            // shard.  We still rotate between buffered cursors so no shard's
+            // stream is starved.
+            bool buffered = false;
+            for (size_t n = 0; n < _cursors.size(); n++) {
+                if ((*_currentCursor)->cursor.moreInCurrentBatch()) {
+                    buffered = true;
+                    break;
+                }
+                if (++_currentCursor == _cursors.end())
+                    _currentCursor = _cursors.begin();
+            }
+
+            // when nothing is buffered anywhere, more() blocks in a getMore
+            // on _currentCursor (and notices eof)
+            if (buffered || (*_currentCursor)->cursor.more()) {
+                const Document next = nextSafeFrom(&((*_currentCursor)->cursor));
+
+                // advance _currentCursor, wrapping if needed
+                if (++_currentCursor == _cursors.end())
+                    _currentCursor = _cursors.begin();
+
+                return next;
+            }
+
+            // this cursor is done; release its connection
             (*_currentCursor)->connection.done();
             _cursors.erase(_currentCursor);
             _currentCursor = _cursors.begin();
         }
 
-        if (_cursors.empty())
-            return boost::none;
-
-        const Document next = nextSafeFrom(&((*_currentCursor)->cursor));
-
-        // advance _currentCursor, wrapping if needed
-        if (++_currentCursor == _cursors.end())
-            _currentCursor = _cursors.begin();
-
-        return next;
+        return boost::none;
     }
 
     void DocumentSourceMergeCursors::dispose() {
@@ -40,6 +40,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/expression_program.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/util/string_map.h"
 #include "mongo/util/mongoutils/str.h"
@@ -373,67 +374,73 @@ namespace {
 
     /* ------------------------- ExpressionAdd ----------------------------- */
 
-    Value ExpressionAdd::evaluateInternal(Variables* vars) const {
-
-        /*
-          We'll try to return the narrowest possible result value.  To do that
-          without creating intermediate Values, do the arithmetic for double
-          and integral types in parallel, tracking the current narrowest
-          type.
-         */
-        double doubleTotal = 0;
-        long long longTotal = 0;
-        BSONType totalType = NumberInt;
-        bool haveDate = false;
-
-        const size_t n = vpOperand.size();
-        for (size_t i = 0; i < n; ++i) {
-            Value val = vpOperand[i]->evaluateInternal(vars);
+    ExpressionAdd::Sum::Sum()
+        : _doubleTotal(0)
+        , _longTotal(0)
+        , _totalType(NumberInt)
+        , _haveDate(false)
+    {}
 
-            if (val.numeric()) {
-                totalType = Value::getWidestNumeric(totalType, val.getType());
+    bool ExpressionAdd::Sum::accumulate(const Value& val) {
+        if (val.numeric()) {
+            _totalType = Value::getWidestNumeric(_totalType, val.getType());
 
-                doubleTotal += val.coerceToDouble();
-                longTotal += val.coerceToLong();
-            }
-            else if (val.getType() == Date) {
-                uassert(16612, "only one Date allowed in an $add expression",
-                        !haveDate);
-                haveDate = true;
+            _doubleTotal += val.coerceToDouble();
+            _longTotal += val.coerceToLong();
+        }
+        else if (val.getType() == Date) {
+            uassert(16612, "only one Date allowed in an $add expression",
+                    !_haveDate);
+            _haveDate = true;
 
-                // We don't manipulate totalType here.
+            // We don't manipulate _totalType here.
 
-                longTotal += val.getDate();
-                doubleTotal += val.getDate();
-            }
-            else if (val.nullish()) {
-                return Value(BSONNULL);
-            }
-            else {
-                uasserted(16554, str::stream() << "$add only supports numeric or date types, not "
-                                               << typeName(val.getType()));
-            }
+            _longTotal += val.getDate();
+            _doubleTotal += val.getDate();
         }
+        else if (val.nullish()) {
+            return false;
+        }
+        else {
+            uasserted(16554, str::stream() << "$add only supports numeric or date types, not "
+                                           << typeName(val.getType()));
+        }
+        return true;
+    }
 
-        if (haveDate) {
-            if (totalType == NumberDouble)
-                longTotal = static_cast<long long>(doubleTotal);
+    Value ExpressionAdd::Sum::getValue() const {
+        if (_haveDate) {
+            long long longTotal = _longTotal;
+            if (_totalType == NumberDouble)
+                longTotal = static_cast<long long>(_doubleTotal);
             return Value(Date_t(longTotal));
         }
-        else if (totalType == NumberLong) {
-            return Value(longTotal);
+        else if (_totalType == NumberLong) {
+            return Value(_longTotal);
         }
-        else if (totalType == NumberDouble) {
-            return Value(doubleTotal);
+        else if (_totalType == NumberDouble) {
+            return Value(_doubleTotal);
         }
-        else if (totalType == NumberInt) {
-            return Value::createIntOrLong(longTotal);
+        else if (_totalType == NumberInt) {
+            return Value::createIntOrLong(_longTotal);
         }
         else {
             massert(16417, "$add resulted in a non-numeric type", false);
         }
     }
 
+    Value ExpressionAdd::evaluateInternal(Variables* vars) const {
+        Sum sum;
+
+        const size_t n = vpOperand.size();
+        for (size_t i = 0; i < n; ++i) {
+            if (!sum.accumulate(vpOperand[i]->evaluateInternal(vars)))
+                return Value(BSONNULL);
+        }
+
+        return sum.getValue();
+    }
+
     REGISTER_EXPRESSION("$add", ExpressionAdd::parse);
     const char *ExpressionAdd::getOpName() const {
         return "$add";
@@ -663,6 +670,10 @@ namespace {
         Value pLeft(vpOperand[0]->evaluateInternal(vars));
         Value pRight(vpOperand[1]->evaluateInternal(vars));
 
+        return doComparison(cmpOp, pLeft, pRight);
+    }
+
+    Value ExpressionCompare::doComparison(CmpOp cmpOp, const Value& pLeft, const Value& pRight) {
         int cmp = Value::compare(pLeft, pRight);
 
         // Make cmp one of 1, 0, or -1.
@@ -690,7 +701,11 @@ namespace {
     Value ExpressionConcat::evaluateInternal(Variables* vars) const {
         const size_t n = vpOperand.size();
 
-        StringBuilder result;
+        // Evaluate all the operands first, then let Value::concat size and
+        // materialize the result in one pass instead of growing a builder and
+        // copying the accumulated string into the Value at the end.
+        vector<Value> vals;
+        vals.reserve(n);
         for (size_t i = 0; i < n; ++i) {
             Value val = vpOperand[i]->evaluateInternal(vars);
             if (val.nullish())
@@ -700,10 +715,10 @@ namespace {
                                          << typeName(val.getType()),
                     val.getType() == String);
 
-            result << val.coerceToString();
+            vals.push_back(val);
         }
 
-        return Value(result.str());
+        return Value::concat(vals);
     }
 
     REGISTER_EXPRESSION("$concat", ExpressionConcat::parse);
@@ -845,6 +860,10 @@ namespace {
         Value lhs = vpOperand[0]->evaluateInternal(vars);
         Value rhs = vpOperand[1]->evaluateInternal(vars);
 
+        return divideValues(lhs, rhs);
+    }
+
+    Value ExpressionDivide::divideValues(const Value& lhs, const Value& rhs) {
         if (lhs.numeric() && rhs.numeric()) {
             double numer = lhs.coerceToDouble();
             double denom = rhs.coerceToDouble();
@@ -886,8 +905,12 @@ namespace {
 
     intrusive_ptr<Expression> ExpressionObject::optimize() {
         for (FieldMap::iterator it(_expressions.begin()); it!=_expressions.end(); ++it) {
-            if (it->second)
-                it->second = it->second->optimize();
+            if (it->second) {
+                // After tree-level optimization, try to flatten each computed field
+                // into a linear program; fields whose trees use operators the
+                // compiler doesn't support keep the tree interpreter unchanged.
+                it->second = ExpressionFlattened::flatten(it->second->optimize());
+            }
         }
 
         return intrusive_ptr<Expression>(this);
@@ -1564,6 +1587,10 @@ namespace {
         Value lhs = vpOperand[0]->evaluateInternal(vars);
         Value rhs = vpOperand[1]->evaluateInternal(vars);
 
+        return modValues(lhs, rhs);
+    }
+
+    Value ExpressionMod::modValues(const Value& lhs, const Value& rhs) {
         BSONType leftType = lhs.getType();
         BSONType rightType = rhs.getType();
 
@@ -1626,44 +1653,56 @@ namespace {
 
     /* ------------------------- ExpressionMultiply ----------------------------- */
 
+    ExpressionMultiply::Product::Product()
+        : _doubleProduct(1)
+        , _longProduct(1)
+        , _productType(NumberInt)
+    {}
+
+    bool ExpressionMultiply::Product::accumulate(const Value& val) {
+        if (val.numeric()) {
+            _productType = Value::getWidestNumeric(_productType, val.getType());
+
+            _doubleProduct *= val.coerceToDouble();
+            _longProduct *= val.coerceToLong();
+        }
+        else if (val.nullish()) {
+            return false;
+        }
+        else {
+            uasserted(16555, str::stream() << "$multiply only supports numeric types, not "
+                                           << typeName(val.getType()));
+        }
+        return true;
+    }
+
+    Value ExpressionMultiply::Product::getValue() const {
+        if (_productType == NumberDouble)
+            return Value(_doubleProduct);
+        else if (_productType == NumberLong)
+            return Value(_longProduct);
+        else if (_productType == NumberInt)
+            return Value::createIntOrLong(_longProduct);
+        else
+            massert(16418, "$multiply resulted in a non-numeric type", false);
+    }
+
     Value ExpressionMultiply::evaluateInternal(Variables* vars) const {
         /*
           We'll try to return the narrowest possible result value.  To do that
-          without creating intermediate Values, do the arithmetic for double
-          and integral types in parallel, tracking the current narrowest
-          type.
+          without creating intermediate Values, the accumulator does the
+          arithmetic for double and integral types in parallel, tracking the
+          current narrowest type.
          */
-        double doubleProduct = 1;
-        long long longProduct = 1;
-        BSONType productType = NumberInt;
+        Product product;
 
         const size_t n = vpOperand.size();
         for(size_t i = 0; i < n; ++i) {
-            Value val = vpOperand[i]->evaluateInternal(vars);
-
-            if (val.numeric()) {
-                productType = Value::getWidestNumeric(productType, val.getType());
-
-                doubleProduct *= val.coerceToDouble();
-                longProduct *= val.coerceToLong();
-            }
-            else if (val.nullish()) {
+            if (!product.accumulate(vpOperand[i]->evaluateInternal(vars)))
                 return Value(BSONNULL);
-            }
-            else {
-                uasserted(16555, str::stream() << "$multiply only supports numeric types, not "
-                                               << typeName(val.getType()));
-            }
         }
 
-        if (productType == NumberDouble)
-            return Value(doubleProduct);
-        else if (productType == NumberLong)
-            return Value(longProduct);
-        else if (productType == NumberInt)
-            return Value::createIntOrLong(longProduct);
-        else
-            massert(16418, "$multiply resulted in a non-numeric type", false);
+        return product.getValue();
     }
 
     REGISTER_EXPRESSION("$multiply", ExpressionMultiply::parse);
@@ -2218,7 +2257,11 @@ namespace {
     Value ExpressionSubtract::evaluateInternal(Variables* vars) const {
         Value lhs = vpOperand[0]->evaluateInternal(vars);
         Value rhs = vpOperand[1]->evaluateInternal(vars);
-            
+
+        return subtractValues(lhs, rhs);
+    }
+
+    Value ExpressionSubtract::subtractValues(const Value& lhs, const Value& rhs) {
         BSONType diffType = Value::getWidestNumeric(rhs.getType(), lhs.getType());
 
         if (diffType == NumberDouble) {
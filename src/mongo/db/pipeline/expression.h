@@ -302,6 +302,9 @@ namespace mongo {
         */
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
+        /// The operands, in order.  Used by ExpressionProgram's compiler.
+        const ExpressionVector& getOperands() const { return vpOperand; }
+
         // TODO split this into two functions
         virtual bool isAssociativeAndCommutative() const { return false; }
 
@@ -366,6 +369,31 @@ namespace mongo {
         virtual Value evaluateInternal(Variables* vars) const;
         virtual const char *getOpName() const;
         virtual bool isAssociativeAndCommutative() const { return true; }
+
+        /** Streaming accumulator for $add, used by evaluateInternal() and by
+         *  ExpressionProgram's flattened evaluator.  To return the narrowest
+         *  possible result without creating intermediate Values, it does the
+         *  arithmetic for double and integral types in parallel, tracking the
+         *  current narrowest type.
+         */
+        class Sum {
+        public:
+            Sum();
+
+            /** Add one operand value to the total.
+             *  @returns false if the value was nullish, making the overall result null.
+             */
+            bool accumulate(const Value& val);
+
+            /// The total of the accumulated values.
+            Value getValue() const;
+
+        private:
+            double _doubleTotal;
+            long long _longTotal;
+            BSONType _totalType;
+            bool _haveDate;
+        };
     };
 
 
@@ -441,6 +469,11 @@ namespace mongo {
 
         ExpressionCompare(CmpOp cmpOp);
 
+        /// Compare two already evaluated operand values with the given operator.
+        static Value doComparison(CmpOp cmpOp, const Value& lhs, const Value& rhs);
+
+        CmpOp getOp() const { return cmpOp; }
+
     private:
         CmpOp cmpOp;
     };
@@ -524,6 +557,9 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual Value evaluateInternal(Variables* vars) const;
         virtual const char *getOpName() const;
+
+        /// $divide on already evaluated operand values.
+        static Value divideValues(const Value& lhs, const Value& rhs);
     };
 
 
@@ -689,8 +725,11 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual Value evaluateInternal(Variables* vars) const;
         virtual const char *getOpName() const;
+
+        /// $mod on already evaluated operand values.
+        static Value modValues(const Value& lhs, const Value& rhs);
     };
-    
+
 
     class ExpressionMultiply : public ExpressionVariadic<ExpressionMultiply> {
     public:
@@ -698,6 +737,27 @@ namespace mongo {
         virtual Value evaluateInternal(Variables* vars) const;
         virtual const char *getOpName() const;
         virtual bool isAssociativeAndCommutative() const { return true; }
+
+        /** Streaming accumulator for $multiply; the counterpart of
+         *  ExpressionAdd::Sum.
+         */
+        class Product {
+        public:
+            Product();
+
+            /** Multiply one operand value into the product.
+             *  @returns false if the value was nullish, making the overall result null.
+             */
+            bool accumulate(const Value& val);
+
+            /// The product of the accumulated values.
+            Value getValue() const;
+
+        private:
+            double _doubleProduct;
+            long long _longProduct;
+            BSONType _productType;
+        };
     };
 
 
@@ -921,6 +981,9 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual Value evaluateInternal(Variables* vars) const;
         virtual const char *getOpName() const;
+
+        /// $subtract on already evaluated operand values.
+        static Value subtractValues(const Value& lhs, const Value& rhs);
     };
 
 
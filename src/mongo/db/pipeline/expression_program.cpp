@@ -0,0 +1,396 @@
+/**
+ * Copyright (c) 2013 10gen Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/expression_program.h"
+
+#include <map>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+namespace {
+
+    /**
+     * Key a subexpression by the exact BSON bytes of its serialization.  Value
+     * ordering can't be used here: it compares numerics of different types as
+     * equal, which would conflate e.g. {$const: 1} with {$const: 1.0}.
+     */
+    std::string serializedKey(const intrusive_ptr<Expression>& expr) {
+        BSONObjBuilder bob;
+        expr->serialize(false).addToBsonObj(&bob, "");
+        BSONObj obj = bob.obj();
+        return std::string(obj.objdata(), obj.objsize());
+    }
+
+}
+
+    /**
+     * Walks an Expression tree and emits the flattened program.
+     *
+     * Common subexpression elimination: identical subtrees (keyed by their
+     * serialization) are compiled once and later occurrences reuse the register.
+     * The table is only consulted and updated outside of conditionally executed
+     * regions ($cond branches, the short-circuited operands of $and/$or/$ifNull),
+     * since a register written there may not hold a value on every path.  All
+     * expressions reachable here are pure, so reuse is safe.
+     */
+    class ExpressionProgram::Builder {
+    public:
+        Builder() : _numRegisters(0), _conditionalDepth(0), _sawSupportedOp(false) {}
+
+        intrusive_ptr<ExpressionProgram> build(const intrusive_ptr<Expression>& expr) {
+            const int resultRegister = compileNode(expr);
+            if (!_sawSupportedOp) {
+                // Nothing but CallNode (and possibly constant loads); running the
+                // tree interpreter directly is no slower.
+                return NULL;
+            }
+            return new ExpressionProgram(_instructions, _constants, _nodes,
+                                         _numRegisters, resultRegister);
+        }
+
+    private:
+        int newRegister() { return _numRegisters++; }
+
+        int addConstant(const Value& value) {
+            _constants.push_back(value);
+            return _constants.size() - 1;
+        }
+
+        size_t emit(OpCode op, int dest = -1, int lhs = -1, int rhs = -1, int imm = -1) {
+            _instructions.push_back(Instruction(op, dest, lhs, rhs, imm));
+            return _instructions.size() - 1;
+        }
+
+        /// Point a previously emitted jump at the next instruction to be emitted.
+        void patchJumpToHere(size_t jumpIndex) {
+            _instructions[jumpIndex].rhs = _instructions.size();
+        }
+
+        /// Compile 'expr' and return the register its value ends up in.
+        int compileNode(const intrusive_ptr<Expression>& expr) {
+            const bool cacheable = (_conditionalDepth == 0);
+            std::string key;
+            if (cacheable) {
+                key = serializedKey(expr);
+                std::map<std::string, int>::const_iterator it = _cse.find(key);
+                if (it != _cse.end())
+                    return it->second;
+            }
+
+            const int reg = compileNewNode(expr);
+
+            if (cacheable)
+                _cse[key] = reg;
+            return reg;
+        }
+
+        int compileNewNode(const intrusive_ptr<Expression>& expr) {
+            Expression* node = expr.get();
+
+            if (ExpressionConstant* constant = dynamic_cast<ExpressionConstant*>(node)) {
+                const int reg = newRegister();
+                emit(LoadConstant, reg, addConstant(constant->getValue()));
+                return reg;
+            }
+
+            if (ExpressionAdd* add = dynamic_cast<ExpressionAdd*>(node))
+                return compileVariadic(AddN, add->getOperands());
+
+            if (ExpressionMultiply* multiply = dynamic_cast<ExpressionMultiply*>(node))
+                return compileVariadic(MultiplyN, multiply->getOperands());
+
+            if (ExpressionSubtract* subtract = dynamic_cast<ExpressionSubtract*>(node))
+                return compileBinary(SubtractOp, subtract->getOperands());
+
+            if (ExpressionDivide* divide = dynamic_cast<ExpressionDivide*>(node))
+                return compileBinary(DivideOp, divide->getOperands());
+
+            if (ExpressionMod* mod = dynamic_cast<ExpressionMod*>(node))
+                return compileBinary(ModOp, mod->getOperands());
+
+            if (ExpressionCompare* compare = dynamic_cast<ExpressionCompare*>(node)) {
+                const std::vector<intrusive_ptr<Expression> >& operands = compare->getOperands();
+                const int lhs = compileNode(operands[0]);
+                const int rhs = compileNode(operands[1]);
+                const int reg = newRegister();
+                emit(CompareOp, reg, lhs, rhs, compare->getOp());
+                _sawSupportedOp = true;
+                return reg;
+            }
+
+            if (ExpressionNot* notExpr = dynamic_cast<ExpressionNot*>(node)) {
+                const int operand = compileNode(notExpr->getOperands()[0]);
+                const int reg = newRegister();
+                emit(NotOp, reg, operand);
+                _sawSupportedOp = true;
+                return reg;
+            }
+
+            if (ExpressionAnd* andExpr = dynamic_cast<ExpressionAnd*>(node))
+                return compileShortCircuit(JumpIfFalse, andExpr->getOperands());
+
+            if (ExpressionOr* orExpr = dynamic_cast<ExpressionOr*>(node))
+                return compileShortCircuit(JumpIfTrue, orExpr->getOperands());
+
+            if (ExpressionCond* cond = dynamic_cast<ExpressionCond*>(node))
+                return compileCond(cond->getOperands());
+
+            if (ExpressionIfNull* ifNull = dynamic_cast<ExpressionIfNull*>(node))
+                return compileIfNull(ifNull->getOperands());
+
+            // Anything else -- field paths included -- is evaluated by the tree
+            // interpreter.  Field paths still benefit from the CSE table: repeated
+            // uses of "$a.b" in one expression become a single CallNode.
+            const int reg = newRegister();
+            _nodes.push_back(expr);
+            emit(CallNode, reg, _nodes.size() - 1);
+            return reg;
+        }
+
+        int compileVariadic(OpCode op, const std::vector<intrusive_ptr<Expression> >& operands) {
+            std::vector<int> operandRegisters;
+            operandRegisters.reserve(operands.size());
+            for (size_t i = 0; i < operands.size(); ++i)
+                operandRegisters.push_back(compileNode(operands[i]));
+
+            const int reg = newRegister();
+            const size_t index = emit(op, reg);
+            _instructions[index].operands.swap(operandRegisters);
+            _sawSupportedOp = true;
+            return reg;
+        }
+
+        int compileBinary(OpCode op, const std::vector<intrusive_ptr<Expression> >& operands) {
+            const int lhs = compileNode(operands[0]);
+            const int rhs = compileNode(operands[1]);
+            const int reg = newRegister();
+            emit(op, reg, lhs, rhs);
+            _sawSupportedOp = true;
+            return reg;
+        }
+
+        /**
+         * $and / $or.  'bailOp' is the jump taken when an operand decides the
+         * result (JumpIfFalse for $and, JumpIfTrue for $or).  Operands after the
+         * first are conditionally executed, matching the tree interpreter's
+         * short-circuiting.
+         */
+        int compileShortCircuit(OpCode bailOp, const std::vector<intrusive_ptr<Expression> >& operands) {
+            const bool decided = (bailOp == JumpIfTrue);  // result if a jump is taken
+
+            const int dest = newRegister();
+            std::vector<size_t> bailJumps;
+            for (size_t i = 0; i < operands.size(); ++i) {
+                if (i == 1)
+                    ++_conditionalDepth;
+                bailJumps.push_back(emit(bailOp, -1, compileNode(operands[i])));
+            }
+            if (operands.size() > 1)
+                --_conditionalDepth;
+
+            emit(LoadConstant, dest, addConstant(Value(!decided)));
+            const size_t endJump = emit(Jump);
+            for (size_t i = 0; i < bailJumps.size(); ++i)
+                patchJumpToHere(bailJumps[i]);
+            emit(LoadConstant, dest, addConstant(Value(decided)));
+            patchJumpToHere(endJump);
+
+            _sawSupportedOp = true;
+            return dest;
+        }
+
+        int compileCond(const std::vector<intrusive_ptr<Expression> >& operands) {
+            const int dest = newRegister();
+            const size_t elseJump = emit(JumpIfFalse, -1, compileNode(operands[0]));
+
+            ++_conditionalDepth;
+            emit(Move, dest, compileNode(operands[1]));
+            const size_t endJump = emit(Jump);
+            patchJumpToHere(elseJump);
+            emit(Move, dest, compileNode(operands[2]));
+            --_conditionalDepth;
+
+            patchJumpToHere(endJump);
+            _sawSupportedOp = true;
+            return dest;
+        }
+
+        int compileIfNull(const std::vector<intrusive_ptr<Expression> >& operands) {
+            const int dest = newRegister();
+            emit(Move, dest, compileNode(operands[0]));
+            const size_t endJump = emit(JumpIfNotNullish, -1, dest);
+
+            ++_conditionalDepth;
+            emit(Move, dest, compileNode(operands[1]));
+            --_conditionalDepth;
+
+            patchJumpToHere(endJump);
+            _sawSupportedOp = true;
+            return dest;
+        }
+
+        std::vector<Instruction> _instructions;
+        std::vector<Value> _constants;
+        std::vector<intrusive_ptr<Expression> > _nodes;
+        std::map<std::string, int> _cse;
+        int _numRegisters;
+        int _conditionalDepth;
+        bool _sawSupportedOp;
+    };
+
+    intrusive_ptr<ExpressionProgram> ExpressionProgram::compile(
+            const intrusive_ptr<Expression>& expr) {
+        Builder builder;
+        return builder.build(expr);
+    }
+
+    ExpressionProgram::ExpressionProgram(
+            const std::vector<Instruction>& instructions,
+            const std::vector<Value>& constants,
+            const std::vector<intrusive_ptr<Expression> >& nodes,
+            int numRegisters,
+            int resultRegister)
+        : _instructions(instructions)
+        , _constants(constants)
+        , _nodes(nodes)
+        , _numRegisters(numRegisters)
+        , _resultRegister(resultRegister)
+        , _registers(numRegisters)
+    {}
+
+    Value ExpressionProgram::evaluate(Variables* vars) const {
+        std::vector<Value>& regs = _registers;
+        const size_t numInsns = _instructions.size();
+
+        size_t ip = 0;
+        while (ip < numInsns) {
+            const Instruction& insn = _instructions[ip];
+            size_t next = ip + 1;
+
+            switch (insn.op) {
+            case LoadConstant:
+                regs[insn.dest] = _constants[insn.lhs];
+                break;
+
+            case CallNode:
+                regs[insn.dest] = _nodes[insn.lhs]->evaluate(vars);
+                break;
+
+            case Move:
+                regs[insn.dest] = regs[insn.lhs];
+                break;
+
+            case AddN: {
+                ExpressionAdd::Sum sum;
+                bool sawNullish = false;
+                for (size_t i = 0; i < insn.operands.size(); ++i) {
+                    if (!sum.accumulate(regs[insn.operands[i]])) {
+                        sawNullish = true;
+                        break;
+                    }
+                }
+                regs[insn.dest] = sawNullish ? Value(BSONNULL) : sum.getValue();
+                break;
+            }
+
+            case MultiplyN: {
+                ExpressionMultiply::Product product;
+                bool sawNullish = false;
+                for (size_t i = 0; i < insn.operands.size(); ++i) {
+                    if (!product.accumulate(regs[insn.operands[i]])) {
+                        sawNullish = true;
+                        break;
+                    }
+                }
+                regs[insn.dest] = sawNullish ? Value(BSONNULL) : product.getValue();
+                break;
+            }
+
+            case SubtractOp:
+                regs[insn.dest] = ExpressionSubtract::subtractValues(regs[insn.lhs],
+                                                                     regs[insn.rhs]);
+                break;
+
+            case DivideOp:
+                regs[insn.dest] = ExpressionDivide::divideValues(regs[insn.lhs],
+                                                                 regs[insn.rhs]);
+                break;
+
+            case ModOp:
+                regs[insn.dest] = ExpressionMod::modValues(regs[insn.lhs], regs[insn.rhs]);
+                break;
+
+            case CompareOp:
+                regs[insn.dest] = ExpressionCompare::doComparison(
+                        static_cast<ExpressionCompare::CmpOp>(insn.imm),
+                        regs[insn.lhs], regs[insn.rhs]);
+                break;
+
+            case NotOp:
+                regs[insn.dest] = Value(!regs[insn.lhs].coerceToBool());
+                break;
+
+            case Jump:
+                next = insn.rhs;
+                break;
+
+            case JumpIfFalse:
+                if (!regs[insn.lhs].coerceToBool())
+                    next = insn.rhs;
+                break;
+
+            case JumpIfTrue:
+                if (regs[insn.lhs].coerceToBool())
+                    next = insn.rhs;
+                break;
+
+            case JumpIfNotNullish:
+                if (!regs[insn.lhs].nullish())
+                    next = insn.rhs;
+                break;
+            }
+
+            ip = next;
+        }
+
+        return regs[_resultRegister];
+    }
+
+    intrusive_ptr<Expression> ExpressionFlattened::flatten(
+            const intrusive_ptr<Expression>& expr) {
+        intrusive_ptr<ExpressionProgram> program = ExpressionProgram::compile(expr);
+        if (!program)
+            return expr;
+        return new ExpressionFlattened(expr, program);
+    }
+
+}
@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2013 10gen Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/util/intrusive_counter.h"
+
+namespace mongo {
+
+    /**
+     * A flattened, linear form of an Expression tree.
+     *
+     * compile() walks a tree and produces a program over a register file of Value
+     * slots: constants are loaded into registers, duplicated subtrees are computed
+     * once (common subexpression elimination), and the supported arithmetic,
+     * comparison and conditional operators run in a tight switch loop instead of
+     * recursive virtual dispatch.  Subtrees rooted at operators the compiler
+     * doesn't know about become single instructions that call back into the tree
+     * interpreter, so a program always produces exactly the same results -- and
+     * the same uasserts -- as the tree it was built from.  Short-circuiting
+     * operators ($and, $or, $cond, $ifNull) compile to conditional jumps, so
+     * operands the tree interpreter would not evaluate are not evaluated here
+     * either.
+     *
+     * A program reuses its register file between evaluations, so it must only be
+     * used by one thread at a time, like the DocumentSources that own the
+     * expressions it is built from.
+     */
+    class ExpressionProgram : public IntrusiveCounterUnsigned {
+    public:
+        /**
+         * Compiles 'expr', which should already be optimize()d.  Returns NULL when
+         * flattening would not help because the root of the tree is not one of the
+         * supported operators.
+         */
+        static intrusive_ptr<ExpressionProgram> compile(
+            const intrusive_ptr<Expression>& expr);
+
+        /// Run the program against one document; equivalent to expr->evaluate(vars).
+        Value evaluate(Variables* vars) const;
+
+        /// Exposed for testing.
+        size_t numInstructions() const { return _instructions.size(); }
+        size_t numRegisters() const { return _numRegisters; }
+
+    private:
+        enum OpCode {
+            LoadConstant,      // reg[dest] = constants[lhs]
+            CallNode,          // reg[dest] = nodes[lhs]->evaluate(vars)
+            Move,              // reg[dest] = reg[lhs]
+            AddN,              // reg[dest] = $add of reg[operands...]
+            MultiplyN,         // reg[dest] = $multiply of reg[operands...]
+            SubtractOp,        // reg[dest] = reg[lhs] $subtract reg[rhs]
+            DivideOp,          // reg[dest] = reg[lhs] $divide reg[rhs]
+            ModOp,             // reg[dest] = reg[lhs] $mod reg[rhs]
+            CompareOp,         // reg[dest] = comparison 'imm' of reg[lhs], reg[rhs]
+            NotOp,             // reg[dest] = !coerceToBool(reg[lhs])
+            Jump,              // goto instruction rhs
+            JumpIfFalse,       // if (!coerceToBool(reg[lhs])) goto rhs
+            JumpIfTrue,        // if (coerceToBool(reg[lhs])) goto rhs
+            JumpIfNotNullish,  // if (!reg[lhs].nullish()) goto rhs
+        };
+
+        struct Instruction {
+            Instruction(OpCode op, int dest, int lhs, int rhs, int imm)
+                : op(op), dest(dest), lhs(lhs), rhs(rhs), imm(imm) {}
+
+            OpCode op;
+            int dest;
+            int lhs;
+            int rhs;
+            int imm;
+            std::vector<int> operands; // inputs for the variadic opcodes
+        };
+
+        /// Does the tree walk; defined in the .cpp file.
+        class Builder;
+        friend class Builder;
+
+        ExpressionProgram(const std::vector<Instruction>& instructions,
+                          const std::vector<Value>& constants,
+                          const std::vector<intrusive_ptr<Expression> >& nodes,
+                          int numRegisters,
+                          int resultRegister);
+
+        const std::vector<Instruction> _instructions;
+        const std::vector<Value> _constants;
+
+        // Subtrees evaluated by the tree interpreter via CallNode (field paths and
+        // unsupported operators).
+        const std::vector<intrusive_ptr<Expression> > _nodes;
+
+        const int _numRegisters;
+        const int _resultRegister;
+
+        // Scratch space reused across evaluations; see the thread-safety note above.
+        mutable std::vector<Value> _registers;
+    };
+
+    /**
+     * Expression that evaluates by running a flattened ExpressionProgram, standing
+     * in for the tree the program was compiled from.  Everything except evaluation
+     * (serialization, dependency analysis) is forwarded to the original tree, so
+     * wrapping is invisible outside of evaluate().
+     */
+    class ExpressionFlattened : public Expression {
+    public:
+        /**
+         * Returns 'expr' wrapped together with its compiled program, or 'expr'
+         * itself when the compiler reports that flattening would not help.
+         */
+        static intrusive_ptr<Expression> flatten(const intrusive_ptr<Expression>& expr);
+
+        // virtuals from Expression
+        virtual intrusive_ptr<Expression> optimize() { return this; }
+        virtual void addDependencies(DepsTracker* deps, vector<string>* path=NULL) const {
+            _original->addDependencies(deps, path);
+        }
+        virtual bool isSimple() { return _original->isSimple(); }
+        virtual Value serialize(bool explain) const { return _original->serialize(explain); }
+        virtual Value evaluateInternal(Variables* vars) const {
+            return _program->evaluate(vars);
+        }
+
+    private:
+        ExpressionFlattened(const intrusive_ptr<Expression>& original,
+                            const intrusive_ptr<ExpressionProgram>& program)
+            : _original(original), _program(program) {}
+
+        intrusive_ptr<Expression> _original;
+        intrusive_ptr<ExpressionProgram> _program;
+    };
+
+}
@@ -211,7 +211,7 @@ namespace mongo {
         // The order in which optimizations are applied can have significant impact on the
         // efficiency of the final pipeline. Be Careful!
         Optimizations::Local::moveMatchBeforeSort(pPipeline.get());
-        Optimizations::Local::moveLimitBeforeSkip(pPipeline.get());
+        Optimizations::Local::moveLimitBeforeSkipAndProject(pPipeline.get());
         Optimizations::Local::coalesceAdjacent(pPipeline.get());
         Optimizations::Local::optimizeEachDocumentSource(pPipeline.get());
         Optimizations::Local::duplicateMatchBeforeInitalRedact(pPipeline.get());
@@ -220,7 +220,8 @@ namespace mongo {
     }
 
     void Pipeline::Optimizations::Local::moveMatchBeforeSort(Pipeline* pipeline) {
-        // TODO Keep moving matches across multiple sorts as moveLimitBeforeSkip does below.
+        // TODO Keep moving matches across multiple sorts as moveLimitBeforeSkipAndProject does
+        // below.
         // TODO Check sort for limit. Not an issue currently due to order optimizations are applied,
         // but should be fixed.
         SourceContainer& sources = pipeline->sources;
@@ -239,7 +240,7 @@ namespace mongo {
         }
     }
 
-    void Pipeline::Optimizations::Local::moveLimitBeforeSkip(Pipeline* pipeline) {
+    void Pipeline::Optimizations::Local::moveLimitBeforeSkipAndProject(Pipeline* pipeline) {
         SourceContainer& sources = pipeline->sources;
         if (sources.empty())
             return;
@@ -247,26 +248,38 @@ namespace mongo {
         for(int i = sources.size() - 1; i >= 1 /* not looking at 0 */; i--) {
             DocumentSourceLimit* limit =
                 dynamic_cast<DocumentSourceLimit*>(sources[i].get());
+            if (!limit)
+                continue;
+
             DocumentSourceSkip* skip =
                 dynamic_cast<DocumentSourceSkip*>(sources[i-1].get());
-            if (limit && skip) {
+            DocumentSourceProject* project =
+                dynamic_cast<DocumentSourceProject*>(sources[i-1].get());
+
+            if (skip) {
                 // Increase limit by skip since the skipped docs now pass through the $limit
                 limit->setLimit(limit->getLimit() + skip->getSkip());
-                swap(sources[i], sources[i-1]);
-
-                // Start at back again. This is needed to handle cases with more than 1 $limit
-                // (S means skip, L means limit)
-                //
-                // These two would work without second pass (assuming back to front ordering)
-                // SL   -> LS
-                // SSL  -> LSS
-                //
-                // The following cases need a second pass to handle the second limit
-                // SLL  -> LLS
-                // SSLL -> LLSS
-                // SLSL -> LLSS
-                i = sources.size(); // decremented before next pass
             }
+            else if (!project) {
+                continue;
+            }
+            // ($project emits exactly one document per input document, so the first k outputs
+            // of [$project, $limit k] are the first k inputs projected and the swap doesn't
+            // change the result.)
+            swap(sources[i], sources[i-1]);
+
+            // Start at back again. This is needed to handle cases with more than 1 $limit
+            // (S means skip or project, L means limit)
+            //
+            // These two would work without second pass (assuming back to front ordering)
+            // SL   -> LS
+            // SSL  -> LSS
+            //
+            // The following cases need a second pass to handle the second limit
+            // SLL  -> LLS
+            // SSLL -> LLSS
+            // SLSL -> LLSS
+            i = sources.size(); // decremented before next pass
         }
     }
 
@@ -30,18 +30,32 @@
 
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/commands/parallel_collection_scan.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_runner.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/d_logic.h"
+#include "mongo/util/queue.h"
 
 namespace mongo {
 
+    // Number of worker threads used to feed an eligible aggregation pipeline from a
+    // parallel collection scan.  0 (the default) disables parallel scans.
+    MONGO_EXPORT_SERVER_PARAMETER(internalAggregationParallelScanThreads, int, 0);
+
 namespace {
     class MongodImplementation : public DocumentSourceNeedsMongod::MongodInterface {
     public:
@@ -61,6 +75,297 @@ namespace {
     private:
         DBDirectClient _client;
     };
+
+    typedef std::vector<BSONObj> ScanBatch;
+
+    // Documents a worker copies out per lock acquisition / queue push.
+    const int kParallelScanBatchBytes = 1024 * 1024;
+
+    /**
+     * State shared between the consuming DocumentSourceParallelScan and its
+     * scan workers.  Held by shared_ptr so it outlives whichever side exits
+     * first; the workers are detached threads.
+     */
+    struct ParallelScanState {
+        ParallelScanState( const string& theNs, size_t numWorkers )
+            : ns( theNs ),
+              queue( 4 * numWorkers ),
+              activeWorkers( numWorkers ),
+              shutdown( 0 ),
+              errMutex( "ParallelScanState" ) {
+        }
+
+        const string ns;
+        BlockingQueue<ScanBatch> queue; // batches of owned documents
+        AtomicInt32 activeWorkers;
+        AtomicInt32 shutdown;
+
+        mongo::mutex errMutex;
+        string errMsg; // first worker failure, reported by the consumer
+
+        void noteError( const string& msg ) {
+            scoped_lock lk( errMutex );
+            if ( errMsg.empty() )
+                errMsg = msg;
+        }
+    };
+
+    /**
+     * Drives one extent-range cursor (as created by parallelCollectionScan) to
+     * EOF, copying documents out in batches under a read lock and pushing them
+     * onto the shared queue.  The cursor lives in the collection cursor cache
+     * between batches, so drops and deletions are handled by the usual
+     * invalidation machinery.
+     */
+    void parallelScanWorker( boost::shared_ptr<ParallelScanState> state, long long cursorId ) {
+        Client::initThread( "aggParallelScan" );
+
+        bool cursorGone = false;
+        try {
+            while ( !state->shutdown.load() ) {
+                ScanBatch batch;
+                bool done = false;
+                {
+                    Client::ReadContext ctx( state->ns );
+                    Collection* collection = ctx.ctx().db()->getCollection( state->ns );
+                    if ( !collection ) {
+                        cursorGone = done = true; // died with the collection
+                    }
+                    else {
+                        ClientCursorPin pin( collection, cursorId );
+                        ClientCursor* cursor = pin.c();
+                        if ( !cursor ) {
+                            cursorGone = done = true; // killed while we yielded
+                        }
+                        else {
+                            BSONObj obj;
+                            Runner::RunnerState runnerState;
+                            int bytes = 0;
+                            while ( ( runnerState = cursor->getRunner()->getNext( &obj, NULL ) )
+                                        == Runner::RUNNER_ADVANCED ) {
+                                batch.push_back( obj.getOwned() );
+                                bytes += obj.objsize();
+                                if ( bytes > kParallelScanBatchBytes )
+                                    break;
+                            }
+                            if ( runnerState != Runner::RUNNER_ADVANCED ) {
+                                done = true;
+                                pin.deleteUnderlying();
+                                cursorGone = true;
+                            }
+                        }
+                    }
+                }
+                if ( !batch.empty() )
+                    state->queue.push( batch ); // may block; dispose() clears the queue
+                if ( done )
+                    break;
+            }
+
+            if ( !cursorGone ) {
+                // shut down before EOF; toss our cursor
+                Client::ReadContext ctx( state->ns );
+                Collection* collection = ctx.ctx().db()->getCollection( state->ns );
+                if ( collection ) {
+                    ClientCursorPin pin( collection, cursorId );
+                    if ( pin.c() )
+                        pin.deleteUnderlying();
+                }
+            }
+        }
+        catch ( const DBException& e ) {
+            state->noteError( e.toString() );
+        }
+        catch ( const std::exception& e ) {
+            state->noteError( e.what() );
+        }
+
+        state->activeWorkers.subtractAndFetch( 1 );
+        cc().shutdown();
+    }
+
+    /**
+     * Initial source that feeds the pipeline from several ExtentRunner cursors
+     * driven on worker threads, instead of a single Runner.  getNext() runs
+     * without any lock held (PipelineRunner manages locking through its source),
+     * so blocking on the queue here cannot deadlock with the workers' read
+     * locks.
+     */
+    class DocumentSourceParallelScan : public DocumentSource {
+    public:
+        static intrusive_ptr<DocumentSourceParallelScan> create(
+                const string& ns,
+                const std::vector<long long>& cursorIds,
+                const boost::optional<ParsedDeps>& deps,
+                const intrusive_ptr<ExpressionContext>& pExpCtx) {
+            return new DocumentSourceParallelScan( ns, cursorIds, deps, pExpCtx );
+        }
+
+        virtual ~DocumentSourceParallelScan() {
+            dispose();
+        }
+
+        virtual const char* getSourceName() const { return "$parallelCollectionScan"; }
+
+        virtual bool isValidInitialSource() const { return true; }
+
+        virtual void setSource(DocumentSource* pSource) {
+            /* this doesn't take a source */
+            verify(false);
+        }
+
+        virtual boost::optional<Document> getNext() {
+            pExpCtx->checkForInterrupt();
+
+            while ( _currentBatch.empty() ) {
+                if ( _state->shutdown.load() )
+                    return boost::none;
+
+                ScanBatch batch;
+                if ( _state->queue.blockingPop( batch, 1 ) ) {
+                    _convertBatch( batch );
+                    continue;
+                }
+
+                pExpCtx->checkForInterrupt();
+
+                if ( _state->activeWorkers.load() == 0 ) {
+                    // Workers are gone; drain anything pushed before the last
+                    // one exited, then report how the scan ended.
+                    while ( _state->queue.tryPop( batch ) )
+                        _convertBatch( batch );
+                    if ( _currentBatch.empty() ) {
+                        const string err = _firstError();
+                        uassert( 17430,
+                                 str::stream() << "parallel scan worker failed: " << err,
+                                 err.empty() );
+                        return boost::none;
+                    }
+                }
+            }
+
+            Document out = _currentBatch.front();
+            _currentBatch.pop_front();
+            return out;
+        }
+
+        virtual void dispose() {
+            _state->shutdown.store( 1 );
+            // Wake any worker blocked pushing into a full queue; the queue is
+            // sized so every worker can complete one final push unblocked.
+            _state->queue.clear();
+            _currentBatch.clear();
+        }
+
+        virtual Value serialize(bool explain = false) const {
+            // we never parse this source, so we only serialize for explain
+            if (!explain)
+                return Value();
+            return Value(DOC(getSourceName() << DOC("numCursors" << (int)_numCursors)));
+        }
+
+    private:
+        DocumentSourceParallelScan(const string& ns,
+                                   const std::vector<long long>& cursorIds,
+                                   const boost::optional<ParsedDeps>& deps,
+                                   const intrusive_ptr<ExpressionContext>& pCtx)
+            : DocumentSource(pCtx)
+            , _state( boost::make_shared<ParallelScanState>( ns, cursorIds.size() ) )
+            , _dependencies( deps )
+            , _numCursors( cursorIds.size() ) {
+
+            for ( size_t i = 0; i < cursorIds.size(); i++ ) {
+                // thread object destruction detaches; workers hold the state
+                // alive through their shared_ptr copy
+                boost::thread( boost::bind( parallelScanWorker, _state, cursorIds[i] ) );
+            }
+        }
+
+        void _convertBatch( const ScanBatch& batch ) {
+            for ( size_t i = 0; i < batch.size(); i++ ) {
+                if ( _dependencies )
+                    _currentBatch.push_back( _dependencies->extractFields( batch[i] ) );
+                else
+                    _currentBatch.push_back( Document::fromBsonWithMetaData( batch[i] ) );
+            }
+        }
+
+        string _firstError() const {
+            scoped_lock lk( _state->errMutex );
+            return _state->errMsg;
+        }
+
+        boost::shared_ptr<ParallelScanState> _state;
+        boost::optional<ParsedDeps> _dependencies;
+        std::deque<Document> _currentBatch;
+        size_t _numCursors;
+    };
+
+    /**
+     * Decides whether this pipeline can be fed by a parallel collection scan
+     * and, if so, builds the source: one ExtentRunner-backed ClientCursor per
+     * extent bucket plus a DocumentSourceParallelScan consuming them.  Returns
+     * NULL when the regular single-Runner path should be used.  Caller must
+     * hold the read lock.
+     */
+    intrusive_ptr<DocumentSource> tryCreateParallelScanSource(
+            const intrusive_ptr<Pipeline>& pPipeline,
+            const intrusive_ptr<ExpressionContext>& pExpCtx,
+            const BSONObj& queryObj) {
+
+        if (internalAggregationParallelScanThreads < 2)
+            return NULL;
+
+        const NamespaceString& nss = pExpCtx->ns;
+
+        // A $text match and shard filtering both need a planner-built Runner.
+        if (DocumentSourceMatch::isTextQuery(queryObj))
+            return NULL;
+        const ChunkVersion unsharded(0, 0, OID());
+        if (!shardingState.getVersion(nss.ns()).isWriteCompatibleWith(unsharded))
+            return NULL;
+
+        // An index-assisted $sort beats a parallel scan feeding a blocking
+        // sort; leave those pipelines to the regular path.  The $sort may sit
+        // behind the initial $match.
+        Pipeline::SourceContainer& sources = pPipeline->sources;
+        const size_t sortPos = queryObj.isEmpty() ? 0 : 1;
+        if (sources.size() > sortPos &&
+            dynamic_cast<DocumentSourceSort*>(sources[sortPos].get()))
+            return NULL;
+
+        Database* db = cc().database();
+        Collection* collection = db ? db->getCollection(nss.ns()) : NULL;
+        if (!collection || collection->isCapped())
+            return NULL;
+
+        // The $match (if any) stays in the pipeline, so the dependency
+        // traversal picks up the fields it needs.
+        DepsTracker deps = pPipeline->getDependencies(queryObj);
+        if (deps.needTextScore)
+            return NULL;
+
+        size_t numWorkers = std::min(internalAggregationParallelScanThreads, 64);
+        vector< vector<ExtentInfo> > buckets =
+            partitionCollectionExtents(db, collection, numWorkers);
+        if (buckets.size() < 2)
+            return NULL; // nothing to parallelize
+
+        std::vector<long long> cursorIds;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            auto_ptr<Runner> runner(new ExtentRunner(nss.ns(),
+                                                     db,
+                                                     collection,
+                                                     buckets[i]));
+            ClientCursor* cursor = new ClientCursor(collection, runner.release());
+            cursorIds.push_back(cursor->cursorid());
+        }
+
+        return DocumentSourceParallelScan::create(nss.ns(),
+                                                  cursorIds,
+                                                  deps.toParsedDeps(),
+                                                  pExpCtx);
+    }
 }
 
     boost::shared_ptr<Runner> PipelineD::prepareCursorSource(
@@ -97,6 +402,20 @@ namespace {
         // Look for an initial match. This works whether we got an initial query or not.
         // If not, it results in a "{}" query, which will be what we want in that case.
         const BSONObj queryObj = pPipeline->getInitialQuery();
+
+        // Knob-gated parallel collection scan: feed the pipeline from several
+        // extent-range cursors on worker threads instead of one Runner.  The
+        // initial $match (if any) stays in the pipeline and is evaluated on
+        // the documents the workers produce.
+        {
+            intrusive_ptr<DocumentSource> parallelSource =
+                tryCreateParallelScanSource(pPipeline, pExpCtx, queryObj);
+            if (parallelSource) {
+                pPipeline->addInitialSource(parallelSource);
+                return boost::shared_ptr<Runner>(); // the source manages its own locking
+            }
+        }
+
         if (!queryObj.isEmpty()) {
             // This will get built in to the Cursor we'll create, so
             // remove the match from the pipeline
@@ -53,14 +53,16 @@ namespace mongo {
         static void moveMatchBeforeSort(Pipeline* pipeline);
 
         /**
-         * Moves limits before any adjacent skip phases.
+         * Moves limits before any adjacent skip or project phases.
          *
          * This is more optimal for sharding since currently, we can only split
          * the pipeline at a single source and it is better to limit the results
-         * coming from each shard. This also enables other optimizations like
-         * coalescing the limit into a sort.
+         * coming from each shard. More importantly it enables coalescing the
+         * limit into an upstream sort, which then keeps only the top limit
+         * documents in a bounded heap (see TopKSorter) instead of
+         * materializing its whole input.
          */
-        static void moveLimitBeforeSkip(Pipeline* pipeline);
+        static void moveLimitBeforeSkipAndProject(Pipeline* pipeline);
 
         /**
          * Runs through the DocumentSources, and give each one the opportunity
@@ -86,7 +86,7 @@ namespace mongo {
         const size_t sizeNoNUL = s.size();
         if (sizeNoNUL <= sizeof(shortStrStorage)) {
             shortStr = true;
-            shortStrSize = s.size();
+            shortStrSize = static_cast<unsigned char>(sizeNoNUL);
             s.copyTo(shortStrStorage, false); // no NUL
 
             // All memory is zeroed before this is called.
@@ -98,6 +98,19 @@ namespace mongo {
         }
     }
 
+    void ValueStorage::putStringRef(const BSONObj& owner, const StringData& s) {
+        // Short strings are cheaper inlined or copied; only longer ones are worth a
+        // reference that pins the whole source buffer in memory.
+        const size_t kMinStringRefSize = 64;
+        if (s.size() < kMinStringRefSize) {
+            putString(s);
+            return;
+        }
+
+        putRefCountable(new RCBSONString(owner, s));
+        bsonStr = true;
+    }
+
     void ValueStorage::putDocument(const Document& d) {
         putRefCountable(d._storage);
     }
@@ -112,11 +125,21 @@ namespace mongo {
         const size_t flagsLen = re.flags.size();
         const size_t totalLen = patternLen + 1/*middle NUL*/ + flagsLen;
 
-        // Need to copy since putString doesn't support scatter-gather.
-        boost::scoped_array<char> buf (new char[totalLen]);
-        re.pattern.copyTo(buf.get(), true);
-        re.flags.copyTo(buf.get() + patternLen + 1, false); // no NUL
-        putString(StringData(buf.get(), totalLen));
+        if (totalLen <= sizeof(shortStrStorage)) {
+            // Assemble on the stack and take putString's inline path.
+            char buf[sizeof(shortStrStorage)];
+            re.pattern.copyTo(buf, true);
+            re.flags.copyTo(buf + patternLen + 1, false); // no NUL
+            putString(StringData(buf, totalLen));
+        }
+        else {
+            // Gather straight into the final allocation.
+            char* out = NULL;
+            intrusive_ptr<const RCString> str = RCString::createUninitialized(totalLen, &out);
+            re.pattern.copyTo(out, true);
+            re.flags.copyTo(out + patternLen + 1, false); // no NUL
+            putRefCountable(str);
+        }
     }
 
     Document ValueStorage::getDocument() const {
@@ -216,6 +239,38 @@ namespace mongo {
         }
     }
 
+    Value::Value(const BSONElement& elem, const BSONObj& owner) : _storage(elem.type()) {
+        // Only worthwhile when 'owner' has a refcounted buffer we can share; an
+        // unowned object gives no lifetime guarantee, so fall back to copying.
+        if (!owner.isOwned()) {
+            *this = Value(elem);
+            return;
+        }
+
+        switch(elem.type()) {
+        case String:
+            _storage.putStringRef(owner, StringData(elem.valuestr(), elem.valuestrsize()-1));
+            return;
+
+        case Object:
+            _storage.putDocument(Document(elem.embeddedObject(), owner));
+            return;
+
+        case Array: {
+            intrusive_ptr<RCVector> vec (new RCVector);
+            BSONForEach(sub, elem.embeddedObject()) {
+                vec->vec.push_back(Value(sub, owner));
+            }
+            _storage.putVector(vec.get());
+            return;
+        }
+
+        default:
+            *this = Value(elem);
+            return;
+        }
+    }
+
     Value::Value(const BSONArray& arr) : _storage(Array) {
         intrusive_ptr<RCVector> vec (new RCVector);
         BSONForEach(sub, arr) {
@@ -224,6 +279,40 @@ namespace mongo {
         _storage.putVector(vec.get());
     }
 
+    Value Value::concat(const vector<Value>& parts) {
+        size_t totalSize = 0;
+        for (size_t i = 0; i < parts.size(); i++) {
+            dassert(parts[i].getType() == String);
+            totalSize += parts[i].getStringData().size();
+        }
+
+        // Small results go through putString's inline path; everything else is
+        // gathered straight into a single RCString allocated at its final size.
+        char* out = NULL;
+        char inlineBuf[32];
+        intrusive_ptr<const RCString> str;
+        if (totalSize <= sizeof(inlineBuf)) {
+            out = inlineBuf;
+        }
+        else {
+            str = RCString::createUninitialized(totalSize, &out);
+        }
+
+        char* pos = out;
+        for (size_t i = 0; i < parts.size(); i++) {
+            const StringData part = parts[i].getStringData();
+            part.copyTo(pos, false); // no NUL
+            pos += part.size();
+        }
+
+        if (str) {
+            ValueStorage storage(String);
+            storage.putRefCountable(str);
+            return Value(storage);
+        }
+        return Value(StringData(inlineBuf, totalSize));
+    }
+
     Value Value::createIntOrLong(long long longValue) {
         int intValue = longValue;
         if (intValue != longValue) {
@@ -831,6 +920,8 @@ namespace mongo {
         case String:
             return sizeof(Value) + (_storage.shortStr
                                         ? 0 // string stored inline, so no extra mem usage
+                                        : _storage.bsonStr
+                                        ? sizeof(RCBSONString) // bytes live in the shared buffer
                                         : sizeof(RCString) + _storage.getString().size());
 
         case Object:
@@ -93,10 +93,16 @@ namespace mongo {
             : _storage(Date, static_cast<long long>(date.millis)) // millis really signed
         {}
 
-        // TODO: add an unsafe version that can share storage with the BSONElement
         /// Deep-convert from BSONElement to Value
         explicit Value(const BSONElement& elem);
 
+        /** Convert from a BSONElement whose enclosing object is 'owner'. If 'owner'
+         *  is owned (has a refcounted buffer), long strings reference the buffer
+         *  rather than being copied out of it; the resulting Values keep the buffer
+         *  alive. Falls back to deep conversion otherwise.
+         */
+        Value(const BSONElement& elem, const BSONObj& owner);
+
         /** Construct a long or integer-valued Value.
          *
          *  Used when preforming arithmetic operations with int where the
@@ -105,6 +111,12 @@ namespace mongo {
         */
         static Value createIntOrLong(long long value);
 
+        /** Construct a String Value from the concatenation of 'parts' (all of which
+         *  must already be String-typed), sizing and materializing the result
+         *  exactly once rather than growing a buffer.
+         */
+        static Value concat(const std::vector<Value>& parts);
+
         /** Construct an Array-typed Value from consumed without copying the vector.
          *  consumed is replaced with an empty vector.
          *  In C++11 this would be spelled Value(std::move(consumed)).
@@ -65,6 +65,23 @@ namespace mongo {
         const OID oid;
     };
 
+    /// A string Value that references bytes inside an owned BSON buffer rather than
+    /// copying them out; holding the BSONObj keeps the buffer alive.
+    class RCBSONString : public RefCountable {
+    public:
+        RCBSONString(const BSONObj& owner, const StringData& str) : _owner(owner), _str(str) {
+            dassert(_owner.isOwned());
+            dassert(str.rawData() >= _owner.objdata()
+                    && str.rawData() + str.size() <= _owner.objdata() + _owner.objsize());
+        }
+
+        StringData stringData() const { return _str; }
+
+    private:
+        const BSONObj _owner;  // shares the refcounted buffer
+        const StringData _str; // points into _owner's buffer
+    };
+
 #pragma pack(1)
     class ValueStorage {
     public:
@@ -129,6 +146,7 @@ namespace mongo {
 
         /// These are only to be called during Value construction on an empty Value
         void putString(const StringData& s);
+        void putStringRef(const BSONObj& owner, const StringData& s);
         void putVector(const RCVector* v);
         void putDocument(const Document& d);
         void putRegEx(const BSONRegEx& re);
@@ -161,6 +179,10 @@ namespace mongo {
             if (shortStr) {
                 return StringData(shortStrStorage, shortStrSize);
             }
+            else if (bsonStr) {
+                dassert(typeid(*genericRCPtr) == typeid(const RCBSONString));
+                return static_cast<const RCBSONString*>(genericRCPtr)->stringData();
+            }
             else {
                 dassert(typeid(*genericRCPtr) == typeid(const RCString));
                 const RCString* stringPtr = static_cast<const RCString*>(genericRCPtr);
@@ -218,7 +240,9 @@ namespace mongo {
                 struct {
                     bool refCounter : 1; // true if we need to refCount
                     bool shortStr : 1; // true if we are using short strings
-                    // reservedFlags: 6;
+                    bool bsonStr : 1; // true if genericRCPtr is an RCBSONString
+                    unsigned char shortStrSize : 4; // only valid if shortStr
+                    // reservedFlags: 1;
                 };
 
                 // bytes 3-16;
@@ -226,8 +250,7 @@ namespace mongo {
                     unsigned char oid[12];
 
                     struct {
-                        char shortStrSize; // TODO Consider moving into flags union (4 bits)
-                        char shortStrStorage[16/*total bytes*/ - 3/*offset*/ - 1/*NUL byte*/];
+                        char shortStrStorage[16/*total bytes*/ - 2/*offset*/ - 1/*NUL byte*/];
                         union {
                             char nulTerminator;
                         };
@@ -30,16 +30,24 @@
 
 #include "mongo/db/prefetch.h"
 
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/db/index/btree_interface.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/structure/catalog/index_details.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/storage/record.h"
 #include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/commands/server_status.h"
+#include "mongo/util/concurrency/work_stealing_pool.h"
 
 namespace mongo {
 
@@ -203,4 +211,96 @@ namespace mongo {
             }
         }
     }
+
+    // number of btree buckets an index scan reads ahead each time it crosses into
+    // a new bucket.  0 (the default) disables query-path index prefetching.
+    MONGO_EXPORT_SERVER_PARAMETER(indexScanPrefetchBuckets, int, 0);
+
+    namespace {
+
+        const int kIndexScanPrefetchThreads = 2;
+        // drop read-ahead requests rather than queue behind this many
+        const int kIndexScanPrefetchMaxQueue = 2 * kIndexScanPrefetchThreads;
+
+        SimpleMutex indexScanPrefetchPoolMutex("indexScanPrefetchPool");
+        threadpool::WorkStealingPool* indexScanPrefetchPool = NULL; // lazily created
+
+        threadpool::WorkStealingPool* getIndexScanPrefetchPool() {
+            SimpleMutex::scoped_lock lk(indexScanPrefetchPoolMutex);
+            if (!indexScanPrefetchPool)
+                indexScanPrefetchPool = new threadpool::WorkStealingPool(kIndexScanPrefetchThreads);
+            return indexScanPrefetchPool;
+        }
+
+        void initializeIndexPrefetchThread() {
+            // only done once per pool thread
+            if (!ClientBasic::getCurrent()) {
+                Client::initThread("index prefetch worker");
+            }
+        }
+
+        // The pool threads call this.  Walks up to nBuckets buckets starting at
+        // 'bucket' and faults in each bucket plus the records its keys point at,
+        // so the scanning thread finds them already in memory.
+        void prefetchIndexBucketsWorker(const string ns,
+                                        const string indexName,
+                                        DiskLoc bucket,
+                                        int direction,
+                                        int nBuckets) {
+            initializeIndexPrefetchThread();
+            try {
+                Client::ReadContext ctx( ns );
+                Database* db = ctx.ctx().db();
+                Collection* collection = db->getCollection( ns );
+                if ( !collection )
+                    return;
+                IndexDescriptor* desc =
+                    collection->getIndexCatalog()->findIndexByName( indexName );
+                if ( !desc )
+                    return;
+                const IndexCatalogEntry* entry =
+                    collection->getIndexCatalog()->getEntry( desc );
+                BtreeInterface* interface = BtreeInterface::interfaces[desc->version()];
+
+                for ( int i = 0; i < nBuckets && !bucket.isNull(); i++ ) {
+                    // nKeys faults in the bucket itself
+                    int n = interface->nKeys( entry, bucket );
+                    for ( int j = 0; j < n; j++ ) {
+                        if ( !interface->keyIsUsed( entry, bucket, j ) )
+                            continue;
+                        DiskLoc recordLoc = interface->recordAt( entry, bucket, j );
+                        if ( !recordLoc.isNull() )
+                            db->getExtentManager().recordFor( recordLoc )->touch();
+                    }
+                    if ( n == 0 )
+                        break;
+                    int keyOfs = ( direction == 1 ) ? n - 1 : 0;
+                    bucket = interface->advance( entry, bucket, keyOfs, direction, "prefetch" );
+                }
+            }
+            catch (const DBException& e) {
+                // we race with writers; a dropped collection or a deleted bucket
+                // (BtreeInterface::deletedBucketCode) just ends this read-ahead.
+                LOG(2) << "ignoring exception in prefetchIndexBuckets(): " << e.what() << endl;
+            }
+        }
+
+    } // namespace
+
+    void prefetchIndexBuckets(const std::string& ns,
+                              const std::string& indexName,
+                              const DiskLoc& bucket,
+                              int direction) {
+        const int nBuckets = indexScanPrefetchBuckets;
+        if ( nBuckets <= 0 || bucket.isNull() )
+            return;
+
+        threadpool::WorkStealingPool* pool = getIndexScanPrefetchPool();
+        // read-ahead is advisory; when the pool is behind, dropping the request
+        // beats queueing up page faults the scan may never reach.
+        if ( pool->tasks_remaining() >= kIndexScanPrefetchMaxQueue )
+            return;
+
+        pool->schedule(&prefetchIndexBucketsWorker, ns, indexName, bucket, direction, nBuckets);
+    }
 }
@@ -40,4 +40,13 @@ namespace mongo {
 
     // page in the data pages for a record associated with an object
     void prefetchRecordPages(const char *ns, const BSONObj& obj);
+
+    // queue asynchronous read-ahead of the next few btree buckets (and the
+    // records their keys point at) for an index scan positioned at 'bucket'.
+    // no-op unless indexScanPrefetchBuckets is set; requests are dropped
+    // rather than queued unboundedly.
+    void prefetchIndexBuckets(const std::string& ns,
+                              const std::string& indexName,
+                              const DiskLoc& bucket,
+                              int direction);
 }
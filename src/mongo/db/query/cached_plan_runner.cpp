@@ -123,6 +123,13 @@ namespace mongo {
         }
     }
 
+    void CachedPlanRunner::setExecBatchSize(int batchSize) {
+        _exec->setExecBatchSize(batchSize);
+        if (NULL != _backupPlan.get()) {
+            _backupPlan->setExecBatchSize(batchSize);
+        }
+    }
+
     const std::string& CachedPlanRunner::ns() {
         return _canonicalQuery->getParsed().ns();
     }
@@ -78,6 +78,8 @@ namespace mongo {
 
         virtual void setYieldPolicy(Runner::YieldPolicy policy);
 
+        virtual void setExecBatchSize(int batchSize);
+
         virtual const std::string& ns();
 
         virtual void kill();
@@ -233,6 +233,16 @@ namespace mongo {
             res->setIndexOnly(false);
             res->setIsMultiKey(false);
         }
+        else if (leaf->stageType == STAGE_PARALLEL_GATHER) {
+            ParallelGatherStats* pgStats = static_cast<ParallelGatherStats*>(leaf->specific.get());
+            // A parallel gather is a table scan as far as consumers of explain
+            // are concerned; the fan-out shows up in the verbose stats.
+            res->setCursor("BasicCursor");
+            res->setNScanned(pgStats->docsTested);
+            res->setNScannedObjects(pgStats->docsTested);
+            res->setIndexOnly(false);
+            res->setIsMultiKey(false);
+        }
         else if (leaf->stageType == STAGE_GEO_2D) {
             // Cursor name depends on type of GeoBrowse.
             // TODO: We could omit the shape from the cursor name.
@@ -415,6 +425,8 @@ namespace mongo {
             return "LIMIT";
         case STAGE_OR:
             return "OR";
+        case STAGE_PARALLEL_GATHER:
+            return "PARALLEL_GATHER";
         case STAGE_PROJECTION:
             return "PROJECTION";
         case STAGE_SHARDING_FILTER:
@@ -450,6 +462,14 @@ namespace mongo {
         bob->appendNumber("needFetch", stats.common.needFetch);
         bob->appendNumber("isEOF", stats.common.isEOF);
 
+        // Sampled timing, inclusive of child stages.  timedWorks out of "works"
+        // calls were timed; scale timedWorksMicros by works/timedWorks to
+        // estimate the total time this subtree consumed.
+        if (stats.common.timedWorks) {
+            bob->appendNumber("timedWorks", stats.common.timedWorks);
+            bob->appendNumber("timedWorksMicros", stats.common.timedWorksMicros);
+        }
+
         // Stage-specific stats
         if (STAGE_AND_HASH == stats.stageType) {
             AndHashStats* spec = static_cast<AndHashStats*>(stats.specific.get());
@@ -473,6 +493,11 @@ namespace mongo {
             CollectionScanStats* spec = static_cast<CollectionScanStats*>(stats.specific.get());
             bob->appendNumber("docsTested", spec->docsTested);
         }
+        else if (STAGE_PARALLEL_GATHER == stats.stageType) {
+            ParallelGatherStats* spec = static_cast<ParallelGatherStats*>(stats.specific.get());
+            bob->appendNumber("docsTested", spec->docsTested);
+            bob->appendNumber("numWorkers", spec->numWorkers);
+        }
         else if (STAGE_FETCH == stats.stageType) {
             FetchStats* spec = static_cast<FetchStats*>(stats.specific.get());
             bob->appendNumber("alreadyHasObj", spec->alreadyHasObj);
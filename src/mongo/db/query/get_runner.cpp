@@ -48,6 +48,9 @@
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/single_solution_runner.h"
 #include "mongo/db/query/stage_builder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/exec/parallel_gather.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
@@ -195,6 +198,19 @@ namespace mongo {
         }
 
         plannerParams->options |= QueryPlannerParams::KEEP_MUTATIONS;
+
+        // Large unsorted table scans can fan out over several worker threads.  Decided
+        // here because eligibility depends on the collection, not the query: the scan
+        // partitions extents, so capped collections are out, and small collections
+        // aren't worth the thread and cursor setup.  Whether this query can actually
+        // use it is checked in QueryPlannerAccess::makeCollectionScan.
+        if (internalQueryParallelCollscanThreads >= 2
+            && !collection->isCapped()
+            && collection->dataSize() >=
+                   static_cast<uint64_t>(internalQueryParallelCollscanMinSizeMB)
+                       * 1024 * 1024) {
+            plannerParams->options |= QueryPlannerParams::PARALLEL_COLLSCAN;
+        }
     }
 
     /**
@@ -319,7 +335,13 @@ namespace mongo {
         }
 
         vector<QuerySolution*> solutions;
+        // Time enumeration+planning so that slow planning (enumeration blowups on
+        // many-index collections) shows up in explain, profiling and slow-query logs
+        // rather than masquerading as execution time.
+        const uint64_t planStartMicros = curTimeMicros64();
         Status status = QueryPlanner::plan(*canonicalQuery, plannerParams, &solutions);
+        cc().curop()->debug().planningTimeMicros +=
+            static_cast<long long>(curTimeMicros64() - planStartMicros);
         if (!status.isOK()) {
             return Status(ErrorCodes::BadValue,
                           "error processing query: " + canonicalQuery->toString() +
@@ -502,10 +524,26 @@ namespace mongo {
          * Currently the solution generated for the distinct hack includes a projection stage and
          * the projection stage cannot be covered with a dotted field.
          */
+        /**
+         * Returns the position of 'field' in 'keyPattern', or -1 if it isn't a component.
+         */
+        int getFieldPosition(const BSONObj& keyPattern, const std::string& field) {
+            int position = 0;
+            BSONObjIterator it(keyPattern);
+            while (it.more()) {
+                if (field == it.next().fieldName()) {
+                    return position;
+                }
+                ++position;
+            }
+            return -1;
+        }
+
         bool getDistinctNodeIndex(const std::vector<IndexEntry>& indices,
                                   const std::string& field, size_t* indexOut) {
             invariant(indexOut);
             bool isDottedField = str::contains(field, '.');
+            int bestPosition = std::numeric_limits<int>::max();
             int minFields = std::numeric_limits<int>::max();
             for (size_t i = 0; i < indices.size(); ++i) {
                 // Skip special indices.
@@ -516,9 +554,18 @@ namespace mongo {
                 if (indices[i].multikey && isDottedField) {
                     continue;
                 }
+                int position = getFieldPosition(indices[i].keyPattern, field);
+                if (position < 0) {
+                    continue;
+                }
                 int nFields = indices[i].keyPattern.nFields();
-                // Pick the index with the lowest number of fields.
-                if (nFields < minFields) {
+                // Prefer the index where the field is earliest: the scan touches one key
+                // per distinct combination of the fields up to and including ours, so the
+                // fewer fields in front, the fewer keys touched.  Break ties on the total
+                // field count.
+                if (position < bestPosition ||
+                    (position == bestPosition && nFields < minFields)) {
+                    bestPosition = position;
                     minFields = nFields;
                     *indexOut = i;
                 }
@@ -654,9 +701,8 @@ namespace mongo {
             dn->direction = isn->direction;
             dn->bounds = isn->bounds;
 
-            // Figure out which field we're skipping to the next value of.  TODO: We currently only
-            // try to distinct-hack when there is an index prefixed by the field we're distinct-ing
-            // over.  Consider removing this code if we stick with that policy.
+            // Figure out which field we're skipping to the next value of.  The field need not
+            // be the leading index component.
             dn->fieldNo = 0;
             BSONObjIterator it(isn->indexKeyPattern);
             while (it.more()) {
@@ -687,7 +733,7 @@ namespace mongo {
         // When can we do a fast distinct hack?
         // 1. There is a plan with just one leaf and that leaf is an ixscan.
         // 2. The ixscan indexes the field we're interested in.
-        // 2a: We are correct if the index contains the field but for now we look for prefix.
+        // 2a: The field can be any component of the index; the scan skips on its position.
         // 3. The query is covered/no fetch.
         //
         // We go through normal planning (with limited parameters) to see if we can produce
@@ -699,9 +745,12 @@ namespace mongo {
         IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(false);
         while (ii.more()) {
             const IndexDescriptor* desc = ii.next();
-            // The distinct hack can work if any field is in the index but it's not always clear
-            // if it's a win unless it's the first field.
-            if (desc->keyPattern().firstElement().fieldName() == field) {
+            // The distinct hack can work whenever the field is a component of the index: the
+            // scan skips to the next distinct combination of the fields up to and including
+            // ours, touching one btree key per combination.  Prefix indexes are best -- one
+            // key per distinct value -- and getDistinctNodeIndex prefers them; even a
+            // non-prefix component beats fetching every document.
+            if (getFieldPosition(desc->keyPattern(), field) >= 0) {
                 plannerParams.indices.push_back(IndexEntry(desc->keyPattern(),
                                                            desc->getAccessMethodName(),
                                                            desc->isMultikey(),
@@ -747,7 +796,7 @@ namespace mongo {
             return getRunner(cq, out);
         }
 
-        // If we're here, we have an index prefixed by the field we're distinct-ing over.
+        // If we're here, we have an index containing the field we're distinct-ing over.
 
         // If there's no query, we can just distinct-scan one of the indices.
         // Not every index in plannerParams.indices may be suitable. Refer to
@@ -759,7 +808,10 @@ namespace mongo {
             dn->indexKeyPattern = plannerParams.indices[distinctNodeIndex].keyPattern;
             dn->direction = 1;
             IndexBoundsBuilder::allValuesBounds(dn->indexKeyPattern, &dn->bounds);
-            dn->fieldNo = 0;
+            // The field may not be the leading index component; skip on the distinct
+            // field's own position.
+            dn->fieldNo = getFieldPosition(dn->indexKeyPattern, field);
+            verify(dn->fieldNo >= 0);
 
             QueryPlannerParams params;
 
@@ -776,7 +828,10 @@ namespace mongo {
 
         // See if we can answer the query in a fast-distinct compatible fashion.
         vector<QuerySolution*> solutions;
+        const uint64_t planStartMicros = curTimeMicros64();
         status = QueryPlanner::plan(*cq, plannerParams, &solutions);
+        cc().curop()->debug().planningTimeMicros +=
+            static_cast<long long>(curTimeMicros64() - planStartMicros);
         if (!status.isOK()) {
             return getRunner(cq, out);
         }
@@ -324,7 +324,7 @@ namespace mongo {
         }
         else if (MatchExpression::EQ == expr->matchType()) {
             const EqualityMatchExpression* node = static_cast<const EqualityMatchExpression*>(expr);
-            translateEquality(node->getData(), isHashed, oilOut, tightnessOut);
+            translateEquality(node->getData(), index, isHashed, oilOut, tightnessOut);
         }
         else if (MatchExpression::LTE == expr->matchType()) {
             const LTEMatchExpression* node = static_cast<const LTEMatchExpression*>(expr);
@@ -494,7 +494,7 @@ namespace mongo {
             IndexBoundsBuilder::BoundsTightness tightness;
             for (BSONElementSet::iterator it = afr.equalities().begin();
                  it != afr.equalities().end(); ++it) {
-                translateEquality(*it, isHashed, oilOut, &tightness);
+                translateEquality(*it, index, isHashed, oilOut, &tightness);
                 if (tightness != IndexBoundsBuilder::EXACT) {
                     *tightnessOut = tightness;
                 }
@@ -739,14 +739,16 @@ namespace mongo {
     }
 
     // static
-    void IndexBoundsBuilder::translateEquality(const BSONElement& data, bool isHashed,
+    void IndexBoundsBuilder::translateEquality(const BSONElement& data, const IndexEntry& index,
+                                               bool isHashed,
                                                OrderedIntervalList* oil, BoundsTightness* tightnessOut) {
         // We have to copy the data out of the parse tree and stuff it into the index
         // bounds.  BSONValue will be useful here.
         if (Array != data.type()) {
             BSONObj dataObj;
             if (isHashed) {
-                dataObj = ExpressionMapping::hash(data);
+                // hash with the seed and hashVersion the index was built with
+                dataObj = ExpressionMapping::hash(data, index.infoObj);
             }
             else {
                 dataObj = objFromElement(data);
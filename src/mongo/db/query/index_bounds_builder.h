@@ -150,6 +150,7 @@ namespace mongo {
                                    BoundsTightness* tightnessOut);
 
         static void translateEquality(const BSONElement& data,
+                                      const IndexEntry& index,
                                       bool isHashed,
                                       OrderedIntervalList* oil,
                                       BoundsTightness* tightnessOut);
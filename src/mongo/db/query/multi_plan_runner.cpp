@@ -53,6 +53,7 @@ namespace mongo {
           _failure(false),
           _failureCount(0),
           _policy(Runner::YIELD_MANUAL),
+          _execBatchSize(0),
           _query(query),
           _backupSolution(NULL),
           _backupPlan(NULL) { }
@@ -105,6 +106,21 @@ namespace mongo {
         }
     }
 
+    void MultiPlanRunner::setExecBatchSize(int batchSize) {
+        if (_failure || _killed) { return; }
+
+        // The plan competition works the candidates one result at a time; the hint only
+        // applies once a winner is being run.
+        _execBatchSize = batchSize;
+
+        if (NULL != _bestPlan) {
+            _bestPlan->setExecBatchSize(batchSize);
+            if (NULL != _backupPlan) {
+                _backupPlan->setExecBatchSize(batchSize);
+            }
+        }
+    }
+
     void MultiPlanRunner::saveState() {
         if (_failure || _killed) { return; }
 
@@ -335,6 +351,7 @@ namespace mongo {
         _bestPlan.reset(new PlanExecutor(_candidates[bestChild].ws,
                                          _candidates[bestChild].root));
         _bestPlan->setYieldPolicy(_policy);
+        _bestPlan->setExecBatchSize(_execBatchSize);
         _alreadyProduced = _candidates[bestChild].results;
         _bestSolution.reset(_candidates[bestChild].solution);
 
@@ -352,6 +369,7 @@ namespace mongo {
                     _backupAlreadyProduced = _candidates[i].results;
                     _backupPlan = new PlanExecutor(_candidates[i].ws, _candidates[i].root);
                     _backupPlan->setYieldPolicy(_policy);
+                    _backupPlan->setExecBatchSize(_execBatchSize);
                     break;
                 }
             }
@@ -98,6 +98,8 @@ namespace mongo {
 
         virtual void setYieldPolicy(Runner::YieldPolicy policy);
 
+        virtual void setExecBatchSize(int batchSize);
+
         virtual const std::string& ns();
 
         virtual void kill();
@@ -143,6 +145,9 @@ namespace mongo {
         // PlanExecutor, we can set the right yielding policy on it.
         Runner::YieldPolicy _policy;
 
+        // Cached for the same reason as _policy.  See Runner::setExecBatchSize.
+        int _execBatchSize;
+
         // The winner of the plan competition...
         boost::scoped_ptr<PlanExecutor> _bestPlan;
 
@@ -29,6 +29,7 @@
 #include "mongo/db/query/new_find.h"
 
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/catalog/materialized_projection.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/exec/filter.h"
@@ -41,6 +42,7 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/query_result_cache.h"
 #include "mongo/db/query/single_solution_runner.h"
 #include "mongo/db/query/type_explain.h"
 #include "mongo/db/repl/repl_reads_ok.h"
@@ -48,6 +50,7 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/stale_exception.h"
@@ -99,7 +102,7 @@ namespace mongo {
     static bool runCommands(const char *ns,
                             BSONObj& jsobj,
                             CurOp& curop,
-                            BufBuilder &b,
+                            PooledBufBuilder &b,
                             BSONObjBuilder& anObjBuilder,
                             bool fromRepl,
                             int queryOptions) {
@@ -147,8 +150,30 @@ namespace mongo {
         // A pin performs a CC lookup and if there is a CC, increments the CC's pin value so it
         // doesn't time out.  Also informs ClientCursor that there is somebody actively holding the
         // CC, so don't delete it.
-        ClientCursorPin ccPin(collection, cursorid);
-        ClientCursor* cc = ccPin.c();
+        scoped_ptr<ClientCursorPin> ccPin(new ClientCursorPin(collection, cursorid));
+
+        // runQuery may have silently retargeted the query to a materialized
+        // projection, in which case the cursor lives on the projection
+        // collection, not the one the client names in the getMore
+        bool viaProjection = false;
+        if (NULL == ccPin->c()) {
+            std::vector<std::string> targets = MaterializedProjections::global.targetsFor(ns);
+            for (size_t i = 0; i < targets.size(); i++) {
+                Collection* target = ctx->ctx().db()->getCollection(targets[i]);
+                if (NULL == target) {
+                    continue;
+                }
+                scoped_ptr<ClientCursorPin> targetPin(new ClientCursorPin(target, cursorid));
+                if (NULL != targetPin->c()) {
+                    ccPin.swap(targetPin);
+                    collection = target;
+                    viaProjection = true;
+                    break;
+                }
+            }
+        }
+
+        ClientCursor* cc = ccPin->c();
 
         // These are set in the QueryResult msg we return.
         int resultFlags = ResultFlag_AwaitCapable;
@@ -163,7 +188,9 @@ namespace mongo {
         else {
             // Quote: check for spoofing of the ns such that it does not match the one originally
             // there for the cursor
-            uassert(17011, "auth error", str::equals(ns, cc->ns().c_str()));
+            uassert(17011, "auth error",
+                    str::equals(ns, cc->ns().c_str()) ||
+                    (viaProjection && cc->ns() == collection->ns().ns()));
             *isCursorAuthorized = true;
 
             // Reset timeout timer on the cursor since the cursor is still in use.
@@ -196,6 +223,14 @@ namespace mongo {
             Runner* runner = cc->getRunner();
             const int queryOptions = cc->queryOptions();
 
+            // Scan-bound cursors refill the reply buffer fastest with batched execution;
+            // the executor clamps the hint and still yields on its work quota between
+            // batches, so the lock is not held for the whole fill.
+            static const int kGetMoreExecBatchSize = 256;
+            runner->setExecBatchSize((0 < ntoreturn && ntoreturn < kGetMoreExecBatchSize)
+                                         ? ntoreturn
+                                         : kGetMoreExecBatchSize);
+
             // Get results out of the runner.
             runner->restoreState();
 
@@ -271,7 +306,7 @@ namespace mongo {
             }
 
             if (!saveClientCursor) {
-                ccPin.deleteUnderlying();
+                ccPin->deleteUnderlying();
                 // cc is now invalid, as is the runner
                 cursorid = 0;
                 cc = NULL;
@@ -377,7 +412,7 @@ namespace mongo {
 
             curop.markCommand();
 
-            BufBuilder bb;
+            PooledBufBuilder bb;
             bb.skip(sizeof(QueryResult));
 
             BSONObjBuilder cmdResBuf;
@@ -390,6 +425,7 @@ namespace mongo {
             curop.debug().query = q.query;
 
             QueryResult* qr = reinterpret_cast<QueryResult*>(bb.buf());
+            int allocSize = bb.getSize();
             bb.decouple();
             qr->setResultFlagsToOk();
             qr->len = bb.len();
@@ -398,7 +434,7 @@ namespace mongo {
             qr->cursorId = 0;
             qr->startingFrom = 0;
             qr->nReturned = 1;
-            result.setData(qr, true);
+            result.setPooledData(qr, allocSize);
             return "";
         }
 
@@ -416,6 +452,37 @@ namespace mongo {
         }
         verify(cq);
 
+        // A materialized projection (see the materializeProjection command) may
+        // hold exactly the slice this query asks for; if so, silently run
+        // against the much smaller projection collection.  Anything unusual
+        // about the query keeps it on its own collection.
+        {
+            const LiteParsedQuery& lpq = cq->getParsed();
+            if (NULL != collection &&
+                !lpq.isExplain() && !lpq.isSnapshot() &&
+                !lpq.returnKey() && !lpq.showDiskLoc() &&
+                lpq.getHint().isEmpty() && lpq.getMin().isEmpty() && lpq.getMax().isEmpty() &&
+                0 == lpq.getMaxScan() &&
+                !lpq.hasOption(QueryOption_CursorTailable) &&
+                !lpq.hasOption(QueryOption_OplogReplay) &&
+                !shardingState.needCollectionMetadata(lpq.ns())) {
+
+                const string projNS = MaterializedProjections::global.retargetNS(*cq);
+                if (!projNS.empty()) {
+                    QueryMessage qProj = q;
+                    qProj.ns = projNS.c_str();
+                    CanonicalQuery* projCq;
+                    if (CanonicalQuery::canonicalize(qProj, &projCq).isOK()) {
+                        LOG(1) << "retargeting query on " << q.ns
+                               << " to materialized projection " << projNS << endl;
+                        delete cq;
+                        cq = projCq;
+                        collection = ctx.ctx().db()->getCollection(projNS);
+                    }
+                }
+            }
+        }
+
         QLOG() << "Running query:\n" << cq->toString();
         LOG(2) << "Running query: query " << cq->getParsed().getFilter().toString()
                << " sort " << cq->getParsed().getSort().toString()
@@ -427,6 +494,62 @@ namespace mongo {
         // We use this a lot below.
         const LiteParsedQuery& pq = cq->getParsed();
 
+        // If the collection opted into result caching (collMod {resultCache: true}), an
+        // earlier identical query may have left its complete reply behind.  Only plain,
+        // single-batch, unsharded queries participate; anything that needs a cursor,
+        // special metadata, or a shard filter takes the normal path.
+        bool resultCacheEligible = false;
+        std::string resultCacheKey;
+        unsigned long long resultCacheGeneration = 0;
+        if (NULL != collection &&
+            collection->details()->isUserFlagSet(NamespaceDetails::Flag_ResultCache) &&
+            !pq.isExplain() &&
+            !pq.hasOption(QueryOption_CursorTailable) &&
+            !pq.hasOption(QueryOption_Exhaust) &&
+            !pq.hasOption(QueryOption_OplogReplay) &&
+            !pq.isSnapshot() &&
+            !pq.returnKey() &&
+            !pq.showDiskLoc() &&
+            !shardingState.needCollectionMetadata(pq.ns())) {
+
+            resultCacheEligible = true;
+            resultCacheKey = QueryResultCache::makeKey(q);
+            // Captured before we run; add() below is refused if a write (possibly during
+            // one of our own yields) bumps the generation in the meantime.
+            resultCacheGeneration = QueryResultCache::get().generation(pq.ns());
+
+            std::string cachedDocs;
+            int cachedNumResults;
+            if (QueryResultCache::get().lookup(pq.ns(), resultCacheKey,
+                                               &cachedDocs, &cachedNumResults)) {
+                // We still own cq here; getRunner hasn't taken it.
+                boost::scoped_ptr<CanonicalQuery> cqDeleter(cq);
+
+                replVerifyReadsOk(&pq);
+
+                PooledBufBuilder bb(32768);
+                bb.skip(sizeof(QueryResult));
+                bb.appendBuf((void*)cachedDocs.data(), cachedDocs.size());
+
+                MsgData* md = reinterpret_cast<MsgData*>(bb.buf());
+                md->len = bb.len();
+                result.setPooledData(md, bb.getSize());
+                bb.decouple();
+
+                QueryResult* qr = static_cast<QueryResult*>(result.header());
+                qr->cursorId = 0;
+                curop.debug().cursorid = -1;
+                qr->setResultFlagsToOk();
+                qr->setOperation(opReply);
+                qr->startingFrom = 0;
+                qr->nReturned = cachedNumResults;
+
+                curop.debug().ntoskip = pq.getSkip();
+                curop.debug().nreturned = cachedNumResults;
+                return "";
+            }
+        }
+
         // We'll now try to get the query runner that will execute this query for us. There
         // are a few cases in which we know upfront which runner we should get and, therefore,
         // we shortcut the selection process here.
@@ -490,7 +613,7 @@ namespace mongo {
         // bb is used to hold query results
         // this buffer should contain either requested documents per query or
         // explain information, but not both
-        BufBuilder bb(32768);
+        PooledBufBuilder bb(32768);
         bb.skip(sizeof(QueryResult));
 
         // How many results have we obtained from the runner?
@@ -679,6 +802,12 @@ namespace mongo {
             // Clock the whole operation.
             explain->setMillis(elapsedMillis);
 
+            // How much of that was spent enumerating and selecting plans rather than
+            // executing the winner.
+            if (curop.debug().planningTimeMicros > 0) {
+                explain->setPlanningTimeMicros(curop.debug().planningTimeMicros);
+            }
+
             BSONObj explainObj = explain->toBSON();
             bb.appendBuf((void*)explainObj.objdata(), explainObj.objsize());
 
@@ -726,8 +855,20 @@ namespace mongo {
             QLOG() << "Not caching runner but returning " << numResults << " results.\n";
         }
 
-        // Add the results from the query into the output buffer.
-        result.appendData(bb.buf(), bb.len());
+        // A complete single-batch reply can be served verbatim to the next identical
+        // query; add() drops it on the floor if a write slipped in while we ran.
+        if (resultCacheEligible && !isExplain && 0 == ccId && Runner::RUNNER_DEAD != state) {
+            QueryResultCache::get().add(pq.ns(), resultCacheKey, resultCacheGeneration,
+                                        bb.buf() + sizeof(QueryResult),
+                                        bb.len() - sizeof(QueryResult),
+                                        numResults);
+        }
+
+        // Hand the pooled buffer to the message without copying; it returns
+        // to the thread's pool once the reply has been sent.
+        MsgData* md = reinterpret_cast<MsgData*>(bb.buf());
+        md->len = bb.len();
+        result.setPooledData(md, bb.getSize());
         bb.decouple();
 
         // Fill out the output buffer's header.
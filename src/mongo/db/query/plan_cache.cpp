@@ -122,7 +122,8 @@ namespace mongo {
     PlanCacheEntry::PlanCacheEntry(const std::vector<QuerySolution*>& solutions,
                                    PlanRankingDecision* why)
         : plannerData(solutions.size()),
-          decision(why) {
+          decision(why),
+          demotions(0) {
         invariant(why);
 
         // The caller of this constructor is responsible for ensuring
@@ -170,6 +171,47 @@ namespace mongo {
         }
         entry->averageScore = averageScore;
         entry->stddevScore = stddevScore;
+        entry->demotions = demotions;
+        return entry;
+    }
+
+    PlanCacheEntry* PlanCacheEntry::cloneWithNextCandidate() const {
+        PlanCacheEntry* entry = clone();
+
+        invariant(entry->plannerData.size() > 1);
+
+        // Rotate the degraded winner to the back; everyone else moves up a slot.
+        SolutionCacheData* degraded = entry->plannerData[0];
+        entry->plannerData.erase(entry->plannerData.begin());
+        entry->plannerData.push_back(degraded);
+
+        // Keep the backup solution pointing at the same plan in its new position.
+        if (entry->backupSoln) {
+            if (0 == *entry->backupSoln) {
+                entry->backupSoln.reset(entry->plannerData.size() - 1);
+            }
+            else if (1 == *entry->backupSoln) {
+                // The backup just became the winner itself; a separate backup no
+                // longer makes sense.
+                entry->backupSoln = boost::none;
+            }
+            else {
+                entry->backupSoln.reset(*entry->backupSoln - 1);
+            }
+        }
+
+        // Drop the degraded winner's feedback; the promoted plan collects its own and is
+        // revalidated by the same degradation check.  'decision' deliberately keeps the
+        // original trial ordering -- it documents why the entry was cached and is only
+        // used for reporting.
+        for (size_t i = 0; i < entry->feedback.size(); ++i) {
+            delete entry->feedback[i];
+        }
+        entry->feedback.clear();
+        entry->averageScore = boost::none;
+        entry->stddevScore = boost::none;
+
+        entry->demotions = demotions + 1;
         return entry;
     }
 
@@ -242,6 +284,82 @@ namespace mongo {
         return ss;
     }
 
+    BSONObj PlanCacheIndexTree::toBSON() const {
+        BSONObjBuilder bob;
+        if (NULL != entry.get()) {
+            BSONObjBuilder indexBob(bob.subobjStart("index"));
+            indexBob.append("keyPattern", entry->keyPattern);
+            indexBob.append("name", entry->name);
+            indexBob.append("multikey", entry->multikey);
+            indexBob.append("sparse", entry->sparse);
+            indexBob.append("infoObj", entry->infoObj);
+            indexBob.doneFast();
+            bob.appendNumber("indexPos", static_cast<long long>(index_pos));
+        }
+        if (!children.empty()) {
+            BSONArrayBuilder childrenBob(bob.subarrayStart("children"));
+            for (vector<PlanCacheIndexTree*>::const_iterator it = children.begin();
+                    it != children.end(); ++it) {
+                childrenBob.append((*it)->toBSON());
+            }
+            childrenBob.doneFast();
+        }
+        return bob.obj();
+    }
+
+    // static
+    Status PlanCacheIndexTree::parse(const BSONObj& obj, PlanCacheIndexTree** out) {
+        verify(out);
+        std::auto_ptr<PlanCacheIndexTree> tree(new PlanCacheIndexTree());
+
+        BSONElement indexElt = obj["index"];
+        if (!indexElt.eoo()) {
+            if (!indexElt.isABSONObj()) {
+                return Status(ErrorCodes::BadValue, "index field must be an object");
+            }
+            BSONObj indexObj = indexElt.Obj();
+            BSONElement keyPatternElt = indexObj["keyPattern"];
+            BSONElement nameElt = indexObj["name"];
+            if (!keyPatternElt.isABSONObj() || nameElt.type() != String) {
+                return Status(ErrorCodes::BadValue,
+                              "index field requires keyPattern object and name string");
+            }
+            BSONObj infoObj;
+            if (indexObj["infoObj"].isABSONObj()) {
+                infoObj = indexObj["infoObj"].Obj().getOwned();
+            }
+            tree->setIndexEntry(IndexEntry(keyPatternElt.Obj().getOwned(),
+                                           indexObj["multikey"].trueValue(),
+                                           indexObj["sparse"].trueValue(),
+                                           nameElt.String(),
+                                           infoObj));
+            tree->index_pos = static_cast<size_t>(obj["indexPos"].numberLong());
+        }
+
+        BSONElement childrenElt = obj["children"];
+        if (!childrenElt.eoo()) {
+            if (childrenElt.type() != Array) {
+                return Status(ErrorCodes::BadValue, "children field must be an array");
+            }
+            BSONObjIterator i(childrenElt.Obj());
+            while (i.more()) {
+                BSONElement childElt = i.next();
+                if (!childElt.isABSONObj()) {
+                    return Status(ErrorCodes::BadValue, "child tree must be an object");
+                }
+                PlanCacheIndexTree* child;
+                Status status = parse(childElt.Obj(), &child);
+                if (!status.isOK()) {
+                    return status;
+                }
+                tree->children.push_back(child);
+            }
+        }
+
+        *out = tree.release();
+        return Status::OK();
+    }
+
     //
     // SolutionCacheData
     //
@@ -281,13 +399,95 @@ namespace mongo {
         return ss;
     }
 
+    namespace {
+        // Stable names for SolutionCacheData::SolutionType in the persisted format.
+        // The enum values themselves are not stored so that reordering the enum
+        // cannot silently change the meaning of old documents.
+        const char kWholeIxscanSolnType[] = "wholeIxscan";
+        const char kCollscanSolnType[] = "collscan";
+        const char kIndexTagsSolnType[] = "ixtags";
+    }
+
+    BSONObj SolutionCacheData::toBSON() const {
+        BSONObjBuilder bob;
+        switch (this->solnType) {
+        case WHOLE_IXSCAN_SOLN:
+            bob.append("solnType", kWholeIxscanSolnType);
+            bob.append("wholeIXSolnDir", this->wholeIXSolnDir);
+            break;
+        case COLLSCAN_SOLN:
+            bob.append("solnType", kCollscanSolnType);
+            break;
+        case USE_INDEX_TAGS_SOLN:
+            bob.append("solnType", kIndexTagsSolnType);
+        }
+        bob.append("indexFilterApplied", this->indexFilterApplied);
+        if (NULL != this->tree.get()) {
+            bob.append("tree", this->tree->toBSON());
+        }
+        return bob.obj();
+    }
+
+    // static
+    Status SolutionCacheData::parse(const BSONObj& obj, SolutionCacheData** out) {
+        verify(out);
+        std::auto_ptr<SolutionCacheData> scd(new SolutionCacheData());
+
+        BSONElement solnTypeElt = obj["solnType"];
+        if (solnTypeElt.type() != String) {
+            return Status(ErrorCodes::BadValue, "solnType field must be a string");
+        }
+        std::string solnTypeStr = solnTypeElt.String();
+        if (kWholeIxscanSolnType == solnTypeStr) {
+            scd->solnType = WHOLE_IXSCAN_SOLN;
+        }
+        else if (kCollscanSolnType == solnTypeStr) {
+            scd->solnType = COLLSCAN_SOLN;
+        }
+        else if (kIndexTagsSolnType == solnTypeStr) {
+            scd->solnType = USE_INDEX_TAGS_SOLN;
+        }
+        else {
+            return Status(ErrorCodes::BadValue,
+                          "unknown solution type: " + solnTypeStr);
+        }
+
+        if (obj["wholeIXSolnDir"].isNumber()) {
+            scd->wholeIXSolnDir = obj["wholeIXSolnDir"].numberInt();
+        }
+        scd->indexFilterApplied = obj["indexFilterApplied"].trueValue();
+
+        BSONElement treeElt = obj["tree"];
+        if (!treeElt.eoo()) {
+            if (!treeElt.isABSONObj()) {
+                return Status(ErrorCodes::BadValue, "tree field must be an object");
+            }
+            PlanCacheIndexTree* tree;
+            Status status = PlanCacheIndexTree::parse(treeElt.Obj(), &tree);
+            if (!status.isOK()) {
+                return status;
+            }
+            scd->tree.reset(tree);
+        }
+        else if (COLLSCAN_SOLN != scd->solnType) {
+            return Status(ErrorCodes::BadValue,
+                          "only a collection scan solution may omit the tree");
+        }
+
+        *out = scd.release();
+        return Status::OK();
+    }
+
     //
     // PlanCache
     //
 
-    PlanCache::PlanCache() : _cache(kMaxCacheSize) { }
+    PlanCache::PlanCache() : _cache(kMaxCacheSize), _snapshot(new Snapshot()) { }
 
-    PlanCache::PlanCache(const std::string& ns) : _cache(kMaxCacheSize), _ns(ns) { }
+    PlanCache::PlanCache(const std::string& ns)
+        : _cache(kMaxCacheSize),
+          _snapshot(new Snapshot()),
+          _ns(ns) { }
 
     PlanCache::~PlanCache() { }
 
@@ -332,30 +532,83 @@ namespace mongo {
         }
 
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        std::auto_ptr<PlanCacheEntry> evictedEntry = _cache.add(query.getPlanCacheKey(), entry);
+        std::auto_ptr< boost::shared_ptr<PlanCacheEntry> > evictedEntry =
+            _cache.add(query.getPlanCacheKey(), new boost::shared_ptr<PlanCacheEntry>(entry));
 
         if (NULL != evictedEntry.get()) {
             LOG(1) << _ns << ": plan cache maximum size exceeded - "
                    << "removed least recently used entry "
-                   << evictedEntry->toString();
+                   << (*evictedEntry)->toString();
         }
 
+        _publishSnapshot_inlock();
+
+        return Status::OK();
+    }
+
+    Status PlanCache::addRestored(const CanonicalQuery& query, SolutionCacheData* winnerData) {
+        invariant(winnerData);
+
+        // Only the winner survives a restart, so the restored entry holds a single
+        // solution.  The original ranking decision is gone; install a placeholder so the
+        // entry stays well formed for the plan cache commands.  Feedback collected from
+        // live runs re-ranks or evicts the entry exactly as it would a freshly cached one.
+        QuerySolution soln;
+        soln.cacheData.reset(winnerData);
+        std::vector<QuerySolution*> solns(1, &soln);
+
+        std::auto_ptr<PlanRankingDecision> why(new PlanRankingDecision());
+        why->stats.mutableVector().push_back(new PlanStageStats(CommonStats(), STAGE_UNKNOWN));
+        why->scores.push_back(0);
+        why->candidateOrder.push_back(0);
+
+        std::auto_ptr<PlanCacheEntry> entry(new PlanCacheEntry(solns, why.release()));
+        const LiteParsedQuery& pq = query.getParsed();
+        entry->query = pq.getFilter().getOwned();
+        entry->sort = pq.getSort().getOwned();
+        entry->projection = pq.getProj().getOwned();
+
+        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        if (_cache.hasKey(query.getPlanCacheKey())) {
+            // Anything cached since startup is fresher than the persisted image.
+            return Status(ErrorCodes::BadValue,
+                          "not restoring persisted plan over a live cache entry");
+        }
+        std::auto_ptr< boost::shared_ptr<PlanCacheEntry> > evictedEntry =
+            _cache.add(query.getPlanCacheKey(),
+                       new boost::shared_ptr<PlanCacheEntry>(entry.release()));
+
+        if (NULL != evictedEntry.get()) {
+            LOG(1) << _ns << ": plan cache maximum size exceeded - "
+                   << "removed least recently used entry "
+                   << (*evictedEntry)->toString();
+        }
+
+        _publishSnapshot_inlock();
+
         return Status::OK();
     }
 
     Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const {
-        const PlanCacheKey& key = query.getPlanCacheKey();
+        return get(query.getPlanCacheKey(), crOut);
+    }
+
+    Status PlanCache::get(const PlanCacheKey& key, CachedSolution** crOut) const {
         verify(crOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
-        if (!cacheStatus.isOK()) {
-            return cacheStatus;
+        // Read from the last published snapshot rather than '_cache' so that lookups never
+        // contend on '_cacheMutex'.  The snapshot's shared_ptr keeps the entry alive even
+        // if a concurrent writer evicts it, and the fields CachedSolution copies are
+        // immutable once the entry is published (feedback bookkeeping is mutable, but only
+        // touched under the mutex and never read here).  The tradeoff is that lookups no
+        // longer promote the entry in the LRU list; recency is driven by writes alone.
+        boost::shared_ptr<const Snapshot> snapshot = boost::atomic_load(&_snapshot);
+        Snapshot::const_iterator i = snapshot->find(key);
+        if (i == snapshot->end()) {
+            return Status(ErrorCodes::NoSuchKey, "no such key in LRU key-value store");
         }
-        invariant(entry);
 
-        *crOut = new CachedSolution(key, *entry);
+        *crOut = new CachedSolution(key, *i->second);
 
         return Status::OK();
     }
@@ -419,20 +672,37 @@ namespace mongo {
         const PlanCacheKey& ck = cq.getPlanCacheKey();
 
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(ck, &entry);
+        boost::shared_ptr<PlanCacheEntry>* entryHolder;
+        Status cacheStatus = _cache.get(ck, &entryHolder);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
+        PlanCacheEntry* entry = entryHolder->get();
         invariant(entry);
 
         if (entry->feedback.size() >= PlanCacheEntry::kMaxFeedback) {
-            // If we have enough feedback, then use it to determine whether
-            // we should get rid of the cached solution.
+            // If we have enough feedback, then use it to re-rank the entry's candidates.
             if (hasCachedPlanPerformanceDegraded(entry, autoFeedback.get())) {
-                LOG(1) << _ns << ": removing plan cache entry " << entry->toString()
-                       << " - detected degradation in performance of cached solution.";
-                _cache.remove(ck);
+                if (entry->demotions + 1 < entry->plannerData.size()) {
+                    // The winner's live performance has fallen off, but we still know the
+                    // runner-up plans from the original trial.  Promote the next-best
+                    // candidate so production queries are served from the cache
+                    // immediately instead of re-racing every candidate in the foreground.
+                    // The promoted plan has to survive the same feedback gauntlet or it
+                    // gets demoted too.  Published entries are immutable, so install a
+                    // rotated replacement; readers of the old snapshot keep their copy.
+                    LOG(1) << _ns << ": demoting winner of plan cache entry "
+                           << entry->toString()
+                           << " - detected degradation in performance of cached solution.";
+                    entryHolder->reset(entry->cloneWithNextCandidate());
+                }
+                else {
+                    // Every candidate has had its turn; make the next query replan.
+                    LOG(1) << _ns << ": removing plan cache entry " << entry->toString()
+                           << " - all candidate plans have degraded.";
+                    _cache.remove(ck);
+                }
+                _publishSnapshot_inlock();
             }
         }
         else {
@@ -445,12 +715,17 @@ namespace mongo {
 
     Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.remove(canonicalQuery.getPlanCacheKey());
+        Status removeStatus = _cache.remove(canonicalQuery.getPlanCacheKey());
+        if (removeStatus.isOK()) {
+            _publishSnapshot_inlock();
+        }
+        return removeStatus;
     }
 
     void PlanCache::clear() {
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         _cache.clear();
+        _publishSnapshot_inlock();
         _writeOperations.store(0);
     }
 
@@ -459,14 +734,14 @@ namespace mongo {
         verify(entryOut);
 
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        boost::shared_ptr<PlanCacheEntry>* entryHolder;
+        Status cacheStatus = _cache.get(key, &entryHolder);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
-        invariant(entry);
+        invariant(entryHolder->get());
 
-        *entryOut = entry->clone();
+        *entryOut = (*entryHolder)->clone();
 
         return Status::OK();
     }
@@ -474,15 +749,28 @@ namespace mongo {
     std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         std::vector<PlanCacheEntry*> entries;
-        typedef std::list< std::pair<PlanCacheKey, PlanCacheEntry*> >::const_iterator ConstIterator;
+        typedef std::list< std::pair<PlanCacheKey,
+                                     boost::shared_ptr<PlanCacheEntry>*> >::const_iterator
+            ConstIterator;
         for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-            PlanCacheEntry* entry = i->second;
+            PlanCacheEntry* entry = i->second->get();
             entries.push_back(entry->clone());
         }
 
         return entries;
     }
 
+    void PlanCache::_publishSnapshot_inlock() {
+        boost::shared_ptr<Snapshot> snapshot(new Snapshot());
+        typedef std::list< std::pair<PlanCacheKey,
+                                     boost::shared_ptr<PlanCacheEntry>*> >::const_iterator
+            ConstIterator;
+        for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
+            (*snapshot)[i->first] = *i->second;
+        }
+        boost::atomic_store(&_snapshot, boost::shared_ptr<const Snapshot>(snapshot));
+    }
+
     bool PlanCache::contains(const CanonicalQuery& cq) const {
         boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         return _cache.hasKey(cq.getPlanCacheKey());
@@ -30,6 +30,7 @@
 
 #include <set>
 #include <boost/optional/optional.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/db/exec/plan_stats.h"
@@ -38,6 +39,7 @@
 #include "mongo/db/query/lru_key_value.h"
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
 
@@ -106,6 +108,17 @@ namespace mongo {
          */
         std::string toString(int indents = 0) const;
 
+        /**
+         * Serialize to BSON for plan cache persistence.
+         */
+        BSONObj toBSON() const;
+
+        /**
+         * Parse a tree serialized by toBSON().  On success, returns Status::OK() and
+         * the caller owns '*out'.
+         */
+        static Status parse(const BSONObj& obj, PlanCacheIndexTree** out);
+
         // Children owned here.
         std::vector<PlanCacheIndexTree*> children;
 
@@ -135,6 +148,17 @@ namespace mongo {
         // For debugging.
         std::string toString() const;
 
+        /**
+         * Serialize to BSON for plan cache persistence.
+         */
+        BSONObj toBSON() const;
+
+        /**
+         * Parse cache data serialized by toBSON().  On success, returns Status::OK() and
+         * the caller owns '*out'.
+         */
+        static Status parse(const BSONObj& obj, SolutionCacheData** out);
+
         // Owned here. If 'wholeIXSoln' is false, then 'tree'
         // can be used to tag an isomorphic match expression. If 'wholeIXSoln'
         // is true, then 'tree' is used to store the relevant IndexEntry.
@@ -220,6 +244,14 @@ namespace mongo {
          */
         PlanCacheEntry* clone() const;
 
+        /**
+         * Make a deep copy with the current winner (plannerData[0]) rotated to the back,
+         * so the runner-up candidate from the original trial is served next.  Accumulated
+         * feedback is dropped; the promoted plan starts collecting its own.  Used by
+         * PlanCache::feedback() when the winner's live performance degrades.
+         */
+        PlanCacheEntry* cloneWithNextCandidate() const;
+
         // For debugging.
         std::string toString() const;
 
@@ -263,6 +295,11 @@ namespace mongo {
         // The standard deviation of the scores from stored as feedback.
         boost::optional<double> stddevScore;
 
+        // How many times a degraded winner has been demoted in favor of the next-best
+        // candidate.  Once every candidate has had a turn, the entry is removed and the
+        // next query replans from scratch.
+        size_t demotions;
+
         // Determines the amount of feedback that we are willing to store. Must be >= 1.
         // TODO: how do we tune this?
         static const size_t kMaxFeedback;
@@ -329,10 +366,29 @@ namespace mongo {
                    const std::vector<QuerySolution*>& solns,
                    PlanRankingDecision* why);
 
+        /**
+         * Install an entry recovered from the persisted plan cache (see
+         * plan_cache_persistence.h).  Only the winning plan survives a restart, so the
+         * entry holds a single solution and a placeholder ranking decision; the restored
+         * plan earns (or loses) its place through the normal feedback mechanism once it
+         * runs.
+         *
+         * Takes ownership of 'winnerData'.
+         *
+         * If an entry for the query's shape already exists it is left alone - anything
+         * cached since startup is fresher than the persisted image - and an error Status
+         * is returned.
+         */
+        Status addRestored(const CanonicalQuery& query, SolutionCacheData* winnerData);
+
         /**
          * Look up the cached data access for the provided 'query'.  Used by the query planner
          * to shortcut planning.
          *
+         * Lock-free: reads from the last published cache snapshot and does not take
+         * '_cacheMutex', so concurrent lookups never serialize against each other or
+         * against writers.
+         *
          * If there is no entry in the cache for the 'query', returns an error Status.
          *
          * If there is an entry in the cache, populates 'crOut' and returns Status::OK().  Caller
@@ -340,6 +396,13 @@ namespace mongo {
          */
         Status get(const CanonicalQuery& query, CachedSolution** crOut) const;
 
+        /**
+         * As above, but keyed by a previously computed shape key.  Callers that hold on to
+         * the key of a query shape (see CanonicalQuery::getPlanCacheKey()) can probe the
+         * cache directly without re-canonicalizing the query.
+         */
+        Status get(const PlanCacheKey& key, CachedSolution** crOut) const;
+
         /**
          * When the CachedPlanRunner runs a plan out of the cache, we want to record data about the
          * plan's performance.  The CachedPlanRunner calls feedback(...) at the end of query
@@ -353,8 +416,11 @@ namespace mongo {
          * If the entry corresponding to 'cq' still exists, 'feedback' is added to the run
          * statistics about the plan.  Status::OK() is returned.
          *
-         * May cause the cache entry to be removed if it is determined that the cached plan
-         * is badly performing.
+         * If the live scores show that the cached plan's performance has degraded, the
+         * entry is re-ranked: the next-best candidate from the original trial is promoted
+         * to the front so production queries keep being served from the cache instead of
+         * re-racing every candidate in the foreground.  Only once every candidate has been
+         * tried and found wanting is the entry removed.
          */
         Status feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback);
 
@@ -409,19 +475,35 @@ namespace mongo {
     private:
 
         /**
-         * Releases resources associated with each cache entry
-         * and clears map.
-         * Invoked by clear() and during destruction.
+         * An immutable point-in-time view of the cache contents, shared with readers.
+         * The shared_ptr values keep entries alive for in-flight get() calls even after
+         * the entry has been evicted or removed from the LRU store.
          */
-        void _clear();
+        typedef unordered_map<PlanCacheKey, boost::shared_ptr<PlanCacheEntry> > Snapshot;
 
-        LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+        /**
+         * Rebuilds the snapshot from '_cache' and publishes it for readers.
+         * Must be called with '_cacheMutex' held, after any mutation of '_cache'.
+         */
+        void _publishSnapshot_inlock();
+
+        /**
+         * Entries are held by shared_ptr so that ownership can be shared between the LRU
+         * store and published snapshots; the LRU store owns the shared_ptr holders.
+         */
+        LRUKeyValue<PlanCacheKey, boost::shared_ptr<PlanCacheEntry> > _cache;
 
         /**
-         * Protects _cache.
+         * Protects _cache.  Readers do not take this; they use '_snapshot'.
          */
         mutable boost::mutex _cacheMutex;
 
+        /**
+         * The last published view of '_cache', accessed by readers with
+         * boost::atomic_load() and replaced by writers with boost::atomic_store().
+         */
+        boost::shared_ptr<const Snapshot> _snapshot;
+
         /**
          * Counter for write notifications since initialization or last clear() invocation.
          * Starts at 0.
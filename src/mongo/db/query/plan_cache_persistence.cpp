@@ -0,0 +1,343 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/query/plan_cache_persistence.h"
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/fsync.h"
+#include "mongo/db/d_concurrency.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER( planCachePersistenceEnabled, bool, true );
+
+    // Seconds between snapshots of the plan caches into 'local.plan_cache'.
+    MONGO_EXPORT_SERVER_PARAMETER( planCachePersistenceIntervalSecs, int, 300 );
+
+    namespace {
+
+        const char kPlanCacheNS[] = "local.plan_cache";
+
+        // Persisted entries read at startup and not yet installed, grouped by the
+        // namespace they belong to.  Entries leave the staging area the first time
+        // their collection's plan cache is used, whether or not they survive
+        // revalidation.
+        typedef unordered_map< string, vector<BSONObj> > StagedEntryMap;
+        StagedEntryMap stagedEntries;
+        SimpleMutex stagedMutex("planCacheStaging");
+
+        // Total staged documents; lets restorePlanCacheEntries() bail out without
+        // taking 'stagedMutex' on the common every-query path once (or if) there is
+        // nothing left to restore.
+        AtomicWord<int> stagedCount;
+
+        /**
+         * The persisted entry may predate index changes.  Every index referenced by
+         * 'tree' must still exist with the same name and key pattern or the entry is
+         * rejected; per-index state that can drift while the server is down
+         * (multikey, sparse, access method, infoObj) is refreshed from the live
+         * catalog.  Returns true if the tree is still valid.
+         */
+        bool revalidateTree(Collection* collection, PlanCacheIndexTree* tree) {
+            if (NULL == tree) {
+                // Collection scan.
+                return true;
+            }
+            if (NULL != tree->entry.get()) {
+                const IndexDescriptor* desc =
+                    collection->getIndexCatalog()->findIndexByName(tree->entry->name);
+                if (NULL == desc || desc->keyPattern() != tree->entry->keyPattern) {
+                    return false;
+                }
+                tree->setIndexEntry(IndexEntry(desc->keyPattern(),
+                                               desc->getAccessMethodName(),
+                                               desc->isMultikey(),
+                                               desc->isSparse(),
+                                               desc->indexName(),
+                                               desc->infoObj()));
+            }
+            for (vector<PlanCacheIndexTree*>::const_iterator it = tree->children.begin();
+                    it != tree->children.end(); ++it) {
+                if (!revalidateTree(collection, *it)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Rebuilds one cache entry from its persisted document.  Returns true if the
+         * entry was installed into 'planCache'.
+         */
+        bool restoreOneEntry(Collection* collection,
+                             PlanCache* planCache,
+                             const BSONObj& doc) {
+            const string& ns = collection->ns().ns();
+
+            BSONElement queryElt = doc["query"];
+            BSONElement sortElt = doc["sort"];
+            BSONElement projElt = doc["projection"];
+            BSONElement winnerElt = doc["winner"];
+            if (!queryElt.isABSONObj() || !sortElt.isABSONObj() ||
+                !projElt.isABSONObj() || !winnerElt.isABSONObj()) {
+                LOG(1) << ns << ": dropping malformed persisted plan cache entry " << doc;
+                return false;
+            }
+
+            // Re-canonicalizing the saved shape recomputes the same plan cache key the
+            // original query produced.
+            CanonicalQuery* cqRaw;
+            Status status = CanonicalQuery::canonicalize(ns, queryElt.Obj(), sortElt.Obj(),
+                                                         projElt.Obj(), &cqRaw);
+            if (!status.isOK()) {
+                LOG(1) << ns << ": dropping persisted plan cache entry " << doc
+                       << " - " << status.toString();
+                return false;
+            }
+            scoped_ptr<CanonicalQuery> cq(cqRaw);
+
+            SolutionCacheData* scdRaw;
+            status = SolutionCacheData::parse(winnerElt.Obj(), &scdRaw);
+            if (!status.isOK()) {
+                LOG(1) << ns << ": dropping persisted plan cache entry " << doc
+                       << " - " << status.toString();
+                return false;
+            }
+            auto_ptr<SolutionCacheData> scd(scdRaw);
+
+            if (!revalidateTree(collection, scd->tree.get())) {
+                LOG(1) << ns << ": dropping persisted plan cache entry "
+                       << cq->getQueryObj().toString()
+                       << " - referenced index no longer exists";
+                return false;
+            }
+
+            return planCache->addRestored(*cq, scd.release()).isOK();
+        }
+
+        /**
+         * Periodically rewrites 'local.plan_cache' from the live plan caches so the
+         * next startup can resume with this instance's plans.
+         */
+        class PlanCacheSaver : public BackgroundJob {
+        public:
+            virtual string name() const { return "PlanCacheSaver"; }
+
+            virtual void run() {
+                Client::initThread( name().c_str() );
+                cc().getAuthorizationSession()->grantInternalAuthorization();
+
+                while ( ! inShutdown() ) {
+                    sleepsecs( std::max( 1, planCachePersistenceIntervalSecs ) );
+
+                    LOG(3) << "PlanCacheSaver thread awake" << endl;
+
+                    if ( !planCachePersistenceEnabled ) {
+                        LOG(1) << "plan cache persistence is disabled" << endl;
+                        continue;
+                    }
+
+                    if ( lockedForWriting() ) {
+                        LOG(3) << " locked for writing" << endl;
+                        continue;
+                    }
+
+                    try {
+                        savePass();
+                    }
+                    catch ( DBException& e ) {
+                        error() << "error saving plan caches: " << e << endl;
+                    }
+                }
+
+                cc().shutdown();
+            }
+
+        private:
+            void savePass() {
+                set<string> dbs;
+                {
+                    Lock::DBRead lk( "local" );
+                    dbHolder().getAllShortNames( dbs );
+                }
+
+                vector<BSONObj> docs;
+                for ( set<string>::const_iterator i = dbs.begin(); i != dbs.end(); ++i ) {
+                    if ( *i == "local" )
+                        continue;
+                    try {
+                        collectDbEntries( *i, &docs );
+                    }
+                    catch ( DBException& e ) {
+                        error() << "error collecting plan cache entries for db: " << *i
+                                << " " << e << endl;
+                    }
+                }
+
+                // Carry forward anything still staged: a collection that has not been
+                // queried since startup keeps its persisted plans across further
+                // restarts instead of losing them to the rewrite below.
+                {
+                    SimpleMutex::scoped_lock lk( stagedMutex );
+                    for ( StagedEntryMap::const_iterator i = stagedEntries.begin();
+                            i != stagedEntries.end(); ++i ) {
+                        docs.insert( docs.end(), i->second.begin(), i->second.end() );
+                    }
+                }
+
+                // Rewrite the whole image each pass; with at most a few hundred
+                // entries per collection this is cheaper than reconciling documents
+                // against evicted and mutated cache entries.
+                db.remove( kPlanCacheNS, BSONObj() );
+                for ( size_t i = 0; i < docs.size(); i++ ) {
+                    db.insert( kPlanCacheNS, docs[i] );
+                }
+
+                LOG(1) << "plan cache persistence: saved " << docs.size() << " entries" << endl;
+            }
+
+            void collectDbEntries( const string& dbName, vector<BSONObj>* docs ) {
+                vector<string> collections;
+                {
+                    auto_ptr<DBClientCursor> cursor =
+                        db.query( dbName + ".system.namespaces", Query() );
+                    while ( cursor.get() && cursor->more() ) {
+                        BSONObj nsObj = cursor->next();
+                        if ( nsObj["name"].type() != String )
+                            continue;
+                        string ns = nsObj["name"].String();
+                        if ( ns.find( '$' ) != string::npos )
+                            continue;
+                        if ( ns.find( ".system." ) != string::npos )
+                            continue;
+                        collections.push_back( ns );
+                    }
+                }
+
+                for ( size_t i = 0; i < collections.size(); i++ ) {
+                    collectCollectionEntries( collections[i], docs );
+                }
+            }
+
+            void collectCollectionEntries( const string& ns, vector<BSONObj>* docs ) {
+                Client::ReadContext ctx( ns );
+                Collection* collection = ctx.ctx().db()->getCollection( ns );
+                if ( !collection )
+                    return;
+
+                vector<PlanCacheEntry*> entries =
+                    collection->infoCache()->getPlanCache()->getAllEntries();
+                for ( size_t i = 0; i < entries.size(); i++ ) {
+                    scoped_ptr<PlanCacheEntry> entry( entries[i] );
+                    if ( entry->plannerData.empty() )
+                        continue;
+                    BSONObjBuilder bob;
+                    bob.append( "ns", ns );
+                    bob.append( "query", entry->query );
+                    bob.append( "sort", entry->sort );
+                    bob.append( "projection", entry->projection );
+                    bob.append( "winner", entry->plannerData[0]->toBSON() );
+                    docs->push_back( bob.obj() );
+                }
+            }
+
+            DBDirectClient db;
+        };
+
+        void loadStagedEntries() {
+            DBDirectClient db;
+            auto_ptr<DBClientCursor> cursor = db.query( kPlanCacheNS, Query() );
+            int n = 0;
+            SimpleMutex::scoped_lock lk( stagedMutex );
+            while ( cursor.get() && cursor->more() ) {
+                BSONObj doc = cursor->next();
+                if ( doc["ns"].type() != String )
+                    continue;
+                stagedEntries[ doc["ns"].String() ].push_back( doc.getOwned() );
+                n++;
+            }
+            stagedCount.store( n );
+            if ( n ) {
+                log() << "plan cache persistence: staged " << n
+                      << " entries for lazy restore" << endl;
+            }
+        }
+
+    }  // namespace
+
+    void restorePlanCacheEntries( Collection* collection, PlanCache* planCache ) {
+        if ( 0 == stagedCount.load() )
+            return;
+
+        vector<BSONObj> docs;
+        {
+            SimpleMutex::scoped_lock lk( stagedMutex );
+            StagedEntryMap::iterator it = stagedEntries.find( collection->ns().ns() );
+            if ( it == stagedEntries.end() )
+                return;
+            docs.swap( it->second );
+            stagedEntries.erase( it );
+            stagedCount.fetchAndAdd( -static_cast<int>( docs.size() ) );
+        }
+
+        int restored = 0;
+        for ( size_t i = 0; i < docs.size(); i++ ) {
+            if ( restoreOneEntry( collection, planCache, docs[i] ) )
+                restored++;
+        }
+
+        if ( restored ) {
+            LOG(1) << collection->ns().ns() << ": restored " << restored
+                   << " plan cache entries from previous instance" << endl;
+        }
+    }
+
+    void startPlanCachePersistence() {
+        if ( planCachePersistenceEnabled ) {
+            loadStagedEntries();
+        }
+        PlanCacheSaver* saver = new PlanCacheSaver();
+        saver->go();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,66 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    class Collection;
+    class PlanCache;
+
+    /**
+     * Plan cache persistence lets a restarted mongod resume with the previous
+     * instance's query plans instead of re-racing the multi plan runner for every
+     * query shape while the caches warm up.
+     *
+     * A background job periodically snapshots every collection's plan cache - the
+     * query shape plus the winning plan's SolutionCacheData - into the unreplicated
+     * 'local.plan_cache' collection.  At startup the saved documents are read back
+     * into an in-memory staging area; the first time a collection's plan cache is
+     * used, the staged entries for that collection are revalidated against its
+     * current IndexCatalog (every referenced index must still exist with the same
+     * name and key pattern) and installed via PlanCache::addRestored().  Entries
+     * that no longer match the index set are discarded, and restored plans are
+     * subject to the usual run-time feedback checks.
+     */
+
+    /**
+     * Reads 'local.plan_cache' into the staging area and starts the background
+     * snapshot job.  Called once during startup.
+     */
+    void startPlanCachePersistence();
+
+    /**
+     * Installs any staged entries for 'collection' into 'planCache'.  Called by
+     * CollectionInfoCache the first time the plan cache is requested; cheap no-op
+     * when nothing is staged.  Caller must hold at least a read lock on the
+     * collection's database.
+     */
+    void restorePlanCacheEntries(Collection* collection, PlanCache* planCache);
+
+}  // namespace mongo
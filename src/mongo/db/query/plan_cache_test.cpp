@@ -376,6 +376,95 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    TEST(PlanCacheTest, AddRestoredSolution) {
+        PlanCache planCache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+
+        SolutionCacheData* scd = new SolutionCacheData();
+        scd->tree.reset(new PlanCacheIndexTree());
+        ASSERT_OK(planCache.addRestored(*cq, scd));
+        ASSERT_TRUE(planCache.contains(*cq));
+
+        // The restored entry is served like any other.
+        CachedSolution* crRaw;
+        ASSERT_OK(planCache.get(*cq, &crRaw));
+        auto_ptr<CachedSolution> cr(crRaw);
+        ASSERT_EQUALS(cr->plannerData.size(), 1U);
+
+        // A live entry is never overwritten by a restored one.
+        SolutionCacheData* other = new SolutionCacheData();
+        other->tree.reset(new PlanCacheIndexTree());
+        ASSERT_NOT_OK(planCache.addRestored(*cq, other));
+        ASSERT_EQUALS(planCache.size(), 1U);
+    }
+
+    //
+    // Tests for cache data serialization, used by plan cache persistence.
+    //
+
+    TEST(SolutionCacheDataTest, RoundTripIndexTagsSolution) {
+        SolutionCacheData scd;
+        scd.solnType = SolutionCacheData::USE_INDEX_TAGS_SOLN;
+        scd.indexFilterApplied = true;
+        scd.tree.reset(new PlanCacheIndexTree());
+        PlanCacheIndexTree* child = new PlanCacheIndexTree();
+        child->setIndexEntry(IndexEntry(BSON("a" << 1), false, true, "a_1", BSONObj()));
+        child->index_pos = 1;
+        scd.tree->children.push_back(child);
+
+        SolutionCacheData* parsedRaw;
+        ASSERT_OK(SolutionCacheData::parse(scd.toBSON(), &parsedRaw));
+        auto_ptr<SolutionCacheData> parsed(parsedRaw);
+
+        ASSERT_EQUALS(parsed->solnType, SolutionCacheData::USE_INDEX_TAGS_SOLN);
+        ASSERT_TRUE(parsed->indexFilterApplied);
+        ASSERT_EQUALS(parsed->tree->children.size(), 1U);
+        const IndexEntry* entry = parsed->tree->children[0]->entry.get();
+        ASSERT(NULL != entry);
+        ASSERT_TRUE(entry->keyPattern == BSON("a" << 1));
+        ASSERT_EQUALS(entry->name, "a_1");
+        ASSERT_TRUE(entry->sparse);
+        ASSERT_FALSE(entry->multikey);
+        ASSERT_EQUALS(parsed->tree->children[0]->index_pos, 1U);
+        ASSERT_EQUALS(scd.toString(), parsed->toString());
+    }
+
+    TEST(SolutionCacheDataTest, RoundTripWholeIxscanSolution) {
+        SolutionCacheData scd;
+        scd.solnType = SolutionCacheData::WHOLE_IXSCAN_SOLN;
+        scd.wholeIXSolnDir = -1;
+        scd.tree.reset(new PlanCacheIndexTree());
+        scd.tree->setIndexEntry(IndexEntry(BSON("b" << -1), true, false, "b_-1", BSONObj()));
+
+        SolutionCacheData* parsedRaw;
+        ASSERT_OK(SolutionCacheData::parse(scd.toBSON(), &parsedRaw));
+        auto_ptr<SolutionCacheData> parsed(parsedRaw);
+
+        ASSERT_EQUALS(parsed->solnType, SolutionCacheData::WHOLE_IXSCAN_SOLN);
+        ASSERT_EQUALS(parsed->wholeIXSolnDir, -1);
+        ASSERT_EQUALS(scd.toString(), parsed->toString());
+    }
+
+    TEST(SolutionCacheDataTest, RoundTripCollscanSolution) {
+        SolutionCacheData scd;
+        scd.solnType = SolutionCacheData::COLLSCAN_SOLN;
+
+        SolutionCacheData* parsedRaw;
+        ASSERT_OK(SolutionCacheData::parse(scd.toBSON(), &parsedRaw));
+        auto_ptr<SolutionCacheData> parsed(parsedRaw);
+
+        ASSERT_EQUALS(parsed->solnType, SolutionCacheData::COLLSCAN_SOLN);
+        ASSERT_TRUE(NULL == parsed->tree.get());
+    }
+
+    TEST(SolutionCacheDataTest, ParseRejectsBadInput) {
+        SolutionCacheData* parsedRaw;
+        ASSERT_NOT_OK(SolutionCacheData::parse(BSONObj(), &parsedRaw));
+        ASSERT_NOT_OK(SolutionCacheData::parse(fromjson("{solnType: 'nosuch'}"), &parsedRaw));
+        // A non-collscan solution must carry a tree.
+        ASSERT_NOT_OK(SolutionCacheData::parse(fromjson("{solnType: 'ixtags'}"), &parsedRaw));
+    }
+
     TEST(PlanCacheTest, NotifyOfWriteOp) {
         PlanCache planCache;
         auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -417,6 +506,59 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    /**
+     * Utility function to create feedback for a cached plan run.
+     */
+    PlanCacheEntryFeedback* createFeedback(double score) {
+        auto_ptr<PlanCacheEntryFeedback> fb(new PlanCacheEntryFeedback());
+        fb->stats.reset(new PlanStageStats(CommonStats(), STAGE_COLLSCAN));
+        fb->score = score;
+        return fb.release();
+    }
+
+    TEST(PlanCacheTest, FeedbackDemotesDegradedWinnerThenRemoves) {
+        PlanCache planCache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+
+        // Two candidates with distinguishable cache data: the winner is a collection
+        // scan, the runner-up an index-tagged solution.
+        QuerySolution winner;
+        winner.cacheData.reset(new SolutionCacheData());
+        winner.cacheData->solnType = SolutionCacheData::COLLSCAN_SOLN;
+        QuerySolution runnerUp;
+        runnerUp.cacheData.reset(new SolutionCacheData());
+        runnerUp.cacheData->solnType = SolutionCacheData::USE_INDEX_TAGS_SOLN;
+        runnerUp.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&winner);
+        solns.push_back(&runnerUp);
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(2U)));
+
+        // The first kMaxFeedback reports build the winner's baseline.
+        for (size_t i = 0; i < PlanCacheEntry::kMaxFeedback; ++i) {
+            ASSERT_OK(planCache.feedback(*cq, createFeedback(1.0)));
+        }
+
+        // A run far below the baseline demotes the winner instead of evicting the
+        // entry: the runner-up is served from the cache afterwards.
+        ASSERT_OK(planCache.feedback(*cq, createFeedback(0.1)));
+        ASSERT_TRUE(planCache.contains(*cq));
+        CachedSolution* rawCS;
+        ASSERT_OK(planCache.get(*cq, &rawCS));
+        auto_ptr<CachedSolution> cs(rawCS);
+        ASSERT_EQUALS(cs->plannerData.size(), 2U);
+        ASSERT_EQUALS(cs->plannerData[0]->solnType, SolutionCacheData::USE_INDEX_TAGS_SOLN);
+        ASSERT_EQUALS(cs->plannerData[1]->solnType, SolutionCacheData::COLLSCAN_SOLN);
+
+        // Once the last candidate degrades too, the entry is removed and the next
+        // query replans from scratch.
+        for (size_t i = 0; i < PlanCacheEntry::kMaxFeedback; ++i) {
+            ASSERT_OK(planCache.feedback(*cq, createFeedback(1.0)));
+        }
+        ASSERT_OK(planCache.feedback(*cq, createFeedback(0.1)));
+        ASSERT_FALSE(planCache.contains(*cq));
+    }
+
     /**
      * Each test in the CachePlanSelectionTest suite goes through
      * the following flow:
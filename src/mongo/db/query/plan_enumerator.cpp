@@ -28,6 +28,7 @@
 
 #include "mongo/db/query/plan_enumerator.h"
 
+#include <algorithm>
 #include <set>
 
 #include "mongo/db/query/indexability.h"
@@ -50,11 +51,28 @@ namespace {
 
 namespace mongo {
 
+    namespace {
+
+        // Maps every node of the tree rooted at 'src' to its counterpart in the
+        // identically-shaped tree rooted at 'dest'.
+        void mapTreeNodes(MatchExpression* src,
+                          MatchExpression* dest,
+                          unordered_map<MatchExpression*, MatchExpression*>* out) {
+            (*out)[src] = dest;
+            verify(src->numChildren() == dest->numChildren());
+            for (size_t i = 0; i < src->numChildren(); ++i) {
+                mapTreeNodes(src->getChild(i), dest->getChild(i), out);
+            }
+        }
+
+    } // namespace
+
     PlanEnumerator::PlanEnumerator(const PlanEnumeratorParams& params)
         : _root(params.root),
           _indices(params.indices),
           _ixisect(params.intersect),
-          _intersectLimit(params.maxIntersectPerAnd) { }
+          _intersectLimit(params.maxIntersectPerAnd),
+          _choiceLimit(params.maxChoicesPerAnd) { }
 
     PlanEnumerator::~PlanEnumerator() {
         typedef unordered_map<MemoID, NodeAssignment*> MemoMap;
@@ -204,7 +222,21 @@ namespace mongo {
         else if (MatchExpression::OR == node->matchType()) {
             // For an OR to be indexed, all its children must be indexed.
             for (size_t i = 0; i < node->numChildren(); ++i) {
-                if (!prepMemo(node->getChild(i), childContext)) {
+                MatchExpression* child = node->getChild(i);
+
+                // If an earlier branch has the same shape and the same relevant indices,
+                // clone its memoized assignments rather than re-running enumeration on
+                // this branch.  Machine-generated $or queries repeat branch shapes a lot.
+                bool cloned = false;
+                for (size_t j = 0; j < i && !cloned; ++j) {
+                    MatchExpression* prev = node->getChild(j);
+                    if (_nodeToId.end() == _nodeToId.find(prev)) {
+                        continue;
+                    }
+                    cloned = cloneMemoSubtree(prev, child);
+                }
+
+                if (!cloned && !prepMemo(child, childContext)) {
                     return false;
                 }
             }
@@ -364,6 +396,8 @@ namespace mongo {
                 enumerateAndIntersect(idxToFirst, idxToNotFirst, subnodes, andAssignment);
             }
 
+            sortAndCapChoices(andAssignment);
+
             return true;
         }
 
@@ -732,6 +766,164 @@ namespace mongo {
         }
     }
 
+    bool PlanEnumerator::choiceIsCheaper(const AndEnumerableState& lhs,
+                                         const AndEnumerableState& rhs) {
+        // More predicates answered by the chosen indices means less residual filtering,
+        // so those choices come first.
+        size_t lhsPreds = 0;
+        for (size_t i = 0; i < lhs.assignments.size(); ++i) {
+            lhsPreds += lhs.assignments[i].preds.size();
+        }
+        size_t rhsPreds = 0;
+        for (size_t i = 0; i < rhs.assignments.size(); ++i) {
+            rhsPreds += rhs.assignments[i].preds.size();
+        }
+        if (lhsPreds != rhsPreds) {
+            return lhsPreds > rhsPreds;
+        }
+
+        // Covering the same predicates with fewer scans is cheaper.
+        return lhs.assignments.size() + lhs.subnodesToIndex.size() <
+               rhs.assignments.size() + rhs.subnodesToIndex.size();
+    }
+
+    void PlanEnumerator::sortAndCapChoices(AndAssignment* andAssignment) {
+        // stable_sort keeps the original (deterministic) order among equal-cost choices.
+        std::stable_sort(andAssignment->choices.begin(),
+                         andAssignment->choices.end(),
+                         choiceIsCheaper);
+        if (andAssignment->choices.size() > _choiceLimit) {
+            andAssignment->choices.resize(_choiceLimit);
+        }
+    }
+
+    bool PlanEnumerator::shapeAndIndexesMatch(MatchExpression* src, MatchExpression* dest) {
+        if (src->matchType() != dest->matchType()) { return false; }
+        if (src->path() != dest->path()) { return false; }
+        if (src->numChildren() != dest->numChildren()) { return false; }
+
+        // Identical shape is not enough: relevant indices are rated per predicate and can
+        // differ even for same-shaped branches (a sparse index is relevant to {a: 5} but
+        // not to {a: null}, for instance).
+        RelevantTag* srcTag = static_cast<RelevantTag*>(src->getTag());
+        RelevantTag* destTag = static_cast<RelevantTag*>(dest->getTag());
+        if ((NULL == srcTag) != (NULL == destTag)) { return false; }
+        if (NULL != srcTag) {
+            // If 'src' became a PredicateAssignment its 'first' list was swapped out of the
+            // tag and into the memo entry; compare against the list's current home.
+            vector<size_t> srcFirst = srcTag->first;
+            unordered_map<MatchExpression*, MemoID>::const_iterator it = _nodeToId.find(src);
+            if (_nodeToId.end() != it) {
+                NodeAssignment* assign = _memo[it->second];
+                if (NULL != assign->pred) {
+                    srcFirst = assign->pred->first;
+                }
+            }
+            if (srcFirst != destTag->first) { return false; }
+            if (srcTag->notFirst != destTag->notFirst) { return false; }
+        }
+
+        for (size_t i = 0; i < src->numChildren(); ++i) {
+            if (!shapeAndIndexesMatch(src->getChild(i), dest->getChild(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool PlanEnumerator::cloneMemoSubtree(MatchExpression* src, MatchExpression* dest) {
+        if (!shapeAndIndexesMatch(src, dest)) { return false; }
+
+        // Map every expression under 'src' to its counterpart under 'dest'.
+        unordered_map<MatchExpression*, MatchExpression*> nodeMap;
+        mapTreeNodes(src, dest, &nodeMap);
+
+        // _nodeToId maps expression to id; subnode lists hold ids, so we need the inverse
+        // to walk them.  The memo is small -- this is cheaper than the enumeration work
+        // the clone is saving.
+        unordered_map<MemoID, MatchExpression*> idToNode;
+        for (unordered_map<MatchExpression*, MemoID>::const_iterator it = _nodeToId.begin();
+             it != _nodeToId.end(); ++it) {
+            idToNode[it->second] = it->first;
+        }
+
+        unordered_map<MemoID, MemoID> cloned;
+        cloneMemoEntry(_nodeToId[src], nodeMap, idToNode, &cloned);
+        return true;
+    }
+
+    PlanEnumerator::MemoID PlanEnumerator::cloneMemoEntry(
+            MemoID srcId,
+            const unordered_map<MatchExpression*, MatchExpression*>& nodeMap,
+            const unordered_map<MemoID, MatchExpression*>& idToNode,
+            unordered_map<MemoID, MemoID>* cloned) {
+
+        // One subnode can appear in several choices of an AndAssignment; clone each memo
+        // entry exactly once.
+        unordered_map<MemoID, MemoID>::const_iterator seen = cloned->find(srcId);
+        if (cloned->end() != seen) { return seen->second; }
+
+        NodeAssignment* src = _memo[srcId];
+        verify(NULL != src);
+
+        MatchExpression* srcExpr = idToNode.find(srcId)->second;
+        MatchExpression* destExpr = nodeMap.find(srcExpr)->second;
+
+        MemoID newId;
+        NodeAssignment* assign;
+        allocateAssignment(destExpr, &assign, &newId);
+        (*cloned)[srcId] = newId;
+
+        if (NULL != src->pred) {
+            PredicateAssignment* pa = new PredicateAssignment();
+            pa->expr = nodeMap.find(src->pred->expr)->second;
+            pa->first = src->pred->first;
+            assign->pred.reset(pa);
+        }
+        else if (NULL != src->orAssignment) {
+            OrAssignment* oa = new OrAssignment();
+            for (size_t i = 0; i < src->orAssignment->subnodes.size(); ++i) {
+                oa->subnodes.push_back(cloneMemoEntry(src->orAssignment->subnodes[i],
+                                                      nodeMap, idToNode, cloned));
+            }
+            assign->orAssignment.reset(oa);
+        }
+        else if (NULL != src->arrayAssignment) {
+            ArrayAssignment* aa = new ArrayAssignment();
+            for (size_t i = 0; i < src->arrayAssignment->subnodes.size(); ++i) {
+                aa->subnodes.push_back(cloneMemoEntry(src->arrayAssignment->subnodes[i],
+                                                      nodeMap, idToNode, cloned));
+            }
+            assign->arrayAssignment.reset(aa);
+        }
+        else {
+            verify(NULL != src->andAssignment);
+            AndAssignment* aa = new AndAssignment();
+            for (size_t i = 0; i < src->andAssignment->choices.size(); ++i) {
+                const AndEnumerableState& srcState = src->andAssignment->choices[i];
+                AndEnumerableState destState;
+                for (size_t j = 0; j < srcState.assignments.size(); ++j) {
+                    const OneIndexAssignment& srcAssign = srcState.assignments[j];
+                    OneIndexAssignment destAssign;
+                    destAssign.index = srcAssign.index;
+                    destAssign.positions = srcAssign.positions;
+                    for (size_t k = 0; k < srcAssign.preds.size(); ++k) {
+                        destAssign.preds.push_back(nodeMap.find(srcAssign.preds[k])->second);
+                    }
+                    destState.assignments.push_back(destAssign);
+                }
+                for (size_t j = 0; j < srcState.subnodesToIndex.size(); ++j) {
+                    destState.subnodesToIndex.push_back(
+                        cloneMemoEntry(srcState.subnodesToIndex[j], nodeMap, idToNode, cloned));
+                }
+                aa->choices.push_back(destState);
+            }
+            assign->andAssignment.reset(aa);
+        }
+
+        return newId;
+    }
+
     void PlanEnumerator::partitionPreds(MatchExpression* node,
                                         PrepMemoContext context,
                                         vector<MatchExpression*>* indexOut,
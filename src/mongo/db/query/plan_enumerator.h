@@ -43,8 +43,13 @@ namespace mongo {
         // How many choices do we want when computing ixisect solutions in an AND?
         static const size_t kDefaultMaxIntersectPerAnd = 3;
 
+        // Most enumeration choices we keep for a single AND after cost-ordering them.
+        // See PlanEnumerator::sortAndCapChoices().
+        static const size_t kDefaultMaxChoicesPerAnd = 16;
+
         PlanEnumeratorParams() : intersect(false),
-                                 maxIntersectPerAnd(3) { }
+                                 maxIntersectPerAnd(3),
+                                 maxChoicesPerAnd(kDefaultMaxChoicesPerAnd) { }
 
         // Do we provide solutions that use more indices than the minimum required to provide
         // an indexed solution?
@@ -60,6 +65,12 @@ namespace mongo {
         // all-pairs approach, we could wind up creating a lot of enumeration possibilities for
         // certain inputs.
         size_t maxIntersectPerAnd;
+
+        // Cap on the enumeration choices kept per AND.  The total enumeration state space is
+        // the product of each AND's choice count, so this bounds the blowup on collections
+        // with many indices.  Choices are cost-ordered before capping, so it's the least
+        // promising assignments that get discarded.
+        size_t maxChoicesPerAnd;
     };
 
     /**
@@ -360,6 +371,54 @@ namespace mongo {
                       const IndexEntry& thisIndex,
                       OneIndexAssignment* assign);
 
+        /**
+         * Orders 'andAssignment's choices from most to least promising by a simple cost
+         * heuristic and truncates the list to _choiceLimit.  getNext() walks the choice
+         * cross-product low-order-digit first and the caller stops after a fixed number of
+         * plans, so ordering determines which candidate plans the multi-planner ever sees,
+         * and the cap bounds the enumeration state space.
+         */
+        void sortAndCapChoices(AndAssignment* andAssignment);
+
+        /**
+         * Comparator for sortAndCapChoices: choices whose indices answer more predicates
+         * (less residual filtering) sort first; among those, fewer scans is better.
+         */
+        static bool choiceIsCheaper(const AndEnumerableState& lhs,
+                                    const AndEnumerableState& rhs);
+
+        /**
+         * Attempts to reuse the memoized assignments of 'src' -- an already-prepped $or
+         * branch -- for the structurally identical sibling branch 'dest', cloning the memo
+         * subtree with 'src's expression pointers swapped for 'dest's.  Machine-generated
+         * $or queries repeat the same branch shape over and over; cloning skips re-running
+         * enumeration (including the all-pairs intersection search) on every repeat.
+         *
+         * Returns false, having changed nothing, if the branches' shapes or relevant
+         * indices differ; the caller falls back to prepMemo().
+         */
+        bool cloneMemoSubtree(MatchExpression* src, MatchExpression* dest);
+
+        /**
+         * Do 'src' and 'dest' have the same tree shape (match types, paths, arity) and the
+         * same relevant indices at every node?  Constants may differ -- index *assignment*
+         * doesn't depend on them -- but the rated indices must agree exactly since the
+         * clone copies index lists wholesale.
+         */
+        bool shapeAndIndexesMatch(MatchExpression* src, MatchExpression* dest);
+
+        /**
+         * Recursive worker for cloneMemoSubtree.  Clones the memo entry 'srcId' (and,
+         * transitively, its subnodes) under the destination branch's expressions.
+         * 'nodeMap' maps source to destination expressions, 'idToNode' is the inverse of
+         * _nodeToId, and 'cloned' memoizes already-cloned entries since one subnode can
+         * appear in several choices.  Returns the MemoID of the clone.
+         */
+        MemoID cloneMemoEntry(MemoID srcId,
+                              const unordered_map<MatchExpression*, MatchExpression*>& nodeMap,
+                              const unordered_map<MemoID, MatchExpression*>& idToNode,
+                              unordered_map<MemoID, MemoID>* cloned);
+
         std::string dumpMemo();
 
         // Map from expression to its MemoID.
@@ -387,6 +446,9 @@ namespace mongo {
 
         // How many things do we want from each AND?
         size_t _intersectLimit;
+
+        // Most enumeration choices we keep per AND; see sortAndCapChoices().
+        size_t _choiceLimit;
     };
 
 } // namespace mongo
@@ -33,11 +33,21 @@
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // Batched ("vectorized") execution: when > 1, results are pulled through the stage tree in
+    // batches of this many WorkingSetIDs per PlanStage::workBatch() call, instead of one
+    // work() round trip through the whole tree per document.  0 disables batching.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchSize, int, 0);
+
+    namespace {
+        const int kMaxExecBatchSize = 256;
+    }
+
     PlanExecutor::PlanExecutor(WorkingSet* ws, PlanStage* rt)
-        : _workingSet(ws) , _root(rt) , _killed(false) { }
+        : _workingSet(ws) , _root(rt) , _batchPos(0) , _execBatchSizeHint(0) , _killed(false) { }
 
     PlanExecutor::~PlanExecutor() { }
 
@@ -61,7 +71,18 @@ namespace mongo {
     }
 
     void PlanExecutor::invalidate(const DiskLoc& dl, InvalidationType type) {
-        if (!_killed) { _root->invalidate(dl, type); }
+        if (!_killed) {
+            _root->invalidate(dl, type);
+
+            // Results buffered by getNextBatched would otherwise miss the notification.
+            for (size_t i = _batchPos; i < _batch.size(); i++) {
+                if (WorkingSet::INVALID_ID == _batch[i]) { continue; }
+                WorkingSetMember* member = _workingSet->get(_batch[i]);
+                if (member->hasLoc() && (member->loc == dl)) {
+                    WorkingSetCommon::fetchAndInvalidateLoc(member);
+                }
+            }
+        }
     }
 
     void PlanExecutor::setYieldPolicy(Runner::YieldPolicy policy) {
@@ -73,9 +94,22 @@ namespace mongo {
         }
     }
 
+    void PlanExecutor::setExecBatchSize(int batchSize) {
+        _execBatchSizeHint = batchSize;
+    }
+
     Runner::RunnerState PlanExecutor::getNext(BSONObj* objOut, DiskLoc* dlOut) {
         if (_killed) { return Runner::RUNNER_DEAD; }
 
+        int batchSize = (_execBatchSizeHint > 0) ? _execBatchSizeHint
+                                                 : internalQueryExecBatchSize;
+        if (batchSize > 1 || _batchPos < _batch.size()) {
+            // The second condition drains anything we buffered before the parameter changed.
+            if (batchSize > kMaxExecBatchSize) { batchSize = kMaxExecBatchSize; }
+            if (batchSize < 1) { batchSize = 1; }
+            return getNextBatched(objOut, dlOut, batchSize);
+        }
+
         for (;;) {
             // Yield, if we can yield ourselves.
             if (NULL != _yieldPolicy.get() && _yieldPolicy->shouldYield()) {
@@ -96,40 +130,7 @@ namespace mongo {
                     return Runner::RUNNER_ADVANCED;
                 }
 
-                WorkingSetMember* member = _workingSet->get(id);
-                bool hasRequestedData = true;
-
-                if (NULL != objOut) {
-                    if (WorkingSetMember::LOC_AND_IDX == member->state) {
-                        if (1 != member->keyData.size()) {
-                            _workingSet->free(id);
-                            hasRequestedData = false;
-                        }
-                        else {
-                            *objOut = member->keyData[0].keyData;
-                        }
-                    }
-                    else if (member->hasObj()) {
-                        *objOut = member->obj;
-                    }
-                    else {
-                        _workingSet->free(id);
-                        hasRequestedData = false;
-                    }
-                }
-
-                if (NULL != dlOut) {
-                    if (member->hasLoc()) {
-                        *dlOut = member->loc;
-                    }
-                    else {
-                        _workingSet->free(id);
-                        hasRequestedData = false;
-                    }
-                }
-
-                if (hasRequestedData) {
-                    _workingSet->free(id);
+                if (getMember(id, objOut, dlOut)) {
                     return Runner::RUNNER_ADVANCED;
                 }
                 // This result didn't have the data the caller wanted, try again.
@@ -185,6 +186,134 @@ namespace mongo {
         }
     }
 
+    Runner::RunnerState PlanExecutor::getNextBatched(BSONObj* objOut, DiskLoc* dlOut,
+                                                     size_t batchSize) {
+        for (;;) {
+            // Hand out buffered results first.
+            while (_batchPos < _batch.size()) {
+                WorkingSetID id = _batch[_batchPos++];
+
+                // Fast count.
+                if (WorkingSet::INVALID_ID == id) {
+                    invariant(NULL == objOut);
+                    invariant(NULL == dlOut);
+                    return Runner::RUNNER_ADVANCED;
+                }
+
+                if (getMember(id, objOut, dlOut)) {
+                    return Runner::RUNNER_ADVANCED;
+                }
+                // This result didn't have the data the caller wanted, try the next one.
+            }
+            _batch.clear();
+            _batchPos = 0;
+
+            // Yield, if we can yield ourselves.
+            if (NULL != _yieldPolicy.get() && _yieldPolicy->shouldYield()) {
+                saveState();
+                _yieldPolicy->yield();
+                if (_killed) { return Runner::RUNNER_DEAD; }
+                restoreState();
+            }
+
+            PlanStage::StageState code = _root->workBatch(batchSize, &_batch);
+
+            if (PlanStage::ADVANCED == code) {
+                // Fall through to the drain loop above.
+            }
+            else if (PlanStage::NEED_TIME == code) {
+                // Try again.
+            }
+            else if (PlanStage::NEED_FETCH == code) {
+                invariant(1 == _batch.size());
+                WorkingSetID id = _batch[0];
+                _batch.clear();
+                WorkingSetMember* member = _workingSet->get(id);
+
+                // Unlike the one-at-a-time path, a batched fetch request may have waited behind
+                // buffered results across a yield; if it was invalidated meanwhile there is
+                // nothing left to page in and the stage will produce the member next call.
+                if (member->hasLoc()) {
+                    Record* record = member->loc.rec();
+
+                    // If we're allowed to, go to disk outside of the lock.
+                    if (NULL != _yieldPolicy.get()) {
+                        saveState();
+                        _yieldPolicy->yield(record);
+                        if (_killed) { return Runner::RUNNER_DEAD; }
+                        restoreState();
+                    }
+                    else {
+                        // We're set to manually yield.  We go to disk in the lock.
+                        record->touch();
+                    }
+
+                    // Record should be in memory now.  Log if it's not.
+                    if (!Record::likelyInPhysicalMemory(record->dataNoThrowing())) {
+                        OCCASIONALLY {
+                            warning() << "Record wasn't in memory immediately after fetch: "
+                                      << member->loc.toString() << endl;
+                        }
+                    }
+                }
+
+                // Note that we're not freeing id.  Fetch semantics say that we shouldn't.
+            }
+            else if (PlanStage::IS_EOF == code) {
+                return Runner::RUNNER_EOF;
+            }
+            else if (PlanStage::DEAD == code) {
+                return Runner::RUNNER_DEAD;
+            }
+            else {
+                verify(PlanStage::FAILURE == code);
+                WorkingSetID id = _batch.empty() ? WorkingSet::INVALID_ID : _batch[0];
+                _batch.clear();
+                WorkingSetCommon::getStatusMemberObject(*_workingSet, id, objOut);
+                return Runner::RUNNER_ERROR;
+            }
+        }
+    }
+
+    bool PlanExecutor::getMember(WorkingSetID id, BSONObj* objOut, DiskLoc* dlOut) {
+        WorkingSetMember* member = _workingSet->get(id);
+        bool hasRequestedData = true;
+
+        if (NULL != objOut) {
+            if (WorkingSetMember::LOC_AND_IDX == member->state) {
+                if (1 != member->keyData.size()) {
+                    _workingSet->free(id);
+                    hasRequestedData = false;
+                }
+                else {
+                    *objOut = member->keyData[0].keyData;
+                }
+            }
+            else if (member->hasObj()) {
+                *objOut = member->obj;
+            }
+            else {
+                _workingSet->free(id);
+                hasRequestedData = false;
+            }
+        }
+
+        if (NULL != dlOut) {
+            if (member->hasLoc()) {
+                *dlOut = member->loc;
+            }
+            else {
+                _workingSet->free(id);
+                hasRequestedData = false;
+            }
+        }
+
+        if (hasRequestedData) {
+            _workingSet->free(id);
+        }
+        return hasRequestedData;
+    }
+
     bool PlanExecutor::isEOF() {
         return _killed || _root->isEOF();
     }
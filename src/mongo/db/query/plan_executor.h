@@ -29,8 +29,10 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/runner.h"
 #include "mongo/db/query/runner_yield_policy.h"
 
@@ -40,7 +42,6 @@ namespace mongo {
     class DiskLoc;
     class PlanStage;
     struct PlanStageStats;
-    class WorkingSet;
 
     /**
      * A PlanExecutor is the abstraction that knows how to crank a tree of stages into execution.
@@ -85,6 +86,12 @@ namespace mongo {
         /** TODO document me */
         void setYieldPolicy(Runner::YieldPolicy policy);
 
+        /**
+         * Prefer batched ("vectorized") execution with batches of up to 'batchSize', clamped
+         * to the executor's maximum.  0 defers to the internalQueryExecBatchSize parameter.
+         */
+        void setExecBatchSize(int batchSize);
+
         /** TODO document me */
         Runner::RunnerState getNext(BSONObj* objOut, DiskLoc* dlOut);
 
@@ -99,10 +106,32 @@ namespace mongo {
         void kill();
 
     private:
+        /**
+         * getNext when batched ("vectorized") execution is enabled: results are pulled through
+         * the stage tree 'batchSize' at a time via PlanStage::workBatch and handed out one by
+         * one from _batch.
+         */
+        Runner::RunnerState getNextBatched(BSONObj* objOut, DiskLoc* dlOut, size_t batchSize);
+
+        /**
+         * Copy the data the caller asked for out of the working set member 'id' and free it.
+         * Returns false if the member didn't have the requested data (caller should try the
+         * next result).
+         */
+        bool getMember(WorkingSetID id, BSONObj* objOut, DiskLoc* dlOut);
+
         boost::scoped_ptr<WorkingSet> _workingSet;
         boost::scoped_ptr<PlanStage> _root;
         boost::scoped_ptr<RunnerYieldPolicy> _yieldPolicy;
 
+        // Results buffered by getNextBatched; _batchPos indexes the next one to hand out.
+        // invalidate() must be told about these, see PlanExecutor::invalidate.
+        std::vector<WorkingSetID> _batch;
+        size_t _batchPos;
+
+        // When positive, overrides internalQueryExecBatchSize.  See setExecBatchSize.
+        int _execBatchSizeHint;
+
         // Did somebody drop an index we care about or the namespace we're looking at?  If so,
         // we'll be killed.
         bool _killed;
@@ -86,6 +86,26 @@ namespace mongo {
             }
         }
 
+        // A sufficiently large unsorted scan can instead run as several extent scans on
+        // worker threads.  PARALLEL_COLLSCAN is only set (see fillOutPlannerParams) when
+        // the collection and server configuration make that worthwhile; here we check
+        // that this particular query doesn't rely on anything a parallel scan gives up:
+        // natural order, tailability, maxScan accounting, and single-threaded match
+        // evaluation ($where runs user JS, which we won't spread across threads).
+        if ((params.options & QueryPlannerParams::PARALLEL_COLLSCAN)
+            && !tailable
+            && 1 == csn->direction
+            && 0 == csn->maxScan
+            && query.getParsed().getSort().isEmpty()
+            && !QueryPlannerCommon::hasNode(query.root(), MatchExpression::WHERE)) {
+            ParallelGatherNode* pgn = new ParallelGatherNode();
+            pgn->name = csn->name;
+            pgn->filter.reset(query.root()->shallowClone());
+            pgn->filterObj = query.getQueryObj().getOwned();
+            delete csn;
+            return pgn;
+        }
+
         return csn;
     }
 
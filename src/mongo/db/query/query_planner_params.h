@@ -79,6 +79,11 @@ namespace mongo {
             // Nobody should set this above the getRunner interface.  Internal flag set as a hint to
             // the planner that the caller is actually the count command.
             PRIVATE_IS_COUNT = 1 << 6,
+
+            // Set this if the collection is big enough, and the server configured, for a table
+            // scan to be run as a parallel extent scan (STAGE_PARALLEL_GATHER).  The planner
+            // only acts on it for unsorted, non-tailable, forward collection scans.
+            PARALLEL_COLLSCAN = 1 << 7,
         };
 
         // See Options enum above.
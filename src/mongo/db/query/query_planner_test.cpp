@@ -755,6 +755,23 @@ namespace {
                                     "{a: [[0,5,false,false]]}}}]}}}}");
     }
 
+    // Structurally identical $or branches reuse one memoized set of index assignments,
+    // but each branch must still get its own bounds.
+    TEST_F(QueryPlannerTest, OrEquivalentBranchShapesReuseAssignments) {
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{$or: [{a:1,b:2}, {a:3,b:4}, {a:5,b:6}]}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {or: {nodes: ["
+                                "{ixscan: {pattern: {a:1,b:1}, bounds: "
+                                    "{a: [[1,1,true,true]], b: [[2,2,true,true]]}}}, "
+                                "{ixscan: {pattern: {a:1,b:1}, bounds: "
+                                    "{a: [[3,3,true,true]], b: [[4,4,true,true]]}}}, "
+                                "{ixscan: {pattern: {a:1,b:1}, bounds: "
+                                    "{a: [[5,5,true,true]], b: [[6,6,true,true]]}}}]}}}}");
+    }
+
     // SERVER-12594: we don't yet collapse an OR of ANDs into a single ixscan.
     TEST_F(QueryPlannerTest, OrOfAnd2) {
         addIndex(BSON("a" << 1));
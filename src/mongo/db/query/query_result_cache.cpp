@@ -0,0 +1,148 @@
+/**
+ *    Copyright (C) 2013 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/query_result_cache.h"
+
+namespace mongo {
+
+    const long long QueryResultCache::kMaxTotalBytes = 64 * 1024 * 1024;
+    const long long QueryResultCache::kMaxEntryBytes = 4 * 1024 * 1024;
+
+    QueryResultCache::QueryResultCache()
+        : _mutex( "QueryResultCache" ),
+          _totalBytes( 0 ) {
+    }
+
+    QueryResultCache& QueryResultCache::get() {
+        static QueryResultCache instance;
+        return instance;
+    }
+
+    // static
+    std::string QueryResultCache::makeKey(const QueryMessage& q) {
+        // Exact bytes of the (possibly $query-wrapped) query object and
+        // projection, plus the paging parameters.  Two queries that differ
+        // only in insignificant ways (field order, int vs long literals)
+        // get distinct entries; that costs memory, not correctness.
+        std::string key;
+        key.reserve( q.query.objsize() + q.fields.objsize() + 3 * sizeof(int) );
+        key.append( q.query.objdata(), q.query.objsize() );
+        key.append( q.fields.objdata(), q.fields.objsize() );
+        key.append( reinterpret_cast<const char*>( &q.ntoskip ), sizeof(int) );
+        key.append( reinterpret_cast<const char*>( &q.ntoreturn ), sizeof(int) );
+        key.append( reinterpret_cast<const char*>( &q.queryOptions ), sizeof(int) );
+        return key;
+    }
+
+    unsigned long long QueryResultCache::generation(const std::string& ns) {
+        scoped_lock lk( _mutex );
+        unordered_map<std::string, NsSlice>::const_iterator it = _slices.find( ns );
+        if ( it == _slices.end() )
+            return 0;
+        return it->second.generation;
+    }
+
+    bool QueryResultCache::lookup(const std::string& ns,
+                                  const std::string& key,
+                                  std::string* docs,
+                                  int* numResults) {
+        scoped_lock lk( _mutex );
+        unordered_map<std::string, NsSlice>::iterator it = _slices.find( ns );
+        if ( it == _slices.end() )
+            return false;
+        EntryMap::const_iterator e = it->second.entries.find( key );
+        if ( e == it->second.entries.end() )
+            return false;
+        *docs = e->second.docs;
+        *numResults = e->second.numResults;
+        return true;
+    }
+
+    void QueryResultCache::add(const std::string& ns,
+                               const std::string& key,
+                               unsigned long long generation,
+                               const char* docs,
+                               int docsLen,
+                               int numResults) {
+        if ( docsLen > kMaxEntryBytes )
+            return;
+
+        scoped_lock lk( _mutex );
+        NsSlice& slice = _slices[ ns ];
+        if ( slice.generation != generation ) {
+            // a write landed while the query ran (e.g. during a yield); the
+            // buffer we were handed may predate it, so don't cache it
+            return;
+        }
+        if ( slice.entries.count( key ) )
+            return;
+
+        _evictionList.push_back( std::make_pair( ns, key ) );
+        Entry& entry = slice.entries[ key ];
+        entry.docs.assign( docs, docsLen );
+        entry.numResults = numResults;
+        entry.evictionPos = --_evictionList.end();
+        _totalBytes += docsLen;
+
+        while ( _totalBytes > kMaxTotalBytes && !_evictionList.empty() ) {
+            _evictOldest_inlock();
+        }
+    }
+
+    void QueryResultCache::invalidate(const std::string& ns) {
+        scoped_lock lk( _mutex );
+        unordered_map<std::string, NsSlice>::iterator it = _slices.find( ns );
+        if ( it == _slices.end() ) {
+            // remember that a write happened even if nothing is cached yet, so
+            // an in-flight query's add() with the old generation is refused
+            _slices[ ns ].generation = 1;
+            return;
+        }
+        NsSlice& slice = it->second;
+        slice.generation++;
+        for ( EntryMap::iterator e = slice.entries.begin(); e != slice.entries.end(); ++e ) {
+            _totalBytes -= e->second.docs.size();
+            _evictionList.erase( e->second.evictionPos );
+        }
+        slice.entries.clear();
+    }
+
+    void QueryResultCache::_evictOldest_inlock() {
+        const std::pair<std::string, std::string>& oldest = _evictionList.front();
+        unordered_map<std::string, NsSlice>::iterator it = _slices.find( oldest.first );
+        if ( it != _slices.end() ) {
+            EntryMap::iterator e = it->second.entries.find( oldest.second );
+            if ( e != it->second.entries.end() ) {
+                _totalBytes -= e->second.docs.size();
+                it->second.entries.erase( e );
+            }
+        }
+        _evictionList.pop_front();
+    }
+
+}  // namespace mongo
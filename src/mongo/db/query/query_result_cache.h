@@ -0,0 +1,118 @@
+/**
+ *    Copyright (C) 2013 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Process-wide cache of complete query replies, for collections opted in with
+     * collMod {resultCache: true}.  The plan cache remembers how to answer a query
+     * shape; this remembers the answer itself, keyed on the exact query message
+     * (filter, projection, skip, limit -- shape plus literals), so read-mostly
+     * reference collections serve repeat queries straight from memory.
+     *
+     * Only complete single-batch replies are stored (runQuery enforces the
+     * eligibility rules).  Any write to a collection bumps its generation and
+     * drops its slice of the cache; add() is a no-op if the generation moved
+     * between query start and completion, so a write that lands mid-query (during
+     * a yield) cannot be papered over by a stale entry.
+     */
+    class QueryResultCache {
+    public:
+        QueryResultCache();
+
+        /** Cache key for a query message: exact query/projection bytes plus skip/limit. */
+        static std::string makeKey(const QueryMessage& q);
+
+        /** Generation to pass to add(); bumped by every invalidate() on 'ns'. */
+        unsigned long long generation(const std::string& ns);
+
+        /**
+         * On a hit copies the reply's document bytes into 'docs', sets
+         * '*numResults' and returns true.
+         */
+        bool lookup(const std::string& ns,
+                    const std::string& key,
+                    std::string* docs,
+                    int* numResults);
+
+        /**
+         * Stores a reply if 'generation' still matches and the entry isn't
+         * oversized; evicts oldest entries to stay within budget.
+         */
+        void add(const std::string& ns,
+                 const std::string& key,
+                 unsigned long long generation,
+                 const char* docs,
+                 int docsLen,
+                 int numResults);
+
+        /** Drops everything cached for 'ns'.  Call on any write, drop, or opt-out. */
+        void invalidate(const std::string& ns);
+
+        static QueryResultCache& get();
+
+    private:
+        // eviction order, oldest first
+        typedef std::list<std::pair<std::string, std::string> > EvictionList;
+
+        struct Entry {
+            std::string docs;
+            int numResults;
+            EvictionList::iterator evictionPos;
+        };
+
+        typedef std::map<std::string, Entry> EntryMap;
+
+        struct NsSlice {
+            NsSlice() : generation(0) {}
+            unsigned long long generation;
+            EntryMap entries;
+        };
+
+        void _evictOldest_inlock();
+
+        static const long long kMaxTotalBytes;  // cache-wide budget
+        static const long long kMaxEntryBytes;  // don't cache replies bigger than this
+
+        mongo::mutex _mutex;
+        unordered_map<std::string, NsSlice> _slices;
+        EvictionList _evictionList;
+        long long _totalBytes;
+    };
+
+}  // namespace mongo
@@ -97,6 +97,22 @@ namespace mongo {
         addCommon(ss, indent);
     }
 
+    //
+    // ParallelGatherNode
+    //
+
+    void ParallelGatherNode::appendToString(mongoutils::str::stream* ss, int indent) const {
+        addIndent(ss, indent);
+        *ss << "PARALLEL_GATHER\n";
+        addIndent(ss, indent + 1);
+        *ss <<  "ns = " << name << '\n';
+        if (NULL != filter) {
+            addIndent(ss, indent + 1);
+            *ss << "filter = " << filter->toString();
+        }
+        addCommon(ss, indent);
+    }
+
     //
     // AndHashNode
     //
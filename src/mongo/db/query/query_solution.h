@@ -252,6 +252,31 @@ namespace mongo {
         int maxScan;
     };
 
+    struct ParallelGatherNode : public QuerySolutionNode {
+        ParallelGatherNode() { }
+        virtual ~ParallelGatherNode() { }
+
+        virtual StageType getType() const { return STAGE_PARALLEL_GATHER; }
+
+        virtual void appendToString(mongoutils::str::stream* ss, int indent) const;
+
+        // Workers return whole documents, interleaved in whatever order their
+        // extent scans produce them.
+        bool fetched() const { return true; }
+        bool hasField(const string& field) const { return true; }
+        bool sortedByDiskLoc() const { return false; }
+        const BSONObjSet& getSort() const { return _sort; }
+
+        BSONObjSet _sort;
+
+        // Name of the namespace.
+        string name;
+
+        // The raw query predicate.  Each worker thread parses a private
+        // MatchExpression from this, so matching needs no cross-thread state.
+        BSONObj filterObj;
+    };
+
     struct AndHashNode : public QuerySolutionNode {
         AndHashNode();
         virtual ~AndHashNode();
@@ -127,6 +127,16 @@ namespace mongo {
          */
         virtual void setYieldPolicy(YieldPolicy policy) = 0;
 
+        /**
+         * Hint that the caller is draining this runner into a large reply buffer and results
+         * should be pulled through the stage tree in batches of up to 'batchSize' rather than
+         * one work() round trip per document.  The executor clamps the hint and still yields
+         * on its usual work quota between batches.  A batchSize of 0 reverts to the
+         * internalQueryExecBatchSize server parameter; runners that cannot execute in batches
+         * ignore the hint.
+         */
+        virtual void setExecBatchSize(int batchSize) { }
+
         /**
          * Get the next result from the query.
          *
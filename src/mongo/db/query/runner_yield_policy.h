@@ -30,13 +30,16 @@
 
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/catalog/collection.h"
-#include "mongo/util/elapsed_tracker.h"
+#include "mongo/db/kill_current_op.h"
+#include "mongo/db/lockstate.h"
+#include "mongo/util/net/listen.h"
 
 namespace mongo {
 
     class RunnerYieldPolicy {
     public:
-        RunnerYieldPolicy() : _elapsedTracker(128, 10), _runnerYielding(NULL) { }
+        RunnerYieldPolicy() : _sliceStartMillis(Listener::getElapsedTimeMillis()),
+                              _runnerYielding(NULL) { }
 
         ~RunnerYieldPolicy() {
             if (NULL != _runnerYielding) {
@@ -48,8 +51,27 @@ namespace mongo {
             }
         }
 
+        /**
+         * Runners run in fixed time slices.  Inside a slice this is one read
+         * of the listener's cached clock; at a slice boundary we consult
+         * actual queued-waiter pressure (pendingLockReaders/Writers): if
+         * nobody is waiting on a lock and no kill was requested, the slice
+         * renews in place and the runner keeps going, so uncontended scans
+         * never touch the lock manager.  Yields thus happen at deterministic
+         * points - slice boundaries - and only under real pressure, instead
+         * of being driven by iteration-count guesswork.
+         */
         bool shouldYield() {
-            return _elapsedTracker.intervalHasElapsed();
+            long long now = Listener::getElapsedTimeMillis();
+            if ( now - _sliceStartMillis < kSliceMillis ) {
+                return false;
+            }
+            if ( 0 == pendingLockReaders() && 0 == pendingLockWriters() &&
+                 !*killCurrentOp.checkForInterruptNoAssert() ) {
+                _sliceStartMillis = now;
+                return false;
+            }
+            return true;
         }
 
         /**
@@ -85,7 +107,7 @@ namespace mongo {
                 runner->collection()->cursorCache()->deregisterRunner( _runnerYielding );
             }
             _runnerYielding = NULL;
-            _elapsedTracker.resetLastTime();
+            _sliceStartMillis = Listener::getElapsedTimeMillis();
             return runner->restoreState();
         }
 
@@ -102,11 +124,8 @@ namespace mongo {
             // we want to page in the record in the lock even if nobody is waiting for the lock?
             if (micros > 0 || (NULL != rec)) {
                 staticYield(micros, rec);
-                // TODO:  When do we really want to reset this?  Currently we reset it when we
-                // actually yield.  As such we'll keep on trying to yield once the tracker has
-                // elapsed.  If we reset it even if we don't yield, we'll wait until the time
-                // interval elapses again to try yielding.
-                _elapsedTracker.resetLastTime();
+                // a new slice starts once we actually yielded
+                _sliceStartMillis = Listener::getElapsedTimeMillis();
             }
         }
 
@@ -115,7 +134,10 @@ namespace mongo {
         }
 
     private:
-        ElapsedTracker _elapsedTracker;
+        // how long a runner may hold its locks before the arbiter is consulted
+        static const int kSliceMillis = 10;
+
+        long long _sliceStartMillis;
         Runner* _runnerYielding;
     };
 
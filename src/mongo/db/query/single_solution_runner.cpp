@@ -76,6 +76,10 @@ namespace mongo {
         _exec->setYieldPolicy(policy);
     }
 
+    void SingleSolutionRunner::setExecBatchSize(int batchSize) {
+        _exec->setExecBatchSize(batchSize);
+    }
+
     void SingleSolutionRunner::invalidate(const DiskLoc& dl, InvalidationType type) {
         _exec->invalidate(dl, type);
     }
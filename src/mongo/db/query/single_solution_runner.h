@@ -69,6 +69,8 @@ namespace mongo {
 
         virtual void setYieldPolicy(Runner::YieldPolicy policy);
 
+        virtual void setExecBatchSize(int batchSize);
+
         virtual void invalidate(const DiskLoc& dl, InvalidationType type);
 
         virtual const std::string& ns();
@@ -41,6 +41,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_gather.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/s2near.h"
 #include "mongo/db/exec/shard_filter.h"
@@ -62,8 +63,19 @@ namespace mongo {
             params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
                                                      : CollectionScanParams::BACKWARD;
             params.maxScan = csn->maxScan;
+            // A blocking stage above a collscan is a sort, which reorders everything
+            // anyway, so the scan is free to join another scan's extent sweep and
+            // return documents out of natural order.
+            params.cooperative = qsol.hasBlockingStage && !csn->tailable;
             return new CollectionScan(params, ws, csn->filter.get());
         }
+        else if (STAGE_PARALLEL_GATHER == root->getType()) {
+            const ParallelGatherNode* pgn = static_cast<const ParallelGatherNode*>(root);
+            ParallelGatherParams params;
+            params.ns = pgn->name;
+            params.filter = pgn->filterObj;
+            return new ParallelGatherStage(params, ws);
+        }
         else if (STAGE_IXSCAN == root->getType()) {
             const IndexScanNode* ixn = static_cast<const IndexScanNode*>(root);
 
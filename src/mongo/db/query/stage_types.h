@@ -63,7 +63,19 @@ namespace mongo {
 
         STAGE_IXSCAN,
         STAGE_LIMIT,
+
+        // Joins two sorted index-key streams on key equality.  Only built by
+        // the stageDebug command for now.
+        STAGE_MERGE_JOIN,
+
         STAGE_OR,
+
+        // Fans a collection scan out over several worker threads, each covering a
+        // disjoint set of extents and applying the query filter, and gathers the
+        // matching documents in whatever order the workers produce them.  Chosen
+        // by the planner for large unsorted table scans.
+        STAGE_PARALLEL_GATHER,
+
         STAGE_PROJECTION,
         STAGE_SHARDING_FILTER,
         STAGE_SKIP,
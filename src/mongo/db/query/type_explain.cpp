@@ -51,6 +51,7 @@ namespace mongo {
     const BSONField<long long> TypeExplain::nYields("nYields");
     const BSONField<long long> TypeExplain::nChunkSkips("nChunkSkips");
     const BSONField<long long> TypeExplain::millis("millis");
+    const BSONField<long long> TypeExplain::planningTimeMicros("planningTimeMicros");
     const BSONField<BSONObj> TypeExplain::indexBounds("indexBounds");
     const BSONField<std::vector<TypeExplain*> > TypeExplain::allPlans("allPlans");
     const BSONField<TypeExplain*> TypeExplain::oldPlan("oldPlan");
@@ -145,6 +146,10 @@ namespace mongo {
 
         if (_isMillisSet) builder.appendNumber(millis(), _millis);
 
+        if (_isPlanningTimeMicrosSet) {
+            builder.appendNumber(planningTimeMicros(), _planningTimeMicros);
+        }
+
         if (_isIndexBoundsSet) builder.append(indexBounds(), _indexBounds);
 
         if (_allPlans.get()) {
@@ -236,6 +241,10 @@ namespace mongo {
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isMillisSet = fieldState == FieldParser::FIELD_SET;
 
+        fieldState = FieldParser::extract(source, planningTimeMicros, &_planningTimeMicros, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isPlanningTimeMicrosSet = fieldState == FieldParser::FIELD_SET;
+
         fieldState = FieldParser::extract(source, indexBounds, &_indexBounds, errMsg);
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isIndexBoundsSet = fieldState == FieldParser::FIELD_SET;
@@ -302,6 +311,9 @@ namespace mongo {
         _millis = 0;
         _isMillisSet = false;
 
+        _planningTimeMicros = 0;
+        _isPlanningTimeMicrosSet = false;
+
         _indexBounds = BSONObj();
         _isIndexBoundsSet = false;
 
@@ -370,6 +382,9 @@ namespace mongo {
         other->_millis = _millis;
         other->_isMillisSet = _isMillisSet;
 
+        other->_planningTimeMicros = _planningTimeMicros;
+        other->_isPlanningTimeMicrosSet = _isPlanningTimeMicrosSet;
+
         other->_indexBounds = _indexBounds;
         other->_isIndexBoundsSet = _isIndexBoundsSet;
 
@@ -700,6 +715,24 @@ namespace mongo {
         return _millis;
     }
 
+    void TypeExplain::setPlanningTimeMicros(long long planningTimeMicros) {
+        _planningTimeMicros = planningTimeMicros;
+        _isPlanningTimeMicrosSet = true;
+    }
+
+    void TypeExplain::unsetPlanningTimeMicros() {
+         _isPlanningTimeMicrosSet = false;
+     }
+
+    bool TypeExplain::isPlanningTimeMicrosSet() const {
+         return _isPlanningTimeMicrosSet;
+    }
+
+    long long TypeExplain::getPlanningTimeMicros() const {
+        verify(_isPlanningTimeMicrosSet);
+        return _planningTimeMicros;
+    }
+
     void TypeExplain::setIndexBounds(const BSONObj& indexBounds) {
         _indexBounds = indexBounds.getOwned();
         _isIndexBoundsSet = true;
@@ -75,6 +75,7 @@ namespace mongo {
         static const BSONField<long long> nYields;
         static const BSONField<long long> nChunkSkips;
         static const BSONField<long long> millis;
+        static const BSONField<long long> planningTimeMicros;
         static const BSONField<BSONObj> indexBounds;
         static const BSONField<std::vector<TypeExplain*> > allPlans;
         static const BSONField<TypeExplain*> oldPlan;
@@ -183,6 +184,11 @@ namespace mongo {
         bool isMillisSet() const;
         long long getMillis() const;
 
+        void setPlanningTimeMicros(long long planningTimeMicros);
+        void unsetPlanningTimeMicros();
+        bool isPlanningTimeMicrosSet() const;
+        long long getPlanningTimeMicros() const;
+
         void setIndexBounds(const BSONObj& indexBounds);
         void unsetIndexBounds();
         bool isIndexBoundsSet() const;
@@ -271,6 +277,10 @@ namespace mongo {
         long long _millis;
         bool _isMillisSet;
 
+        // (O)  time spent enumerating and selecting candidate plans, in microseconds
+        long long _planningTimeMicros;
+        bool _isPlanningTimeMicrosSet;
+
         // (O)  keys used to seek in and out of an index
         BSONObj _indexBounds;
         bool _isIndexBoundsSet;
@@ -315,13 +315,15 @@ namespace mongo {
             sleepmillis(checkIntervalMillis);
         }
 
+        RangeDeleteProgress progress;
         bool result = _env->deleteRange(ns, min, max, shardKeyPattern,
-                                        secondaryThrottle, errMsg);
+                                        secondaryThrottle, errMsg, &progress);
 
         {
             scoped_lock sl(_queueMutex);
             _deleteSet.erase(&deleteRange);
 
+            _stats->addDeleteProgress_inlock(progress);
             _stats->decInProgressDeletes_inlock();
             _stats->decTotalDeletes_inlock();
 
@@ -460,12 +462,14 @@ namespace mongo {
                 _stats->incInProgressDeletes_inlock();
             }
 
+            RangeDeleteProgress progress;
             if (!_env->deleteRange(nextTask->ns,
                                    nextTask->min,
                                    nextTask->max,
                                    nextTask->shardKeyPattern,
                                    nextTask->secondaryThrottle,
-                                   &errMsg)) {
+                                   &errMsg,
+                                   &progress)) {
                 warning() << "Error encountered while trying to delete range: "
                           << errMsg << endl;
             }
@@ -475,6 +479,7 @@ namespace mongo {
 
                 NSMinMax setEntry(nextTask->ns, nextTask->min, nextTask->max);
                 deletePtrElement(&_deleteSet, &setEntry);
+                _stats->addDeleteProgress_inlock(progress);
                 _stats->decInProgressDeletes_inlock();
                 _stats->decTotalDeletes_inlock();
 
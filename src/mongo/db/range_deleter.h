@@ -42,6 +42,7 @@
 
 namespace mongo {
 
+    struct RangeDeleteProgress;
     struct RangeDeleterEnv;
     class RangeDeleterStats;
 
@@ -283,13 +284,17 @@ namespace mongo {
          *
          * Must be a synchronous call. Docs should be deleted after call ends.
          * Must not throw Exceptions.
+         *
+         * If 'progress' is non-NULL, pacing counters for this call are filled
+         * in, even when the call fails after making partial progress.
          */
         virtual bool deleteRange(const StringData& ns,
                                  const BSONObj& inclusiveLower,
                                  const BSONObj& exclusiveUpper,
                                  const BSONObj& shardKeyPattern,
                                  bool secondaryThrottle,
-                                 std::string* errMsg) = 0;
+                                 std::string* errMsg,
+                                 RangeDeleteProgress* progress) = 0;
 
         /**
          * Gets the list of open cursors on a given namespace. The openCursors is an
@@ -33,6 +33,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/range_deleter_stats.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/write_concern.h"
 #include "mongo/s/d_logic.h"
@@ -59,7 +60,8 @@ namespace mongo {
                                         const BSONObj& exclusiveUpper,
                                         const BSONObj& keyPattern,
                                         bool secondaryThrottle,
-                                        std::string* errMsg) {
+                                        std::string* errMsg,
+                                        RangeDeleteProgress* progress) {
         const bool initiallyHaveClient = haveClient();
 
         if (!initiallyHaveClient) {
@@ -79,6 +81,7 @@ namespace mongo {
                   << endl;
 
             try {
+                Helpers::RemoveRangeStats removeStats;
                 long long numDeleted =
                         Helpers::removeRange(KeyRange(ns.toString(),
                                                       inclusiveLower,
@@ -88,7 +91,16 @@ namespace mongo {
                                              replSet? secondaryThrottle : false,
                                              serverGlobalParams.moveParanoia ? &removeSaver : NULL,
                                              true, /*fromMigrate*/
-                                             true); /*onlyRemoveOrphans*/
+                                             true, /*onlyRemoveOrphans*/
+                                             &removeStats);
+
+                if (progress) {
+                    progress->docsDeleted = removeStats.numDeleted;
+                    progress->batchesProcessed = removeStats.numBatches;
+                    progress->millisWaitingForReplication =
+                            removeStats.millisWaitingForReplication;
+                    progress->millisSleeping = removeStats.millisSleeping;
+                }
 
                 if (numDeleted < 0) {
                     *errMsg = "collection or index dropped before data could be cleaned";
@@ -145,6 +157,10 @@ namespace mongo {
             LOG(elapsedTime.seconds() < 30 ? 1 : 0)
                 << "rangeDeleter took " << elapsedTime.seconds() << " seconds "
                 << " waiting for deletes to be replicated to majority nodes" << endl;
+
+            if (progress) {
+                progress->millisWaitingForReplication += elapsedTime.millis();
+            }
         }
 
         if (!initiallyHaveClient) {
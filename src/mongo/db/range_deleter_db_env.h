@@ -49,6 +49,8 @@ namespace mongo {
          * Note that secondaryThrottle will be ignored if current process is not part
          * of a replica set.
          *
+         * If 'progress' is non-NULL, pacing counters for this call are filled in.
+         *
          * Does not throw Exceptions.
          */
         virtual bool deleteRange(const StringData& ns,
@@ -56,7 +58,8 @@ namespace mongo {
                                  const BSONObj& exclusiveUpper,
                                  const BSONObj& keyPattern,
                                  bool secondaryThrottle,
-                                 std::string* errMsg);
+                                 std::string* errMsg,
+                                 RangeDeleteProgress* progress);
 
         /**
          * Gets the list of open cursors on a given namespace.
@@ -105,7 +105,8 @@ namespace mongo {
                                           const BSONObj& max,
                                           const BSONObj& shardKeyPattern,
                                           bool secondaryThrottle,
-                                          string* errMsg) {
+                                          string* errMsg,
+                                          RangeDeleteProgress* progress) {
 
         {
             scoped_lock sl(_pauseDeleteMutex);
@@ -131,7 +131,8 @@ namespace mongo {
                          const BSONObj& max,
                          const BSONObj& shardKeyPattern,
                          bool secondaryThrottle,
-                         string* errMsg);
+                         string* errMsg,
+                         RangeDeleteProgress* progress);
 
         /**
          * Basic implementation of gathering open cursors that matches the signature for
@@ -70,6 +70,26 @@ namespace {
                                          &inProgressCount, NULL /* don't care errMsg */));
         ASSERT_EQUALS(0, inProgressCount);
 
+        long long deletedDocs = 0;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::DeletedDocsField,
+                                         &deletedDocs, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(0, deletedDocs);
+
+        long long totalBatches = 0;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::TotalBatchesField,
+                                         &totalBatches, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(0, totalBatches);
+
+        long long waitForReplMillis = 0;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::WaitForReplMillisField,
+                                         &waitForReplMillis, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(0, waitForReplMillis);
+
+        long long sleepMillis = 0;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::SleepMillisField,
+                                         &sleepMillis, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(0, sleepMillis);
+
         deleter.stopWorkers();
     }
 
@@ -32,6 +32,11 @@ namespace mongo {
     const BSONField<int> RangeDeleterStats::TotalDeletesField("totalDeletes");
     const BSONField<int> RangeDeleterStats::PendingDeletesField("pendingDeletes");
     const BSONField<int> RangeDeleterStats::InProgressDeletesField("inProgressDeletes");
+    const BSONField<long long> RangeDeleterStats::DeletedDocsField("deletedDocs");
+    const BSONField<long long> RangeDeleterStats::TotalBatchesField("totalBatches");
+    const BSONField<long long> RangeDeleterStats::WaitForReplMillisField(
+            "millisWaitingForReplication");
+    const BSONField<long long> RangeDeleterStats::SleepMillisField("millisSleepingBetweenBatches");
 
     BSONObj RangeDeleterStats::toBSON() const {
         scoped_lock sl(*_lockPtr);
@@ -40,6 +45,10 @@ namespace mongo {
         builder << TotalDeletesField(_totalDeletes);
         builder << PendingDeletesField(_pendingDeletes);
         builder << InProgressDeletesField(_inProgressDeletes);
+        builder << DeletedDocsField(_deletedDocs);
+        builder << TotalBatchesField(_totalBatches);
+        builder << WaitForReplMillisField(_millisWaitingForReplication);
+        builder << SleepMillisField(_millisSleeping);
 
         return builder.obj();
     }
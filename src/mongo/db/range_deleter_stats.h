@@ -34,6 +34,25 @@
 #include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
+    /**
+     * Progress and pacing counters reported by one RangeDeleterEnv::deleteRange
+     * call. Accumulated into RangeDeleterStats after every delete attempt,
+     * including failed ones that made partial progress.
+     */
+    struct RangeDeleteProgress {
+        RangeDeleteProgress():
+            docsDeleted(0),
+            batchesProcessed(0),
+            millisWaitingForReplication(0),
+            millisSleeping(0) {
+        }
+
+        long long docsDeleted;
+        long long batchesProcessed;
+        long long millisWaitingForReplication;
+        long long millisSleeping;
+    };
+
     /**
      * Simple class for storing statistics for the RangeDeleter.
      */
@@ -52,6 +71,18 @@ namespace mongo {
         // Total number of deletes that are currently in progress.
         static const BSONField<int> InProgressDeletesField;
 
+        // Cumulative number of documents deleted since startup.
+        static const BSONField<long long> DeletedDocsField;
+
+        // Cumulative number of delete batches processed since startup.
+        static const BSONField<long long> TotalBatchesField;
+
+        // Cumulative time spent throttling on secondary replication, in milliseconds.
+        static const BSONField<long long> WaitForReplMillisField;
+
+        // Cumulative time spent sleeping between delete batches, in milliseconds.
+        static const BSONField<long long> SleepMillisField;
+
         /**
          * Creates a stat object given the mutex from the RangeDeleter object
          * that this instance is keeping track of.
@@ -60,7 +91,11 @@ namespace mongo {
             _lockPtr(lockPtr),
             _totalDeletes(0),
             _pendingDeletes(0),
-            _inProgressDeletes(0) {
+            _inProgressDeletes(0),
+            _deletedDocs(0),
+            _totalBatches(0),
+            _millisWaitingForReplication(0),
+            _millisSleeping(0) {
         }
 
         /**
@@ -104,6 +139,13 @@ namespace mongo {
             return _inProgressDeletes > 0;
         }
 
+        void addDeleteProgress_inlock(const RangeDeleteProgress& progress) {
+            _deletedDocs += progress.docsDeleted;
+            _totalBatches += progress.batchesProcessed;
+            _millisWaitingForReplication += progress.millisWaitingForReplication;
+            _millisSleeping += progress.millisSleeping;
+        }
+
     private:
         // Protects all data structures below this. Not owned here.
         mutable mutex* _lockPtr;
@@ -111,5 +153,10 @@ namespace mongo {
         int _totalDeletes;
         int _pendingDeletes;
         int _inProgressDeletes;
+
+        long long _deletedDocs;
+        long long _totalBatches;
+        long long _millisWaitingForReplication;
+        long long _millisSleeping;
     };
 }
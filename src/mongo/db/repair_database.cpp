@@ -394,9 +394,11 @@ namespace mongo {
 
                 }
 
+                // one-pass copy; don't let it push the rest of the page cache out
                 scoped_ptr<CollectionIterator> iterator( originalCollection->getIterator( DiskLoc(),
                                                                                           false,
-                                                                                          CollectionScanParams::FORWARD ) );
+                                                                                          CollectionScanParams::FORWARD,
+                                                                                          true ) );
                 while ( !iterator->isEOF() ) {
                     DiskLoc loc = iterator->getNext();
                     invariant( !loc.isNull() );
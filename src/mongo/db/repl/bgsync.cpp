@@ -334,6 +334,15 @@ namespace replset {
         // this oplog reader does not do a handshake because we don't want the server it's syncing
         // from to track how far it has synced
         OplogReader r;
+        if (replExhaustOplogFetch) {
+            // Have the sync source stream batches at us as ops arrive rather
+            // than waiting for a getMore per batch; on a high-RTT link this
+            // makes tailing bandwidth-bound instead of RTT-bound.  Only the
+            // bgsync tail opts in -- ghost-sync and feedback readers run
+            // commands on their connections between batches, which an open
+            // exhaust stream does not allow.
+            r.setTailingQueryOptions(r.getTailingQueryOptions() | QueryOption_Exhaust);
+        }
         OpTime lastOpTimeFetched;
         // find a target to sync from the last op time written
         getOplogReader(r);
@@ -434,8 +443,10 @@ namespace replset {
             }
 
             // At this point, we are guaranteed to have at least one thing to read out
-            // of the oplogreader cursor.
-            BSONObj o = r.nextSafe().getOwned();
+            // of the oplogreader cursor.  The object shares the network buffer rather
+            // than being memcpy'd out of it; we consume every op of every batch, so
+            // nothing pins a batch longer than the ops themselves live in _buffer.
+            BSONObj o = r.nextSafeShared();
             opsReadStats.increment();
 
             {
@@ -78,8 +78,10 @@ namespace replset {
         // _mutex protects all of the class variables
         boost::mutex _mutex;
 
-        // Production thread
-        BlockingQueue<BSONObj> _buffer;
+        // Production thread.  The producer thread is the lone pusher and the sync
+        // thread the lone popper, so the lock-free SPSC queue applies; its fast
+        // paths keep per-op overhead off the replication hot path.
+        SingleProducerSingleConsumerQueue<BSONObj> _buffer;
 
         OpTime _lastOpTimeFetched;
         long long _lastH;
@@ -436,6 +436,11 @@ namespace mongo {
             if (!_self->config().arbiterOnly) {
                 bb.appendTimestamp("optime", lastOpTimeWritten.asDate());
                 bb.appendDate("optimeDate", lastOpTimeWritten.getSecs() * 1000LL);
+                OpTime boundary = replset::SyncTail::lastBatchBoundary();
+                if (!boundary.isNull()) {
+                    // consistency point reads on this secondary observe
+                    bb.appendTimestamp("lastBatchBoundary", boundary.asDate());
+                }
             }
 
             int maintenance = _maintenanceMode;
@@ -561,7 +561,7 @@ namespace mongo {
                     if( tp.get() == 0 ) {
                         int nthr = min(8, replSettings.pretouch);
                         nthr = max(nthr, 1);
-                        tp.reset( new ThreadPool(nthr) );
+                        tp.reset( new WorkStealingPool(nthr) );
                     }
                     vector<BSONObj> v;
                     oplogReader.peek(v, replSettings.pretouch);
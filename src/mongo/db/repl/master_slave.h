@@ -58,7 +58,7 @@ namespace mongo {
     };
 
     namespace threadpool {
-        class ThreadPool;
+        class WorkStealingPool;
     }
 
     /* A Source is a source from which we can pull (replicate) data.
@@ -72,7 +72,7 @@ namespace mongo {
        not done (always use main for now).
     */
     class ReplSource {
-        shared_ptr<threadpool::ThreadPool> tp;
+        shared_ptr<threadpool::WorkStealingPool> tp;
 
         void resync(const std::string& dbName);
 
@@ -42,6 +42,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/dbhash.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/dur.h"
 #include "mongo/db/index_builder.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/namespace_string.h"
@@ -55,6 +56,7 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/elapsed_tracker.h"
@@ -132,19 +134,42 @@ namespace mongo {
             }
         }
 
+        noteOplogWrite();
         OpTime::setLast( ts );
     }
 
     /**
-     * This allows us to stream the oplog entry directly into data region
-     * main goal is to avoid copying the o portion
-     * which can be very large
-     * TODO: can have this build the entire doc
+     * Streams a complete oplog entry directly into the allocated oplog record.
+     *
+     * The entry layout is fixed ({ts, h, v, op, ns, [fromMigrate], [b], [o2], o}),
+     * so the header elements are laid down by hand from the raw field values
+     * instead of being staged through a BSONObjBuilder first; each byte of the
+     * entry - including the user document, which can be very large - is written
+     * exactly once, into the mapped memory of the record.
+     *
+     * A 'version' of 0 selects the old master/slave entry format, which carries
+     * neither the 'h' nor the 'v' field.
      */
     class OplogDocWriter : public DocWriter {
     public:
-        OplogDocWriter( const BSONObj& frame, const BSONObj& oField )
-            : _frame( frame ), _oField( oField ) {
+        OplogDocWriter( unsigned long long ts,
+                        long long hash,
+                        int version,
+                        const char* opstr,
+                        const char* ns,
+                        const BSONObj& oField,
+                        const BSONObj* o2 = NULL,
+                        const bool* bb = NULL,
+                        bool fromMigrate = false )
+            : _ts( ts ),
+              _hash( hash ),
+              _version( version ),
+              _opstr( opstr ),
+              _ns( ns ),
+              _oField( oField ),
+              _o2( o2 ),
+              _bb( bb ),
+              _fromMigrate( fromMigrate ) {
         }
 
         ~OplogDocWriter(){}
@@ -152,28 +177,97 @@ namespace mongo {
         void writeDocument( char* start ) const {
             char* buf = start;
 
-            memcpy( buf, _frame.objdata(), _frame.objsize() - 1 ); // don't copy final EOO
+            appendInt( buf, static_cast<int>( documentSize() ) );
 
-            reinterpret_cast<int*>( buf )[0] = documentSize();
+            appendName( buf, Timestamp, "ts" );
+            appendLongLong( buf, static_cast<long long>( _ts ) );
 
-            buf += ( _frame.objsize() - 1 );
-            buf[0] = (char)Object;
-            buf[1] = 'o';
-            buf[2] = 0;
-            memcpy( buf+3, _oField.objdata(), _oField.objsize() );
-            buf += 3 + _oField.objsize();
-            buf[0] = EOO;
+            if ( _version > 0 ) {
+                appendName( buf, NumberLong, "h" );
+                appendLongLong( buf, _hash );
+                appendName( buf, NumberInt, "v" );
+                appendInt( buf, _version );
+            }
+
+            appendString( buf, "op", _opstr );
+            appendString( buf, "ns", _ns );
+
+            if ( _fromMigrate ) {
+                appendName( buf, Bool, "fromMigrate" );
+                *buf++ = 1;
+            }
+            if ( _bb ) {
+                appendName( buf, Bool, "b" );
+                *buf++ = *_bb ? 1 : 0;
+            }
+            if ( _o2 ) {
+                appendName( buf, Object, "o2" );
+                appendBytes( buf, _o2->objdata(), _o2->objsize() );
+            }
+
+            appendName( buf, Object, "o" );
+            appendBytes( buf, _oField.objdata(), _oField.objsize() );
 
-            verify( static_cast<size_t>( ( buf + 1 ) - start ) == documentSize() ); // DEV?
+            *buf++ = (char)EOO;
+
+            verify( static_cast<size_t>( buf - start ) == documentSize() ); // DEV?
         }
 
         size_t documentSize() const {
-            return _frame.objsize() + _oField.objsize() + 1 /* type */ + 2 /* "o" */;
+            size_t size = 4;                                      // leading length word
+            size += 1 + 3 + 8;                                    // ts
+            if ( _version > 0 ) {
+                size += 1 + 2 + 8;                                // h
+                size += 1 + 2 + 4;                                // v
+            }
+            size += 1 + 3 + 4 + strlen( _opstr ) + 1;             // op
+            size += 1 + 3 + 4 + strlen( _ns ) + 1;                // ns
+            if ( _fromMigrate )
+                size += 1 + 12 + 1;                               // fromMigrate
+            if ( _bb )
+                size += 1 + 2 + 1;                                // b
+            if ( _o2 )
+                size += 1 + 3 + _o2->objsize();                   // o2
+            size += 1 + 2 + _oField.objsize();                    // o
+            size += 1;                                            // EOO
+            return size;
         }
 
     private:
-        BSONObj _frame;
+        static void appendBytes( char*& buf, const void* src, size_t len ) {
+            memcpy( buf, src, len );
+            buf += len;
+        }
+
+        static void appendInt( char*& buf, int v ) {
+            appendBytes( buf, &v, 4 );
+        }
+
+        static void appendLongLong( char*& buf, long long v ) {
+            appendBytes( buf, &v, 8 );
+        }
+
+        static void appendName( char*& buf, BSONType t, const char* name ) {
+            *buf++ = (char)t;
+            appendBytes( buf, name, strlen( name ) + 1 );
+        }
+
+        static void appendString( char*& buf, const char* name, const char* value ) {
+            appendName( buf, String, name );
+            int len = strlen( value ) + 1;
+            appendInt( buf, len );
+            appendBytes( buf, value, len );
+        }
+
+        unsigned long long _ts;
+        long long _hash;
+        int _version;
+        const char* _opstr;
+        const char* _ns;
         BSONObj _oField;
+        const BSONObj* _o2;
+        const bool* _bb;
+        bool _fromMigrate;
     };
 
     /* we write to local.oplog.rs:
@@ -195,23 +289,56 @@ namespace mongo {
 
     */
 
-    // global is safe as we are in write lock. we put the static outside the function to avoid the implicit mutex 
-    // the compiler would use if inside the function.  the reason this is static is to avoid a malloc/free for this
-    // on every logop call.
-    static BufBuilder logopbufbuilder(8*1024);
+    // Journal commit epoch captured right after the most recent oplog write.
+    // Tailing getMores wait on it (waitForNewerOplogEntry) so they wake when
+    // the entry is durable rather than on a polling sleep.
+    static AtomicUInt64 lastOplogWriteEpoch;
+
+    static void noteOplogWrite() {
+        lastOplogWriteEpoch.store( getDur().commitEpoch() );
+    }
+
+    void waitForNewerOplogEntry( OpTime last, unsigned millis ) {
+        // woken by OpTime::now() as soon as logOp hands out a newer optime;
+        // the entry itself becomes visible when the writer releases the
+        // 'local' write lock, which our caller queues on anyway
+        last.waitForDifferent( millis );
+
+        // now wait for the journal to have the entry.  when it already does
+        // (or --dur is off) this returns immediately; otherwise the journal
+        // thread sees us waiting and commits early, so this is bounded by a
+        // fraction of the journal commit interval.
+        getDur().awaitCommitOf( lastOplogWriteEpoch.load() );
+    }
+
     static const int OPLOG_VERSION = 2;
     static void _logOpRS(const char *opstr, const char *ns, const char *logNS, const BSONObj& obj, BSONObj *o2, bool *bb, bool fromMigrate ) {
-        Lock::DBWrite lk1("local");
+        DEV verify( logNS == 0 ); // check this was never a master/slave master
 
         if ( strncmp(ns, "local.", 6) == 0 ) {
-            if ( strncmp(ns, "local.slaves", 12) == 0 )
+            if ( strncmp(ns, "local.slaves", 12) == 0 ) {
+                Lock::DBWrite lk1("local");
                 resetSlaveCache();
+            }
             return;
         }
 
-        mutex::scoped_lock lk2(OpTime::m);
+        /* the entry is never staged through a BSONObjBuilder: once the (optime,
+           hash) slot is reserved, OplogDocWriter lays the fixed-layout header
+           down directly in the allocated record and copies the user document
+           into place exactly once.
+        */
+        Lock::DBWrite lk1("local");
+
+        // Reserve this entry's slot.  The global OpTime mutex is held only for
+        // the timestamp handout; oplog writers are already serialized with each
+        // other by the 'local' write lock above.
+        OpTime ts;
+        {
+            mutex::scoped_lock lk2(OpTime::m);
+            ts = OpTime::now(lk2);
+        }
 
-        const OpTime ts = OpTime::now(lk2);
         long long hashNew;
         if( theReplSet ) {
             if (!theReplSet->box.getState().primary()) {
@@ -226,27 +353,6 @@ namespace mongo {
             hashNew = 0;
         }
 
-        /* we jump through a bunch of hoops here to avoid copying the obj buffer twice --
-           instead we do a single copy to the destination position in the memory mapped file.
-        */
-
-        logopbufbuilder.reset();
-        BSONObjBuilder b(logopbufbuilder);
-        b.appendTimestamp("ts", ts.asDate());
-        b.append("h", hashNew);
-        b.append("v", OPLOG_VERSION);
-        b.append("op", opstr);
-        b.append("ns", ns);
-        if (fromMigrate) 
-            b.appendBool("fromMigrate", true);
-        if ( bb )
-            b.appendBool("b", *bb);
-        if ( o2 )
-            b.append("o2", *o2);
-        BSONObj partial = b.done();
-
-        DEV verify( logNS == 0 ); // check this was never a master/slave master
-
         if ( localOplogRSCollection == 0 ) {
             Client::Context ctx(rsoplog, storageGlobalParams.dbpath);
             localDB = ctx.db();
@@ -256,7 +362,8 @@ namespace mongo {
         }
 
         Client::Context ctx(rsoplog, localDB);
-        OplogDocWriter writer( partial, obj );
+        OplogDocWriter writer( ts.asDate(), hashNew, OPLOG_VERSION, opstr, ns, obj,
+                               o2, bb, fromMigrate );
         checkOplogInsert( localOplogRSCollection->insertDocument( &writer, false ) );
 
         /* todo: now() has code to handle clock skew.  but if the skew server to server is large it will get unhappy.
@@ -279,11 +386,80 @@ namespace mongo {
             ctx.getClient()->setLastOp( ts );
         }
 
+        noteOplogWrite();
+    }
+
+    /** batch flavor of _logOpRS for inserts: one local db lock, one optime mutex
+        acquisition and one Context for the whole group of documents. */
+    static void _logInsertOpsRS(const char *ns, const vector<BSONObj>& docs) {
+        if ( strncmp(ns, "local.", 6) == 0 ) {
+            if ( strncmp(ns, "local.slaves", 12) == 0 ) {
+                Lock::DBWrite lk1("local");
+                resetSlaveCache();
+            }
+            return;
+        }
+
+        Lock::DBWrite lk1("local");
+
+        // Reserve all the optime slots at once; we hold the local db lock so no
+        // other oplog writer can interleave with the batch.
+        vector<OpTime> timestamps( docs.size() );
+        {
+            mutex::scoped_lock lk2(OpTime::m);
+            for ( size_t i = 0; i < docs.size(); i++ )
+                timestamps[i] = OpTime::now(lk2);
+        }
+
+        if( theReplSet && !theReplSet->box.getState().primary() ) {
+            log() << "replSet error : logInsertOps() but not primary";
+            fassertFailed(17432);
+        }
+        verify( theReplSet || *ns == 0 );
+
+        if ( localOplogRSCollection == 0 ) {
+            Client::Context ctx(rsoplog, storageGlobalParams.dbpath);
+            localDB = ctx.db();
+            verify( localDB );
+            localOplogRSCollection = localDB->getCollection( rsoplog );
+            massert(17433, "local.oplog.rs missing. did you drop it? if so restart server", localOplogRSCollection);
+        }
+
+        Client::Context ctx(rsoplog, localDB);
+
+        long long hashNew = theReplSet ? theReplSet->lastH : 0;
+        for ( size_t i = 0; i < docs.size(); i++ ) {
+            const OpTime& ts = timestamps[i];
+            if( theReplSet )
+                hashNew = (hashNew * 131 + ts.asLL()) * 17 + theReplSet->selfId();
+
+            OplogDocWriter writer( ts.asDate(), hashNew, OPLOG_VERSION, "i", ns, docs[i] );
+            checkOplogInsert( localOplogRSCollection->insertDocument( &writer, false ) );
+        }
+
+        if( theReplSet ) {
+            const OpTime& last = timestamps.back();
+            if( !(theReplSet->lastOpTimeWritten<timestamps.front()) ) {
+                log() << "replication oplog stream went back in time. previous timestamp: "
+                      << theReplSet->lastOpTimeWritten << " newest timestamp: " << timestamps.front()
+                      << ". attempting to sync directly from primary." << endl;
+                std::string errmsg;
+                BSONObjBuilder result;
+                if (!theReplSet->forceSyncFrom(theReplSet->box.getPrimary()->fullName(),
+                                               errmsg, result)) {
+                    log() << "Can't sync from primary: " << errmsg << endl;
+                }
+            }
+            theReplSet->lastOpTimeWritten = last;
+            theReplSet->lastH = hashNew;
+            ctx.getClient()->setLastOp( last );
+        }
+
+        noteOplogWrite();
     }
 
     static void _logOpOld(const char *opstr, const char *ns, const char *logNS, const BSONObj& obj, BSONObj *o2, bool *bb, bool fromMigrate ) {
         Lock::DBWrite lk("local");
-        static BufBuilder bufbuilder(8*1024); // todo there is likely a mutex on this constructor
 
         if ( strncmp(ns, "local.", 6) == 0 ) {
             if ( strncmp(ns, "local.slaves", 12) == 0 ) {
@@ -297,23 +473,6 @@ namespace mongo {
         const OpTime ts = OpTime::now(lk2);
         Client::Context context("", 0);
 
-        /* we jump through a bunch of hoops here to avoid copying the obj buffer twice --
-           instead we do a single copy to the destination position in the memory mapped file.
-        */
-
-        bufbuilder.reset();
-        BSONObjBuilder b(bufbuilder);
-        b.appendTimestamp("ts", ts.asDate());
-        b.append("op", opstr);
-        b.append("ns", ns);
-        if (fromMigrate) 
-            b.appendBool("fromMigrate", true);
-        if ( bb )
-            b.appendBool("b", *bb);
-        if ( o2 )
-            b.append("o2", *o2);
-        BSONObj partial = b.done(); // partial is everything except the o:... part.
-
         if( logNS == 0 ) {
             logNS = "local.oplog.$main";
         }
@@ -327,10 +486,12 @@ namespace mongo {
         }
 
         Client::Context ctx(logNS , localDB);
-        OplogDocWriter writer( partial, obj );
+        // version 0: old-style entry without the h and v fields
+        OplogDocWriter writer( ts.asDate(), 0, 0, opstr, ns, obj, o2, bb, fromMigrate );
         checkOplogInsert( localOplogMainCollection->insertDocument( &writer, false ) );
 
         context.getClient()->setLastOp( ts );
+        noteOplogWrite();
     }
 
     static void (*_logOp)(const char *opstr, const char *ns, const char *logNS, const BSONObj& obj, BSONObj *o2, bool *bb, bool fromMigrate ) = _logOpOld;
@@ -382,6 +543,33 @@ namespace mongo {
 
     }
 
+    void logInsertOps(const char* ns, const vector<BSONObj>& docs) {
+        if ( docs.empty() )
+            return;
+
+        if ( replSettings.master ) {
+            if ( _logOp == _logOpRS ) {
+                _logInsertOpsRS(ns, docs);
+            }
+            else {
+                // master/slave and uninitialized replication keep the
+                // one-op-at-a-time path
+                for ( size_t i = 0; i < docs.size(); i++ )
+                    _logOp("i", ns, 0, docs[i], 0, 0, false);
+            }
+        }
+
+        for ( size_t i = 0; i < docs.size(); i++ ) {
+            logOpForSharding("i", ns, docs[i], NULL, NULL, false);
+            logOpForDbHash("i", ns, docs[i], NULL, NULL, false);
+            getGlobalAuthorizationManager()->logOp("i", ns, docs[i], NULL, NULL);
+        }
+
+        if ( strstr( ns, ".system.js" ) ) {
+            Scope::storedFuncMod(); // this is terrible
+        }
+    }
+
     void createOplog() {
         Lock::GlobalWrite lk;
 
@@ -639,7 +827,7 @@ namespace mongo {
                 verify( opType[1] == 'b' ); // "db" advertisement
         }
         else if ( *opType == 'c' ) {
-            BufBuilder bb;
+            PooledBufBuilder bb;
             BSONObjBuilder ob;
             _runCommands(ns, o, bb, ob, true, 0);
             // _runCommands takes care of adjusting opcounters for command counting.
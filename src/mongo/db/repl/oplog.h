@@ -28,6 +28,10 @@
 
 #pragma once
 
+#include <vector>
+
+#include "mongo/bson/optime.h"
+
 namespace mongo {
 
     class BSONObj;
@@ -70,9 +74,24 @@ namespace mongo {
                 BSONObj *patt = NULL, bool *b = NULL, bool fromMigrate = false,
                 const BSONObj* fullObj = NULL );
 
+    /** Log a batch of inserts into 'ns' as one group: the local db lock and
+        optime mutex are taken once for the whole batch rather than once per
+        document.  Equivalent to calling logOp( "i", ns, doc ) for each doc.
+    */
+    void logInsertOps( const char *ns, const std::vector<BSONObj>& docs );
+
     // Log an empty no-op operation to the local oplog
     void logKeepalive();
 
+    /**
+     * Parks a tailing (awaitData) getMore until an oplog entry newer than
+     * 'last' has been written and journaled, or roughly 'millis' ms elapsed.
+     * logOp wakes the waiters the moment it hands out a newer optime, and the
+     * journal's commit notification then releases them once the entry is
+     * durable -- no polling sleeps.
+     */
+    void waitForNewerOplogEntry( OpTime last, unsigned millis );
+
     /** puts obj in the oplog as a comment (a no-op).  Just for diags.
         convention is
           { msg : "text", ... }
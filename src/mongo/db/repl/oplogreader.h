@@ -37,6 +37,13 @@
 namespace mongo {
 
     extern const BSONObj reverseNaturalObj; // { $natural : -1 }
+
+    // If set, replica set members tail their sync source's oplog in exhaust
+    // mode: the source pushes batches as ops arrive instead of waiting for a
+    // getMore round trip per batch, so a high-latency link no longer caps
+    // replication throughput at one batch per RTT.
+    extern bool replExhaustOplogFetch;
+
     /**
      * Authenticates conn using the server's cluster-membership credentials.
      *
@@ -54,16 +61,13 @@ namespace mongo {
         int _tailingQueryOptions;
     public:
         OplogReader();
-        ~OplogReader() { }
-        void resetCursor() { cursor.reset(); }
-        void resetConnection() {
-            cursor.reset();
-            _conn.reset();
-        }
+        ~OplogReader() { resetConnection(); }
+        /** drops the connection too (and reconnects) if the server is still
+            streaming exhaust batches at the cursor, so conn() stays usable */
+        void resetCursor();
+        void resetConnection();
         DBClientConnection* conn() { return _conn.get(); }
-        BSONObj findOne(const char *ns, const Query& q) {
-            return conn()->findOne(ns, q, 0, QueryOption_SlaveOk);
-        }
+        BSONObj findOne(const char *ns, const Query& q);
         BSONObj getLastOp(const char *ns) {
             return findOne(ns, Query().sort(reverseNaturalObj));
         }
@@ -136,9 +140,7 @@ namespace mongo {
         }
 
         int currentBatchMessageSize() {
-            if( NULL == cursor->getMessage() )
-                return 0;
-            return cursor->getMessage()->size();
+            return cursor->currentBatchMessageSize();
         }
 
         /* old mongod's can't do the await flag... */
@@ -154,6 +156,8 @@ namespace mongo {
                 cursor->peek(v,n);
         }
         BSONObj nextSafe() { return cursor->nextSafe(); }
+        /** owned without copying out of the network buffer; see DBClientCursor::nextShared() */
+        BSONObj nextSafeShared() { return cursor->nextSafeShared(); }
         BSONObj next() { return cursor->next(); }
         void putBack(BSONObj op) { cursor->putBack(op); }
         
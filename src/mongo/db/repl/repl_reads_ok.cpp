@@ -40,16 +40,36 @@ namespace mongo {
     /** we allow queries to SimpleSlave's */
     void replVerifyReadsOk(const LiteParsedQuery* pq) {
         if( replSet ) {
-            // todo: speed up the secondary case.  as written here there are 2 mutex entries, it
-            // can b 1.
+            if( theReplSet ) {
+                // One lock-free state fetch covers both the primary and the
+                // secondary check; the old isMaster()/isSecondary() pair
+                // entered the StateBox rwlock twice per read, contending
+                // with the heartbeat and manager threads that write-lock it.
+                const MemberState s = theReplSet->box.getStateLockless();
+                if( s.primary() ) return;
+                if ( cc().isGod() ) return;
+                {
+                    // queries to "local" are always allowed, as in isMaster()
+                    Database *database = cc().database();
+                    verify( database );
+                    if( database->name() == "local" ) return;
+                }
+                uassert(NotMasterNoSlaveOkCode, "not master and slaveOk=false",
+                        !pq || pq->hasOption(QueryOption_SlaveOk) || pq->hasReadPref());
+                uassert(NotMasterOrSecondaryCode,
+                        "not master or secondary; cannot currently read from this replSet member",
+                        s.secondary() );
+                return;
+            }
+
+            // --replSet specified but the set is not initialized yet
             if( isMaster() ) return;
             if ( cc().isGod() ) return;
 
             uassert(NotMasterNoSlaveOkCode, "not master and slaveOk=false",
                     !pq || pq->hasOption(QueryOption_SlaveOk) || pq->hasReadPref());
-            uassert(NotMasterOrSecondaryCode,
-                    "not master or secondary; cannot currently read from this replSet member",
-                    theReplSet && theReplSet->isSecondary() );
+            uasserted(NotMasterOrSecondaryCode,
+                      "not master or secondary; cannot currently read from this replSet member");
         }
         else {
             // master/slave
@@ -33,6 +33,7 @@
 #include <boost/scoped_ptr.hpp>
 
 #include "mongo/client/connpool.h"
+#include "mongo/db/client_basic.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/internal_plans.h"
@@ -195,6 +196,24 @@ namespace mongo {
 
             appendReplicationInfo(result, 0);
 
+            // Negotiated wire compression.  A client listing snappy in its
+            // isMaster can decode snappy-framed messages, so we may enable
+            // compression on the port right away -- even this reply can go out
+            // compressed.
+            BSONElement compression = cmdObj["compression"];
+            ClientBasic* client = ClientBasic::getCurrent();
+            if ( compression.type() == Array && client && client->port() ) {
+                BSONObjIterator it( compression.Obj() );
+                while ( it.more() ) {
+                    BSONElement alg = it.next();
+                    if ( alg.type() == String && alg.str() == "snappy" ) {
+                        result.append( "compression", BSON_ARRAY( "snappy" ) );
+                        client->port()->setWireCompression( true );
+                        break;
+                    }
+                }
+            }
+
             result.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
             result.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
             result.appendNumber("maxWriteBatchSize", BatchedCommandRequest::kMaxWriteBatchSize);
@@ -41,9 +41,10 @@
 #include "mongo/db/repl/rs_member.h"
 #include "mongo/db/repl/rs_sync.h"
 #include "mongo/db/repl/sync_source_feedback.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/list.h"
 #include "mongo/util/concurrency/msg.h"
-#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/work_stealing_pool.h"
 #include "mongo/util/concurrency/value.h"
 #include "mongo/util/net/hostandport.h"
 
@@ -297,6 +298,13 @@ namespace mongo {
             rwlock lk(m, false);
             return sp.state;
         }
+        /** as getState() but a single atomic load; for hot paths (e.g. the
+            per-read state check) where taking the rwlock, which heartbeat and
+            manager threads write-lock, is not worth it.  A state read was
+            stale the moment the lock above was released anyway. */
+        MemberState getStateLockless() const {
+            return MemberState(_stateCache.load());
+        }
         const Member* getPrimary() const {
             rwlock lk(m, false);
             return sp.primary;
@@ -307,6 +315,7 @@ namespace mongo {
                 log() << "replSet " << s.toString() << rsLog;
             }
             sp.state = s;
+            _stateCache.store(s.s);
             if( s.primary() ) {
                 sp.primary = self;
             }
@@ -318,6 +327,7 @@ namespace mongo {
         void set(MemberState s, const Member *p) {
             rwlock lk(m, true);
             sp.state = s;
+            _stateCache.store(s.s);
             sp.primary = p;
         }
         void setSelfPrimary(const Member *self) { change(MemberState::RS_PRIMARY, self); }
@@ -331,10 +341,13 @@ namespace mongo {
             verify(!sp.state.primary());
             sp.primary = remote;
         }
-        StateBox() : m("StateBox") { }
+        StateBox() : m("StateBox"), _stateCache((int) MemberState::RS_STARTUP) { }
     private:
         RWLock m;
         SP sp;
+        // mirror of sp.state, kept in sync by the writers above, so
+        // getStateLockless() readers never touch the rwlock
+        AtomicInt32 _stateCache;
     };
 
     void parseReplsetCmdLine(const std::string& cfgString,
@@ -584,9 +597,9 @@ namespace mongo {
         // keep a list of hosts that we've tried recently that didn't work
         map<string,time_t> _veto;
         // persistent pool of worker threads for writing ops to the databases
-        threadpool::ThreadPool _writerPool;
+        threadpool::WorkStealingPool _writerPool;
         // persistent pool of worker threads for prefetching
-        threadpool::ThreadPool _prefetcherPool;
+        threadpool::WorkStealingPool _prefetcherPool;
 
     public:
         // Allow index prefetching to be turned on/off
@@ -603,8 +616,8 @@ namespace mongo {
             
         static const int replWriterThreadCount;
         static const int replPrefetcherThreadCount;
-        threadpool::ThreadPool& getPrefetchPool() { return _prefetcherPool; }
-        threadpool::ThreadPool& getWriterPool() { return _writerPool; }
+        threadpool::WorkStealingPool& getPrefetchPool() { return _prefetcherPool; }
+        threadpool::WorkStealingPool& getWriterPool() { return _writerPool; }
 
         const ReplSetConfig::MemberCfg& myConfig() const { return _config; }
         bool tryToGoLiveAsASecondary(OpTime&); // readlocks
@@ -675,8 +688,8 @@ namespace mongo {
         void summarizeAsHtml(stringstream& ss) const { _summarizeAsHtml(ss); }
         void summarizeStatus(BSONObjBuilder& b) const  { _summarizeStatus(b); }
         void fillIsMaster(BSONObjBuilder& b) { _fillIsMaster(b); }
-        threadpool::ThreadPool& getPrefetchPool() { return ReplSetImpl::getPrefetchPool(); }
-        threadpool::ThreadPool& getWriterPool() { return ReplSetImpl::getWriterPool(); }
+        threadpool::WorkStealingPool& getPrefetchPool() { return ReplSetImpl::getPrefetchPool(); }
+        threadpool::WorkStealingPool& getWriterPool() { return ReplSetImpl::getWriterPool(); }
 
         /**
          * We have a new config (reconfig) - apply it.
@@ -41,6 +41,7 @@
 #include "mongo/bson/optime.h"
 #include "mongo/db/repl/replication_server_status.h"  // replSettings
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -48,6 +49,10 @@ namespace mongo {
     using namespace mongoutils;
     using namespace bson;
 
+    // how many collections the data pass of initial sync clones concurrently,
+    // each over its own connection to the sync source
+    MONGO_EXPORT_SERVER_PARAMETER(replInitialSyncCloneThreads, int, 4);
+
     void dropAllDatabasesExceptLocal();
 
     // add try/catch with sleep
@@ -108,6 +113,9 @@ namespace mongo {
             options.mayBeInterrupted = false;
             options.syncData = dataPass;
             options.syncIndexes = ! dataPass;
+            if ( dataPass )
+                options.numParallelCollections =
+                    replInitialSyncCloneThreads < 1 ? 1 : replInitialSyncCloneThreads;
 
             if (!cloner.go(ctx.ctx(), master, options, NULL, err, &errCode)) {
                 sethbmsg(str::stream() << "initial sync: error while "
@@ -30,10 +30,13 @@
 
 #include "mongo/db/repl/rs_sync.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "third_party/murmurhash3/MurmurHash3.h"
 
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/commands/fsync.h"
@@ -47,6 +50,8 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/timer.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/base/counter.h"
@@ -75,6 +80,20 @@ namespace replset {
 
     MONGO_FP_DECLARE(rsSyncApplyStop);
 
+    // Wall-clock time a full apply round (prefetch join, batch dispatch, lock
+    // wait and writes) should take.  The per-batch op limit is retuned toward
+    // this after every batch; <= 0 pins the limit at replBatchLimitOperations.
+    MONGO_EXPORT_SERVER_PARAMETER(replApplyBatchTargetMillis, int, 100);
+
+    // Floor for the tuned op limit, so a run of slow batches can't shrink
+    // batches to the point where per-batch overhead dominates.
+    const unsigned int replBatchLimitOperationsMin = 64;
+
+    // "ts" of the last op of the last batch to be fully applied and written
+    // to the local oplog.  Written by the apply thread at the end of
+    // applyOpsToOplog, read lock-free via SyncTail::lastBatchBoundary().
+    static AtomicUInt64 lastBatchBoundaryTs;
+
     // Number and time of each ApplyOps worker pool round
     static TimerStats applyBatchStats;
     static ServerStatusMetricField<TimerStats> displayOpBatchesApplied(
@@ -84,10 +103,18 @@ namespace replset {
     static Counter64 opsAppliedStats;
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
+    //The oplog entries set aside for duplicate key conflicts
+    static Counter64 opsQuarantinedStats;
+    static ServerStatusMetricField<Counter64> displayOpsQuarantined(
+                                                    "repl.apply.quarantined",
+                                                    &opsQuarantinedStats );
 
 
     SyncTail::SyncTail(BackgroundSyncInterface *q) :
-        Sync(""), oplogVersion(0), _networkQueue(q)
+        Sync(""), oplogVersion(0), _networkQueue(q),
+        _batchLimitOps(replBatchLimitOperations),
+        _quarantineMutex("SyncTail::_quarantineMutex"),
+        _retryingQuarantined(false)
     {}
 
     SyncTail::~SyncTail() {}
@@ -155,6 +182,42 @@ namespace replset {
         }
     }
 
+    // Called by the writer loops when applying 'op' raised a duplicate key
+    // error.  While the batch is still in flight the op that frees the key
+    // is, with the _id fan-out, by construction likely pending in this very
+    // batch -- and if that freeing op is an update, removing the holder now
+    // would make it later re-apply as an upsert that reconstructs only the
+    // $set fields: silent divergence.  So the first pass only parks the op on
+    // the quarantine queue and keeps the batch moving.  The destructive local
+    // resolution runs solely on the post-batch retry, where a surviving
+    // conflict genuinely proves the holder stale.
+    static void handleDuplicateKey(SyncTail* st, const BSONObj& op,
+                                   bool convertUpdateToUpsert) {
+        if (st->isRetryingQuarantined()) {
+            bool resolved;
+            {
+                Lock::GlobalWrite lk;
+                resolved = st->resolveDuplicateKey(op);
+            }
+            if (resolved) {
+                try {
+                    if (st->syncApply(op, convertUpdateToUpsert)) {
+                        return;
+                    }
+                }
+                catch (const DBException& e) {
+                    LOG(1) << "replSet op failed again after local duplicate key "
+                           << "resolution: " << causedBy(e) << rsLog;
+                }
+            }
+            st->quarantineOp(op); // still conflicted; retryQuarantinedOps is fatal on this
+            return;
+        }
+        LOG(1) << "replSet quarantining op with duplicate key conflict until "
+               << "end of batch: " << op.toString() << rsLog;
+        st->quarantineOp(op);
+    }
+
     // This free function is used by the writer threads to apply each op
     void multiSyncApply(const std::vector<BSONObj>& ops, SyncTail* st) {
         initializeWriterThread();
@@ -171,6 +234,10 @@ namespace replset {
                     fassertFailedNoTrace(16359);
                 }
             } catch (const DBException& e) {
+                if (e.getCode() == ASSERT_ID_DUPKEY) {
+                    handleDuplicateKey(st, *it, convertUpdatesToUpserts);
+                    continue;
+                }
                 error() << "writer worker caught exception: " << causedBy(e)
                         << " on: " << it->toString() << endl;
                 fassertFailedNoTrace(16360);
@@ -203,6 +270,10 @@ namespace replset {
                 }
             }
             catch (const DBException& e) {
+                if (e.getCode() == ASSERT_ID_DUPKEY) {
+                    handleDuplicateKey(st, *it, false);
+                    continue;
+                }
                 error() << "exception: " << causedBy(e) << " on: " << it->toString() << endl;
                 fassertFailedNoTrace(16361);
             }
@@ -232,38 +303,82 @@ namespace replset {
         }
     }
 
-    // Doles out all the work to the reader pool threads and waits for them to complete
-    void SyncTail::prefetchOps(const std::deque<BSONObj>& ops) {
-        threadpool::ThreadPool& prefetcherPool = theReplSet->getPrefetchPool();
-        for (std::deque<BSONObj>::const_iterator it = ops.begin();
-             it != ops.end();
-             ++it) {
-            prefetcherPool.schedule(&prefetchOp, *it);
-        }
-        prefetcherPool.join();
+    // Hands one op to the reader pool and returns without waiting.  Ops come
+    // through here as tryPopAndWaitForMore pops them into a batch, so the
+    // prefetchers work through the batch while it is still being assembled
+    // (including the up-to-a-second waits for more ops).  multiApply joins the
+    // pool before taking any write locks; overlapping further into the
+    // previous batch's apply would gain nothing, as the prefetch read locks
+    // are excluded by ParallelBatchWriterMode for its duration anyway.
+    void SyncTail::schedulePrefetch(const BSONObj& op) {
+        theReplSet->getPrefetchPool().schedule(&prefetchOp, op);
     }
-    
+
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
                                      MultiSyncApplyFunc applyFunc) {
-        ThreadPool& writerPool = theReplSet->getWriterPool();
+        WorkStealingPool& writerPool = theReplSet->getWriterPool();
         TimerHolder timer(&applyBatchStats);
-        for (std::vector< std::vector<BSONObj> >::const_iterator it = writerVectors.begin();
-             it != writerVectors.end();
-             ++it) {
-            if (!it->empty()) {
-                writerPool.schedule(applyFunc, boost::cref(*it), this);
+        for (size_t i = 0; i < writerVectors.size(); i++) {
+            if (!writerVectors[i].empty()) {
+                // vector i always lands on worker i, so ops for a given
+                // namespace keep hitting the same worker's warm caches
+                writerPool.scheduleOn(i, boost::bind(applyFunc,
+                                                     boost::cref(writerVectors[i]),
+                                                     this));
             }
         }
         writerPool.join();
     }
 
+    void SyncTail::quarantineOp(const BSONObj& op) {
+        SimpleMutex::scoped_lock lk(_quarantineMutex);
+        _quarantined.push_back(op.getOwned());
+        opsQuarantinedStats.increment();
+    }
+
+    // Retries ops the writers set aside for duplicate key conflicts, once
+    // every other op in the batch has been applied.  A conflict between ops
+    // of one collection fanned out across writers -- the delete or update
+    // that frees a unique key racing the insert that claims it -- resolves
+    // itself here.  One that still conflicts now may be resolved against
+    // local state (see handleDuplicateKey / Sync::resolveDuplicateKey);
+    // one that survives even that is real divergence, and fatal.
+    void SyncTail::retryQuarantinedOps(MultiSyncApplyFunc applyFunc) {
+        std::vector<BSONObj> retries;
+        {
+            SimpleMutex::scoped_lock lk(_quarantineMutex);
+            if (_quarantined.empty())
+                return;
+            retries.assign(_quarantined.begin(), _quarantined.end());
+            _quarantined.clear();
+        }
+
+        log() << "replSet retrying " << retries.size()
+              << " op(s) quarantined for duplicate key conflicts" << rsLog;
+
+        // Run on a writer thread so the retry passes the batch writer barrier.
+        _retryingQuarantined = true;
+        WorkStealingPool& writerPool = theReplSet->getWriterPool();
+        writerPool.scheduleOn(0, boost::bind(applyFunc, boost::cref(retries), this));
+        writerPool.join();
+        _retryingQuarantined = false;
+
+        SimpleMutex::scoped_lock lk(_quarantineMutex);
+        if (!_quarantined.empty()) {
+            error() << "replSet op conflicts with local data even after its "
+                    << "full batch applied: " << _quarantined.front().toString() << rsLog;
+            fassertFailedNoTrace(17575);
+        }
+    }
+
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::multiApply( std::deque<BSONObj>& ops, MultiSyncApplyFunc applyFunc ) {
+        Timer applyTimer;
+
+        // Wait for the prefetches scheduled while this batch was assembled.
+        theReplSet->getPrefetchPool().join();
 
-        // Use a ThreadPool to prefetch all the operations in a batch.
-        prefetchOps(ops);
-        
         std::vector< std::vector<BSONObj> > writerVectors(theReplSet->replWriterThreadCount);
         fillWriterVectors(ops, &writerVectors);
         LOG(2) << "replication batch size is " << ops.size() << endl;
@@ -276,11 +391,93 @@ namespace replset {
         Lock::ParallelBatchWriterMode pbwm;
 
         applyOps(writerVectors, applyFunc);
+
+        retryQuarantinedOps(applyFunc);
+
+        tuneBatchLimit(applyTimer.millis(), ops.size());
     }
 
+    void SyncTail::tuneBatchLimit(int applyMillis, size_t opsApplied) {
+        const int target = replApplyBatchTargetMillis;
+        if (target <= 0) {
+            _batchLimitOps = replBatchLimitOperations;
+            return;
+        }
+        if (opsApplied == 0)
+            return;
+
+        // Scale the limit toward the target time, moving at most a factor of
+        // two per batch so a single outlier (a huge op, a journal flush, a
+        // long lock wait) doesn't whipsaw it.  Fast batches grow the limit
+        // back toward the hard cap.
+        double next = static_cast<double>(_batchLimitOps) * target / (applyMillis + 1);
+        next = std::min(next, _batchLimitOps * 2.0);
+        next = std::max(next, _batchLimitOps / 2.0);
+        next = std::min(next, static_cast<double>(replBatchLimitOperations));
+        next = std::max(next, static_cast<double>(replBatchLimitOperationsMin));
+
+        if (static_cast<unsigned int>(next) != _batchLimitOps) {
+            _batchLimitOps = static_cast<unsigned int>(next);
+            LOG(2) << "replSet apply batch limit now " << _batchLimitOps
+                   << " ops (last batch: " << opsApplied << " ops in "
+                   << applyMillis << "ms)" << endl;
+        }
+    }
 
-    void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
+
+    // Returns the _id the op targets, or EOO if there isn't one to key on.  Inserts and
+    // deletes carry the document (or its _id) in "o"; replicated updates carry the query,
+    // always of the form { _id: ... }, in "o2".
+    static BSONElement extractIdForApply(const BSONObj& op) {
+        switch (op.getStringField("op")[0]) {
+        case 'i':
+        case 'd':
+            return op.getObjectField("o")["_id"];
+        case 'u':
+            return op.getObjectField("o2")["_id"];
+        default:
+            return BSONElement();
+        }
+    }
+
+    void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops,
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
+        // Ops for the same document must replay in oplog order, so a document's ops always
+        // hash to the same writer.  Ops for different documents may replay in any relative
+        // order, so within a namespace we spread them over the writers by _id.  A namespace
+        // is pinned to a single writer if any of its ops in this batch lacks an _id to key
+        // on, or if the collection is capped (capped allocation recycles space in insertion
+        // order, so all its ops are ordering-dependent).  Commands and index builds are
+        // applied in single-op batches (see tryPopAndWaitForMore) and never appear here
+        // alongside other ops.
+        //
+        // The keys below point into the ops deque, which outlives both maps.
+        StringMap<bool> parallelizableByNs;
+        for (std::deque<BSONObj>::const_iterator it = ops.begin();
+             it != ops.end();
+             ++it) {
+            const char* ns = it->getStringField("ns");
+            StringMap<bool>::const_iterator cached = parallelizableByNs.find(ns);
+            if (cached == parallelizableByNs.end()) {
+                bool capped = false;
+                try {
+                    Client::ReadContext ctx(ns);
+                    Collection* collection = ctx.ctx().db()->getCollection(ns);
+                    capped = collection && collection->isCapped();
+                }
+                catch (const DBException& e) {
+                    // If we can't look the collection up (e.g. the db doesn't exist yet),
+                    // there is nothing capped to protect.
+                    LOG(2) << "ignoring exception checking capped status of " << ns
+                           << " for parallel apply: " << e.what() << endl;
+                }
+                parallelizableByNs[ns] = !capped;
+            }
+            if (parallelizableByNs[ns] && extractIdForApply(*it).eoo()) {
+                parallelizableByNs[ns] = false;
+            }
+        }
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
@@ -291,16 +488,29 @@ namespace replset {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            if (parallelizableByNs[ns]) {
+                // Sub-hash by _id, seeded with the namespace hash, so independent documents
+                // in a hot collection fan out over all the writers.
+                const BSONElement id = extractIdForApply(*it);
+                MurmurHash3_x86_32( id.value(), id.valuesize(), hash, &hash);
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
         }
     }
 
 
-    InitialSync::InitialSync(BackgroundSyncInterface *q) : 
+    InitialSync::InitialSync(BackgroundSyncInterface *q) :
         SyncTail(q) {}
 
     InitialSync::~InitialSync() {}
 
+    bool InitialSync::resolveDuplicateKey(const BSONObj& o) {
+        // A cloned document can be newer than the op, whatever the op's "ts"
+        // says; always leave the conflict to the quarantine queue.
+        return false;
+    }
+
     BSONObj SyncTail::oplogApplySegment(const BSONObj& applyGTEObj, const BSONObj& minValidObj,
                                      MultiSyncApplyFunc func) {
         OpTime applyGTE = applyGTEObj["ts"]._opTime();
@@ -330,7 +540,7 @@ namespace replset {
                 if (!ops.empty()) {
                     if (now > replBatchLimitSeconds)
                         break;
-                    if (ops.getDeque().size() > replBatchLimitOperations)
+                    if (ops.getDeque().size() > _batchLimitOps)
                         break;
                 }
             }
@@ -416,7 +626,7 @@ namespace replset {
                 if (!ops.empty()) {
                     if (now > replBatchLimitSeconds)
                         break;
-                    if (ops.getDeque().size() > replBatchLimitOperations)
+                    if (ops.getDeque().size() > _batchLimitOps)
                         break;
                 }
                 // occasionally check some things
@@ -538,6 +748,7 @@ namespace replset {
                 // apply commands one-at-a-time
                 ops->push_back(op);
                 _networkQueue->consume();
+                schedulePrefetch(op);
             }
 
             // otherwise, apply what we have so far and come back for the command
@@ -570,11 +781,17 @@ namespace replset {
         ops->push_back(op);
         _networkQueue->consume();
 
+        // Start faulting in the pages this op will touch while we collect
+        // the rest of the batch.
+        schedulePrefetch(op);
+
         // Go back for more ops
         return false;
     }
 
     void SyncTail::applyOpsToOplog(std::deque<BSONObj>* ops) {
+        const OpTime boundary = ops->empty() ? OpTime() : ops->back()["ts"]._opTime();
+
         {
             Lock::DBWrite lk("local");
             while (!ops->empty()) {
@@ -585,10 +802,20 @@ namespace replset {
              }
         }
 
+        // The batch is now fully applied and logged; readers that run between
+        // batches see exactly this boundary.
+        if (!boundary.isNull()) {
+            lastBatchBoundaryTs.store(boundary.asDate());
+        }
+
         // Update write concern on primary
         BackgroundSync::notify();
     }
 
+    OpTime SyncTail::lastBatchBoundary() {
+        return OpTime(lastBatchBoundaryTs.load());
+    }
+
     void SyncTail::handleSlaveDelay(const BSONObj& lastOp) {
         int sd = theReplSet->myConfig().slaveDelay;
 
@@ -35,6 +35,7 @@
 #include "mongo/db/dur.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/repl/sync.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
@@ -106,6 +107,27 @@ namespace replset {
         // Ops are removed from the deque.
         void applyOpsToOplog(std::deque<BSONObj>* ops);
 
+        // Sets an op aside to be retried after the rest of its batch has been
+        // applied, instead of failing the whole batch.  Used by the writer
+        // workers for duplicate key conflicts.
+        void quarantineOp(const BSONObj& op);
+
+        // Whether the post-batch retry of quarantined ops is in progress.  The
+        // destructive local duplicate key resolution is only attempted then:
+        // while the batch is still in flight the op that frees the key may
+        // itself be pending, so a conflict proves nothing about the holder.
+        bool isRetryingQuarantined() const { return _retryingQuarantined; }
+
+        /**
+         * The "ts" of the last op of the last batch to be fully applied and
+         * written to the local oplog, published lock-free after each batch.
+         * Readers are excluded (via ParallelBatchWriterMode) while a batch is
+         * in flight, so this is exactly the consistency boundary any read on
+         * this secondary can observe; a null OpTime means no batch has been
+         * applied since startup.
+         */
+        static OpTime lastBatchBoundary();
+
     protected:
         // Cap the batches using the limit on journal commits.
         // This works out to be 100 MB (64 bit) or 50 MB (32 bit)
@@ -113,7 +135,8 @@ namespace replset {
         static const int replBatchLimitSeconds = 1;
         static const unsigned int replBatchLimitOperations = 5000;
 
-        // Prefetch and write a deque of operations, using the supplied function.
+        // Write a deque of operations, using the supplied function, after
+        // waiting for the prefetches scheduled while the batch was assembled.
         // Initial Sync and Sync Tail each use a different function.
         void multiApply(std::deque<BSONObj>& ops, MultiSyncApplyFunc applyFunc);
 
@@ -123,15 +146,33 @@ namespace replset {
     private:
         BackgroundSyncInterface* _networkQueue;
 
-        // Doles out all the work to the reader pool threads and waits for them to complete
-        void prefetchOps(const std::deque<BSONObj>& ops);
+        // Current upper bound on ops per batch.  Retuned after every batch
+        // toward replApplyBatchTargetMillis of apply time per batch; never
+        // exceeds replBatchLimitOperations.
+        unsigned int _batchLimitOps;
+
+        // Hands an op that was just added to a batch to the reader pool, so
+        // its pages are prefetched while the rest of the batch is assembled.
+        void schedulePrefetch(const BSONObj& op);
         // Used by the thread pool readers to prefetch an op
         static void prefetchOp(const BSONObj& op);
 
+        // Resizes _batchLimitOps based on how long the last batch took to apply
+        void tuneBatchLimit(int applyMillis, size_t opsApplied);
+
         // Doles out all the work to the writer pool threads and waits for them to complete
-        void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
+        void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors,
                       MultiSyncApplyFunc applyFunc);
 
+        // Retries any ops the writers quarantined, once the rest of the batch
+        // has been applied.  Fatal if an op still conflicts after the retry.
+        void retryQuarantinedOps(MultiSyncApplyFunc applyFunc);
+
+        // Ops set aside by quarantineOp() until the end of the current batch.
+        SimpleMutex _quarantineMutex;
+        std::deque<BSONObj> _quarantined;
+        bool _retryingQuarantined;
+
         void fillWriterVectors(const std::deque<BSONObj>& ops, 
                                std::vector< std::vector<BSONObj> >* writerVectors);
         void handleSlaveDelay(const BSONObj& op);
@@ -151,6 +192,13 @@ namespace replset {
          * this runs oplogApplySegment allowing recloning documents.
          */
         BSONObj oplogApplication(const BSONObj& applyGTEObj, const BSONObj& minValidObj);
+
+        /**
+         * During initial sync cloned documents can embed state from
+         * arbitrarily far ahead of the op being applied, so a newer op does
+         * not prove the conflicting local document stale.  Never resolves.
+         */
+        virtual bool resolveDuplicateKey(const BSONObj& o);
     };
 
     // TODO: move hbmsg into an error-keeping class (SERVER-4444)
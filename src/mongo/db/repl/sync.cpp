@@ -32,11 +32,16 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/client.h"
+#include "mongo/db/dbhelpers.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/ops/delete.h"
 #include "mongo/db/repl/oplogreader.h"
+#include "mongo/db/repl/rs.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -133,4 +138,90 @@ namespace mongo {
             return true;
         }
     }
+
+    bool Sync::resolveDuplicateKey(const BSONObj& o) {
+        // should already have write lock
+        const char *ns = o.getStringField("ns");
+
+        // Only a full-document insert is self-contained: the op alone says
+        // exactly what should end up on disk.  A failed update would need the
+        // post-image from somewhere else.
+        if (*o.getStringField("op") != 'i')
+            return false;
+
+        BSONObj doc = o.getObjectField("o");
+        BSONElement id;
+        if (!doc.getObjectID(id))
+            return false;
+
+        if (!theReplSet)
+            return false;
+
+        // The op must be strictly newer than everything applied locally before
+        // we may throw away the document it collides with.  lastOpTimeWritten
+        // only advances once a whole batch is applied, and ops for one
+        // document always apply in oplog order, so a newer "ts" proves the
+        // holder of the conflicting key reflects older state -- the delete or
+        // update that frees the key sits between its insertion and this op.
+        // An op at or before lastOpTimeWritten is a replay of an
+        // already-applied segment (or, if "h" disagrees at equal "ts", a fork
+        // that rollback has to sort out): the local document may be the
+        // product of later ops, so removing it could lose writes.
+        OpTime opTs = o["ts"]._opTime();
+        if (!(theReplSet->lastOpTimeWritten < opTs))
+            return false;
+
+        Client::Context ctx(ns);
+        Collection* collection = ctx.db()->getCollection(ns);
+        if (!collection)
+            return false; // should never happen; something raised the dup key
+
+        // Find whichever local document holds each unique key the op's
+        // document needs, and remove it.  Multikey and sparse unique indexes
+        // can't be probed with a simple equality lookup, so leave those
+        // conflicts to the caller.
+        int removed = 0;
+        IndexCatalog::IndexIterator ii =
+            collection->getIndexCatalog()->getIndexIterator(false);
+        while (ii.more()) {
+            IndexDescriptor* desc = ii.next();
+            if (!desc->unique() || desc->isIdIndex())
+                continue;
+            if (desc->isSparse() || desc->isMultikey())
+                return false;
+
+            BSONObjBuilder probe;
+            BSONObjIterator keys(desc->keyPattern());
+            while (keys.more()) {
+                BSONElement key = keys.next();
+                BSONElement elt = doc.getFieldDotted(key.fieldName());
+                if (elt.eoo()) {
+                    // a missing field indexes as null
+                    probe.appendNull(key.fieldName());
+                }
+                else {
+                    probe.appendAs(elt, key.fieldName());
+                }
+            }
+
+            BSONObj holder;
+            if (!Helpers::findOne(ns, probe.done(), holder, false))
+                continue; // already cleaned up underneath us
+            if (holder["_id"].valuesEqual(id))
+                continue; // our own document; not the source of the conflict
+
+            log() << "replication removing stale document " << holder["_id"]
+                  << " conflicting with " << id << " on " << desc->indexName()
+                  << " (" << ns << ")" << endl;
+            deleteObjects(ns, holder["_id"].wrap(), true);
+            ++removed;
+        }
+
+        if (0 == removed)
+            return false;
+
+        LOG(1) << "replication resolved duplicate key conflict locally for "
+               << id << " (" << ns << ")" << endl;
+        return true;
+    }
 }
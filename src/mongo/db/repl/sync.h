@@ -46,6 +46,25 @@ namespace mongo {
          * If applyOperation_inlock should be called again after an update fails.
          */
         virtual bool shouldRetry(const BSONObj& o);
+
+        /**
+         * Tries to resolve a duplicate key error raised while applying o, using
+         * only local state -- no round trip to the sync source.  Only a
+         * full-document insert is self-contained enough for this: if the op is
+         * provably newer than everything applied locally, whatever document
+         * holds the conflicting unique key is stale and is removed.
+         *
+         * Must be called with the write lock held, like shouldRetry(), and
+         * only once the rest of the op's batch has been applied (see
+         * SyncTail::retryQuarantinedOps): while the batch is in flight the
+         * delete or update that frees the key may itself still be pending,
+         * and removing the holder would lose the writes it carries.
+         *
+         * @return true if the conflicting document(s) were removed and the
+         *         caller should apply o again; false if the conflict could not
+         *         be resolved locally.
+         */
+        virtual bool resolveDuplicateKey(const BSONObj& o);
         void setHostname(const string& hostname);
     };
 
@@ -77,6 +77,7 @@ namespace mongo {
             _dirty = false;
             _started = false;
             _currentlyUpdatingCache = false;
+            _updateGen = 0;
         }
 
         void run() {
@@ -140,6 +141,7 @@ namespace mongo {
             if (last > _slaves[ident]) {
                 _slaves[ident] = last;
                 _dirty = true;
+                _updateGen++;
 
                 if (theReplSet && theReplSet->isPrimary()) {
                     if (!theReplSet->ghost->updateSlave(ident.obj["_id"].OID(), last)) {
@@ -265,11 +267,35 @@ namespace mongo {
             return _slaves.size();
         }
 
+        unsigned long long progressGen() const {
+            scoped_lock mylk(_mutex);
+            return _updateGen;
+        }
+
+        unsigned long long waitForProgress( unsigned long long lastGen, unsigned millis ) {
+            boost::xtime xt;
+            boost::xtime_get(&xt, MONGO_BOOST_TIME_UTC);
+            xt.sec += millis / 1000;
+            xt.nsec += ( millis % 1000 ) * 1000000;
+            if ( xt.nsec >= 1000000000 ) {
+                xt.nsec -= 1000000000;
+                xt.sec += 1;
+            }
+
+            scoped_lock mylk(_mutex);
+            while ( _updateGen == lastGen ) {
+                if ( ! _threadsWaitingForReplication.timed_wait( mylk.boost() , xt ) )
+                    break;
+            }
+            return _updateGen;
+        }
+
         // need to be careful not to deadlock with this
         mutable mongo::mutex _mutex;
         boost::condition _threadsWaitingForReplication;
 
         map<Ident,OpTime> _slaves;
+        unsigned long long _updateGen; // bumped on every position advance; see progressGen()
         bool _dirty;
         bool _started;
         bool _currentlyUpdatingCache; // this is not thread safe, but ok for our purposes
@@ -358,6 +384,14 @@ namespace mongo {
         slaveTracking.reset();
     }
 
+    unsigned long long slaveProgressGen() {
+        return slaveTracking.progressGen();
+    }
+
+    unsigned long long waitForSlaveProgress( unsigned long long lastGen , unsigned millis ) {
+        return slaveTracking.waitForProgress( lastGen, millis );
+    }
+
     unsigned getSlaveCount() {
         return slaveTracking.getSlaveCount();
     }
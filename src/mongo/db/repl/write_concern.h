@@ -52,6 +52,16 @@ namespace mongo {
 
     bool waitForReplication( OpTime op , int w , int maxSecondsToWait );
 
+    /** Generation counter bumped every time any slave reports a new position.
+        Read it before checking opReplicatedEnough, then pass it to
+        waitForSlaveProgress: an update that races with the check makes the
+        wait return immediately, so no wakeup is lost. */
+    unsigned long long slaveProgressGen();
+
+    /** Blocks until a slave reports progress past lastGen, or for at most
+        millis.  @return the current generation, for the next wait. */
+    unsigned long long waitForSlaveProgress( unsigned long long lastGen , unsigned millis );
+
     std::vector<BSONObj> getHostsWrittenTo( const OpTime& op );
 
     void resetSlaveCache();
@@ -56,7 +56,9 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
+#include "mongo/util/file.h"
 #include "mongo/util/goodies.h"
+#include "mongo/util/md5.hpp"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -72,6 +74,23 @@ namespace mongo {
             return sb.str();
         }
 
+        /**
+         * Checksum of a spill-file block as stored on disk (the compressed form when
+         * compression kicked in).  Lets the reader detect a corrupted or truncated
+         * temp file up front rather than feeding garbage to the deserializers.
+         */
+        inline uint32_t blockChecksum(const char* data, size_t size) {
+            md5digest digest;
+            md5_state_t md5state;
+            md5_init(&md5state);
+            md5_append(&md5state, reinterpret_cast<const md5_byte_t*>(data), size);
+            md5_finish(&md5state, digest);
+
+            uint32_t out;
+            memcpy(&out, digest, sizeof(out));
+            return out;
+        }
+
         template<typename Data, typename Comparator>
         void compIsntSane(const Comparator& comp, const Data& lhs, const Data& rhs) {
             PRINT(typeid(comp).name());
@@ -207,10 +226,18 @@ namespace mongo {
                 const bool compressed = rawSize < 0;
                 const int32_t blockSize = std::abs(rawSize);
 
+                uint32_t expectedChecksum;
+                read(&expectedChecksum, sizeof(expectedChecksum));
+                massert(17564, "file too short?", !_done);
+
                 _buffer.reset(new char[blockSize]);
                 read(_buffer.get(), blockSize);
                 massert(16816, "file too short?", !_done);
 
+                massert(17565, str::stream() << "checksum mismatch in block of \"" << _fileName
+                                             << "\" - temp file corrupted?",
+                        blockChecksum(_buffer.get(), blockSize) == expectedChecksum);
+
                 if (!compressed) {
                     _reader.reset(new BufReader(_buffer.get(), blockSize));
                     return;
@@ -397,6 +424,7 @@ namespace mongo {
                 , _settings(settings)
                 , _opts(opts)
                 , _memUsed(0)
+                , _runFilesSynced(0)
             { verify(_opts.limit == 0); }
 
             void add(const Key& key, const Value& val) {
@@ -419,6 +447,53 @@ namespace mongo {
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
+            bool persistRunFiles(std::vector<std::string>* fileNames) {
+                spill();
+
+                // Nothing is ever appended to a finished run, so once a run
+                // has been fsynced here it stays crash-safe and doesn't need
+                // syncing again on the next call.
+                for (; _runFilesSynced < _runFileNames.size(); _runFilesSynced++) {
+                    File f;
+                    f.open(_runFileNames[_runFilesSynced].c_str());
+                    if (f.bad())
+                        return false;
+                    f.fsync();
+                    if (f.bad())
+                        return false;
+                }
+
+                fileNames->insert(fileNames->end(),
+                                  _runFileNames.begin(), _runFileNames.end());
+                return true;
+            }
+
+            bool adoptPersistedRunFiles(const std::vector<std::string>& fileNames) {
+                verify(_data.empty() && _iters.empty());
+
+                // Validate everything up front: failing below would already
+                // have armed FileDeleters for some of the files.
+                for (size_t i = 0; i < fileNames.size(); i++) {
+                    if (!boost::filesystem::exists(fileNames[i]) ||
+                        boost::filesystem::file_size(fileNames[i]) == 0) {
+                        return false;
+                    }
+                }
+
+                // Adopted runs keep their original order ahead of any new
+                // runs so the merge stays stable across a resume.
+                for (size_t i = 0; i < fileNames.size(); i++) {
+                    _iters.push_back(boost::shared_ptr<Iterator>(
+                            new FileIterator<Key, Value>(
+                                fileNames[i],
+                                _settings,
+                                boost::make_shared<FileDeleter>(fileNames[i]))));
+                    _runFileNames.push_back(fileNames[i]);
+                }
+                _runFilesSynced = _runFileNames.size(); // synced by the instance that wrote them
+                return true;
+            }
+
             // TEMP these are here for compatibility. Will be replaced with a general stats API
             int numFiles() const { return _iters.size(); }
             size_t memUsed() const { return _memUsed; }
@@ -468,6 +543,7 @@ namespace mongo {
                 }
 
                 _iters.push_back(boost::shared_ptr<Iterator>(writer.done()));
+                _runFileNames.push_back(writer.fileName());
 
                 _memUsed = 0;
             }
@@ -478,6 +554,8 @@ namespace mongo {
             size_t _memUsed;
             std::deque<Data> _data; // the "current" data
             std::vector<boost::shared_ptr<Iterator> > _iters; // data that has already been spilled
+            std::vector<std::string> _runFileNames; // files behind _iters, in order
+            size_t _runFilesSynced; // prefix of _runFileNames already fsynced
         };
 
         template <typename Key, typename Value, typename Comparator>
@@ -828,16 +906,20 @@ namespace mongo {
         snappy::Compress(_buffer.buf(), _buffer.len(), &compressed);
         verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
 
+        const char* outBuffer = _buffer.buf();
+        int32_t size = _buffer.len();
+        if (compressed.size() < size_t(_buffer.len()/10*9)) {
+            outBuffer = compressed.data();
+            size = -int32_t(compressed.size()); // negative means compressed
+        }
+
+        // checksummed over the bytes as stored, so the reader verifies before decompressing
+        const uint32_t checksum = sorter::blockChecksum(outBuffer, std::abs(size));
+
         try {
-            if (compressed.size() < size_t(_buffer.len()/10*9)) {
-                const int32_t size = -int32_t(compressed.size()); // negative means compressed
-                _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-                _file.write(compressed.data(), compressed.size());
-            } else {
-                const int32_t size = _buffer.len();
-                _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-                _file.write(_buffer.buf(), _buffer.len());
-            }
+            _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            _file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+            _file.write(outBuffer, std::abs(size));
         } catch (const std::exception&) {
             msgasserted(16821, str::stream() << "error writing to file \"" << _fileName << "\": "
                                              << sorter::myErrnoWithDescription());
@@ -171,6 +171,25 @@ namespace mongo {
         virtual void add(const Key&, const Value&) =0;
         virtual Iterator* done() =0; /// Can't add more data after calling done()
 
+        /**
+         * Flushes any buffered data to a sorted run file and fsyncs every run
+         * file written so far, so the runs named in 'fileNames' survive a
+         * crash.  Appends those names to 'fileNames'.  The sorter remains
+         * usable; later add()s go to new run files.  Returns false if this
+         * sorter cannot persist its state (limit-based sorters).
+         */
+        virtual bool persistRunFiles(std::vector<std::string>* fileNames) { return false; }
+
+        /**
+         * Seeds this sorter with run files persisted by an earlier instance
+         * via persistRunFiles().  Must be called before the first add().
+         * Returns false, leaving the sorter empty, if unsupported or if any
+         * file is missing or empty.
+         */
+        virtual bool adoptPersistedRunFiles(const std::vector<std::string>& fileNames) {
+            return false;
+        }
+
         virtual ~Sorter() {}
 
         // TEMP these are here for compatibility. Will be replaced with a general stats API
@@ -197,6 +216,8 @@ namespace mongo {
         void addAlreadySorted(const Key&, const Value&);
         Iterator* done(); /// Can't add more data after calling done()
 
+        const std::string& fileName() const { return _fileName; }
+
     private:
         void spill();
 
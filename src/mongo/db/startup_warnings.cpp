@@ -33,6 +33,7 @@
 
 #include "mongo/db/storage_options.h"
 #include "mongo/util/log.h"
+#include "mongo/util/numa.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/version.h"
 
@@ -96,7 +97,7 @@ namespace mongo {
                   << "Failed to probe \"" << e.path1().string() << "\": " << e.code().message()
                   << startupWarningsLog;
         }
-        if (hasMultipleNumaNodes) {
+        if (hasMultipleNumaNodes && !numaInterleaveApplied()) {
             // We are on a box with a NUMA enabled kernel and more than 1 numa node (they start at
             // node0)
             // Now we look at the first line of /proc/self/numa_maps
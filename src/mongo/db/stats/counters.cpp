@@ -60,8 +60,10 @@ namespace mongo {
     }
 
     void OpCounters::_checkWrap() {
-        const unsigned MAX = 1 << 30;
-        
+        const long long MAX = 1 << 30;
+
+        // some downstream consumers (snmp, older drivers) want values that fit in a signed
+        // 32 bit int, so we still periodically wrap back to zero
         bool wrap =
             _insert.get() > MAX ||
             _query.get() > MAX ||
@@ -69,7 +71,7 @@ namespace mongo {
             _delete.get() > MAX ||
             _getmore.get() > MAX ||
             _command.get() > MAX;
-        
+
         if ( wrap ) {
             _insert.zero();
             _query.zero();
@@ -82,44 +84,26 @@ namespace mongo {
 
     BSONObj OpCounters::getObj() const {
         BSONObjBuilder b;
-        b.append( "insert" , _insert.get() );
-        b.append( "query" , _query.get() );
-        b.append( "update" , _update.get() );
-        b.append( "delete" , _delete.get() );
-        b.append( "getmore" , _getmore.get() );
-        b.append( "command" , _command.get() );
+        b.appendNumber( "insert" , _insert.get() );
+        b.appendNumber( "query" , _query.get() );
+        b.appendNumber( "update" , _update.get() );
+        b.appendNumber( "delete" , _delete.get() );
+        b.appendNumber( "getmore" , _getmore.get() );
+        b.appendNumber( "command" , _command.get() );
         return b.obj();
     }
 
     void NetworkCounter::hit( long long bytesIn , long long bytesOut ) {
-        const long long MAX = 1ULL << 60;
-
-        // don't care about the race as its just a counter
-        bool overflow = _bytesIn > MAX || _bytesOut > MAX;
-
-        if ( overflow ) {
-            _lock.lock();
-            _overflows++;
-            _bytesIn = bytesIn;
-            _bytesOut = bytesOut;
-            _requests = 1;
-            _lock.unlock();
-        }
-        else {
-            _lock.lock();
-            _bytesIn += bytesIn;
-            _bytesOut += bytesOut;
-            _requests++;
-            _lock.unlock();
-        }
+        // striped counters: no shared cache line, no lock
+        _bytesIn.increment( bytesIn );
+        _bytesOut.increment( bytesOut );
+        _requests.increment();
     }
 
     void NetworkCounter::append( BSONObjBuilder& b ) {
-        _lock.lock();
-        b.appendNumber( "bytesIn" , _bytesIn );
-        b.appendNumber( "bytesOut" , _bytesOut );
-        b.appendNumber( "numRequests" , _requests );
-        _lock.unlock();
+        b.appendNumber( "bytesIn" , _bytesIn.get() );
+        b.appendNumber( "bytesOut" , _bytesOut.get() );
+        b.appendNumber( "numRequests" , _requests.get() );
     }
 
 
@@ -33,51 +33,49 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/processinfo.h"
-#include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/striped_counter.h"
 #include "mongo/db/pdfile.h"
 
 namespace mongo {
 
     /**
-     * for storing operation counters
-     * note: not thread safe.  ok with that for speed
+     * for storing operation counters.  counting is striped per core so the hot
+     * path never contends on a shared cache line; reads sum the stripes.
      */
     class OpCounters {
     public:
 
         OpCounters();
-        void incInsertInWriteLock(int n) { _insert.x += n; }
-        void gotInsert() { _insert++; }
-        void gotQuery() { _query++; }
-        void gotUpdate() { _update++; }
-        void gotDelete() { _delete++; }
-        void gotGetMore() { _getmore++; }
-        void gotCommand() { _command++; }
+        void incInsertInWriteLock(int n) { _insert.increment(n); }
+        void gotInsert() { _insert.increment(); }
+        void gotQuery() { _query.increment(); }
+        void gotUpdate() { _update.increment(); }
+        void gotDelete() { _delete.increment(); }
+        void gotGetMore() { _getmore.increment(); }
+        void gotCommand() { _command.increment(); }
 
         void gotOp( int op , bool isCommand );
 
         BSONObj getObj() const;
-        
+
         // thse are used by snmp, and other things, do not remove
-        const AtomicUInt * getInsert() const { return &_insert; }
-        const AtomicUInt * getQuery() const { return &_query; }
-        const AtomicUInt * getUpdate() const { return &_update; }
-        const AtomicUInt * getDelete() const { return &_delete; }
-        const AtomicUInt * getGetMore() const { return &_getmore; }
-        const AtomicUInt * getCommand() const { return &_command; }
+        const StripedCounter64 * getInsert() const { return &_insert; }
+        const StripedCounter64 * getQuery() const { return &_query; }
+        const StripedCounter64 * getUpdate() const { return &_update; }
+        const StripedCounter64 * getDelete() const { return &_delete; }
+        const StripedCounter64 * getGetMore() const { return &_getmore; }
+        const StripedCounter64 * getCommand() const { return &_command; }
 
 
     private:
         void _checkWrap();
-        
-        // todo: there will be a lot of cache line contention on these.  need to do something 
-        //       else eventually.
-        AtomicUInt _insert;
-        AtomicUInt _query;
-        AtomicUInt _update;
-        AtomicUInt _delete;
-        AtomicUInt _getmore;
-        AtomicUInt _command;
+
+        StripedCounter64 _insert;
+        StripedCounter64 _query;
+        StripedCounter64 _update;
+        StripedCounter64 _delete;
+        StripedCounter64 _getmore;
+        StripedCounter64 _command;
     };
 
     extern OpCounters globalOpCounters;
@@ -85,17 +83,13 @@ namespace mongo {
 
     class NetworkCounter {
     public:
-        NetworkCounter() : _bytesIn(0), _bytesOut(0), _requests(0), _overflows(0) {}
+        NetworkCounter() {}
         void hit( long long bytesIn , long long bytesOut );
         void append( BSONObjBuilder& b );
     private:
-        long long _bytesIn;
-        long long _bytesOut;
-        long long _requests;
-
-        long long _overflows;
-
-        SpinLock _lock;
+        StripedCounter64 _bytesIn;
+        StripedCounter64 _bytesOut;
+        StripedCounter64 _requests;
     };
 
     extern NetworkCounter networkCounter;
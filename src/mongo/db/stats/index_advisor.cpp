@@ -0,0 +1,298 @@
+// index_advisor.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/index_advisor.h"
+
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/authorization_manager.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/stats/query_shape_profiler.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    namespace {
+
+        /** Operators an ordinary btree index cannot serve at all. */
+        bool isUnindexableOperator( const char* op ) {
+            return str::equals( op, "$where" ) || str::equals( op, "$text" ) ||
+                   str::equals( op, "$near" ) || str::equals( op, "$nearSphere" ) ||
+                   str::equals( op, "$geoWithin" ) || str::equals( op, "$geoIntersects" ) ||
+                   str::equals( op, "$geoNear" ) || str::equals( op, "$within" );
+        }
+
+        /**
+         * Splits a wrapped query ({ $query: ..., $orderby: ... } or the
+         * legacy query/orderby spelling) into filter and sort; an unwrapped
+         * query is all filter.
+         */
+        void unwrapQuery( const BSONObj& raw, BSONObj* filter, BSONObj* sort ) {
+            BSONElement first = raw.firstElement();
+            if ( ( str::equals( first.fieldName(), "$query" ) ||
+                   str::equals( first.fieldName(), "query" ) ) && first.isABSONObj() ) {
+                *filter = first.Obj();
+                BSONElement order = raw["$orderby"];
+                if ( order.eoo() )
+                    order = raw["orderby"];
+                if ( order.isABSONObj() )
+                    *sort = order.Obj();
+            }
+            else {
+                *filter = raw;
+            }
+        }
+    }
+
+    BSONObj IndexAdvisor::suggestIndex( const BSONObj& shape,
+                                        const BSONObj& sort,
+                                        std::string* whyNot ) {
+        // split the shape's top-level predicates into equality and range;
+        // field order within each class follows the shape
+        std::vector<const char*> equality;
+        std::vector<const char*> range;
+        BSONObjIterator it( shape );
+        while ( it.more() ) {
+            BSONElement e = it.next();
+            if ( e.fieldName()[0] == '$' ) {
+                // $or/$and/... need per-branch analysis; don't guess
+                *whyNot = str::stream() << "cannot advise through top-level "
+                                        << e.fieldName();
+                return BSONObj();
+            }
+            if ( e.type() == Object && e.Obj().firstElementFieldName()[0] == '$' ) {
+                const char* op = e.Obj().firstElementFieldName();
+                if ( isUnindexableOperator( op ) ) {
+                    *whyNot = str::stream() << op << " needs a special index";
+                    return BSONObj();
+                }
+                if ( str::equals( op, "$eq" ) )
+                    equality.push_back( e.fieldName() );
+                else
+                    range.push_back( e.fieldName() );
+            }
+            else {
+                // a plain value (or exact subobject match) is an equality
+                equality.push_back( e.fieldName() );
+            }
+        }
+
+        // equality fields, then the sort, then range fields
+        BSONObjBuilder key;
+        for ( size_t i = 0; i < equality.size(); i++ )
+            key.append( equality[i], 1 );
+
+        BSONObjIterator si( sort );
+        while ( si.more() ) {
+            BSONElement e = si.next();
+            if ( e.fieldName()[0] == '$' ) {
+                *whyNot = str::stream() << "cannot advise on a " << e.fieldName() << " sort";
+                return BSONObj();
+            }
+            if ( key.hasField( e.fieldName() ) )
+                continue; // sorting on an equality field is free
+            key.append( e.fieldName(), e.numberInt() >= 0 ? 1 : -1 );
+        }
+
+        for ( size_t i = 0; i < range.size(); i++ ) {
+            if ( !key.hasField( range[i] ) )
+                key.append( range[i], 1 );
+        }
+
+        BSONObj pattern = key.obj();
+        if ( pattern.isEmpty() ) {
+            *whyNot = "no indexable predicates or sort";
+            return BSONObj();
+        }
+        if ( pattern.nFields() == 1 && str::equals( pattern.firstElementFieldName(), "_id" ) ) {
+            *whyNot = "_id is already indexed";
+            return BSONObj();
+        }
+        return pattern;
+    }
+
+    void IndexAdvisor::record( const CurOp& op, const OpDebug& d, bool command,
+                               long long micros ) {
+        if ( command || op.getOp() != dbQuery )
+            return;
+        if ( d.nscanned < kMinExamined )
+            return;
+
+        const bool collscan = str::startsWith( d.planSummary.toString(), "COLLSCAN" );
+        const long long returned = d.nreturned > 0 ? d.nreturned : 1;
+        if ( !collscan && d.nscanned < kMinExamineRatio * returned )
+            return;
+
+        const char* ns = op.getNS();
+        if ( !ns[0] || str::startsWith( ns, "local." ) || str::contains( ns, ".system." ) )
+            return;
+        if ( !op.haveQuery() )
+            return;
+
+        BSONObj filter;
+        BSONObj sort;
+        unwrapQuery( op.query(), &filter, &sort );
+
+        BSONObjBuilder shapeBob;
+        QueryShapeProfiler::appendShape( filter, &shapeBob );
+        BSONObj shape = shapeBob.obj();
+        if ( shape.isEmpty() && sort.isEmpty() )
+            return; // a full scan with no predicate or sort; no index to suggest
+
+        // binary key so shapes compare cheaply
+        std::string key;
+        key.reserve( strlen( ns ) + 1 + shape.objsize() + sort.objsize() );
+        key.append( ns );
+        key.push_back( '\0' );
+        key.append( shape.objdata(), shape.objsize() );
+        key.append( sort.objdata(), sort.objsize() );
+
+        SimpleMutex::scoped_lock lk( _lock );
+        std::map<std::string, Entry>::iterator i = _entries.find( key );
+        if ( i == _entries.end() ) {
+            if ( _entries.size() >= kMaxShapes )
+                return; // full; existing shapes keep aggregating
+            Entry& fresh = _entries[key];
+            fresh.ns = ns;
+            fresh.shape = shape.getOwned();
+            fresh.sort = sort.getOwned();
+            i = _entries.find( key );
+        }
+        Entry& entry = i->second;
+        entry.count++;
+        if ( collscan )
+            entry.collscans++;
+        entry.scanned += d.nscanned;
+        entry.scannedObjects += d.nscannedObjects;
+        entry.returned += d.nreturned;
+        entry.totalMicros += micros;
+        entry.lastSeen = time( 0 );
+    }
+
+    void IndexAdvisor::append( BSONObjBuilder* builder ) const {
+        std::vector<Entry> entries;
+        {
+            SimpleMutex::scoped_lock lk( _lock );
+            for ( std::map<std::string, Entry>::const_iterator i = _entries.begin();
+                  i != _entries.end(); ++i )
+                entries.push_back( i->second );
+        }
+
+        // most documents examined first
+        std::vector< std::pair<long long, size_t> > order;
+        for ( size_t i = 0; i < entries.size(); i++ )
+            order.push_back( std::make_pair( -entries[i].scanned, i ) );
+        std::sort( order.begin(), order.end() );
+
+        const time_t now = time( 0 );
+        BSONArrayBuilder arr( builder->subarrayStart( "candidates" ) );
+        for ( size_t i = 0; i < order.size(); i++ ) {
+            const Entry& entry = entries[order[i].second];
+
+            BSONObjBuilder bb( arr.subobjStart() );
+            bb.append( "ns", entry.ns );
+            bb.append( "shape", entry.shape );
+            if ( !entry.sort.isEmpty() )
+                bb.append( "sort", entry.sort );
+
+            string whyNot;
+            BSONObj suggestion = suggestIndex( entry.shape, entry.sort, &whyNot );
+            if ( !suggestion.isEmpty() )
+                bb.append( "suggestedIndex", suggestion );
+            else
+                bb.append( "noSuggestionReason", whyNot );
+
+            bb.appendNumber( "count", entry.count );
+            bb.appendNumber( "collscans", entry.collscans );
+            bb.appendNumber( "docsExamined", entry.scanned );
+            bb.appendNumber( "objsExamined", entry.scannedObjects );
+            bb.appendNumber( "docsReturned", entry.returned );
+            bb.appendNumber( "avgExamined", entry.count ? entry.scanned / entry.count : 0 );
+            bb.append( "examineRatio",
+                       static_cast<double>( entry.scanned ) /
+                       ( entry.returned > 0 ? entry.returned : 1 ) );
+            bb.appendNumber( "totalMicros", entry.totalMicros );
+            bb.appendNumber( "lastSeenSecondsAgo",
+                             static_cast<long long>( now - entry.lastSeen ) );
+            bb.done();
+        }
+        arr.done();
+
+        builder->appendNumber( "minExamined", kMinExamined );
+        builder->appendNumber( "minExamineRatio", kMinExamineRatio );
+    }
+
+    void IndexAdvisor::collectionDropped( const StringData& ns ) {
+        SimpleMutex::scoped_lock lk( _lock );
+        std::map<std::string, Entry>::iterator i = _entries.begin();
+        while ( i != _entries.end() ) {
+            if ( ns == i->second.ns )
+                _entries.erase( i++ );
+            else
+                ++i;
+        }
+    }
+
+    IndexAdvisor IndexAdvisor::global;
+
+    class IndexAdvisorCmd : public Command {
+    public:
+        IndexAdvisorCmd() : Command( "indexAdvisor", true ) {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream& help ) const {
+            help << "query shapes that ran as collection scans or with a high "
+                    "examined/returned ratio, each with a candidate index. "
+                    "always on; see also the queryShapes command";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::top);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+        virtual bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            IndexAdvisor::global.append( &result );
+            return true;
+        }
+
+    } indexAdvisorCmd;
+
+}  // namespace mongo
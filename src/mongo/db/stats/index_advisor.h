@@ -0,0 +1,114 @@
+// index_advisor.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class CurOp;
+    class OpDebug;
+
+    /**
+     * Registry of query shapes that ran without useful index support.  Fed
+     * from operation completion: a query whose winning plan was a collection
+     * scan, or that examined far more documents than it returned, has its
+     * shape (constants stripped, like the queryShapes profiler) and its
+     * examined/returned counts aggregated here.  Well-indexed queries never
+     * enter the registry, so the common case pays two integer compares.
+     *
+     * The { indexAdvisor: 1 } command reports the offending shapes, most
+     * documents examined first, each with a candidate index synthesized from
+     * the shape's predicates and sort: equality fields, then sort fields,
+     * then range fields.
+     */
+    class IndexAdvisor {
+    public:
+        // a query must examine at least this many documents to be recorded
+        static const long long kMinExamined = 100;
+
+        // ...and examine at least this many times more documents than it
+        // returned (collection scans are recorded regardless of ratio)
+        static const long long kMinExamineRatio = 10;
+
+        // once this many distinct shapes are held, new ones are dropped
+        static const size_t kMaxShapes = 200;
+
+        IndexAdvisor() : _lock( "IndexAdvisor" ) {}
+
+        /** Called at operation completion; no-op for efficient queries. */
+        void record( const CurOp& op, const OpDebug& debug, bool command, long long micros );
+
+        /** Reports aggregated shapes, most documents examined first. */
+        void append( BSONObjBuilder* builder ) const;
+
+        /** Forgets shapes for a dropped (or renamed-away) collection. */
+        void collectionDropped( const StringData& ns );
+
+        /**
+         * Synthesizes a candidate index key pattern for a query shape and
+         * sort: equality predicates first, then the sort fields with their
+         * directions, then range predicates.  Returns an empty object and
+         * fills in 'whyNot' when the shape cannot be advised on (top-level
+         * $-operators, geo/text predicates, only the _id field, ...).
+         */
+        static BSONObj suggestIndex( const BSONObj& shape,
+                                     const BSONObj& sort,
+                                     std::string* whyNot );
+
+        static IndexAdvisor global;
+
+    private:
+        struct Entry {
+            Entry() : count( 0 ), collscans( 0 ), scanned( 0 ), scannedObjects( 0 ),
+                      returned( 0 ), totalMicros( 0 ), lastSeen( 0 ) {}
+            std::string ns;
+            BSONObj shape;
+            BSONObj sort;
+            long long count;
+            long long collscans;
+            long long scanned;
+            long long scannedObjects;
+            long long returned;
+            long long totalMicros;
+            time_t lastSeen;
+        };
+
+        // all access is under _lock; only inefficient queries ever get here
+        mutable SimpleMutex _lock;
+        std::map<std::string, Entry> _entries; // ns + shape + sort -> stats
+    };
+
+}  // namespace mongo
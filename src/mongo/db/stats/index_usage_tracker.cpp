@@ -0,0 +1,155 @@
+// index_usage_tracker.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/index_usage_tracker.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/net/listen.h"
+
+namespace mongo {
+
+    /**
+     * Per-thread buffer of index accesses not yet folded into the shared
+     * counters.  Kept small and flushed on volume or age so serverStatus is
+     * never far behind.
+     */
+    struct IndexUsageBuffer {
+        IndexUsageBuffer() : pending( 0 ), lastFlushMillis( 0 ) {}
+        StringMap<long long> counts;
+        int pending;
+        long long lastFlushMillis;
+    };
+
+    TSP_DECLARE(IndexUsageBuffer, tlIndexUsage)
+    TSP_DEFINE(IndexUsageBuffer, tlIndexUsage)
+
+    namespace {
+        const int kFlushEveryAccesses = 64;
+        const long long kFlushIntervalMillis = 1000;
+    }
+
+    void IndexUsageTracker::recordAccess( const StringData& indexNs ) {
+        IndexUsageBuffer* buffer = tlIndexUsage.getMake();
+        buffer->counts[indexNs]++;
+        buffer->pending++;
+
+        // Listener's cached clock keeps the age check cheap.
+        long long now = Listener::getElapsedTimeMillis();
+        if ( buffer->pending < kFlushEveryAccesses &&
+             now - buffer->lastFlushMillis < kFlushIntervalMillis )
+            return;
+
+        _flush( buffer );
+        buffer->lastFlushMillis = now;
+    }
+
+    void IndexUsageTracker::_flush( IndexUsageBuffer* buffer ) {
+        for ( StringMap<long long>::const_iterator i = buffer->counts.begin();
+              i != buffer->counts.end(); ++i ) {
+            _entryFor( i->first )->accesses.fetchAndAdd( i->second );
+        }
+        buffer->counts.clear();
+        buffer->pending = 0;
+    }
+
+    IndexUsageTracker::UsageEntry* IndexUsageTracker::_entryFor( const StringData& indexNs ) {
+        SimpleMutex::scoped_lock lk( _mapLock );
+        UsageEntry*& entry = _byIndex[indexNs];
+        if ( !entry )
+            entry = new UsageEntry();
+        return entry;
+    }
+
+    void IndexUsageTracker::appendUsage( BSONObjBuilder* builder ) const {
+        // sort the names so the user gets a stable order, as top does
+        vector<string> names;
+        {
+            SimpleMutex::scoped_lock lk( _mapLock );
+            for ( StringMap<UsageEntry*>::const_iterator i = _byIndex.begin();
+                  i != _byIndex.end(); ++i ) {
+                names.push_back( i->first );
+            }
+        }
+        std::sort( names.begin(), names.end() );
+
+        for ( size_t i = 0; i < names.size(); i++ ) {
+            const UsageEntry* entry;
+            {
+                SimpleMutex::scoped_lock lk( _mapLock );
+                entry = _byIndex.find( names[i] )->second;
+            }
+            BSONObjBuilder bb( builder->subobjStart( names[i] ) );
+            bb.appendNumber( "ops", static_cast<long long>( entry->accesses.load() ) );
+            bb.appendDate( "since", entry->since );
+            bb.done();
+        }
+    }
+
+    void IndexUsageTracker::indexDropped( const StringData& indexNs ) {
+        // reset rather than erase: recordAccess() may hold a pointer to the entry
+        SimpleMutex::scoped_lock lk( _mapLock );
+        StringMap<UsageEntry*>::const_iterator i = _byIndex.find( indexNs );
+        if ( i != _byIndex.end() ) {
+            i->second->accesses.store( 0 );
+            i->second->since = jsTime();
+        }
+    }
+
+    IndexUsageTracker::~IndexUsageTracker() {
+        for ( StringMap<UsageEntry*>::const_iterator i = _byIndex.begin();
+              i != _byIndex.end(); ++i ) {
+            delete i->second;
+        }
+    }
+
+    IndexUsageTracker IndexUsageTracker::global;
+
+    namespace {
+
+        class IndexUsageSSS : public ServerStatusSection {
+        public:
+            IndexUsageSSS() : ServerStatusSection( "indexUsage" ) {}
+
+            // one entry per accessed index can get long; ask for it explicitly
+            virtual bool includeByDefault() const { return false; }
+
+            BSONObj generateSection( const BSONElement& configElement ) const {
+                BSONObjBuilder usageBuilder;
+                IndexUsageTracker::global.appendUsage( &usageBuilder );
+                return usageBuilder.obj();
+            }
+        } indexUsageSSS;
+
+    }
+
+}  // namespace mongo
@@ -0,0 +1,93 @@
+// index_usage_tracker.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // Per-thread write-combining buffer; defined in the .cpp.
+    struct IndexUsageBuffer;
+
+    /**
+     * Always-on accounting of which indexes queries actually use, so dead
+     * indexes can be found from production data.  One access is recorded per
+     * index scan (not per key), keyed by the index namespace
+     * ("db.coll.$name_1").
+     *
+     * Accesses accumulate in a per-thread write-combining buffer and are
+     * folded into the shared counters every few scans or milliseconds, so the
+     * recording path touches no shared cache lines and takes no locks.
+     * Reported under serverStatus({indexUsage: 1}); an index that never
+     * appears there has not been scanned since startup.
+     */
+    class IndexUsageTracker {
+    public:
+        IndexUsageTracker() : _mapLock( "IndexUsageTracker" ) {}
+        ~IndexUsageTracker();
+
+        /** Records one scan of the given index in this thread's buffer. */
+        void recordAccess( const StringData& indexNs );
+
+        /**
+         * Appends { "<indexNs>": { ops: N, since: Date }, ... } for every
+         * index accessed since startup, sorted by namespace.  Buffered
+         * counts not yet flushed by their threads are not included.
+         */
+        void appendUsage( BSONObjBuilder* builder ) const;
+
+        /** Zeroes the counter for a dropped index so a recreated one starts fresh. */
+        void indexDropped( const StringData& indexNs );
+
+        static IndexUsageTracker global;
+
+    private:
+        struct UsageEntry {
+            UsageEntry() : accesses( 0 ), since( jsTime() ) {}
+            AtomicInt64 accesses;
+            Date_t since; // when tracking of this index began (or was reset)
+        };
+
+        UsageEntry* _entryFor( const StringData& indexNs );
+        void _flush( IndexUsageBuffer* buffer );
+
+        // Guards the map only.  Entries are never deleted (a dropped index's
+        // counter is reset instead) so pointers stay valid for lock free
+        // recording, as in LatencyStats.
+        mutable SimpleMutex _mapLock;
+        StringMap<UsageEntry*> _byIndex;
+    };
+
+}  // namespace mongo
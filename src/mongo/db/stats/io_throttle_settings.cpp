@@ -0,0 +1,105 @@
+// io_throttle_settings.cpp : server parameters and serverStatus for IoThrottle
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/io_throttle.h"
+
+namespace mongo {
+
+    namespace {
+
+        /**
+         * One setParameter per I/O class, forwarding to IoThrottle::global
+         * so changes take effect on the next request():
+         * ioThrottleJournalBytesPerSec, ioThrottleFlushBytesPerSec,
+         * ioThrottleMaintenanceBytesPerSec.  0 (the default) disables
+         * throttling for the class.
+         */
+        class IoThrottleLimitSetting : public ServerParameter {
+        public:
+            IoThrottleLimitSetting( const string& name, IoThrottle::IoClass ioClass )
+                : ServerParameter( ServerParameterSet::getGlobal(), name ),
+                  _ioClass( ioClass ) {
+            }
+
+            virtual void append( BSONObjBuilder& b, const string& name ) {
+                b.appendNumber( name, IoThrottle::global.bytesPerSec( _ioClass ) );
+            }
+
+            virtual Status set( const BSONElement& newValueElement ) {
+                if ( !newValueElement.isNumber() ) {
+                    return Status( ErrorCodes::BadValue,
+                                   str::stream() << name() << " has to be a number" );
+                }
+
+                const long long v = newValueElement.numberLong();
+                if ( v < 0 ) {
+                    return Status( ErrorCodes::BadValue,
+                                   str::stream() << name()
+                                                 << " has to be >= 0 (0 disables the limit)" );
+                }
+
+                IoThrottle::global.setBytesPerSec( _ioClass, v );
+                return Status::OK();
+            }
+
+            virtual Status setFromString( const string& str ) {
+                return set( BSON( "" << atoll( str.c_str() ) ).firstElement() );
+            }
+
+        private:
+            const IoThrottle::IoClass _ioClass;
+        };
+
+        IoThrottleLimitSetting ioThrottleJournalSetting(
+                "ioThrottleJournalBytesPerSec", IoThrottle::Journal );
+        IoThrottleLimitSetting ioThrottleFlushSetting(
+                "ioThrottleFlushBytesPerSec", IoThrottle::Flush );
+        IoThrottleLimitSetting ioThrottleMaintenanceSetting(
+                "ioThrottleMaintenanceBytesPerSec", IoThrottle::Maintenance );
+
+        class IoThrottleSSS : public ServerStatusSection {
+        public:
+            IoThrottleSSS() : ServerStatusSection( "ioThrottle" ) {}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection( const BSONElement& configElement ) const {
+                BSONObjBuilder b;
+                IoThrottle::global.appendStats( b );
+                return b.obj();
+            }
+        } ioThrottleSSS;
+
+    }
+
+}  // namespace mongo
@@ -0,0 +1,172 @@
+// metrics_stream.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/metrics_stream.h"
+
+#include "mongo/db/client.h"
+#include "mongo/db/dur_stats.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/top.h"
+#include "mongo/db/storage_options.h"
+
+namespace mongo {
+
+    // How often a sample is pushed, in milliseconds.  0 (the default) disables the
+    // stream; can be flipped at runtime with setParameter.
+    MONGO_EXPORT_SERVER_PARAMETER( metricsStreamIntervalMs, int, 0 );
+
+    namespace {
+
+        const char* const metricsStreamNS = "local.system.metricsStream";
+        const long long metricsStreamSizeBytes = 4 * 1024 * 1024;
+
+        /** point-in-time copy of the counters we stream; deltas are taken between two */
+        struct MetricsSample {
+            unsigned long long micros;
+
+            long long insert;
+            long long query;
+            long long update;
+            long long remove;
+            long long getmore;
+            long long command;
+
+            long long readLockMicros;
+            long long writeLockMicros;
+
+            void take() {
+                micros = curTimeMicros64();
+
+                insert = globalOpCounters.getInsert()->get();
+                query = globalOpCounters.getQuery()->get();
+                update = globalOpCounters.getUpdate()->get();
+                remove = globalOpCounters.getDelete()->get();
+                getmore = globalOpCounters.getGetMore()->get();
+                command = globalOpCounters.getCommand()->get();
+
+                Top::CollectionData global = Top::global.getGlobalData();
+                readLockMicros = global.readLock.time;
+                writeLockMicros = global.writeLock.time;
+            }
+        };
+
+        BSONObj makeSampleDoc( const MetricsSample& older, const MetricsSample& newer ) {
+            BSONObjBuilder b;
+            b.appendOID( "_id", NULL, true /* generate */ );
+            b.appendDate( "ts", jsTime() );
+            b.append( "ms", static_cast<int>( ( newer.micros - older.micros ) / 1000 ) );
+
+            {
+                BSONObjBuilder op( b.subobjStart( "op" ) );
+                op.append( "insert", newer.insert - older.insert );
+                op.append( "query", newer.query - older.query );
+                op.append( "update", newer.update - older.update );
+                op.append( "delete", newer.remove - older.remove );
+                op.append( "getmore", newer.getmore - older.getmore );
+                op.append( "command", newer.command - older.command );
+                op.doneFast();
+            }
+
+            {
+                BSONObjBuilder lock( b.subobjStart( "lockMicros" ) );
+                lock.append( "r", newer.readLockMicros - older.readLockMicros );
+                lock.append( "w", newer.writeLockMicros - older.writeLockMicros );
+                lock.doneFast();
+            }
+
+            if ( storageGlobalParams.dur ) {
+                // dur::stats.curr is already an interval accumulator maintained by the
+                // journal thread, so these are within-interval values, not lifetime totals
+                BSONObjBuilder d( b.subobjStart( "dur" ) );
+                d.append( "commits", static_cast<int>( dur::stats.curr->_commits ) );
+                d.append( "journaledBytes",
+                          static_cast<long long>( dur::stats.curr->_journaledBytes ) );
+                d.append( "writeToDataFilesBytes",
+                          static_cast<long long>( dur::stats.curr->_writeToDataFilesBytes ) );
+                d.doneFast();
+            }
+
+            return b.obj();
+        }
+    }
+
+    void MetricsStreamThread::run() {
+        Client::initThread( "metricsStream" );
+
+        bool createdCollection = false;
+        MetricsSample prev;
+        bool havePrev = false;
+
+        while ( !inShutdown() ) {
+            const int intervalMs = metricsStreamIntervalMs;
+            if ( intervalMs <= 0 ) {
+                // disabled.  drop the previous sample so the first delta after a
+                // re-enable doesn't span the dark period.
+                havePrev = false;
+                sleepsecs( 1 );
+                continue;
+            }
+            sleepmillis( intervalMs );
+
+            try {
+                MetricsSample curr;
+                curr.take();
+
+                if ( havePrev ) {
+                    BSONObj doc = makeSampleDoc( prev, curr );
+
+                    DBDirectClient c;
+                    if ( !createdCollection ) {
+                        // a no-op if it already exists from a previous run
+                        c.createCollection( metricsStreamNS, metricsStreamSizeBytes, true );
+                        createdCollection = true;
+                    }
+                    c.insert( metricsStreamNS, doc );
+                }
+
+                prev = curr;
+                havePrev = true;
+            }
+            catch ( const std::exception& e ) {
+                log() << "ERROR in MetricsStreamThread: " << e.what() << endl;
+                havePrev = false;
+            }
+        }
+
+        cc().shutdown();
+    }
+
+    MetricsStreamThread metricsStreamThread;
+
+}  // namespace mongo
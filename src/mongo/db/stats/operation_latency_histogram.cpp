@@ -0,0 +1,216 @@
+// operation_latency_histogram.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/operation_latency_histogram.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    namespace {
+
+        const char* categoryName( int category ) {
+            switch ( category ) {
+            case OperationLatencyHistogram::OpRead: return "reads";
+            case OperationLatencyHistogram::OpWrite: return "writes";
+            default: return "commands";
+            }
+        }
+    }
+
+    void OperationLatencyHistogram::increment( Category category,
+                                               unsigned long long latencyMicros ) {
+        CategoryData& data = _data[category];
+        data.sketch.record( static_cast<double>( latencyMicros ) );
+        data.entryCount.fetchAndAdd( 1 );
+        data.sum.fetchAndAdd( latencyMicros );
+    }
+
+    void OperationLatencyHistogram::append( bool includeHistograms,
+                                            BSONObjBuilder* builder ) const {
+        for ( int c = 0; c < NumCategories; c++ ) {
+            const CategoryData& data = _data[c];
+            BSONObjBuilder cb( builder->subobjStart( categoryName( c ) ) );
+
+            if ( includeHistograms ) {
+                BSONArrayBuilder ab( cb.subarrayStart( "histogram" ) );
+                for ( int i = 0; i < data.sketch.numBuckets(); i++ ) {
+                    long long count = data.sketch.bucketCount( i );
+                    if ( count == 0 )
+                        continue;
+                    BSONObjBuilder bb( ab.subobjStart() );
+                    bb.appendNumber( "micros",
+                                     static_cast<long long>( data.sketch.bucketLowerBound( i ) ) );
+                    bb.appendNumber( "count", count );
+                    bb.done();
+                }
+                ab.done();
+
+                if ( data.sketch.count() ) {
+                    // coarse (within a factor of two, like the buckets), but
+                    // saves the caller re-deriving them from the histogram
+                    cb.append( "p50", data.sketch.quantile( 0.50 ) );
+                    cb.append( "p95", data.sketch.quantile( 0.95 ) );
+                    cb.append( "p99", data.sketch.quantile( 0.99 ) );
+                }
+            }
+
+            cb.appendNumber( "latency", static_cast<long long>( data.sum.load() ) );
+            cb.appendNumber( "ops", static_cast<long long>( data.entryCount.load() ) );
+            cb.done();
+        }
+    }
+
+    void OperationLatencyHistogram::reset() {
+        for ( int c = 0; c < NumCategories; c++ ) {
+            CategoryData& data = _data[c];
+            data.sketch.reset();
+            data.entryCount.store( 0 );
+            data.sum.store( 0 );
+        }
+    }
+
+    LatencyStats::~LatencyStats() {
+        for ( StringMap<OperationLatencyHistogram*>::const_iterator i = _byNamespace.begin();
+              i != _byNamespace.end(); ++i ) {
+            delete i->second;
+        }
+    }
+
+    void LatencyStats::record( const StringData& ns, int op, bool command,
+                               long long micros ) {
+        if ( ns.size() && ns[0] == '?' )
+            return;
+
+        OperationLatencyHistogram::Category category;
+        switch ( op ) {
+        case dbQuery:
+            category = command ? OperationLatencyHistogram::OpCommand
+                               : OperationLatencyHistogram::OpRead;
+            break;
+        case dbGetMore:
+            category = OperationLatencyHistogram::OpRead;
+            break;
+        case dbInsert:
+        case dbUpdate:
+        case dbDelete:
+            category = OperationLatencyHistogram::OpWrite;
+            break;
+        default:
+            // 0 (unknown), killcursors, ... don't have a meaningful category
+            return;
+        }
+
+        _globalHistogram.increment( category, micros );
+        if ( ns.size() )
+            _histogramFor( ns )->increment( category, micros );
+    }
+
+    OperationLatencyHistogram* LatencyStats::_histogramFor( const StringData& ns ) {
+        SimpleMutex::scoped_lock lk( _mapLock );
+        OperationLatencyHistogram*& histogram = _byNamespace[ns];
+        if ( !histogram )
+            histogram = new OperationLatencyHistogram();
+        return histogram;
+    }
+
+    void LatencyStats::append( bool includeHistograms, bool includeCollections,
+                               BSONObjBuilder* builder ) const {
+        _globalHistogram.append( includeHistograms, builder );
+
+        if ( !includeCollections )
+            return;
+
+        BSONObjBuilder collections( builder->subobjStart( "collections" ) );
+
+        // sort the names so the user gets a stable order, as top does
+        vector<string> names;
+        {
+            SimpleMutex::scoped_lock lk( _mapLock );
+            for ( StringMap<OperationLatencyHistogram*>::const_iterator i = _byNamespace.begin();
+                  i != _byNamespace.end(); ++i ) {
+                names.push_back( i->first );
+            }
+        }
+        std::sort( names.begin(), names.end() );
+
+        for ( size_t i = 0; i < names.size(); i++ ) {
+            const OperationLatencyHistogram* histogram;
+            {
+                SimpleMutex::scoped_lock lk( _mapLock );
+                histogram = _byNamespace.find( names[i] )->second;
+            }
+            BSONObjBuilder bb( collections.subobjStart( names[i] ) );
+            histogram->append( includeHistograms, &bb );
+            bb.done();
+        }
+
+        collections.done();
+    }
+
+    void LatencyStats::collectionDropped( const StringData& ns ) {
+        // reset rather than erase: record() may hold a pointer to the entry
+        SimpleMutex::scoped_lock lk( _mapLock );
+        StringMap<OperationLatencyHistogram*>::const_iterator i = _byNamespace.find( ns );
+        if ( i != _byNamespace.end() )
+            i->second->reset();
+    }
+
+    LatencyStats LatencyStats::global;
+
+    namespace {
+
+        class OpLatenciesSSS : public ServerStatusSection {
+        public:
+            OpLatenciesSSS() : ServerStatusSection( "opLatencies" ) {}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection( const BSONElement& configElement ) const {
+                bool includeHistograms = false;
+                bool includeCollections = false;
+                if ( configElement.isABSONObj() ) {
+                    BSONObj config = configElement.Obj();
+                    includeHistograms = config["histograms"].trueValue();
+                    includeCollections = config["collections"].trueValue();
+                }
+
+                BSONObjBuilder latencyBuilder;
+                LatencyStats::global.append( includeHistograms, includeCollections,
+                                             &latencyBuilder );
+                return latencyBuilder.obj();
+            }
+        } opLatenciesSSS;
+
+    }
+
+}  // namespace mongo
@@ -0,0 +1,127 @@
+// operation_latency_histogram.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/quantile_sketch.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    /**
+     * Latency distribution for reads, writes and commands, in log-spaced
+     * buckets: bucket i counts operations that took [2^i, 2^(i+1))
+     * microseconds, except bucket 0 which starts at 0.  Recording is an
+     * atomic increment per operation - no locks - so histograms can be
+     * updated on every operation and read at any time.
+     */
+    class OperationLatencyHistogram {
+    public:
+        enum Category {
+            OpRead = 0,
+            OpWrite,
+            OpCommand,
+
+            NumCategories
+        };
+
+        // 2^31 usecs ~ 36 minutes in the top bucket
+        static const int NumBuckets = 32;
+
+        void increment( Category category, unsigned long long latencyMicros );
+
+        /**
+         * Appends { reads: {...}, writes: {...}, commands: {...} }, each with
+         * total latency and operation count, plus the non-empty buckets as
+         * { micros: <lower bound>, count: N } and p50/p95/p99 estimates when
+         * 'includeHistograms'.
+         */
+        void append( bool includeHistograms, BSONObjBuilder* builder ) const;
+
+        /** Zeroes all counters (e.g. when a collection goes away). */
+        void reset();
+
+    private:
+        struct CategoryData {
+            // base-2 sketch reproduces the original power-of-two buckets
+            CategoryData() : sketch( 2.0, NumBuckets ) {}
+
+            QuantileSketch sketch;
+            AtomicUInt64 entryCount;
+            AtomicUInt64 sum; // micros
+        };
+
+        CategoryData _data[NumCategories];
+    };
+
+    /**
+     * Operation latency histograms for the whole server and per namespace,
+     * recorded when a CurOp completes, alongside Top.  The per-namespace map
+     * is guarded by a mutex but only for locating the histogram; the counts
+     * themselves are incremented lock free.
+     */
+    class LatencyStats {
+    public:
+        LatencyStats() : _mapLock( "LatencyStats" ) {}
+        ~LatencyStats();
+
+        /**
+         * @param op     message op (dbQuery, dbUpdate, ...), as in Top::record
+         * @param micros how long the operation took
+         */
+        void record( const StringData& ns, int op, bool command, long long micros );
+
+        /**
+         * Appends the server-wide histograms, and each namespace's under a
+         * 'collections' subobject when 'includeCollections'.
+         */
+        void append( bool includeHistograms, bool includeCollections,
+                     BSONObjBuilder* builder ) const;
+
+        void collectionDropped( const StringData& ns );
+
+        static LatencyStats global;
+
+    private:
+        OperationLatencyHistogram* _histogramFor( const StringData& ns );
+
+        OperationLatencyHistogram _globalHistogram;
+
+        // Guards the map only.  Entries are never deleted (a dropped
+        // collection's histogram is reset instead) so pointers handed out
+        // stay valid for lock free recording.
+        mutable SimpleMutex _mapLock;
+        StringMap<OperationLatencyHistogram*> _byNamespace;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,229 @@
+// query_shape_profiler.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/query_shape_profiler.h"
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/authorization_manager.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/curop.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    namespace {
+
+        // shapes nested deeper than this are cut off with a 1
+        const int kMaxShapeDepth = 5;
+
+        // once this many distinct shapes have been seen, new ones are dropped
+        const size_t kMaxShapes = 1000;
+
+        unsigned long long fnv1a( unsigned long long h, const char* data, size_t len ) {
+            for ( size_t i = 0; i < len; i++ ) {
+                h ^= static_cast<unsigned char>( data[i] );
+                h *= 1099511628211ULL;
+            }
+            return h;
+        }
+
+        struct Agg {
+            Agg() : count( 0 ), totalMicros( 0 ), maxMicros( 0 ), lockWaitMicros( 0 ),
+                    memPeakBytes( 0 ) {}
+            long long count;
+            long long totalMicros;
+            long long maxMicros;
+            long long lockWaitMicros;
+            long long memPeakBytes;
+        };
+    }
+
+    void QueryShapeProfiler::appendShape( const BSONObj& obj, BSONObjBuilder* out, int depth ) {
+        BSONObjIterator it( obj );
+        while ( it.more() ) {
+            BSONElement e = it.next();
+            if ( e.type() == Object && depth < kMaxShapeDepth ) {
+                BSONObjBuilder sub( out->subobjStart( e.fieldNameStringData() ) );
+                appendShape( e.Obj(), &sub, depth + 1 );
+                sub.done();
+            }
+            else if ( e.type() == Array && e.fieldName()[0] == '$' &&
+                      depth < kMaxShapeDepth ) {
+                BSONObjBuilder sub( out->subarrayStart( e.fieldNameStringData() ) );
+                appendShape( e.Obj(), &sub, depth + 1 );
+                sub.done();
+            }
+            else {
+                out->append( e.fieldNameStringData(), 1 );
+            }
+        }
+    }
+
+    void QueryShapeProfiler::record( const CurOp& op, bool command, long long micros ) {
+        const unsigned long long n = _ops.fetchAndAdd( 1 );
+        if ( n % kSampleEvery )
+            return;
+
+        const char* ns = op.getNS();
+        if ( !ns[0] || ns[0] == '?' )
+            return;
+
+        const char* opType = command ? "command" : opToString( op.getOp() );
+
+        BSONObjBuilder shapeBob;
+        if ( op.haveQuery() )
+            appendShape( op.query(), &shapeBob, 0 );
+        BSONObj shape = shapeBob.obj();
+
+        unsigned long long h = 14695981039346656037ULL;
+        h = fnv1a( h, ns, strlen( ns ) );
+        h = fnv1a( h, opType, strlen( opType ) );
+        h = fnv1a( h, shape.objdata(), shape.objsize() );
+        if ( h == 0 )
+            h = 1; // 0 marks an empty ring slot
+
+        const LockStat& ls = op.lockStat();
+        const long long lockWait =
+            ls.getTimeAcquiring( 'R' ) + ls.getTimeAcquiring( 'W' ) +
+            ls.getTimeAcquiring( 'r' ) + ls.getTimeAcquiring( 'w' );
+
+        Sample& s = _samples[_sampled.fetchAndAdd( 1 ) % kNumSamples];
+        s.micros.store( micros );
+        s.lockWaitMicros.store( lockWait );
+        s.memPeakBytes.store( op.memPeakAccounted() );
+        s.shapeHash.store( h );
+
+        SimpleMutex::scoped_lock lk( _shapesLock );
+        if ( _shapes.count( h ) )
+            return;
+        if ( _shapes.size() >= kMaxShapes )
+            return; // full; the sample stays but won't be attributable
+        ShapeInfo& info = _shapes[h];
+        info.ns = ns;
+        info.opType = opType;
+        info.shape = shape.getOwned();
+    }
+
+    void QueryShapeProfiler::append( BSONObjBuilder* builder ) const {
+        const unsigned long long handedOut = _sampled.load();
+        const int filled = handedOut > static_cast<unsigned long long>( kNumSamples ) ?
+            kNumSamples : static_cast<int>( handedOut );
+
+        std::map<unsigned long long, Agg> aggregated;
+        for ( int i = 0; i < filled; i++ ) {
+            const unsigned long long h = _samples[i].shapeHash.load();
+            if ( h == 0 )
+                continue;
+            Agg& a = aggregated[h];
+            const long long micros = _samples[i].micros.load();
+            a.count++;
+            a.totalMicros += micros;
+            if ( micros > a.maxMicros )
+                a.maxMicros = micros;
+            a.lockWaitMicros += _samples[i].lockWaitMicros.load();
+            const long long memPeak = _samples[i].memPeakBytes.load();
+            if ( memPeak > a.memPeakBytes )
+                a.memPeakBytes = memPeak;
+        }
+
+        std::map<unsigned long long, ShapeInfo> shapes;
+        {
+            SimpleMutex::scoped_lock lk( _shapesLock );
+            shapes = _shapes;
+        }
+
+        // most expensive shapes first
+        std::vector< std::pair<long long, unsigned long long> > order;
+        for ( std::map<unsigned long long, Agg>::const_iterator i = aggregated.begin();
+              i != aggregated.end(); ++i ) {
+            if ( shapes.count( i->first ) )
+                order.push_back( std::make_pair( -i->second.totalMicros, i->first ) );
+        }
+        std::sort( order.begin(), order.end() );
+
+        BSONArrayBuilder arr( builder->subarrayStart( "shapes" ) );
+        for ( size_t i = 0; i < order.size(); i++ ) {
+            const unsigned long long h = order[i].second;
+            const Agg& a = aggregated[h];
+            const ShapeInfo& info = shapes[h];
+
+            BSONObjBuilder bb( arr.subobjStart() );
+            bb.append( "ns", info.ns );
+            bb.append( "op", info.opType );
+            bb.append( "shape", info.shape );
+            bb.appendNumber( "count", a.count );
+            bb.appendNumber( "totalMicros", a.totalMicros );
+            bb.appendNumber( "avgMicros", a.count ? a.totalMicros / a.count : 0 );
+            bb.appendNumber( "maxMicros", a.maxMicros );
+            bb.appendNumber( "lockWaitMicros", a.lockWaitMicros );
+            if ( a.memPeakBytes )
+                bb.appendNumber( "memPeakBytes", a.memPeakBytes );
+            bb.done();
+        }
+        arr.done();
+
+        builder->appendNumber( "totalOps", static_cast<long long>( _ops.load() ) );
+        builder->appendNumber( "sampledOps", static_cast<long long>( handedOut ) );
+        builder->append( "sampleRate", 1.0 / kSampleEvery );
+        builder->append( "ringSize", kNumSamples );
+    }
+
+    QueryShapeProfiler QueryShapeProfiler::global;
+
+    class QueryShapesCmd : public Command {
+    public:
+        QueryShapesCmd() : Command( "queryShapes", true ) {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream& help ) const {
+            help << "sampled per-query-shape timings, in micros. always on; "
+                    "see also the profile command for full tracing";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::top);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+        virtual bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            QueryShapeProfiler::global.append( &result );
+            return true;
+        }
+
+    } queryShapesCmd;
+
+}  // namespace mongo
@@ -0,0 +1,101 @@
+// query_shape_profiler.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <map>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class CurOp;
+
+    /**
+     * Always-on sampling profiler, unlike the system.profile profiler which
+     * writes a document per op under the write lock and is too expensive to
+     * leave enabled.  One in every kSampleEvery completed operations has its
+     * summary - query shape hash, duration, lock wait - dropped into a
+     * fixed-size in-memory ring.  The unsampled path is a single atomic
+     * increment; nothing ever touches disk.  The { queryShapes: 1 } command
+     * aggregates the ring per shape on demand.
+     */
+    class QueryShapeProfiler {
+    public:
+        static const int kSampleEvery = 16;
+        static const int kNumSamples = 4096;
+
+        QueryShapeProfiler() : _shapesLock( "QueryShapeProfiler" ) {}
+
+        /** Called at operation completion; cheap unless this op is sampled. */
+        void record( const CurOp& op, bool command, long long micros );
+
+        /** Aggregates the ring per shape, most expensive shapes first. */
+        void append( BSONObjBuilder* builder ) const;
+
+        /**
+         * Copies 'obj' with every value replaced by 1, so that queries
+         * differing only in constants collapse to the same shape.  Subobjects
+         * keep their structure; so do arrays under $-operators ($or, $and,
+         * ...) since their clauses are part of the shape, while plain arrays
+         * (e.g. $in lists) become a 1 regardless of length.
+         */
+        static void appendShape( const BSONObj& obj, BSONObjBuilder* out, int depth = 0 );
+
+        static QueryShapeProfiler global;
+
+    private:
+        struct Sample {
+            AtomicWord<unsigned long long> shapeHash; // 0 == empty slot
+            AtomicWord<long long> micros;
+            AtomicWord<long long> lockWaitMicros;
+            AtomicWord<long long> memPeakBytes;
+        };
+
+        /** What a shape hash stands for, fixed at first sighting. */
+        struct ShapeInfo {
+            std::string ns;
+            std::string opType;
+            BSONObj shape;
+        };
+
+        AtomicUInt64 _ops;      // every completed op, sampled or not
+        AtomicUInt64 _sampled;  // ring slots handed out
+
+        Sample _samples[kNumSamples];
+
+        // shape hash -> description; only written when a new shape shows up
+        mutable SimpleMutex _shapesLock;
+        std::map<unsigned long long, ShapeInfo> _shapes;
+    };
+
+}  // namespace mongo
@@ -34,6 +34,7 @@
 
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/util/timer_wheel.h"
 
 /**
    handles snapshotting performance metrics and other such things
@@ -115,37 +116,38 @@ namespace mongo {
         ss << "</div>\n";
     }
 
-    void SnapshotThread::run() {
-        Client::initThread("snapshotthread");
-        Client& client = cc();
+    namespace {
 
-        long long numLoops = 0;
+        // The snapshot most recently fed to the cpu log line.
+        const SnapshotData* prevSnapshot = 0;
 
-        const SnapshotData* prev = 0;
+        void takeStatsSnapshot() {
+            if ( inShutdown() )
+                return;
 
-        while ( ! inShutdown() ) {
             try {
                 const SnapshotData* s = statsSnapshots.takeSnapshot();
 
-                if (prev && serverGlobalParams.cpu) {
-                    unsigned long long elapsed = s->_created - prev->_created;
-                    SnapshotDelta d( *prev , *s );
-                    log() << "cpu: elapsed:" << (elapsed/1000) <<"  writelock: " << (int)(100*d.percentWriteLocked()) << "%" << endl;
+                if (prevSnapshot && serverGlobalParams.cpu) {
+                    SnapshotDelta d( *prevSnapshot , *s );
+                    log() << "cpu: elapsed:" << (d.elapsed()/1000) <<"  writelock: " << (int)(100*d.percentWriteLocked()) << "%" << endl;
                 }
 
-                prev = s;
+                prevSnapshot = s;
             }
             catch ( std::exception& e ) {
-                log() << "ERROR in SnapshotThread: " << e.what() << endl;
+                log() << "ERROR taking stats snapshot: " << e.what() << endl;
             }
-
-            numLoops++;
-            sleepsecs(4);
         }
 
-        client.shutdown();
+    } // namespace
+
+    void startStatsSnapshots() {
+        TimerWheel* wheel = globalTimerWheel();
+        if ( !wheel )
+            return;
+        wheel->schedulePeriodic( "statsSnapshot", takeStatsSnapshot, 4 );
     }
 
     Snapshots statsSnapshots;
-    SnapshotThread snapshotThread;
 }
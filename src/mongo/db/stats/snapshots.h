@@ -32,15 +32,12 @@
 #include "mongo/pch.h"
 #include "mongo/db/jsobj.h"
 #include "top.h"
-#include "mongo/util/background.h"
 
 /**
    handles snapshotting performance metrics and other such things
  */
 namespace mongo {
 
-    class SnapshotThread;
-
     /**
      * stores a point in time snapshot
      * i.e. all counters at a given time
@@ -53,7 +50,6 @@ namespace mongo {
         unsigned long long _totalWriteLockedTime; // micros of total time locked
         Top::UsageMap _usage;
 
-        friend class SnapshotThread;
         friend class SnapshotDelta;
         friend class Snapshots;
     };
@@ -113,14 +109,12 @@ namespace mongo {
         int _stored;
     };
 
-    class SnapshotThread : public BackgroundJob {
-    public:
-        virtual string name() const { return "snapshot"; }
-        void run();
-    };
+    /**
+     * Registers the periodic stats snapshot job on the shared timer wheel thread.
+     */
+    void startStatsSnapshots();
 
     extern Snapshots statsSnapshots;
-    extern SnapshotThread snapshotThread;
 
 
 }
@@ -114,7 +114,7 @@ namespace {
 
             Top::UsageMap usage = delta->collectionUsageDiff();
             for ( Top::UsageMap::const_iterator i=usage.begin(); i != usage.end(); ++i ) {
-                display( ss , (double) delta->elapsed() , i->first , i->second );
+                display( ss , (double) delta->elapsed() , i->first.str().toString() , i->second );
             }
 
             ss << "</table>";
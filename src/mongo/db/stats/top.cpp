@@ -36,17 +36,93 @@
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
 #include "mongo/db/commands.h"
 
 namespace mongo {
 
+    /**
+     * Per-thread buffer of usage not yet folded into the shared map: a small
+     * open-addressing table keyed by the interned namespace handle.  Op
+     * completion only touches this; the owning thread folds it into
+     * Top::global on volume or age, so the shared lock is taken once per
+     * flush instead of once per op.
+     */
+    struct TopDeltaBuffer {
+        enum { NumSlots = 64 }; // power of two; flushed well before full
+
+        struct Slot {
+            InternedString ns; // empty == unused
+            Top::CollectionData data;
+        };
+
+        TopDeltaBuffer() : distinct( 0 ), pending( 0 ), lastFlushMillis( 0 ) {}
+
+        /** slot for ns, or NULL if the table needs a flush first */
+        Slot* find( const InternedString& ns ) {
+            size_t idx = InternedString::Hasher()( ns ) & ( NumSlots - 1 );
+            for ( int probes = 0; probes < MaxProbes; probes++ ) {
+                Slot& s = slots[( idx + probes ) & ( NumSlots - 1 )];
+                if ( s.ns == ns )
+                    return &s;
+                if ( s.ns.isEmpty() ) {
+                    if ( distinct >= NumSlots / 2 )
+                        return NULL;
+                    s.ns = ns;
+                    distinct++;
+                    return &s;
+                }
+            }
+            return NULL;
+        }
+
+        void clear() {
+            for ( int i = 0; i < NumSlots; i++ ) {
+                slots[i].ns = InternedString();
+                slots[i].data = Top::CollectionData();
+            }
+            globalDelta = Top::CollectionData();
+            distinct = 0;
+            pending = 0;
+        }
+
+        static const int MaxProbes = 8;
+
+        Slot slots[NumSlots];
+        Top::CollectionData globalDelta;
+        int distinct;
+        int pending;
+        long long lastFlushMillis;
+    };
+
+    TSP_DECLARE(TopDeltaBuffer, tlTopDeltas)
+    TSP_DEFINE(TopDeltaBuffer, tlTopDeltas)
+
+    namespace {
+        const int kFlushEveryOps = 64;
+        const long long kFlushIntervalMillis = 1000;
+    }
+
     Top::UsageData::UsageData( const UsageData& older , const UsageData& newer ) {
         // this won't be 100% accurate on rollovers and drop(), but at least it won't be negative
         time  = (newer.time  >= older.time)  ? (newer.time  - older.time)  : newer.time;
         count = (newer.count >= older.count) ? (newer.count - older.count) : newer.count;
     }
 
+    void Top::CollectionData::add( const CollectionData& other ) {
+        total.add( other.total );
+        readLock.add( other.readLock );
+        writeLock.add( other.writeLock );
+        queries.add( other.queries );
+        getmore.add( other.getmore );
+        insert.add( other.insert );
+        update.add( other.update );
+        remove.add( other.remove );
+        commands.add( other.commands );
+    }
+
     Top::CollectionData::CollectionData( const CollectionData& older , const CollectionData& newer )
         : total( older.total , newer.total ) ,
           readLock( older.readLock , newer.readLock ) ,
@@ -64,17 +140,70 @@ namespace mongo {
         if ( ns[0] == '?' )
             return;
 
-        //cout << "record: " << ns << "\t" << op << "\t" << command << endl;
-        SimpleMutex::scoped_lock lk(_lock);
+        record( internString( ns ) , op , lockType , micros , command );
+    }
+
+    void Top::record( const InternedString& ns , int op , int lockType , long long micros , bool command ) {
+        //cout << "record: " << ns.str() << "\t" << op << "\t" << command << endl;
+        TopDeltaBuffer* buf = tlTopDeltas.getMake();
+        long long now = Listener::getElapsedTimeMillis();
+
+        TopDeltaBuffer::Slot* slot = buf->find( ns );
+        if ( !slot ) {
+            // table crowded with distinct namespaces; fold it in and retry
+            _flush( buf , now );
+            slot = buf->find( ns );
+            verify( slot );
+        }
 
-        if ( ( command || op == dbQuery ) && ns == _lastDropped ) {
-            _lastDropped = "";
+        _record( slot->data , op , lockType , micros , command );
+        _record( buf->globalDelta , op , lockType , micros , command );
+        buf->pending++;
+
+        if ( buf->pending >= kFlushEveryOps ||
+             now - buf->lastFlushMillis >= kFlushIntervalMillis ) {
+            _flush( buf , now );
+        }
+    }
+
+    void Top::_flush( TopDeltaBuffer* buf , long long nowMillis ) {
+        SimpleMutex::scoped_lock lk( _lock );
+
+        for ( int i = 0; i < TopDeltaBuffer::NumSlots; i++ ) {
+            TopDeltaBuffer::Slot& s = buf->slots[i];
+            if ( s.ns.isEmpty() )
+                continue;
+
+            if ( s.ns == _lastDropped ) {
+                // the drop itself; don't let its bookkeeping re-create the
+                // entry we just erased
+                _lastDropped = InternedString();
+                continue;
+            }
+
+            _usage[s.ns].add( s.data );
+            _intervalAccum[s.ns].add( s.data );
+        }
+        _global.add( buf->globalDelta );
+
+        buf->clear();
+        buf->lastFlushMillis = nowMillis;
+
+        _rollIntervalIfNeeded( nowMillis );
+    }
+
+    void Top::_rollIntervalIfNeeded( long long nowMillis ) {
+        if ( _intervalStartMillis == 0 ) {
+            _intervalStartMillis = nowMillis;
             return;
         }
+        if ( nowMillis - _intervalStartMillis < kFlushIntervalMillis )
+            return;
 
-        CollectionData& coll = _usage[ns];
-        _record( coll , op , lockType , micros , command );
-        _record( _global , op , lockType , micros , command );
+        _lastInterval.swap( _intervalAccum );
+        _intervalAccum.clear();
+        _lastIntervalMillis = nowMillis - _intervalStartMillis;
+        _intervalStartMillis = nowMillis;
     }
 
     void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command ) {
@@ -120,9 +249,12 @@ namespace mongo {
     }
 
     void Top::collectionDropped( const StringData& ns ) {
+        InternedString ins = internString( ns );
         SimpleMutex::scoped_lock lk(_lock);
-        _usage.erase(ns);
-        _lastDropped = ns.toString();
+        _usage.erase(ins);
+        _intervalAccum.erase(ins);
+        _lastInterval.erase(ins);
+        _lastDropped = ins;
     }
 
     void Top::cloneMap(Top::UsageMap& out) const {
@@ -130,25 +262,44 @@ namespace mongo {
         out = _usage;
     }
 
+    bool Top::getUsage( const StringData& ns, Top::CollectionData* result ) const {
+        InternedString ins = internString( ns );
+        SimpleMutex::scoped_lock lk(_lock);
+        UsageMap::const_iterator i = _usage.find( ins );
+        if ( i == _usage.end() ) {
+            *result = CollectionData();
+            return false;
+        }
+        *result = i->second;
+        return true;
+    }
+
     void Top::append( BSONObjBuilder& b ) {
         SimpleMutex::scoped_lock lk( _lock );
         _appendToUsageMap( b , _usage );
     }
 
+    void Top::appendLastInterval( BSONObjBuilder& b ) {
+        SimpleMutex::scoped_lock lk( _lock );
+        _rollIntervalIfNeeded( Listener::getElapsedTimeMillis() );
+        b.appendNumber( "intervalMillis" , _lastIntervalMillis );
+        _appendToUsageMap( b , _lastInterval );
+    }
+
     void Top::_appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const {
-        // pull all the names into a vector so we can sort them for the user
-        
-        vector<string> names;
+        // pull all the entries into a vector so we can sort them by name for the user
+
+        vector< pair<string,const CollectionData*> > entries;
         for ( UsageMap::const_iterator i = map.begin(); i != map.end(); ++i ) {
-            names.push_back( i->first );
+            entries.push_back( make_pair( i->first.str().toString() , &i->second ) );
         }
-        
-        std::sort( names.begin(), names.end() );
 
-        for ( size_t i=0; i<names.size(); i++ ) {
-            BSONObjBuilder bb( b.subobjStart( names[i] ) );
+        std::sort( entries.begin(), entries.end() );
 
-            const CollectionData& coll = map.find(names[i])->second;
+        for ( size_t i=0; i<entries.size(); i++ ) {
+            BSONObjBuilder bb( b.subobjStart( entries[i].first ) );
+
+            const CollectionData& coll = *entries[i].second;
 
             _appendStatsEntry( b , "total" , coll.total );
 
@@ -195,11 +346,65 @@ namespace mongo {
                 Top::global.append( b );
                 b.done();
             }
+            {
+                BSONObjBuilder b( result.subobjStart( "lastInterval" ) );
+                Top::global.appendLastInterval( b );
+                b.done();
+            }
             return true;
         }
 
     } topCmd;
 
+    /**
+     * Reports how much work this mongod has done for a single collection,
+     * derived from Top. The balancer runs this against every shard to weigh
+     * migration candidates by how hot a collection is where it currently lives.
+     * Counters are cumulative since startup, so only their relative size across
+     * shards is meaningful.
+     */
+    class CollectionLoadCmd : public Command {
+    public:
+        CollectionLoadCmd() : Command( "collectionLoad", true ) {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream& help ) const {
+            help << "{ collectionLoad: <ns> } Top-derived usage for one collection, in micros";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::top);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+        virtual bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            const string ns = cmdObj.firstElement().str();
+            if ( ns.empty() ) {
+                errmsg = "need to specify a namespace, ex: { collectionLoad: \"test.foo\" }";
+                return false;
+            }
+
+            Top::CollectionData data;
+            Top::global.getUsage( ns, &data ); // zeroed if we have never touched it
+
+            const long long readMicros = data.queries.time + data.getmore.time;
+            const long long writeMicros = data.insert.time + data.update.time + data.remove.time;
+
+            result.append( "ns", ns );
+            result.appendNumber( "readCount", data.queries.count + data.getmore.count );
+            result.appendNumber( "readMicros", readMicros );
+            result.appendNumber( "writeCount",
+                                 data.insert.count + data.update.count + data.remove.count );
+            result.appendNumber( "writeMicros", writeMicros );
+            result.appendNumber( "loadMicros", readMicros + writeMicros );
+            return true;
+        }
+
+    } collectionLoadCmd;
+
     Top Top::global;
 
 }
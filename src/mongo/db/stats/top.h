@@ -19,18 +19,26 @@
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include "mongo/platform/unordered_map.h"
 #include "mongo/util/concurrency/mutex.h"
-#include "mongo/util/string_map.h"
+#include "mongo/util/interned_string.h"
 
 namespace mongo {
 
+    struct TopDeltaBuffer;
+
     /**
      * tracks usage by collection
+     *
+     * Op completion records into a per-thread delta buffer (see top.cpp) that
+     * is folded into the shared map on volume or age, like the index usage
+     * tracker's buffers, so the common case takes no shared lock.  Readers
+     * may therefore be up to a flush interval (one second) behind.
      */
     class Top {
 
     public:
-        Top() : _lock("Top") { }
+        Top() : _lock("Top"), _intervalStartMillis(0), _lastIntervalMillis(0) { }
 
         struct UsageData {
             UsageData() : time(0) , count(0) {}
@@ -42,6 +50,11 @@ namespace mongo {
                 count++;
                 time += micros;
             }
+
+            void add( const UsageData& other ) {
+                time += other.time;
+                count += other.count;
+            }
         };
 
         struct CollectionData {
@@ -51,6 +64,8 @@ namespace mongo {
             CollectionData() {}
             CollectionData( const CollectionData& older , const CollectionData& newer );
 
+            void add( const CollectionData& other );
+
             UsageData total;
 
             UsageData readLock;
@@ -64,12 +79,26 @@ namespace mongo {
             UsageData commands;
         };
 
-        typedef StringMap<CollectionData> UsageMap;
+        // keyed by interned namespace so lookups under _lock hash/compare a
+        // pointer instead of the namespace characters
+        typedef unordered_map<InternedString,CollectionData,InternedString::Hasher> UsageMap;
 
     public:
         void record( const StringData& ns , int op , int lockType , long long micros , bool command );
+        /** as above, but the caller already interned the namespace (see CurOp) */
+        void record( const InternedString& ns , int op , int lockType , long long micros , bool command );
         void append( BSONObjBuilder& b );
+        /**
+         * usage over the last completed one-second interval, so mongotop
+         * no longer has to approximate rates by diffing cumulative totals
+         */
+        void appendLastInterval( BSONObjBuilder& b );
         void cloneMap(UsageMap& out) const;
+        /**
+         * copies the usage data for one collection into 'result'
+         * @return false (and zeroed data) if we have never touched the collection
+         */
+        bool getUsage( const StringData& ns, CollectionData* result ) const;
         CollectionData getGlobalData() const { return _global; }
         void collectionDropped( const StringData& ns );
 
@@ -81,10 +110,22 @@ namespace mongo {
         void _appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const;
         void _record( CollectionData& c , int op , int lockType , long long micros , bool command );
 
+        /** folds a thread's pending deltas into the shared maps */
+        void _flush( TopDeltaBuffer* buffer , long long nowMillis );
+
+        /** caller holds _lock; publishes the interval snapshot once a second */
+        void _rollIntervalIfNeeded( long long nowMillis );
+
         mutable SimpleMutex _lock;
         CollectionData _global;
         UsageMap _usage;
-        string _lastDropped;
+        InternedString _lastDropped;
+
+        // last completed interval's deltas, published by _rollIntervalIfNeeded
+        UsageMap _intervalAccum;
+        UsageMap _lastInterval;
+        long long _intervalStartMillis;
+        long long _lastIntervalMillis; // length of the published interval
     };
 
 } // namespace mongo
@@ -0,0 +1,168 @@
+// working_set_stats.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/working_set_stats.h"
+
+namespace mongo {
+
+    namespace {
+
+        // matches the horizon of the access tracker's slices
+        // (RotateTimeSecs * NumSlices in db/storage/record.cpp)
+        const int WindowSecs = 900;
+
+        // the tracker works in 4k pages
+        const long long PageSizeBytes = 4096;
+
+        // don't give sizing advice off a handful of samples
+        const long long MinSamplesForAdvice = 1000;
+    }
+
+    WorkingSetStats::CollectionStats::CollectionStats()
+        : windowStart( time( 0 ) ),
+          prevAccesses( 0 ),
+          prevResident( 0 ),
+          prevFirstTouches( 0 ),
+          prevSeconds( 0 ) {
+    }
+
+    WorkingSetStats::~WorkingSetStats() {
+        for ( StringMap<CollectionStats*>::const_iterator i = _byNamespace.begin();
+              i != _byNamespace.end(); ++i ) {
+            delete i->second;
+        }
+    }
+
+    void WorkingSetStats::record( const StringData& ns, bool resident, bool firstTouch ) {
+        CollectionStats* stats = _statsFor( ns );
+        stats->accesses.fetchAndAdd( 1 );
+        if ( resident )
+            stats->resident.fetchAndAdd( 1 );
+        if ( firstTouch )
+            stats->firstTouches.fetchAndAdd( 1 );
+    }
+
+    WorkingSetStats::CollectionStats* WorkingSetStats::_statsFor( const StringData& ns ) {
+        SimpleMutex::scoped_lock lk( _mapLock );
+        CollectionStats*& stats = _byNamespace[ns];
+        if ( !stats )
+            stats = new CollectionStats();
+        else
+            _rotateIfNeeded( stats );
+        return stats;
+    }
+
+    void WorkingSetStats::_rotateIfNeeded( CollectionStats* stats ) {
+        time_t now = time( 0 );
+        if ( now - stats->windowStart < WindowSecs )
+            return;
+
+        stats->prevAccesses = stats->accesses.load();
+        stats->prevResident = stats->resident.load();
+        stats->prevFirstTouches = stats->firstTouches.load();
+        stats->prevSeconds = static_cast<int>( now - stats->windowStart );
+
+        stats->accesses.store( 0 );
+        stats->resident.store( 0 );
+        stats->firstTouches.store( 0 );
+        stats->windowStart = now;
+    }
+
+    void WorkingSetStats::append( BSONObjBuilder& b ) {
+        SimpleMutex::scoped_lock lk( _mapLock );
+
+        // sort the names so the user gets a stable order, as top does
+        vector<string> names;
+        for ( StringMap<CollectionStats*>::const_iterator i = _byNamespace.begin();
+              i != _byNamespace.end(); ++i ) {
+            names.push_back( i->first );
+        }
+        std::sort( names.begin(), names.end() );
+
+        BSONObjBuilder collections( b.subobjStart( "collections" ) );
+        time_t now = time( 0 );
+
+        for ( size_t i = 0; i < names.size(); i++ ) {
+            CollectionStats* stats = _byNamespace.find( names[i] )->second;
+            _rotateIfNeeded( stats );
+
+            long long accesses = stats->accesses.load() + stats->prevAccesses;
+            if ( !accesses )
+                continue;
+            long long resident = stats->resident.load() + stats->prevResident;
+            long long firstTouches = stats->firstTouches.load() + stats->prevFirstTouches;
+
+            BSONObjBuilder cb( collections.subobjStart( names[i] ) );
+            cb.appendNumber( "accessesSampled", accesses );
+            cb.appendNumber( "pagesTouched", firstTouches );
+            cb.appendNumber( "estimatedRamBytes", firstTouches * PageSizeBytes );
+            cb.append( "residentRate", static_cast<double>( resident ) / accesses );
+            cb.append( "reuseRate", 1.0 - static_cast<double>( firstTouches ) / accesses );
+            cb.append( "overSeconds",
+                       static_cast<int>( now - stats->windowStart ) + stats->prevSeconds );
+
+            // a collection whose pages are mostly touched once and rarely
+            // found in memory is being dragged through RAM for no benefit -
+            // flag it so an operator can move those scans off peak or stop
+            // sizing the instance for them
+            if ( accesses >= MinSamplesForAdvice &&
+                 resident * 2 < accesses &&
+                 firstTouches * 10 >= accesses * 9 ) {
+                cb.append( "evictionCandidate", true );
+            }
+            cb.done();
+        }
+
+        collections.done();
+    }
+
+    void WorkingSetStats::collectionDropped( const StringData& ns ) {
+        // reset rather than erase: record() may hold a pointer to the entry
+        SimpleMutex::scoped_lock lk( _mapLock );
+        StringMap<CollectionStats*>::const_iterator i = _byNamespace.find( ns );
+        if ( i == _byNamespace.end() )
+            return;
+
+        CollectionStats* stats = i->second;
+        stats->accesses.store( 0 );
+        stats->resident.store( 0 );
+        stats->firstTouches.store( 0 );
+        stats->windowStart = time( 0 );
+        stats->prevAccesses = 0;
+        stats->prevResident = 0;
+        stats->prevFirstTouches = 0;
+        stats->prevSeconds = 0;
+    }
+
+    WorkingSetStats WorkingSetStats::global;
+
+}  // namespace mongo
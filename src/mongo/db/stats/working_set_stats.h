@@ -0,0 +1,108 @@
+// working_set_stats.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    /**
+     * Per collection working set estimates, fed by the record access tracker
+     * in db/storage/record.cpp.  The tracker samples page touches (a page is
+     * reported at most once per thread until its thread local table rotates)
+     * and each sample says whether the page was already resident and whether
+     * this was its first sampled touch inside the tracking window.  From
+     * those we estimate, per collection, how many distinct pages the
+     * workload touches (~ RAM needed), how often pages are re-touched
+     * (reuse) and how often they are found in memory (residency).
+     *
+     * Counters accumulate into a window roughly as long as the tracker's own
+     * slice horizon and the completed previous window is kept, so reported
+     * rates cover about the last 15-30 minutes.
+     */
+    class WorkingSetStats {
+    public:
+        WorkingSetStats() : _mapLock( "WorkingSetStats" ) {}
+        ~WorkingSetStats();
+
+        /**
+         * @param resident   the page was (likely) already in physical memory
+         * @param firstTouch first sampled touch of the page in the current
+         *                   tracking window
+         */
+        void record( const StringData& ns, bool resident, bool firstTouch );
+
+        /**
+         * Appends a 'collections' subobject with, per namespace, the sampled
+         * access counts, the resulting residency / reuse rates, the RAM the
+         * touched pages amount to, and an 'evictionCandidate' flag on
+         * collections that are scanned through memory with little reuse.
+         */
+        void append( BSONObjBuilder& b );
+
+        void collectionDropped( const StringData& ns );
+
+        static WorkingSetStats global;
+
+    private:
+        struct CollectionStats {
+            CollectionStats();
+
+            // current window; incremented lock free
+            AtomicInt64 accesses;
+            AtomicInt64 resident;
+            AtomicInt64 firstTouches;
+            time_t windowStart;
+
+            // previous, completed window
+            long long prevAccesses;
+            long long prevResident;
+            long long prevFirstTouches;
+            int prevSeconds;
+        };
+
+        CollectionStats* _statsFor( const StringData& ns );
+
+        /** requires _mapLock */
+        void _rotateIfNeeded( CollectionStats* stats );
+
+        // Guards the map and window rotation only.  Entries are never
+        // deleted (a dropped collection's counters are reset instead) so
+        // pointers handed out stay valid for lock free recording.
+        SimpleMutex _mapLock;
+        StringMap<CollectionStats*> _byNamespace;
+    };
+
+}  // namespace mongo
@@ -104,7 +104,7 @@ namespace mongo {
         DataFileHeader* getHeader() { return header(); }
         const DataFileHeader* getHeader() const { return header(); }
 
-        HANDLE getFd() { return mmf.getFd(); }
+        HANDLE getFd() const { return mmf.getFd(); }
         unsigned long long length() const { return mmf.length(); }
 
         /* return max size an extent may be */
@@ -36,6 +36,7 @@
 
 #include "mongo/db/storage/durable_mapped_file.h"
 
+#include <algorithm>
 
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/dur.h"
@@ -46,16 +47,77 @@ using namespace mongoutils;
 
 namespace mongo {
 
+    const size_t DurableMappedFile::remapChunkSize;
+
+    void DurableMappedFile::markDirtyRange(size_t ofs, unsigned len) {
+        if( len == 0 )
+            return;
+        if( _dirtyChunks.empty() )
+            _dirtyChunks.resize((size_t) ((length() + remapChunkSize - 1) / remapChunkSize), false);
+        size_t last = (ofs + len - 1) / remapChunkSize;
+        for( size_t c = ofs / remapChunkSize; c <= last && c < _dirtyChunks.size(); c++ )
+            _dirtyChunks[c] = true;
+    }
+
+#if !defined(_WIN32)
+    bool DurableMappedFile::_remapDirtyChunksOnly() {
+        if( _dirtyChunks.empty() )
+            return false;
+
+        size_t nDirty = 0;
+        for( size_t c = 0; c < _dirtyChunks.size(); c++ ) {
+            if( _dirtyChunks[c] )
+                nDirty++;
+        }
+
+        // if most of the file was written, one whole-view remap is cheaper than many
+        // ranged ones
+        if( nDirty * 2 > _dirtyChunks.size() )
+            return false;
+
+        // remap each contiguous run of dirty chunks.  chunks with no declared write
+        // intents since the last remap have no privately materialized pages -- every
+        // write through the private view is declared to the commit job -- so skipping
+        // them is safe and preserves their warm page table entries.
+        for( size_t c = 0; c < _dirtyChunks.size(); ) {
+            if( !_dirtyChunks[c] ) {
+                c++;
+                continue;
+            }
+            size_t runEnd = c;
+            while( runEnd < _dirtyChunks.size() && _dirtyChunks[runEnd] )
+                runEnd++;
+            size_t offset = c * remapChunkSize;
+            size_t len = std::min((size_t) (runEnd * remapChunkSize), (size_t) length()) - offset;
+            remapPrivateViewRange(_view_private, offset, len);
+            c = runEnd;
+        }
+
+        _dirtyChunks.assign(_dirtyChunks.size(), false);
+        return true;
+    }
+#endif
+
     void DurableMappedFile::remapThePrivateView() {
         verify(storageGlobalParams.dur);
 
+#if !defined(_WIN32)
+        // when only a small part of the file was written since the last remap, drop just
+        // those copy-on-write pages rather than tearing down the whole mapping
+        if( _remapDirtyChunksOnly() )
+            return;
+#endif
+
         // todo 1.9 : it turns out we require that we always remap to the same address.
         // so the remove / add isn't necessary and can be removed?
         void *old = _view_private;
-        //privateViews.remove(_view_private);        
+        //privateViews.remove(_view_private);
         _view_private = remapPrivateView(_view_private);
         //privateViews.add(_view_private, this);
         fassert( 16112, _view_private == old );
+
+        if( !_dirtyChunks.empty() )
+            _dirtyChunks.assign(_dirtyChunks.size(), false);
     }
 
     /** register view. threadsafe */
@@ -87,7 +87,7 @@ namespace mongo {
         }
 
         int fileSuffixNo() const { return _fileSuffixNo; }
-        HANDLE getFd() { return MemoryMappedFile::getFd(); }
+        HANDLE getFd() const { return MemoryMappedFile::getFd(); }
 
         /** true if we have written.
             set in PREPLOGBUFFER, it is NOT set immediately on write intent declaration.
@@ -95,15 +95,39 @@ namespace mongo {
         */
         bool& willNeedRemap() { return _willNeedRemap; }
 
+        /** note that [ofs, ofs+len) of the private view was written, and thus may hold
+            privately materialized (copy-on-write) pages.  set in PREPLOGBUFFER alongside
+            willNeedRemap(); lets remapThePrivateView() remap just the written chunks
+            instead of the entire view.
+        */
+        void markDirtyRange(size_t ofs, unsigned len);
+
         void remapThePrivateView();
 
         virtual bool isDurableMappedFile() { return true; }
 
     private:
+        // granularity of the dirty tracking below.  must be a multiple of the page size;
+        // coarse enough that a 2GB file needs only 512 bits and a handful of mmap calls.
+        static const size_t remapChunkSize = 4 * 1024 * 1024;
+
+#if !defined(_WIN32)
+        /** remap only the chunks recorded dirty since the last remap.
+            @return true if handled, false if the caller should remap the whole view
+            (nothing recorded, or enough of the file was written that one map is cheaper).
+        */
+        bool _remapDirtyChunksOnly();
+#endif
 
         void *_view_write;
         void *_view_private;
         bool _willNeedRemap;
+
+        // bit per remapChunkSize bytes of the private view; sized on first write.
+        // written in PREPLOGBUFFER, read and cleared in REMAPPRIVATEVIEW -- both
+        // serialized by the group commit machinery, like _willNeedRemap.
+        std::vector<bool> _dirtyChunks;
+
         RelativePath _p;   // e.g. "somepath/dbname"
         int _fileSuffixNo;  // e.g. 3.  -1="ns"
 
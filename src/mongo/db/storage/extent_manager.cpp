@@ -40,6 +40,7 @@
 #include "mongo/db/storage/extent_manager.h"
 
 #include "mongo/db/pdfile.h"
+#include "mongo/platform/posix_fadvise.h"
 
 namespace mongo {
 
@@ -175,6 +176,25 @@ namespace mongo {
         return ret;
     }
 
+    bool ExtentManager::preallocateFileForExtent( int approxSize ) {
+        DEV Lock::assertWriteLocked( _dbname );
+
+        approxSize = quantizeExtentSize( approxSize );
+
+        for ( int i = numFiles() - 1; i >= 0; i-- ) {
+            DataFile* f = getFile( i );
+            if ( f->getHeader()->unusedLength >= approxSize ) {
+                // an already open file can host the extent, nothing to do
+                return false;
+            }
+        }
+
+        // the extent will need a fresh file; start writing it out now so the
+        // eventual addAFile() finds it on disk and only has to open it
+        preallocateAFile();
+        return true;
+    }
+
     size_t ExtentManager::numFiles() const {
         DEV Lock::assertAtLeastReadLocked( _dbname );
         return _files.size();
@@ -284,6 +304,17 @@ namespace mongo {
         return e->lastRecord;
     }
 
+    void ExtentManager::dontNeedRange( const DiskLoc& extentLoc, int len ) const {
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+        extentLoc.assertOk();
+        const DataFile* df = _getOpenFile( extentLoc.a() );
+        if ( posix_fadvise( df->getFd(), extentLoc.getOfs(), len, POSIX_FADV_DONTNEED ) ) {
+            warning() << "posix_fadvise fails " << fileName( extentLoc.a() ).string()
+                      << ' ' << errnoWithDescription() << endl;
+        }
+#endif
+    }
+
     Extent* ExtentManager::getNextExtent( Extent* e ) const {
         if ( e->xnext.isNull() )
             return NULL;
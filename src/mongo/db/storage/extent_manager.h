@@ -91,6 +91,16 @@ namespace mongo {
 
         void preallocateAFile() { getFile( numFiles() , 0, true ); }// XXX-ERH
 
+        /**
+         * If no currently open file has room for an extent of approxSize,
+         * asks the FileAllocator to start zeroing the next data file in the
+         * background so a later addAFile() only has to mmap it.
+         * Does not look at the free list.
+         * @return true if the next extent of this size will need a file that
+         *         is (still) being allocated in the background
+         */
+        bool preallocateFileForExtent( int approxSize );
+
         void flushFiles( bool sync );
 
         /* allocate a new Extent, does not check free list
@@ -160,6 +170,16 @@ namespace mongo {
 
         DiskLoc getPrevRecordInExtent( const DiskLoc& loc ) const;
 
+        /**
+         * Hint to the OS that the page cache backing len bytes at extentLoc
+         * will not be needed again soon, making those pages preferred victims
+         * for reclaim.  Used by cold collection scans so a one-off table scan
+         * does not evict the hot working set.  Advisory only; a no-op on
+         * platforms without posix_fadvise.
+         * @param extentLoc - has to be for a specific Extent
+         */
+        void dontNeedRange( const DiskLoc& extentLoc, int len ) const;
+
         /**
          * quantizes extent size to >= min + page boundary
          */
@@ -38,6 +38,7 @@
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/stats/working_set_stats.h"
 #include "mongo/platform/bits.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/util/net/listen.h"
@@ -390,7 +391,25 @@ namespace mongo {
             b.append( "overSeconds", static_cast<int>( time(0) - timestamp ) );
 
         }
-        
+
+        /**
+         * attributes a sampled page touch to the collection the current
+         * operation is addressing.  only called on thread local PointerTable
+         * misses, so the per collection bookkeeping runs at the same (low)
+         * rate as the Rolling slices above.
+         */
+        void noteAccess( bool resident , bool firstTouch ) {
+            if ( ! haveClient() )
+                return;
+            CurOp* op = cc().curop();
+            if ( ! op )
+                return;
+            const char* ns = op->getNS();
+            if ( ! ns || ! *ns )
+                return;
+            WorkingSetStats::global.record( ns , resident , firstTouch );
+        }
+
     }
 
     
@@ -446,10 +465,14 @@ namespace mongo {
     void Record::appendWorkingSetInfo( BSONObjBuilder& b ) {
         if ( ! blockSupported ) {
             b.append( "info", "not supported" );
-            return;
         }
-        
-        ps::appendWorkingSetInfo( b );
+        else {
+            ps::appendWorkingSetInfo( b );
+        }
+
+        // the per collection estimates come from the access tracker alone,
+        // so they are available even when residency checking is not
+        WorkingSetStats::global.append( b );
     }
 
     bool Record::likelyInPhysicalMemory() const {
@@ -490,24 +513,33 @@ namespace mongo {
         const size_t offset = page & 0x3f;
 
         const bool seen = ps::PointerTable::seen( ps::PointerTable::getData(), reinterpret_cast<size_t>(data));
-        if (seen || ps::rolling[ps::bigHash(region)].access( region , offset , false ) ) {
-        
+        if ( seen ) {
+            // this thread touched the page moments ago; no need to sample again
+            return true;
+        }
+
+        if ( ps::rolling[ps::bigHash(region)].access( region , offset , false ) ) {
+
 #ifdef _DEBUG
             if ( blockSupported && ! ProcessInfo::blockInMemory(data) ) {
                 RARELY warning() << "we think data is in ram but system says no"  << endl;
             }
 #endif
+            ps::noteAccess( true , false );
             return true;
         }
 
         if ( ! blockSupported ) {
-            // this means we don't fallback to system call 
+            // this means we don't fallback to system call
             // and assume things aren't in memory
             // possible we yield too much - but better than not yielding through a fault
+            ps::noteAccess( false , true );
             return false;
         }
 
-        return ProcessInfo::blockInMemory( const_cast<char*>(data) );
+        const bool inMemory = ProcessInfo::blockInMemory( const_cast<char*>(data) );
+        ps::noteAccess( inMemory , true );
+        return inMemory;
     }
 
 
@@ -516,8 +548,9 @@ namespace mongo {
         if (!seen){
             const size_t page = (size_t)_data >> 12;
             const size_t region = page >> 6;
-            const size_t offset = page & 0x3f;        
-            ps::rolling[ps::bigHash(region)].access( region , offset , true );
+            const size_t offset = page & 0x3f;
+            const bool inTracker = ps::rolling[ps::bigHash(region)].access( region , offset , true );
+            ps::noteAccess( inTracker , ! inTracker );
         }
 
         return this;
@@ -0,0 +1,81 @@
+// record_compression.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/storage/record_compression.h"
+
+#include <string>
+
+#include "mongo/util/compress.h"
+
+namespace mongo {
+
+    namespace {
+        const int kCompressedRecordHeaderSize = 3 * sizeof(int);
+    }
+
+    bool compressRecordData( const BSONObj& doc, BufBuilder* out ) {
+        std::string compressed;
+        compress( doc.objdata(), doc.objsize(), &compressed );
+
+        if ( static_cast<int>( compressed.size() ) + kCompressedRecordHeaderSize >=
+             doc.objsize() ) {
+            // Not worth it; incompressible documents stay in the plain format.
+            return false;
+        }
+
+        out->appendNum( kCompressedRecordMagic );
+        out->appendNum( doc.objsize() );
+        out->appendNum( static_cast<int>( compressed.size() ) );
+        out->appendBuf( compressed.data(), compressed.size() );
+        return true;
+    }
+
+    BSONObj uncompressRecordObj( const char* data ) {
+        verify( isCompressedRecordData( data ) );
+        const int uncompressedLen = reinterpret_cast<const int*>( data )[1];
+        const int compressedLen = reinterpret_cast<const int*>( data )[2];
+
+        massert( 18600,
+                 "compressed record has invalid uncompressed length",
+                 uncompressedLen >= BSONObj().objsize() &&
+                     uncompressedLen <= BSONObjMaxInternalSize );
+
+        std::string uncompressed;
+        massert( 18601,
+                 "compressed record failed to decompress - file may be corrupt",
+                 uncompress( data + kCompressedRecordHeaderSize, compressedLen, &uncompressed ) &&
+                     static_cast<int>( uncompressed.size() ) == uncompressedLen );
+
+        // The record body is transient (mmap page may be remapped, record may move), so
+        // hand back an owned copy.
+        return BSONObj( uncompressed.c_str() ).getOwned();
+    }
+
+}  // namespace mongo
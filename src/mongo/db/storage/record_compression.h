@@ -0,0 +1,73 @@
+// record_compression.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/bson/util/builder.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * Opt-in compressed storage format for record bodies
+     * (NamespaceDetails::Flag_CompressRecords).
+     *
+     * A compressed body is self-describing:
+     *
+     *     [ int32 magic ][ int32 uncompressed length ][ int32 compressed length ][ snappy block ]
+     *
+     * The magic is negative, and a plain BSON document always starts with a positive int32
+     * total length, so the two layouts cannot be confused and compressed and uncompressed
+     * records can coexist in one collection (turning the flag on only affects records
+     * written afterwards).  BSONObj::make() is the single place record bodies become
+     * documents, and it decompresses transparently.
+     */
+
+    // "SNP\xff" as a little-endian int32; the high byte keeps it negative.
+    const int kCompressedRecordMagic = 0xff504e53;
+
+    inline bool isCompressedRecordData( const char* data ) {
+        return *reinterpret_cast<const int*>( data ) == kCompressedRecordMagic;
+    }
+
+    /**
+     * Appends the compressed image of 'doc' to 'out'.  Returns false (leaving 'out'
+     * untouched) when compression would not actually shrink the record, in which case the
+     * caller should store the document uncompressed.
+     */
+    bool compressRecordData( const BSONObj& doc, BufBuilder* out );
+
+    /**
+     * Decompresses a record body produced by compressRecordData().  The returned object
+     * owns its buffer; it does not point into the record.
+     */
+    BSONObj uncompressRecordObj( const char* data );
+
+}  // namespace mongo
@@ -79,6 +79,8 @@ namespace mongo {
 
         bool dur;                       // --dur durability (now --journal)
         unsigned journalCommitInterval; // group/batch commit interval ms
+        std::string journalPath;        // --journalPath; directory for journal files so they can
+                                        // live on their own device.  Empty means <dbpath>/journal.
 
         /** --durOptions 7      dump journal and terminate without doing anything further
             --durOptions 4      recover and terminate without listening
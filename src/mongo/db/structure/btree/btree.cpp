@@ -1923,6 +1923,88 @@ namespace mongo {
         return x;
     }
 
+    /**
+     * Equivalent to bt_insert() once per key, but keeps a finger on the bucket that
+     * received the previous key so runs of nearby keys skip the root-to-leaf descent.
+     * See comments in btree.h.
+     */
+    template< class V >
+    int BtreeBucket<V>::bt_insert_batch(IndexCatalogEntry* btreeState,
+                                        const DiskLoc thisLoc,
+                                        const DiskLoc recordLoc,
+                                        const vector<BSONObj>& keys,
+                                        bool dupsAllowed,
+                                        size_t* cursor) const {
+        const Ordering& order = btreeState->ordering();
+        int ret = 0;
+        DiskLoc finger; // bucket that received the previous key
+
+        guessIncreasing = !keys.empty() &&
+            keys.front().firstElementType() == jstOID &&
+            btreeState->descriptor()->isIdIndex();
+
+        try {
+            while ( *cursor < keys.size() ) {
+                KeyOwned key(keys[*cursor]);
+
+                if ( key.dataSize() > getKeyMax() ) {
+                    string msg = str::stream() << "Btree::insert: key too large to index, failing "
+                                               << btreeState->descriptor()->indexNamespace() << ' '
+                                               << key.dataSize() << ' ' << key.toString();
+                    problem() << msg << endl;
+                    keyTooLongAssert( 17434, msg );
+                    ret = 3;
+                    ++*cursor;
+                    continue;
+                }
+
+                DiskLoc target;
+                if ( !finger.isNull() ) {
+                    // If the key falls strictly between the finger bucket's first and
+                    // last keys, its position is in (or beneath) that bucket and we can
+                    // skip the descent from the root.  Exact matches against a boundary
+                    // key fail the strict test and descend, so duplicate detection is
+                    // unaffected.  Splits caused by our own earlier inserts are fine:
+                    // the finger bucket stays in the tree with a subrange of its keys.
+                    const BtreeBucket<V>* fb = BTREE(finger);
+                    if ( fb->n >= 2 &&
+                         fb->keyNode(0).key.woCompare( key, order ) < 0 &&
+                         key.woCompare( fb->keyNode(fb->n - 1).key, order ) < 0 ) {
+                        target = finger;
+                    }
+                }
+
+                if ( target.isNull() ) {
+                    target = thisLoc;
+                    while ( 1 ) {
+                        const BtreeBucket<V>* b = BTREE(target);
+                        int pos;
+                        if ( b->find(btreeState, key, recordLoc, pos, !dupsAllowed) )
+                            break; // let _insert() handle the match (unused key or dup)
+                        DiskLoc child = b->childForPos(pos);
+                        if ( child.isNull() )
+                            break;
+                        target = child;
+                    }
+                }
+
+                int x = BTREE(target)->_insert(btreeState, target, recordLoc, key,
+                                               dupsAllowed, DiskLoc(), DiskLoc() );
+                this->assertValid( order );
+                if ( x != 0 )
+                    ret = x;
+                finger = target;
+                ++*cursor;
+            }
+        }
+        catch( ... ) {
+            guessIncreasing = false;
+            throw;
+        }
+        guessIncreasing = false;
+        return ret;
+    }
+
     template< class V >
     void BtreeBucket<V>::shape(stringstream& ss) const {
         this->_shape(0, ss);
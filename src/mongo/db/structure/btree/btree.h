@@ -400,6 +400,9 @@ namespace mongo {
         int nKeys() const { return this->n; }
         const DiskLoc getNextChild() const { return this->nextChild; }
 
+        /** Parent bucket, which isNull() for the head bucket. */
+        const DiskLoc getParent() const { return this->parent; }
+
         // for tree inspection and statistical analysis
         // NOTE: topSize and emptySize have different types in BtreeData_V0 and BtreeData_V1
 
@@ -725,6 +728,27 @@ namespace mongo {
                       const BSONObj& key,
                       bool dupsallowed,
                       bool toplevel) const;
+
+        /**
+         * Insert a batch of keys all pointing to recordLoc, resuming at
+         * keys[*cursor].  Equivalent to calling bt_insert() once per key, but
+         * keeps a finger on the bucket that received the previous key: when
+         * the next key falls strictly inside that bucket's key range it is
+         * inserted there directly instead of re-descending from the root.
+         * Keys that arrive in sorted order (e.g. out of a BSONObjSet) tend to
+         * hit the same bucket repeatedly, so most descents are skipped.
+         *
+         * '*cursor' is advanced past each key that is applied; on exception
+         * it indexes the key that failed, so the caller can roll back what
+         * was applied, or skip the offender and resume.
+         */
+        int bt_insert_batch(IndexCatalogEntry* btreeState,
+                            const DiskLoc thisLoc,
+                            const DiskLoc recordLoc,
+                            const vector<BSONObj>& keys,
+                            bool dupsallowed,
+                            size_t* cursor) const;
+
         /**
          * Preconditions:
          *  - 'key' has a valid schema for this index, and may have objsize() > KeyMax.
@@ -32,49 +32,85 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/structure/btree/btree_stats.h"
+#include "mongo/util/concurrency/threadlocal.h"
 
 namespace mongo {
 
+    /**
+     * Per-thread buffer of btree accesses not yet folded into the shared
+     * counters.  Flushed every kBtreeStatsFlushEvery accesses, so the shared
+     * counters lag by at most that much per thread.
+     */
+    struct BtreeAccessBuffer {
+        BtreeAccessBuffer() : hits( 0 ), misses( 0 ) {}
+        long long hits;
+        long long misses;
+    };
+
+    TSP_DECLARE(BtreeAccessBuffer, tlBtreeAccesses)
+    TSP_DEFINE(BtreeAccessBuffer, tlBtreeAccesses)
+
+    namespace {
+        const long long kBtreeStatsFlushEvery = 1024;
+    }
 
-    IndexCounters::IndexCounters() 
+    IndexCounters::IndexCounters()
         : ServerStatusSection( "indexCounters" ) {
 
         _memSupported = ProcessInfo().blockCheckSupported();
 
-        _btreeMemHits = 0;
-        _btreeMemMisses = 0;
-        _btreeAccesses = 0;
-
-
         _maxAllowed = ( numeric_limits< long long >::max() ) / 2;
-        _resets = 0;
     }
 
     IndexCounters::~IndexCounters(){
     }
 
+    void IndexCounters::btree( bool memHit ) {
+        BtreeAccessBuffer* buffer = tlBtreeAccesses.getMake();
+        if ( memHit )
+            buffer->hits++;
+        else
+            buffer->misses++;
+        if ( buffer->hits + buffer->misses >= kBtreeStatsFlushEvery ) {
+            _flush( buffer->hits, buffer->misses );
+            buffer->hits = 0;
+            buffer->misses = 0;
+        }
+    }
+
+    void IndexCounters::_flush( long long hits, long long misses ) {
+        _btreeMemHits.fetchAndAdd( hits );
+        _btreeMemMisses.fetchAndAdd( misses );
+        if ( _btreeAccesses.fetchAndAdd( hits + misses ) > _maxAllowed )
+            _roll();
+    }
+
     BSONObj IndexCounters::generateSection(const BSONElement& configElement) const {
         if ( ! _memSupported ) {
             return BSON( "note" << "not supported on this platform" );
         }
         
+        long long accesses = _btreeAccesses.load();
+        long long hits = _btreeMemHits.load();
+        long long misses = _btreeMemMisses.load();
+
         BSONObjBuilder bb;
-        bb.appendNumber( "accesses" , _btreeAccesses );
-        bb.appendNumber( "hits" , _btreeMemHits );
-        bb.appendNumber( "misses" , _btreeMemMisses );
+        bb.appendNumber( "accesses" , accesses );
+        bb.appendNumber( "hits" , hits );
+        bb.appendNumber( "misses" , misses );
 
-        bb.append( "resets" , _resets );
+        bb.append( "resets" , _resets.load() );
 
-        bb.append( "missRatio" , (_btreeAccesses ? (_btreeMemMisses / (double)_btreeAccesses) : 0) );
+        bb.append( "missRatio" , (accesses ? (misses / (double)accesses) : 0) );
 
-        return bb.obj();        
+        return bb.obj();
     }
 
     void IndexCounters::_roll() {
-        _btreeAccesses = 0;
-        _btreeMemMisses = 0;
-        _btreeMemHits = 0;
-        _resets++;
+        _btreeAccesses.store( 0 );
+        _btreeMemMisses.store( 0 );
+        _btreeMemHits.store( 0 );
+        _resets.fetchAndAdd( 1 );
     }
 
     IndexCounters* globalIndexCounters = NULL;
@@ -33,6 +33,7 @@
 
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/db/storage/record.h"
 #include "mongo/util/processinfo.h"
 
@@ -49,37 +50,36 @@ namespace mongo {
         virtual BSONObj generateSection(const BSONElement& configElement) const;
 
 
-        // used without a mutex intentionally (can race)
         void btree( const char* node ) {
             if ( ! _memSupported )
                 return;
             btree( Record::likelyInPhysicalMemory( node ) );
         }
 
-        void btree( bool memHit ) {
-            if ( memHit )
-                _btreeMemHits++;
-            else
-                _btreeMemMisses++;
-            if ( _btreeAccesses++ > _maxAllowed )
-                _roll();
-
-        }
-        void btreeHit() { _btreeMemHits++; _btreeAccesses++; }
-        void btreeMiss() { _btreeMemMisses++; _btreeAccesses++; }
+        /**
+         * Bumps a per-thread write-combining buffer; the shared counters are
+         * only touched when the buffer fills, so every bucket access doesn't
+         * bounce one cache line between all reader/writer threads.
+         */
+        void btree( bool memHit );
+        void btreeHit() { btree( true ); }
+        void btreeMiss() { btree( false ); }
 
     private:
-        
+
+        // folds a thread's buffered counts into the shared counters
+        void _flush( long long hits, long long misses );
+
         void _roll();
 
         bool _memSupported;
 
-        int _resets;
+        AtomicInt32 _resets;
         long long _maxAllowed;
 
-        long long _btreeMemMisses;
-        long long _btreeMemHits;
-        long long _btreeAccesses;
+        AtomicInt64 _btreeMemMisses;
+        AtomicInt64 _btreeMemHits;
+        AtomicInt64 _btreeAccesses;
     };
 
     extern IndexCounters* globalIndexCounters;
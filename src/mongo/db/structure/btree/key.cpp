@@ -533,21 +533,19 @@ namespace mongo {
         return L.woCompare(R, order, /*considerfieldname*/false);
     }
 
-    int KeyV1::woCompare(const KeyV1& right, const Ordering &order) const {
-        const unsigned char *l = _keyData;
-        const unsigned char *r = right._keyData;
-
-        if( (*l|*r) == IsBSON ) // only can do this if cNOTUSED maintained
-            return compareHybrid(right, order);
-
+    // the anyDescending=false instantiation carries no direction mask at all;
+    // as ascending indexes are the overwhelmingly common case this strips the
+    // per-field direction test and mask shift out of the btree search loop.
+    template< bool anyDescending >
+    static int compareCompact(const unsigned char *l, const unsigned char *r, const Ordering &order) {
         unsigned mask = 1;
-        while( 1 ) { 
-            char lval = *l; 
+        while( 1 ) {
+            char lval = *l;
             char rval = *r;
             {
                 int x = compare(l, r); // updates l and r pointers
                 if( x ) {
-                    if( order.descending(mask) )
+                    if( anyDescending && order.descending(mask) )
                         x = -x;
                     return x;
                 }
@@ -555,18 +553,33 @@ namespace mongo {
 
             {
                 int x = ((int)(lval & cHASMORE)) - ((int)(rval & cHASMORE));
-                if( x ) 
+                if( x )
                     return x;
                 if( (lval & cHASMORE) == 0 )
                     break;
             }
 
-            mask <<= 1;
+            if( anyDescending )
+                mask <<= 1;
         }
 
         return 0;
     }
 
+    int KeyV1::woCompare(const KeyV1& right, const Ordering &order) const {
+        const unsigned char *l = _keyData;
+        const unsigned char *r = right._keyData;
+
+        if( (*l|*r) == IsBSON ) // only can do this if cNOTUSED maintained
+            return compareHybrid(right, order);
+
+        // one well-predicted branch on the precomputed direction bits selects
+        // the specialized loop
+        if( order.allAscending() )
+            return compareCompact<false>(l, r, order);
+        return compareCompact<true>(l, r, order);
+    }
+
     static unsigned sizes[] = {
         0,
         1, //cminkey=1,
@@ -0,0 +1,373 @@
+// ordered_key.cpp
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/structure/btree/ordered_key.h"
+
+#include "mongo/bson/util/builder.h"
+#include "mongo/util/startup_test.h"
+
+namespace mongo {
+
+    /* Format, per field of the key, in key pattern order:
+
+         1 type byte, chosen so the bytes sort in canonicalizeBSONType() order,
+         then a type-specific payload:
+
+           minkey, null, maxkey   nothing
+           false, true            nothing (two type bytes)
+           numeric                8 bytes: the value as a double, big-endian,
+                                  sign bit flipped for >= 0 and all bits
+                                  flipped for < 0 so the bytes sort like the
+                                  double; then 1 byte telling the original
+                                  type (int/long/double) so ties between
+                                  e.g. int 5 and double 5.0 break
+                                  deterministically and decode is exact
+           string                 the utf8 bytes with 0x00 escaped as
+                                  0x00 0xff, then 0x00 0x00.  the two-byte
+                                  terminator sorts below any continuation in
+                                  both directions, so "foo" orders before
+                                  "foo\0x" (and after it when descending)
+                                  without relying on a buffer-length rule
+           oid                    the 12 bytes as stored
+           date                   8 bytes: millis as a signed value, offset
+                                  by 2^63, big-endian
+
+         For a field that is descending in the Ordering every byte of the
+         field (type byte included) is xor'ed with 0xff, which exactly
+         reverses the memcmp order of that field.
+
+         Because every field encoding is self-delimiting and injective, two
+         different keys always differ within the shorter encoding's length;
+         the length tiebreak in compareOrderedKeys only distinguishes a key
+         from an extension of itself, which cannot occur within one index
+         (all keys of an index have the key pattern's field count).
+       */
+
+    namespace {
+
+        // type bytes in canonicalizeBSONType() order.  must be > 0x00 and
+        // < 0xff so the string escape/terminator bytes order correctly
+        // against a following field in both directions.
+        const unsigned char cdMinKey  = 0x04;
+        const unsigned char cdNull    = 0x08;
+        const unsigned char cdNumeric = 0x10;
+        const unsigned char cdString  = 0x18;
+        const unsigned char cdOID     = 0x28;
+        const unsigned char cdFalse   = 0x30;
+        const unsigned char cdTrue    = 0x31;
+        const unsigned char cdDate    = 0x38;
+        const unsigned char cdMaxKey  = 0xf0;
+
+        // trailing numeric type byte
+        const unsigned char cdnInt    = 1;
+        const unsigned char cdnLong   = 2;
+        const unsigned char cdnDouble = 3;
+
+        // largest long long a double represents exactly; longs beyond this
+        // are not encodable (they would collide with or misorder against
+        // nearby doubles)
+        const long long cdMaxExactLong = 9007199254740992LL; // 2^53
+
+        void appendByte(BufBuilder& out, unsigned char c, unsigned char x) {
+            out.appendChar(c ^ x);
+        }
+
+        void appendBE64(BufBuilder& out, unsigned long long v, unsigned char x) {
+            for (int shift = 56; shift >= 0; shift -= 8)
+                out.appendChar((unsigned char)(v >> shift) ^ x);
+        }
+
+        unsigned long long readBE64(const unsigned char*& p, unsigned char x) {
+            unsigned long long v = 0;
+            for (int i = 0; i < 8; i++)
+                v = (v << 8) | (unsigned char)(*p++ ^ x);
+            return v;
+        }
+    }
+
+    bool encodeOrderedKey(const BSONObj& key, const Ordering& ord, BufBuilder& out) {
+        unsigned mask = 1;
+        BSONObjIterator it(key);
+        while (it.more()) {
+            BSONElement e = it.next();
+            const unsigned char x = ord.descending(mask) ? 0xff : 0x00;
+            switch (e.type()) {
+            case MinKey:
+                appendByte(out, cdMinKey, x);
+                break;
+            case jstNULL:
+                appendByte(out, cdNull, x);
+                break;
+            case NumberInt:
+            case NumberLong:
+            case NumberDouble: {
+                double d;
+                unsigned char nt;
+                if (e.type() == NumberInt) {
+                    d = e._numberInt();
+                    nt = cdnInt;
+                }
+                else if (e.type() == NumberLong) {
+                    long long v = e._numberLong();
+                    if (v < -cdMaxExactLong || v > cdMaxExactLong)
+                        return false;
+                    d = (double)v;
+                    nt = cdnLong;
+                }
+                else {
+                    d = e._numberDouble();
+                    if (d != d) // NaN sorts below all numbers; no byte string does that
+                        return false;
+                    nt = cdnDouble;
+                }
+                unsigned long long bits;
+                memcpy(&bits, &d, 8);
+                if (bits & (1ULL << 63))
+                    bits = ~bits;
+                else
+                    bits ^= (1ULL << 63);
+                appendByte(out, cdNumeric, x);
+                appendBE64(out, bits, x);
+                appendByte(out, nt, x);
+                break;
+            }
+            case String: {
+                appendByte(out, cdString, x);
+                const char* s = e.valuestr();
+                int len = e.valuestrsize() - 1; // drop the trailing 0; embedded 0s stay
+                for (int i = 0; i < len; i++) {
+                    if (s[i] == 0) {
+                        appendByte(out, 0x00, x);
+                        appendByte(out, 0xff, x);
+                    }
+                    else {
+                        appendByte(out, s[i], x);
+                    }
+                }
+                appendByte(out, 0x00, x);
+                appendByte(out, 0x00, x);
+                break;
+            }
+            case jstOID: {
+                appendByte(out, cdOID, x);
+                const char* p = e.value();
+                for (int i = 0; i < OID::kOIDSize; i++)
+                    appendByte(out, p[i], x);
+                break;
+            }
+            case Bool:
+                appendByte(out, e.boolean() ? cdTrue : cdFalse, x);
+                break;
+            case Date:
+                appendByte(out, cdDate, x);
+                // dates compare as signed millis; the offset makes that unsigned
+                appendBE64(out, (unsigned long long)e.date().millis ^ (1ULL << 63), x);
+                break;
+            case MaxKey:
+                appendByte(out, cdMaxKey, x);
+                break;
+            default:
+                // object, array, bindata, regex, code, symbol, timestamp, undefined
+                return false;
+            }
+            mask <<= 1;
+        }
+        return true;
+    }
+
+    BSONObj decodeOrderedKey(const char* data, int len, const Ordering& ord) {
+        BSONObjBuilder b;
+        const unsigned char* p = (const unsigned char*)data;
+        const unsigned char* end = p + len;
+        unsigned mask = 1;
+        while (p < end) {
+            const unsigned char x = ord.descending(mask) ? 0xff : 0x00;
+            const unsigned char t = *p++ ^ x;
+            switch (t) {
+            case cdMinKey:
+                b.appendMinKey("");
+                break;
+            case cdNull:
+                b.appendNull("");
+                break;
+            case cdNumeric: {
+                massert(17469, "bad ordered key", end - p >= 9);
+                unsigned long long bits = readBE64(p, x);
+                if (bits & (1ULL << 63))
+                    bits ^= (1ULL << 63);
+                else
+                    bits = ~bits;
+                double d;
+                memcpy(&d, &bits, 8);
+                const unsigned char nt = *p++ ^ x;
+                if (nt == cdnInt)
+                    b.append("", (int)d);
+                else if (nt == cdnLong)
+                    b.append("", (long long)d);
+                else {
+                    massert(17470, "bad ordered key", nt == cdnDouble);
+                    b.append("", d);
+                }
+                break;
+            }
+            case cdString: {
+                StringBuilder s;
+                while (1) {
+                    massert(17471, "bad ordered key", p < end);
+                    const unsigned char c = *p++ ^ x;
+                    if (c != 0) {
+                        s << (char)c;
+                        continue;
+                    }
+                    massert(17472, "bad ordered key", p < end);
+                    const unsigned char c2 = *p++ ^ x;
+                    if (c2 == 0)
+                        break;            // terminator
+                    massert(17473, "bad ordered key", c2 == 0xff);
+                    s << '\0';            // escaped zero
+                }
+                b.append("", s.str());
+                break;
+            }
+            case cdOID: {
+                massert(17474, "bad ordered key", end - p >= OID::kOIDSize);
+                unsigned char raw[OID::kOIDSize];
+                for (int i = 0; i < OID::kOIDSize; i++)
+                    raw[i] = *p++ ^ x;
+                OID oid(raw);
+                b.appendOID("", &oid);
+                break;
+            }
+            case cdFalse:
+                b.appendBool("", false);
+                break;
+            case cdTrue:
+                b.appendBool("", true);
+                break;
+            case cdDate:
+                massert(17475, "bad ordered key", end - p >= 8);
+                b.appendDate("", Date_t(readBE64(p, x) ^ (1ULL << 63)));
+                break;
+            case cdMaxKey:
+                b.appendMaxKey("");
+                break;
+            default:
+                msgasserted(17476, "bad ordered key type byte");
+            }
+            mask <<= 1;
+        }
+        return b.obj();
+    }
+
+    int compareOrderedKeys(const char* l, int llen, const char* r, int rlen) {
+        int common = std::min(llen, rlen);
+        int x = memcmp(l, r, common);
+        if (x)
+            return x;
+        return llen - rlen;
+    }
+
+    struct OrderedKeyUnitTest : public StartupTest {
+        static BufBuilder& enc(BufBuilder& b, const BSONObj& o, const Ordering& ord) {
+            b.reset();
+            verify(encodeOrderedKey(o, ord, b));
+            return b;
+        }
+        void check(const BSONObj& smaller, const BSONObj& bigger, const Ordering& ord) {
+            BufBuilder bs(64), bb(64);
+            enc(bs, smaller, ord);
+            enc(bb, bigger, ord);
+            int w = smaller.woCompare(bigger, ord, false);
+            int m = compareOrderedKeys(bs.buf(), bs.len(), bb.buf(), bb.len());
+            // w == 0 with m != 0 is fine: that's the numeric type tiebreak
+            verify(w >= 0 || m < 0);
+            verify(w <= 0 || m > 0);
+            // decode must round-trip exactly
+            verify(decodeOrderedKey(bs.buf(), bs.len(), ord).binaryEqual(smaller));
+            verify(decodeOrderedKey(bb.buf(), bb.len(), ord).binaryEqual(bigger));
+        }
+        void run() {
+            const Ordering asc = Ordering::make(BSON("a" << 1 << "b" << 1));
+            const Ordering desc = Ordering::make(BSON("a" << -1 << "b" << -1));
+            const Ordering mixed = Ordering::make(BSON("a" << 1 << "b" << -1));
+
+            BSONObj keys[] = {
+                BSON("" << MINKEY),
+                BSON("" << BSONNULL),
+                BSON("" << -numeric_limits<double>::infinity()),
+                BSON("" << -3.7),
+                BSON("" << 0),
+                BSON("" << 0.0),
+                BSON("" << 3),
+                BSON("" << 3LL),
+                BSON("" << 3.0),
+                BSON("" << 3.5),
+                BSON("" << numeric_limits<double>::infinity()),
+                BSON("" << ""),
+                BSON("" << "ab"),
+                BSONObjBuilder().append("", StringData("ab\0q", 4)).obj(), // embedded zero
+                BSON("" << "abc"),
+                BSON("" << OID("000000000000000000000001")),
+                BSON("" << false),
+                BSON("" << true),
+                BSON("" << Date_t(0)),
+                BSON("" << Date_t(12345)),
+                BSON("" << MAXKEY),
+            };
+            const int n = sizeof(keys) / sizeof(keys[0]);
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    check(keys[i], keys[j], asc);
+                    check(keys[i], keys[j], desc);
+                    // compound, exercising the field boundary
+                    for (int k = 0; k < n; k += 5) {
+                        BSONObjBuilder l, r;
+                        l.appendAs(keys[i].firstElement(), "");
+                        l.appendAs(keys[k].firstElement(), "");
+                        r.appendAs(keys[j].firstElement(), "");
+                        r.appendAs(keys[(k + 5) % n].firstElement(), "");
+                        check(l.obj(), r.obj(), mixed);
+                    }
+                }
+            }
+
+            // things that must refuse to encode
+            BufBuilder b(64);
+            verify(!encodeOrderedKey(BSON("" << BSON("a" << 1)), asc, b));
+            b.reset();
+            verify(!encodeOrderedKey(BSON("" << numeric_limits<double>::quiet_NaN()), asc, b));
+            b.reset();
+            verify(!encodeOrderedKey(BSON("" << (cdMaxExactLong * 4)), asc, b));
+        }
+    } orderedKeyUnitTest;
+
+}
@@ -0,0 +1,70 @@
+// ordered_key.h
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/bson/ordering.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /** An order-preserving byte-string encoding of index keys: for any two
+        encodable keys x and y,
+            sign( compareOrderedKeys(enc(x), enc(y)) ) == sign( x.woCompare(y, ord, false) )
+        so keys can be encoded once and then compared with a plain memcmp,
+        which is much cheaper than decoding both sides field by field the way
+        KeyV1::woCompare does.
+
+        Only "simple" field types are encodable: MinKey, MaxKey, Null, the
+        numerics (excluding NaN and NumberLongs beyond 2^53), String, OID,
+        Bool and Date.  encodeOrderedKey() returns false for anything else
+        (objects, arrays, bindata, regex, code, symbol, timestamp, ...) and
+        the caller must fall back to regular woCompare for that key.
+
+        Ties between equal values of different numeric types (e.g. int 5 vs
+        double 5.0) are broken by a trailing type byte; that refinement is
+        harmless for sorting and lets decodeOrderedKey() reproduce the
+        original key exactly.
+    */
+
+    /** append the encoding of 'key' (field names ignored) to 'out'.
+        @return false if the key contains an unencodable field; 'out' may then
+                hold a partial encoding and should be discarded. */
+    bool encodeOrderedKey(const BSONObj& key, const Ordering& ord, BufBuilder& out);
+
+    /** rebuild the original key (with empty field names, as btree keys are
+        stored) from bytes produced by encodeOrderedKey with the same 'ord'. */
+    BSONObj decodeOrderedKey(const char* data, int len, const Ordering& ord);
+
+    /** memcmp, then shorter-is-smaller.  the length rule only fires for
+        encodings of different keys, see ordered_key.cpp. */
+    int compareOrderedKeys(const char* l, int llen, const char* r, int rlen);
+
+}
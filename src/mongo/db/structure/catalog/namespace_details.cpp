@@ -245,6 +245,51 @@ namespace mongo {
     */
     DiskLoc NamespaceDetails::__stdAlloc(int len, bool peekOnly) {
         freelistAllocs.increment();
+
+        {
+            // Requests for exactly a bucket boundary - which is every request
+            // from a power of two sized collection, since those quantize to
+            // the boundaries - can skip the best-fit scan: a record in bucket
+            // i is at least bucketSizes[i - 1] long, so every record in the
+            // request's bucket and above fits and we just pop the first
+            // non-empty head.  alloc() splits off whatever we don't need.
+            const int firstBucket = bucket(len);
+            if ( firstBucket > 0 && len == bucketSizes[firstBucket - 1] ) {
+                for ( int b = firstBucket; b <= MaxBucket; b++ ) {
+                    DiskLoc head = _deletedList[b];
+                    if ( head.isNull() )
+                        continue;
+
+                    { // defensive check, as below
+                        if ( head.a() < -1 || head.a() >= 100000 || head.getOfs() < 0 ) {
+                            StringBuilder sb;
+                            sb << "Deleted record list corrupted in bucket " << b
+                               << ", invalid head is " << head.toString()
+                               << ", throwing Fatal Assertion";
+                            problem() << sb.str() << endl;
+                            fassertFailed(17431);
+                        }
+                    }
+
+                    DeletedRecord* r = head.drec();
+                    if ( r->lengthWithHeaders() < len ) {
+                        // bucket invariant violated (older data files);
+                        // let the scan below sort it out
+                        break;
+                    }
+
+                    if ( !peekOnly ) {
+                        *getDur().writing( &_deletedList[b] ) = r->nextDeleted();
+                        r->nextDeleted().writing().setInvalid(); // defensive.
+                        verify( r->extentOfs() < head.getOfs() );
+                    }
+
+                    freelistIterations.increment( 1 + ( b - firstBucket ) );
+                    return head;
+                }
+            }
+        }
+
         DiskLoc *prev;
         DiskLoc *bestprev = 0;
         DiskLoc bestmatch;
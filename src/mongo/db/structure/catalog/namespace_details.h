@@ -249,7 +249,17 @@ namespace mongo {
         };
 
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+
+            // Store snappy-compressed record bodies (see db/storage/record_compression.h).
+            // Only affects records written after the flag is set; compressed and plain
+            // records can coexist.
+            Flag_CompressRecords = 1 << 1,
+
+            // Cache complete query replies for this collection (see
+            // db/query/query_result_cache.h).  Any write invalidates the cache, so
+            // only worthwhile for read-mostly collections.
+            Flag_ResultCache = 1 << 2
         };
 
         IndexDetails& idx(int idxNo, bool missingExpected = false );
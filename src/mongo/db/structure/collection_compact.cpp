@@ -200,6 +200,29 @@ namespace mongo {
 
     }
 
+    StatusWith<DiskLoc> Collection::relocateDocument( const DiskLoc& oldLocation ) {
+
+        BSONObj objOld = docFor( oldLocation );
+
+        // Same dance as a too-big-to-fit update: unindex the old record but
+        // don't delete it yet, so a failed insert can put the indexes back.
+        _cursorCache.invalidateDocument( oldLocation, INVALIDATION_DELETION );
+        _indexCatalog.unindexRecord( objOld, oldLocation, true );
+
+        StatusWith<DiskLoc> loc = _insertDocument( objOld, false );
+
+        if ( loc.isOK() ) {
+            // insert successful, deallocate the old location; it is already unindexed
+            _recordStore->deleteRecord( oldLocation );
+        }
+        else {
+            // couldn't insert the copy, so put the old document back in its indexes
+            _indexCatalog.indexRecord( objOld, oldLocation );
+        }
+
+        return loc;
+    }
+
     BSONObj _compactAdjustIndexSpec( const BSONObj& oldSpec ) {
         BSONObjBuilder b;
         BSONObj::iterator i( oldSpec );
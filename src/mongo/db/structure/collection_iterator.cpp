@@ -35,14 +35,58 @@
 
 namespace mongo {
 
+    //
+    // Shared scan coordination
+    //
+
+    SharedScanCoordinator::SharedScanCoordinator()
+        : _mutex( "SharedScanCoordinator" ) {
+    }
+
+    DiskLoc SharedScanCoordinator::join( const FlatIterator* scan ) {
+        SimpleMutex::scoped_lock lk( _mutex );
+
+        // Join the sweep of any scan that has published a position; if several are
+        // active they converged on one window long ago.
+        DiskLoc joinAt;
+        for ( PositionMap::const_iterator it = _positions.begin();
+              it != _positions.end(); ++it ) {
+            if ( !it->second.isNull() ) {
+                joinAt = it->second;
+                break;
+            }
+        }
+
+        _positions[ scan ] = DiskLoc();
+        return joinAt;
+    }
+
+    void SharedScanCoordinator::publish( const FlatIterator* scan, const DiskLoc& extentLoc ) {
+        SimpleMutex::scoped_lock lk( _mutex );
+        PositionMap::iterator it = _positions.find( scan );
+        dassert( it != _positions.end() );
+        if ( it != _positions.end() ) {
+            it->second = extentLoc;
+        }
+    }
+
+    void SharedScanCoordinator::leave( const FlatIterator* scan ) {
+        SimpleMutex::scoped_lock lk( _mutex );
+        _positions.erase( scan );
+    }
+
     //
     // Regular / non-capped collection traversal
     //
 
     FlatIterator::FlatIterator(const Collection* collection,
                                const DiskLoc& start,
-                               const CollectionScanParams::Direction& dir)
-        : _curr(start), _collection(collection), _direction(dir) {
+                               const CollectionScanParams::Direction& dir,
+                               bool adviseDontNeed,
+                               bool cooperative)
+        : _curr(start), _collection(collection), _direction(dir),
+          _adviseDontNeed(adviseDontNeed), _advisedExtentLength(0),
+          _sharedScan(false), _wrapped(false) {
 
         if (_curr.isNull()) {
 
@@ -53,17 +97,36 @@ namespace mongo {
                 verify( _collection->_details->lastExtent().isNull() );
             }
             else if (CollectionScanParams::FORWARD == _direction) {
+                _curr = _firstRecord();
+
+                if (cooperative) {
+                    // Attach to the sweep another scan has in flight, if any: start at
+                    // the extent it is currently faulting in and wrap around at the end
+                    // to pick up what we skipped.
+                    _sharedScan = true;
+                    DiskLoc joinExtent = _collection->sharedScanCoordinator()->join( this );
+
+                    if (!joinExtent.isNull()) {
+                        // Start with the first record in that extent, skipping forward
+                        // over empty extents just as a scan from the beginning would.
+                        Extent* e = em->getExtent( joinExtent );
+                        while (e->firstRecord.isNull() && !e->xnext.isNull()) {
+                            e = em->getNextExtent( e );
+                        }
+
+                        if (!e->firstRecord.isNull()) {
+                            _curr = e->firstRecord;
+                            _joinExtent = em->extentLocFor( _curr );
+                        }
+                        // else: nothing at or after the published position; start at the
+                        // beginning as usual (no wrap-around leg).
+                    }
 
-                // Find a non-empty extent and start with the first record in it.
-                Extent* e = em->getExtent( _collection->_details->firstExtent() );
-
-                while (e->firstRecord.isNull() && !e->xnext.isNull()) {
-                    e = em->getNextExtent( e );
+                    if (!_curr.isNull()) {
+                        _publishedExtent = em->extentLocFor( _curr );
+                        _collection->sharedScanCoordinator()->publish( this, _publishedExtent );
+                    }
                 }
-
-                // _curr may be set to DiskLoc() here if e->lastRecord isNull but there is no
-                // valid e->xnext
-                _curr = e->firstRecord;
             }
             else {
                 // Walk backwards, skipping empty extents, and use the last record in the first
@@ -83,10 +146,30 @@ namespace mongo {
         }
     }
 
+    FlatIterator::~FlatIterator() {
+        if (_sharedScan) {
+            _collection->sharedScanCoordinator()->leave( this );
+        }
+    }
+
     bool FlatIterator::isEOF() {
         return _curr.isNull();
     }
 
+    DiskLoc FlatIterator::_firstRecord() const {
+        const ExtentManager* em = _collection->getExtentManager();
+
+        // Find a non-empty extent and start with the first record in it.
+        Extent* e = em->getExtent( _collection->_details->firstExtent() );
+
+        while (e->firstRecord.isNull() && !e->xnext.isNull()) {
+            e = em->getNextExtent( e );
+        }
+
+        // May be DiskLoc() if e->firstRecord isNull but there is no valid e->xnext
+        return e->firstRecord;
+    }
+
     DiskLoc FlatIterator::getNext() {
         DiskLoc ret = _curr;
 
@@ -98,11 +181,110 @@ namespace mongo {
             else {
                 _curr = _collection->getExtentManager()->getPrevRecord( _curr );
             }
+
+            if (_sharedScan) {
+                _cooperativeAdvanced();
+            }
+
+            if (_adviseDontNeed) {
+                _adviseScanned( ret );
+                if (_curr.isNull()) {
+                    // The scan is done; let go of the last extent too.
+                    _releaseAdvisedExtent();
+                }
+            }
         }
 
         return ret;
     }
 
+    void FlatIterator::_cooperativeAdvanced() {
+        const ExtentManager* em = _collection->getExtentManager();
+
+        bool justWrapped = false;
+        if (_curr.isNull() && !_wrapped && !_joinExtent.isNull()) {
+            // We joined the sweep partway through the collection and just ran off the
+            // end; wrap to the beginning to cover the part we skipped.
+            _wrapped = true;
+            justWrapped = true;
+            _curr = _firstRecord();
+        }
+
+        if (_curr.isNull()) {
+            return;
+        }
+
+        DiskLoc extentLoc = em->extentLocFor( _curr );
+
+        if (_wrapped) {
+            // The wrap-around leg ends at the extent where we joined.  We cannot wait
+            // for _curr to land on a record inside it: deletes while the scan was
+            // yielded can empty the join extent (which stays linked in the chain),
+            // making record traversal hop straight over it -- and then the leg would
+            // run on and re-emit everything from the join point to the end.  Instead,
+            // on each extent crossing walk the chain from where the leg just was and
+            // end the leg as soon as the join extent comes at or before the extent we
+            // landed in.
+            DiskLoc from = justWrapped ? _collection->_details->firstExtent()
+                                       : _publishedExtent;
+            if ((justWrapped || extentLoc != _publishedExtent) &&
+                _wrapLegPassedJoin( from, extentLoc )) {
+                _curr = DiskLoc();
+                return;
+            }
+        }
+
+        if (extentLoc != _publishedExtent) {
+            _publishedExtent = extentLoc;
+            _collection->sharedScanCoordinator()->publish( this, extentLoc );
+        }
+    }
+
+    bool FlatIterator::_wrapLegPassedJoin( const DiskLoc& from, const DiskLoc& currExtent ) const {
+        const ExtentManager* em = _collection->getExtentManager();
+
+        DiskLoc e = from;
+        while ( !e.isNull() ) {
+            if ( e == _joinExtent )
+                return true;
+            if ( e == currExtent )
+                return false;
+            e = em->getExtent( e )->xnext;
+        }
+
+        // Ran off the chain without meeting either extent; the join extent can only
+        // be behind the leg, so treat it as passed rather than re-emit the tail.
+        return true;
+    }
+
+    void FlatIterator::_adviseScanned(const DiskLoc& loc) {
+        const ExtentManager* em = _collection->getExtentManager();
+
+        DiskLoc extentLoc = em->extentLocFor( loc );
+        if (extentLoc == _advisedExtent) {
+            return;
+        }
+
+        // We crossed into a new extent; everything in the old one is behind the scan now.
+        _releaseAdvisedExtent();
+
+        Extent* e = em->getExtent( extentLoc );
+        _advisedExtent = extentLoc;
+        _advisedExtentLength = e->length;
+        _advisedSequential.reset( new MAdvise( e, e->length, MAdvise::Sequential ) );
+    }
+
+    void FlatIterator::_releaseAdvisedExtent() {
+        if (_advisedExtent.isNull()) {
+            return;
+        }
+
+        _advisedSequential.reset();  // back to MADV_NORMAL
+        _collection->getExtentManager()->dontNeedRange( _advisedExtent, _advisedExtentLength );
+        _advisedExtent = DiskLoc();
+        _advisedExtentLength = 0;
+    }
+
     void FlatIterator::invalidate(const DiskLoc& dl) {
         verify( _collection->ok() );
 
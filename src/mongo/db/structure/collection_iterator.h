@@ -28,15 +28,63 @@
 
 #pragma once
 
+#include <map>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/base/disallow_copying.h"
 #include "mongo/db/exec/collection_scan_common.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/mmap.h"
 
 namespace mongo {
 
     class Collection;
     class DiskLoc;
     class ExtentManager;
+    class FlatIterator;
     class NamespaceDetails;
 
+    /**
+     * Lets concurrent full scans of one collection share a single physical extent
+     * sweep instead of each faulting the same extents in different phases.
+     * Participating scans publish the extent they are currently walking; a new
+     * full forward scan joins at a published extent -- consuming the window of
+     * pages an earlier scan just faulted in -- and wraps around at the end of
+     * the collection to cover the part it skipped.  See
+     * CollectionScanParams::cooperative.
+     *
+     * One per Collection.  Thread safe: scans of one collection proceed in
+     * parallel under the shared database read lock.  Positions are published
+     * per extent crossed, not per record, so the mutex is barely contended.
+     */
+    class SharedScanCoordinator {
+        MONGO_DISALLOW_COPYING(SharedScanCoordinator);
+    public:
+        SharedScanCoordinator();
+
+        /**
+         * Registers 'scan' as a participating full forward scan.
+         * @return the extent some other participating scan is currently
+         *   walking, to join the sweep at, or DiskLoc() if there is none and
+         *   the new scan should start at the beginning.
+         */
+        DiskLoc join( const FlatIterator* scan );
+
+        /** Called by a participating scan when it crosses into a new extent. */
+        void publish( const FlatIterator* scan, const DiskLoc& extentLoc );
+
+        /** Unregisters 'scan'; must be called before the scan goes away. */
+        void leave( const FlatIterator* scan );
+
+    private:
+        SimpleMutex _mutex;
+
+        // Extent each participating scan is currently walking.
+        typedef std::map<const FlatIterator*, DiskLoc> PositionMap;
+        PositionMap _positions;
+    };
+
     /**
      * A CollectionIterator provides an interface for walking over a collection.
      * The details of navigating the collection's structure are below this interface.
@@ -67,12 +115,24 @@ namespace mongo {
      * The collection must exist when the constructor is called.
      *
      * If start is not DiskLoc(), the iteration begins at that DiskLoc.
+     *
+     * If adviseDontNeed is true, the iterator tells the OS that pages behind the scan are
+     * not needed again soon, so a cold scan does not evict the hot working set.  See
+     * CollectionScanParams::adviseDontNeed.  (Don't combine with cooperative -- releasing
+     * pages behind the sweep defeats the sharing.)
+     *
+     * If cooperative is true and this is a full forward scan, the iterator takes part in
+     * the collection's SharedScanCoordinator: it may begin partway through the collection,
+     * at the extent another scan is walking, and wrap around at the end.  Every record is
+     * still returned exactly once, but not in natural order.
      */
     class FlatIterator : public CollectionIterator {
     public:
         FlatIterator(const Collection* collection, const DiskLoc& start,
-                     const CollectionScanParams::Direction& dir);
-        virtual ~FlatIterator() { }
+                     const CollectionScanParams::Direction& dir,
+                     bool adviseDontNeed = false,
+                     bool cooperative = false);
+        virtual ~FlatIterator();
 
         virtual bool isEOF();
         virtual DiskLoc getNext();
@@ -82,12 +142,68 @@ namespace mongo {
         virtual bool recoverFromYield();
 
     private:
+        /**
+         * Track which extent the just-returned record lives in; when the scan crosses an
+         * extent boundary, release the pages of the extent it left.
+         */
+        void _adviseScanned(const DiskLoc& loc);
+
+        /**
+         * Drop the MADV_SEQUENTIAL advice on the current extent and tell the OS its pages
+         * will not be needed again.
+         */
+        void _releaseAdvisedExtent();
+
+        /**
+         * First record of the first non-empty extent -- where a forward scan from the
+         * beginning starts.  DiskLoc() if the collection is empty.
+         */
+        DiskLoc _firstRecord() const;
+
+        /**
+         * Shared-scan bookkeeping after _curr has been advanced: wrap around at the end
+         * if we joined partway through, stop once the wrap reaches the join extent, and
+         * publish our position when we cross into a new extent.
+         */
+        void _cooperativeAdvanced();
+
+        /**
+         * Whether the wrap-around leg, having just crossed from extent 'from' into
+         * 'currExtent', reached or skipped over the extent where it joined the sweep.
+         * Walks the xnext chain so a join extent emptied by deletes -- which record
+         * traversal hops straight over -- still ends the leg.
+         */
+        bool _wrapLegPassedJoin(const DiskLoc& from, const DiskLoc& currExtent) const;
+
         // The result returned on the next call to getNext().
         DiskLoc _curr;
 
         const Collection* _collection;
 
         CollectionScanParams::Direction _direction;
+
+        // True if we should advise the OS to reclaim pages behind the scan.
+        bool _adviseDontNeed;
+
+        // The extent the scan is currently inside, kept under MADV_SEQUENTIAL while we walk
+        // it.  Only maintained when _adviseDontNeed is set.
+        DiskLoc _advisedExtent;
+        int _advisedExtentLength;
+        boost::scoped_ptr<MAdvise> _advisedSequential;
+
+        // True if we registered with the collection's SharedScanCoordinator; we must
+        // leave() it on destruction.
+        bool _sharedScan;
+
+        // The extent we joined another scan's sweep at, or isNull() if we started at the
+        // beginning.  The wrap-around leg ends when it reaches this extent again.
+        DiskLoc _joinExtent;
+
+        // True once we have wrapped from the end of the collection to the beginning.
+        bool _wrapped;
+
+        // Last extent we published to the coordinator.
+        DiskLoc _publishedExtent;
     };
 
     /**
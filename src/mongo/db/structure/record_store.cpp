@@ -188,11 +188,21 @@ namespace mongo {
 
     // -------------------------------
 
+    // predictive extent preallocation: only bother for collections sustaining
+    // at least this insert rate, and grow when the newest extent looks like it
+    // will fill within this many seconds
+    static const double minForecastBytesPerSec = 256 * 1024;
+    static const int forecastSeconds = 2;
+
     SimpleRecordStoreV1::SimpleRecordStoreV1( const StringData& ns,
                                               NamespaceDetails* details,
                                               ExtentManager* em,
                                               bool isSystemIndexes )
-        : RecordStoreV1Base( ns, details, em, isSystemIndexes ) {
+        : RecordStoreV1Base( ns, details, em, isSystemIndexes ),
+          _bytesSinceLastExtent( 0 ),
+          _nextFileRequested( false ),
+          _bytesThisSample( 0 ),
+          _insertBytesPerSec( 0 ) {
     }
 
     SimpleRecordStoreV1::~SimpleRecordStoreV1() {
@@ -200,8 +210,10 @@ namespace mongo {
 
     StatusWith<DiskLoc> SimpleRecordStoreV1::allocRecord( int lengthWithHeaders, int quotaMax ) {
         DiskLoc loc = _details->alloc( NULL, _ns, lengthWithHeaders );
-        if ( !loc.isNull() )
+        if ( !loc.isNull() ) {
+            _forecastStorageNeeds( lengthWithHeaders, quotaMax );
             return StatusWith<DiskLoc>( loc );
+        }
 
         LOG(1) << "allocating new extent";
 
@@ -209,6 +221,8 @@ namespace mongo {
                                              Extent::followupSize( lengthWithHeaders,
                                                                    _details->lastExtentSize()),
                                              quotaMax );
+        _bytesSinceLastExtent = 0;
+        _nextFileRequested = false;
 
         loc = _details->alloc( NULL, _ns, lengthWithHeaders );
         if ( !loc.isNull() ) {
@@ -227,6 +241,8 @@ namespace mongo {
                                                  Extent::followupSize( lengthWithHeaders,
                                                                        _details->lastExtentSize()),
                                                  quotaMax );
+            _bytesSinceLastExtent = 0;
+            _nextFileRequested = false;
 
             loc = _details->alloc( NULL, _ns, lengthWithHeaders);
             if ( ! loc.isNull() )
@@ -236,6 +252,60 @@ namespace mongo {
         return StatusWith<DiskLoc>( ErrorCodes::InternalError, "cannot allocate space" );
     }
 
+    void SimpleRecordStoreV1::_forecastStorageNeeds( int justAllocated, int quotaMax ) {
+        _bytesSinceLastExtent += justAllocated;
+        _bytesThisSample += justAllocated;
+
+        int ms = _rateTimer.millis();
+        if ( ms >= 1000 ) {
+            double recent = _bytesThisSample * 1000.0 / ms;
+            // average with the previous estimate so a burst registers quickly
+            // but a single quiet second does not wipe the history
+            _insertBytesPerSec = ( _insertBytesPerSec + recent ) / 2;
+            _bytesThisSample = 0;
+            _rateTimer.reset();
+        }
+
+        if ( _insertBytesPerSec < minForecastBytesPerSec )
+            return;
+
+        // how much of the newest extent is still unwritten; alloc() may also
+        // be feeding from older deleted records, so this errs towards growing
+        // a bit early for churny collections
+        long long remaining = _details->lastExtentSize() - _bytesSinceLastExtent;
+        if ( remaining > _insertBytesPerSec * forecastSeconds )
+            return;
+
+        int followupSize = Extent::followupSize( justAllocated, _details->lastExtentSize() );
+
+        if ( _nextFileRequested ) {
+            // the file for the next extent is being zeroed in the background;
+            // when allocRecord() really runs out of room, addAFile() will find
+            // it on disk and just mmap it
+            return;
+        }
+
+        if ( _extentManager->preallocateFileForExtent( followupSize ) ) {
+            _nextFileRequested = true;
+            return;
+        }
+
+        // an open file already has room: link the next extent into the chain
+        // now, while this insert holds the write lock anyway, instead of
+        // making a later insert block on it
+        LOG(1) << "preallocating next extent for " << _ns
+               << " insertBytesPerSec: " << static_cast<long long>( _insertBytesPerSec )
+               << " lastExtentSize: " << _details->lastExtentSize();
+        try {
+            _extentManager->increaseStorageSize( _ns, _details, followupSize, quotaMax );
+            _bytesSinceLastExtent = 0;
+        }
+        catch ( const UserException& e ) {
+            // over quota; let the insert that actually runs out of room surface it
+            LOG(1) << "predictive extent allocation failed: " << e.what();
+        }
+    }
+
     // -------------------------------
 
     CappedRecordStoreV1::CappedRecordStoreV1( Collection* collection,
@@ -32,6 +32,7 @@
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -103,6 +104,27 @@ namespace mongo {
     protected:
         virtual StatusWith<DiskLoc> allocRecord( int lengthWithHeaders, int quotaMax );
 
+    private:
+        /**
+         * called after every successful alloc; tracks the collection's insert
+         * byte-rate and, when the newest extent looks like it will fill soon,
+         * allocates the next one ahead of need so no insert has to wait for
+         * file allocation
+         */
+        void _forecastStorageNeeds( int justAllocated, int quotaMax );
+
+        // bytes handed out by allocRecord() since the last extent was added;
+        // approximates how full the newest extent is
+        long long _bytesSinceLastExtent;
+
+        // true once we've asked for the next data file to be allocated in the
+        // background for the upcoming extent
+        bool _nextFileRequested;
+
+        // decayed insert-rate estimate, resampled roughly once a second
+        Timer _rateTimer;
+        long long _bytesThisSample;
+        double _insertBytesPerSec;
     };
 
     class CappedRecordStoreV1 : public RecordStoreV1Base {
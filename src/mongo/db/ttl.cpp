@@ -39,11 +39,14 @@
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/d_concurrency.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/lockstat.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/util/background.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -54,10 +57,34 @@ namespace mongo {
     ServerStatusMetricField<Counter64> ttlDeletedDocumentsDisplay("ttl.deletedDocuments", &ttlDeletedDocuments);
 
     MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorEnabled, bool, true );
-    
+
+    // Maximum documents deleted per write lock acquisition.  Expired documents
+    // beyond this are removed in further batches, with the lock released and a
+    // short pause in between, so a large expired backlog never produces one
+    // long write-lock convoy.  0 restores the old delete-everything-per-pass
+    // behavior.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlDeleteBatchSize, int, 1000 );
+    MONGO_EXPORT_SERVER_PARAMETER( ttlDeleteBatchPauseMillis, int, 10 );
+
+    namespace {
+        const int kMinTTLBatchSize = 64;
+
+        // fractions of the batch's wall time that other threads spent waiting
+        // to acquire locks, above/below which the live batch size shrinks or
+        // recovers (see _tuneBatchSize)
+        const double kHighLockWaitRatio = 0.5;
+        const double kLowLockWaitRatio = 0.1;
+
+        long long lockAcquireWaitMicros() {
+            LockStat* stat = Lock::globalLockStat();
+            return stat->getTimeAcquiring( 'R' ) + stat->getTimeAcquiring( 'W' ) +
+                   stat->getTimeAcquiring( 'r' ) + stat->getTimeAcquiring( 'w' );
+        }
+    }
+
     class TTLMonitor : public BackgroundJob {
     public:
-        TTLMonitor(){}
+        TTLMonitor() : _batchSize(0) {}
         virtual ~TTLMonitor(){}
 
         virtual string name() const { return "TTLMonitor"; }
@@ -108,41 +135,110 @@ namespace mongo {
 
                 LOG(1) << "TTL: " << key << " \t " << query << endl;
 
-                long long n = 0;
+                doTTLForIndex( idx["ns"].String(), key, query, isMaster );
+            }
+
+
+        }
+
+        /**
+         * Removes the documents of one TTL index matching query, walking the
+         * index in batches of at most _batchSize deletes.  The write lock is
+         * released between batches and the batch size adapts to observed lock
+         * contention, so expired backlogs drain continuously instead of in one
+         * long burst.
+         */
+        void doTTLForIndex( const string& ns,
+                            const BSONObj& key,
+                            const BSONObj& query,
+                            bool isMaster ) {
+            if ( _batchSize <= 0 )
+                _batchSize = std::max( ttlDeleteBatchSize, kMinTTLBatchSize );
+
+            long long n = 0;
+            bool firstBatch = true;
+            while ( ! inShutdown() ) {
+                const long long limit = ttlDeleteBatchSize > 0 ? _batchSize : 0;
+                const long long acquireWaitBefore = lockAcquireWaitMicros();
+                Timer batchTimer;
+                long long deleted = 0;
                 {
-                    string ns = idx["ns"].String();
                     Client::WriteContext ctx( ns );
                     Collection* collection = ctx.ctx().db()->getCollection( ns );
                     if ( !collection ) {
                         // collection was dropped
-                        continue;
+                        return;
                     }
 
-                    NamespaceDetails* nsd = collection->details();
-                    if ( nsd->setUserFlag( NamespaceDetails::Flag_UsePowerOf2Sizes ) ) {
-                        // TODO: wish there was a cleaner way to do this
-                        nsd->syncUserFlags( ns );
-                    }
+                    if ( firstBatch ) {
+                        firstBatch = false;
 
-                    // only do deletes if on master
-                    if ( ! isMaster ) {
-                        continue;
-                    }
+                        NamespaceDetails* nsd = collection->details();
+                        if ( nsd->setUserFlag( NamespaceDetails::Flag_UsePowerOf2Sizes ) ) {
+                            // TODO: wish there was a cleaner way to do this
+                            nsd->syncUserFlags( ns );
+                        }
 
-                    if ( collection->getIndexCatalog()->findIndexByKeyPattern( key ) == NULL ) {
-                        // index not finished yet
-                        LOG(1) << " skipping index because not finished";
-                        continue;
+                        // only do deletes if on master
+                        if ( ! isMaster ) {
+                            return;
+                        }
+
+                        if ( collection->getIndexCatalog()->findIndexByKeyPattern( key ) == NULL ) {
+                            // index not finished yet
+                            LOG(1) << " skipping index because not finished";
+                            return;
+                        }
                     }
 
-                    n = deleteObjects( ns , query , false , true );
-                    ttlDeletedDocuments.increment( n );
+                    deleted = deleteObjects( ns , query , false , true , false , limit );
+                    ttlDeletedDocuments.increment( deleted );
+                }
+                n += deleted;
+
+                if ( limit == 0 || deleted < limit ) {
+                    // drained everything that was expired when the pass started
+                    break;
                 }
 
-                LOG(1) << "\tTTL deleted: " << n << endl;
+                _tuneBatchSize( lockAcquireWaitMicros() - acquireWaitBefore,
+                                batchTimer.micros() );
+
+                if ( ttlDeleteBatchPauseMillis > 0 )
+                    sleepmillis( ttlDeleteBatchPauseMillis );
+            }
+
+            LOG(1) << "\tTTL deleted: " << n << endl;
+        }
+
+        /**
+         * Adjusts _batchSize from how much lock acquire-wait the rest of the
+         * server accumulated while the last batch ran.  The counters are
+         * server wide, so this is a coarse signal, but a TTL batch holding the
+         * database write lock is usually what the waiters are stuck on.
+         */
+        void _tuneBatchSize( long long acquireWaitMicros, long long batchMicros ) {
+            if ( batchMicros <= 0 )
+                return;
+
+            int target = _batchSize;
+            double waitRatio = (double)acquireWaitMicros / (double)batchMicros;
+            if ( waitRatio > kHighLockWaitRatio ) {
+                target = _batchSize / 2;
+            }
+            else if ( waitRatio < kLowLockWaitRatio ) {
+                target = _batchSize + std::max( 1, _batchSize / 4 );
+            }
+
+            target = std::max( target, kMinTTLBatchSize );
+            target = std::min( target, std::max( ttlDeleteBatchSize,
+                                                 kMinTTLBatchSize ) );
+
+            if ( target != _batchSize ) {
+                LOG(1) << "TTL: batch size " << _batchSize << " -> " << target
+                       << " (lock wait ratio " << waitRatio << ")" << endl;
+                _batchSize = target;
             }
-            
-            
         }
 
         virtual void run() {
@@ -192,6 +288,11 @@ namespace mongo {
         }
 
         DBDirectClient db;
+
+    private:
+        // live per-batch delete limit; starts at ttlDeleteBatchSize and is
+        // tuned between kMinTTLBatchSize and that maximum
+        int _batchSize;
     };
 
     void startTTLBackgroundJob() {
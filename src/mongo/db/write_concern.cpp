@@ -185,6 +185,10 @@ namespace mongo {
         // TODO: Make this cleaner
         Status replStatus = Status::OK();
         try {
+            // Read the progress generation before each check so a position
+            // update that races with the check makes the wait below return
+            // immediately instead of being missed.
+            unsigned long long progressGen = slaveProgressGen();
             while ( 1 ) {
 
                 if ( writeConcern.wNumNodes > 0 ) {
@@ -206,7 +210,16 @@ namespace mongo {
                     break;
                 }
 
-                sleepmillis(1);
+                // Park until a secondary reports new progress rather than
+                // polling.  The 100ms cap only bounds how long an interrupt
+                // or stepdown can go unnoticed; progress wakes us at once.
+                unsigned waitMillis = 100;
+                if ( writeConcern.wTimeout > 0 ) {
+                    const int left = writeConcern.wTimeout - gleTimerHolder.millis();
+                    if ( left >= 1 && static_cast<unsigned>( left ) < waitMillis )
+                        waitMillis = left;
+                }
+                progressGen = waitForSlaveProgress( progressGen, waitMillis );
                 killCurrentOp.checkForInterrupt();
             }
         }
@@ -28,6 +28,7 @@
 #include "mongo/db/write_concern_options.h"
 
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/command_arg_schema.h"
 
 namespace mongo {
 
@@ -36,13 +37,35 @@ namespace mongo {
     const BSONObj WriteConcernOptions::AllConfigs = BSONObj();
     const BSONObj WriteConcernOptions::Unacknowledged(BSON("w" << W_NONE));
 
+    namespace {
+        // Schema for the one-pass scan of a write concern document; parse()
+        // is on the path of every gle and every write command.
+        struct WCArgs {
+            CommandArgSchema schema;
+            int j;
+            int fsync;
+            int w;
+            int wtimeout;
+            WCArgs() {
+                j = schema.add("j");
+                fsync = schema.add("fsync");
+                w = schema.add("w");
+                wtimeout = schema.add("wtimeout");
+            }
+        };
+        const WCArgs wcArgs;
+    }
+
     Status WriteConcernOptions::parse( const BSONObj& obj ) {
         if ( obj.isEmpty() ) {
             return Status( ErrorCodes::BadValue, "write concern object cannot be empty" );
         }
 
-        bool j = obj["j"].trueValue();
-        bool fsync = obj["fsync"].trueValue();
+        BSONElement slots[4];
+        wcArgs.schema.bind( obj, slots );
+
+        bool j = slots[wcArgs.j].trueValue();
+        bool fsync = slots[wcArgs.fsync].trueValue();
 
         if ( j & fsync )
             return Status( ErrorCodes::BadValue, "fsync and j options cannot be used together" );
@@ -54,7 +77,7 @@ namespace mongo {
             syncMode = FSYNC;
         }
 
-        BSONElement e = obj["w"];
+        BSONElement e = slots[wcArgs.w];
         if ( e.isNumber() ) {
             wNumNodes = e.numberInt();
         }
@@ -70,7 +93,7 @@ namespace mongo {
             return Status( ErrorCodes::BadValue, "w has to be a number or a string" );
         }
 
-        wTimeout = obj["wtimeout"].numberInt();
+        wTimeout = slots[wcArgs.wtimeout].numberInt();
 
         return Status::OK();
     }
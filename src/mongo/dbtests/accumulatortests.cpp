@@ -835,9 +835,75 @@ namespace AccumulatorTests {
                            + (double)numeric_limits<long long>::max());
             }
         };
-        
+
+        /** A batch of ints through the typed kernel still sums to an int. */
+        class IntBatch : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                const long long vals[] = { 1, 2, 3, 4 };
+                accumulator()->processLongs( vals, 4, true /* fromInts */ );
+                ASSERT_EQUALS( NumberInt, accumulator()->getValue(false).getType() );
+                ASSERT_EQUALS( 10, accumulator()->getValue(false).getInt() );
+            }
+        };
+
+        /** A double batch mixed with boxed longs matches the scalar result. */
+        class DoubleBatchAfterLong : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                accumulator()->process(Value(4LL), false);
+                const double vals[] = { 0.5, 1.5 };
+                accumulator()->processDoubles( vals, 2 );
+                ASSERT_EQUALS( NumberDouble, accumulator()->getValue(false).getType() );
+                ASSERT_EQUALS( 6.0, accumulator()->getValue(false).getDouble() );
+            }
+        };
+
     } // namespace Sum
 
+    namespace Batch {
+
+        /** $min's double kernel handles a NaN inside the batch. */
+        class MinDoublesWithNan : public AccumulatorTests::Base {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> batched = AccumulatorMinMax::createMin();
+                intrusive_ptr<Accumulator> scalar = AccumulatorMinMax::createMin();
+                const double vals[] = { 3.0, numeric_limits<double>::quiet_NaN(), -1.0 };
+                batched->processDoubles( vals, 3 );
+                for ( size_t i = 0; i < 3; i++ )
+                    scalar->process( Value( vals[i] ), false );
+                assertBinaryEqual( fromValue( scalar->getValue(false) ),
+                                   fromValue( batched->getValue(false) ) );
+            }
+        };
+
+        /** $max's long kernel matches element at a time processing. */
+        class MaxLongs : public AccumulatorTests::Base {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> accumulator = AccumulatorMinMax::createMax();
+                const long long vals[] = { -7, 42, 3 };
+                accumulator->processLongs( vals, 3, false );
+                ASSERT_EQUALS( 42, accumulator->getValue(false).getLong() );
+            }
+        };
+
+        /** $avg's double kernel counts and totals the whole batch. */
+        class AvgDoubles : public AccumulatorTests::Base {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> accumulator = AccumulatorAvg::create();
+                const double vals[] = { 1.0, 2.0, 6.0 };
+                accumulator->processDoubles( vals, 3 );
+                ASSERT_EQUALS( 3.0, accumulator->getValue(false).getDouble() );
+            }
+        };
+
+    } // namespace Batch
+
     class All : public Suite {
     public:
         All() : Suite( "accumulator" ) {
@@ -914,6 +980,12 @@ namespace AccumulatorTests {
             add<Sum::IntNull>();
             add<Sum::IntUndefined>();
             add<Sum::NoOverflowBeforeDouble>();
+            add<Sum::IntBatch>();
+            add<Sum::DoubleBatchAfterLong>();
+
+            add<Batch::MinDoublesWithNan>();
+            add<Batch::MaxLongs>();
+            add<Batch::AvgDoubles>();
         }
     } myall;
 
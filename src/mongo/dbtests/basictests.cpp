@@ -35,6 +35,7 @@
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/array.h"
 #include "mongo/util/base64.h"
+#include "mongo/util/buffer_pool.h"
 #include "mongo/util/compress.h"
 #include "mongo/util/paths.h"
 #include "mongo/util/queue.h"
@@ -506,6 +507,32 @@ namespace BasicTests {
         }
     };
 
+    class SpscQueueTest {
+    public:
+        void run() {
+            SingleProducerSingleConsumerQueue<int> q;
+            int x = -1;
+            ASSERT( q.empty() );
+            ASSERT( ! q.tryPop( x ) );
+
+            for ( int i = 0; i < 10; i++ )
+                q.push( i );
+            ASSERT_EQUALS( 10 , q.count() );
+
+            ASSERT( q.peek( x ) );
+            ASSERT_EQUALS( 0 , x );
+            ASSERT_EQUALS( 0 , q.blockingPop() );
+
+            std::vector<int> batch;
+            ASSERT_EQUALS( 5u , q.tryPopMany( &batch , 5 ) );
+            ASSERT_EQUALS( 1 , batch[0] );
+            ASSERT_EQUALS( 5 , batch[4] );
+            ASSERT_EQUALS( 4u , q.tryPopMany( &batch , 100 ) );
+            ASSERT( q.empty() );
+            ASSERT( ! q.blockingPop( x , 1 ) );
+        }
+    };
+
     class StrTests {
     public:
 
@@ -561,6 +588,40 @@ namespace BasicTests {
         }
     } ctest1;
 
+    class BufferPoolTest {
+    public:
+        void run() {
+            ASSERT_EQUALS( 512, BufferPool::roundUp( 1 ) );
+            ASSERT_EQUALS( 512, BufferPool::roundUp( 512 ) );
+            ASSERT_EQUALS( 1024, BufferPool::roundUp( 513 ) );
+            // sizes past the largest class are not pooled
+            ASSERT_EQUALS( BufferPool::MaxPooledSize + 1,
+                           BufferPool::roundUp( BufferPool::MaxPooledSize + 1 ) );
+
+            // drain this thread's 1024 class so cache state is known
+            const int nheld = BufferPool::MaxBlocksPerClass + 2;
+            char* held[ nheld ];
+            for ( int i = 0; i < nheld; i++ )
+                held[i] = BufferPool::acquire( 1000 );
+
+            // released blocks come back LIFO on the next acquire of the class
+            BufferPool::release( held[0], 1024 );
+            BufferPool::release( held[1], 1024 );
+            ASSERT_EQUALS( (void*)held[1], (void*)BufferPool::acquire( 600 ) );
+            ASSERT_EQUALS( (void*)held[0], (void*)BufferPool::acquire( 1000 ) );
+
+            for ( int i = 0; i < nheld; i++ )
+                BufferPool::release( held[i], 1024 );
+
+            // a pooled builder behaves like a BufBuilder, growing included
+            PooledBufBuilder bb;
+            for ( int i = 0; i < 300; i++ )
+                bb.appendNum( (long long)i );
+            ASSERT_EQUALS( 300 * (int)sizeof(long long), bb.len() );
+            ASSERT_EQUALS( 0, memcmp( bb.buf(), "\0\0\0\0\0\0\0\0", 8 ) );
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "basic" ) {
@@ -589,6 +650,7 @@ namespace BasicTests {
             add< IsValidUTF8Test >();
 
             add< QueueTest >();
+            add< SpscQueueTest >();
 
             add< StrTests >();
 
@@ -596,6 +658,7 @@ namespace BasicTests {
             add< RelativePathTest >();
 
             add< CompressionTest1 >();
+            add< BufferPoolTest >();
 
         }
     } myall;
@@ -158,6 +158,27 @@ namespace CountTests {
         }
     };
 
+    class Approx : public Base {
+    public:
+        void run() {
+            insert( "{\"a\":\"b\"}" );
+            insert( "{\"a\":\"b\",\"x\":\"y\"}" );
+            insert( "{\"a\":\"c\"}" );
+            BSONObj cmd = BSON( "query" << BSON( "a" << "b" ) << "approx" << true );
+            string err;
+            int errCode;
+            BSONObjBuilder extraInfo;
+            long long n = runCount( ns(), cmd, err, errCode, &extraInfo );
+            // the estimate is an upper bound on the true count and cannot
+            // exceed the number of keys in the index
+            ASSERT( n >= 2 );
+            ASSERT( n <= 3 );
+            BSONObj info = extraInfo.obj();
+            ASSERT( info["approximate"].trueValue() );
+            ASSERT( info["approxErrorBound"].isNumber() );
+        }
+    };
+
     /** Set a value or await an expected value. */
     class PendingValue {
     public:
@@ -263,6 +284,7 @@ namespace CountTests {
             add<Fields>();
             add<QueryFields>();
             add<IndexedRegex>();
+            add<Approx>();
             add<Yield>();
         }
     } myall;
@@ -524,6 +524,37 @@ namespace DocumentTests {
             }
         };
 
+        /** Long strings converted from an owned BSONObj reference the BSON buffer. */
+        class LongStringFromOwnedBson {
+        public:
+            void run() {
+                const string str( 100, 'x' );
+                BSONObj obj = BSON( "" << str ).getOwned();
+                Value value( obj.firstElement(), obj );
+                // The Value must keep the string alive after the last BSONObj goes away.
+                obj = BSONObj();
+                ASSERT_EQUALS( str, value.getString() );
+                ASSERT_EQUALS( mongo::String, value.getType() );
+                assertRoundTrips( value );
+            }
+        };
+
+        /** Value::concat materializes several strings in a single pass. */
+        class ConcatStrings {
+        public:
+            void run() {
+                vector<Value> parts;
+                parts.push_back( Value( "short" ) );
+                parts.push_back( Value( string( 40, 'y' ) ) );
+                parts.push_back( Value( string( "a\0b", 3 ) ) );
+                Value value = Value::concat( parts );
+                ASSERT_EQUALS( "short" + string( 40, 'y' ) + string( "a\0b", 3 ),
+                               value.getString() );
+                ASSERT_EQUALS( mongo::String, value.getType() );
+                assertRoundTrips( value );
+            }
+        };
+
         /** Date type. */
         class Date {
         public:
@@ -1435,6 +1466,8 @@ namespace DocumentTests {
             add<Value::Double>();
             add<Value::String>();
             add<Value::StringWithNull>();
+            add<Value::LongStringFromOwnedBson>();
+            add<Value::ConcatStrings>();
             add<Value::Date>();
             add<Value::Timestamp>();
             add<Value::EmptyDocument>();
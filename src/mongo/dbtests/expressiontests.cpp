@@ -32,6 +32,7 @@
 
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/expression_program.h"
 #include "mongo/dbtests/dbtests.h"
 
 namespace ExpressionTests {
@@ -3436,6 +3437,156 @@ namespace ExpressionTests {
 
     } // namespace AllAnyElements
 
+    namespace FlattenedProgram {
+
+        static intrusive_ptr<Expression> parseSpec( const BSONObj& specObj ) {
+            BSONElement specElement = specObj.firstElement();
+            VariablesIdGenerator idGenerator;
+            VariablesParseState vps( &idGenerator );
+            return Expression::parseOperand( specElement, vps );
+        }
+
+        /** A compiled program produces the same result as the tree interpreter. */
+        class EquivalentBase {
+        public:
+            virtual ~EquivalentBase() {}
+            void run() {
+                intrusive_ptr<Expression> expression = parseSpec( spec() );
+                intrusive_ptr<ExpressionProgram> program =
+                        ExpressionProgram::compile( expression );
+                ASSERT( program );
+                Variables vars( 0, fromBson( document() ) );
+                assertBinaryEqual( toBson( expression->evaluate( fromBson( document() ) ) ),
+                                   toBson( program->evaluate( &vars ) ) );
+            }
+        protected:
+            virtual BSONObj spec() = 0;
+            virtual BSONObj document() { return BSONObj(); }
+        };
+
+        /** Nested arithmetic over field paths. */
+        class Arithmetic : public EquivalentBase {
+            BSONObj spec() {
+                return constify( BSON( "$subtract" << BSON_ARRAY(
+                        BSON( "$add" << BSON_ARRAY(
+                                "$a" << BSON( "$multiply" << BSON_ARRAY( "$b" << 2 ) ) << 1 ) ) <<
+                        BSON( "$mod" << BSON_ARRAY( "$a" << 2 ) ) ) ) );
+            }
+            BSONObj document() { return BSON( "a" << 7 << "b" << 2.5 ); }
+        };
+
+        /** Constants of different numeric types must not share a register. */
+        class NarrowestType : public EquivalentBase {
+            BSONObj spec() {
+                return constify( BSON( "$add" << BSON_ARRAY( 1 << 1.0 ) ) );
+            }
+        };
+
+        /** Comparison operators. */
+        class Compare : public EquivalentBase {
+            BSONObj spec() {
+                return constify( BSON( "$lt" << BSON_ARRAY( "$a" << "$b" ) ) );
+            }
+            BSONObj document() { return BSON( "a" << 1 << "b" << "foo" ); }
+        };
+
+        /** A missing operand makes arithmetic results null. */
+        class NullPropagation : public EquivalentBase {
+            BSONObj spec() {
+                return constify( BSON( "$add" << BSON_ARRAY( "$missing" << 1 ) ) );
+            }
+        };
+
+        /** The untaken $cond branch is not evaluated (it would throw). */
+        class CondShortCircuit : public EquivalentBase {
+            BSONObj spec() {
+                return constify( BSON( "$cond" << BSON_ARRAY(
+                        BSON( "$gt" << BSON_ARRAY( "$a" << 0 ) ) <<
+                        "taken" <<
+                        BSON( "$divide" << BSON_ARRAY( 1 << 0 ) ) ) ) );
+            }
+            BSONObj document() { return BSON( "a" << 1 ); }
+        };
+
+        /** Operands beyond a deciding $and operand are not evaluated. */
+        class AndShortCircuit : public EquivalentBase {
+            BSONObj spec() {
+                return constify( BSON( "$and" << BSON_ARRAY(
+                        false << BSON( "$divide" << BSON_ARRAY( 1 << 0 ) ) ) ) );
+            }
+        };
+
+        /** $ifNull falling through to its replacement. */
+        class IfNullMissing : public EquivalentBase {
+            BSONObj spec() {
+                return constify( BSON( "$ifNull" << BSON_ARRAY( "$missing" << "default" ) ) );
+            }
+        };
+
+        /** Unsupported operators fall back to the tree interpreter per subtree. */
+        class UnsupportedFallback : public EquivalentBase {
+            BSONObj spec() {
+                return constify( BSON( "$add" << BSON_ARRAY(
+                        BSON( "$strcasecmp" << BSON_ARRAY( "$a" << "B" ) ) << 1 ) ) );
+            }
+            BSONObj document() { return BSON( "a" << "a" ); }
+        };
+
+        /** A bare field path gains nothing from flattening. */
+        class FieldPathNotCompiled {
+        public:
+            void run() {
+                intrusive_ptr<Expression> expression = parseSpec( BSON( "" << "$a" ) );
+                ASSERT( !ExpressionProgram::compile( expression ) );
+                ASSERT_EQUALS( expression.get(),
+                               ExpressionFlattened::flatten( expression ).get() );
+            }
+        };
+
+        /** Identical subtrees are computed once. */
+        class CommonSubexpressions {
+        public:
+            void run() {
+                intrusive_ptr<Expression> expression = parseSpec(
+                        constify( BSON( "$add" << BSON_ARRAY(
+                                BSON( "$multiply" << BSON_ARRAY( "$a" << "$b" ) ) <<
+                                BSON( "$multiply" << BSON_ARRAY( "$a" << "$b" ) ) ) ) ) );
+                intrusive_ptr<ExpressionProgram> program =
+                        ExpressionProgram::compile( expression );
+                ASSERT( program );
+                // "$a", "$b" and the deduplicated $multiply, then the $add.
+                ASSERT_EQUALS( 4U, program->numInstructions() );
+                Variables vars( 0, fromBson( BSON( "a" << 3 << "b" << 4 ) ) );
+                assertBinaryEqual( BSON( "" << 24 ), toBson( program->evaluate( &vars ) ) );
+            }
+        };
+
+        /** ExpressionObject::optimize() flattens computed fields transparently. */
+        class OptimizedObject {
+        public:
+            void run() {
+                intrusive_ptr<ExpressionObject> object = ExpressionObject::create();
+                VariablesIdGenerator idGenerator;
+                VariablesParseState vps( &idGenerator );
+                object->addField( mongo::FieldPath( "total" ),
+                                  Expression::parseOperand(
+                                          BSON( "" << BSON( "$add"
+                                                  << BSON_ARRAY( "$a" << "$b" ) ) ).firstElement(),
+                                          vps ) );
+                object->optimize();
+                // Flattening must not change serialization...
+                assertBinaryEqual( BSON( "total" << BSON( "$add"
+                                           << BSON_ARRAY( "$a" << "$b" ) ) ),
+                                   expressionToBson( object ) );
+                // ...or evaluation.
+                Variables vars( 0, fromBson( BSON( "a" << 1 << "b" << 2 ) ) );
+                assertBinaryEqual( BSON( "total" << 3 ),
+                                   toBson( object->evaluateDocument( &vars ) ) );
+            }
+        };
+
+    } // namespace FlattenedProgram
+
     class All : public Suite {
     public:
         All() : Suite( "expression" ) {
@@ -3739,6 +3890,18 @@ namespace ExpressionTests {
             add<AllAnyElements::TrueViaInt>();
             add<AllAnyElements::FalseViaInt>();
             add<AllAnyElements::Null>();
+
+            add<FlattenedProgram::Arithmetic>();
+            add<FlattenedProgram::NarrowestType>();
+            add<FlattenedProgram::Compare>();
+            add<FlattenedProgram::NullPropagation>();
+            add<FlattenedProgram::CondShortCircuit>();
+            add<FlattenedProgram::AndShortCircuit>();
+            add<FlattenedProgram::IfNullMissing>();
+            add<FlattenedProgram::UnsupportedFallback>();
+            add<FlattenedProgram::FieldPathNotCompiled>();
+            add<FlattenedProgram::CommonSubexpressions>();
+            add<FlattenedProgram::OptimizedObject>();
         }
     } myall;
 
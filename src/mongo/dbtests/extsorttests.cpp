@@ -297,6 +297,39 @@ namespace ExtSortTests {
         }
     };
 
+    /** Merge the output of several sorters into one globally sorted stream. */
+    class MergeSorters {
+    public:
+        void run() {
+            const int nSorters = 3;
+            const int nDocs = 90;
+
+            // Deal keys round robin so every sorter holds a slice of the range.
+            std::vector< boost::shared_ptr<BSONObjExternalSorter> > sorters;
+            for ( int i = 0; i < nSorters; ++i ) {
+                sorters.push_back( make_shared<BSONObjExternalSorter>( _aFirstSort ) );
+            }
+            for ( int i = 0; i < nDocs; ++i ) {
+                sorters[i % nSorters]->add( BSON( "" << ( nDocs - 1 - i ) ), DiskLoc(), false );
+            }
+
+            std::vector< boost::shared_ptr<BSONObjExternalSorter::Iterator> > iters;
+            for ( int i = 0; i < nSorters; ++i ) {
+                sorters[i]->sort( false );
+                iters.push_back( boost::shared_ptr<BSONObjExternalSorter::Iterator>(
+                                     sorters[i]->iterator().release() ) );
+            }
+
+            scoped_ptr<BSONObjExternalSorter::Iterator> merged(
+                BSONObjExternalSorter::mergeIterators( iters, _aFirstSort ) );
+            int expectedKey = 0;
+            while ( merged->more() ) {
+                ASSERT_EQUALS( BSON( "" << expectedKey++ ), merged->next().first );
+            }
+            ASSERT_EQUALS( nDocs, expectedKey );
+        }
+    };
+
     /**
      * BSONObjExternalSorter::add() aborts if the current operation is interrupted, even if storage
      * system writes have occurred.
@@ -421,6 +454,7 @@ namespace ExtSortTests {
             add<Sort1e6>();
             add<SortNull>();
             add<Sort130>();
+            add<MergeSorters>();
             add<InterruptAdd>( false );
             add<InterruptAdd>( true );
             add<InterruptSort>( false );
@@ -77,6 +77,12 @@ namespace mongo {
         options->addOptionChaining("perfHist", "perfHist", moe::Unsigned,
                 "number of back runs of perf stats to display");
 
+        options->addOptionChaining("perfOut", "perfOut", moe::String,
+                "append perf suite results to this file, one JSON document per test");
+
+        options->addOptionChaining("perfBaseline", "perfBaseline", moe::String,
+                "compare perf suite results against a file written by --perfOut");
+
 
         options->addOptionChaining("suites", "suites", moe::StringVector, "test suites to run")
                                   .hidden()
@@ -136,6 +142,14 @@ namespace mongo {
             frameworkGlobalParams.perfHist = params["perfHist"].as<unsigned>();
         }
 
+        if (params.count("perfOut")) {
+            frameworkGlobalParams.perfOut = params["perfOut"].as<string>();
+        }
+
+        if (params.count("perfBaseline")) {
+            frameworkGlobalParams.perfBaseline = params["perfBaseline"].as<string>();
+        }
+
         bool nodur = false;
         if( params.count("nodur") ) {
             nodur = true;
@@ -44,6 +44,8 @@ namespace mongo {
 
     struct FrameworkGlobalParams {
         unsigned perfHist;
+        std::string perfOut;
+        std::string perfBaseline;
         unsigned long long seed;
         int runsPerTest;
         std::string dbpathSpec;
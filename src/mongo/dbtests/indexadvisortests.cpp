@@ -0,0 +1,103 @@
+// indexadvisortests.cpp : db/stats/index_advisor.{h,cpp} unit tests
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/index_advisor.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace IndexAdvisorTests {
+
+    BSONObj suggest( const BSONObj& shape, const BSONObj& sort ) {
+        string whyNot;
+        return IndexAdvisor::suggestIndex( shape, sort, &whyNot );
+    }
+
+    class EqualitySortRange {
+    public:
+        void run() {
+            // equality first, then the sort with its direction, then ranges
+            ASSERT_EQUALS( BSON( "a" << 1 << "c" << -1 << "b" << 1 ),
+                           suggest( BSON( "a" << 1 << "b" << BSON( "$gt" << 1 ) ),
+                                    BSON( "c" << -1 ) ) );
+            // $eq counts as equality; $in as a range
+            ASSERT_EQUALS( BSON( "a" << 1 << "b" << 1 ),
+                           suggest( BSON( "b" << BSON( "$in" << 1 ) <<
+                                          "a" << BSON( "$eq" << 1 ) ),
+                                    BSONObj() ) );
+        }
+    };
+
+    class SortOnEqualityField {
+    public:
+        void run() {
+            // sorting on an equality field adds nothing to the key
+            ASSERT_EQUALS( BSON( "a" << 1 ),
+                           suggest( BSON( "a" << 1 ), BSON( "a" << 1 ) ) );
+            // a sort alone is still worth an index
+            ASSERT_EQUALS( BSON( "ts" << -1 ),
+                           suggest( BSONObj(), BSON( "ts" << -1 ) ) );
+        }
+    };
+
+    class NoSuggestion {
+    public:
+        void run() {
+            string whyNot;
+
+            ASSERT( IndexAdvisor::suggestIndex(
+                        BSON( "$or" << BSON_ARRAY( BSON( "a" << 1 ) ) ),
+                        BSONObj(), &whyNot ).isEmpty() );
+            ASSERT( !whyNot.empty() );
+
+            ASSERT( IndexAdvisor::suggestIndex(
+                        BSON( "loc" << BSON( "$near" << 1 ) ),
+                        BSONObj(), &whyNot ).isEmpty() );
+
+            ASSERT( IndexAdvisor::suggestIndex(
+                        BSON( "_id" << 1 ), BSONObj(), &whyNot ).isEmpty() );
+
+            ASSERT( IndexAdvisor::suggestIndex(
+                        BSONObj(), BSONObj(), &whyNot ).isEmpty() );
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "indexadvisor" ) {}
+
+        void setupTests() {
+            add<EqualitySortRange>();
+            add<SortOnEqualityField>();
+            add<NoSuggestion>();
+        }
+    } myall;
+
+}  // namespace IndexAdvisorTests
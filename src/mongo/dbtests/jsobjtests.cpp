@@ -152,6 +152,75 @@ namespace JsobjTests {
             }
         };
 
+        /** repeated getField calls on an owned object switch to the lazily
+            built field index; results must not change when they do */
+        class FieldIndexLookup {
+        public:
+            void run() {
+                BSONObjBuilder b;
+                const int n = 20;
+                for ( int i = 0; i < n; i++ ) {
+                    StringBuilder name;
+                    name << "field" << i;
+                    b.append( name.str(), i );
+                }
+                BSONObj o = b.obj();
+
+                // well past the scan threshold that triggers the index build
+                for ( int pass = 0; pass < 5; pass++ ) {
+                    for ( int i = 0; i < n; i++ ) {
+                        StringBuilder name;
+                        name << "field" << i;
+                        BSONElement e = o.getField( name.str() );
+                        ASSERT_EQUALS( i, e.numberInt() );
+                    }
+                    ASSERT( o.getField( "missing" ).eoo() );
+                    ASSERT_EQUALS( n, o.nFields() );
+                }
+
+                // an unowned view of the same buffer still works (linear path)
+                BSONObj unowned( o.objdata() );
+                ASSERT_EQUALS( 7, unowned.getField( "field7" ).numberInt() );
+
+                // first occurrence wins for duplicate field names
+                BSONObjBuilder dupb;
+                for ( int i = 0; i < 10; i++ )
+                    dupb.append( "x", i );
+                BSONObj dup = dupb.obj();
+                for ( int pass = 0; pass < 5; pass++ ) {
+                    ASSERT_EQUALS( 0, dup.getField( "x" ).numberInt() );
+                }
+            }
+        };
+
+        /** several objects aliasing one SharedBuffer are owned without
+            copies and outlive both the buffer handle and each other */
+        class SharedBufferAliasing {
+        public:
+            void run() {
+                BufBuilder b;
+                BSONObjBuilder( b ).append( "a", 1 ).done();
+                const int firstSize = b.len();
+                BSONObjBuilder( b ).append( "b", 2 ).done();
+                char* buf = b.buf();
+                b.decouple();
+
+                BSONObj first;
+                BSONObj second;
+                {
+                    SharedBuffer shared = SharedBuffer::takeOwnership( buf );
+                    first = BSONObj( shared, buf );
+                    second = BSONObj( shared, buf + firstSize );
+                }
+                // the buffer handle is gone; the objects keep the bytes alive
+                ASSERT( first.isOwned() );
+                ASSERT( second.isOwned() );
+                ASSERT_EQUALS( 1, first["a"].numberInt() );
+                first = BSONObj();
+                ASSERT_EQUALS( 2, second["b"].numberInt() );
+            }
+        };
+
         class Base {
         protected:
             static BSONObj basic( const char *name, int val ) {
@@ -2132,6 +2201,8 @@ namespace JsobjTests {
             add< BSONElementBasic >();
             add< BSONObjTests::NullString >();
             add< BSONObjTests::Create >();
+            add< BSONObjTests::FieldIndexLookup >();
+            add< BSONObjTests::SharedBufferAliasing >();
             add< BSONObjTests::WoCompareBasic >();
             add< BSONObjTests::NumericCompareBasic >();
             add< BSONObjTests::WoCompareEmbeddedObject >();
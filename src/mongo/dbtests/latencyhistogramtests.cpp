@@ -0,0 +1,130 @@
+// latencyhistogramtests.cpp : db/stats/operation_latency_histogram.{h,cpp} unit tests
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/operation_latency_histogram.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/util/net/message.h"
+
+namespace LatencyHistogramTests {
+
+    BSONObj appended( const OperationLatencyHistogram& h, bool includeHistograms ) {
+        BSONObjBuilder b;
+        h.append( includeHistograms, &b );
+        return b.obj();
+    }
+
+    class Buckets {
+    public:
+        void run() {
+            OperationLatencyHistogram h;
+            h.increment( OperationLatencyHistogram::OpRead, 0 );   // [0, 2)
+            h.increment( OperationLatencyHistogram::OpRead, 1 );   // [0, 2)
+            h.increment( OperationLatencyHistogram::OpRead, 3 );   // [2, 4)
+            h.increment( OperationLatencyHistogram::OpRead, 4 );   // [4, 8)
+            h.increment( OperationLatencyHistogram::OpRead, 100 ); // [64, 128)
+
+            BSONObj reads = appended( h, true )["reads"].Obj();
+            ASSERT_EQUALS( 108, reads["latency"].numberLong() );
+            ASSERT_EQUALS( 5, reads["ops"].numberLong() );
+
+            vector<BSONElement> buckets = reads["histogram"].Array();
+            ASSERT_EQUALS( 4U, buckets.size() );
+            ASSERT_EQUALS( 0, buckets[0].Obj()["micros"].numberLong() );
+            ASSERT_EQUALS( 2, buckets[0].Obj()["count"].numberLong() );
+            ASSERT_EQUALS( 2, buckets[1].Obj()["micros"].numberLong() );
+            ASSERT_EQUALS( 1, buckets[1].Obj()["count"].numberLong() );
+            ASSERT_EQUALS( 4, buckets[2].Obj()["micros"].numberLong() );
+            ASSERT_EQUALS( 64, buckets[3].Obj()["micros"].numberLong() );
+
+            // histograms are only emitted on request
+            ASSERT( appended( h, false )["reads"].Obj()["histogram"].eoo() );
+        }
+    };
+
+    class Categories {
+    public:
+        void run() {
+            LatencyStats stats;
+            stats.record( "test.coll", dbQuery, false, 10 );  // read
+            stats.record( "test.coll", dbGetMore, false, 10 );// read
+            stats.record( "test.coll", dbInsert, false, 10 ); // write
+            stats.record( "test.coll", dbUpdate, false, 10 ); // write
+            stats.record( "test.coll", dbDelete, false, 10 ); // write
+            stats.record( "test.$cmd", dbQuery, true, 10 );   // command
+            stats.record( "?xyz", dbQuery, false, 10 );       // skipped
+            stats.record( "test.coll", dbKillCursors, false, 10 ); // no category
+
+            BSONObjBuilder b;
+            stats.append( false, true, &b );
+            BSONObj o = b.obj();
+
+            ASSERT_EQUALS( 2, o["reads"].Obj()["ops"].numberLong() );
+            ASSERT_EQUALS( 3, o["writes"].Obj()["ops"].numberLong() );
+            ASSERT_EQUALS( 1, o["commands"].Obj()["ops"].numberLong() );
+
+            BSONObj coll = o["collections"].Obj()["test.coll"].Obj();
+            ASSERT_EQUALS( 2, coll["reads"].Obj()["ops"].numberLong() );
+            ASSERT_EQUALS( 3, coll["writes"].Obj()["ops"].numberLong() );
+            ASSERT_EQUALS( 0, coll["commands"].Obj()["ops"].numberLong() );
+        }
+    };
+
+    class Dropped {
+    public:
+        void run() {
+            LatencyStats stats;
+            stats.record( "test.a", dbQuery, false, 10 );
+            stats.record( "test.b", dbQuery, false, 10 );
+            stats.collectionDropped( "test.a" );
+
+            BSONObjBuilder b;
+            stats.append( false, true, &b );
+            BSONObj colls = b.obj()["collections"].Obj();
+
+            // the dropped namespace's counters restart from zero
+            ASSERT_EQUALS( 0, colls["test.a"].Obj()["reads"].Obj()["ops"].numberLong() );
+            ASSERT_EQUALS( 1, colls["test.b"].Obj()["reads"].Obj()["ops"].numberLong() );
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "latencyhistogram" ) {}
+
+        void setupTests() {
+            add< Buckets >();
+            add< Categories >();
+            add< Dropped >();
+        }
+    } myall;
+
+}  // namespace LatencyHistogramTests
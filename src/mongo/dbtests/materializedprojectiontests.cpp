@@ -0,0 +1,213 @@
+// materializedprojectiontests.cpp : db/catalog/materialized_projection.{h,cpp} tests
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/catalog/materialized_projection.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace MaterializedProjectionTests {
+
+    static const char* const ns = "unittests.matproj";
+    static const char* const targetNS = "unittests.matproj.proj.active";
+
+    class Base {
+    public:
+        Base() {
+            // dropping the source deactivates any leftover definition too
+            _client.dropCollection( ns );
+            _client.dropCollection( targetNS );
+        }
+        virtual ~Base() {
+            _client.dropCollection( ns );
+            _client.dropCollection( targetNS );
+        }
+
+    protected:
+        bool materialize() {
+            BSONObj info;
+            return _client.runCommand( "unittests",
+                                       BSON( "materializeProjection" << "matproj" <<
+                                             "name" << "active" <<
+                                             "filter" << BSON( "status" << "active" ) <<
+                                             "fields" << BSON_ARRAY( "a" ) ),
+                                       info );
+        }
+
+        DBDirectClient _client;
+    };
+
+    class BackfillAndMaintain : public Base {
+    public:
+        void run() {
+            _client.insert( ns, BSON( "_id" << 1 << "status" << "active" << "a" << 10 << "b" << 1 ) );
+            _client.insert( ns, BSON( "_id" << 2 << "status" << "done" << "a" << 20 << "b" << 2 ) );
+
+            ASSERT( materialize() );
+
+            // backfill copied only the matching doc and only the listed
+            // fields (plus _id and the filter field)
+            ASSERT_EQUALS( 1U, _client.count( targetNS ) );
+            ASSERT_EQUALS( BSON( "_id" << 1 << "status" << "active" << "a" << 10 ),
+                           _client.findOne( targetNS, BSON( "_id" << 1 ) ) );
+
+            // inserts are reflected synchronously
+            _client.insert( ns, BSON( "_id" << 3 << "status" << "active" << "a" << 30 ) );
+            _client.insert( ns, BSON( "_id" << 4 << "status" << "done" << "a" << 40 ) );
+            ASSERT_EQUALS( 2U, _client.count( targetNS ) );
+
+            // an update that changes a projected field rewrites the copy
+            _client.update( ns, BSON( "_id" << 3 ),
+                            BSON( "_id" << 3 << "status" << "active" << "a" << 31 ) );
+            ASSERT_EQUALS( 31, _client.findOne( targetNS, BSON( "_id" << 3 ) )["a"].numberInt() );
+
+            // so does an in-place $set, which patches the record's bytes
+            // without going through Collection::updateDocument
+            _client.update( ns, BSON( "_id" << 3 ),
+                            BSON( "$set" << BSON( "a" << 32 ) ) );
+            ASSERT_EQUALS( 32, _client.findOne( targetNS, BSON( "_id" << 3 ) )["a"].numberInt() );
+
+            // ... leaving the filter drops the copy, re-entering restores it
+            _client.update( ns, BSON( "_id" << 3 ),
+                            BSON( "_id" << 3 << "status" << "done" << "a" << 31 ) );
+            ASSERT_EQUALS( 1U, _client.count( targetNS ) );
+            _client.update( ns, BSON( "_id" << 4 ),
+                            BSON( "_id" << 4 << "status" << "active" << "a" << 40 ) );
+            ASSERT_EQUALS( 2U, _client.count( targetNS ) );
+
+            // deletes are reflected as well
+            _client.remove( ns, BSON( "_id" << 1 ) );
+            ASSERT_EQUALS( 1U, _client.count( targetNS ) );
+
+            // dropProjection removes both the definition and the collection
+            BSONObj info;
+            ASSERT( _client.runCommand( "unittests",
+                                        BSON( "dropProjection" << "matproj" <<
+                                              "name" << "active" ),
+                                        info ) );
+            ASSERT_EQUALS( 0U, _client.count( targetNS ) );
+            _client.insert( ns, BSON( "_id" << 5 << "status" << "active" << "a" << 50 ) );
+            ASSERT_EQUALS( 0U, _client.count( targetNS ) );
+        }
+    };
+
+    class Retargeting : public Base {
+    public:
+        void run() {
+            _client.insert( ns, BSON( "_id" << 1 << "status" << "active" << "a" << 10 ) );
+            ASSERT( materialize() );
+
+            // the hot shape goes to the projection collection
+            ASSERT_EQUALS( targetNS,
+                           retarget( BSON( "status" << "active" ), BSON( "a" << 1 ) ) );
+
+            // residual predicates and sorts on projected fields are fine
+            ASSERT_EQUALS( targetNS,
+                           retarget( BSON( "status" << "active" <<
+                                           "a" << BSON( "$gt" << 5 ) ),
+                                     BSON( "a" << 1 << "_id" << 0 ) ) );
+
+            // a different equality value is a different slice
+            ASSERT_EQUALS( "", retarget( BSON( "status" << "done" ), BSON( "a" << 1 ) ) );
+
+            // no projection means whole documents, which the copy lacks
+            ASSERT_EQUALS( "", retarget( BSON( "status" << "active" ), BSONObj() ) );
+
+            // so does touching a field that was not projected
+            ASSERT_EQUALS( "", retarget( BSON( "status" << "active" << "b" << 1 ),
+                                         BSON( "a" << 1 ) ) );
+            ASSERT_EQUALS( "", retarget( BSON( "status" << "active" ),
+                                         BSON( "b" << 1 ) ) );
+
+            BSONObj info;
+            ASSERT( _client.runCommand( "unittests",
+                                        BSON( "dropProjection" << "matproj" <<
+                                              "name" << "active" ),
+                                        info ) );
+            ASSERT_EQUALS( "", retarget( BSON( "status" << "active" ), BSON( "a" << 1 ) ) );
+        }
+
+    private:
+        std::string retarget( const BSONObj& query, const BSONObj& proj ) {
+            CanonicalQuery* rawCq;
+            ASSERT_OK( CanonicalQuery::canonicalize( ns, query, BSONObj(), proj, &rawCq ) );
+            boost::scoped_ptr<CanonicalQuery> cq( rawCq );
+            return MaterializedProjections::global.retargetNS( *cq );
+        }
+    };
+
+    class InvalidDefinitions : public Base {
+    public:
+        void run() {
+            _client.insert( ns, BSON( "_id" << 1 << "status" << "active" ) );
+
+            // non-scalar filter values and operator filters are refused
+            ASSERT( !create( BSON( "status" << BSON( "$ne" << "done" ) ),
+                             BSON_ARRAY( "a" ) ) );
+            ASSERT( !create( BSON( "status" << BSONNULL ), BSON_ARRAY( "a" ) ) );
+            // so are dotted or $-prefixed projected fields
+            ASSERT( !create( BSON( "status" << "active" ), BSON_ARRAY( "a.b" ) ) );
+            ASSERT( !create( BSON( "status" << "active" ), BSON_ARRAY( "$x" ) ) );
+            // and an empty filter (that would just be a full copy)
+            ASSERT( !create( BSONObj(), BSON_ARRAY( "a" ) ) );
+
+            ASSERT( materialize() );
+            // double-create of the same name is refused
+            ASSERT( !materialize() );
+        }
+
+    private:
+        bool create( const BSONObj& filter, const BSONArray& fields ) {
+            BSONObj info;
+            return _client.runCommand( "unittests",
+                                       BSON( "materializeProjection" << "matproj" <<
+                                             "name" << "active" <<
+                                             "filter" << filter <<
+                                             "fields" << fields ),
+                                       info );
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "materializedprojection" ) {}
+
+        void setupTests() {
+            add<BackfillAndMaintain>();
+            add<Retargeting>();
+            add<InvalidDefinitions>();
+        }
+    } myall;
+
+}  // namespace MaterializedProjectionTests
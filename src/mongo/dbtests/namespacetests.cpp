@@ -1561,6 +1561,39 @@ namespace NamespaceTests {
             virtual string spec() const { return ""; }
         };
 
+        /**
+         * A request for exactly a bucket boundary size - what power of 2 sized collections
+         * always ask for - is served by popping the head of the appropriate deleted list
+         * without scanning it.
+         */
+        class AllocExactBucketSizeTakesListHead : public Base {
+        public:
+            void run() {
+                create();
+                cookDeletedList( 1024 );
+                DiskLoc actualLocation = nsd()->alloc( NULL, ns(), 1024 );
+                ASSERT_EQUALS( 1024, actualLocation.rec()->lengthWithHeaders() );
+                ASSERT_EQUALS( DiskLoc(), smallestDeletedRecord() );
+            }
+            virtual string spec() const { return ""; }
+        };
+
+        /**
+         * An exact bucket boundary request served from a larger bucket still splits off the
+         * unneeded remainder as a new deleted record.
+         */
+        class AllocExactBucketSizeSplitsLargerRecord : public Base {
+        public:
+            void run() {
+                create();
+                cookDeletedList( 4096 );
+                DiskLoc actualLocation = nsd()->alloc( NULL, ns(), 1024 );
+                ASSERT_EQUALS( 1024, actualLocation.rec()->lengthWithHeaders() );
+                ASSERT_EQUALS( 3072, smallestDeletedRecord().drec()->lengthWithHeaders() );
+            }
+            virtual string spec() const { return ""; }
+        };
+
         /** An attempt to allocate a record larger than the largest deleted record fails. */
         class AllocFailsWithTooSmallDeletedRecord : public Base {
         public:
@@ -1811,6 +1844,8 @@ namespace NamespaceTests {
             add< NamespaceDetailsTests::AllocQuantizedWithExtra >();
             add< NamespaceDetailsTests::AllocQuantizedWithoutExtra >();
             add< NamespaceDetailsTests::AllocNotQuantizedNearDeletedSize >();
+            add< NamespaceDetailsTests::AllocExactBucketSizeTakesListHead >();
+            add< NamespaceDetailsTests::AllocExactBucketSizeSplitsLargerRecord >();
             add< NamespaceDetailsTests::AllocFailsWithTooSmallDeletedRecord >();
             add< NamespaceDetailsTests::TwoExtent >();
             add< NamespaceDetailsTests::TruncateCapped >();
@@ -110,6 +110,55 @@ namespace PdfileTests {
                 ASSERT( !fixDocumentForInsert( BSON( "_id" << BSON( "$oid" << 5 ) ) ).isOK() );
             }
         };
+
+        class IdMovedToFront : public Base {
+        public:
+            void run() {
+                BSONObj o = BSON( "x" << 1 << "y" << "payload" << "_id" << 5 );
+
+                BSONObj fixed = fixDocumentForInsert( o ).getValue();
+                // _id comes first, everything else keeps its relative order and bytes
+                ASSERT( fixed.binaryEqual( BSON( "_id" << 5 << "x" << 1 << "y" << "payload" ) ) );
+
+                // an _id in the middle moves the same way
+                o = BSON( "x" << 1 << "_id" << 5 << "y" << "payload" );
+                fixed = fixDocumentForInsert( o ).getValue();
+                ASSERT( fixed.binaryEqual( BSON( "_id" << 5 << "x" << 1 << "y" << "payload" ) ) );
+            }
+        };
+
+        class ValidateAllFields : public Base {
+        public:
+            void run() {
+                // $-prefixed names are rejected even when they follow a zero
+                // Timestamp that needs fixing up
+                BSONObjBuilder b;
+                b.appendTimestamp( "a" );
+                b.append( "$bad", 1 );
+                ASSERT( !fixDocumentForInsert( b.done() ).isOK() );
+            }
+        };
+
+        class Relocate : public Base {
+        public:
+            void run() {
+                Collection* collection = _context.db()->getOrCreateCollection( ns() );
+
+                BSONObj doc = BSON( "_id" << 1 << "x" << "some payload" );
+                StatusWith<DiskLoc> inserted = collection->insertDocument( doc, true );
+                ASSERT( inserted.isOK() );
+                const uint64_t nBefore = collection->numRecords();
+
+                StatusWith<DiskLoc> relocated =
+                    collection->relocateDocument( inserted.getValue() );
+                ASSERT( relocated.isOK() );
+                ASSERT( relocated.getValue() != inserted.getValue() );
+
+                // same document, same count, just living somewhere else
+                ASSERT_EQUALS( 0, doc.woCompare( collection->docFor( relocated.getValue() ) ) );
+                ASSERT_EQUALS( nBefore, collection->numRecords() );
+            }
+        };
     } // namespace Insert
 
     class ExtentSizing {
@@ -200,6 +249,9 @@ namespace PdfileTests {
             add< Insert::InsertNoId >();
             add< Insert::UpdateDate >();
             add< Insert::ValidId >();
+            add< Insert::IdMovedToFront >();
+            add< Insert::ValidateAllFields >();
+            add< Insert::Relocate >();
             add< ExtentSizing >();
             add< CollectionOptionsRoundTrip >();
         }
@@ -41,9 +41,14 @@
 #include <fstream>
 
 #include "mongo/db/db.h"
+#include "mongo/db/dur.h"
 #include "mongo/db/dur_stats.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/extsort.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/structure/btree/key.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/taskqueue.h"
@@ -189,14 +194,39 @@ namespace PerfTests {
                 }
             }
         }
-        catch(...) { 
+        catch(...) {
             cout << "pstatsConnect() didn't work; ignoring" << endl;
         }
     }
 
+    /* load a --perfOut file for --perfBaseline: last recorded rps per test wins,
+       so appending several runs to one file compares against the most recent. */
+    map<string,double> loadPerfBaseline(const string& fn) {
+        map<string,double> m;
+        ifstream f(fn.c_str());
+        if( !f.good() ) {
+            cout << "warning: couldn't read perf baseline file " << fn << endl;
+            return m;
+        }
+        string line;
+        while( getline(f, line) ) {
+            if( line.empty() )
+                continue;
+            try {
+                BSONObj o = fromjson(line);
+                if( o["test"].type() == String && o["rps"].isNumber() )
+                    m[o["test"].String()] = o["rps"].Number();
+            }
+            catch( MsgAssertionException& ) {
+                // skip lines that aren't results; the file may be hand-edited
+            }
+        }
+        return m;
+    }
 
     class B : public ClientBase {
         string _ns;
+        unsigned long long _cyclesPerOp; // set by run() around the timed loop, consumed by say()
     protected:
         const char *ns() { return _ns.c_str(); }
 
@@ -223,15 +253,54 @@ namespace PerfTests {
         virtual bool showDurStats() { return true; }
 
     public:
+        B() : _cyclesPerOp(0) { }
+
         virtual unsigned batchSize() { return 50; }
 
         void say(unsigned long long n, int ms, string s) {
             unsigned long long rps = n*1000/ms;
-            cout << "stats " << setw(42) << left << s << ' ' << right << setw(9) << rps << ' ' << right << setw(5) << ms << "ms ";
+            unsigned long long cyclesPerOp = _cyclesPerOp;
+            _cyclesPerOp = 0; // one-shot; e.g. threaded runs don't measure cycles
+            cout << "stats " << setw(42) << left << s << ' ' << right << setw(9) << rps << ' ' << right << setw(5) << ms << "ms " << right << setw(9) << cyclesPerOp << ' ';
             if( showDurStats() )
                 cout << dur::stats.curr->_asCSV();
             cout << endl;
 
+            if( !frameworkGlobalParams.perfOut.empty() ) {
+                bob b;
+                b.append("test", s);
+                b.append("rps", (int) rps);
+                b.append("millis", ms);
+                if( cyclesPerOp )
+                    b.appendNumber("cyclesPerOp", (long long) cyclesPerOp);
+                b.appendBool("dur", storageGlobalParams.dur);
+                DEV b.appendBool("debug", true);
+                if( sizeof(int*) == 4 )
+                    b.append("bits", 32);
+                b.append("version", versionString);
+                b.append("git", gitVersion());
+                b.appendTimeT("when", time(0));
+                ofstream f(frameworkGlobalParams.perfOut.c_str(), ios::app);
+                if( f.good() )
+                    f << b.obj().jsonString() << '\n';
+                else
+                    cout << "warning: couldn't append to " << frameworkGlobalParams.perfOut << endl;
+            }
+
+            if( !frameworkGlobalParams.perfBaseline.empty() ) {
+                static map<string,double> baseline =
+                    loadPerfBaseline(frameworkGlobalParams.perfBaseline);
+                map<string,double>::const_iterator it = baseline.find(s);
+                if( it != baseline.end() && it->second > 0 ) {
+                    double ratio = rps / it->second;
+                    cout << "stats " << setw(42) << right << "new/baseline:" << ' '
+                         << right << setw(9) << fixed << setprecision(2) << ratio;
+                    if( ratio < 0.9 )
+                        cout << "  ** check for regression";
+                    cout << endl;
+                }
+            }
+
             if( conn && !conn->isFailed() ) {
                 const char *ns = "perf.pstats";
                 if(frameworkGlobalParams.perfHist) {
@@ -335,6 +404,7 @@ namespace PerfTests {
             n = 0;
             const unsigned int Batch = batchSize();
 
+            unsigned long long cyclesStart = cycleClock();
             if( hlm == 0 ) {
                 // means just do once
                 timed();
@@ -349,7 +419,9 @@ namespace PerfTests {
             }
 
             client().getLastError(); // block until all ops are finished
+            unsigned long long cycles = cycleClock() - cyclesStart;
             int ms = t.millis();
+            _cyclesPerOp = n ? cycles / n : 0;
 
             say(n, ms, name());
 
@@ -361,6 +433,7 @@ namespace PerfTests {
                     dur::stats.curr->reset();
                     mongo::Timer t;
                     unsigned long long n = 0;
+                    unsigned long long cyclesStart = cycleClock();
                     while( 1 ) {
                         unsigned int i;
                         for( i = 0; i < Batch; i++ )
@@ -369,6 +442,7 @@ namespace PerfTests {
                         if( t.millis() > hlm )
                             break;
                     }
+                    _cyclesPerOp = n ? ( cycleClock() - cyclesStart ) / n : 0;
                     int ms = t.millis();
                     say(n, ms, test2name);
                 }
@@ -1154,6 +1228,169 @@ namespace PerfTests {
         }
     };
 
+    /** 100-document batches through the insert write command, i.e. the batch
+        executor path rather than one wire message per document. */
+    class InsertBatch : public B {
+        int i;
+    public:
+        InsertBatch() : i(0) { }
+        string name() { return "insert-batch-100"; }
+        virtual unsigned batchSize() { return 1; }
+        void timed() {
+            BSONArrayBuilder docs;
+            for( int j = 0; j < 100; j++ )
+                docs.append( BSON( "_id" << i++ << "x" << 99 ) );
+            BSONObj res;
+            verify( client().runCommand( "perftest",
+                                         BSON( "insert" << str::after( ns(), '.' ) <<
+                                               "documents" << docs.arr() ),
+                                         res ) );
+        }
+        void post() {
+#if !defined(_DEBUG)
+            verify( client().count(ns()) >= 100 );
+#endif
+        }
+    };
+
+    /** matcher evaluation against an in-memory document: per-document cost of
+        a simple equality-and-range match, no storage involved. */
+    class MatchSimple : public B {
+        scoped_ptr<MatchExpression> _m;
+        BSONObj _doc;
+    public:
+        string name() { return "match-simple"; }
+        virtual int howLongMillis() { return 2000; }
+        virtual bool showDurStats() { return false; }
+        void prep() {
+            StatusWithMatchExpression s =
+                MatchExpressionParser::parse( BSON( "a" << 1 << "b" << GT << 2 ) );
+            verify( s.isOK() );
+            _m.reset( s.getValue() );
+            _doc = BSON( "a" << 1 << "b" << 5 <<
+                         "c" << "some padding so the document is not trivially small" );
+        }
+        void timed() {
+            verify( _m->matchesBSON( _doc ) );
+        }
+    };
+
+    /** same, but the match walks a dotted path into an array */
+    class MatchDotted : public B {
+        scoped_ptr<MatchExpression> _m;
+        BSONObj _doc;
+    public:
+        string name() { return "match-dotted-array"; }
+        virtual int howLongMillis() { return 2000; }
+        virtual bool showDurStats() { return false; }
+        void prep() {
+            StatusWithMatchExpression s =
+                MatchExpressionParser::parse( BSON( "x.y" << 3 ) );
+            verify( s.isOK() );
+            _m.reset( s.getValue() );
+            _doc = BSON( "x" << BSON_ARRAY( BSON( "y" << 1 ) <<
+                                            BSON( "y" << 2 ) <<
+                                            BSON( "y" << 3 ) ) );
+        }
+        void timed() {
+            verify( _m->matchesBSON( _doc ) );
+        }
+    };
+
+    /** point reads through an index: btree search plus document fetch, end to
+        end via findOne. */
+    class IndexedFindOne : public B {
+        enum { N = 10000 };
+    public:
+        string name() { return "btree-search-findOne"; }
+        virtual bool showDurStats() { return false; }
+        void prep() {
+            for( int i = 0; i < N; i++ )
+                client().insert( ns(), BSON( "x" << i << "y" << rand() ) );
+            client().ensureIndex( ns(), BSON( "x" << 1 ) );
+        }
+        void timed() {
+            verify( !client().findOne( ns(), QUERY( "x" << ( rand() % N ) ) ).isEmpty() );
+        }
+    };
+
+    /** full scan throughput through the exec stage directly, bypassing the
+        query layer above it */
+    class CollScanStage : public B {
+        enum { N = 1000 };
+    public:
+        string name() { return "stage-collscan-1000-docs"; }
+        virtual int howLongMillis() { return 2000; }
+        virtual unsigned batchSize() { return 1; }
+        virtual bool showDurStats() { return false; }
+        void prep() {
+            for( int i = 0; i < N; i++ )
+                client().insert( ns(), BSON( "x" << i ) );
+        }
+        void timed() {
+            Client::ReadContext ctx( ns() );
+            CollectionScanParams params;
+            params.ns = ns();
+            WorkingSet ws;
+            CollectionScan scan( params, &ws, NULL );
+            int n = 0;
+            while( !scan.isEOF() ) {
+                WorkingSetID id;
+                if( scan.work( &id ) == PlanStage::ADVANCED )
+                    n++;
+            }
+            verify( n == N );
+        }
+    };
+
+    /** external sort: feed shuffled keys through the sorter and drain the
+        merged iterator, as an index build's sort phase does */
+    class ExternalSort : public B {
+        enum { N = 10000 };
+        class Cmp : public ExternalSortComparison {
+        public:
+            virtual int compare(const ExternalSortDatum& l, const ExternalSortDatum& r) const {
+                return l.first.firstElement().numberInt() - r.first.firstElement().numberInt();
+            }
+        } _cmp;
+    public:
+        string name() { return "external-sort-10k"; }
+        virtual int howLongMillis() { return 2000; }
+        virtual unsigned batchSize() { return 1; }
+        virtual bool showDurStats() { return false; }
+        void timed() {
+            BSONObjExternalSorter sorter( &_cmp );
+            for( int i = 0; i < N; i++ )
+                sorter.add( BSON( "" << ( ( i * 9973 ) % N ) ), DiskLoc(), false );
+            sorter.sort( false );
+            auto_ptr<BSONObjExternalSorter::Iterator> it = sorter.iterator();
+            int n = 0, last = -1;
+            while( it->more() ) {
+                int v = it->next().first.firstElement().numberInt();
+                verify( v >= last );
+                last = v;
+                n++;
+            }
+            verify( n == N );
+        }
+    };
+
+    /** one forced group commit per op: journal commit latency.  only
+        registered when the suite runs with journaling on. */
+    class JournalCommit : public B {
+        int i;
+    public:
+        JournalCommit() : i(0) { }
+        string name() { return "journal-commit"; }
+        virtual int howLongMillis() { return 2000; }
+        virtual unsigned batchSize() { return 1; }
+        void timed() {
+            client().insert( ns(), BSON( "_id" << i++ << "x" << 3 ) );
+            Lock::GlobalWrite lk;
+            getDur().commitNow();
+        }
+    };
+
     // Tests what the worst case is for the overhead of enabling a fail point. If 'fpInjected'
     // is false, then the fail point will be compiled out. If 'fpInjected' is true, then the
     // fail point will be compiled in. Since the conditioned block is more or less trivial, any
@@ -1364,7 +1601,7 @@ namespace PerfTests {
         void setupTests() {
             pstatsConnect();
             cout
-                << "stats test                                       rps------  time-- "
+                << "stats test                                       rps------  time--  cyc/op--- "
                 << dur::stats.curr->_CSVHeader() << endl;
             if( profiling ) {
                 add< Insert1 >();
@@ -1437,6 +1674,14 @@ namespace PerfTests {
                 add< Update1 >();
                 add< MoreIndexes<Update1> >();
                 add< InsertBig >();
+                add< InsertBatch >();
+                add< MatchSimple >();
+                add< MatchDotted >();
+                add< IndexedFindOne >();
+                add< CollScanStage >();
+                add< ExternalSort >();
+                if (storageGlobalParams.dur)
+                    add< JournalCommit >();
                 add< FailPointTest<false, false> >();
                 add< FailPointTest<true, false> >();
                 add< FailPointTest<true, true> >();
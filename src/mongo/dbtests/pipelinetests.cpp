@@ -372,15 +372,18 @@ namespace PipelineTests {
                     // No new project should be added. This test reflects current behavior where the
                     // 'a' field is still sent because it is explicitly asked for, even though it
                     // isn't actually needed. If this changes in the future, this test will need to
-                    // change.
+                    // change. The $match keeps moveLimitBeforeSkipAndProject() from hoisting the
+                    // $limit in front of the $project.
                     string inputPipeJson() {
                         return "[{$project: {_id:true, a:true}}"
+                               ",{$match: {a:1}}"
                                ",{$limit:1}"
                                ",{$group: {_id: '$_id'}}"
                                "]";
                     }
                     string shardPipeJson() {
                         return "[{$project: {_id:true, a:true}}"
+                               ",{$match: {a:1}}"
                                ",{$limit:1}"
                                "]";
                     }
@@ -393,6 +396,94 @@ namespace PipelineTests {
 
             } // namespace limitFieldsSentFromShardsToMerger
         } // namespace Sharded
+
+        namespace Local {
+            class Base {
+            public:
+                // These both return json arrays of pipeline operators
+                virtual string inputPipeJson() = 0;
+                virtual string outputPipeJson() = 0;
+
+                BSONObj pipelineFromJsonArray(const string& array) {
+                    return fromjson("{pipeline: " + array + "}");
+                }
+                virtual void run() {
+                    const BSONObj inputBson = pipelineFromJsonArray(inputPipeJson());
+                    const BSONObj outputPipeExpected = pipelineFromJsonArray(outputPipeJson());
+
+                    intrusive_ptr<ExpressionContext> ctx =
+                        new ExpressionContext(InterruptStatusMongod::status,
+                                              NamespaceString("a.collection"));
+                    string errmsg;
+                    // parseCommand runs the local optimizations
+                    intrusive_ptr<Pipeline> pipe = Pipeline::parseCommand(errmsg, inputBson, ctx);
+                    ASSERT_EQUALS(errmsg, "");
+                    ASSERT(pipe != NULL);
+
+                    ASSERT_EQUALS(pipe->serialize()["pipeline"],
+                                  Value(outputPipeExpected["pipeline"]));
+                }
+
+                virtual ~Base() {};
+            };
+
+            namespace moveLimitBeforeSkipAndProject {
+
+                class LimitBeforeSkip : public Base {
+                    string inputPipeJson() { return "[{$skip: 3}, {$limit: 5}]"; }
+                    string outputPipeJson() { return "[{$limit: 8}, {$skip: 3}]"; }
+                };
+
+                class LimitBeforeProject : public Base {
+                    string inputPipeJson() {
+                        return "[{$project: {_id: true, a: true}}, {$limit: 5}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$limit: 5}, {$project: {_id: true, a: true}}]";
+                    }
+                };
+
+                class SortProjectLimitBecomesTopK : public Base {
+                    // the $limit reaches the $sort and bounds it (serialized as $sort then $limit)
+                    string inputPipeJson() {
+                        return "[{$sort: {a: 1}}"
+                               ",{$project: {_id: true, a: true}}"
+                               ",{$limit: 5}"
+                               "]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$sort: {a: 1}}"
+                               ",{$limit: 5}"
+                               ",{$project: {_id: true, a: true}}"
+                               "]";
+                    }
+                };
+
+                class SortSkipProjectLimitBecomesTopK : public Base {
+                    string inputPipeJson() {
+                        return "[{$sort: {a: 1}}"
+                               ",{$skip: 3}"
+                               ",{$project: {_id: true, a: true}}"
+                               ",{$limit: 5}"
+                               "]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$sort: {a: 1}}"
+                               ",{$limit: 8}"
+                               ",{$skip: 3}"
+                               ",{$project: {_id: true, a: true}}"
+                               "]";
+                    }
+                };
+
+                class LimitDoesNotHopMatch : public Base {
+                    // $match can drop documents, so the $limit must stay downstream of it
+                    string inputPipeJson() { return "[{$match: {a: 1}}, {$limit: 5}]"; }
+                    string outputPipeJson() { return "[{$match: {a: 1}}, {$limit: 5}]"; }
+                };
+
+            } // namespace moveLimitBeforeSkipAndProject
+        } // namespace Local
     } // namespace Optimizations
 
     class All : public Suite {
@@ -431,6 +522,11 @@ namespace PipelineTests {
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::NothingNeeded>();
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::JustNeedsMetadata>();
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::ShardAlreadyExhaustive>();
+            add<Optimizations::Local::moveLimitBeforeSkipAndProject::LimitBeforeSkip>();
+            add<Optimizations::Local::moveLimitBeforeSkipAndProject::LimitBeforeProject>();
+            add<Optimizations::Local::moveLimitBeforeSkipAndProject::SortProjectLimitBecomesTopK>();
+            add<Optimizations::Local::moveLimitBeforeSkipAndProject::SortSkipProjectLimitBecomesTopK>();
+            add<Optimizations::Local::moveLimitBeforeSkipAndProject::LimitDoesNotHopMatch>();
         }
     } myall;
     
@@ -31,6 +31,8 @@
  */
 
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
 #include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/instance.h"
@@ -38,6 +40,7 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/storage/extent_manager.h"
 #include "mongo/dbtests/dbtests.h"
 
 namespace QueryStageCollectionScan {
@@ -411,6 +414,192 @@ namespace QueryStageCollectionScan {
         }
     };
 
+    //
+    // Pull results through workBatch() and check they match the one-at-a-time scan.
+    //
+
+    class QueryStageCollscanBatchedWork : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            Client::ReadContext ctx(ns());
+
+            CollectionScanParams params;
+            params.ns = ns();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            BSONObj filterObj = BSON("foo" << BSON("$lt" << 25));
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            WorkingSet ws;
+            scoped_ptr<CollectionScan> scan(new CollectionScan(params, &ws, filterExpr.get()));
+
+            int count = 0;
+            while (!scan->isEOF()) {
+                vector<WorkingSetID> batch;
+                PlanStage::StageState state = scan->workBatch(16, &batch);
+                if (PlanStage::ADVANCED == state) {
+                    ASSERT_LESS_THAN_OR_EQUALS(batch.size(), 16U);
+                    for (size_t i = 0; i < batch.size(); ++i) {
+                        WorkingSetMember* member = ws.get(batch[i]);
+                        ASSERT(member->hasObj());
+                        // Batched results come back in scan order.
+                        ASSERT_EQUALS(count, member->obj["foo"].numberInt());
+                        ++count;
+                        ws.free(batch[i]);
+                    }
+                }
+                else {
+                    ASSERT(PlanStage::NEED_TIME == state || PlanStage::IS_EOF == state);
+                }
+            }
+
+            ASSERT_EQUALS(25, count);
+        }
+    };
+
+    //
+    // A cooperative scan started while another is in flight joins that scan's sweep
+    // partway through and wraps around, still returning every document exactly once.
+    //
+
+    class QueryStageCollscanCooperativeJoin : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            Client::ReadContext ctx(ns());
+            Collection* collection = ctx.ctx().db()->getCollection(ns());
+
+            scoped_ptr<CollectionIterator> leader(
+                collection->getIterator(DiskLoc(), false, CollectionScanParams::FORWARD,
+                                        false /*adviseDontNeed*/, true /*cooperative*/));
+
+            // Put the leader partway through the collection.
+            for (int i = 0; i < numObj() / 2; ++i) {
+                ASSERT(!leader->getNext().isNull());
+            }
+
+            // A second cooperative scan joins the leader's sweep...
+            scoped_ptr<CollectionIterator> joiner(
+                collection->getIterator(DiskLoc(), false, CollectionScanParams::FORWARD,
+                                        false, true));
+
+            // ...and still sees every document exactly once, possibly out of order.
+            set<int> seen;
+            int count = 0;
+            while (!joiner->isEOF()) {
+                DiskLoc loc = joiner->getNext();
+                seen.insert(loc.obj()["foo"].numberInt());
+                ++count;
+            }
+
+            ASSERT_EQUALS(numObj(), count);
+            ASSERT_EQUALS(numObj(), static_cast<int>(seen.size()));
+        }
+    };
+
+    //
+    // Deletes that empty the extent where a cooperative scan joined the sweep must not
+    // make its wrap-around leg overshoot the join point and re-emit documents: record
+    // traversal hops straight over the emptied (but still linked) extent, so the leg
+    // has to recognize the crossing from the extent chain instead.
+    //
+
+    class QueryStageCollscanCooperativeEmptiedJoinExtent {
+    public:
+        virtual ~QueryStageCollscanCooperativeEmptiedJoinExtent() {
+            Client::WriteContext ctx(ns());
+            _client.dropCollection(ns());
+        }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            Database* db = ctx.ctx().db();
+
+            // Several small extents with a few documents each, so the leader is
+            // partway through a middle extent when the second scan joins.
+            string err;
+            ASSERT( userCreateNS( ns(), fromjson( "{\"$nExtents\":[4096,4096,4096,4096,"
+                                                  "4096,4096,4096,4096]}" ), err, false ) );
+            const string pad( 700, 'x' );
+            for ( int i = 0; i < numObj(); ++i ) {
+                _client.insert( ns(), BSON( "foo" << i << "pad" << pad ) );
+            }
+
+            Collection* collection = db->getCollection( ns() );
+            const ExtentManager& em = db->getExtentManager();
+
+            scoped_ptr<CollectionIterator> leader(
+                collection->getIterator(DiskLoc(), false, CollectionScanParams::FORWARD,
+                                        false /*adviseDontNeed*/, true /*cooperative*/));
+
+            // Put the leader partway through the collection.
+            for (int i = 0; i < numObj() / 2; ++i) {
+                ASSERT(!leader->getNext().isNull());
+            }
+
+            // The second scan joins the sweep at the extent the leader is walking.
+            scoped_ptr<CollectionIterator> joiner(
+                collection->getIterator(DiskLoc(), false, CollectionScanParams::FORWARD,
+                                        false, true));
+            ASSERT(!joiner->isEOF());
+
+            DiskLoc loc = joiner->getNext();
+            const DiskLoc joinExtent = em.extentLocFor( loc );
+            ASSERT( joinExtent != nsdetails( ns() )->firstExtent() );
+
+            // Drain the pre-wrap leg -- the join extent through the end of the
+            // collection -- remembering which documents live in the join extent.
+            // Returning the last inserted document ends the leg; the iterator has
+            // then already wrapped, so its position is safely in the first extent.
+            set<int> seen;
+            vector<int> inJoinExtent;
+            while ( true ) {
+                int foo = loc.obj()["foo"].numberInt();
+                ASSERT( seen.insert( foo ).second );
+                if ( em.extentLocFor( loc ) == joinExtent ) {
+                    inJoinExtent.push_back( foo );
+                }
+                if ( foo == numObj() - 1 ) {
+                    break;
+                }
+                ASSERT( !joiner->isEOF() );
+                loc = joiner->getNext();
+            }
+            ASSERT( !joiner->isEOF() );
+            ASSERT( !inJoinExtent.empty() );
+
+            // Done with the leader; its position must not stay published across the
+            // deletes below.
+            leader.reset();
+
+            // Empty the join extent.  It stays linked in the extent chain, but a
+            // record walk now hops straight over it.
+            for ( size_t i = 0; i < inJoinExtent.size(); ++i ) {
+                _client.remove( ns(), BSON( "foo" << inJoinExtent[i] ) );
+            }
+
+            // The wrap-around leg returns only the documents before the join extent,
+            // each exactly once, and then stops -- it must not run on past the
+            // emptied join extent and re-emit the tail of the collection.
+            while ( !joiner->isEOF() ) {
+                loc = joiner->getNext();
+                ASSERT( seen.insert( loc.obj()["foo"].numberInt() ).second );
+            }
+            ASSERT_EQUALS( numObj(), static_cast<int>( seen.size() ) );
+        }
+
+        static int numObj() { return 48; }
+
+        static const char* ns() { return "unittests.QueryStageCollscanEmptiedJoinExtent"; }
+
+    private:
+        static DBDirectClient _client;
+    };
+
+    DBDirectClient QueryStageCollscanCooperativeEmptiedJoinExtent::_client;
+
     //
     // Get objects in the order we inserted them.
     //
@@ -614,6 +803,9 @@ namespace QueryStageCollectionScan {
             add<QueryStageCollscanBasicBackward>();
             add<QueryStageCollscanBasicForwardWithMatch>();
             add<QueryStageCollscanBasicBackwardWithMatch>();
+            add<QueryStageCollscanBatchedWork>();
+            add<QueryStageCollscanCooperativeJoin>();
+            add<QueryStageCollscanCooperativeEmptiedJoinExtent>();
             add<QueryStageCollscanObjectsInOrderForward>();
             add<QueryStageCollscanObjectsInOrderBackward>();
             add<QueryStageCollscanInvalidateUpcomingObject>();
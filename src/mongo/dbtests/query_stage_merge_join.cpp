@@ -0,0 +1,291 @@
+/**
+ *    Copyright (C) 2014 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/exec/merge_join.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/json.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/structure/collection_iterator.h"
+#include "mongo/dbtests/dbtests.h"
+
+/**
+ * This file tests db/exec/merge_join.cpp
+ */
+
+namespace QueryStageMergeJoinTests {
+
+    class QueryStageMergeJoinTestBase {
+    public:
+        QueryStageMergeJoinTestBase() { }
+
+        virtual ~QueryStageMergeJoinTestBase() {
+            Client::WriteContext ctx(leftNs());
+            _client.dropCollection(leftNs());
+            _client.dropCollection(rightNs());
+        }
+
+        void addIndex(const char* ns, const BSONObj& obj) {
+            _client.ensureIndex(ns, obj);
+        }
+
+        void insert(const char* ns, const BSONObj& obj) {
+            _client.insert(ns, obj);
+        }
+
+        Collection* getOrCreateCollection(Database* db, const char* ns) {
+            Collection* coll = db->getCollection(ns);
+            if (!coll) {
+                coll = db->createCollection(ns);
+            }
+            return coll;
+        }
+
+        void getLocs(set<DiskLoc>* out, Collection* coll) {
+            CollectionIterator* it = coll->getIterator(DiskLoc(), false,
+                                                       CollectionScanParams::FORWARD);
+            while (!it->isEOF()) {
+                DiskLoc nextLoc = it->getNext();
+                out->insert(nextLoc);
+            }
+            delete it;
+        }
+
+        // A full forward scan over 'keyPattern' on 'coll'.
+        IndexScan* makeIndexScan(Collection* coll, const BSONObj& keyPattern, WorkingSet* ws) {
+            IndexScanParams params;
+            params.descriptor = coll->getIndexCatalog()->findIndexByKeyPattern(keyPattern);
+            verify(params.descriptor);
+            params.bounds.isSimpleRange = true;
+            BSONObjBuilder startBob;
+            startBob.appendMinKey("");
+            params.bounds.startKey = startBob.obj();
+            BSONObjBuilder endBob;
+            endBob.appendMaxKey("");
+            params.bounds.endKey = endBob.obj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            return new IndexScan(params, ws, NULL);
+        }
+
+        static const char* leftNs() { return "unittests.QueryStageMergeJoinLeft"; }
+        static const char* rightNs() { return "unittests.QueryStageMergeJoinRight"; }
+    private:
+        static DBDirectClient _client;
+    };
+
+    DBDirectClient QueryStageMergeJoinTestBase::_client;
+
+    // Join {a: i} against {b: i} where only even i exist on the right.
+    class QueryStageMergeJoinBasic : public QueryStageMergeJoinTestBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(leftNs());
+            Database* db = ctx.ctx().db();
+            Collection* leftColl = getOrCreateCollection(db, leftNs());
+            Collection* rightColl = getOrCreateCollection(db, rightNs());
+
+            const int N = 20;
+            for (int i = 0; i < N; ++i) {
+                insert(leftNs(), BSON("a" << i));
+                if (0 == i % 2) {
+                    insert(rightNs(), BSON("b" << i));
+                }
+            }
+            addIndex(leftNs(), BSON("a" << 1));
+            addIndex(rightNs(), BSON("b" << 1));
+
+            WorkingSet* ws = new WorkingSet();
+            MergeJoinStageParams params;
+            MergeJoinStage* mj = new MergeJoinStage(params, ws, NULL,
+                                                    makeIndexScan(leftColl, BSON("a" << 1), ws),
+                                                    makeIndexScan(rightColl, BSON("b" << 1), ws));
+
+            // The stage emits owned {left: ..., right: ...} docs; no fetch needed.
+            PlanExecutor runner(ws, mj);
+
+            for (int i = 0; i < N; i += 2) {
+                BSONObj obj;
+                ASSERT_EQUALS(Runner::RUNNER_ADVANCED, runner.getNext(&obj, NULL));
+                ASSERT_EQUALS(i, obj["left"].Obj()["a"].numberInt());
+                ASSERT_EQUALS(i, obj["right"].Obj()["b"].numberInt());
+            }
+
+            BSONObj foo;
+            ASSERT_EQUALS(Runner::RUNNER_EOF, runner.getNext(&foo, NULL));
+        }
+    };
+
+    // Equal-key runs on both sides produce their cross product.
+    class QueryStageMergeJoinDups : public QueryStageMergeJoinTestBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(leftNs());
+            Database* db = ctx.ctx().db();
+            Collection* leftColl = getOrCreateCollection(db, leftNs());
+            Collection* rightColl = getOrCreateCollection(db, rightNs());
+
+            // Two left rows and three right rows with key 5, plus unmatched keys.
+            insert(leftNs(), BSON("a" << 3));
+            insert(leftNs(), BSON("a" << 5 << "tag" << 1));
+            insert(leftNs(), BSON("a" << 5 << "tag" << 2));
+            insert(rightNs(), BSON("b" << 5 << "tag" << 1));
+            insert(rightNs(), BSON("b" << 5 << "tag" << 2));
+            insert(rightNs(), BSON("b" << 5 << "tag" << 3));
+            insert(rightNs(), BSON("b" << 7));
+
+            addIndex(leftNs(), BSON("a" << 1));
+            addIndex(rightNs(), BSON("b" << 1));
+
+            WorkingSet* ws = new WorkingSet();
+            MergeJoinStageParams params;
+            MergeJoinStage* mj = new MergeJoinStage(params, ws, NULL,
+                                                    makeIndexScan(leftColl, BSON("a" << 1), ws),
+                                                    makeIndexScan(rightColl, BSON("b" << 1), ws));
+
+            PlanExecutor runner(ws, mj);
+
+            int count = 0;
+            for (BSONObj obj; Runner::RUNNER_ADVANCED == runner.getNext(&obj, NULL); ) {
+                ASSERT_EQUALS(5, obj["left"].Obj()["a"].numberInt());
+                ASSERT_EQUALS(5, obj["right"].Obj()["b"].numberInt());
+                ++count;
+            }
+            ASSERT_EQUALS(2 * 3, count);
+        }
+    };
+
+    // An empty side means no results, however much the other side has.
+    class QueryStageMergeJoinEmptySide : public QueryStageMergeJoinTestBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(leftNs());
+            Database* db = ctx.ctx().db();
+            Collection* leftColl = getOrCreateCollection(db, leftNs());
+            Collection* rightColl = getOrCreateCollection(db, rightNs());
+
+            for (int i = 0; i < 10; ++i) {
+                insert(leftNs(), BSON("a" << i));
+            }
+            addIndex(leftNs(), BSON("a" << 1));
+            addIndex(rightNs(), BSON("b" << 1));
+
+            WorkingSet* ws = new WorkingSet();
+            MergeJoinStageParams params;
+            MergeJoinStage* mj = new MergeJoinStage(params, ws, NULL,
+                                                    makeIndexScan(leftColl, BSON("a" << 1), ws),
+                                                    makeIndexScan(rightColl, BSON("b" << 1), ws));
+
+            PlanExecutor runner(ws, mj);
+
+            BSONObj foo;
+            ASSERT_EQUALS(Runner::RUNNER_EOF, runner.getNext(&foo, NULL));
+        }
+    };
+
+    // Invalidating a buffered row forces a fetch but doesn't lose the pair.
+    class QueryStageMergeJoinInvalidation : public QueryStageMergeJoinTestBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(leftNs());
+            Database* db = ctx.ctx().db();
+            Collection* leftColl = getOrCreateCollection(db, leftNs());
+            Collection* rightColl = getOrCreateCollection(db, rightNs());
+
+            insert(leftNs(), BSON("a" << 5));
+            insert(rightNs(), BSON("b" << 5 << "tag" << 1));
+            insert(rightNs(), BSON("b" << 5 << "tag" << 2));
+
+            addIndex(leftNs(), BSON("a" << 1));
+            addIndex(rightNs(), BSON("b" << 1));
+
+            WorkingSet ws;
+            MergeJoinStageParams params;
+            auto_ptr<MergeJoinStage> mj(
+                new MergeJoinStage(params, &ws, NULL,
+                                   makeIndexScan(leftColl, BSON("a" << 1), &ws),
+                                   makeIndexScan(rightColl, BSON("b" << 1), &ws)));
+
+            // Work the stage until the equal-key runs have been seeded.
+            while (!mj->isEOF()) {
+                scoped_ptr<PlanStageStats> stats(mj->getStats());
+                const MergeJoinStats* mjs =
+                    static_cast<const MergeJoinStats*>(stats->specific.get());
+                if (mjs->runsMatched > 0) { break; }
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                mj->work(&id);
+            }
+
+            // Invalidate everything on the right side while buffered.
+            set<DiskLoc> locs;
+            getLocs(&locs, rightColl);
+            mj->prepareToYield();
+            for (set<DiskLoc>::iterator it = locs.begin(); it != locs.end(); ++it) {
+                mj->invalidate(*it, INVALIDATION_DELETION);
+            }
+            mj->recoverFromYield();
+
+            // We should still get both pairs, with the right docs intact.
+            int count = 0;
+            while (!mj->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState status = mj->work(&id);
+                if (PlanStage::ADVANCED != status) { continue; }
+
+                WorkingSetMember* member = ws.get(id);
+                ASSERT(member->hasObj());
+                ASSERT_EQUALS(5, member->obj["left"].Obj()["a"].numberInt());
+                ASSERT_EQUALS(5, member->obj["right"].Obj()["b"].numberInt());
+                ++count;
+            }
+            ASSERT_EQUALS(2, count);
+
+            scoped_ptr<PlanStageStats> stats(mj->getStats());
+            const MergeJoinStats* mjs =
+                static_cast<const MergeJoinStats*>(stats->specific.get());
+            ASSERT_GREATER_THAN_OR_EQUALS(mjs->forcedFetches, 1U);
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "query_stage_merge_join_test" ) { }
+
+        void setupTests() {
+            add<QueryStageMergeJoinBasic>();
+            add<QueryStageMergeJoinDups>();
+            add<QueryStageMergeJoinEmptySide>();
+            add<QueryStageMergeJoinInvalidation>();
+        }
+    }  queryStageMergeJoinTest;
+
+}  // namespace
@@ -0,0 +1,144 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * This file tests db/exec/projection.cpp, in particular the covered fast
+ * path that builds results straight from index keys.
+ */
+
+#include "mongo/db/exec/mock_stage.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/json.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace QueryStageProjection {
+
+    class QueryStageProjectionBase {
+    public:
+        virtual ~QueryStageProjectionBase() { }
+
+        /**
+         * Runs 'projSpec' over a mocked child returning one covered result
+         * with the given key, and returns the projected object.
+         */
+        BSONObj projectCovered(const BSONObj& projSpec,
+                               const BSONObj& keyPattern,
+                               const BSONObj& key) {
+            WorkingSet ws;
+            auto_ptr<MockStage> mock(new MockStage(&ws));
+
+            WorkingSetMember member;
+            member.state = WorkingSetMember::LOC_AND_IDX;
+            member.keyData.push_back(IndexKeyDatum(keyPattern, key));
+            mock->pushBack(member);
+
+            ProjectionStage proj(projSpec, NULL, &ws, mock.release());
+            return getNextResult(&proj, &ws);
+        }
+
+        BSONObj getNextResult(PlanStage* stage, WorkingSet* ws) {
+            while (!stage->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState status = stage->work(&id);
+                if (PlanStage::ADVANCED == status) {
+                    WorkingSetMember* member = ws->get(id);
+                    verify(member->hasObj());
+                    return member->obj;
+                }
+                verify(PlanStage::FAILURE != status);
+            }
+            return BSONObj();
+        }
+    };
+
+    //
+    // Covered inclusion projections serialize straight from the index key.
+    //
+    class ProjectFromIndexKey : public QueryStageProjectionBase {
+    public:
+        void run() {
+            // Values come from the key, named by the pattern's fields.
+            BSONObj out = projectCovered(fromjson("{a: 1, b: 1, _id: 0}"),
+                                         BSON("a" << 1 << "b" << 1),
+                                         BSON("" << 5 << "" << "ten"));
+            ASSERT_EQUALS(0, out.woCompare(fromjson("{a: 5, b: 'ten'}")));
+
+            // The projection can ask for a subset of the key, in its own order.
+            out = projectCovered(fromjson("{b: 1, _id: 0}"),
+                                 BSON("a" << 1 << "b" << 1),
+                                 BSON("" << 5 << "" << "ten"));
+            ASSERT_EQUALS(0, out.woCompare(fromjson("{b: 'ten'}")));
+
+            // _id comes first when the key covers it, wherever the spec put it.
+            out = projectCovered(fromjson("{a: 1, _id: 1}"),
+                                 BSON("a" << 1 << "_id" << 1),
+                                 BSON("" << 5 << "" << 7));
+            ASSERT_EQUALS(0, out.woCompare(fromjson("{_id: 7, a: 5}")));
+
+            // Fields the key doesn't cover are dropped, like getFieldDotted
+            // would do - including an _id that isn't in the index.
+            out = projectCovered(fromjson("{a: 1, c: 1}"),
+                                 BSON("a" << 1 << "b" << 1),
+                                 BSON("" << 5 << "" << "ten"));
+            ASSERT_EQUALS(0, out.woCompare(fromjson("{a: 5}")));
+        }
+    };
+
+    //
+    // Results carrying a document still go through the general transform.
+    //
+    class ProjectFromObject : public QueryStageProjectionBase {
+    public:
+        void run() {
+            WorkingSet ws;
+            auto_ptr<MockStage> mock(new MockStage(&ws));
+
+            WorkingSetMember member;
+            member.state = WorkingSetMember::OWNED_OBJ;
+            member.obj = fromjson("{_id: 1, a: 5, b: 'ten'}");
+            mock->pushBack(member);
+
+            ProjectionStage proj(fromjson("{a: 1, _id: 0}"), NULL, &ws, mock.release());
+            BSONObj out = getNextResult(&proj, &ws);
+            ASSERT_EQUALS(0, out.woCompare(fromjson("{a: 5}")));
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "query_stage_projection" ) { }
+
+        void setupTests() {
+            add<ProjectFromIndexKey>();
+            add<ProjectFromObject>();
+        }
+    }  queryStageProjectionAll;
+
+}  // namespace QueryStageProjection
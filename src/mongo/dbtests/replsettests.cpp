@@ -898,6 +898,51 @@ namespace ReplSetTests {
         }
     };
 
+    class ResolveDuplicateKey : public Base {
+    public:
+        void run() {
+            drop();
+
+            client()->ensureIndex(ns(), BSON("a" << 1), true /* unique */);
+            insert(BSON("_id" << "stale" << "a" << 1));
+
+            BSONObjBuilder b;
+            {
+                mongo::mutex::scoped_lock lk2(OpTime::m);
+                b.appendTimestamp("ts", OpTime::now(lk2).asLL());
+            }
+            b.append("h", 1LL);
+            b.append("op", "i");
+            b.append("ns", ns());
+            b.append("o", BSON("_id" << "fresh" << "a" << 1));
+            BSONObj op = b.obj();
+
+            Lock::GlobalWrite lk;
+            Sync s("");
+
+            // an update isn't self-contained, so it can't be resolved locally
+            BSONObj up = BSON("ts" << op["ts"] << "h" << 1LL << "op" << "u"
+                                   << "ns" << ns() << "o" << BSON("a" << 1)
+                                   << "o2" << BSON("_id" << "fresh"));
+            verify(!s.resolveDuplicateKey(up));
+
+            // the insert resolves by removing the stale key holder
+            verify(s.resolveDuplicateKey(op));
+            {
+                Client::Context ctx(ns());
+                verify(!applyOperation_inlock(op, true));
+            }
+            verify(findOne(BSON("_id" << "stale")).isEmpty());
+            verify(!findOne(BSON("_id" << "fresh")).isEmpty());
+
+            // initial sync never resolves locally; cloned docs may be newer
+            replset::InitialSync init(0);
+            verify(!init.resolveDuplicateKey(op));
+
+            drop();
+        }
+    };
+
     class CappedInitialSync : public Base {
         string _cappedNs;
         Lock::DBWrite _lk;
@@ -1169,6 +1214,7 @@ namespace ReplSetTests {
             Base::setup();
             add< TestInitApplyOp >();
             add< TestInitApplyOp2 >();
+            add< ResolveDuplicateKey >();
             add< CappedInitialSync >();
             add< CappedUpdate >();
             add< CappedInsert >();
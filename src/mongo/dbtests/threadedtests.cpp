@@ -40,6 +40,7 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mvar.h"
 #include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/work_stealing_pool.h"
 #include "mongo/util/concurrency/list.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/concurrency/synchronization.h"
@@ -385,6 +386,39 @@ namespace ThreadedTests {
         }
     };
 
+    class WorkStealingPoolTest {
+        static const unsigned iterations = 10000;
+        static const unsigned nThreads = 8;
+
+        AtomicUInt32 counter;
+        void increment(unsigned n) {
+            for (unsigned i=0; i<n; i++) {
+                counter.fetchAndAdd(1);
+            }
+        }
+
+    public:
+        void run() {
+            WorkStealingPool tp(nThreads);
+
+            for (unsigned i=0; i < iterations; i++) {
+                // alternate hinted and unhinted scheduling so both paths and
+                // the stealing of hinted tasks get exercised
+                if (i % 2 == 0) {
+                    tp.scheduleOn(i, boost::bind(&WorkStealingPoolTest::increment,
+                                                 this, 2u));
+                }
+                else {
+                    tp.schedule(&WorkStealingPoolTest::increment, this, 2);
+                }
+            }
+
+            tp.join();
+
+            ASSERT_EQUALS(counter.load(), iterations * 2);
+        }
+    };
+
     class LockTest {
     public:
         void run() {
@@ -863,6 +897,46 @@ namespace ThreadedTests {
         }
     };
 
+    // Two writers of different collections in one database only conflict at
+    // the database lock when collection-level locking is compiled out; with
+    // MONGOD_CONCURRENCY_LEVEL_COLLECTION they proceed in parallel.  A second
+    // writer of the *same* collection waits under either build.
+    class CollectionWriteParallel : public ThreadedTest<3> {
+    public:
+        CollectionWriteParallel() : _holding(false) { }
+    private:
+        volatile bool _holding;
+        virtual void validate() { }
+        virtual void subthread(int x) {
+            Client::initThread("cwtest");
+            if( x == 1 ) {
+                Lock::CollectionWrite lk("unittests_cw.a");
+                _holding = true;
+                sleepmillis(300);
+                _holding = false;
+            }
+            if( x == 2 ) {
+                sleepmillis(100);
+                Lock::CollectionWrite lk("unittests_cw.b");
+                if( Lock::collectionLevelLockingEnabled() ) {
+                    // got in while thread 1 still holds collection a
+                    verify( _holding );
+                }
+                else {
+                    // degraded to a db lock, so we waited thread 1 out
+                    verify( !_holding );
+                }
+            }
+            if( x == 3 ) {
+                sleepmillis(100);
+                Timer t;
+                Lock::CollectionWrite lk("unittests_cw.a");
+                ASSERT( t.millis() > 100 );
+            }
+            cc().shutdown();
+        }
+    };
+
     class QLockTest : public ThreadedTest<3> {
     public:
         bool gotW;
@@ -907,8 +981,10 @@ namespace ThreadedTests {
         }
     };
 
-    // Tests waiting on the TicketHolder by running many more threads than can fit into the "hotel", but only
-    // max _nRooms threads should ever get in at once
+    // Tests waiting on a ticket holder by running many more threads than can fit into the "hotel", but only
+    // max _nRooms threads should ever get in at once.  Templated so the classic mutex-based
+    // TicketHolder and the CAS-based FastTicketHolder run the same scenario.
+    template< class HolderType >
     class TicketHolderWaits : public ThreadedTest<10> {
 
         static const int checkIns = 1000;
@@ -943,7 +1019,7 @@ namespace ThreadedTests {
         };
 
         Hotel _hotel;
-        TicketHolder _tickets;
+        HolderType _tickets;
 
         virtual void subthread(int x) {
 
@@ -953,7 +1029,6 @@ namespace ThreadedTests {
             for( int i = 0; i < checkIns; i++ ){
 
                 _tickets.waitForTicket();
-                TicketHolderReleaser whenDone( &_tickets );
 
                 _hotel.checkIn();
 
@@ -962,6 +1037,8 @@ namespace ThreadedTests {
 
                 _hotel.checkOut();
 
+                _tickets.release();
+
                 if( ( i % ( checkIns / 10 ) ) == 0 )
                     mongo::unittest::log() << "checked in " << i << " times..." << endl;
 
@@ -987,6 +1064,7 @@ namespace ThreadedTests {
 
         void setupTests() {
             add< WriteLocksAreGreedy >();
+            add< CollectionWriteParallel >();
             add< QLockTest >();
             add< QLockTest >();
 
@@ -1007,6 +1085,7 @@ namespace ThreadedTests {
             add< IsAtomicWordAtomic<AtomicUInt64> >();
             add< MVarTest >();
             add< ThreadPoolTest >();
+            add< WorkStealingPoolTest >();
             add< LockTest >();
 
 
@@ -1016,7 +1095,8 @@ namespace ThreadedTests {
             add< RWLockTest4 >();
 
             add< MongoMutexTest >();
-            add< TicketHolderWaits >();
+            add< TicketHolderWaits<TicketHolder> >();
+            add< TicketHolderWaits<FastTicketHolder> >();
         }
     } myall;
 }
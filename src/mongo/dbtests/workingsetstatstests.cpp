@@ -0,0 +1,106 @@
+// workingsetstatstests.cpp : db/stats/working_set_stats.{h,cpp} unit tests
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/working_set_stats.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace WorkingSetStatsTests {
+
+    BSONObj collectionsOf( WorkingSetStats& stats ) {
+        BSONObjBuilder b;
+        stats.append( b );
+        return b.obj()["collections"].Obj().getOwned();
+    }
+
+    class Rates {
+    public:
+        void run() {
+            WorkingSetStats stats;
+            // 4 touches of 2 distinct pages, 3 of them resident
+            stats.record( "test.a", false, true );
+            stats.record( "test.a", true, true );
+            stats.record( "test.a", true, false );
+            stats.record( "test.a", true, false );
+
+            BSONObj a = collectionsOf( stats )["test.a"].Obj();
+            ASSERT_EQUALS( 4, a["accessesSampled"].numberLong() );
+            ASSERT_EQUALS( 2, a["pagesTouched"].numberLong() );
+            ASSERT_EQUALS( 2 * 4096, a["estimatedRamBytes"].numberLong() );
+            ASSERT_APPROX_EQUAL( 0.75, a["residentRate"].number(), 1e-10 );
+            ASSERT_APPROX_EQUAL( 0.5, a["reuseRate"].number(), 1e-10 );
+            ASSERT( a["evictionCandidate"].eoo() );
+        }
+    };
+
+    class EvictionCandidate {
+    public:
+        void run() {
+            WorkingSetStats stats;
+            // a cold scan: every page new, nothing found in memory
+            for ( int i = 0; i < 1000; i++ ) {
+                stats.record( "test.scanned", false, true );
+                stats.record( "test.hot", true, false );
+            }
+
+            BSONObj colls = collectionsOf( stats );
+            ASSERT( colls["test.scanned"].Obj()["evictionCandidate"].trueValue() );
+            ASSERT( colls["test.hot"].Obj()["evictionCandidate"].eoo() );
+        }
+    };
+
+    class Dropped {
+    public:
+        void run() {
+            WorkingSetStats stats;
+            stats.record( "test.a", true, true );
+            stats.record( "test.b", true, true );
+            stats.collectionDropped( "test.a" );
+
+            BSONObj colls = collectionsOf( stats );
+            // empty namespaces are skipped, so the dropped one disappears
+            ASSERT( colls["test.a"].eoo() );
+            ASSERT_EQUALS( 1, colls["test.b"].Obj()["accessesSampled"].numberLong() );
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "workingsetstats" ) {}
+
+        void setupTests() {
+            add< Rates >();
+            add< EvictionCandidate >();
+            add< Dropped >();
+        }
+    } myall;
+
+}  // namespace WorkingSetStatsTests
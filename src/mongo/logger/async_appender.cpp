@@ -0,0 +1,93 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_appender.h"
+
+#include <boost/bind.hpp>
+
+namespace mongo {
+namespace logger {
+
+namespace {
+
+    // Cap on the bytes of message text queued ahead of the writer thread.
+    // Large enough to absorb bursts, small enough that a wedged sink makes
+    // emitting threads block rather than the queue eat the heap.
+    const size_t maxQueuedBytes = 16 * 1024 * 1024;
+
+}  // namespace
+
+    AsyncAppender::AsyncAppender(Appender<MessageEventEphemeral>* wrapped)
+        : _wrapped(wrapped),
+          _queuedBytes(0),
+          _shutdown(false) {
+
+        _writer = boost::thread(boost::bind(&AsyncAppender::_writerThread, this));
+    }
+
+    AsyncAppender::~AsyncAppender() {
+        {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            _shutdown = true;
+            _notEmpty.notify_one();
+        }
+        _writer.join();  // the writer drains the queue before exiting
+    }
+
+    Status AsyncAppender::append(const MessageEventEphemeral& event) {
+        QueuedEvent queued(event.getDate(),
+                           event.getSeverity(),
+                           event.getContextName().toString(),
+                           event.getMessage().toString());
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (_queuedBytes >= maxQueuedBytes && !_shutdown) {
+            _notFull.wait(lk);
+        }
+        _queuedBytes += queued.message.size();
+        _queue.push_back(queued);
+        _notEmpty.notify_one();
+        return Status::OK();
+    }
+
+    void AsyncAppender::_writerThread() {
+        while (true) {
+            std::deque<QueuedEvent> batch;
+            {
+                boost::unique_lock<boost::mutex> lk(_mutex);
+                while (_queue.empty() && !_shutdown) {
+                    _notEmpty.wait(lk);
+                }
+                if (_queue.empty())
+                    return;
+                batch.swap(_queue);
+                _queuedBytes = 0;
+                _notFull.notify_all();
+            }
+            for (std::deque<QueuedEvent>::const_iterator i = batch.begin();
+                 i != batch.end(); ++i) {
+
+                MessageEventEphemeral event(
+                        i->date, i->severity, i->contextName, i->message);
+                // As in LogstreamBuilder's destructor, there is nowhere to
+                // report an append failure, so the status is discarded.
+                _wrapped->append(event);
+            }
+        }
+    }
+
+}  // namespace logger
+}  // namespace mongo
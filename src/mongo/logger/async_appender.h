@@ -0,0 +1,90 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/logger/appender.h"
+#include "mongo/logger/message_event.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Decorator that makes a downstream appender asynchronous.  append()
+     * copies the event onto a bounded in-memory queue and returns; a single
+     * writer thread drains the queue into the wrapped appender.  Encoding
+     * (timestamp and severity formatting) and the write itself thus happen
+     * on the writer thread rather than the thread emitting the message, and
+     * emitting threads never contend on the sink's mutex.
+     *
+     * If the queue is full, append() blocks until the writer catches up, so
+     * messages are never dropped.  The destructor drains the queue before
+     * joining the writer thread.  Messages still queued when the process
+     * aborts (rather than exiting cleanly) are lost; code that must have a
+     * message on disk before proceeding should not log through one of these.
+     */
+    class AsyncAppender : public Appender<MessageEventEphemeral> {
+        MONGO_DISALLOW_COPYING(AsyncAppender);
+
+    public:
+        /**
+         * Takes ownership of "wrapped".
+         */
+        explicit AsyncAppender(Appender<MessageEventEphemeral>* wrapped);
+        virtual ~AsyncAppender();
+
+        virtual Status append(const MessageEventEphemeral& event);
+
+    private:
+        // Owns the storage behind its fields, unlike MessageEventEphemeral,
+        // whose strings may point into the emitting thread's buffers.
+        struct QueuedEvent {
+            QueuedEvent(Date_t date,
+                        LogSeverity severity,
+                        const std::string& contextName,
+                        const std::string& message)
+                : date(date), severity(severity), contextName(contextName), message(message) {}
+
+            Date_t date;
+            LogSeverity severity;
+            std::string contextName;
+            std::string message;
+        };
+
+        void _writerThread();
+
+        boost::scoped_ptr<Appender<MessageEventEphemeral> > _wrapped;
+
+        boost::mutex _mutex; // guards everything below
+        boost::condition_variable _notEmpty;
+        boost::condition_variable _notFull;
+        std::deque<QueuedEvent> _queue;
+        size_t _queuedBytes;
+        bool _shutdown;
+
+        boost::thread _writer; // started last, in the constructor body
+    };
+
+}  // namespace logger
+}  // namespace mongo
@@ -22,16 +22,52 @@
 #include "mongo/base/init.h"
 #include "mongo/base/status.h"
 #include "mongo/logger/message_event_utf8_encoder.h"
+#include "mongo/util/async_sink.h"
 #include "mongo/util/mongoutils/html.h"
 #include "mongo/util/map_util.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
+
+    /**
+     * A line bound for a RamLog, queued behind the shared writer thread.
+     * RamLogs are leaked, never deleted, so the raw pointer stays valid.
+     *
+     * Named (rather than in the anonymous namespace) so it can instantiate
+     * AsyncSink and RamLogWriter can be a friend of RamLog.
+     */
+    struct RamLogLine {
+        RamLogLine() : log(NULL) {}
+        RamLogLine(RamLog* log, const std::string& line) : log(log), line(line) {}
+
+        RamLog* log;
+        std::string line;
+    };
+
+    /**
+     * Copies queued lines into their RamLogs' line buffers.  A single drainer
+     * keeps lines in write order; per-RamLog mutexes are then only ever
+     * contended by readers.
+     */
+    class RamLogWriter : public AsyncSink<RamLogLine> {
+    public:
+        RamLogWriter() : AsyncSink<RamLogLine>("ramlog writer", 4096) {}
+
+    protected:
+        virtual void consume(const RamLogLine& entry) {
+            entry.log->writeSync(entry.line);
+        }
+    };
+
 namespace {
     typedef std::map<string,RamLog*> RM;
     mongo::mutex* _namedLock = NULL;
     RM*  _named = NULL;
 
+    // Set once by RamLog::startAsyncWrites() during startup, read-only
+    // thereafter.  Leaked, like the RamLogs themselves.
+    RamLogWriter* _writer = NULL;
+
 }  // namespace
 
     using namespace mongoutils;
@@ -46,6 +82,14 @@ namespace {
     RamLog::~RamLog() {}
 
     void RamLog::write(const std::string& str) {
+        if (_writer) {
+            _writer->push(RamLogLine(this, str));
+            return;
+        }
+        writeSync(str);
+    }
+
+    void RamLog::writeSync(const std::string& str) {
         boost::lock_guard<boost::mutex> lk(_mutex);
         _lastWrite = time(0);
         _totalLinesWritten++;
@@ -190,6 +234,13 @@ namespace {
     // static things
     // ---------------
 
+    void RamLog::startAsyncWrites() {
+        if (!_writer) {
+            _writer = new RamLogWriter();
+            _writer->start();
+        }
+    }
+
     RamLog* RamLog::get(const std::string& name) {
         if (!_namedLock) {
             // Guaranteed to happen before multi-threaded operation.
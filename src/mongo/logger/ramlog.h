@@ -74,12 +74,22 @@ namespace mongo {
          */
         static void getNames( std::vector<std::string>& names );
 
+        /**
+         * Spawns the single background thread that performs all RamLog line
+         * copies, making write() a bounded enqueue on the calling thread.
+         * Call at most once, during startup; processes that never call it
+         * keep fully synchronous writes.
+         */
+        static void startAsyncWrites();
+
         /**
          * Writes "str" as a line into the RamLog.  If "str" is longer than the maximum
          * line size, RamLog::C, truncates the line to the first C bytes.  If "str"
          * is shorter than RamLog::C and has a terminal '\n', it omits that character.
          *
-         * Synchronized on the instance's own mutex, _mutex.
+         * After startAsyncWrites(), queues the line for the shared writer thread
+         * and returns; readers may then see a line a moment after it was written.
+         * Otherwise, synchronized on the instance's own mutex, _mutex.
          */
         void write(const std::string& str);
 
@@ -92,6 +102,8 @@ namespace mongo {
         void toHTML(std::stringstream& s);
 
     private:
+        friend class RamLogWriter;
+
         static int repeats(const std::vector<const char *>& v, int i);
         static string clean(const std::vector<const char *>& v, int i, string line="");
         static string color(const std::string& line);
@@ -109,6 +121,12 @@ namespace mongo {
 
         const char* getLine_inlock(unsigned lineNumber) const;
 
+        /**
+         * Copies "str" into the line buffer, synchronously.  The body of the
+         * pre-startAsyncWrites() write(); also what the writer thread calls.
+         */
+        void writeSync(const std::string& str);
+
         boost::mutex _mutex;  // Guards all non-static data.
         char lines[N][C];
         unsigned h; // current position
@@ -296,6 +296,20 @@ namespace mongo {
 
             DistributionStatus status( shardInfo, shardToChunksMap );
 
+            // ask each shard how hot this collection is there, so the policy can
+            // weigh migration candidates by load and not just chunk count
+            for ( vector<Shard>::const_iterator i = allShards.begin(); i != allShards.end(); ++i ) {
+                try {
+                    BSONObj res = i->runCommand( "admin", BSON( "collectionLoad" << ns ) );
+                    status.setLoadForShard( i->getName(), res["loadMicros"].numberLong() );
+                }
+                catch ( const DBException& e ) {
+                    // old shards don't have the command; they just balance by count
+                    LOG(1) << "could not get collection load for " << ns
+                           << " from " << i->getName() << causedBy( e ) << endl;
+                }
+            }
+
             // load tags
             Status result = clusterCreateIndex(TagsType::ConfigNS,
                                                BSON(TagsType::ns() << 1 << TagsType::min() << 1),
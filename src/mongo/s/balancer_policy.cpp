@@ -58,6 +58,17 @@ namespace mongo {
         return i->second;
     }
 
+    void DistributionStatus::setLoadForShard( const string& shard, long long load ) {
+        _shardLoad[shard] = load;
+    }
+
+    long long DistributionStatus::loadForShard( const string& shard ) const {
+        map<string,long long>::const_iterator i = _shardLoad.find( shard );
+        if ( i == _shardLoad.end() )
+            return 0;
+        return i->second;
+    }
+
     unsigned DistributionStatus::totalChunks() const {
         unsigned total = 0;
         for ( ShardToChunksMap::const_iterator i = _shardChunks.begin(); i != _shardChunks.end(); ++i )
@@ -88,6 +99,7 @@ namespace mongo {
     string DistributionStatus::getBestReceieverShard( const string& tag ) const {
         string best;
         unsigned minChunks = numeric_limits<unsigned>::max();
+        long long bestLoad = 0;
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
             if ( i->second.isSizeMaxed() ) {
@@ -111,13 +123,22 @@ namespace mongo {
             }
 
             unsigned myChunks = numberOfChunksInShard( i->first );
-            if ( myChunks >= minChunks ) {
+            if ( myChunks > minChunks ) {
                 LOG(1) << i->first << " has more chunks me:" << myChunks << " best: " << best << ":" << minChunks << endl;
                 continue;
             }
 
+            // break chunk-count ties towards the shard serving less of this collection
+            long long myLoad = loadForShard( i->first );
+            if ( myChunks == minChunks && best.size() > 0 && myLoad >= bestLoad ) {
+                LOG(1) << i->first << " is as full as and hotter than " << best
+                       << " (load " << myLoad << " vs " << bestLoad << ")" << endl;
+                continue;
+            }
+
             best = i->first;
             minChunks = myChunks;
+            bestLoad = myLoad;
         }
 
         return best;
@@ -126,6 +147,7 @@ namespace mongo {
     string DistributionStatus::getMostOverloadedShard( const string& tag ) const {
         string worst;
         unsigned maxChunks = 0;
+        long long worstLoad = 0;
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
 
@@ -135,11 +157,17 @@ namespace mongo {
             }
 
             unsigned myChunks = numberOfChunksInShardWithTag( i->first, tag );
-            if ( myChunks <= maxChunks )
+            if ( myChunks == 0 || myChunks < maxChunks )
+                continue;
+
+            // break chunk-count ties towards the shard serving more of this collection
+            long long myLoad = loadForShard( i->first );
+            if ( myChunks == maxChunks && worst.size() > 0 && myLoad <= worstLoad )
                 continue;
 
             worst = i->first;
             maxChunks = myChunks;
+            worstLoad = myLoad;
         }
 
         return worst;
@@ -224,6 +252,13 @@ namespace mongo {
         }
     }
 
+    // a load-triggered move needs the donor to be serving at least this many
+    // times the receiver's load for this collection...
+    static const long long kLoadImbalanceFactor = 4;
+    // ...and to have done at least this much cumulative work, so an idle
+    // collection never migrates on noise
+    static const long long kLoadMoveMinMicros = 1000 * 1000;
+
     bool BalancerPolicy::_isJumbo( const BSONObj& chunk ) {
         if ( chunk[ChunkType::jumbo()].trueValue() ) {
             LOG(1) << "chunk: " << chunk << "is marked as jumbo" << endl;
@@ -374,13 +409,33 @@ namespace mongo {
 
             const int imbalance = max - min;
 
+            const long long fromLoad = distribution.loadForShard( from );
+            const long long toLoad = distribution.loadForShard( to );
+
             LOG(1) << "collection : " << ns << endl;
-            LOG(1) << "donor      : " << from << " chunks on " << max << endl;
-            LOG(1) << "receiver   : " << to << " chunks on " << min << endl;
+            LOG(1) << "donor      : " << from << " chunks on " << max
+                   << " load " << fromLoad << endl;
+            LOG(1) << "receiver   : " << to << " chunks on " << min
+                   << " load " << toLoad << endl;
             LOG(1) << "threshold  : " << threshold << endl;
 
-            if ( imbalance < threshold )
-                continue;
+            if ( imbalance < threshold ) {
+                // counts alone don't justify a move, but a donor that is both
+                // ahead on chunks and much hotter than the receiver should
+                // still shed one; requiring imbalance >= 1 keeps this from
+                // ever fighting the count-based rule above
+                if ( imbalance >= 1 &&
+                     fromLoad >= kLoadMoveMinMicros &&
+                     fromLoad >= kLoadImbalanceFactor * toLoad ) {
+                    log() << "ns: " << ns << " shard " << from
+                          << " is serving " << fromLoad << " micros of load vs "
+                          << toLoad << " on " << to
+                          << ", moving a chunk to spread the heat" << endl;
+                }
+                else {
+                    continue;
+                }
+            }
 
             const vector<BSONObj>& chunks = distribution.getChunks( from );
             unsigned numJumboChunks = 0;
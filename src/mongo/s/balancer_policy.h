@@ -139,6 +139,14 @@ namespace mongo {
          */
         bool addTagRange( const TagRange& range );
 
+        /**
+         * Records this collection's Top-derived load on a shard (cumulative
+         * micros spent serving the collection there; only the relative size
+         * across shards matters). Shards that never report count as zero, which
+         * leaves the policy balancing purely on chunk counts.
+         */
+        void setLoadForShard( const string& shard, long long load );
+
         // ---- these methods might be better suiting in BalancerPolicy
         
         /**
@@ -179,6 +187,9 @@ namespace mongo {
 
         /** @return the ShardInfo for the shard */
         const ShardInfo& shardInfo( const string& shard ) const;
+
+        /** @return reported load on the shard for this collection, 0 if none */
+        long long loadForShard( const string& shard ) const;
         
         /** writes all state to log() */
         void dump() const;
@@ -189,6 +200,7 @@ namespace mongo {
         map<BSONObj,TagRange> _tagRanges;
         set<string> _allTags;
         set<string> _shards;
+        map<string,long long> _shardLoad;
     };
 
     class BalancerPolicy {
@@ -160,6 +160,111 @@ namespace mongo {
             ASSERT( ! c );
         }
 
+        TEST( BalancerPolicyTests , LoadBreaksReceiverTie ) {
+            // 2 chunks on shard0, two empty receivers; the cooler one should win
+            ShardToChunksMap chunkMap;
+            vector<BSONObj> chunks;
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << BSON("$minKey"<<1))) <<
+                                  ChunkType::max(BSON("x" << 49))));
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << 49)) <<
+                                  ChunkType::max(BSON("x" << BSON("$maxkey"<<1)))));
+            chunkMap["shard0"] = chunks;
+            chunks.clear();
+            chunkMap["shard1"] = chunks;
+            chunkMap["shard2"] = chunks;
+
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 2, false, false );
+            info["shard1"] = ShardInfo( 0, 0, false, false );
+            info["shard2"] = ShardInfo( 0, 0, false, false );
+
+            DistributionStatus status( info, chunkMap );
+            status.setLoadForShard( "shard1", 9000000LL );
+            status.setLoadForShard( "shard2", 1000LL );
+
+            MigrateInfo* c = BalancerPolicy::balance( "ns", status, 1 );
+            ASSERT( c );
+            ASSERT_EQUALS( c->from, "shard0" );
+            ASSERT_EQUALS( c->to, "shard2" );
+        }
+
+        TEST( BalancerPolicyTests , LoadTriggeredMove ) {
+            // 2 vs 1 chunks is under the count threshold, but shard0 is much
+            // hotter so it should still shed a chunk
+            ShardToChunksMap chunkMap;
+            vector<BSONObj> chunks;
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << BSON("$minKey"<<1))) <<
+                                  ChunkType::max(BSON("x" << 49))));
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << 49)) <<
+                                  ChunkType::max(BSON("x" << 80))));
+            chunkMap["shard0"] = chunks;
+            chunks.clear();
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << 80)) <<
+                                  ChunkType::max(BSON("x" << BSON("$maxkey"<<1)))));
+            chunkMap["shard1"] = chunks;
+
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 2, false, false );
+            info["shard1"] = ShardInfo( 0, 1, false, false );
+
+            DistributionStatus status( info, chunkMap );
+            status.setLoadForShard( "shard0", 5000000LL );
+
+            MigrateInfo* c = BalancerPolicy::balance( "ns", status, 0 );
+            ASSERT( c );
+            ASSERT_EQUALS( c->from, "shard0" );
+            ASSERT_EQUALS( c->to, "shard1" );
+        }
+
+        TEST( BalancerPolicyTests , LoadNoMoveWithoutCountHeadroom ) {
+            // equal chunk counts: even a very hot shard keeps its chunks,
+            // otherwise the next round would just move them back
+            ShardToChunksMap chunkMap;
+            vector<BSONObj> chunks;
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << BSON("$minKey"<<1))) <<
+                                  ChunkType::max(BSON("x" << 49))));
+            chunkMap["shard0"] = chunks;
+            chunks.clear();
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << 49)) <<
+                                  ChunkType::max(BSON("x" << BSON("$maxkey"<<1)))));
+            chunkMap["shard1"] = chunks;
+
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 1, false, false );
+            info["shard1"] = ShardInfo( 0, 1, false, false );
+
+            DistributionStatus status( info, chunkMap );
+            status.setLoadForShard( "shard0", 5000000LL );
+
+            MigrateInfo* c = BalancerPolicy::balance( "ns", status, 0 );
+            ASSERT( ! c );
+        }
+
+        TEST( BalancerPolicyTests , LoadNoMoveOnIdleCollection ) {
+            // 2 vs 1 chunks with negligible load shouldn't trigger a load move
+            ShardToChunksMap chunkMap;
+            vector<BSONObj> chunks;
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << BSON("$minKey"<<1))) <<
+                                  ChunkType::max(BSON("x" << 49))));
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << 49)) <<
+                                  ChunkType::max(BSON("x" << 80))));
+            chunkMap["shard0"] = chunks;
+            chunks.clear();
+            chunks.push_back(BSON(ChunkType::min(BSON("x" << 80)) <<
+                                  ChunkType::max(BSON("x" << BSON("$maxkey"<<1)))));
+            chunkMap["shard1"] = chunks;
+
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 2, false, false );
+            info["shard1"] = ShardInfo( 0, 1, false, false );
+
+            DistributionStatus status( info, chunkMap );
+            status.setLoadForShard( "shard0", 500LL );
+
+            MigrateInfo* c = BalancerPolicy::balance( "ns", status, 0 );
+            ASSERT( ! c );
+        }
+
 
         void addShard( ShardToChunksMap& map, unsigned numChunks, bool last ) {
             unsigned total = 0;
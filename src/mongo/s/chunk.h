@@ -338,6 +338,37 @@ namespace mongo {
         ChunkRangeMap _ranges;
     };
 
+    /**
+     * Flat routing table over the chunks, keyed by memcmp-comparable encoded
+     * shard keys (see shard_key_encoding.h) and probed by binary search, so a
+     * point lookup does no BSON decoding.  Built once at ChunkManager load
+     * time; unusable() - and everything falls back to the woCompare-ordered
+     * ChunkMap - when any chunk bound contains a value the encoding does not
+     * cover.
+     */
+    class EncodedChunkMap {
+    public:
+        EncodedChunkMap() : _usable( false ) {}
+
+        /** rebuilds from the (woCompare-sorted) chunk map; @return usable() */
+        bool reload( const ChunkMap& chunks );
+
+        bool usable() const { return _usable; }
+
+        /**
+         * Returns the chunk whose encoded max key is the first one greater
+         * than 'encodedPoint', or an empty ChunkPtr past the last chunk.
+         * Only valid when usable().
+         */
+        ChunkPtr upperBound( const std::string& encodedPoint ) const;
+
+    private:
+        typedef std::pair<std::string, ChunkPtr> Entry;
+
+        std::vector<Entry> _entries; // sorted by encoded key
+        bool _usable;
+    };
+
     /* config.sharding
          { ns: 'alleyinsider.fs.chunks' ,
            key: { ts : 1 } ,
@@ -474,6 +505,7 @@ namespace mongo {
         const bool _unique;
 
         const ChunkMap _chunkMap;
+        const EncodedChunkMap _encodedChunkMap;
         const ChunkRangeManager _chunkRanges;
 
         const set<Shard> _shards;
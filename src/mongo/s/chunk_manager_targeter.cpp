@@ -72,6 +72,7 @@ namespace mongo {
 
         // Get either the chunk manager or primary shard
         config->getChunkManagerOrPrimary( _nss.ns(), _manager, _primary );
+        _insertCache.reset();
 
         return Status::OK();
     }
@@ -109,12 +110,24 @@ namespace mongo {
                                         << _manager->getShardKey().key() );
             }
 
-            ChunkPtr chunk = _manager->findChunkForDoc( doc );
-            *endpoint = new ShardEndpoint( chunk->getShard().getName(),
-                                           _manager->getVersion( chunk->getShard() ) );
+            // Extract the (possibly hashed) shard key once and route on it directly,
+            // rather than letting findChunkForDoc() re-extract it.  The extracted key is
+            // also what lets us test the cached chunk without a routing-table search.
+            BSONObj shardKey = _manager->getShardKey().extractKey( doc );
+
+            if ( !_insertCache.chunk || !_insertCache.chunk->containsPoint( shardKey ) ) {
+                ChunkPtr chunk = _manager->findIntersectingChunk( shardKey );
+                _insertCache.chunk = chunk;
+                _insertCache.shardName = chunk->getShard().getName();
+                _insertCache.shardVersion = _manager->getVersion( chunk->getShard() );
+                _insertCache.sizeDelta = &_stats->chunkSizeDelta[chunk->getMin()];
+            }
+
+            *endpoint = new ShardEndpoint( _insertCache.shardName,
+                                           _insertCache.shardVersion );
 
             // Track autosplit stats for sharded collections
-            _stats->chunkSizeDelta[chunk->getMin()] += doc.objsize();
+            *_insertCache.sizeDelta += doc.objsize();
         }
 
         return Status::OK();
@@ -496,10 +509,28 @@ namespace mongo {
             remoteShardVersion = ChunkVersion::fromBSON( staleInfo, "vWanted" );
         }
 
-        // We assume here that we can't have more than one stale config per-shard
-        dassert( _remoteShardVersions.find( endpoint.shardName ) == _remoteShardVersions.end() );
-
-        _remoteShardVersions.insert( make_pair( endpoint.shardName, remoteShardVersion ) );
+        // During a migration burst a single batch response can carry a stale config
+        // error per write op, all from the same shard and possibly wanting different
+        // versions.  Coalesce them here, keeping the highest version wanted, so one
+        // refresh in refreshIfNeeded() covers the whole burst instead of triggering
+        // a reload per stale response.
+        ShardVersionMap::iterator it = _remoteShardVersions.find( endpoint.shardName );
+        if ( it == _remoteShardVersions.end() ) {
+            _remoteShardVersions.insert( make_pair( endpoint.shardName, remoteShardVersion ) );
+        }
+        else {
+            ChunkVersion& previouslyNotedVersion = it->second;
+            if ( previouslyNotedVersion.hasCompatibleEpoch( remoteShardVersion )) {
+                if ( previouslyNotedVersion.isOlderThan( remoteShardVersion )) {
+                    remoteShardVersion.cloneTo( &previouslyNotedVersion );
+                }
+            }
+            else {
+                // Epoch changed midway while applying the batch so ignore the updated
+                // version and take the hit of a possible extra refresh later on
+                ChunkVersion::IGNORED().cloneTo( &previouslyNotedVersion );
+            }
+        }
     }
 
     void ChunkManagerTargeter::noteCouldNotTarget() {
@@ -541,6 +572,7 @@ namespace mongo {
 
         // Get either the chunk manager or primary shard
         config->getChunkManagerOrPrimary( _nss.ns(), _manager, _primary );
+        _insertCache.reset();
 
         // We now have the latest metadata from the cache.
 
@@ -636,6 +668,7 @@ namespace mongo {
                 return Status( ErrorCodes::UnknownError, ex.toString() );
             }
             config->getChunkManagerOrPrimary( _nss.ns(), _manager, _primary );
+            _insertCache.reset();
         }
         else if ( refreshType == RefreshType_ReloadDatabase ) {
             try {
@@ -648,6 +681,7 @@ namespace mongo {
                 return Status( ErrorCodes::UnknownError, ex.toString() );
             }
             config->getChunkManagerOrPrimary( _nss.ns(), _manager, _primary );
+            _insertCache.reset();
         }
 
         return Status::OK();
@@ -134,6 +134,28 @@ namespace mongo {
         // Stores whether we need to check the remote server on refresh
         bool _needsTargetingRefresh;
 
+        /**
+         * Cache of the last chunk an insert was routed to.  Bulk inserts are usually
+         * clustered (often fully sorted) by shard key, so consecutive documents tend to
+         * land in the same chunk; reusing it skips the routing-table search, the shard
+         * version lookup, and the per-chunk stats map lookup for those documents.
+         * Reset whenever the targeting metadata is replaced.
+         */
+        struct InsertTargetCache {
+            InsertTargetCache() : sizeDelta( NULL ) {}
+            void reset() {
+                chunk.reset();
+                shardName.clear();
+                shardVersion = ChunkVersion();
+                sizeDelta = NULL;
+            }
+            ChunkPtr chunk;
+            std::string shardName;
+            ChunkVersion shardVersion;
+            int* sizeDelta;
+        };
+        mutable InsertTargetCache _insertCache;
+
         // Represents only the view and not really part of the targeter state.
         mutable boost::scoped_ptr<TargeterStats> _stats;
     };
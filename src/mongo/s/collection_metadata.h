@@ -209,6 +209,16 @@ namespace mongo {
             return _pendingMap.size();
         }
 
+        /**
+         * Map of contiguous owned ranges, min key -> max key, as consulted by
+         * keyBelongsToMe().  Exposed so per-document hot paths (e.g. the shard
+         * filter stage) can precompile the ranges into faster lookup structures;
+         * this metadata is immutable, so the map cannot change underneath them.
+         */
+        const RangeMap& getRangesMap() const {
+            return _rangesMap;
+        }
+
         //
         // reporting
         //
@@ -1455,6 +1455,24 @@ namespace mongo {
             virtual bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
                 result.appendBool("ismaster", true );
                 result.append("msg", "isdbgrid");
+
+                // Negotiated wire compression, mirroring mongod's isMaster: the
+                // client listed what it can decode, so compressing our side of
+                // the connection can start with this very reply.
+                BSONElement compression = cmdObj["compression"];
+                ClientBasic* client = ClientBasic::getCurrent();
+                if ( compression.type() == Array && client && client->port() ) {
+                    BSONObjIterator it( compression.Obj() );
+                    while ( it.more() ) {
+                        BSONElement alg = it.next();
+                        if ( alg.type() == String && alg.str() == "snappy" ) {
+                            result.append( "compression", BSON_ARRAY( "snappy" ) );
+                            client->port()->setWireCompression( true );
+                            break;
+                        }
+                    }
+                }
+
                 result.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
                 result.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
                 result.appendNumber("maxWriteBatchSize",
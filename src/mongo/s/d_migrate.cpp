@@ -71,10 +71,12 @@
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
 #include "mongo/s/d_logic.h"
+#include "mongo/s/d_split_sampler.h"
 #include "mongo/s/distlock.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/type_chunk.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/compress.h"
 #include "mongo/util/elapsed_tracker.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/queue.h"
@@ -474,7 +476,11 @@ namespace mongo {
             return true;
         }
 
-        bool clone( string& errmsg , BSONObjBuilder& result ) {
+        /**
+         * @param useCompression if set, the batch is shipped as one snappy-compressed blob
+         *                       (the recipient asked for it, so it knows how to inflate it)
+         */
+        bool clone( bool useCompression , string& errmsg , BSONObjBuilder& result ) {
             if ( ! _getActive() ) {
                 errmsg = "not active";
                 return false;
@@ -546,7 +552,25 @@ namespace mongo {
                 
             }
 
-            result.appendArray( "objects" , a.arr() );
+            BSONArray arr = a.arr();
+
+            if ( useCompression ) {
+                // a full batch spends most of the migration on the wire, so ship it
+                // compressed; if the data doesn't shrink (e.g. already compressed
+                // blobs), fall through to the plain form, which is never bigger
+                string compressedBuf;
+                compress( arr.objdata(), arr.objsize(), &compressedBuf );
+                if ( compressedBuf.size() < static_cast<size_t>( arr.objsize() ) ) {
+                    result.appendBinData( "compressedObjects",
+                                          compressedBuf.size(),
+                                          BinDataGeneral,
+                                          compressedBuf.c_str() );
+                    result.appendNumber( "uncompressedSize", arr.objsize() );
+                    return true;
+                }
+            }
+
+            result.appendArray( "objects" , arr );
             return true;
         }
 
@@ -717,6 +741,11 @@ namespace mongo {
                           BSONObj * patt,
                           const BSONObj* fullObj,
                           bool notInActiveChunk) {
+        // feed inserted shard keys to the split point sampler (near-free when
+        // no namespace is being sampled)
+        if (opstr[0] == 'i' && opstr[1] == 0)
+            splitPointSampler.recordInsert(ns, obj);
+
         // TODO: include fullObj?
         migrateFromStatus.logOp(opstr, ns, obj, patt, notInActiveChunk);
     }
@@ -750,7 +779,7 @@ namespace mongo {
             out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
         }
         bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
-            return migrateFromStatus.clone( errmsg, result );
+            return migrateFromStatus.clone( cmdObj["compress"].trueValue(), errmsg, result );
         }
     } initialCloneCommand;
 
@@ -1734,13 +1763,22 @@ namespace mongo {
                 }
             }
 
+            // if running on a replicated system, we'll need to flush the docs we cloned to the secondaries
+            ReplTime lastOpApplied = 0;
+
             {
                 // 3. initial bulk clone
                 state = CLONE;
 
+                // how many cloned docs we insert per write lock acquisition below
+                const int insertGroupSize = 64;
+
                 while ( true ) {
                     BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    // gets array of objects to copy, in disk order
+                    if ( ! conn->runCommand( "admin" ,
+                                             BSON( "_migrateClone" << 1 << "compress" << true ) ,
+                                             res ) ) {
                         state = FAIL;
                         errmsg = "_migrateClone failed: ";
                         errmsg += res.toString();
@@ -1749,43 +1787,78 @@ namespace mongo {
                         return;
                     }
 
-                    BSONObj arr = res["objects"].Obj();
+                    string inflated; // keeps an inflated batch alive while we insert from it
+                    BSONObj arr;
+                    if ( res.hasField( "compressedObjects" ) ) {
+                        int len;
+                        const char* data = res["compressedObjects"].binData( len );
+                        if ( ! uncompress( data, len, &inflated ) ||
+                             static_cast<long long>( inflated.size() ) !=
+                                 res["uncompressedSize"].numberLong() ) {
+                            state = FAIL;
+                            errmsg = "_migrateClone sent a corrupt compressed batch";
+                            error() << errmsg << migrateLog;
+                            conn.done();
+                            return;
+                        }
+                        arr = BSONObj( inflated.data() );
+                    }
+                    else {
+                        // a pre-compression donor
+                        arr = res["objects"].Obj();
+                    }
+
                     int thisTime = 0;
 
                     BSONObjIterator i( arr );
                     while( i.more() ) {
-                        BSONObj o = i.next().Obj();
+                        // insert a whole group per write lock acquisition instead of
+                        // relocking for every document
+                        vector<BSONObj> group;
+                        int groupBytes = 0;
+                        while ( i.more() && static_cast<int>( group.size() ) < insertGroupSize ) {
+                            BSONObj o = i.next().Obj();
+                            group.push_back( o );
+                            groupBytes += o.objsize();
+                        }
+
                         {
                             PageFaultRetryableSection pgrs;
                             while ( 1 ) {
                                 try {
                                     Client::WriteContext cx( ns );
 
-                                    BSONObj localDoc;
-                                    if ( willOverrideLocalId( o, &localDoc ) ) {
-                                        string errMsg =
-                                            str::stream() << "cannot migrate chunk, local document "
-                                                          << localDoc
-                                                          << " has same _id as cloned "
-                                                          << "remote document " << o;
+                                    for ( size_t j = 0; j < group.size(); j++ ) {
+                                        const BSONObj& o = group[j];
 
-                                        warning() << errMsg << endl;
+                                        BSONObj localDoc;
+                                        if ( willOverrideLocalId( o, &localDoc ) ) {
+                                            string errMsg =
+                                                str::stream() << "cannot migrate chunk, local document "
+                                                              << localDoc
+                                                              << " has same _id as cloned "
+                                                              << "remote document " << o;
 
-                                        // Exception will abort migration cleanly
-                                        uasserted( 16976, errMsg );
-                                    }
+                                            warning() << errMsg << endl;
 
-                                    Helpers::upsert( ns, o, true );
+                                            // Exception will abort migration cleanly
+                                            uasserted( 16976, errMsg );
+                                        }
+
+                                        Helpers::upsert( ns, o, true );
+                                    }
                                     break;
                                 }
                                 catch ( PageFaultException& e ) {
+                                    // docs already upserted just get re-upserted on retry,
+                                    // which is a no-op
                                     e.touch();
                                 }
                             }
                         }
-                        thisTime++;
-                        numCloned++;
-                        clonedBytes += o.objsize();
+                        thisTime += group.size();
+                        numCloned += group.size();
+                        clonedBytes += groupBytes;
 
                         if ( secondaryThrottle && thisTime > 0 ) {
                             if ( ! waitForReplication( cc().getLastOp(), 2, 60 /* seconds to wait */ ) ) {
@@ -1796,14 +1869,23 @@ namespace mongo {
 
                     if ( thisTime == 0 )
                         break;
+
+                    // overlap catch-up with the clone: drain a round of mods between
+                    // batches so the donor's transfer buffer doesn't grow for the
+                    // whole duration of a long clone
+                    BSONObj modsRes;
+                    if ( conn->runCommand( "admin" , BSON( "_transferMods" << 1 ) , modsRes ) &&
+                         modsRes["size"].number() > 0 ) {
+                        apply( modsRes , &lastOpApplied );
+                    }
                 }
 
                 timing.done(3);
                 MONGO_FP_PAUSE_WHILE(migrateThreadHangAtStep3);
             }
 
-            // if running on a replicated system, we'll need to flush the docs we cloned to the secondaries
-            ReplTime lastOpApplied = cc().getLastOp().asDate();
+            // everything the clone wrote on this thread is older than this
+            lastOpApplied = cc().getLastOp().asDate();
 
             {
                 // 4. do bulk of mods
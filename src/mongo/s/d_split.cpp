@@ -52,6 +52,7 @@
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
 #include "mongo/s/d_logic.h"
+#include "mongo/s/d_split_sampler.h"
 #include "mongo/s/distlock.h"
 #include "mongo/s/type_chunk.h"
 #include "mongo/util/timer.h"
@@ -369,6 +370,28 @@ namespace mongo {
                     keyCount = maxChunkObjects;
                 }
                 
+                //
+                // 2.a Let the sampler learn this namespace so later splits can skip the index
+                //     walk, and try to serve this request from the sample it has accumulated.
+                //
+
+                splitPointSampler.enableSampling( ns, keyPattern );
+
+                if ( !forceMedianSplit &&
+                     splitPointSampler.trySplitPoints( ns, keyPattern,
+                                                       jsobj.getObjectField( "min" ),
+                                                       jsobj.getObjectField( "max" ),
+                                                       keyCount, recCount, maxSplitPoints,
+                                                       &splitKeys ) ) {
+                    log() << "splitVector answered from shard key sample for chunk " << ns
+                          << " " << min << " -->> " << max << ", "
+                          << splitKeys.size() << " split points" << endl;
+                    result.appendBool( "fromSampler", true );
+                    result.append( "timeMillis", 0 );
+                    result.append( "splitKeys", splitKeys );
+                    return true;
+                }
+
                 //
                 // 2. Traverse the index and add the keyCount-th key to the result vector. If that key
                 //    appeared in the vector before, we omit it. The invariant here is that all the
@@ -0,0 +1,179 @@
+// d_split_sampler.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/s/d_split_sampler.h"
+
+#include <algorithm>
+
+#include "mongo/platform/random.h"
+
+namespace mongo {
+
+    namespace {
+
+        // about 4k keys; enough resolution for a few hundred split points per chunk
+        const int kReservoirSize = 4 * 1024;
+
+        // don't trust an estimate built on fewer in-chunk samples than this
+        const int kMinSamplesInChunk = 256;
+
+        struct SampleSorter {
+            SampleSorter( const Ordering& o ) : ordering( o ) {}
+            bool operator()( const BSONObj& l, const BSONObj& r ) const {
+                return l.woCompare( r, ordering ) < 0;
+            }
+            Ordering ordering;
+        };
+
+        // only touched under _sampleLock
+        PseudoRandom reservoirPRNG( static_cast<int64_t>( time( 0 ) ) );
+    }
+
+    SplitPointSampler splitPointSampler;
+
+    SplitPointSampler::SplitPointSampler()
+        : _anySampled( 0 ),
+          _mapLock( "SplitPointSampler::map" ),
+          _sampleLock( "SplitPointSampler::sample" ) {
+    }
+
+    void SplitPointSampler::enableSampling( const StringData& ns, const BSONObj& keyPattern ) {
+        SimpleMutex::scoped_lock lk( _mapLock );
+        NamespaceSample*& entry = _byNs[ns];
+        if ( !entry ) {
+            entry = new NamespaceSample( keyPattern );
+            _anySampled.store( 1 );
+        }
+    }
+
+    SplitPointSampler::NamespaceSample* SplitPointSampler::_find( const StringData& ns ) {
+        SimpleMutex::scoped_lock lk( _mapLock );
+        StringMap<NamespaceSample*>::const_iterator i = _byNs.find( ns );
+        return i == _byNs.end() ? NULL : i->second;
+    }
+
+    void SplitPointSampler::recordInsert( const char* ns, const BSONObj& doc ) {
+        if ( !_anySampled.loadRelaxed() )
+            return;
+
+        NamespaceSample* entry = _find( ns );
+        if ( !entry )
+            return;
+
+        SimpleMutex::scoped_lock lk( _sampleLock );
+
+        BSONObj key = doc.extractFields( entry->keyPattern );
+        if ( key.nFields() != entry->keyPattern.nFields() )
+            return; // missing shard key fields; not a useful sample
+
+        long long n = ++entry->seen;
+        if ( n <= kReservoirSize ) {
+            entry->reservoir.push_back( key.getOwned() );
+            return;
+        }
+
+        // classic reservoir sampling: keep with probability kReservoirSize/n
+        long long slot = reservoirPRNG.nextInt64() % n;
+        if ( slot < 0 )
+            slot += n;
+        if ( slot < static_cast<long long>( entry->reservoir.size() ) )
+            entry->reservoir[ static_cast<size_t>( slot ) ] = key.getOwned();
+    }
+
+    bool SplitPointSampler::trySplitPoints( const string& ns,
+                                            const BSONObj& keyPattern,
+                                            const BSONObj& min,
+                                            const BSONObj& max,
+                                            long long keyCount,
+                                            long long recCount,
+                                            long long maxSplitPoints,
+                                            vector<BSONObj>* splitKeys ) {
+        if ( keyCount <= 0 || recCount <= 0 )
+            return false;
+
+        NamespaceSample* entry = _find( ns );
+        if ( !entry )
+            return false;
+
+        // copy the reservoir out so the estimate below runs unlocked
+        vector<BSONObj> samples;
+        {
+            SimpleMutex::scoped_lock lk( _sampleLock );
+            if ( entry->keyPattern.woCompare( keyPattern ) != 0 )
+                return false;
+            samples = entry->reservoir;
+        }
+
+        if ( samples.empty() )
+            return false;
+
+        const Ordering ordering = Ordering::make( keyPattern );
+
+        // keep the samples that fall inside [min, max)
+        vector<BSONObj> inChunk;
+        for ( size_t i = 0; i < samples.size(); i++ ) {
+            if ( !min.isEmpty() && samples[i].woCompare( min, ordering ) < 0 )
+                continue;
+            if ( !max.isEmpty() && samples[i].woCompare( max, ordering ) >= 0 )
+                continue;
+            inChunk.push_back( samples[i] );
+        }
+
+        if ( static_cast<int>( inChunk.size() ) < kMinSamplesInChunk )
+            return false;
+
+        // the chunk holds about this fraction of the sampled inserts
+        long long chunkRecords = static_cast<long long>(
+                recCount * ( inChunk.size() / (double)samples.size() ) );
+        long long numSplits = chunkRecords / keyCount;
+        if ( numSplits < 1 )
+            return false;
+        if ( maxSplitPoints && numSplits > maxSplitPoints )
+            numSplits = maxSplitPoints;
+
+        std::sort( inChunk.begin(), inChunk.end(), SampleSorter( ordering ) );
+
+        // pick evenly spaced quantiles, skipping duplicates and the chunk's own
+        // lower bound (all instances of a key value must live in one chunk)
+        for ( long long i = 1; i <= numSplits; i++ ) {
+            size_t idx = static_cast<size_t>( i * inChunk.size() / ( numSplits + 1 ) );
+            BSONObj key = inChunk[idx].clientReadable();
+            if ( !min.isEmpty() && key.woCompare( min, ordering ) == 0 )
+                continue;
+            if ( !splitKeys->empty() && key.woCompare( splitKeys->back(), ordering ) == 0 )
+                continue;
+            splitKeys->push_back( key.getOwned() );
+        }
+
+        return !splitKeys->empty();
+    }
+}
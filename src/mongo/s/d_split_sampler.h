@@ -0,0 +1,109 @@
+// d_split_sampler.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    /**
+     * Reservoir sample of recently inserted shard key values, kept per sharded
+     * namespace so splitVector can estimate split points without walking the
+     * shard key index across the whole chunk.
+     *
+     * Sampling for a namespace begins the first time splitVector runs on it, so
+     * only collections that actually split pay for it.  The first split on a
+     * namespace - and any chunk too few samples fall into - falls back to the
+     * full index walk; chunks hot enough for that walk to hurt are, by the same
+     * token, hot enough to fill the reservoir quickly.
+     */
+    class SplitPointSampler {
+    public:
+        SplitPointSampler();
+
+        /**
+         * Begins sampling inserts into 'ns', whose shard key is 'keyPattern'.
+         * Idempotent.
+         */
+        void enableSampling( const StringData& ns, const BSONObj& keyPattern );
+
+        /**
+         * Adds the shard key of 'doc', just inserted into 'ns', to the
+         * reservoir.  One atomic load for namespaces that aren't sampled.
+         */
+        void recordInsert( const char* ns, const BSONObj& doc );
+
+        /**
+         * Tries to produce split points for the chunk ['min', 'max') of 'ns'
+         * from the reservoir.  'min'/'max' are in shard key space (empty means
+         * unbounded), 'keyCount' is the desired number of records between split
+         * points and 'recCount' the record total on this shard, both as
+         * computed by splitVector.  Returns false - and the caller walks the
+         * index - when the namespace isn't sampled or too few samples fall
+         * inside the chunk for a trustworthy estimate.
+         */
+        bool trySplitPoints( const std::string& ns,
+                             const BSONObj& keyPattern,
+                             const BSONObj& min,
+                             const BSONObj& max,
+                             long long keyCount,
+                             long long recCount,
+                             long long maxSplitPoints,
+                             std::vector<BSONObj>* splitKeys );
+
+    private:
+        struct NamespaceSample {
+            NamespaceSample( const BSONObj& pattern )
+                : keyPattern( pattern.getOwned() ), seen( 0 ) {}
+            BSONObj keyPattern;
+            long long seen;                  // inserts observed since sampling began
+            std::vector<BSONObj> reservoir;  // sampled shard key values
+        };
+
+        NamespaceSample* _find( const StringData& ns );
+
+        // nonzero once any namespace is sampled; lets recordInsert bail with
+        // one relaxed load on unsharded deployments
+        AtomicInt32 _anySampled;
+
+        // guards the map only; entries are never deleted so pointers stay valid
+        mutable SimpleMutex _mapLock;
+        StringMap<NamespaceSample*> _byNs;
+
+        // guards 'seen' and 'reservoir' of every entry
+        mutable SimpleMutex _sampleLock;
+    };
+
+    extern SplitPointSampler splitPointSampler;
+}
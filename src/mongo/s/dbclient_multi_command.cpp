@@ -34,9 +34,12 @@
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/s/shard.h"
+#include "mongo/client/dbclientinterface.h"
 #include "mongo/s/write_ops/batch_downconvert.h"
 #include "mongo/s/write_ops/dbclient_safe_writer.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/socket_poll.h"
 
 namespace mongo {
 
@@ -81,6 +84,17 @@ namespace mongo {
                    && conn->getMaxWireVersion() >= BATCH_COMMANDS;
         }
 
+        /**
+         * @return the raw socket fd under a connection, or -1 if there is
+         * nothing pollable there (not a plain single connection).
+         */
+        int rawSocketFd( DBClientBase* conn ) {
+            DBClientConnection* single = dynamic_cast<DBClientConnection*>( conn );
+            if ( !single || single->isFailed() )
+                return -1;
+            return single->port().psock->rawFD();
+        }
+
         /**
          * Parses and re-BSON's a batch write command in order to send it as a set of safe writes.
          */
@@ -198,8 +212,59 @@ namespace mongo {
 
     Status DBClientMultiCommand::recvAny( ConnectionString* endpoint, BSONSerializable* response ) {
 
-        scoped_ptr<PendingCommand> command( _pendingCommands.front() );
-        _pendingCommands.pop_front();
+        typedef deque<PendingCommand*>::iterator PendingIt;
+        PendingIt which = _pendingCommands.begin();
+
+        // Hand back whichever in-flight reply has already arrived instead of
+        // always blocking on the oldest command, so one slow shard doesn't
+        // hold up responses the others have sent.  Commands that failed to
+        // send have nothing to wait for and keep FIFO order, as do legacy
+        // safe writes (not yet sent) and anything we can't poll.
+        PendingCommand* front = _pendingCommands.front();
+        const bool frontAwaitingRecv = front->status.isOK() && NULL != front->conn
+            && ( hasBatchWriteFeature( front->conn ) || !isBatchWriteCommand( front->cmdObj ) );
+
+        if ( frontAwaitingRecv && _pendingCommands.size() > 1 && isPollSupported() ) {
+
+            bool pollable = true;
+            vector<pollfd> fds( _pendingCommands.size() );
+            size_t n = 0;
+
+            for ( PendingIt it = _pendingCommands.begin();
+                it != _pendingCommands.end() && pollable; ++it, ++n ) {
+
+                PendingCommand* c = *it;
+                const bool awaitingRecv = c->status.isOK() && NULL != c->conn
+                    && ( hasBatchWriteFeature( c->conn ) || !isBatchWriteCommand( c->cmdObj ) );
+
+                fds[n].fd = awaitingRecv ? rawSocketFd( c->conn ) : -1;
+                fds[n].events = POLLIN;
+                fds[n].revents = 0;
+                if ( awaitingRecv && fds[n].fd < 0 )
+                    pollable = false;
+            }
+
+            if ( pollable ) {
+                // a negative timeout means wait indefinitely, like recv would
+                int timeoutMillis = _timeoutMillis > 0 ? _timeoutMillis : -1;
+                if ( socketPoll( &fds[0], fds.size(), timeoutMillis ) > 0 ) {
+                    size_t i = 0;
+                    for ( PendingIt it = _pendingCommands.begin();
+                        it != _pendingCommands.end(); ++it, ++i ) {
+                        // errored sockets count as ready - their recv fails fast
+                        if ( fds[i].revents ) {
+                            which = it;
+                            break;
+                        }
+                    }
+                }
+                // on poll timeout fall through to the front command; its recv
+                // enforces the socket timeout and reports the failure
+            }
+        }
+
+        scoped_ptr<PendingCommand> command( *which );
+        _pendingCommands.erase( which );
 
         *endpoint = command->endpoint;
         if ( !command->status.isOK() ) return command->status;
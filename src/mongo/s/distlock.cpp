@@ -22,6 +22,7 @@
 #include <boost/thread/thread.hpp>
 
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/type_locks.h"
 #include "mongo/s/type_lockpings.h"
 #include "mongo/util/concurrency/thread_name.h"
@@ -81,6 +82,101 @@ namespace mongo {
     bool isLockPingerEnabled() { return lockPingerEnabled; }
     void setLockPingerEnabled(bool enabled) { lockPingerEnabled = enabled; }
 
+    // How long (in ms) a released distributed lock stays locally leased to this process for
+    // round-trip-free re-acquisition before the pinger gives it back to the config servers.
+    // While leased the lock document stays finalized remotely, so contenders on other
+    // processes wait out the lease as if the lock were still held.  0 disables leasing.
+    MONGO_EXPORT_SERVER_PARAMETER(distLockLeaseMillis, int, 15000);
+
+    /**
+     * Locally cached leases on distributed locks this process has released but still holds
+     * on the config servers.  While a lease is cached the lock document stays finalized
+     * (state 2) remotely, with the usual process ping keeping the hold valid, so
+     * re-acquisition by this process is a map lookup instead of several config server round
+     * trips.  Leases that lapse without being re-taken are fed to the pinger's lazy unlock
+     * machinery; contending processes just see an ordinarily held lock.
+     */
+    class DistLockLeaseCache {
+    public:
+
+        DistLockLeaseCache() : _mutex( "DistLockLeaseCache" ) {}
+
+        /** caches a lease on 'lockDoc', a finalized lock document this process holds */
+        void put( const ConnectionString& conn, const string& name, const BSONObj& lockDoc,
+                  unsigned long long durationMillis ) {
+            scoped_lock lk( _mutex );
+            LeaseData& lease = _leases[ LeaseKey( conn.toString(), name ) ];
+            lease.lockDoc = lockDoc.getOwned();
+            lease.expires = jsTime() + durationMillis;
+        }
+
+        /**
+         * Takes the lease on the given lock back for active use, if 'processId' holds one
+         * that is still inside its window.
+         * @return true and the held lock document in 'lockDoc' on success
+         */
+        bool take( const ConnectionString& conn, const string& name, const string& processId,
+                   BSONObj* lockDoc ) {
+            scoped_lock lk( _mutex );
+
+            map<LeaseKey, LeaseData>::iterator it =
+                _leases.find( LeaseKey( conn.toString(), name ) );
+            if ( it == _leases.end() )
+                return false;
+
+            // An expired lease is left for the pinger to release remotely.
+            if ( it->second.expires <= jsTime() )
+                return false;
+
+            // The same (conn, name) may be locked under a per-thread process id, whose
+            // lease only that id may reuse.
+            if ( it->second.lockDoc[LocksType::process()].String() != processId )
+                return false;
+
+            *lockDoc = it->second.lockDoc;
+            _leases.erase( it );
+            return true;
+        }
+
+        /**
+         * Moves the lock documents of this process' expired leases -- or, if 'all', every
+         * lease it holds -- into 'docs', so the caller can release them remotely.
+         */
+        void collect( const ConnectionString& conn, const string& processId, bool all,
+                      vector<BSONObj>* docs ) {
+            scoped_lock lk( _mutex );
+
+            Date_t now = jsTime();
+            for ( map<LeaseKey, LeaseData>::iterator it = _leases.begin();
+                  it != _leases.end(); ) {
+
+                if ( it->first.first == conn.toString() &&
+                     it->second.lockDoc[LocksType::process()].String() == processId &&
+                     ( all || it->second.expires <= now ) ) {
+                    docs->push_back( it->second.lockDoc );
+                    _leases.erase( it++ );
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+    private:
+
+        typedef std::pair<string, string> LeaseKey; // (conn, lock name)
+
+        struct LeaseData {
+            LeaseData() : expires(0) {}
+            BSONObj lockDoc;
+            Date_t expires;
+        };
+
+        mongo::mutex _mutex;
+        map<LeaseKey, LeaseData> _leases;
+
+    } distLockLeases;
+
     class DistributedLockPinger {
     public:
 
@@ -186,6 +282,22 @@ namespace mongo {
                             << " by distributed lock pinger '" << pingId
                             << "', sleeping for " << sleepTime << "ms" << endl;
 
+                    // Locks whose local leases lapsed without re-acquisition are still held
+                    // on the config servers; hand them to the lazy unlock list below.
+                    // (addUnlockOID takes _mutex, so do this before we do.)
+                    {
+                        vector<BSONObj> expiredLeases;
+                        distLockLeases.collect( addr, process, false, &expiredLeases );
+                        for ( vector<BSONObj>::const_iterator it = expiredLeases.begin();
+                              it != expiredLeases.end(); ++it ) {
+                            LOG( DistributedLock::logLvl - 1 )
+                                    << "lease on distributed lock with ts "
+                                    << (*it)[LocksType::lockID()].OID()
+                                    << " expired, scheduling remote release" << endl;
+                            addUnlockOID( (*it)[LocksType::lockID()].OID() );
+                        }
+                    }
+
                     // Remove old locks, if possible
                     // Make sure no one else is adding to this list at the same time
                     scoped_lock lk( _mutex );
@@ -236,6 +348,28 @@ namespace mongo {
                 sleepmillis(sleepTime);
             }
 
+            // Give back any locks we still hold only by lease, so other processes don't
+            // have to wait out the full lock timeout after we go away.
+            {
+                vector<BSONObj> remainingLeases;
+                distLockLeases.collect( addr, process, true, &remainingLeases );
+                for ( vector<BSONObj>::const_iterator it = remainingLeases.begin();
+                      it != remainingLeases.end(); ++it ) {
+                    try {
+                        ScopedDbConnection conn( addr.toString() );
+                        conn->update( LocksType::ConfigNS,
+                                      BSON( LocksType::name((*it)[LocksType::name()].String()) <<
+                                            LocksType::lockID((*it)[LocksType::lockID()].OID()) ),
+                                      BSON( "$set" << BSON( LocksType::state(0) ) ) );
+                        conn.done();
+                    }
+                    catch ( std::exception& e ) {
+                        warning() << "could not release leased distributed lock with ts "
+                                  << (*it)[LocksType::lockID()].OID() << causedBy( e ) << endl;
+                    }
+                }
+            }
+
             warning() << "removing distributed lock ping thread '" << pingId << "'" << endl;
 
 
@@ -599,6 +733,28 @@ namespace mongo {
         // This should always be true, if not, we are using the lock incorrectly.
         verify( _name != "" );
 
+        // If we released this lock within the lease window it is still finalized under our
+        // process on the config servers, so we can re-take it without any remote traffic.
+        // Re-entrant acquisition needs to inspect the real lock document, so it always goes
+        // through the full protocol below.
+        if ( !reenter && distLockLeaseMillis > 0 ) {
+            BSONObj cached;
+            if ( distLockLeases.take( _conn, _name, _processId, &cached ) &&
+                 !distLockPinger.willUnlockOID( cached[LocksType::lockID()].OID() ) ) {
+
+                LOG( logLvl - 1 ) << "re-acquired distributed lock '" << _name << "/"
+                                  << _processId << "' from local lease, ts "
+                                  << cached[LocksType::lockID()].OID() << " for '" << why << "'"
+                                  << endl;
+
+                if ( other != NULL ) {
+                    *other = cached;
+                    other->getOwned();
+                }
+                return true;
+            }
+        }
+
         LOG( logLvl ) << "trying to acquire new distributed lock for " << _name << " on " << _conn
                       << " ( lock timeout : " << _lockTimeout
                       << ", ping interval : " << _lockPing << ", process : " << _processId << " )"
@@ -1053,6 +1209,26 @@ namespace mongo {
 
         string lockName = _name + string("/") + _processId;
 
+        // If the caller can show us a finalized lock document owned by our process, keep the
+        // lock held on the config servers and just cache a lease on it locally -- the common
+        // re-acquisition (e.g. the balancer each round) then costs no round trips at all.
+        // Leases that lapse are released remotely by the ping thread.
+        if ( distLockLeaseMillis > 0 &&
+             oldLockPtr && !oldLockPtr->isEmpty() &&
+             (*oldLockPtr)[LocksType::state()].numberInt() == 2 &&
+             (*oldLockPtr)[LocksType::process()].type() == String &&
+             (*oldLockPtr)[LocksType::process()].String() == _processId &&
+             !(*oldLockPtr)[LocksType::lockID()].eoo() ) {
+
+            distLockLeases.put( _conn, _name, *oldLockPtr,
+                                static_cast<unsigned long long>( distLockLeaseMillis ) );
+
+            LOG( logLvl - 1 ) << "distributed lock '" << lockName
+                              << "' released to local lease cache, ts "
+                              << (*oldLockPtr)[LocksType::lockID()].OID() << endl;
+            return;
+        }
+
         const int maxAttempts = 3;
         int attempted = 0;
 
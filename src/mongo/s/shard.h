@@ -33,6 +33,7 @@
 #include "mongo/pch.h"
 
 #include "mongo/client/connpool.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -330,6 +331,10 @@ namespace mongo {
         void _init();
         void _finishInit();
 
+        // Tells the host load tracker this checkout is over; called once, from
+        // whichever of done()/kill() runs first.
+        void _noteOpFinished();
+
         bool _finishedInit;
 
         string _addr;
@@ -338,6 +343,10 @@ namespace mongo {
 
         DBClientBase* _conn;
         bool _setVersion;
+
+        // Measures how long this connection is checked out; in mongos a
+        // checkout brackets one operation against the shard.
+        Timer _opTimer;
     };
 
 
@@ -0,0 +1,156 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/s/shard_key_encoding.h"
+
+#include <string.h>
+
+namespace mongo {
+
+    namespace {
+
+        void appendUInt64BE( std::string* encoded, unsigned long long v ) {
+            for ( int shift = 56; shift >= 0; shift -= 8 )
+                encoded->push_back( static_cast<char>( ( v >> shift ) & 0xFF ) );
+        }
+
+        /**
+         * Maps a double onto an unsigned 64-bit value whose unsigned order is
+         * the double's numeric order: negatives have all bits flipped,
+         * non-negatives have the sign bit set.  NaN is mapped below -Inf,
+         * which is where woCompare puts it.
+         */
+        void appendNumber( std::string* encoded, double d ) {
+            unsigned long long bits;
+            memcpy( &bits, &d, 8 );
+            if ( d != d ) {
+                bits = 0;
+            }
+            else if ( bits & 0x8000000000000000ULL ) {
+                bits = ~bits;
+            }
+            else {
+                bits |= 0x8000000000000000ULL;
+            }
+            appendUInt64BE( encoded, bits );
+        }
+
+        // Largest magnitude at which every NumberLong is exactly a double, so
+        // encoding through double cannot merge values woCompare separates.
+        const long long kMaxExactDouble = 1LL << 53;
+
+    }  // namespace
+
+    bool encodeShardKeyForMemcmp( const BSONObj& key, std::string* encoded ) {
+        encoded->clear();
+
+        BSONObjIterator it( key );
+        while ( it.more() ) {
+            if ( !encodeKeyElementForMemcmp( it.next(), encoded ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool encodeKeyElementForMemcmp( const BSONElement& e, std::string* encoded ) {
+
+        // canonical types order fields across types the way woCompare
+        // does; +2 keeps MinKey's -1 a valid unsigned byte
+        encoded->push_back( static_cast<char>( canonicalizeBSONType( e.type() ) + 2 ) );
+
+        switch ( e.type() ) {
+        case MinKey:
+        case MaxKey:
+        case jstNULL:
+        case Undefined:
+            // the type byte says it all
+            break;
+
+        case NumberInt:
+        case NumberDouble:
+            appendNumber( encoded, e.number() );
+            break;
+
+        case NumberLong: {
+            const long long v = e._numberLong();
+            if ( v > kMaxExactDouble || v < -kMaxExactDouble )
+                return false;
+            appendNumber( encoded, static_cast<double>( v ) );
+            break;
+        }
+
+        case mongo::String: {
+            // strings compare by memcmp with the shorter one first on a
+            // common prefix; escape embedded NULs so the 0x00 0x00
+            // terminator stays smallest
+            const char* s = e.valuestr();
+            const int len = e.valuestrsize() - 1; // drop the trailing NUL
+            for ( int i = 0; i < len; i++ ) {
+                encoded->push_back( s[i] );
+                if ( s[i] == '\0' )
+                    encoded->push_back( static_cast<char>( 0xFF ) );
+            }
+            encoded->push_back( '\0' );
+            encoded->push_back( '\0' );
+            break;
+        }
+
+        case jstOID:
+            encoded->append( e.value(), 12 );
+            break;
+
+        case mongo::Bool:
+            encoded->push_back( e.boolean() ? 1 : 0 );
+            break;
+
+        case mongo::Date: {
+            // Date and Timestamp share a canonical type; woCompare is
+            // unsigned for Timestamp and signed for Date, which only
+            // agree for non-negative values
+            const long long millis = static_cast<long long>( e.Date().millis );
+            if ( millis < 0 )
+                return false;
+            appendUInt64BE( encoded, static_cast<unsigned long long>( millis ) );
+            break;
+        }
+
+        case Timestamp:
+            appendUInt64BE( encoded, e.date().millis );
+            break;
+
+        default:
+            // Symbol, Object, Array, BinData, RegEx, ... - not worth the
+            // complexity for shard keys
+            return false;
+        }
+
+        return true;
+    }
+
+}  // namespace mongo
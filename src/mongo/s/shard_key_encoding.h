@@ -0,0 +1,68 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * Builds an order-preserving binary encoding of the field values of 'key'
+     * in 'encoded': for two keys a and b with identical field names,
+     * memcmp over the encodings orders them exactly as a.woCompare( b )
+     * does.  Field names are not encoded, so only keys sharing one key
+     * pattern (e.g. the bounds and targets of a sharded collection's chunks)
+     * may be compared this way.
+     *
+     * Handles the types that occur in shard keys: MinKey, MaxKey, null,
+     * numbers, strings, ObjectId, bool, Date and Timestamp.
+     *
+     * @return false - leaving 'encoded' in an unspecified state - for any
+     * other type, and for corner values whose woCompare order the encoding
+     * cannot represent (NumberLongs beyond 2^53, pre-epoch dates); the
+     * caller must then fall back to woCompare.
+     */
+    bool encodeShardKeyForMemcmp( const BSONObj& key, std::string* encoded );
+
+    /**
+     * Appends the order-preserving encoding of one element's value (type and
+     * value, never the field name) to 'encoded'.  This is the per-field
+     * building block of encodeShardKeyForMemcmp and obeys the same contract:
+     * each value's encoding is prefix-free, so concatenations compare
+     * field by field.
+     *
+     * @return false for the types and corner values the encoding cannot
+     * represent (see above); 'encoded' may then hold a partial element and
+     * should be discarded.
+     */
+    bool encodeKeyElementForMemcmp( const BSONElement& e, std::string* encoded );
+
+}  // namespace mongo
@@ -0,0 +1,170 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include <limits>
+
+#include "mongo/s/shard_key_encoding.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::BSONObjBuilder;
+    using mongo::BSONNULL;
+    using mongo::MINKEY;
+    using mongo::MAXKEY;
+    using mongo::OID;
+    using mongo::Date_t;
+    using mongo::encodeKeyElementForMemcmp;
+    using mongo::encodeShardKeyForMemcmp;
+
+    /** {x: Timestamp(raw)} */
+    BSONObj ts( unsigned long long raw ) {
+        BSONObjBuilder b;
+        b.appendTimestamp( "x", raw );
+        return b.obj();
+    }
+
+    int sign( int i ) {
+        if ( i < 0 ) return -1;
+        if ( i > 0 ) return 1;
+        return 0;
+    }
+
+    int memcmpOrder( const BSONObj& a, const BSONObj& b ) {
+        std::string ea;
+        std::string eb;
+        ASSERT( encodeShardKeyForMemcmp( a, &ea ) );
+        ASSERT( encodeShardKeyForMemcmp( b, &eb ) );
+        return sign( ea.compare( eb ) );
+    }
+
+    /** memcmp order over the encodings must match woCompare, both ways. */
+    void assertSameOrder( const BSONObj& a, const BSONObj& b ) {
+        ASSERT_EQUALS( sign( a.woCompare( b ) ), memcmpOrder( a, b ) );
+        ASSERT_EQUALS( sign( b.woCompare( a ) ), memcmpOrder( b, a ) );
+    }
+
+    TEST(ShardKeyEncoding, Numbers) {
+        assertSameOrder( BSON( "x" << 1 ), BSON( "x" << 2 ) );
+        assertSameOrder( BSON( "x" << -1 ), BSON( "x" << 1 ) );
+        assertSameOrder( BSON( "x" << -5.5 ), BSON( "x" << -5 ) );
+        assertSameOrder( BSON( "x" << 0 ), BSON( "x" << 0.0 ) );
+        assertSameOrder( BSON( "x" << 3 ), BSON( "x" << 3.5 ) );
+        assertSameOrder( BSON( "x" << 1000LL ), BSON( "x" << 999 ) );
+        assertSameOrder( BSON( "x" << -std::numeric_limits<double>::infinity() ),
+                         BSON( "x" << std::numeric_limits<double>::min() ) );
+        assertSameOrder( BSON( "x" << std::numeric_limits<double>::infinity() ),
+                         BSON( "x" << std::numeric_limits<double>::max() ) );
+        // NaN sorts below all numbers
+        assertSameOrder( BSON( "x" << std::numeric_limits<double>::quiet_NaN() ),
+                         BSON( "x" << -std::numeric_limits<double>::infinity() ) );
+    }
+
+    TEST(ShardKeyEncoding, Types) {
+        assertSameOrder( BSON( "x" << MINKEY ), BSON( "x" << 1 ) );
+        assertSameOrder( BSON( "x" << 1 ), BSON( "x" << MAXKEY ) );
+        assertSameOrder( BSON( "x" << BSONNULL ), BSON( "x" << MINKEY ) );
+        assertSameOrder( BSON( "x" << BSONNULL ), BSON( "x" << 0 ) );
+        assertSameOrder( BSON( "x" << 1 ), BSON( "x" << "1" ) );
+        assertSameOrder( BSON( "x" << "a" ), BSON( "x" << true ) );
+        assertSameOrder( BSON( "x" << false ), BSON( "x" << true ) );
+        assertSameOrder( BSON( "x" << true ), BSON( "x" << Date_t( 0 ) ) );
+    }
+
+    TEST(ShardKeyEncoding, Strings) {
+        assertSameOrder( BSON( "x" << "a" ), BSON( "x" << "b" ) );
+        assertSameOrder( BSON( "x" << "a" ), BSON( "x" << "ab" ) );
+        assertSameOrder( BSON( "x" << "Z" ), BSON( "x" << "a" ) );
+        assertSameOrder( BSON( "x" << "" ), BSON( "x" << "a" ) );
+        // embedded NULs: shorter prefix still sorts first
+        assertSameOrder( BSON( "x" << std::string( "a\0b", 3 ) ), BSON( "x" << "a" ) );
+        assertSameOrder( BSON( "x" << std::string( "a\0b", 3 ) ),
+                         BSON( "x" << std::string( "a\0c", 3 ) ) );
+        assertSameOrder( BSON( "x" << std::string( "a\0", 2 ) ),
+                         BSON( "x" << "a\x01" ) );
+    }
+
+    TEST(ShardKeyEncoding, OIDDateTimestamp) {
+        assertSameOrder( BSON( "x" << OID( "4c88b36b0ce1f4ed7b1d0034" ) ),
+                         BSON( "x" << OID( "4c88b36b0ce1f4ed7b1d0035" ) ) );
+        assertSameOrder( BSON( "x" << Date_t( 1000 ) ), BSON( "x" << Date_t( 2000 ) ) );
+        assertSameOrder( ts( 100 ), ts( 200 ) );
+        assertSameOrder( ts( ( 1ULL << 32 ) | 2 ), ts( ( 2ULL << 32 ) | 1 ) );
+        // Date and Timestamp share a canonical type and compare by value
+        assertSameOrder( BSON( "x" << Date_t( 5000 ) ), ts( 1ULL << 32 ) );
+    }
+
+    TEST(ShardKeyEncoding, CompoundKeys) {
+        assertSameOrder( BSON( "a" << 1 << "b" << "x" ), BSON( "a" << 1 << "b" << "y" ) );
+        assertSameOrder( BSON( "a" << 1 << "b" << "z" ), BSON( "a" << 2 << "b" << "a" ) );
+        assertSameOrder( BSON( "a" << "ab" << "b" << 1 ), BSON( "a" << "a" << "b" << 2 ) );
+        assertSameOrder( BSON( "a" << MINKEY << "b" << MAXKEY ),
+                         BSON( "a" << MINKEY << "b" << MINKEY ) );
+    }
+
+    TEST(ShardKeyEncoding, Unsupported) {
+        std::string encoded;
+        ASSERT_FALSE( encodeShardKeyForMemcmp( BSON( "x" << BSON( "y" << 1 ) ), &encoded ) );
+        ASSERT_FALSE( encodeShardKeyForMemcmp( BSON( "x" << BSON_ARRAY( 1 << 2 ) ),
+                                               &encoded ) );
+        // NumberLongs beyond exact double precision can't round trip
+        ASSERT_FALSE( encodeShardKeyForMemcmp(
+                          BSON( "x" << ( ( 1LL << 53 ) + 1 ) ), &encoded ) );
+        // pre-epoch dates conflict with Timestamp's unsigned ordering
+        ASSERT_FALSE( encodeShardKeyForMemcmp( BSON( "x" << Date_t( -5LL ) ), &encoded ) );
+
+        // supported values still work
+        ASSERT_TRUE( encodeShardKeyForMemcmp( BSON( "x" << ( 1LL << 53 ) ), &encoded ) );
+    }
+
+    TEST(ShardKeyEncoding, Elements) {
+        // encoding a key is the concatenation of its element encodings
+        const BSONObj key = BSON( "a" << 1 << "b" << "x" );
+        std::string whole;
+        ASSERT_TRUE( encodeShardKeyForMemcmp( key, &whole ) );
+
+        std::string pieces;
+        ASSERT_TRUE( encodeKeyElementForMemcmp( key["a"], &pieces ) );
+        ASSERT_TRUE( encodeKeyElementForMemcmp( key["b"], &pieces ) );
+        ASSERT_EQUALS( whole, pieces );
+
+        // element encodings are appended, not replaced
+        std::string appended = "q";
+        ASSERT_TRUE( encodeKeyElementForMemcmp( key["a"], &appended ) );
+        ASSERT_EQUALS( 'q', appended[0] );
+
+        // element encodings are prefix-free, even for strings
+        std::string shorter;
+        std::string longer;
+        ASSERT_TRUE( encodeKeyElementForMemcmp( BSON( "x" << "a" )["x"], &shorter ) );
+        ASSERT_TRUE( encodeKeyElementForMemcmp( BSON( "x" << "ab" )["x"], &longer ) );
+        ASSERT_NOT_EQUALS( shorter, longer.substr( 0, shorter.size() ) );
+    }
+
+}  // namespace
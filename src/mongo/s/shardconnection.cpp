@@ -32,12 +32,14 @@
 
 #include <set>
 
+#include "mongo/client/host_load_tracker.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/s/config.h"
+#include "mongo/s/grid.h"
 #include "mongo/s/request.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/stale_exception.h"
@@ -109,6 +111,8 @@ namespace mongo {
             shardConnectionPool.appendInfo( result );
             // Thread connection info
             activeClientConnections.appendInfo( result );
+            // Per-host in-flight counts and smoothed request latencies
+            HostLoadTracker::get().appendInfo( result );
             return true;
         }
 
@@ -247,8 +251,32 @@ namespace mongo {
 
         void checkVersions( const string& ns ) {
 
+            // Only shards that might own data for 'ns' need the version
+            // handshake.  Fanning out to every shard in the cluster here gave
+            // each client thread a backend socket per shard as soon as it
+            // touched any namespace, dominating mongos' backend connection
+            // counts on large clusters.
             vector<Shard> all;
-            Shard::getAllShards( all );
+            DBConfigPtr conf = grid.getDBConfig( nsToDatabase( ns ), false );
+            if ( conf ) {
+                ChunkManagerPtr manager;
+                ShardPtr primary;
+                conf->getChunkManagerOrPrimary( ns, manager, primary );
+                if ( manager ) {
+                    set<Shard> shards;
+                    manager->getAllShards( shards );
+                    all.insert( all.end(), shards.begin(), shards.end() );
+                }
+                else if ( primary ) {
+                    all.push_back( *primary );
+                }
+            }
+
+            if ( all.empty() ) {
+                // We know nothing about the namespace; fall back to checking
+                // everywhere, as before.
+                Shard::getAllShards( all );
+            }
 
             // Don't report exceptions here as errors in GetLastError
             LastError::Disabled ignoreForGLE(lastError.get(false));
@@ -406,6 +434,15 @@ namespace mongo {
         _conn = ClientConnections::threadInstance()->get( _addr , _ns );
         _finishedInit = false;
         usingAShardConnection( _addr );
+
+        // A checkout brackets one operation against this shard, so the
+        // checkout duration is what the load tracker wants.
+        HostLoadTracker::get().opStarted( _addr );
+        _opTimer.reset();
+    }
+
+    void ShardConnection::_noteOpFinished() {
+        HostLoadTracker::get().opFinished( _addr , _opTimer.micros() );
     }
 
     void ShardConnection::_finishInit() {
@@ -428,6 +465,7 @@ namespace mongo {
 
     void ShardConnection::done() {
         if ( _conn ) {
+            _noteOpFinished();
             ClientConnections::threadInstance()->done( _addr , _conn );
             _conn = 0;
             _finishedInit = true;
@@ -436,6 +474,7 @@ namespace mongo {
 
     void ShardConnection::kill() {
         if ( _conn ) {
+            _noteOpFinished();
             if( versionManager.isVersionableCB( _conn ) ) versionManager.resetShardVersionCB( _conn );
 
             if (_conn->isFailed()) {
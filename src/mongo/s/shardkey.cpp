@@ -94,8 +94,9 @@ namespace mongo {
 
         }
         else {
-            BufBuilder buf (obj.objsize());
-            buf.appendNum((unsigned)0); // refcount
+            BufBuilder buf (obj.objsize() + BSONObj::Holder::extraBytes);
+            // refcount and lazy field index slots
+            memset(buf.skip(BSONObj::Holder::extraBytes), 0, BSONObj::Holder::extraBytes);
             buf.appendNum(obj.objsize());
 
             vector<pair<const char*, size_t> > copies;
@@ -78,11 +78,15 @@ namespace mongo {
     void BenchRunEventCounter::reset() {
         _numEvents = 0;
         _totalTimeMicros = 0;
+        for (int i = 0; i < kNumHistogramBuckets; ++i)
+            _histogram[i] = 0;
     }
 
     void BenchRunEventCounter::updateFrom(const BenchRunEventCounter &other) {
         _numEvents += other._numEvents;
         _totalTimeMicros += other._totalTimeMicros;
+        for (int i = 0; i < kNumHistogramBuckets; ++i)
+            _histogram[i] += other._histogram[i];
     }
 
     BenchRunStats::BenchRunStats() {
@@ -100,6 +104,7 @@ namespace mongo {
         insertCounter.reset();
         deleteCounter.reset();
         queryCounter.reset();
+        commandCounter.reset();
 
         trappedErrors.clear();
     }
@@ -114,6 +119,7 @@ namespace mongo {
         insertCounter.updateFrom(other.insertCounter);
         deleteCounter.updateFrom(other.deleteCounter);
         queryCounter.updateFrom(other.queryCounter);
+        commandCounter.updateFrom(other.commandCounter);
 
         for (size_t i = 0; i < other.trappedErrors.size(); ++i)
             trappedErrors.push_back(other.trappedErrors[i]);
@@ -411,8 +417,12 @@ namespace mongo {
                     else if ( op == "command" ) {
 
                         BSONObj result;
-                        conn->runCommand( ns, fixQuery( e["command"].Obj(), bsonTemplateEvaluator ),
-                                          result, e["options"].numberInt() );
+                        {
+                            BenchRunEventTrace _bret(&_stats.commandCounter);
+                            conn->runCommand( ns,
+                                              fixQuery( e["command"].Obj(), bsonTemplateEvaluator ),
+                                              result, e["options"].numberInt() );
+                        }
 
                         if( check ){
                             int err = scope->invoke( scopeFunc , 0 , &result,  1000 * 60 , false );
@@ -837,6 +847,28 @@ namespace mongo {
                         static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
      }
 
+     /**
+      * Appends the latency histogram of "counter" to "buf" as a subobject named "name",
+      * mapping the lower bound in microseconds of each occupied power-of-two bucket to
+      * its event count.  An average alone hides the tail; the histogram makes latency
+      * regressions in replayed workloads visible.
+      */
+     static void appendLatencyHistogramIfAvailable(
+             BSONObjBuilder &buf, const std::string &name, const BenchRunEventCounter &counter) {
+
+         if (counter.getNumEvents() == 0)
+             return;
+         BSONObjBuilder histo(buf.subobjStart(name));
+         for (int i = 0; i < BenchRunEventCounter::kNumHistogramBuckets; ++i) {
+             if (counter.getHistogramBucket(i) == 0)
+                 continue;
+             histo.append(
+                     str::stream() << BenchRunEventCounter::histogramBucketLowerBound(i),
+                     static_cast<long long>(counter.getHistogramBucket(i)));
+         }
+         histo.done();
+     }
+
      BSONObj BenchRunner::finish( BenchRunner* runner ) {
 
          runner->stop();
@@ -863,6 +895,19 @@ namespace mongo {
          appendAverageMicrosIfAvailable(buf, "deleteLatencyAverageMicros", stats.deleteCounter);
          appendAverageMicrosIfAvailable(buf, "updateLatencyAverageMicros", stats.updateCounter);
          appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
+         appendAverageMicrosIfAvailable(buf, "commandLatencyAverageMicros", stats.commandCounter);
+         appendLatencyHistogramIfAvailable(buf, "findOneLatencyHistogramMicros",
+                                           stats.findOneCounter);
+         appendLatencyHistogramIfAvailable(buf, "insertLatencyHistogramMicros",
+                                           stats.insertCounter);
+         appendLatencyHistogramIfAvailable(buf, "deleteLatencyHistogramMicros",
+                                           stats.deleteCounter);
+         appendLatencyHistogramIfAvailable(buf, "updateLatencyHistogramMicros",
+                                           stats.updateCounter);
+         appendLatencyHistogramIfAvailable(buf, "queryLatencyHistogramMicros",
+                                           stats.queryCounter);
+         appendLatencyHistogramIfAvailable(buf, "commandLatencyHistogramMicros",
+                                           stats.commandCounter);
 
          {
              BSONObjIterator i( after );
@@ -142,6 +142,7 @@ namespace mongo {
         void countOne(unsigned long long timeMicros) {
             ++_numEvents;
             _totalTimeMicros += timeMicros;
+            ++_histogram[histogramBucketOf(timeMicros)];
         }
 
         /**
@@ -154,9 +155,32 @@ namespace mongo {
          */
         unsigned long long getNumEvents() const { return _numEvents; }
 
+        /**
+         * Number of buckets in the latency histogram.  Bucket "i" counts events whose
+         * duration in microseconds was in [2^i, 2^(i+1)), except that bucket 0 also
+         * includes sub-microsecond events and the last bucket is unbounded above.
+         */
+        static const int kNumHistogramBuckets = 32;
+
+        /// Get the number of events recorded in histogram bucket "bucket".
+        unsigned long long getHistogramBucket(int bucket) const { return _histogram[bucket]; }
+
+        /// Get the lower bound, in microseconds, of histogram bucket "bucket".
+        static unsigned long long histogramBucketLowerBound(int bucket) {
+            return bucket == 0 ? 0 : (1ULL << bucket);
+        }
+
     private:
+        static int histogramBucketOf(unsigned long long timeMicros) {
+            int bucket = 0;
+            while (timeMicros >>= 1)
+                ++bucket;
+            return bucket < kNumHistogramBuckets ? bucket : kNumHistogramBuckets - 1;
+        }
+
         unsigned long long _numEvents;
         unsigned long long _totalTimeMicros;
+        unsigned long long _histogram[kNumHistogramBuckets];
     };
 
     /**
@@ -226,6 +250,7 @@ namespace mongo {
         BenchRunEventCounter insertCounter;
         BenchRunEventCounter deleteCounter;
         BenchRunEventCounter queryCounter;
+        BenchRunEventCounter commandCounter;
 
         std::map<std::string, long long> opcounters;
         std::vector<BSONObj> trappedErrors;
@@ -38,8 +38,10 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/scripting/bench.h"
+#include "mongo/util/background.h"
 #include "mongo/util/file.h"
 #include "mongo/util/text.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
     long long Scope::_lastVersion = 1;
@@ -287,7 +289,7 @@ namespace mongo {
 namespace {
     class ScopeCache {
     public:
-        ScopeCache() : _mutex("ScopeCache") {}
+        ScopeCache() : _mutex("ScopeCache"), _warmTarget(0), _missedSinceDecay(false) {}
 
         void release(const string& poolName, const boost::shared_ptr<Scope>& scope) {
             scoped_lock lk(_mutex);
@@ -330,22 +332,119 @@ namespace {
             return boost::shared_ptr<Scope>();
         }
 
+        /**
+         * Takes a prebuilt blank scope from the warm pool, or nothing when
+         * it is empty.  An empty-pool miss bumps the warm target so the
+         * warmer thread builds ahead of the observed demand.
+         */
+        boost::shared_ptr<Scope> tryAcquireWarm() {
+            scoped_lock lk(_mutex);
+
+            if (_warm.empty()) {
+                _missedSinceDecay = true;
+                if (_warmTarget < kMaxWarmScopes)
+                    _warmTarget++;
+                return boost::shared_ptr<Scope>();
+            }
+
+            boost::shared_ptr<Scope> scope = _warm.back();
+            _warm.pop_back();
+            return scope;
+        }
+
+        void parkWarm(const boost::shared_ptr<Scope>& scope) {
+            scoped_lock lk(_mutex);
+            _warm.push_back(scope);
+        }
+
+        /** how many scopes the warmer should build right now */
+        int warmDeficit() {
+            scoped_lock lk(_mutex);
+            return _warmTarget - static_cast<int>(_warm.size());
+        }
+
+        /**
+         * Halves the warm target when a whole decay interval passed without
+         * an empty-pool miss, so a burst of JS load doesn't pin prebuilt
+         * contexts in memory forever.
+         */
+        void decayWarmTargetIfIdle() {
+            scoped_lock lk(_mutex);
+            if (_missedSinceDecay) {
+                _missedSinceDecay = false;
+                return;
+            }
+            _warmTarget /= 2;
+        }
+
     private:
         struct ScopeAndPool {
             boost::shared_ptr<Scope> scope;
             string poolName;
         };
 
-        // Note: if these numbers change, reconsider choice of datastructure for _pools
-        static const unsigned kMaxPoolSize = 10;
-        static const int kMaxScopeReuse = 10;
+        // Note: if these numbers grow much, reconsider choice of datastructure for _pools
+        // (acquire is a linear scan)
+        static const unsigned kMaxPoolSize = 25;
+        // a cached scope keeps its compiled functions, so recurring jobs skip
+        // recompilation as long as the scope survives; recreating a scope means
+        // building a whole new context.  out-of-memory and errored scopes are
+        // never cached, which bounds the damage of a leaky reused scope.
+        static const int kMaxScopeReuse = 100;
+        // upper bound on prebuilt blank scopes parked for cache misses
+        static const int kMaxWarmScopes = 10;
 
         typedef deque<ScopeAndPool> Pools; // More-recently used Scopes are kept at the front.
         Pools _pools;    // protected by _mutex
         mongo::mutex _mutex;
+
+        // blank scopes built ahead of need by the warmer thread; all
+        // protected by _mutex
+        vector<boost::shared_ptr<Scope> > _warm;
+        int _warmTarget;
+        bool _missedSinceDecay;
     };
 
     ScopeCache scopeCache;
+
+    /**
+     * Builds blank scopes in the background and parks them in the
+     * ScopeCache's warm pool.  Creating a scope from scratch means building
+     * a whole new JS context - tens of milliseconds with the engine's type
+     * templates and db access installed - so paying it inline on a pool
+     * miss gives the first $where or eval on a connection bimodal latency.
+     * The pool is sized by recent miss demand and decays when the JS load
+     * stops.
+     */
+    class JSScopeWarmer : public BackgroundJob {
+    public:
+        JSScopeWarmer() : BackgroundJob(true /* selfDelete */) {}
+
+        virtual string name() const { return "JSScopeWarmer"; }
+
+        virtual void run() {
+            Timer sinceDecay;
+            while (!inShutdown()) {
+                for (int deficit = scopeCache.warmDeficit(); deficit > 0; deficit--) {
+                    boost::shared_ptr<Scope> scope(globalScriptEngine->newScope());
+                    scopeCache.parkWarm(scope);
+                }
+
+                if (sinceDecay.seconds() >= kDecaySecs) {
+                    scopeCache.decayWarmTargetIfIdle();
+                    sinceDecay.reset();
+                }
+
+                sleepsecs(1);
+            }
+        }
+
+    private:
+        static const int kDecaySecs = 60;
+    };
+
+    mongo::mutex scopeWarmerStartMutex("JSScopeWarmer");
+    bool scopeWarmerStarted = false;
 } // anonymous namespace
 
     class PooledScope : public Scope {
@@ -424,8 +523,23 @@ namespace {
 
     /** Get a scope from the pool of scopes matching the supplied pool name */
     auto_ptr<Scope> ScriptEngine::getPooledScope(const string& db, const string& scopeType) {
+        {
+            // lazily start the warmer the first time anything pools scopes,
+            // by which point the global engine is certainly up
+            scoped_lock lk(scopeWarmerStartMutex);
+            if (!scopeWarmerStarted) {
+                scopeWarmerStarted = true;
+                (new JSScopeWarmer())->go();
+            }
+        }
+
         const string fullPoolName = db + scopeType;
         boost::shared_ptr<Scope> s = scopeCache.tryAcquire(fullPoolName);
+        if (!s) {
+            // a prebuilt blank scope skips context construction; it just
+            // needs the per-pool state applied below
+            s = scopeCache.tryAcquireWarm();
+        }
         if (!s) {
             s.reset(newScope());
         }
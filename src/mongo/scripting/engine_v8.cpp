@@ -930,6 +930,66 @@ namespace mongo {
 
     // --- functions -----
 
+namespace {
+    /**
+     * Process-wide cache of V8 pre-parse data, keyed by script source.
+     * ScriptData::PreCompile output is context and isolate independent, so one
+     * entry serves every scope compiling the same source; feeding it back to
+     * v8::Script::Compile skips the parse, which is most of the cost of
+     * recompiling the map/reduce/$where functions that recurring jobs submit
+     * run after run, and of loading the core js files into a fresh context.
+     */
+    class PreparseCache {
+    public:
+        PreparseCache() : _mutex("PreparseCache"), _bytes(0) {}
+
+        /**
+         * Returns pre-parse data for 'source', computing and caching it the
+         * first time a source is seen.  Caller owns the returned ScriptData.
+         * Returns NULL when the source fails to pre-parse (compilation will
+         * report the error) or the cache is full.
+         *
+         * Must be called with the isolate entered, same as Script::Compile.
+         */
+        v8::ScriptData* get(const string& source) {
+            {
+                mongo::mutex::scoped_lock lk(_mutex);
+                Map::const_iterator it = _cache.find(source);
+                if (it != _cache.end())
+                    return v8::ScriptData::New(it->second.data(),
+                                               static_cast<int>(it->second.size()));
+            }
+
+            scoped_ptr<v8::ScriptData> fresh(
+                    v8::ScriptData::PreCompile(source.c_str(),
+                                               static_cast<int>(source.size())));
+            if (!fresh || fresh->HasError())
+                return NULL;
+
+            mongo::mutex::scoped_lock lk(_mutex);
+            if (_cache.count(source) == 0) {
+                const size_t entryBytes = source.size() + fresh->Length();
+                if (_bytes + entryBytes > kMaxBytes)
+                    return NULL; // full; just pay for the parse
+                _cache[source].assign(fresh->Data(), fresh->Length());
+                _bytes += entryBytes;
+            }
+            const string& stored = _cache[source];
+            return v8::ScriptData::New(stored.data(), static_cast<int>(stored.size()));
+        }
+
+    private:
+        static const size_t kMaxBytes = 8 * 1024 * 1024;
+
+        typedef map<string, string> Map; // source -> serialized ScriptData
+        mongo::mutex _mutex;
+        Map _cache;     // protected by _mutex
+        size_t _bytes;  // protected by _mutex; keys + values
+    };
+
+    PreparseCache preparseCache;
+} // anonymous namespace
+
     bool hasFunctionIdentifier(const StringData& code) {
         if (code.size() < 9 || code.find("function") != 0 )
             return false;
@@ -955,9 +1015,14 @@ namespace mongo {
         string fn = str::stream() << "_funcs" << functionNumber;
         code = str::stream() << fn << " = " << code;
 
+        // scopes in the same pool hand out the same function numbers in the same
+        // order, so recurring jobs hit the cache even on a fresh scope
+        scoped_ptr<v8::ScriptData> preData(preparseCache.get(code));
+        v8::ScriptOrigin origin(v8::String::New(fn.c_str()));
         v8::Handle<v8::Script> script = v8::Script::Compile(
                                             v8::String::New(code.c_str(), code.length()),
-                                            v8::String::New(fn.c_str()));
+                                            &origin,
+                                            preData.get());
 
         // throw on error
         checkV8ErrorState(script, try_catch);
@@ -1069,9 +1134,17 @@ namespace mongo {
         V8_SIMPLE_HEADER
         v8::TryCatch try_catch;
 
+        // only sources big enough for the parse to matter are worth a cache
+        // entry; this catches the core js files loaded into every new context
+        // without filling the cache with one-off shell input
+        scoped_ptr<v8::ScriptData> preData;
+        if (code.size() >= 512)
+            preData.reset(preparseCache.get(code.toString()));
+        v8::ScriptOrigin origin(v8::String::New(name.c_str(), name.length()));
         v8::Handle<v8::Script> script =
                 v8::Script::Compile(v8::String::New(code.rawData(), code.size()),
-                                    v8::String::New(name.c_str(), name.length()));
+                                    &origin,
+                                    preData.get());
 
         if (checkV8ErrorState(script, try_catch, reportError, assertOnError))
             return false;
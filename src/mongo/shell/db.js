@@ -130,6 +130,62 @@ DB.prototype.getProfilingStatus  = function() {
     return res;
 }
 
+/**
+ *  Convert operations captured in this database's system.profile collection into an
+ *  ops array suitable for benchRun(), so a sampled production workload can be
+ *  replayed against a test instance at controlled concurrency:
+ *
+ *      db.setProfilingLevel(2)         // or 1 with a suitable slowms, to sample
+ *      ... workload runs ...
+ *      var ops = db.profileToBenchRunOps()
+ *      benchRun( { ops: ops, host: "testhost", parallel: 8, seconds: 60 } )
+ *
+ *  The returned array is plain JSON and can be saved (e.g. with tojson) for later
+ *  replay.  Query, command, update and remove operations are converted with their
+ *  captured literals; inserts and getmores are skipped, since the profiler does not
+ *  record the inserted documents and getmores only continue an already-replayed query.
+ *
+ *  @param filter optional query against system.profile to select which ops to convert.
+ *  @param limit optional cap on the number of profile documents read (default 1000).
+ *  @return array of benchRun operation objects, in capture order.
+ */
+DB.prototype.profileToBenchRunOps = function( filter, limit ) {
+    var ops = [];
+    var cursor = this.system.profile.find( filter ? filter : {} )
+                     .sort( { ts: 1 } ).limit( limit ? limit : 1000 );
+    while ( cursor.hasNext() ) {
+        var p = cursor.next();
+        if ( p.op == "query" && p.query ) {
+            // Unwrap queries the shell sent in { query : ..., orderby : ... } form.
+            var q = p.query.query ? p.query.query : p.query;
+            var op = { op: "find", ns: p.ns, query: q };
+            if ( p.ntoreturn )
+                op.limit = p.ntoreturn;
+            if ( p.ntoskip )
+                op.skip = p.ntoskip;
+            ops.push( op );
+        }
+        else if ( p.op == "command" && p.command ) {
+            // benchRun's command op takes the database name in the ns field.
+            ops.push( { op: "command", ns: p.ns.split( "." )[0], command: p.command } );
+        }
+        else if ( p.op == "update" && p.updateobj ) {
+            var op = { op: "update", ns: p.ns,
+                       query: p.query ? p.query : {}, update: p.updateobj };
+            if ( p.upsert )
+                op.upsert = true;
+            if ( p.nMatched > 1 || p.nupdated > 1 )
+                op.multi = true;
+            ops.push( op );
+        }
+        else if ( p.op == "remove" ) {
+            ops.push( { op: "remove", ns: p.ns, query: p.query ? p.query : {} } );
+        }
+        // "insert" and "getmore" are not replayable; skip them.
+    }
+    return ops;
+}
+
 
 /**
   Erase the entire database.  (!)
@@ -299,6 +355,7 @@ DB.prototype.help = function() {
     print("\tdb.printReplicationInfo()");
     print("\tdb.printShardingStatus()");
     print("\tdb.printSlaveReplicationInfo()");
+    print("\tdb.profileToBenchRunOps(<filter>,<limit>) - convert system.profile docs to a benchRun ops array");
     print("\tdb.dropUser(username)");
     print("\tdb.repairDatabase()");
     print("\tdb.resetError()");
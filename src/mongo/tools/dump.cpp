@@ -28,8 +28,10 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <fstream>
 #include <map>
@@ -37,10 +39,12 @@
 #include "mongo/base/status.h"
 #include "mongo/client/auth_helpers.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/client/sasl_client_authenticate.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/db.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/tools/mongodump_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/options_parser/option_section.h"
@@ -89,15 +93,15 @@ public:
         ProgressMeter* _m;
     };
 
-    void doCollection( const string coll , Query q, FILE* out , ProgressMeter *m ) {
+    void doCollection( DBClientBase& connBase, const string coll , Query q, FILE* out ,
+                       ProgressMeter *m ) {
         int queryOptions = QueryOption_SlaveOk | QueryOption_NoCursorTimeout;
         if (startsWith(coll.c_str(), "local.oplog."))
             queryOptions |= QueryOption_OplogReplay;
         else if (mongoDumpGlobalParams.snapShotQuery) {
             q.snapshot();
         }
-        
-        DBClientBase& connBase = conn(true);
+
         Writer writer(out, m);
 
         // use low-latency "exhaust" mode if going over the network
@@ -115,17 +119,18 @@ public:
         }
     }
 
-    void writeCollectionFile( const string coll , Query q, boost::filesystem::path outputFile ) {
+    void writeCollectionFile( DBClientBase& connBase, const string coll , Query q,
+                              boost::filesystem::path outputFile ) {
         toolInfoLog() << "\t" << coll << " to " << outputFile.string() << std::endl;
 
         FilePtr f (fopen(outputFile.string().c_str(), "wb"));
         uassert(10262, errnoWithPrefix("couldn't open file"), f);
 
-        ProgressMeter m(conn(true).count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
+        ProgressMeter m(connBase.count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
         m.setName("Collection File Writing Progress");
         m.setUnits("documents");
 
-        doCollection(coll, q, f, &m);
+        doCollection(connBase, coll, q, f, &m);
 
         toolInfoLog() << "\t\t " << m.done() << " documents" << std::endl;
     }
@@ -165,7 +170,91 @@ public:
 
 
     void writeCollectionStdout( const string coll ) {
-        doCollection(coll, _query, stdout, NULL);
+        doCollection(conn(true), coll, _query, stdout, NULL);
+    }
+
+    /**
+     * Opens (and authenticates) a dedicated connection for a parallel dump worker.
+     * The Tool base class keeps a single connection, which the worker threads
+     * cannot share, so each worker redoes the connect/auth handshake itself.
+     */
+    DBClientBase* openWorkerConnection() {
+        string errmsg;
+        ConnectionString cs = ConnectionString::parse(toolGlobalParams.connectionString, errmsg);
+        uassert(17560, str::stream() << "invalid hostname ["
+                << toolGlobalParams.connectionString << "] " << errmsg, cs.isValid());
+
+        auto_ptr<DBClientBase> workerConn(cs.connect(errmsg));
+        uassert(17561, str::stream() << "couldn't connect to ["
+                << toolGlobalParams.connectionString << "] " << errmsg, workerConn.get());
+
+        if (!toolGlobalParams.username.empty()) {
+            BSONObjBuilder authParams;
+            authParams <<
+                saslCommandUserDBFieldName << getAuthenticationDatabase() <<
+                saslCommandUserFieldName << toolGlobalParams.username <<
+                saslCommandPasswordFieldName << toolGlobalParams.password  <<
+                saslCommandMechanismFieldName <<
+                toolGlobalParams.authenticationMechanism;
+
+            if (!toolGlobalParams.gssapiServiceName.empty()) {
+                authParams << saslCommandServiceNameFieldName
+                           << toolGlobalParams.gssapiServiceName;
+            }
+
+            if (!toolGlobalParams.gssapiHostName.empty()) {
+                authParams << saslCommandServiceHostnameFieldName
+                           << toolGlobalParams.gssapiHostName;
+            }
+
+            workerConn->auth(authParams.obj());
+        }
+
+        return workerConn.release();
+    }
+
+    /**
+     * Body of one parallel dump worker: claims collections off the shared list
+     * and streams each one to its .bson/.metadata.json pair over the worker's
+     * own connection.  Failures are counted rather than thrown so the
+     * remaining collections still get dumped.
+     */
+    void dumpWorker( const vector<string>* collections,
+                     AtomicInt32* nextCollection,
+                     AtomicInt32* errorCount,
+                     const string* db,
+                     const Query* query,
+                     const boost::filesystem::path* outdir,
+                     const map<string, BSONObj>* collectionOptions,
+                     const multimap<string, BSONObj>* indexes ) {
+        scoped_ptr<DBClientBase> workerConn;
+        try {
+            workerConn.reset(openWorkerConnection());
+        }
+        catch (const DBException& e) {
+            toolError() << "parallel dump worker couldn't connect: " << e.toString() << std::endl;
+            errorCount->fetchAndAdd(1);
+            return;
+        }
+
+        while (true) {
+            int i = nextCollection->fetchAndAdd(1);
+            if (i >= static_cast<int>(collections->size()))
+                break;
+
+            const string& name = (*collections)[i];
+            const string filename = name.substr(db->size() + 1);
+            try {
+                writeCollectionFile(*workerConn, name, *query, *outdir / (filename + ".bson"));
+                writeMetadataFile(name, *outdir / (filename + ".metadata.json"),
+                                  *collectionOptions, *indexes);
+            }
+            catch (const DBException& e) {
+                toolError() << "error dumping collection " << name << ": " << e.toString()
+                          << std::endl;
+                errorCount->fetchAndAdd(1);
+            }
+        }
     }
 
     void go(const string& db,
@@ -225,7 +314,8 @@ public:
             if (nsToCollectionSubstring(name) == "system.indexes") {
               // Create system.indexes.bson for compatibility with pre 2.2 mongorestore
               const string filename = name.substr( db.size() + 1 );
-              writeCollectionFile( name.c_str() , query, outdir / ( filename + ".bson" ) );
+              writeCollectionFile( conn( true ), name.c_str() , query,
+                                   outdir / ( filename + ".bson" ) );
               // Don't dump indexes as *.metadata.json
               continue;
             }
@@ -238,10 +328,41 @@ public:
             collections.push_back(name);
         }
         
+        int numWorkers = mongoDumpGlobalParams.numParallelCollections;
+        if ( numWorkers > static_cast<int>( collections.size() ) )
+            numWorkers = collections.size();
+
+        // Dump collections with several concurrent streams when there's more than
+        // one to do and each worker can open its own connection.  DBDirectClient
+        // is bound to the caller's thread, and a caller-supplied output filename
+        // implies a single collection, so both fall through to the serial loop.
+        if ( numWorkers > 1 && !toolGlobalParams.useDirectClient && outFilename.empty() ) {
+            toolInfoLog() << "dumping " << collections.size() << " collections with "
+                          << numWorkers << " parallel streams" << std::endl;
+
+            AtomicInt32 nextCollection( 0 );
+            AtomicInt32 errorCount( 0 );
+            vector< boost::shared_ptr<boost::thread> > workers;
+            for ( int i = 0; i < numWorkers; i++ ) {
+                workers.push_back( boost::shared_ptr<boost::thread>( new boost::thread(
+                        boost::bind( &Dump::dumpWorker, this,
+                                     &collections, &nextCollection, &errorCount,
+                                     &db, &query, &outdir,
+                                     &collectionOptions, &indexes ) ) ) );
+            }
+            for ( size_t i = 0; i < workers.size(); i++ ) {
+                workers[i]->join();
+            }
+
+            uassert( 17562, "one or more parallel dump streams failed",
+                     errorCount.load() == 0 );
+            return;
+        }
+
         for (vector<string>::iterator it = collections.begin(); it != collections.end(); ++it) {
             string name = *it;
             const string filename = outFilename != "" ? outFilename : name.substr( db.size() + 1 );
-            writeCollectionFile( name , query, outdir / ( filename + ".bson" ) );
+            writeCollectionFile( conn( true ), name , query, outdir / ( filename + ".bson" ) );
             writeMetadataFile( name, outdir / (filename + ".metadata.json"), collectionOptions, indexes);
         }
 
@@ -556,7 +677,7 @@ public:
 
             _query = BSON("ts" << b.obj());
 
-            writeCollectionFile( opLogName , _query, root / "oplog.bson" );
+            writeCollectionFile( conn( true ), opLogName , _query, root / "oplog.bson" );
         }
 
         return 0;
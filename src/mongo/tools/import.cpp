@@ -37,6 +37,7 @@
 #include "mongo/db/json.h"
 #include "mongo/tools/mongoimport_options.h"
 #include "mongo/tools/tool.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/options_parser/option_section.h"
 #include "mongo/util/text.h"
 
@@ -281,8 +282,180 @@ class Import : public Tool {
         return true;
     }
 
+    /*
+     * A contiguous run of input lines handed to a parser thread.  Batches are
+     * numbered so the insert loop can put the parsed documents back in input
+     * order.
+     */
+    struct ParseBatch {
+        unsigned long long id;
+        vector<string> lines;
+        vector<BSONObj> docs;
+        int errors;
+        long long bytes;
+        ParseBatch() : id( 0 ), errors( 0 ), bytes( 0 ) {}
+    };
+
+    // Parallel JSON parsing state, shared with the parser threads.
+    mongo::mutex _parseMutex;
+    boost::condition _parseCondition;
+    map<unsigned long long, ParseBatch*> _parsedBatches;
+
+    /* worker-pool task: turn a batch of JSON lines into BSONObjs */
+    void parseBatchTask(ParseBatch* batch) {
+        for (size_t i = 0; i < batch->lines.size(); i++) {
+            string& line = batch->lines[i];
+            // Strip out trailing whitespace, as parseRow does
+            while (!line.empty() && isspace(line[line.size()-1])) {
+                line.resize(line.size() - 1);
+            }
+            if (line.empty())
+                continue;
+            try {
+                batch->docs.push_back(fromjson(line));
+            }
+            catch ( const std::exception& e ) {
+                toolError() << "exception:" << e.what() << std::endl;
+                batch->errors++;
+            }
+        }
+
+        scoped_lock lk(_parseMutex);
+        _parsedBatches[batch->id] = batch;
+        _parseCondition.notify_one();
+    }
+
+    /* blocks until the parser threads have finished batch 'id' */
+    void waitForParsedBatch(unsigned long long id) {
+        scoped_lock lk(_parseMutex);
+        while (_parsedBatches.count(id) == 0) {
+            _parseCondition.wait(lk.boost());
+        }
+    }
+
+    /*
+     * Inserts any parsed batches that are next in input order.  Returns the id
+     * of the first batch still outstanding.
+     */
+    unsigned long long insertReadyBatches(const string& ns, unsigned long long nextToInsert,
+                                          int& num, int& lastNumChecked, int& errors,
+                                          ProgressMeter& pm, time_t start) {
+        while (true) {
+            boost::scoped_ptr<ParseBatch> batch;
+            {
+                scoped_lock lk(_parseMutex);
+                map<unsigned long long, ParseBatch*>::iterator it =
+                    _parsedBatches.find(nextToInsert);
+                if (it == _parsedBatches.end())
+                    return nextToInsert;
+                batch.reset(it->second);
+                _parsedBatches.erase(it);
+            }
+            nextToInsert++;
+
+            errors += batch->errors;
+
+            for (size_t i = 0; i < batch->docs.size(); i++) {
+                try {
+                    if (mongoImportGlobalParams.doimport) {
+                        importDocument(ns, batch->docs[i]);
+
+                        if (num < 10) {
+                            // we absolutely want to check the first and last op of the batch. we do
+                            // a few more as that won't be too time expensive.
+                            checkLastError();
+                            lastNumChecked = num;
+                        }
+                    }
+                    num++;
+                }
+                catch ( const std::exception& e ) {
+                    toolError() << "exception:" << e.what() << std::endl;
+                    errors++;
+                }
+            }
+
+            if (!toolGlobalParams.quiet) {
+                if (pm.hit(batch->bytes)) {
+                    log() << "\t\t\t" << num << "\t" << (num / (time(0) - start)) << "/second"
+                          << std::endl;
+                }
+            }
+        }
+    }
+
+    /*
+     * Line-delimited JSON import using --parseThreads worker threads: this
+     * thread reads batches of lines and drives the inserts in input order,
+     * while the pool turns each batch into BSON.  With stopOnError, reading
+     * stops at the first error, but batches already scheduled are still
+     * inserted.
+     */
+    void importJsonLinesParallel(const string& ns, istream* in, int& num,
+                                 int& lastNumChecked, int& errors,
+                                 ProgressMeter& pm, time_t start) {
+        ThreadPool pool(mongoImportGlobalParams.parseThreads);
+        const unsigned long long maxOutstanding = mongoImportGlobalParams.parseThreads * 2;
+        const size_t linesPerBatch = 1024;
+
+        boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
+
+        unsigned long long nextId = 0;
+        unsigned long long nextToInsert = 0;
+        bool stop = false;
+
+        while (in->rdstate() == 0 && !stop) {
+            auto_ptr<ParseBatch> batch(new ParseBatch());
+            while (batch->lines.size() < linesPerBatch && in->rdstate() == 0) {
+                char* line = buffer.get();
+                int numBytesRead;
+                try {
+                    numBytesRead = getLine(in, line);
+                }
+                catch ( const std::exception& e ) {
+                    toolError() << "exception:" << e.what() << std::endl;
+                    errors++;
+                    if (mongoImportGlobalParams.stopOnError) {
+                        stop = true;
+                        break;
+                    }
+                    continue;
+                }
+                line += numBytesRead;
+                if (line[0] == '\0')
+                    continue;
+                batch->bytes += numBytesRead + strlen(line) + 1;
+                batch->lines.push_back(line);
+            }
+
+            if (!batch->lines.empty()) {
+                batch->id = nextId++;
+                pool.schedule(boost::bind(&Import::parseBatchTask, this, batch.release()));
+            }
+
+            // insert whatever has finished parsing, and keep the parsers from
+            // running more than a few batches ahead of the inserts
+            nextToInsert = insertReadyBatches(ns, nextToInsert, num, lastNumChecked,
+                                              errors, pm, start);
+            while (nextId - nextToInsert > maxOutstanding) {
+                waitForParsedBatch(nextToInsert);
+                nextToInsert = insertReadyBatches(ns, nextToInsert, num, lastNumChecked,
+                                                  errors, pm, start);
+            }
+
+            if (errors && mongoImportGlobalParams.stopOnError)
+                stop = true;
+        }
+
+        while (nextToInsert < nextId) {
+            waitForParsedBatch(nextToInsert);
+            nextToInsert = insertReadyBatches(ns, nextToInsert, num, lastNumChecked,
+                                              errors, pm, start);
+        }
+    }
+
 public:
-    Import() : Tool() {
+    Import() : Tool(), _parseMutex("importParse") {
         _type = JSON;
     }
 
@@ -515,6 +688,9 @@ public:
                 }
             }
         }
+        else if (_type == JSON && mongoImportGlobalParams.parseThreads > 1) {
+            importJsonLinesParallel(ns, in, num, lastNumChecked, errors, pm, start);
+        }
         else {
             while (in->rdstate() == 0) {
                 try {
@@ -76,6 +76,10 @@ namespace mongo {
                 "Dump user and role definitions for the given database")
                         .requires("db").incompatibleWith("collection");
 
+        options->addOptionChaining("numParallelCollections", "numParallelCollections,j", moe::Int,
+                "number of collections to dump in parallel (4 by default)")
+                                  .setDefault(moe::Value(4));
+
         return Status::OK();
     }
 
@@ -122,6 +126,10 @@ namespace mongo {
             }
         }
         mongoDumpGlobalParams.outputDirectory = getParam("out");
+        mongoDumpGlobalParams.numParallelCollections = getParam("numParallelCollections", 4);
+        if (mongoDumpGlobalParams.numParallelCollections < 1) {
+            return Status(ErrorCodes::BadValue, "numParallelCollections must be a positive number");
+        }
         mongoDumpGlobalParams.snapShotQuery = false;
         if (!hasParam("query") && !hasParam("dbpath") && !hasParam("forceTableScan")) {
             mongoDumpGlobalParams.snapShotQuery = true;
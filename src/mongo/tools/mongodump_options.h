@@ -44,6 +44,7 @@ namespace mongo {
         bool repair;
         bool snapShotQuery;
         bool dumpUsersAndRoles;
+        int numParallelCollections;
     };
 
     extern MongoDumpGlobalParams mongoDumpGlobalParams;
@@ -90,6 +90,10 @@ namespace mongo {
         options->addOptionChaining("jsonArray", "jsonArray", moe::Switch,
                 "load a json array, not one item per line. Currently limited to 16MB.");
 
+        options->addOptionChaining("parseThreads", "parseThreads", moe::Int,
+                "number of threads to parse line-delimited JSON input with; "
+                "useful when the import is CPU bound on parsing. default 1");
+
 
         options->addOptionChaining("noimport", "noimport", moe::Switch,
                 "don't actually import. useful for benchmarking parser")
@@ -155,6 +159,10 @@ namespace mongo {
         mongoImportGlobalParams.jsonArray = hasParam("jsonArray");
         mongoImportGlobalParams.headerLine = hasParam("headerline");
         mongoImportGlobalParams.stopOnError = hasParam("stopOnError");
+        mongoImportGlobalParams.parseThreads = getParam("parseThreads", 1);
+        if (mongoImportGlobalParams.parseThreads < 1) {
+            return Status(ErrorCodes::BadValue, "parseThreads must be at least 1");
+        }
 
         return Status::OK();
     }
@@ -103,6 +103,10 @@ namespace mongo {
         options->addOptionChaining("w", "w", moe::Int, "minimum number of replicas per write")
                                   .setDefault(moe::Value(0));
 
+        options->addOptionChaining("batchSize", "batchSize", moe::Int,
+                "max number of documents per bulk insert (1000 by default)")
+                                  .setDefault(moe::Value(1000));
+
         options->addOptionChaining("dir", "dir", moe::String, "directory to restore from")
                                   .hidden()
                                   .setDefault(moe::Value(std::string("dump")))
@@ -155,6 +159,10 @@ namespace mongo {
         mongoRestoreGlobalParams.restoreOptions = !hasParam("noOptionsRestore");
         mongoRestoreGlobalParams.restoreIndexes = !hasParam("noIndexRestore");
         mongoRestoreGlobalParams.w = getParam( "w" , 0 );
+        mongoRestoreGlobalParams.batchSize = getParam( "batchSize" , 1000 );
+        if (mongoRestoreGlobalParams.batchSize < 1) {
+            return Status(ErrorCodes::BadValue, "batchSize must be a positive number");
+        }
         mongoRestoreGlobalParams.oplogReplay = hasParam("oplogReplay");
         mongoRestoreGlobalParams.oplogLimit = getParam("oplogLimit", "");
         mongoRestoreGlobalParams.tempUsersColl = getParam("tempUsersCollection");
@@ -46,6 +46,7 @@ namespace mongo {
         bool restoreIndexes;
         bool restoreUsersAndRoles;
         int w;
+        int batchSize;
         std::string restoreDirectory;
         std::string tempUsersColl;
         std::string tempRolesColl;
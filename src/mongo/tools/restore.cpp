@@ -56,6 +56,10 @@ using namespace mongo;
 
 namespace {
     const char* OPLOG_SENTINEL = "$oplog";  // compare by ptr not strcmp
+
+    // flush a partially filled insert batch once it holds this many bytes,
+    // regardless of --batchSize; keeps messages well under the wire maximum
+    const int INSERT_BATCH_MAX_BYTES = 8 * 1024 * 1024;
 }
 
 class Restore : public BSONTool {
@@ -74,8 +78,10 @@ public:
     int _serverAuthzVersion; // authSchemaVersion of the cluster being restored into.
     int _dumpFileAuthzVersion; // version extracted from admin.system.version file in dump.
     bool _serverAuthzVersionDocExists; // Whether the remote cluster has an admin.system.version doc
+    vector<BSONObj> _insertBatch; // Documents awaiting the next bulk insert into _curns
+    int _insertBatchBytes; // Total size of the documents in _insertBatch
     Restore() : BSONTool(), _oplogEntrySkips(0), _oplogEntryApplies(0), _serverAuthzVersion(0),
-            _dumpFileAuthzVersion(0), _serverAuthzVersionDocExists(false) { }
+            _dumpFileAuthzVersion(0), _serverAuthzVersionDocExists(false), _insertBatchBytes(0) { }
 
     virtual void printHelp(ostream& out) {
         printMongoRestoreHelp(&out);
@@ -507,6 +513,7 @@ public:
 
         // 3) Actually restore the BSONObjs inside the dump file
         processFile( root );
+        flushInserts(); // the users/roles merging and index builds below must see every document
 
         // 4) If running with --drop, remove any users/roles that were in the system at the
         // beginning of the restore but weren't found in the dump file
@@ -710,7 +717,16 @@ public:
                                 << _dumpFileAuthzVersion,
                     _serverAuthzVersion == _dumpFileAuthzVersion);
             }
-            conn().insert(_curns, obj);
+
+            // Ordinary data documents are grouped into bulk inserts; the write
+            // concern wait, if any, happens per batch in flushInserts().
+            _insertBatch.push_back(obj.getOwned());
+            _insertBatchBytes += obj.objsize();
+            if (static_cast<int>(_insertBatch.size()) >= mongoRestoreGlobalParams.batchSize ||
+                    _insertBatchBytes >= INSERT_BATCH_MAX_BYTES) {
+                flushInserts();
+            }
+            return;
         }
 
         // wait for insert (or update) to propagate to "w" nodes (doesn't warn if w used
@@ -725,6 +741,29 @@ public:
 
 private:
 
+    /**
+     * Sends the pending insert batch, if any, to _curns.  ContinueOnError keeps
+     * parity with the old one-document-at-a-time inserts: a duplicate key in the
+     * middle of a batch doesn't abort the documents behind it.
+     */
+    void flushInserts() {
+        if (_insertBatch.empty())
+            return;
+
+        conn().insert(_curns, _insertBatch, InsertOption_ContinueOnError);
+        _insertBatch.clear();
+        _insertBatchBytes = 0;
+
+        // wait for the batch to propagate to "w" nodes (doesn't warn if w used
+        // without replset)
+        if (mongoRestoreGlobalParams.w > 0) {
+            string err = conn().getLastError(_curdb, false, false, mongoRestoreGlobalParams.w);
+            if (!err.empty()) {
+                toolError() << err << std::endl;
+            }
+        }
+    }
+
     BSONObj parseMetadataFile(string filePath) {
         long long fileSize = boost::filesystem::file_size(filePath);
         ifstream file(filePath.c_str(), ios_base::in);
@@ -0,0 +1,183 @@
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+    /**
+     * Bounded multi-producer, single-consumer sink backed by a drainer thread.
+     *
+     * Producers call push() with a fully formatted entry; push() copies the
+     * entry onto a bounded in-memory queue under a short critical section and
+     * returns, so producers pay only for the enqueue no matter how slow the
+     * destination is.  A single drainer thread removes entries in production
+     * order and hands each one to the subclass's consume().
+     *
+     * Backpressure is drop-oldest: when the queue is full, push() discards
+     * the oldest queued entry to make room rather than blocking the producer.
+     * Discards are counted, reported by the drainer thread when it catches
+     * up, and available via dropped().  This makes sinks suitable for
+     * best-effort diagnostic streams (profiling, in-memory logs); wrap the
+     * destination in a logger::AsyncAppender instead when losing entries is
+     * unacceptable.
+     *
+     * The drainer thread is not spawned until start() is called; entries
+     * pushed before then simply wait (bounded) in the queue.  Sink singletons
+     * are expected to be leaked, like RamLogs; the destructor exists for
+     * completeness and joins the drainer after it empties the queue.
+     */
+    template <typename T>
+    class AsyncSink {
+        MONGO_DISALLOW_COPYING(AsyncSink);
+
+    public:
+        AsyncSink( const std::string& name, size_t maxQueued )
+            : _name( name ),
+              _maxQueued( maxQueued ),
+              _dropped( 0 ),
+              _started( false ),
+              _shutdown( false ) {
+        }
+
+        virtual ~AsyncSink() {
+            {
+                boost::lock_guard<boost::mutex> lk( _mutex );
+                if ( !_started )
+                    return;
+                _shutdown = true;
+                _notEmpty.notify_one();
+            }
+            _drainer.join();  // the drainer empties the queue before exiting
+        }
+
+        /**
+         * Spawns the drainer thread.  Meant to be called once during startup;
+         * subsequent calls are ignored.
+         */
+        void start() {
+            boost::lock_guard<boost::mutex> lk( _mutex );
+            if ( _started )
+                return;
+            _started = true;
+            _drainer = boost::thread( boost::bind( &AsyncSink::_drainerThread, this ) );
+        }
+
+        bool started() const {
+            boost::lock_guard<boost::mutex> lk( _mutex );
+            return _started;
+        }
+
+        /**
+         * Queues a copy of "entry" for the drainer thread; never blocks.  If
+         * the queue is full, the oldest queued entry is dropped to make room.
+         */
+        void push( const T& entry ) {
+            boost::lock_guard<boost::mutex> lk( _mutex );
+            if ( _queue.size() >= _maxQueued ) {
+                _queue.pop_front();
+                _dropped++;
+            }
+            _queue.push_back( entry );
+            _notEmpty.notify_one();
+        }
+
+        /**
+         * Total entries discarded because the queue was full.
+         */
+        long long dropped() const {
+            boost::lock_guard<boost::mutex> lk( _mutex );
+            return _dropped;
+        }
+
+    protected:
+        /**
+         * Called on the drainer thread, once per entry, in production order.
+         * Exceptions escaping consume() are caught and logged.
+         */
+        virtual void consume( const T& entry ) = 0;
+
+        /**
+         * Called once on the drainer thread, before the first consume().
+         * Subclasses whose consume() touches database state initialize their
+         * Client here.
+         */
+        virtual void onDrainerThreadStart() {}
+
+    private:
+        void _drainerThread() {
+            onDrainerThreadStart();
+
+            long long reportedDrops = 0;
+            while ( true ) {
+                std::deque<T> batch;
+                long long droppedSoFar;
+                {
+                    boost::unique_lock<boost::mutex> lk( _mutex );
+                    while ( _queue.empty() && !_shutdown ) {
+                        _notEmpty.wait( lk );
+                    }
+                    if ( _queue.empty() )
+                        return;
+                    // take the whole backlog in one swap so producers never
+                    // wait behind a consume()
+                    batch.swap( _queue );
+                    droppedSoFar = _dropped;
+                }
+
+                for ( typename std::deque<T>::const_iterator i = batch.begin();
+                      i != batch.end(); ++i ) {
+                    try {
+                        consume( *i );
+                    }
+                    catch ( const std::exception& e ) {
+                        error() << _name << ": error consuming queued entry: "
+                                << e.what() << std::endl;
+                    }
+                }
+
+                if ( droppedSoFar > reportedDrops ) {
+                    warning() << _name << ": dropped "
+                              << ( droppedSoFar - reportedDrops )
+                              << " queued entries (queue full)" << std::endl;
+                    reportedDrops = droppedSoFar;
+                }
+            }
+        }
+
+        const std::string _name;
+        const size_t _maxQueued;
+
+        mutable boost::mutex _mutex;  // guards everything below
+        boost::condition_variable _notEmpty;
+        std::deque<T> _queue;
+        long long _dropped;
+        bool _started;
+        bool _shutdown;
+
+        boost::thread _drainer;  // started by start()
+    };
+
+}  // namespace mongo
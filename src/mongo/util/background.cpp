@@ -32,87 +32,37 @@
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/time_support.h"
 #include "mongo/util/timer.h"
+#include "mongo/util/timer_wheel.h"
 
 using namespace std;
 namespace mongo {
 
     namespace {
 
-        class PeriodicTaskRunner : public BackgroundJob {
-        public:
+        // How often each PeriodicTask runs. Use a shorter cycle time in debug mode
+        // to help catch race conditions.
+        const int taskPeriodSecs = debug ? 5 : 60;
 
-            PeriodicTaskRunner()
-                : _mutex("PeriodicTaskRunner")
-                , _shutdownRequested(false) {}
+        // Runs one task to completion on the timer wheel thread, and optionally
+        // reports timing.
+        void runPeriodicTask( PeriodicTask* task ) {
+            Timer timer;
 
-            void add( PeriodicTask* task );
-            void remove( PeriodicTask* task );
+            const std::string taskName = task->taskName();
 
-            Status stop( int gracePeriodMillis );
-
-        private:
-
-            virtual std::string name() const {
-                return "PeriodicTaskRunner";
+            try {
+                task->taskDoWork();
             }
-
-            virtual void run();
-
-            // Returns true if shutdown has been requested.  You must hold _mutex to call this
-            // function.
-            bool _isShutdownRequested() const;
-
-            // Runs all registered tasks. You must hold _mutex to call this function.
-            void _runTasks();
-
-            // Runs one task to completion, and optionally reports timing. You must hold _mutex
-            // to call this function.
-            void _runTask( PeriodicTask* task );
-
-            // _mutex protects the _shutdownRequested flag and the _tasks vector.
-            mongo::mutex _mutex;
-
-            // The condition variable is used to sleep for the interval between task
-            // executions, and is notified when the _shutdownRequested flag is toggled.
-            boost::condition _cond;
-
-            // Used to break the loop. You should notify _cond after changing this to true
-            // so that shutdown proceeds promptly.
-            bool _shutdownRequested;
-
-            // The PeriodicTasks contained in this vector are NOT owned by the
-            // PeriodicTaskRunner, and are not deleted. The vector never shrinks, removed Tasks
-            // have their entry overwritten with NULL.
-            std::vector< PeriodicTask* > _tasks;
-        };
-
-        // We rely here on zero-initialization of 'runnerMutex' to distinguish whether we are
-        // running before or after static initialization for this translation unit has
-        // completed. In the former case, we assume no threads are present, so we do not need
-        // to use the mutex. When present, the mutex protects 'runner' and 'runnerDestroyed'
-        // below.
-        SimpleMutex* const runnerMutex = new SimpleMutex("PeriodicTaskRunner");
-
-        // A scoped lock like object that only locks/unlocks the mutex if it exists.
-        class ConditionalScopedLock {
-        public:
-            ConditionalScopedLock( SimpleMutex* mutex ) : _mutex( mutex ) {
-                if ( _mutex )
-                    _mutex->lock();
+            catch ( const std::exception& e ) {
+                error() << "task: " << taskName << " failed: " << e.what() << endl;
             }
-            ~ConditionalScopedLock() {
-                if ( _mutex )
-                    _mutex->unlock();
+            catch ( ... ) {
+                error() << "task: " << taskName << " failed with unknown error" << endl;
             }
-        private:
-            SimpleMutex* const _mutex;
-        };
 
-        // The unique PeriodicTaskRunner, also zero-initialized.
-        PeriodicTaskRunner* runner;
-
-        // The runner is never re-created once it has been destroyed.
-        bool runnerDestroyed;
+            const int ms = timer.millis();
+            LOG( ms <= 3 ? 3 : 0 ) << "task: " << taskName << " took: " << ms << "ms" << endl;
+        }
 
     } // namespace
 
@@ -234,126 +184,30 @@ namespace mongo {
 
     // -------------------------
 
-    PeriodicTask::PeriodicTask() {
-        ConditionalScopedLock lock( runnerMutex );
-        if ( runnerDestroyed )
+    PeriodicTask::PeriodicTask() : _wheelJobId( 0 ) {
+        TimerWheel* wheel = globalTimerWheel();
+        if ( !wheel )
             return;
 
-        if ( !runner )
-            runner = new PeriodicTaskRunner;
-
-        runner->add( this );
+        // taskName() is virtual and cannot be called from this constructor, so the
+        // wheel's diagnostic name is generic; runPeriodicTask logs the real name.
+        _wheelJobId = wheel->schedulePeriodic( "periodic task",
+                                               boost::bind( &runPeriodicTask, this ),
+                                               taskPeriodSecs );
     }
 
     PeriodicTask::~PeriodicTask() {
-        ConditionalScopedLock lock( runnerMutex );
-        if ( runnerDestroyed || !runner )
-            return;
-
-        runner->remove( this );
+        TimerWheel* wheel = globalTimerWheel();
+        if ( wheel && _wheelJobId )
+            wheel->unschedule( _wheelJobId );
     }
 
     void PeriodicTask::startRunningPeriodicTasks() {
-        ConditionalScopedLock lock( runnerMutex );
-        if ( runnerDestroyed )
-            return;
-
-        if ( !runner )
-            runner = new PeriodicTaskRunner;
-
-        runner->go();
+        startGlobalTimerWheel();
     }
 
     Status PeriodicTask::stopRunningPeriodicTasks( int gracePeriodMillis ) {
-        ConditionalScopedLock lock( runnerMutex );
-
-        Status status = Status::OK();
-        if ( runnerDestroyed || !runner )
-            return status;
-
-        runner->cancel();
-        status = runner->stop( gracePeriodMillis );
-
-        if ( status.isOK() ) {
-            delete runner;
-            runnerDestroyed = true;
-        }
-
-        return status;
-    }
-
-    void PeriodicTaskRunner::add( PeriodicTask* task ) {
-        mutex::scoped_lock lock( _mutex );
-        _tasks.push_back( task );
-    }
-
-    void PeriodicTaskRunner::remove( PeriodicTask* task ) {
-        mutex::scoped_lock lock( _mutex );
-        for ( size_t i = 0; i != _tasks.size(); i++ ) {
-            if ( _tasks[i] == task ) {
-                _tasks[i] = NULL;
-                break;
-            }
-        }
-    }
-
-    Status PeriodicTaskRunner::stop( int gracePeriodMillis ) {
-        {
-            mutex::scoped_lock lock( _mutex );
-            _shutdownRequested = true;
-            _cond.notify_one();
-        }
-
-        if ( !wait( gracePeriodMillis ) ) {
-            return Status( ErrorCodes::ExceededTimeLimit,
-                           "Grace period expired while waiting for PeriodicTasks to terminate" );
-        }
-        return Status::OK();
-    }
-
-    void PeriodicTaskRunner::run() {
-        // Use a shorter cycle time in debug mode to help catch race conditions.
-        const size_t waitMillis = (debug ? 5 : 60) * 1000;
-
-        const boost::function<bool()> predicate =
-            boost::bind( &PeriodicTaskRunner::_isShutdownRequested, this );
-
-        mutex::scoped_lock lock( _mutex );
-        while ( !predicate() ) {
-            const boost::xtime deadline = incxtimemillis( waitMillis );
-            if ( !_cond.timed_wait( lock.boost(), deadline, predicate ) )
-                _runTasks();
-        }
-    }
-
-    bool PeriodicTaskRunner::_isShutdownRequested() const {
-        return _shutdownRequested;
-    }
-
-    void PeriodicTaskRunner::_runTasks() {
-        const size_t size = _tasks.size();
-        for ( size_t i = 0; i != size; ++i )
-            if ( PeriodicTask* const task = _tasks[i] )
-                _runTask(task);
-    }
-
-    void PeriodicTaskRunner::_runTask(PeriodicTask* const task) {
-        Timer timer;
-
-        const std::string taskName = task->taskName();
-
-        try {
-            task->taskDoWork();
-        }
-        catch ( const std::exception& e ) {
-            error() << "task: " << taskName << " failed: " << e.what() << endl;
-        }
-        catch ( ... ) {
-            error() << "task: " << taskName << " failed with unknown error" << endl;
-        }
-
-        const int ms = timer.millis();
-        LOG( ms <= 3 ? 3 : 0 ) << "task: " << taskName << " took: " << ms << "ms" << endl;
+        return stopGlobalTimerWheel( gracePeriodMillis );
     }
 
 } // namespace mongo
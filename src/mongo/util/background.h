@@ -120,7 +120,8 @@ namespace mongo {
     };
 
     /**
-     * these run "roughly" every minute
+     * these run "roughly" every minute, each at its own phase on the shared timer
+     * wheel (see util/timer_wheel.h)
      * instantiate statically
      * class MyTask : public PeriodicTask {
      * public:
@@ -137,24 +138,30 @@ namespace mongo {
         virtual std::string taskName() const = 0;
 
         /**
-         *  Starts the BackgroundJob that runs PeriodicTasks. You may call this multiple times,
-         *  from multiple threads, and the BackgroundJob will be started only once. Please note
+         *  Starts the timer wheel thread that runs PeriodicTasks. You may call this multiple
+         *  times, from multiple threads, and the thread will be started only once. Please note
          *  that since this method starts threads, it is not appropriate to call it from within
          *  a mongo initializer. Calling this method after calling 'stopRunningPeriodicTasks'
-         *  does not re-start the background job.
+         *  does not re-start the background thread.
          */
         static void startRunningPeriodicTasks();
 
         /**
-         *  Waits 'gracePeriodMillis' for the BackgroundJob responsible for PeriodicTask
-         *  execution to finish any running tasks, then destroys it. If the BackgroundJob was
-         *  never started, returns Status::OK right away. If the BackgroundJob does not
-         *  terminate within the grace period, returns an invalid status. It is safe to call
-         *  this method repeatedly from one thread if the grace period is overshot. It is not
+         *  Waits 'gracePeriodMillis' for the timer wheel responsible for PeriodicTask
+         *  execution to finish any running tasks, then destroys it. If the timer wheel was
+         *  never started, returns Status::OK right away. If its thread does not terminate
+         *  within the grace period, returns an invalid status. It is safe to call this
+         *  method repeatedly from one thread if the grace period is overshot. It is not
          *  safe to call this method from multiple threads, or in a way that races with
-         *  'startRunningPeriodicTasks'.
+         *  'startRunningPeriodicTasks'. Note that this stops the whole shared wheel, so
+         *  every other job registered on it stops too.
          */
         static Status stopRunningPeriodicTasks( int gracePeriodMillis );
+
+    private:
+        // This task's registration on the global timer wheel, or zero if the wheel
+        // had already been shut down when the task was constructed.
+        size_t _wheelJobId;
     };
 
 
@@ -0,0 +1,103 @@
+// buffer_pool.cpp
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/util/buffer_pool.h"
+
+#include <boost/thread/tss.hpp>
+
+namespace mongo {
+
+    namespace {
+
+        int classIndex( int size ) {
+            // pooled classes are the exact powers of two in
+            // [MinPooledSize, MaxPooledSize]
+            if ( size < BufferPool::MinPooledSize || size > BufferPool::MaxPooledSize )
+                return -1;
+            if ( size & ( size - 1 ) )
+                return -1;
+            int idx = 0;
+            for ( int s = BufferPool::MinPooledSize; s < size; s *= 2 )
+                idx++;
+            return idx;
+        }
+
+        const int NumClasses = 10; // 512B .. 256KB
+
+        struct ThreadCache {
+            ThreadCache() {
+                memset( counts, 0, sizeof(counts) );
+            }
+            ~ThreadCache() {
+                for ( int c = 0; c < NumClasses; c++ )
+                    for ( int i = 0; i < counts[c]; i++ )
+                        free( blocks[c][i] );
+            }
+            char* blocks[NumClasses][BufferPool::MaxBlocksPerClass];
+            int counts[NumClasses];
+        };
+
+        boost::thread_specific_ptr<ThreadCache> threadCache;
+
+        ThreadCache* cache() {
+            ThreadCache* c = threadCache.get();
+            if ( !c ) {
+                c = new ThreadCache();
+                threadCache.reset( c );
+            }
+            return c;
+        }
+    }
+
+    int BufferPool::roundUp( int minSize ) {
+        if ( minSize > MaxPooledSize )
+            return minSize;
+        int s = MinPooledSize;
+        while ( s < minSize )
+            s *= 2;
+        return s;
+    }
+
+    char* BufferPool::acquire( int minSize ) {
+        int size = roundUp( minSize );
+        int idx = classIndex( size );
+        if ( idx >= 0 ) {
+            ThreadCache* c = cache();
+            if ( c->counts[idx] > 0 )
+                return c->blocks[idx][ --c->counts[idx] ];
+        }
+        char* p = (char*)malloc( size );
+        if ( p == 0 )
+            msgasserted( 17429, "out of memory BufferPool::acquire" );
+        return p;
+    }
+
+    void BufferPool::release( char* buf, int allocSize ) {
+        if ( !buf )
+            return;
+        int idx = classIndex( allocSize );
+        if ( idx >= 0 ) {
+            ThreadCache* c = cache();
+            if ( c->counts[idx] < MaxBlocksPerClass ) {
+                c->blocks[idx][ c->counts[idx]++ ] = buf;
+                return;
+            }
+        }
+        free( buf );
+    }
+
+}  // namespace mongo
@@ -0,0 +1,104 @@
+// buffer_pool.h
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include "mongo/bson/util/builder.h"
+
+namespace mongo {
+
+    /**
+     * Thread-local, size-classed cache of malloc'ed buffers for the request
+     * reply path.  Blocks are plain malloc allocations of exactly a
+     * power-of-two class size, so a pooled buffer may always be handed to
+     * code that eventually releases it with free() -- it is then simply not
+     * recycled.  Likewise release() of a block the pool did not hand out is
+     * harmless.  No locking: each thread caches its own blocks.
+     */
+    class BufferPool {
+    public:
+        enum {
+            MinPooledSize = 512,
+            MaxPooledSize = 256 * 1024,
+            MaxBlocksPerClass = 4
+        };
+
+        /**
+         * Rounds minSize up to the allocation class acquire() will actually
+         * use: the next power of two within [MinPooledSize, MaxPooledSize].
+         * Sizes outside that range are returned unchanged (not pooled).
+         */
+        static int roundUp( int minSize );
+
+        /**
+         * @return a block of at least roundUp(minSize) bytes, from the
+         * current thread's cache when possible, malloc otherwise.  The
+         * caller owns the block.
+         */
+        static char* acquire( int minSize );
+
+        /**
+         * Gives a block back to the current thread's cache (or frees it if
+         * the cache is full or the size is not a pooled class).
+         * @param allocSize the block's full allocation size -- the
+         * roundUp() of what was passed to acquire() -- not the bytes used.
+         */
+        static void release( char* buf, int allocSize );
+    };
+
+    /**
+     * Allocator for _BufBuilder that draws from BufferPool.  Tracks the
+     * class of the builder's current block, so buffers cycle through the
+     * thread's cache instead of malloc/realloc/free.  A decouple()d buffer
+     * simply escapes the pool; see BufferPool.
+     */
+    class PooledBufferAllocator {
+    public:
+        PooledBufferAllocator() : _size( 0 ) {}
+
+        void* Malloc( size_t sz ) {
+            _size = BufferPool::roundUp( (int)sz );
+            return BufferPool::acquire( (int)sz );
+        }
+        void* Realloc( void* p, size_t sz ) {
+            if ( p == 0 )
+                return Malloc( sz );
+            int newSize = BufferPool::roundUp( (int)sz );
+            if ( newSize == _size )
+                return p;
+            char* n = BufferPool::acquire( (int)sz );
+            memcpy( n, p, _size < newSize ? _size : newSize );
+            BufferPool::release( (char*)p, _size );
+            _size = newSize;
+            return n;
+        }
+        void Free( void* p ) {
+            BufferPool::release( (char*)p, _size );
+        }
+
+    private:
+        int _size; // allocation size of the builder's current block
+    };
+
+    /**
+     * BufBuilder variant whose storage cycles through the thread's
+     * BufferPool.  Use for reply buffers; pair with Message::setPooledData()
+     * to hand the finished buffer to the outbound message without a copy.
+     */
+    typedef _BufBuilder<PooledBufferAllocator> PooledBufBuilder;
+
+}  // namespace mongo
@@ -0,0 +1,221 @@
+// epoch_reclamation.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#include "mongo/util/concurrency/epoch_reclamation.h"
+
+#include <cstddef>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+    /**
+     * One slot per thread that has ever entered a read guard.  Slots hang off
+     * a global list that is only ever appended to; when a thread exits, its
+     * slot is recycled for the next new thread rather than unlinked, so the
+     * epoch-advance scan can walk the list without worrying about teardown.
+     *
+     * In namespace mongo rather than file-static because C++03 forbids types
+     * with internal linkage as template arguments (TSP<> below).
+     */
+    struct EpochThreadSlot {
+        AtomicUInt32 epoch;    // global epoch observed at outermost guard entry
+        AtomicUInt32 nesting;  // guard depth; 0 == quiescent
+        AtomicUInt32 claimed;  // owned by a live thread
+        EpochThreadSlot* next;
+
+        // Keep each thread's hot fields off its neighbours' cache lines.
+        char padding[64 - 3 * sizeof(AtomicUInt32) - sizeof(EpochThreadSlot*)];
+
+        EpochThreadSlot() : epoch(0), nesting(0), claimed(1), next(NULL) {}
+    };
+
+    /** Thread-local handle; releases the slot for reuse when the thread dies. */
+    struct EpochSlotRef {
+        EpochThreadSlot* slot;
+        EpochSlotRef() : slot(NULL) {}
+        ~EpochSlotRef() {
+            if (slot)
+                slot->claimed.store(0);
+        }
+    };
+
+    TSP_DECLARE(EpochSlotRef, epochSlotRef)
+    TSP_DEFINE(EpochSlotRef, epochSlotRef)
+
+    namespace {
+
+        // Retirement runs three buckets deep: an object retired in epoch E
+        // may still be visible to readers active in E and E-1, so its bucket
+        // is freed when the global epoch has advanced to E+2.
+        const unsigned kEpochBuckets = 3;
+
+        struct RetiredNode {
+            void* p;
+            EpochReclamation::DisposeFn dispose;
+            RetiredNode* next;
+        };
+
+        // ebrLock guards the slot registry, the limbo buckets and the pending
+        // count.  The global epoch is read lock-free on guard entry but only
+        // advanced under the lock.
+        SpinLock ebrLock;
+        AtomicUInt32 globalEpoch(1);
+        EpochThreadSlot* slotList = NULL;
+        RetiredNode* limbo[kEpochBuckets] = { NULL, NULL, NULL };
+        long long pendingCount = 0;
+
+        EpochThreadSlot* claimSlot() {
+            scoped_spinlock lk(ebrLock);
+            for (EpochThreadSlot* s = slotList; s; s = s->next) {
+                if (!s->claimed.load()) {
+                    s->claimed.store(1);
+                    return s;
+                }
+            }
+            EpochThreadSlot* s = new EpochThreadSlot();
+            s->next = slotList;
+            slotList = s;
+            return s;
+        }
+
+        EpochThreadSlot* mySlot() {
+            EpochSlotRef* ref = epochSlotRef.getMake();
+            if (!ref->slot)
+                ref->slot = claimSlot();
+            return ref->slot;
+        }
+
+        /**
+         * Advances the global epoch if no active reader is still in an older
+         * one, and returns the limbo bucket that became reclaimable -- the
+         * caller disposes of it after dropping ebrLock, since disposers may
+         * retire() more memory.  Returns NULL (and leaves the buckets alone)
+         * while an older reader pins the epoch.  Must hold ebrLock.
+         */
+        RetiredNode* tryAdvance_inlock() {
+            const unsigned e = globalEpoch.load();
+            for (EpochThreadSlot* s = slotList; s; s = s->next) {
+                if (s->nesting.load() > 0 && s->epoch.load() != e)
+                    return NULL;
+            }
+            globalEpoch.store(e + 1);
+            // Everything retired in epoch e-1 is now unreachable: the scan
+            // proved all active readers entered in e, and e-1's retirees were
+            // unlinked before any reader in e arrived.
+            const unsigned bucket = (e + 2) % kEpochBuckets;  // == e-1 mod 3
+            RetiredNode* ready = limbo[bucket];
+            limbo[bucket] = NULL;
+            return ready;
+        }
+
+        void disposeAll(RetiredNode* n) {
+            long long freed = 0;
+            while (n) {
+                RetiredNode* next = n->next;
+                n->dispose(n->p);
+                delete n;
+                ++freed;
+                n = next;
+            }
+            if (freed) {
+                scoped_spinlock lk(ebrLock);
+                pendingCount -= freed;
+            }
+        }
+
+    }  // namespace
+
+    EpochReadGuard::EpochReadGuard() {
+        EpochThreadSlot* slot = mySlot();
+        const unsigned depth = slot->nesting.load();
+        if (0 == depth) {
+            slot->nesting.store(1);
+            // Announce the epoch with a swap: its full barrier makes both
+            // announcements globally visible before any of the guarded reads
+            // that follow, so the advance scan can never miss this reader
+            // while it holds a pointer into retired memory.  A stale epoch
+            // read here (the global advancing concurrently) only delays
+            // reclamation, never loses it.
+            slot->epoch.swap(globalEpoch.load());
+        }
+        else {
+            slot->nesting.store(depth + 1);
+        }
+    }
+
+    EpochReadGuard::~EpochReadGuard() {
+        EpochThreadSlot* slot = mySlot();
+        const unsigned depth = slot->nesting.load();
+        dassert(depth > 0);
+        // The release semantics order the guarded reads before the slot goes
+        // quiescent.
+        slot->nesting.store(depth - 1);
+    }
+
+    void EpochReclamation::retire(void* p, DisposeFn dispose) {
+        RetiredNode* node = new RetiredNode();
+        node->p = p;
+        node->dispose = dispose;
+
+        RetiredNode* ready;
+        {
+            scoped_spinlock lk(ebrLock);
+            const unsigned bucket = globalEpoch.load() % kEpochBuckets;
+            node->next = limbo[bucket];
+            limbo[bucket] = node;
+            ++pendingCount;
+            ready = tryAdvance_inlock();
+        }
+        disposeAll(ready);
+    }
+
+    long long EpochReclamation::pendingReclaims() {
+        scoped_spinlock lk(ebrLock);
+        return pendingCount;
+    }
+
+    void EpochReclamation::drain() {
+        // Each successful advance frees one bucket, so with no readers in the
+        // way three rounds flush everything.
+        for (unsigned i = 0; i < kEpochBuckets; i++) {
+            RetiredNode* ready;
+            {
+                scoped_spinlock lk(ebrLock);
+                ready = tryAdvance_inlock();
+            }
+            disposeAll(ready);
+        }
+    }
+
+}  // namespace mongo
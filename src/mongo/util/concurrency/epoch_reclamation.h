@@ -0,0 +1,119 @@
+// epoch_reclamation.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+
+namespace mongo {
+
+    /**
+     * Epoch based reclamation (EBR) for lock-free, read-mostly data structures.
+     *
+     * Lock-free readers cannot take a reference count without turning every
+     * lookup into shared-cacheline traffic, but a writer that swaps out part
+     * of a structure must not delete the old memory while a reader may still
+     * be chasing pointers into it.  EBR closes that gap: readers bracket each
+     * traversal with an EpochReadGuard, writers hand replaced memory to
+     * EpochReclamation::retire(), and the memory is deleted once every guard
+     * that could possibly have seen it has been released.
+     *
+     * Usage, with an atomically swapped snapshot as the typical case:
+     *
+     *     // reader -- no locks, no reference counts
+     *     {
+     *         EpochReadGuard guard;
+     *         const Snapshot* s = currentSnapshot;  // safe until guard dies
+     *         ...
+     *     }
+     *
+     *     // writer
+     *     const Snapshot* old = swapInNewSnapshot();
+     *     EpochReclamation::retire(old);            // deleted when safe
+     *
+     * Entering and leaving a guard costs a thread-local lookup and a couple
+     * of atomic operations on a cache line no other thread writes; guards
+     * nest freely.  retire() is the writer side; it takes a spinlock, which
+     * the update paths of read-mostly structures can afford.
+     *
+     * Guards must not be held across yields, lock acquisitions or anything
+     * else that can block: an active guard pins every object retired
+     * anywhere in the process since it was entered.
+     */
+    class EpochReclamation {
+        MONGO_DISALLOW_COPYING(EpochReclamation);
+    public:
+        typedef void (*DisposeFn)(void*);
+
+        /**
+         * Hands p over for deferred deletion once no read guard that was
+         * active at the time of this call remains.  p must already be
+         * unreachable for readers arriving after this returns.
+         */
+        template <typename T>
+        static void retire(T* p) { retire(p, &_disposeOf<T>); }
+
+        /**
+         * As above, but with an explicit disposer for memory that operator
+         * delete can't free (arrays, arena allocations, ...).
+         */
+        static void retire(void* p, DisposeFn dispose);
+
+        /** Count of objects retired but not yet reclaimed. */
+        static long long pendingReclaims();
+
+        /**
+         * Reclaims everything reclaimable right now, advancing the epoch as
+         * far as active readers allow.  Primarily for tests and shutdown;
+         * normal operation amortizes the advance over retire() calls.
+         */
+        static void drain();
+
+    private:
+        EpochReclamation();  // static-only
+
+        template <typename T>
+        static void _disposeOf(void* p) { delete static_cast<T*>(p); }
+    };
+
+    /**
+     * RAII read-side critical section for EpochReclamation.  Enter the guard
+     * before loading any pointer into the protected structure; every pointer
+     * reached from then on stays valid until the outermost guard on this
+     * thread is destroyed.
+     */
+    class EpochReadGuard {
+        MONGO_DISALLOW_COPYING(EpochReadGuard);
+    public:
+        EpochReadGuard();
+        ~EpochReadGuard();
+    };
+
+}  // namespace mongo
@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/epoch_reclamation.h"
+
+namespace {
+
+    using mongo::EpochReadGuard;
+    using mongo::EpochReclamation;
+
+    // Counts its own destructions so tests can see when reclamation ran.
+    struct Tracked {
+        explicit Tracked( int* deletions ) : _deletions(deletions) {}
+        ~Tracked() { ++*_deletions; }
+        int* _deletions;
+    };
+
+    TEST( EpochReclamation, RetireWithoutReadersReclaims ) {
+        int deletions = 0;
+        EpochReclamation::retire( new Tracked( &deletions ) );
+        EpochReclamation::retire( new Tracked( &deletions ) );
+        EpochReclamation::drain();
+        ASSERT_EQUALS( 2, deletions );
+    }
+
+    TEST( EpochReclamation, ActiveGuardPinsRetiredObject ) {
+        int deletions = 0;
+        {
+            EpochReadGuard guard;
+            EpochReclamation::retire( new Tracked( &deletions ) );
+            EpochReclamation::drain();
+            ASSERT_EQUALS( 0, deletions );
+            ASSERT_GREATER_THAN_OR_EQUALS( EpochReclamation::pendingReclaims(), 1LL );
+        }
+        EpochReclamation::drain();
+        ASSERT_EQUALS( 1, deletions );
+    }
+
+    TEST( EpochReclamation, GuardsNest ) {
+        int deletions = 0;
+        {
+            EpochReadGuard outer;
+            {
+                EpochReadGuard inner;
+                EpochReclamation::retire( new Tracked( &deletions ) );
+            }
+            // Leaving the inner guard must not release the pin.
+            EpochReclamation::drain();
+            ASSERT_EQUALS( 0, deletions );
+        }
+        EpochReclamation::drain();
+        ASSERT_EQUALS( 1, deletions );
+    }
+
+    int customDisposals = 0;
+    void countingDispose( void* p ) {
+        delete[] static_cast<char*>( p );
+        ++customDisposals;
+    }
+
+    TEST( EpochReclamation, CustomDisposer ) {
+        EpochReclamation::retire( static_cast<void*>( new char[16] ),
+                                  &countingDispose );
+        EpochReclamation::drain();
+        ASSERT_EQUALS( 1, customDisposals );
+    }
+
+}  // namespace
@@ -72,6 +72,14 @@ namespace mongo {
         transition, all threads in the "w" state must be blocked in w_to_X().  When all threads in
         the "w" state are blocked in w_to_X(), one thread will be released in the X state.  The
         other threads remain blocked in w_to_X() until the thread in the X state calls X_to_w().
+
+        Scheduling policy: a pending W normally jumps the queue (no new r/R/w
+        are admitted while it waits).  To avoid convoys under sustained write
+        pressure, only a bounded run of W grants may jump the queue while
+        r/R/w requests wait (setMaxConsecutiveQueueJumpingWrites); after that
+        the waiters get one grant window.  Symmetrically, while a W waits,
+        readers are admitted in bounded groups (setReaderAdmissionLimit) so a
+        read flood cannot starve the writer.
     */
     class QLock : boost::noncopyable {
         struct Z { 
@@ -84,10 +92,56 @@ namespace mongo {
         int numPendingGlobalWrites;  // >0 if someone wants to acquire a write lock
         long long generationX;
         long long generationXExit;
+
+        // scheduling policy; see setMaxConsecutiveQueueJumpingWrites() and
+        // setReaderAdmissionLimit()
+        int policyMaxConsecutiveQueueJumps;
+        int policyReaderAdmissionLimit;
+
+        int consecutiveQueueJumps;   // W grants since the last r/R/w grant window
+        int readerAdmissionRemaining; // r/R grants left in the current window
+        int pendingShared;           // threads blocked entering r, R or w
+        bool sharedAdmittedSinceLastW;
+
         void _lock_W();
         void _unlock_R();
+
+        /** true when W has taken its full run of back-to-back grants while
+            granular/read requests starve; time to give them one window */
+        bool _queueJumpBudgetExhausted() const {
+            return policyMaxConsecutiveQueueJumps > 0 &&
+                   consecutiveQueueJumps >= policyMaxConsecutiveQueueJumps &&
+                   pendingShared > 0;
+        }
+
         bool _areQueueJumpingGlobalWritesPending() const {
-            return numPendingGlobalWrites > 0;
+            return numPendingGlobalWrites > 0 && !_queueJumpBudgetExhausted();
+        }
+
+        /** readers are admitted in groups of at most policyReaderAdmissionLimit
+            while a W is waiting, so a read flood cannot push the writer out
+            indefinitely.  0 means unbounded. */
+        bool _readerAdmissionOk() const {
+            return numPendingGlobalWrites == 0 ||
+                   policyReaderAdmissionLimit == 0 ||
+                   readerAdmissionRemaining > 0;
+        }
+
+        void _noteSharedGranted( bool isReader ) {
+            if ( numPendingGlobalWrites == 0 )
+                return;
+            sharedAdmittedSinceLastW = true;
+            if ( isReader && policyReaderAdmissionLimit > 0 && readerAdmissionRemaining > 0 )
+                --readerAdmissionRemaining;
+        }
+
+        void _noteGlobalWriteGranted() {
+            // a grant run only counts while it is actually starving someone
+            if ( sharedAdmittedSinceLastW || pendingShared == 0 )
+                consecutiveQueueJumps = 0;
+            sharedAdmittedSinceLastW = false;
+            ++consecutiveQueueJumps;
+            readerAdmissionRemaining = policyReaderAdmissionLimit;
         }
 
         bool W_legal() const { return r.n + w.n + R.n + W.n + X.n == 0; }
@@ -96,7 +150,8 @@ namespace mongo {
         bool w_legal_ignore_greed() const { return R.n + W.n + X.n == 0; }
 
         bool R_legal() const {
-            return !_areQueueJumpingGlobalWritesPending() && R_legal_ignore_greed();
+            return !_areQueueJumpingGlobalWritesPending() && _readerAdmissionOk() &&
+                   R_legal_ignore_greed();
         }
 
         bool w_legal() const {
@@ -104,7 +159,8 @@ namespace mongo {
         }
 
         bool r_legal() const {
-            return !_areQueueJumpingGlobalWritesPending() && r_legal_ignore_greed();
+            return !_areQueueJumpingGlobalWritesPending() && _readerAdmissionOk() &&
+                   r_legal_ignore_greed();
         }
 
         bool X_legal() const { return w.n + r.n + R.n + W.n == 0; }
@@ -115,9 +171,26 @@ namespace mongo {
         QLock() :
             numPendingGlobalWrites(0),
             generationX(0),
-            generationXExit(0) {
+            generationXExit(0),
+            policyMaxConsecutiveQueueJumps(8),
+            policyReaderAdmissionLimit(32),
+            consecutiveQueueJumps(0),
+            readerAdmissionRemaining(0),
+            pendingShared(0),
+            sharedAdmittedSinceLastW(false) {
         }
 
+        /** cap on back-to-back queue-jumping W grants while r/R/w requests are
+            waiting.  once the cap is hit the waiters get one grant window
+            before W regains priority.  0 restores strict W priority. */
+        void setMaxConsecutiveQueueJumpingWrites( int n );
+        int getMaxConsecutiveQueueJumpingWrites();
+
+        /** bound on r/R grants per window while a W is waiting, so a reader
+            flood cannot starve the writer.  0 means unbounded. */
+        void setReaderAdmissionLimit( int n );
+        int getReaderAdmissionLimit();
+
         void lock_r();
         void lock_w();
         void lock_R();
@@ -181,19 +254,29 @@ namespace mongo {
     //  granular locks."
     inline void QLock::lock_r() {
         boost::mutex::scoped_lock lk(m);
-        while( !r_legal() ) {
-            r.c.wait(m);
+        if( !r_legal() ) {
+            ++pendingShared;
+            do {
+                r.c.wait(m);
+            } while( !r_legal() );
+            --pendingShared;
         }
+        _noteSharedGranted( true );
         r.n++;
     }
 
     // "i will be writing. i promise to coordinate my activities with w's and r's as i go with more 
     //  granular locks."
-    inline void QLock::lock_w() { 
+    inline void QLock::lock_w() {
         boost::mutex::scoped_lock lk(m);
-        while( !w_legal() ) {
-            w.c.wait(m);
+        if( !w_legal() ) {
+            ++pendingShared;
+            do {
+                w.c.wait(m);
+            } while( !w_legal() );
+            --pendingShared;
         }
+        _noteSharedGranted( false );
         w.n++;
     }
 
@@ -201,19 +284,29 @@ namespace mongo {
     // are writing."
     inline void QLock::lock_R() {
         boost::mutex::scoped_lock lk(m);
-        while( ! R_legal() ) {
-            R.c.wait(m);
+        if( ! R_legal() ) {
+            ++pendingShared;
+            do {
+                R.c.wait(m);
+            } while( ! R_legal() );
+            --pendingShared;
         }
+        _noteSharedGranted( true );
         R.n++;
     }
 
     inline bool QLock::lock_R_try(int millis) {
         unsigned long long end = curTimeMillis64() + millis;
         boost::mutex::scoped_lock lk(m);
-        while( !R_legal() && curTimeMillis64() < end ) {
-            R.c.timed_wait(m, boost::posix_time::milliseconds(millis));
+        if ( !R_legal() ) {
+            ++pendingShared;
+            while( !R_legal() && curTimeMillis64() < end ) {
+                R.c.timed_wait(m, boost::posix_time::milliseconds(millis));
+            }
+            --pendingShared;
         }
         if ( R_legal() ) {
+            _noteSharedGranted( true );
             R.n++;
             return true;
         }
@@ -231,6 +324,7 @@ namespace mongo {
         --numPendingGlobalWrites;
 
         if (W_legal()) {
+            _noteGlobalWriteGranted();
             W.n++;
             fassert( 16202, W.n == 1 );
             return true;
@@ -280,6 +374,7 @@ namespace mongo {
         fassert(16210, W.n == 0);
         fassert(16211, U.n == 1);
 
+        _noteGlobalWriteGranted();
         R.n = 0;
         W.n = 1;
         U.n = 0;
@@ -335,6 +430,7 @@ namespace mongo {
             W.c.wait(m);
         }
         --numPendingGlobalWrites;
+        _noteGlobalWriteGranted();
         W.n++;
     }
     inline void QLock::lock_W() {
@@ -373,4 +469,31 @@ namespace mongo {
         notifyWeUnlocked('W');
     }
 
+    inline void QLock::setMaxConsecutiveQueueJumpingWrites( int n ) {
+        boost::mutex::scoped_lock lk(m);
+        policyMaxConsecutiveQueueJumps = n;
+        // the new policy may make waiters legal right now
+        R.c.notify_all();
+        w.c.notify_all();
+        r.c.notify_all();
+    }
+
+    inline int QLock::getMaxConsecutiveQueueJumpingWrites() {
+        boost::mutex::scoped_lock lk(m);
+        return policyMaxConsecutiveQueueJumps;
+    }
+
+    inline void QLock::setReaderAdmissionLimit( int n ) {
+        boost::mutex::scoped_lock lk(m);
+        policyReaderAdmissionLimit = n;
+        readerAdmissionRemaining = n;
+        R.c.notify_all();
+        r.c.notify_all();
+    }
+
+    inline int QLock::getReaderAdmissionLimit() {
+        boost::mutex::scoped_lock lk(m);
+        return policyReaderAdmissionLimit;
+    }
+
 }
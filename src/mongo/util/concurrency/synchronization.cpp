@@ -42,39 +42,61 @@ namespace mongo {
 
     /* --- NotifyAll --- */
 
-    NotifyAll::NotifyAll() : _mutex("NotifyAll") { 
+    NotifyAll::NotifyAll() : _mutex("NotifyAll") {
         _lastDone = 0;
         _lastReturned = 0;
         _nWaiting = 0;
     }
 
-    NotifyAll::When NotifyAll::now() { 
+    NotifyAll::When NotifyAll::now() {
         scoped_lock lock( _mutex );
         return ++_lastReturned;
     }
 
     void NotifyAll::waitFor(When e) {
         scoped_lock lock( _mutex );
-        ++_nWaiting;
-        while( _lastDone < e ) {
-            _condition.wait( lock.boost() );
-        }
+        _waitFor( lock, e );
     }
 
-    void NotifyAll::awaitBeyondNow() { 
+    void NotifyAll::awaitBeyondNow() {
         scoped_lock lock( _mutex );
-        ++_nWaiting;
         When e = ++_lastReturned;
-        while( _lastDone <= e ) {
-            _condition.wait( lock.boost() );
+        _waitFor( lock, e + 1 );
+    }
+
+    void NotifyAll::_waitFor(scoped_lock& lock, When e) {
+        if( _lastDone >= e )
+            return;
+
+        // hold our own reference: notifyAll() removes the group from the map
+        // before we get to run again
+        boost::shared_ptr<WaiterGroup>& entry = _groups[e];
+        if( !entry )
+            entry.reset( new WaiterGroup() );
+        boost::shared_ptr<WaiterGroup> group = entry;
+
+        group->count++;
+        ++_nWaiting;
+        while( _lastDone < e ) {
+            group->condition.wait( lock.boost() );
         }
+        group->count--;
+        --_nWaiting;
     }
 
     void NotifyAll::notifyAll(When e) {
         scoped_lock lock( _mutex );
         _lastDone = e;
-        _nWaiting = 0;
-        _condition.notify_all();
+        WaiterGroups::iterator it = _groups.begin();
+        while( it != _groups.end() && it->first <= e ) {
+            it->second->condition.notify_all();
+            _groups.erase( it++ );
+        }
+    }
+
+    bool NotifyAll::done(When e) const {
+        scoped_lock lock( _mutex );
+        return _lastDone >= e;
     }
 
 } // namespace mongo
@@ -17,7 +17,11 @@
 
 #pragma once
 
+#include <map>
+
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/condition.hpp>
+
 #include "mutex.h"
 
 namespace mongo {
@@ -51,6 +55,11 @@ namespace mongo {
 
     /** establishes a synchronization point between threads. N threads are waits and one is notifier.
         threadsafe.
+
+        waiters are grouped by the event number they wait for, each group with its own
+        condition variable, so notifyAll(e) only wakes threads whose event is covered by
+        e -- waiters on later events sleep through it instead of waking, rechecking and
+        sleeping again on every notification.
     */
     class NotifyAll : boost::noncopyable {
     public:
@@ -68,15 +77,28 @@ namespace mongo {
         /** a bit faster than waitFor( now() ) */
         void awaitBeyondNow();
 
-        /** may be called multiple times. notifies all waiters */
+        /** may be called multiple times. notifies waiters whose awaited event is <= e */
         void notifyAll(When);
 
+        /** nonblocking: true if a notifyAll() covering e has already happened */
+        bool done(When e) const;
+
         /** indicates how many threads are waiting for a notify. */
         unsigned nWaiting() const { return _nWaiting; }
 
     private:
-        mongo::mutex _mutex;
-        boost::condition _condition;
+        struct WaiterGroup {
+            WaiterGroup() : count(0) {}
+            boost::condition condition;
+            unsigned count;
+        };
+        typedef std::map<When, boost::shared_ptr<WaiterGroup> > WaiterGroups;
+
+        /** waits (with _mutex held via 'lock') until _lastDone >= e */
+        void _waitFor(scoped_lock& lock, When e);
+
+        mutable mongo::mutex _mutex;
+        WaiterGroups _groups; // one entry per distinct awaited event
         When _lastDone;
         When _lastReturned;
         unsigned _nWaiting;
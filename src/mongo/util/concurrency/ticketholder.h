@@ -17,6 +17,7 @@
 #include <boost/thread/condition_variable.hpp>
 #include <iostream>
 
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
@@ -96,6 +97,85 @@ namespace mongo {
         boost::condition_variable_any _newTicket;
     };
 
+    /**
+     * Semaphore with the same interface as TicketHolder, but the uncontended
+     * acquire and release are a single compare-and-swap; the mutex and
+     * condition variable only come into play when a thread actually has to
+     * block, or a release has a sleeping waiter to wake.  Use it where many
+     * threads stream through the gate concurrently and TicketHolder's mutex
+     * would serialize them.
+     *
+     * Unlike TicketHolder::resize, shrinking below the number of checked-out
+     * tickets is allowed: the available count goes negative and the gate
+     * stays shut until enough releases pay the debt back.
+     */
+    class FastTicketHolder {
+    public:
+        explicit FastTicketHolder( int num )
+            : _outof( num ), _num( num ), _waiters( 0 ), _mutex( "FastTicketHolder" ) {}
+
+        bool tryAcquire() {
+            while ( true ) {
+                int cur = _num.load();
+                if ( cur <= 0 )
+                    return false;
+                if ( _num.compareAndSwap( cur, cur - 1 ) == cur )
+                    return true;
+            }
+        }
+
+        void waitForTicket() {
+            if ( tryAcquire() )
+                return;
+
+            scoped_lock lk( _mutex );
+            _waiters.addAndFetch( 1 );
+            while ( !tryAcquire() ) {
+                _newTicket.wait( lk.boost() );
+            }
+            _waiters.subtractAndFetch( 1 );
+        }
+
+        void release() {
+            _num.addAndFetch( 1 );
+            // Only touch the mutex when someone may be asleep.  A waiter that
+            // hasn't published itself yet is still before the retry in its
+            // wait loop and will see the ticket we just returned.
+            if ( _waiters.load() > 0 ) {
+                scoped_lock lk( _mutex );
+                _newTicket.notify_one();
+            }
+        }
+
+        void resize( int newSize ) {
+            {
+                scoped_lock lk( _mutex ); // serializes resizes; acquirers stay lock free
+                int delta = newSize - _outof.load();
+                if ( delta == 0 )
+                    return;
+                _outof.store( newSize );
+                _num.addAndFetch( delta );
+            }
+            _newTicket.notify_all();
+        }
+
+        int available() const { return _num.load(); }
+
+        int used() const { return _outof.load() - _num.load(); }
+
+        int outof() const { return _outof.load(); }
+
+        /** number of threads blocked in waitForTicket() */
+        int waiters() const { return _waiters.load(); }
+
+    private:
+        AtomicWord<int> _outof;
+        AtomicWord<int> _num;
+        AtomicWord<int> _waiters;
+        mongo::mutex _mutex;
+        boost::condition_variable_any _newTicket;
+    };
+
     class ScopedTicket {
     public:
 
@@ -0,0 +1,209 @@
+// work_stealing_pool.cpp
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/concurrency/work_stealing_pool.h"
+
+#include <deque>
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/platform/random.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+    namespace threadpool {
+
+        // One worker's deque.  The owner drains the front, so per-queue tasks
+        // run in submission order like the old ThreadPool; thieves take from
+        // the back, leaving the owner the work it was going to run next.
+        class WorkStealingPool::TaskQueue : boost::noncopyable {
+        public:
+            TaskQueue() : _mutex("WorkStealingPool::TaskQueue") {}
+
+            void push(Task& task) {
+                SimpleMutex::scoped_lock lk(_mutex);
+                _deque.push_back(task);
+            }
+
+            bool popFront(Task* out) {
+                SimpleMutex::scoped_lock lk(_mutex);
+                if (_deque.empty())
+                    return false;
+                *out = _deque.front();
+                _deque.pop_front();
+                return true;
+            }
+
+            bool popBack(Task* out) {
+                SimpleMutex::scoped_lock lk(_mutex);
+                if (_deque.empty())
+                    return false;
+                *out = _deque.back();
+                _deque.pop_back();
+                return true;
+            }
+
+        private:
+            SimpleMutex _mutex;
+            std::deque<Task> _deque;
+        };
+
+        // Worker thread
+        class WorkStealingPool::Worker : boost::noncopyable {
+        public:
+            Worker(WorkStealingPool& owner, unsigned id)
+                : _owner(owner)
+                , _id(id)
+                , _rand(static_cast<int64_t>(curTimeMicros64()) + id)
+                , _thread(boost::bind(&Worker::loop, this))
+            {}
+
+            // acts as a "join" on this thread; loop() must have been told to
+            // exit (_inShutdown) before this runs
+            ~Worker() {
+                _thread.join();
+            }
+
+        private:
+            WorkStealingPool& _owner;
+            const unsigned _id;
+            PseudoRandom _rand;
+            boost::thread _thread;
+
+            // own queue first, then sweep the others from a random start so
+            // idle workers don't all gang up on the same victim
+            bool findTask(Task* out) {
+                if (_owner._queues[_id]->popFront(out))
+                    return true;
+
+                const unsigned n = _owner._queues.size();
+                const unsigned start = static_cast<unsigned>(_rand.nextInt32()) % n;
+                for (unsigned i = 0; i < n; i++) {
+                    const unsigned victim = (start + i) % n;
+                    if (victim == _id)
+                        continue;
+                    if (_owner._queues[victim]->popBack(out))
+                        return true;
+                }
+                return false;
+            }
+
+            void loop() {
+                while (true) {
+                    Task task;
+                    if (findTask(&task)) {
+                        {
+                            scoped_lock lock(_owner._mutex);
+                            _owner._unclaimed--;
+                        }
+
+                        try {
+                            task();
+                        }
+                        catch (DBException& e) {
+                            log() << "Unhandled DBException: " << e.toString() << endl;
+                        }
+                        catch (std::exception& e) {
+                            log() << "Unhandled std::exception in worker thread: " << e.what() << endl;
+                        }
+                        catch (...) {
+                            log() << "Unhandled non-exception in worker thread" << endl;
+                        }
+
+                        scoped_lock lock(_owner._mutex);
+                        _owner._tasksRemaining--;
+                        if (_owner._tasksRemaining == 0)
+                            _owner._poolIsIdle.notify_all();
+                        continue;
+                    }
+
+                    // every queue looked empty; sleep unless work appeared (or
+                    // was still being claimed) while we scanned
+                    scoped_lock lock(_owner._mutex);
+                    if (_owner._inShutdown)
+                        break;
+                    if (_owner._unclaimed > 0)
+                        continue; // raced with a submitter; rescan
+                    _owner._taskAvailable.wait(lock.boost());
+                }
+            }
+        };
+
+        WorkStealingPool::WorkStealingPool(int nThreads)
+            : _mutex("WorkStealingPool"), _nextQueue(0)
+            , _tasksRemaining(0), _unclaimed(0)
+            , _inShutdown(false), _nThreads(nThreads) {
+            for (int i = 0; i < nThreads; i++) {
+                _queues.push_back(new TaskQueue());
+            }
+            for (int i = 0; i < nThreads; i++) {
+                _workers.push_back(new Worker(*this, i));
+            }
+        }
+
+        WorkStealingPool::~WorkStealingPool() {
+            join();
+
+            {
+                scoped_lock lock(_mutex);
+                _inShutdown = true;
+                _taskAvailable.notify_all();
+            }
+
+            for (size_t i = 0; i < _workers.size(); i++) {
+                delete _workers[i]; // joins the thread
+            }
+            for (size_t i = 0; i < _queues.size(); i++) {
+                delete _queues[i];
+            }
+        }
+
+        void WorkStealingPool::join() {
+            scoped_lock lock(_mutex);
+            while (_tasksRemaining) {
+                _poolIsIdle.wait(lock.boost());
+            }
+        }
+
+        void WorkStealingPool::schedule(Task task) {
+            _submit(_nextQueue.fetchAndAdd(1) % _nThreads, task);
+        }
+
+        void WorkStealingPool::scheduleOn(unsigned hint, Task task) {
+            _submit(hint % _nThreads, task);
+        }
+
+        void WorkStealingPool::_submit(unsigned n, Task& task) {
+            // bump the counters before the task becomes claimable, so a worker
+            // can never finish it and drive _tasksRemaining negative.  a worker
+            // that sees _unclaimed > 0 before the push lands just rescans.
+            {
+                scoped_lock lock(_mutex);
+                _tasksRemaining++;
+                _unclaimed++;
+            }
+
+            _queues[n]->push(task);
+
+            scoped_lock lock(_mutex);
+            _taskAvailable.notify_one();
+        }
+
+    } //namespace threadpool
+} //namespace mongo
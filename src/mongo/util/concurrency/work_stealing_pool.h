@@ -0,0 +1,110 @@
+// work_stealing_pool.h
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    namespace threadpool {
+
+        typedef boost::function<void(void)> Task; //nullary function or functor
+
+        /**
+         * Drop-in alternative to ThreadPool for fan-out workloads.  ThreadPool
+         * funnels every dispatch through one mutex-protected FIFO, which
+         * serializes dispatch once there are more than a handful of workers.
+         * Here every worker owns its own deque: submitters append to a deque
+         * chosen round-robin (or by affinity hint), the owning worker drains
+         * its deque in submission order, and an idle worker steals from the
+         * back of a randomly chosen victim's deque.  The shared mutex covers
+         * only the bookkeeping counters and sleeping/waking, never the queues.
+         */
+        class WorkStealingPool : boost::noncopyable {
+        public:
+            explicit WorkStealingPool(int nThreads=8);
+
+            // blocks until all tasks are complete (tasks_remaining() == 0)
+            // You should not call schedule while in the destructor
+            ~WorkStealingPool();
+
+            // blocks until all tasks are complete (tasks_remaining() == 0)
+            // does not prevent new tasks from being scheduled so could wait forever.
+            // Also, new tasks could be scheduled after this returns.
+            void join();
+
+            // task will be copied a few times so make sure it's relatively cheap
+            void schedule(Task task);
+
+            // as schedule(), but queue the task for worker (hint % nThreads).
+            // tasks with the same hint run on the same worker as long as it
+            // keeps up, so related tasks share that worker's warm caches; an
+            // idle worker may still steal them.
+            void scheduleOn(unsigned hint, Task task);
+
+            // Helpers that wrap schedule and boost::bind.
+            // Functor and args will be copied a few times so make sure it's relatively cheap
+            template<typename F, typename A>
+            void schedule(F f, A a) { schedule(boost::bind(f,a)); }
+            template<typename F, typename A, typename B>
+            void schedule(F f, A a, B b) { schedule(boost::bind(f,a,b)); }
+            template<typename F, typename A, typename B, typename C>
+            void schedule(F f, A a, B b, C c) { schedule(boost::bind(f,a,b,c)); }
+            template<typename F, typename A, typename B, typename C, typename D>
+            void schedule(F f, A a, B b, C c, D d) { schedule(boost::bind(f,a,b,c,d)); }
+            template<typename F, typename A, typename B, typename C, typename D, typename E>
+            void schedule(F f, A a, B b, C c, D d, E e) { schedule(boost::bind(f,a,b,c,d,e)); }
+
+            int tasks_remaining() { return _tasksRemaining; }
+
+        private:
+            class TaskQueue;
+            class Worker;
+
+            // queues the task and wakes a sleeping worker if there is one
+            void _submit(unsigned n, Task& task);
+
+            mongo::mutex _mutex; // guards the counters below, never the queues
+            boost::condition _taskAvailable; // idle workers sleep here
+            boost::condition _poolIsIdle;    // join() sleeps here
+
+            std::vector<TaskQueue*> _queues; // one per worker, fixed at construction
+            std::vector<Worker*> _workers;
+
+            AtomicUInt32 _nextQueue; // round-robin cursor for unhinted schedule()
+
+            int _tasksRemaining; // in queues + currently processing
+            int _unclaimed;      // in queues, not yet picked up by any worker
+            bool _inShutdown;
+            int _nThreads;
+
+            friend class Worker;
+        };
+
+    } //namespace threadpool
+
+    using threadpool::WorkStealingPool;
+
+} //namespace mongo
@@ -59,7 +59,10 @@ namespace mongo {
         // Step 1
         disableFailPoint();
 
-        // Step 2
+        // Step 2: the drain is the grace period of the lock-free read protocol;
+        // once the reference count hits zero no reader can be looking at the
+        // settings, since new readers see ACTIVE_BIT clear and return on the
+        // fast path without touching them.
         while (_fpInfo.load() != 0) {
             sleepmillis(50);
         }
@@ -111,6 +114,10 @@ namespace mongo {
     FailPoint::RetCode FailPoint::slowShouldFailOpenBlock() {
         ValType localFpInfo = _fpInfo.addAndFetch(1);
 
+        // Re-check after publishing our reference: the caller's relaxed load may
+        // have raced with setMode() clearing ACTIVE_BIT.  With the bit still set
+        // here, setMode() cannot finish draining until we release the reference,
+        // so _mode/_timesOrPeriod/_data are stable below.
         if ((localFpInfo & ACTIVE_BIT) == 0) {
             return slowOff;
         }
@@ -62,6 +62,18 @@ namespace mongo {
      * 1. Always refer to _fpInfo first to check if failPoint is active or not before
      *    entering fail point or modifying fail point.
      * 2. Client visible fail point states are read-only when active.
+     *
+     * Performance contract: evaluating a disabled fail point is a single relaxed
+     * load of _fpInfo and a predictable branch -- no stores, no atomic
+     * read-modify-write, no shared cache line traffic.  Fail points can therefore
+     * be embedded on hot paths without throughput concerns.  The mutate side pays
+     * for this with an epoch-style protocol: setMode() clears ACTIVE_BIT, waits
+     * for the reference count of in-flight readers to drain to zero (the grace
+     * period), and only then rewrites _mode/_timesOrPeriod/_data before
+     * republishing ACTIVE_BIT.  Readers that enter the slow path take a reference
+     * with a full-barrier increment and re-check ACTIVE_BIT, so they never observe
+     * half-written settings; readers whose relaxed load races with enableFailPoint
+     * may miss one activation, which is acceptable for a diagnostic.
      */
     class FailPoint {
         MONGO_DISALLOW_COPYING(FailPoint);
@@ -97,6 +109,9 @@ namespace mongo {
          * @return slowOn if fail point is active.
          */
         inline RetCode shouldFailOpenBlock() {
+            // A relaxed load is sufficient here: when the bit is clear we touch no
+            // other state, and the slow path re-checks it after taking a reference
+            // with full barriers.  See the performance contract above.
             if (MONGO_likely((_fpInfo.loadRelaxed() & ACTIVE_BIT) == 0)) {
                 return fastOff;
             }
@@ -43,6 +43,25 @@ namespace mongo_test {
         ASSERT_FALSE(failPoint.shouldFail());
     }
 
+    TEST(FailPoint, DisabledChecksLeaveNoState) {
+        FailPoint failPoint;
+
+        // A disabled check must not take (or leak) a reference; a leaked
+        // reference would make the setMode below spin forever in its drain loop.
+        for (size_t x = 0; x < 1000; x++) {
+            ASSERT_FALSE(failPoint.shouldFail());
+
+            MONGO_FAIL_POINT_BLOCK(failPoint, scopedFp) {
+                ASSERT(false);
+            }
+        }
+
+        failPoint.setMode(FailPoint::alwaysOn);
+        ASSERT(failPoint.shouldFail());
+        failPoint.setMode(FailPoint::off);
+        ASSERT_FALSE(failPoint.shouldFail());
+    }
+
     TEST(FailPoint, AlwaysOn) {
         FailPoint failPoint;
         failPoint.setMode(FailPoint::alwaysOn);
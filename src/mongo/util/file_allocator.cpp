@@ -39,6 +39,7 @@
 
 #include "mongo/platform/posix_fadvise.h"
 #include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/io_throttle.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/paths.h"
 #include "mongo/util/processinfo.h"
@@ -219,6 +220,10 @@ namespace mongo {
                 if ( towrite > z )
                     towrite = z;
 
+                // zeroing a whole datafile can saturate the device; meter it
+                // chunk by chunk against the maintenance budget
+                IoThrottle::global.request( IoThrottle::Maintenance, towrite );
+
                 int written = write( fd , buf , towrite );
                 uassert( 10443 , errnoWithPrefix("FileAllocator: file write failed" ), written > 0 );
                 left -= written;
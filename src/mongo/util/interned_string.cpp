@@ -0,0 +1,54 @@
+// interned_string.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/util/interned_string.h"
+
+namespace mongo {
+
+    InternedString StringInternTable::intern( const StringData& s ) {
+        const size_t h = StringData::Hasher()( s );
+        AtomicWord<Entry*>& bucket = _buckets[ h & ( NumBuckets - 1 ) ];
+
+        for ( Entry* e = bucket.load(); e; e = e->next ) {
+            if ( e->hash == h && s == StringData( e->str ) )
+                return InternedString( e );
+        }
+
+        SimpleMutex::scoped_lock lk( _m );
+
+        // someone may have interned it while we were checking without the lock
+        Entry* head = bucket.load();
+        for ( Entry* e = head; e; e = e->next ) {
+            if ( e->hash == h && s == StringData( e->str ) )
+                return InternedString( e );
+        }
+
+        Entry* e = new Entry( s , h , head );
+        bucket.store( e ); // publish fully constructed
+        _size.addAndFetch( 1 );
+        return InternedString( e );
+    }
+
+    namespace {
+        StringInternTable globalInternTable;
+    }
+
+    InternedString internString( const StringData& s ) {
+        return globalInternTable.intern( s );
+    }
+
+}
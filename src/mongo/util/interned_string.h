@@ -0,0 +1,107 @@
+// interned_string.h
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Handle to a string in the process-wide intern table (see internString()).
+     *
+     * Interning the same string always yields the same handle, so equality is a
+     * single pointer compare and hashing reuses the hash computed when the string
+     * was interned -- no per-use hashing or copying.  Handles stay valid for the
+     * life of the process.
+     */
+    class InternedString {
+    public:
+        InternedString() : _entry(NULL) {}
+
+        bool isEmpty() const { return _entry == NULL; }
+
+        /** the interned characters; valid for the life of the process */
+        StringData str() const { return _entry ? StringData( _entry->str ) : StringData(); }
+
+        bool operator==( const InternedString& other ) const { return _entry == other._entry; }
+        bool operator!=( const InternedString& other ) const { return _entry != other._entry; }
+
+        struct Hasher {
+            size_t operator()( const InternedString& s ) const {
+                return s._entry ? s._entry->hash : 0;
+            }
+        };
+
+    private:
+        friend class StringInternTable;
+
+        /** immutable once published; never freed */
+        struct Entry : boost::noncopyable {
+            Entry( const StringData& s , size_t h , Entry* n )
+                : str( s.toString() ), hash( h ), next( n ) {}
+            const std::string str;
+            const size_t hash;
+            Entry* const next;
+        };
+
+        explicit InternedString( const Entry* e ) : _entry(e) {}
+
+        const Entry* _entry;
+    };
+
+    /**
+     * string -> InternedString
+     *
+     * The lookup path is lock free, following the same scheme as DatabaseHolder:
+     * entries hang off a fixed array of hash buckets whose heads are published
+     * atomically, fully constructed, so a concurrent reader sees either the old
+     * head or the new one.  Inserts (first sighting of a string -- rare)
+     * serialize on _m.
+     *
+     * Entries are never removed, so only intern bounded vocabularies such as
+     * namespaces and field names; a namespace that is dropped keeps its entry.
+     */
+    class StringInternTable {
+    public:
+        StringInternTable() : _m("StringInternTable") {}
+
+        InternedString intern( const StringData& s );
+
+        // "info" as a concurrent intern could bump this under you
+        int sizeInfo() const { return _size.load(); }
+
+    private:
+        enum { NumBuckets = 4096 }; // power of two
+
+        typedef InternedString::Entry Entry;
+
+        SimpleMutex _m;    // serializes inserts only; lookups never take it
+        AtomicWord<Entry*> _buckets[NumBuckets];
+        AtomicInt32 _size;
+    };
+
+    /** intern via the process-wide table */
+    InternedString internString( const StringData& s );
+
+}
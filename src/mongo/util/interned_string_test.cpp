@@ -0,0 +1,62 @@
+// interned_string_test.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/unittest/unittest.h"
+
+#include "mongo/util/interned_string.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+    using namespace mongo;
+
+    TEST(InternedStringTest, Basic) {
+        StringInternTable table;
+
+        InternedString a = table.intern( "foo.bar" );
+        InternedString b = table.intern( "foo.bar" );
+        InternedString c = table.intern( "foo.baz" );
+
+        ASSERT_FALSE( a.isEmpty() );
+        ASSERT_TRUE( a == b );
+        ASSERT_TRUE( a != c );
+        ASSERT_EQUALS( "foo.bar", a.str().toString() );
+        ASSERT_EQUALS( "foo.baz", c.str().toString() );
+        ASSERT_EQUALS( 2, table.sizeInfo() );
+    }
+
+    TEST(InternedStringTest, HandleIsStable) {
+        StringInternTable table;
+        const char* raw = table.intern( "stable" ).str().rawData();
+        for ( int i = 0; i < 10000; i++ ) {
+            table.intern( mongoutils::str::stream() << "filler" << i );
+        }
+        ASSERT_EQUALS( raw, table.intern( "stable" ).str().rawData() );
+    }
+
+    TEST(InternedStringTest, EmptyHandle) {
+        InternedString empty;
+        ASSERT_TRUE( empty.isEmpty() );
+        ASSERT_TRUE( empty == InternedString() );
+        ASSERT_EQUALS( 0U, InternedString::Hasher()( empty ) );
+    }
+
+    TEST(InternedStringTest, HasherMatchesIdentity) {
+        StringInternTable table;
+        InternedString::Hasher h;
+        ASSERT_EQUALS( h( table.intern( "x.y" ) ), h( table.intern( "x.y" ) ) );
+    }
+}
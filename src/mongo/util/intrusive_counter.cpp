@@ -55,6 +55,26 @@ namespace mongo {
         return ptr;
     }
 
+    intrusive_ptr<const RCString> RCString::createUninitialized(int size, char** dataOut) {
+        uassert(17567, str::stream() << "Tried to create string longer than "
+                                     << (BSONObjMaxUserSize/1024/1024) << "MB",
+                size >= 0 && size < BSONObjMaxUserSize);
+
+        const size_t bytesNeeded = sizeof(RCString) + size + 1;
+
+#pragma warning(push)
+#pragma warning(disable : 4291)
+        intrusive_ptr<RCString> ptr = new (bytesNeeded) RCString(); // uses custom operator new
+#pragma warning(pop)
+
+        ptr->_size = size;
+        char* stringStart = reinterpret_cast<char*>(ptr.get()) + sizeof(RCString);
+        stringStart[size] = '\0';
+        *dataOut = stringStart;
+
+        return ptr;
+    }
+
     void IntrusiveCounterUnsigned::addRef() const {
         ++counter;
     }
@@ -116,6 +116,13 @@ namespace mongo {
 
         static intrusive_ptr<const RCString> create(StringData s);
 
+        /** Allocates an RCString of 'size' bytes and returns a pointer to its
+         *  storage in 'dataOut' for the caller to fill in; the trailing NUL is
+         *  already in place. Lets callers gather a string from several pieces
+         *  without an intermediate buffer.
+         */
+        static intrusive_ptr<const RCString> createUninitialized(int size, char** dataOut);
+
 // MSVC: C4291: 'declaration' : no matching operator delete found; memory will not be freed if 
 // initialization throws an exception
 // We simply rely on the default global placement delete since a local placement delete would be 
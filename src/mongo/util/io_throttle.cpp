@@ -0,0 +1,134 @@
+// io_throttle.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/util/io_throttle.h"
+
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    IoThrottle::Bucket::Bucket()
+        : limitBytesPerSec( 0 ),
+          tokens( 0 ),
+          lastRefillMicros( 0 ),
+          bytes( 0 ),
+          requests( 0 ),
+          throttledMicros( 0 ) {
+    }
+
+    IoThrottle::IoThrottle() : _mutex( "IoThrottle" ) {
+    }
+
+    const char* IoThrottle::className( IoClass ioClass ) {
+        switch ( ioClass ) {
+        case Journal:     return "journal";
+        case Flush:       return "flush";
+        default:          return "maintenance";
+        }
+    }
+
+    void IoThrottle::request( IoClass ioClass, long long bytes ) {
+        long long sleptMicros = 0;
+
+        for ( ;; ) {
+            long long waitMillis = 0;
+            {
+                SimpleMutex::scoped_lock lk( _mutex );
+                Bucket& b = _buckets[ioClass];
+                const long long limit = b.limitBytesPerSec;
+
+                if ( limit > 0 ) {
+                    const unsigned long long now = curTimeMicros64();
+                    if ( now > b.lastRefillMicros ) {
+                        b.tokens += static_cast<double>( limit ) *
+                            ( now - b.lastRefillMicros ) / 1000000.0;
+                        // cap the burst at one second's budget
+                        if ( b.tokens > limit )
+                            b.tokens = limit;
+                        b.lastRefillMicros = now;
+                    }
+
+                    if ( b.tokens < 0 ) {
+                        waitMillis = static_cast<long long>( -b.tokens * 1000 / limit ) + 1;
+                        // re-check at least once a second: the limit can be
+                        // raised (or cleared) at runtime while we wait
+                        if ( waitMillis > 1000 )
+                            waitMillis = 1000;
+                    }
+                }
+
+                if ( waitMillis == 0 ) {
+                    if ( limit > 0 )
+                        b.tokens -= bytes;
+                    b.bytes += bytes;
+                    b.requests++;
+                    b.throttledMicros += sleptMicros;
+                    return;
+                }
+            }
+
+            sleepmillis( waitMillis );
+            sleptMicros += waitMillis * 1000;
+        }
+    }
+
+    void IoThrottle::setBytesPerSec( IoClass ioClass, long long bytesPerSec ) {
+        SimpleMutex::scoped_lock lk( _mutex );
+        Bucket& b = _buckets[ioClass];
+        b.limitBytesPerSec = bytesPerSec;
+        // start the new rate from a full second's budget; a stale deficit or
+        // surplus from the old rate shouldn't carry over
+        b.tokens = bytesPerSec;
+        b.lastRefillMicros = curTimeMicros64();
+    }
+
+    long long IoThrottle::bytesPerSec( IoClass ioClass ) const {
+        SimpleMutex::scoped_lock lk( _mutex );
+        return _buckets[ioClass].limitBytesPerSec;
+    }
+
+    void IoThrottle::appendStats( BSONObjBuilder& b ) const {
+        SimpleMutex::scoped_lock lk( _mutex );
+        for ( int i = 0; i < NumClasses; i++ ) {
+            const Bucket& bucket = _buckets[i];
+            BSONObjBuilder cb( b.subobjStart( className( static_cast<IoClass>( i ) ) ) );
+            cb.appendNumber( "bytesPerSec", bucket.limitBytesPerSec );
+            cb.appendNumber( "bytes", bucket.bytes );
+            cb.appendNumber( "requests", bucket.requests );
+            cb.appendNumber( "throttledMicros", bucket.throttledMicros );
+            cb.done();
+        }
+    }
+
+    IoThrottle IoThrottle::global;
+
+}  // namespace mongo
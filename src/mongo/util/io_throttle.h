@@ -0,0 +1,103 @@
+// io_throttle.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Token buckets rationing the background I/O classes that share devices
+     * with foreground operations.  Each class has an independent bytes/sec
+     * budget (default unlimited); a writer calls request() before issuing a
+     * write and sleeps until the class's bucket covers it.  Foreground
+     * operations never consult the throttle - prioritization comes from
+     * capping the background classes, not from queueing client writes.
+     *
+     * Buckets accumulate at most one second of budget, so an idle class can
+     * burst briefly but cannot save up.  Rates are adjustable at runtime via
+     * the ioThrottle*BytesPerSec server parameters; per-class totals are
+     * reported in the ioThrottle serverStatus section.
+     */
+    class IoThrottle {
+    public:
+        enum IoClass {
+            Journal = 0,     // journal file appends
+            Flush,           // journaled writes applied back to the data files
+            Maintenance,     // file preallocation, range/TTL deletes
+
+            NumClasses
+        };
+
+        IoThrottle();
+
+        /**
+         * Blocks until 'bytes' of budget are available for 'ioClass', then
+         * consumes them.  Returns immediately when the class has no limit.
+         * A write larger than a second's budget is admitted whole as soon
+         * as the bucket is non-negative; it pushes the bucket negative and
+         * throttles what follows rather than stalling forever.
+         */
+        void request( IoClass ioClass, long long bytes );
+
+        /** bytes per second; 0 disables throttling for the class */
+        void setBytesPerSec( IoClass ioClass, long long bytesPerSec );
+        long long bytesPerSec( IoClass ioClass ) const;
+
+        /** appends a subobject per class: limit, bytes, requests, time spent blocked */
+        void appendStats( BSONObjBuilder& b ) const;
+
+        static const char* className( IoClass ioClass );
+
+        static IoThrottle global;
+
+    private:
+        struct Bucket {
+            Bucket();
+
+            long long limitBytesPerSec;       // 0 = unlimited
+            double tokens;                    // bytes; negative after a large write
+            unsigned long long lastRefillMicros;
+
+            // totals since startup
+            long long bytes;
+            long long requests;
+            long long throttledMicros;
+        };
+
+        // one mutex for all classes: requesters are few and already on slow
+        // paths (each request is followed by real disk I/O)
+        mutable SimpleMutex _mutex;
+        Bucket _buckets[NumClasses];
+    };
+
+}  // namespace mongo
@@ -19,15 +19,21 @@
 
 #include "mongo/util/mmap.h"
 
+#include <algorithm>
+#include <utility>
+
 #include <boost/filesystem/operations.hpp>
 
 #include "mongo/base/owned_pointer_vector.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/concurrency/rwlock.h"
 #include "mongo/util/map_util.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/startup_test.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -41,6 +47,23 @@ namespace mongo {
 namespace {
     set<MongoFile*> mmfiles;
     map<string,MongoFile*> pathToFile;
+
+    // Completion time of each file's last flush, used by flushAllPaced to sync
+    // the files that have gone longest without a flush first.  Guarded by its
+    // own mutex rather than mmmutex so the maps above are unaffected.
+    SimpleMutex flushAgesMutex("flushAges");
+    map<string,unsigned long long> flushAges;
+
+    unsigned long long lastFlushCompleted( const string& path ) {
+        SimpleMutex::scoped_lock lk( flushAgesMutex );
+        map<string,unsigned long long>::const_iterator it = flushAges.find( path );
+        return it == flushAges.end() ? 0 : it->second;
+    }
+
+    void noteFlushCompleted( const string& path ) {
+        SimpleMutex::scoped_lock lk( flushAgesMutex );
+        flushAges[path] = curTimeMillis64();
+    }
 }  // namespace
 
     /* Create. Must not exist.
@@ -104,6 +127,8 @@ namespace {
         LockMongoFilesShared::assertExclusivelyLocked();
         mmfiles.erase(this);
         pathToFile.erase( filename() );
+        SimpleMutex::scoped_lock lk( flushAgesMutex );
+        flushAges.erase( filename() );
     }
 
     /*static*/
@@ -189,6 +214,52 @@ namespace {
         return thingsToFlush.size();
     }
 
+    /*static*/ int MongoFile::flushAllPaced( long long budgetMillis, int* flushTimeMillisOut ) {
+        notifyPreFlush();
+
+        // snapshot the files as _flushAll(true) does, least recently flushed first
+        OwnedPointerVector<Flushable> thingsToFlushWrapper;
+        vector<Flushable*>& thingsToFlush = thingsToFlushWrapper.mutableVector();
+        vector<string> paths;
+        {
+            vector< std::pair<unsigned long long, MongoFile*> > byAge;
+            LockMongoFilesShared lk;
+            for ( set<MongoFile*>::iterator i = mmfiles.begin(); i != mmfiles.end(); i++ ) {
+                MongoFile* mmf = *i;
+                if ( !mmf )
+                    continue;
+                byAge.push_back( std::make_pair( lastFlushCompleted( mmf->filename() ), mmf ) );
+            }
+            std::sort( byAge.begin(), byAge.end() );
+            for ( size_t i = 0; i < byAge.size(); i++ ) {
+                paths.push_back( byAge[i].second->filename() );
+                thingsToFlush.push_back( byAge[i].second->prepareFlush() );
+            }
+        }
+
+        const long long pauseMillis =
+            thingsToFlush.empty() ? 0 : budgetMillis / (long long)thingsToFlush.size();
+
+        long long flushTime = 0;
+        for ( size_t i = 0; i < thingsToFlush.size(); i++ ) {
+            Timer t;
+            thingsToFlush[i]->flush();
+            const long long took = t.millis();
+            flushTime += took;
+            noteFlushCompleted( paths[i] );
+            // keep a gap between msyncs so they don't pile up behind one another
+            // (and behind journal writes) as a single storm
+            if ( i + 1 < thingsToFlush.size() && took < pauseMillis )
+                sleepmillis( pauseMillis - took );
+        }
+
+        if ( flushTimeMillisOut )
+            *flushTimeMillisOut = static_cast<int>( flushTime );
+
+        notifyPostFlush();
+        return thingsToFlush.size();
+    }
+
     void MongoFile::created() {
         LockMongoFilesExclusive lk;
         mmfiles.insert(this);
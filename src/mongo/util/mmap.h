@@ -107,6 +107,21 @@ namespace mongo {
         static void (*notifyPostFlush)();
 
         static int flushAll( bool sync ); // returns n flushed
+
+        /**
+         * Flushes every mapped file as flushAll(true) does, but spreads the msyncs
+         * over roughly budgetMillis, syncing the files that have gone longest
+         * without a flush first, so background flushing stops arriving as one
+         * I/O storm.  One complete pass is still one checkpoint: the pre/post
+         * flush notifications, which advance the journal's recovery point,
+         * bracket the whole pass.  A budget of zero degenerates to flushAll(true).
+         *
+         * If flushTimeMillisOut is non-NULL it is set to the time spent actually
+         * flushing, excluding the pacing sleeps.  Returns the number of files
+         * flushed.
+         */
+        static int flushAllPaced( long long budgetMillis, int* flushTimeMillisOut = 0 );
+
         static long long totalMappedLength();
         static void closeAllFiles( std::stringstream &message );
 
@@ -238,6 +253,15 @@ namespace mongo {
 
         /** close the current private view and open a new replacement */
         void* remapPrivateView(void *oldPrivateAddr);
+
+#if !defined(_WIN32)
+        /** remap just [offset, offset+length) of the private view, leaving the rest of the
+            mapping (and its page table entries) untouched.  offset must be page aligned.
+            used by the durability code to drop only the copy-on-write pages that were
+            actually written since the last remap.
+        */
+        void remapPrivateViewRange(void *oldPrivateAddr, size_t offset, size_t length);
+#endif
     };
 
     /** p is called from within a mutex that MongoFile uses.  so be careful not to deadlock. */
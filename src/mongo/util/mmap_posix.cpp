@@ -237,6 +237,26 @@ namespace mongo {
         return x;
     }
 
+    void MemoryMappedFile::remapPrivateViewRange(void *oldPrivateAddr, size_t offset, size_t length) {
+#if defined(__sunos__) // SERVER-8795
+        verify( Lock::isW() );
+        LockMongoFilesExclusive lockMongoFiles;
+#endif
+
+        // as above, don't unmap -- just mmap over the subrange of the old region
+        char *oldRangeAddr = static_cast<char*>(oldPrivateAddr) + offset;
+        void * x = mmap( oldRangeAddr, length, PROT_READ|PROT_WRITE,
+                         MAP_PRIVATE|MAP_NORESERVE|MAP_FIXED, fd, (off_t) offset );
+        if( x == MAP_FAILED ) {
+            int err = errno;
+            error()  << "17435 Couldn't remap private view range: " << errnoWithDescription(err) << endl;
+            log() << "aborting" << endl;
+            printMemInfo();
+            abort();
+        }
+        verify( x == oldRangeAddr );
+    }
+
     void MemoryMappedFile::flush(bool sync) {
         if ( views.empty() || fd == 0 )
             return;
@@ -23,12 +23,26 @@
 #include <errno.h>
 #include <time.h>
 
+#include "mongo/bson/bsonobj.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message_port.h"
 
 namespace mongo {
 
+    SharedBuffer Message::releaseShared() {
+        // Pooled buffers must go back through BufferPool::release and
+        // multi-segment messages aren't one allocation, so neither can be
+        // handed to free()-based shared ownership.
+        if ( !_buf || !_freeIt || _bufAllocSize || !_data.empty() ) {
+            return SharedBuffer();
+        }
+        SharedBuffer shared = SharedBuffer::takeOwnership( (char*)_buf );
+        _buf = 0;
+        _freeIt = false;
+        return shared;
+    }
+
     void Message::send( MessagingPort &p, const char *context ) {
         if ( empty() ) {
             return;
@@ -37,7 +51,13 @@ namespace mongo {
             p.send( (char*)_buf, _buf->len, context );
         }
         else {
-            p.send( _data, context );
+            // Hand the segments to the scatter/gather send; no concatenation.
+            std::vector< std::pair< char*, int > > segments;
+            segments.reserve( _data.size() );
+            for (MsgVec::const_iterator it = _data.begin(); it != _data.end(); ++it) {
+                segments.push_back( std::make_pair( it->data, it->len ) );
+            }
+            p.send( segments, context );
         }
     }
 
@@ -19,7 +19,10 @@
 
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #include "mongo/bson/util/atomic_int.h"
+#include "mongo/util/buffer_pool.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/net/sock.h"
@@ -34,6 +37,7 @@ namespace mongo {
     class Message;
     class MessagingPort;
     class PiggyBackData;
+    class SharedBuffer;
 
     typedef AtomicUInt MSGID;
 
@@ -46,7 +50,10 @@ namespace mongo {
         dbQuery = 2004,
         dbGetMore = 2005,
         dbDelete = 2006,
-        dbKillCursors = 2007
+        dbKillCursors = 2007,
+        /* snappy-framed envelope wrapping one of the messages above; produced and
+           consumed entirely inside MessagingPort, invisible to the Message layer */
+        dbCompressed = 2012
     };
 
     bool doesOpGetAResponse( int op );
@@ -62,6 +69,7 @@ namespace mongo {
         case dbGetMore: return "getmore";
         case dbDelete: return "remove";
         case dbKillCursors: return "killcursors";
+        case dbCompressed: return "compressed";
         default:
             massert( 16141, str::stream() << "cannot translate opcode " << op, !op );
             return "";
@@ -153,12 +161,12 @@ namespace mongo {
     class Message {
     public:
         // we assume here that a vector with initial size 0 does no allocation (0 is the default, but wanted to make it explicit).
-        Message() : _buf( 0 ), _data( 0 ), _freeIt( false ) {}
+        Message() : _buf( 0 ), _data( 0 ), _freeIt( false ), _bufAllocSize( 0 ) {}
         Message( void * data , bool freeIt ) :
-            _buf( 0 ), _data( 0 ), _freeIt( false ) {
+            _buf( 0 ), _data( 0 ), _freeIt( false ), _bufAllocSize( 0 ) {
             _setData( reinterpret_cast< MsgData* >( data ), freeIt );
         };
-        Message(Message& r) : _buf( 0 ), _data( 0 ), _freeIt( false ) {
+        Message(Message& r) : _buf( 0 ), _data( 0 ), _freeIt( false ), _bufAllocSize( 0 ) {
             *this = r;
         }
         ~Message() {
@@ -169,7 +177,7 @@ namespace mongo {
 
         MsgData *header() const {
             verify( !empty() );
-            return _buf ? _buf : reinterpret_cast< MsgData* > ( _data[ 0 ].first );
+            return _buf ? _buf : reinterpret_cast< MsgData* > ( _data[ 0 ].data );
         }
         int operation() const { return header()->operation(); }
 
@@ -187,7 +195,7 @@ namespace mongo {
             }
             else {
                 for (MsgVec::const_iterator it = _data.begin(); it != _data.end(); ++it) {
-                    res += it->second;
+                    res += it->len;
                 }
             }
             return res;
@@ -204,16 +212,14 @@ namespace mongo {
 
             verify( _freeIt );
             int totalSize = 0;
-            for (std::vector< std::pair< char *, int > >::const_iterator i = _data.begin();
-                 i != _data.end(); ++i) {
-                totalSize += i->second;
+            for (MsgVec::const_iterator i = _data.begin(); i != _data.end(); ++i) {
+                totalSize += i->len;
             }
             char *buf = (char*)malloc( totalSize );
             char *p = buf;
-            for (std::vector< std::pair< char *, int > >::const_iterator i = _data.begin();
-                 i != _data.end(); ++i) {
-                memcpy( p, i->first, i->second );
-                p += i->second;
+            for (MsgVec::const_iterator i = _data.begin(); i != _data.end(); ++i) {
+                memcpy( p, i->data, i->len );
+                p += i->len;
             }
             reset();
             _setData( (MsgData*)buf, true );
@@ -228,6 +234,8 @@ namespace mongo {
             if ( r._data.size() > 0 ) {
                 _data.swap( r._data );
             }
+            _bufAllocSize = r._bufAllocSize;
+            r._bufAllocSize = 0;
             r._freeIt = false;
             _freeIt = true;
             return *this;
@@ -236,16 +244,20 @@ namespace mongo {
         void reset() {
             if ( _freeIt ) {
                 if ( _buf ) {
-                    free( _buf );
+                    if ( _bufAllocSize )
+                        BufferPool::release( (char*)_buf, _bufAllocSize );
+                    else
+                        free( _buf );
                 }
-                for (std::vector< std::pair< char *, int > >::const_iterator i = _data.begin();
-                     i != _data.end(); ++i) {
-                    free(i->first);
+                for (MsgVec::const_iterator i = _data.begin(); i != _data.end(); ++i) {
+                    if ( !i->owner )
+                        free(i->data);
                 }
             }
             _buf = 0;
-            _data.clear();
+            _data.clear(); // drops any shared segment references
             _freeIt = false;
+            _bufAllocSize = 0;
         }
 
         // use to add a buffer
@@ -261,12 +273,22 @@ namespace mongo {
                 return;
             }
             verify( _freeIt );
-            if ( _buf ) {
-                _data.push_back(std::make_pair((char*)_buf, _buf->len));
-                _buf = 0;
+            _appendSegment( MsgSegment( d, size ) );
+        }
+
+        /** Append a buffer segment this message references but does not own.
+            'owner' keeps the bytes alive by refcount for as long as the
+            message holds them; 'd' may point anywhere inside the owned
+            allocation.  Used to attach an already-built blob (e.g. a batch of
+            result documents) behind a reply header with no copying.  The
+            message must already hold its leading MsgData buffer. */
+        void appendSharedData( const boost::shared_ptr<char>& owner, char *d, int size ) {
+            if ( size <= 0 ) {
+                return;
             }
-            _data.push_back(std::make_pair(d, size));
-            header()->len += size;
+            verify( !empty() );
+            verify( _freeIt );
+            _appendSegment( MsgSegment( d, size, owner ) );
         }
 
         // use to set first buffer if empty
@@ -274,6 +296,18 @@ namespace mongo {
             verify( empty() );
             _setData( d, freeIt );
         }
+
+        /** Take ownership of a buffer drawn from BufferPool -- typically a
+            finished PooledBufBuilder's, decouple()d by the caller -- as this
+            message's data, without copying.  The buffer goes back to the
+            thread's pool when the message is reset.
+            @param allocSize the buffer's full allocation size (the builder's
+            getSize()), not the bytes used. */
+        void setPooledData(MsgData *d, int allocSize) {
+            verify( empty() );
+            _setData( d, true );
+            _bufAllocSize = allocSize;
+        }
         void setData(int operation, const char *msgtxt) {
             setData(operation, msgtxt, strlen(msgtxt)+1);
         }
@@ -291,21 +325,57 @@ namespace mongo {
             return _freeIt;
         }
 
+        /** Release this message's buffer into a refcounted SharedBuffer so
+            BSONObjs can alias the documents in it without copying them out
+            (see BSONObj(SharedBuffer, const char*)).  On success the message
+            is left empty and the buffer is freed when the last reference
+            goes.  Only a single malloc'd owned buffer can be released;
+            pooled (BufferPool) and multi-segment messages are left untouched
+            and an invalid SharedBuffer is returned -- callers must be
+            prepared to fall back to copying. */
+        SharedBuffer releaseShared();
+
         void send( MessagingPort &p, const char *context );
         
         string toString() const;
 
     private:
+        /** One buffer of a multi-buffer message.  When 'owner' is set the
+            segment is shared: the refcount keeps the bytes alive and reset()
+            merely drops the reference; otherwise the bytes are malloc'd and
+            owned by the message. */
+        struct MsgSegment {
+            MsgSegment() : data(0), len(0) {}
+            MsgSegment( char *d, int l ) : data(d), len(l) {}
+            MsgSegment( char *d, int l, const boost::shared_ptr<char>& o )
+                : data(d), len(l), owner(o) {}
+            char *data;
+            int len;
+            boost::shared_ptr<char> owner;
+        };
+        typedef std::vector< MsgSegment > MsgVec;
+
         void _setData( MsgData *d, bool freeIt ) {
             _freeIt = freeIt;
             _buf = d;
         }
+        void _appendSegment( const MsgSegment& segment ) {
+            if ( _buf ) {
+                _data.push_back( MsgSegment( (char*)_buf, _buf->len ) );
+                _buf = 0;
+                _bufAllocSize = 0; // multi-buffer messages free() each owned piece
+            }
+            _data.push_back( segment );
+            header()->len += segment.len;
+        }
         // if just one buffer, keep it in _buf, otherwise keep a sequence of buffers in _data
         MsgData * _buf;
         // byte buffer(s) - the first must contain at least a full MsgData unless using _buf for storage instead
-        typedef std::vector< std::pair< char*, int > > MsgVec;
         MsgVec _data;
         bool _freeIt;
+        // when nonzero, _buf came from BufferPool with this allocation size
+        // and reset() recycles it there instead of calling free()
+        int _bufAllocSize;
     };
 
 
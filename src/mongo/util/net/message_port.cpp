@@ -23,6 +23,7 @@
 #include <time.h>
 
 #include "mongo/util/background.h"
+#include "mongo/util/compress.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
@@ -52,47 +53,6 @@ namespace mongo {
 
     /* messagingport -------------------------------------------------------------- */
 
-    class PiggyBackData {
-    public:
-        PiggyBackData( MessagingPort * port ) {
-            _port = port;
-            _buf = new char[1300];
-            _cur = _buf;
-        }
-
-        ~PiggyBackData() {
-            DESTRUCTOR_GUARD (
-                flush();
-                delete[]( _cur );
-            );
-        }
-
-        void append( Message& m ) {
-            verify( m.header()->len <= 1300 );
-
-            if ( len() + m.header()->len > 1300 )
-                flush();
-
-            memcpy( _cur , m.singleData() , m.header()->len );
-            _cur += m.header()->len;
-        }
-
-        void flush() {
-            if ( _buf == _cur )
-                return;
-
-            _port->send( _buf , len(), "flush" );
-            _cur = _buf;
-        }
-
-        int len() const { return _cur - _buf; }
-
-    private:
-        MessagingPort* _port;
-        char * _buf;
-        char * _cur;
-    };
-
     class Ports {
         set<MessagingPort*> ports;
         mongo::mutex m;
@@ -124,19 +84,21 @@ namespace mongo {
         ports.closeAll(mask);
     }
 
-    MessagingPort::MessagingPort(int fd, const SockAddr& remote) 
-        : psock( new Socket( fd , remote ) ) , piggyBackData(0) {
+    MessagingPort::MessagingPort(int fd, const SockAddr& remote)
+        : psock( new Socket( fd , remote ) ),
+          _pooledRecv(false), _activeRecvBuf(0), _activeRecvBufSize(0), _compressOutgoing(false) {
         ports.insert(this);
     }
 
-    MessagingPort::MessagingPort( double timeout, logger::LogSeverity ll ) 
-        : psock( new Socket( timeout, ll ) ) {
+    MessagingPort::MessagingPort( double timeout, logger::LogSeverity ll )
+        : psock( new Socket( timeout, ll ) ),
+          _pooledRecv(false), _activeRecvBuf(0), _activeRecvBufSize(0), _compressOutgoing(false) {
         ports.insert(this);
-        piggyBackData = 0;
     }
 
     MessagingPort::MessagingPort( boost::shared_ptr<Socket> sock )
-        : psock( sock ), piggyBackData( 0 ) {
+        : psock( sock ),
+          _pooledRecv(false), _activeRecvBuf(0), _activeRecvBufSize(0), _compressOutgoing(false) {
         ports.insert(this);
     }
 
@@ -149,15 +111,118 @@ namespace mongo {
     }
 
     MessagingPort::~MessagingPort() {
-        if ( piggyBackData )
-            delete( piggyBackData );
+        DESTRUCTOR_GUARD( _flushPending(); );
+        if ( _activeRecvBuf )
+            free( _activeRecvBuf );
+        for ( size_t i = 0; i < _recvBufPool.size(); i++ ) {
+            free( _recvBufPool[i].second );
+        }
         shutdown();
         ports.erase(this);
     }
     
+    const size_t MessagingPort::kMaxPooledRecvBufs;
+    const int MessagingPort::kInitialRecvBufSize;
+    const int MessagingPort::kMinBytesToCompress;
+
+    MsgData* MessagingPort::_allocRecvBuf( int size ) {
+        verify( !_activeRecvBuf );
+        int z = (size+1023)&0xfffffc00;
+        verify( z >= size );
+        char* buf = 0;
+        for ( std::vector< std::pair<int, char*> >::iterator it = _recvBufPool.begin();
+              it != _recvBufPool.end(); ++it ) {
+            if ( it->first >= z ) {
+                z = it->first;
+                buf = it->second;
+                _recvBufPool.erase( it );
+                break;
+            }
+        }
+        if ( !buf ) {
+            buf = (char *) malloc( z );
+            verify( buf );
+        }
+        _activeRecvBuf = (MsgData *) buf;
+        _activeRecvBufSize = z;
+        return _activeRecvBuf;
+    }
+
+    void MessagingPort::_recycleRecvBuf( MsgData* buf, int size ) {
+        if ( _recvBufPool.size() < kMaxPooledRecvBufs ) {
+            _recvBufPool.push_back( std::make_pair( size, (char *) buf ) );
+        }
+        else {
+            free( buf );
+        }
+    }
+
+    bool MessagingPort::_recvPooled(Message& m) {
+        const int headerLen = sizeof(MSGHEADER);
+        int initialSize = kInitialRecvBufSize;
+        if ( static_cast<int>( _recvOverflow.size() ) > initialSize )
+            initialSize = _recvOverflow.size();
+        MsgData* md = _allocRecvBuf( initialSize );
+        int have = 0;
+
+        // Start with any bytes the previous read pulled in past the end of its message.
+        if ( !_recvOverflow.empty() ) {
+            have = _recvOverflow.size();
+            memcpy( (char *) md, &_recvOverflow[0], have );
+            _recvOverflow.clear();
+        }
+
+        // One scatter-style read picks up the 16 byte header and however much of the body
+        // has already arrived, so a fully-arrived request costs a single recv syscall.
+        while ( have < headerLen ) {
+            have += psock->unsafe_recv( (char *) md + have, _activeRecvBufSize - have );
+        }
+
+        const int len = md->len;
+        if ( len < headerLen || len > MaxMessageSizeBytes ) {
+            LOG(0) << "recv(): message len " << len << " is invalid. "
+                   << "Min " << headerLen << " Max: " << MaxMessageSizeBytes << endl;
+            return false;
+        }
+
+        if ( len > _activeRecvBufSize ) {
+            // The message doesn't fit this size class; move what we have to one that fits.
+            MsgData* old = md;
+            const int oldSize = _activeRecvBufSize;
+            _activeRecvBuf = 0;
+            md = _allocRecvBuf( len );
+            memcpy( (char *) md, (char *) old, have );
+            _recycleRecvBuf( old, oldSize );
+        }
+
+        if ( have > len ) {
+            // We read past the end of this message; the excess is the start of the next.
+            _recvOverflow.assign( (char *) md + len, (char *) md + have );
+        }
+        else if ( have < len ) {
+            psock->recv( (char *) md + have, len - have );
+        }
+
+        // The port keeps ownership; the buffer is reclaimed on the next recv() call.
+        m.setData( md, false );
+        return true;
+    }
+
     bool MessagingPort::recv(Message& m) {
         try {
+            // Reclaim the buffer handed out by the previous recv().  Per the contract in
+            // message_port.h the caller is done with its Message once it calls recv() again.
+            if ( _activeRecvBuf ) {
+                _recycleRecvBuf( _activeRecvBuf, _activeRecvBufSize );
+                _activeRecvBuf = 0;
+            }
 again:
+            // Once the connection handshake is done the wire carries nothing but regular
+            // messages, so a pooled port can take the combined header+body fast path.
+            if ( _pooledRecv && !psock->isAwaitingHandshake() ) {
+                return _recvPooled(m) && _maybeInflate(m);
+            }
+
             //mmm( log() << "*  recv() sock:" << this->sock << endl; )
             MSGHEADER header;
             int headerLen = sizeof(MSGHEADER);
@@ -222,7 +287,7 @@ again:
 
             guard.Dismiss();
             m.setData(md, true);
-            return true;
+            return _maybeInflate(m);
 
         }
         catch ( const SocketException & e ) {
@@ -279,38 +344,132 @@ again:
         toSend.header()->id = nextMessageId();
         toSend.header()->responseTo = responseTo;
 
-        if ( piggyBackData && piggyBackData->len() ) {
-            mmm( log() << "*     have piggy back" << endl; )
-            if ( ( piggyBackData->len() + toSend.header()->len ) > 1300 ) {
-                // won't fit in a packet - so just send it off
-                piggyBackData->flush();
-            }
-            else {
-                piggyBackData->append( toSend );
-                piggyBackData->flush();
-                return;
-            }
+        // anything deferred by piggyBack() goes out in the same corked
+        // stretch as this message; the uncork at scope exit is the one flush
+        ScopedSocketCork cork( *psock );
+        _flushPending();
+
+        if ( _compressOutgoing && toSend.size() >= kMinBytesToCompress ) {
+            _sayCompressed( toSend );
+            return;
         }
 
         toSend.send( *this, "say" );
     }
 
-    void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
+    void MessagingPort::say(const std::vector<Message*>& toSend) {
+        // Socket::cork() nests, so the inner per-message corks are no-ops and
+        // the whole batch flushes once, here at scope exit.
+        ScopedSocketCork cork( *psock );
+        for ( size_t i = 0; i < toSend.size(); i++ ) {
+            say( *toSend[i] );
+        }
+    }
 
-        if ( toSend.header()->len > 1300 ) {
-            // not worth saving because its almost an entire packet
-            say( toSend );
+    /**
+     * Wire format of a compressed envelope: a regular 16 byte header with
+     * operation dbCompressed and the id/responseTo of the wrapped message,
+     * followed by two int32s -- the wrapped operation and the wrapped body
+     * length -- and then the snappy-compressed body bytes.
+     */
+    void MessagingPort::_sayCompressed( Message& toSend ) {
+        // Snappy needs a contiguous run; reply batches can be multi-buffer.
+        // The concat() copy is a wash next to the compression pass itself.
+        toSend.concat();
+        const MsgData* src = toSend.singleData();
+        const int bodyLen = src->len - MsgDataHeaderSize;
+        const int metaLen = 2 * sizeof(int32_t);
+
+        string compressed;
+        compress( reinterpret_cast<const char*>( src ) + MsgDataHeaderSize, bodyLen, &compressed );
+
+        if ( static_cast<int>( compressed.size() ) + metaLen >= bodyLen ) {
+            // Incompressible payload (already-compressed blobs, mostly) -- the
+            // envelope would only add bytes, so send the original.
+            toSend.send( *this, "say" );
             return;
         }
 
+        const int envLen = MsgDataHeaderSize + metaLen + compressed.size();
+        MsgData* env = (MsgData *) malloc( envLen );
+        verify( env );
+        env->len = envLen;
+        env->id = src->id;
+        env->responseTo = src->responseTo;
+        env->setOperation( dbCompressed );
+        int32_t* meta = reinterpret_cast<int32_t*>( env->_data );
+        meta[0] = src->operation();
+        meta[1] = bodyLen;
+        memcpy( reinterpret_cast<char*>( env ) + MsgDataHeaderSize + metaLen,
+                compressed.data(), compressed.size() );
+
+        Message wrapped( env, true );
+        wrapped.send( *this, "say-compressed" );
+    }
+
+    bool MessagingPort::_maybeInflate( Message& m ) {
+        if ( m.operation() != dbCompressed )
+            return true;
+
+        const MsgData* env = m.singleData();
+        const int metaLen = 2 * sizeof(int32_t);
+        if ( env->len < MsgDataHeaderSize + metaLen ) {
+            LOG(0) << "recv(): compressed message too short for its envelope" << endl;
+            return false;
+        }
+        const int32_t* meta = reinterpret_cast<const int32_t*>( env->_data );
+        const int originalOp = meta[0];
+        const int bodyLen = meta[1];
+        if ( bodyLen < 0 || bodyLen + MsgDataHeaderSize > MaxMessageSizeBytes ) {
+            LOG(0) << "recv(): compressed message claims invalid inflated len "
+                   << bodyLen << endl;
+            return false;
+        }
+
+        string inflated;
+        if ( !uncompress( reinterpret_cast<const char*>( env ) + MsgDataHeaderSize + metaLen,
+                          env->len - MsgDataHeaderSize - metaLen,
+                          &inflated ) ||
+             inflated.size() != static_cast<size_t>( bodyLen ) ) {
+            LOG(0) << "recv(): corrupt compressed message from " << remote().toString() << endl;
+            return false;
+        }
+
+        MsgData* md = (MsgData *) malloc( MsgDataHeaderSize + bodyLen );
+        verify( md );
+        md->len = MsgDataHeaderSize + bodyLen;
+        md->id = env->id;
+        md->responseTo = env->responseTo;
+        md->setOperation( originalOp );
+        memcpy( md->_data, inflated.data(), bodyLen );
+
+        // A pooled envelope buffer stays owned by the port and is reclaimed on
+        // the next recv(); a malloc'd one is freed here by reset().
+        m.reset();
+        m.setData( md, true );
+        return true;
+    }
+
+    void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
         // we're going to be storing this, so need to set it up
         toSend.header()->id = nextMessageId();
         toSend.header()->responseTo = responseTo;
 
-        if ( ! piggyBackData )
-            piggyBackData = new PiggyBackData( this );
+        if ( static_cast<int>( _pendingSend.size() ) + toSend.header()->len >
+             kMaxPendingSendBytes ) {
+            _flushPending();
+        }
+
+        toSend.concat(); // piggybacked messages are single-buffer in practice
+        const char* data = reinterpret_cast<const char*>( toSend.singleData() );
+        _pendingSend.insert( _pendingSend.end(), data, data + toSend.header()->len );
+    }
 
-        piggyBackData->append( toSend );
+    void MessagingPort::_flushPending() {
+        if ( _pendingSend.empty() )
+            return;
+        psock->send( &_pendingSend[0], _pendingSend.size(), "flushPending" );
+        _pendingSend.clear();
     }
 
     HostAndPort MessagingPort::remote() const {
@@ -25,7 +25,6 @@
 namespace mongo {
 
     class MessagingPort;
-    class PiggyBackData;
 
     typedef AtomicUInt MSGID;
 
@@ -52,6 +51,15 @@ namespace mongo {
         long long connectionId() const { return _connectionId; }
         void setConnectionId( long long connectionId );
 
+        /**
+         * Enables snappy compression of outgoing messages, as negotiated via
+         * isMaster.  Inbound compressed messages are always understood -- only
+         * sending is gated on negotiation -- so the peers may start compressing
+         * at different points in the conversation.  Default implementation is a
+         * no-op for ports that never carry the binary wire protocol.
+         */
+        virtual void setWireCompression(bool on) { }
+
     public:
         // TODO make this private with some helpers
 
@@ -85,12 +93,35 @@ namespace mongo {
            also, the Message data will go out of scope on the subsequent recv call.
         */
         bool recv(Message& m);
+
+        /**
+         * Enables reuse of receive buffers on this port.  When enabled, recv() hands out
+         * buffers owned by this port rather than malloc'd ones and reclaims them on the
+         * subsequent recv() call, per the contract documented above, so steady-state
+         * reception does no allocations and typically one recv syscall per message.
+         *
+         * Only safe when every received Message is consumed before the next recv() and
+         * never outlives this port.  The server request loops honor that; client-side
+         * callers (e.g. DBClientCursor) may hold a response past the life of the
+         * connection, which is why pooling is opt-in.
+         */
+        void setRecvBufferPooling(bool pool) { _pooledRecv = pool; }
+
+        virtual void setWireCompression(bool on) { _compressOutgoing = on; }
         void reply(Message& received, Message& response, MSGID responseTo);
         void reply(Message& received, Message& response);
         bool call(Message& toSend, Message& response);
 
         void say(Message& toSend, int responseTo = 0);
 
+        /**
+         * Sends several messages in one corked stretch of the socket, so the
+         * batch leaves in full TCP segments with a single flush at the end
+         * instead of one small segment per message.  Assigns each message its
+         * own id.
+         */
+        void say(const std::vector<Message*>& toSend);
+
         /**
          * this is used for doing 'async' queries
          * instead of doing call( to , from )
@@ -102,6 +133,12 @@ namespace mongo {
          */
         bool recv( const Message& sent , Message& response );
 
+        /**
+         * Defers a (small) message until the next say() on this port, which
+         * sends it in the same corked stretch as the message it rides with --
+         * one flush for both.  Used for fire-and-forget traffic like
+         * killCursors that would otherwise cost its own TCP segment.
+         */
         void piggyBack( Message& toSend , int responseTo = 0 );
 
         unsigned remotePort() const { return psock->remotePort(); }
@@ -142,17 +179,57 @@ namespace mongo {
         }
 
     private:
-        
-        PiggyBackData * piggyBackData;
+
+        // Bytes deferred by piggyBack(), flushed in front of the next say().
+        // Bounded by kMaxPendingSendBytes; overflow is sent immediately.
+        std::vector<char> _pendingSend;
+
+        static const int kMaxPendingSendBytes = 16 * 1024;
+
+        void _flushPending();
 
         // this is the parsed version of remote
         // mutable because its initialized only on call to remote()
-        mutable HostAndPort _remoteParsed; 
+        mutable HostAndPort _remoteParsed;
+
+        /**
+         * Receive-buffer pool, active once setRecvBufferPooling(true) is called.  Buffers
+         * are rounded to the 1KB size classes recv() has always used, and recycled through
+         * _recvBufPool instead of freed.  All of this state is touched only by the thread
+         * servicing the connection.
+         */
+        bool _pooledRecv;
+
+        // Buffer handed out by the last recv(); reclaimed at the start of the next one.
+        MsgData* _activeRecvBuf;
+        int _activeRecvBufSize;
+
+        // Idle (capacity, buffer) pairs available for reuse.
+        std::vector< std::pair<int, char*> > _recvBufPool;
+
+        // Bytes a pooled read pulled in past the end of its message; they belong to the
+        // next message (a pipelining client can have it on the wire already).
+        std::vector<char> _recvOverflow;
+
+        static const size_t kMaxPooledRecvBufs = 4;
+        static const int kInitialRecvBufSize = 4 * 1024;
+
+        bool _recvPooled(Message& m);
+        MsgData* _allocRecvBuf(int size);
+        void _recycleRecvBuf(MsgData* buf, int size);
+
+        // Compress outgoing messages (see setWireCompression above).  Messages
+        // under kMinBytesToCompress go out as-is: snappy rarely wins there and
+        // the envelope would only add latency to pings and getmore trickles.
+        bool _compressOutgoing;
+
+        static const int kMinBytesToCompress = 1024;
+
+        void _sayCompressed(Message& toSend);
+        bool _maybeInflate(Message& m);
 
     public:
         static void closeAllSockets(unsigned tagMask = 0xffffffff);
-
-        friend class PiggyBackData;
     };
 
 
@@ -66,4 +66,9 @@ namespace mongo {
 
     // TODO use a factory here to decide between port and asio variations
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler );
+
+    // event-driven (epoll) variation; see message_server_event.cpp
+    extern bool serverEventLoop;
+    MessageServer * createEventLoopServer( const MessageServer::Options& opts ,
+                                           MessageHandler * handler );
 }
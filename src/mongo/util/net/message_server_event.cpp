@@ -0,0 +1,292 @@
+// message_server_event.cpp
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * Event-driven MessageServer front end.
+ *
+ * Instead of dedicating an OS thread to every connection for its whole
+ * lifetime (see message_server_port.cpp), idle sockets are parked in an epoll
+ * set and a small worker pool services whichever connections actually have a
+ * request pending.  A thread is only tied to a connection while a message is
+ * being received and processed, so tens of thousands of idle connections cost
+ * one epoll registration each rather than a 1MB stack and a scheduler entry.
+ *
+ * Handlers used with this server must not assume a 1:1 mapping between
+ * connections and threads: connection-scoped state has to live on the
+ * messaging port (or be keyed by connectionId), not in thread locals.  The
+ * per-connection LastError is owned here and installed into the thread-local
+ * holder around each process() call.
+ *
+ * Linux only for now; other platforms keep the thread-per-connection server.
+ * Enabled with --setParameter serverEventLoop=true.
+ */
+
+#include "mongo/pch.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/lasterror.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/work_stealing_pool.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/processinfo.h"
+
+#ifdef __linux__
+# include <sys/epoll.h>
+#endif
+
+namespace mongo {
+
+    bool serverEventLoop = false; // --setParameter serverEventLoop=true
+    ExportedServerParameter<bool> serverEventLoopParam( ServerParameterSet::getGlobal(),
+                                                        "serverEventLoop",
+                                                        &serverEventLoop,
+                                                        true,   // startup
+                                                        false ); // not runtime settable
+
+    int serverEventLoopWorkers = 0; // 0 -> 2x cores
+    ExportedServerParameter<int> serverEventLoopWorkersParam( ServerParameterSet::getGlobal(),
+                                                              "serverEventLoopWorkers",
+                                                              &serverEventLoopWorkers,
+                                                              true,
+                                                              false );
+
+#ifdef __linux__
+
+    class EventLoopMessageServer : public MessageServer , public Listener {
+    public:
+        EventLoopMessageServer( const MessageServer::Options& opts, MessageHandler* handler )
+            : Listener( "" , opts.ipList, opts.port ),
+              _handler( handler ),
+              _workers( serverEventLoopWorkers > 0
+                            ? serverEventLoopWorkers
+                            : 2 * static_cast<int>( ProcessInfo().getNumCores() ) ) {
+            _epollFd = epoll_create1( EPOLL_CLOEXEC );
+            massert( 18500, errnoWithPrefix( "epoll_create1 failed" ), _epollFd >= 0 );
+        }
+
+        virtual ~EventLoopMessageServer() {
+            close( _epollFd );
+        }
+
+        virtual void acceptedMP( MessagingPort* p ) {
+            if ( ! Listener::globalTicketHolder.tryAcquire() ) {
+                log() << "connection refused because too many open connections: "
+                      << Listener::globalTicketHolder.used() << endl;
+                p->shutdown();
+                delete p;
+                sleepmillis(2); // otherwise we'll hard loop
+                return;
+            }
+
+            Connection* conn = new Connection( p );
+            p->psock->setLogLevel( logger::LogSeverity::Debug(1) );
+
+            try {
+                _handler->connected( p );
+            }
+            catch ( ... ) {
+                log() << "exception in connected() handler, closing connection" << endl;
+                closeConnection( conn );
+                return;
+            }
+
+            // From here on the epoll set owns the connection; EPOLLONESHOT
+            // guarantees only one worker services it at a time.
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = conn;
+            if ( epoll_ctl( _epollFd, EPOLL_CTL_ADD, p->psock->rawFD(), &ev ) != 0 ) {
+                log() << errnoWithPrefix( "epoll_ctl(ADD) failed, closing connection" ) << endl;
+                closeConnection( conn );
+            }
+        }
+
+        virtual void setAsTimeTracker() {
+            Listener::setAsTimeTracker();
+        }
+
+        virtual void setupSockets() {
+            Listener::setupSockets();
+        }
+
+        void run() {
+            boost::thread loop( boost::bind( &EventLoopMessageServer::eventLoop, this ) );
+            initAndListen();
+        }
+
+        virtual bool useUnixSockets() const { return true; }
+
+    private:
+        /**
+         * Per-connection state.  Owned by whichever of the epoll set / a
+         * worker currently holds the connection; freed in closeConnection().
+         */
+        struct Connection {
+            explicit Connection( MessagingPort* p )
+                : port( p ), lastError( new LastError() ), otherSide( p->psock->remoteString() ) {
+                // Each request is fully processed before the next recv() on this port, so
+                // received buffers can be pooled per connection.
+                p->setRecvBufferPooling( true );
+            }
+            ~Connection() {
+                delete lastError;
+            }
+
+            MessagingPort* port;
+            LastError* lastError;
+            string otherSide;
+        };
+
+        void eventLoop() {
+            setThreadName( "eventLoop" );
+            const int kMaxEvents = 128;
+            epoll_event events[kMaxEvents];
+
+            while ( ! inShutdown() ) {
+                int n = epoll_wait( _epollFd, events, kMaxEvents, 100 /*ms*/ );
+                if ( n < 0 ) {
+                    if ( errno == EINTR )
+                        continue;
+                    error() << errnoWithPrefix( "epoll_wait failed" ) << endl;
+                    break;
+                }
+                for ( int i = 0; i < n; i++ ) {
+                    Connection* conn = static_cast<Connection*>( events[i].data.ptr );
+                    // Hand the connection to a worker even on HUP/error: the
+                    // recv() there reports the close and runs the normal
+                    // disconnect path.
+                    // key on the fd so a connection's requests stay on one
+                    // worker (and its warm caches) whenever it keeps up
+                    _workers.scheduleOn(
+                            conn->port->psock->rawFD(),
+                            boost::bind( &EventLoopMessageServer::serviceConnection,
+                                         this, conn ) );
+                }
+            }
+        }
+
+        /**
+         * Runs on a pool worker: receive and process one request, then
+         * re-arm the socket in the epoll set.
+         */
+        void serviceConnection( Connection* conn ) {
+            MessagingPort* p = conn->port;
+
+            lastError.release(); // detach whatever the previous dispatch left
+            lastError.reset( conn->lastError );
+
+            try {
+                Message m;
+                p->psock->clearCounters();
+                if ( ! p->recv( m ) ) {
+                    if ( ! serverGlobalParams.quiet ) {
+                        int conns = Listener::globalTicketHolder.used()-1;
+                        const char* word = (conns == 1 ? " connection" : " connections");
+                        log() << "end connection " << conn->otherSide
+                              << " (" << conns << word << " now open)" << endl;
+                    }
+                    disconnect( conn );
+                    return;
+                }
+
+                _handler->process( m, p, conn->lastError );
+                networkCounter.hit( p->psock->getBytesIn(), p->psock->getBytesOut() );
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException handling request, closing client connection: "
+                      << e << endl;
+                disconnect( conn );
+                return;
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException handling request, closing client connection: "
+                      << e << endl;
+                disconnect( conn );
+                return;
+            }
+            catch ( const DBException& e ) {
+                log() << "DBException handling request, closing client connection: "
+                      << e << endl;
+                disconnect( conn );
+                return;
+            }
+            catch ( std::exception& e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+            lastError.release();
+
+            // Park the connection again; level-triggered epoll re-fires
+            // immediately if a pipelined request is already buffered.
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = conn;
+            if ( epoll_ctl( _epollFd, EPOLL_CTL_MOD, p->psock->rawFD(), &ev ) != 0 ) {
+                log() << errnoWithPrefix( "epoll_ctl(MOD) failed, closing connection" ) << endl;
+                disconnect( conn );
+            }
+        }
+
+        void disconnect( Connection* conn ) {
+            lastError.release();
+            try {
+                _handler->disconnected( conn->port );
+            }
+            catch ( ... ) {
+                log() << "exception in disconnected() handler" << endl;
+            }
+            closeConnection( conn );
+        }
+
+        /** Tears down the socket and releases the connection ticket. */
+        void closeConnection( Connection* conn ) {
+            // The fd was implicitly removed from the epoll set when ONESHOT
+            // fired; an explicit DEL is unnecessary before close().
+            conn->port->shutdown();
+            delete conn->port;
+            delete conn;
+            Listener::globalTicketHolder.release();
+        }
+
+        MessageHandler* _handler;
+        threadpool::WorkStealingPool _workers;
+        int _epollFd;
+    };
+
+    MessageServer* createEventLoopServer( const MessageServer::Options& opts,
+                                          MessageHandler* handler ) {
+        return new EventLoopMessageServer( opts, handler );
+    }
+
+#else   // !__linux__
+
+    MessageServer* createEventLoopServer( const MessageServer::Options& opts,
+                                          MessageHandler* handler ) {
+        verify( false ); // createServer() never routes here off Linux
+        return NULL;
+    }
+
+#endif  // __linux__
+
+}
@@ -21,9 +21,12 @@
 
 #ifndef USE_ASIO
 
+#include <deque>
 
 #include "mongo/db/lasterror.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/net/listen.h"
@@ -38,6 +41,14 @@
 
 namespace mongo {
 
+    bool serverPipelinedConnections = false; // --setParameter serverPipelinedConnections=true
+    ExportedServerParameter<bool> serverPipelinedConnectionsParam(
+            ServerParameterSet::getGlobal(),
+            "serverPipelinedConnections",
+            &serverPipelinedConnections,
+            true,    // startup
+            false ); // not runtime settable
+
     class PortMessageServer : public MessageServer , public Listener {
     public:
         /**
@@ -151,6 +162,171 @@ namespace mongo {
             MessageHandler* handler;
         };
 
+        /**
+         * State shared between the socket reader thread and the connection thread
+         * of a pipelined connection. The reader produces complete messages; the
+         * connection thread consumes them strictly in arrival order, so the
+         * per-connection response ordering of MessagingPort::reply is unchanged.
+         */
+        struct PipelineState {
+            // Bound on decoded-but-unprocessed messages per connection, so a
+            // fast sender cannot buffer an unbounded amount of work here.
+            static const size_t MaxQueued = 16;
+
+            PipelineState():
+                lock( "PipelineState" ),
+                readerDone( false ),
+                workerDone( false ) {
+            }
+
+            ~PipelineState() {
+                while ( !queue.empty() ) {
+                    delete queue.front();
+                    queue.pop_front();
+                }
+            }
+
+            mongo::mutex lock;
+            boost::condition cond;
+            std::deque<Message*> queue;
+            bool readerDone;
+            bool workerDone;
+        };
+
+        /**
+         * Body of the reader thread of a pipelined connection: decodes the next
+         * messages off the socket while the connection thread is still executing
+         * the current operation. Exits when the socket yields an error or EOF,
+         * including the connection thread shutting the port down after a failure.
+         */
+        static void pipelineReaderThread(MessagingPort* p, PipelineState* state) {
+            {
+                string threadName = "connread";
+                if ( p->connectionId() > 0 )
+                    threadName = str::stream() << threadName << p->connectionId();
+                setThreadName( threadName.c_str() );
+            }
+
+            while ( true ) {
+                auto_ptr<Message> m( new Message() );
+
+                bool ok = false;
+                try {
+                    ok = p->recv( *m );
+                }
+                catch ( ... ) {
+                    // recv() already logged; treat like EOF and let the
+                    // connection thread run the normal disconnect path.
+                }
+
+                scoped_lock sl( state->lock );
+
+                if ( !ok || inShutdown() ) {
+                    state->readerDone = true;
+                    state->cond.notify_all();
+                    return;
+                }
+
+                while ( state->queue.size() >= PipelineState::MaxQueued &&
+                        !state->workerDone ) {
+                    state->cond.wait( sl.boost() );
+                }
+
+                if ( state->workerDone ) {
+                    state->readerDone = true;
+                    state->cond.notify_all();
+                    return;
+                }
+
+                state->queue.push_back( m.release() );
+                state->cond.notify_all();
+            }
+        }
+
+        /**
+         * Pipelined variant of the receive loop below: a dedicated reader thread
+         * decodes subsequent requests off the socket while this thread executes
+         * the current one, overlapping network I/O with operation execution for
+         * clients that pipeline requests on one connection. Processing stays on
+         * this single thread in FIFO order, which preserves response ordering.
+         *
+         * Returns when the connection is done; the caller runs the normal
+         * disconnect path. Rethrows handler exceptions after stopping the reader.
+         */
+        static void pipelinedReceiveLoop(MessagingPort* p,
+                                         MessageHandler* handler,
+                                         LastError* le,
+                                         const string& otherSide) {
+            PipelineState state;
+            boost::thread reader( boost::bind( &pipelineReaderThread, p, &state ) );
+
+            long long prevBytesOut = 0;
+            try {
+                while ( true ) {
+                    Message* next = NULL;
+                    {
+                        scoped_lock sl( state.lock );
+                        while ( state.queue.empty() && !state.readerDone ) {
+                            state.cond.wait( sl.boost() );
+                        }
+                        if ( !state.queue.empty() ) {
+                            next = state.queue.front();
+                            state.queue.pop_front();
+                            // The reader may be blocked on a full queue.
+                            state.cond.notify_all();
+                        }
+                    }
+
+                    if ( !next ) {
+                        // Reader hit EOF or an error and the queue is drained.
+                        if (!serverGlobalParams.quiet) {
+                            int conns = Listener::globalTicketHolder.used()-1;
+                            const char* word = (conns == 1 ? " connection" : " connections");
+                            log() << "end connection " << otherSide << " (" << conns << word << " now open)" << endl;
+                        }
+                        break;
+                    }
+
+                    auto_ptr<Message> nextHolder( next );
+
+                    if ( inShutdown() ) {
+                        continue; // drain the queue without processing
+                    }
+
+                    handler->process( *next, p, le );
+
+                    // Only this thread sends, so the socket's outbound counter can
+                    // be read here without racing the reader; inbound traffic is
+                    // accounted by message size because the reader owns the
+                    // socket's receive-side counters.
+                    long long bytesOut = p->psock->getBytesOut();
+                    networkCounter.hit( next->size(), bytesOut - prevBytesOut );
+                    prevBytesOut = bytesOut;
+                }
+            }
+            catch ( ... ) {
+                // Unblock the reader (shutdown fails its recv, the notify wakes a
+                // full-queue wait) and join it before unwinding; it references
+                // both the port and this stack frame.
+                p->shutdown();
+                {
+                    scoped_lock sl( state.lock );
+                    state.workerDone = true;
+                    state.cond.notify_all();
+                }
+                reader.join();
+                throw;
+            }
+
+            p->shutdown();
+            {
+                scoped_lock sl( state.lock );
+                state.workerDone = true;
+                state.cond.notify_all();
+            }
+            reader.join();
+        }
+
         /**
          * Handles incoming messages from a given socket.
          *
@@ -179,6 +355,13 @@ namespace mongo {
 
             verify( inPort );
             inPort->psock->setLogLevel(logger::LogSeverity::Debug(1));
+            if ( !serverPipelinedConnections ) {
+                // The loop below consumes each message before the next recv() and the port
+                // outlives them all, so received buffers can be pooled per connection.
+                // With pipelining the next recv() happens while the previous message is
+                // still being processed, so pooling's reclaim-on-recv contract is unsafe.
+                inPort->setRecvBufferPooling( true );
+            }
             scoped_ptr<MessagingPort> p( inPort );
 
             string otherSide;
@@ -192,7 +375,10 @@ namespace mongo {
 
                 handler->connected( p.get() );
 
-                while ( ! inShutdown() ) {
+                if ( serverPipelinedConnections ) {
+                    pipelinedReceiveLoop( p.get(), handler, le, otherSide );
+                }
+                else while ( ! inShutdown() ) {
                     m.reset();
                     p->psock->clearCounters();
 
@@ -245,6 +431,10 @@ namespace mongo {
 
 
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+#ifdef __linux__
+        if ( serverEventLoop )
+            return createEventLoopServer( opts , handler );
+#endif
         return new PortMessageServer( opts , handler );
     }
 
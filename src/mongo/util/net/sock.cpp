@@ -429,6 +429,9 @@ namespace mongo {
     void Socket::_init() {
         _bytesOut = 0;
         _bytesIn = 0;
+        _corkDepth = 0;
+        _appliedTimeout = 0; // a fresh fd has no kernel timeout
+
         _awaitingHandshake = true;
 #ifdef MONGO_SSL
         _sslManager = 0;
@@ -464,6 +467,7 @@ namespace mongo {
             return false;
         }
         _sslManager = mgr;
+        _applyTimeout(); // the handshake reads the raw fd, bypassing _recv()
         _sslConnection.reset(_sslManager->connect(this));
         mgr->parseAndValidatePeerCertificate(_sslConnection.get(), remoteHost);
         return true;
@@ -481,6 +485,7 @@ namespace mongo {
                                   "Attempt to call SSL_accept on already secure Socket from " +
                                   remoteString());
         }
+        _applyTimeout(); // the handshake reads the raw fd, bypassing _recv()
         _sslConnection.reset(_sslManager->accept(this, firstBytes, len));
         return _sslManager->parseAndValidatePeerCertificate(_sslConnection.get(), "");
     }
@@ -515,9 +520,9 @@ namespace mongo {
             return false;
         }
 
-        if ( _timeout > 0 ) {
-            setTimeout( _timeout );
-        }
+        // new fd, so the kernel timeout options are back at their default;
+        // the first blocking send/recv re-applies _timeout
+        _appliedTimeout = 0;
 
         ConnectBG bg(_fd, remote);
         bg.go();
@@ -555,8 +560,29 @@ namespace mongo {
         return true;
     }
 
-    // throws if SSL_write or send fails 
+    void Socket::cork() {
+#ifdef TCP_CORK
+        if ( _corkDepth++ == 0 && _fd >= 0 ) {
+            const int one = 1;
+            // fails (harmlessly) on non-TCP sockets like unix domain sockets
+            setsockopt( _fd, IPPROTO_TCP, TCP_CORK, (char *) &one, sizeof(one) );
+        }
+#endif
+    }
+
+    void Socket::uncork() {
+#ifdef TCP_CORK
+        verify( _corkDepth > 0 );
+        if ( --_corkDepth == 0 && _fd >= 0 ) {
+            const int zero = 0;
+            setsockopt( _fd, IPPROTO_TCP, TCP_CORK, (char *) &zero, sizeof(zero) );
+        }
+#endif
+    }
+
+    // throws if SSL_write or send fails
     int Socket::_send( const char * data , int len, const char * context ) {
+        _applyTimeout();
 #ifdef MONGO_SSL
         if ( _sslConnection.get() ) {
             return _sslManager->SSL_write( _sslConnection.get() , data , len );
@@ -608,6 +634,7 @@ namespace mongo {
      * @param context descriptive for logging
      */
     void Socket::send( const vector< pair< char *, int > > &data, const char *context ) {
+        _applyTimeout();
 
 #ifdef MONGO_SSL
         if ( _sslConnection.get() ) {
@@ -713,6 +740,7 @@ namespace mongo {
 
     // throws if SSL_read fails or recv returns an error
     int Socket::_recv( char *buf, int max ) {
+        _applyTimeout();
 #ifdef MONGO_SSL
         if ( _sslConnection.get() ){
             return _sslManager->SSL_read( _sslConnection.get() , buf , max );
@@ -782,7 +810,14 @@ namespace mongo {
     }
 
     void Socket::setTimeout( double secs ) {
-        setSockTimeouts( _fd, secs );
+        _timeout = secs;
+    }
+
+    void Socket::_applyTimeout() {
+        if ( _timeout == _appliedTimeout || _fd < 0 )
+            return;
+        setSockTimeouts( _fd, _timeout );
+        _appliedTimeout = _timeout;
     }
 
     // TODO: allow modification?
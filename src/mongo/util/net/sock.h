@@ -207,6 +207,16 @@ namespace mongo {
         void send( const char * data , int len, const char *context );
         void send( const std::vector< std::pair< char *, int > > &data, const char *context );
 
+        /**
+         * Output batching hints.  While corked the kernel holds back partial
+         * TCP segments, so several sends coalesce into full frames; uncork()
+         * is the explicit flush point.  Calls nest -- only the outermost
+         * uncork() flushes.  No-ops on platforms without TCP_CORK and on
+         * non-TCP sockets; with SSL they still apply, below the TLS layer.
+         */
+        void cork();
+        void uncork();
+
         // recv len or throw SocketException
         void recv( char * data , int len );
         int unsafe_recv( char *buf, int max );
@@ -225,6 +235,12 @@ namespace mongo {
         long long getBytesOut() const { return _bytesOut; }
         int rawFD() const { return _fd; }
 
+        /**
+         * Cheap, in-memory only.  The kernel SO_RCVTIMEO/SO_SNDTIMEO options
+         * are synced lazily on the next blocking send/recv, and only if the
+         * value actually changed, so callers that adjust the timeout per
+         * operation (e.g. for maxTimeMS) don't pay setsockopt per op.
+         */
         void setTimeout( double secs );
         bool isStillConnected();
 
@@ -281,16 +297,23 @@ namespace mongo {
         /** raw recv, same semantics as ::recv */
         int _recv( char * buf , int max );
 
+        /** syncs the kernel timeout options with _timeout if they differ */
+        void _applyTimeout();
+
         int _fd;
         uint64_t _fdCreationMicroSec;
         SockAddr _local;
         SockAddr _remote;
         double _timeout;
+        double _appliedTimeout; // what the kernel currently has; see _applyTimeout()
 
         long long _bytesIn;
         long long _bytesOut;
         time_t _lastValidityCheckAtSecs;
 
+        // cork()/uncork() nesting depth; the socket is corked while > 0
+        int _corkDepth;
+
 #ifdef MONGO_SSL
         boost::scoped_ptr<SSLConnection> _sslConnection;
         SSLManagerInterface* _sslManager;
@@ -302,5 +325,17 @@ namespace mongo {
 
     };
 
+    /**
+     * Corks a socket for the lifetime of the object; the destructor is the
+     * flush point.  Safe to nest (see Socket::cork()).
+     */
+    class ScopedSocketCork {
+        MONGO_DISALLOW_COPYING(ScopedSocketCork);
+    public:
+        explicit ScopedSocketCork( Socket& sock ) : _sock( sock ) { _sock.cork(); }
+        ~ScopedSocketCork() { _sock.uncork(); }
+    private:
+        Socket& _sock;
+    };
 
 } // namespace mongo
@@ -19,6 +19,7 @@
 
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/tss.hpp>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -127,6 +128,13 @@ namespace mongo {
         SSLManagerInterface* theSSLManager = NULL;
         static const int BUFFER_SIZE = 8*1024;
 
+        // SSL session resumption: cap on the server's internal session cache,
+        // lifetime of cached sessions, and cap on the number of distinct remotes
+        // in the outgoing session map.
+        static const long SERVER_SESSION_CACHE_SIZE = 20 * 1024;
+        static const long SESSION_TIMEOUT_SECONDS = 5 * 60;
+        static const size_t MAX_CLIENT_SESSIONS = 256;
+
         struct Params {
             Params(const std::string& pemfile,
                    const std::string& pempwd,
@@ -207,6 +215,12 @@ namespace mongo {
             std::string _serverSubjectName;
             std::string _clientSubjectName;
 
+            // Sessions negotiated on completed outgoing handshakes, keyed by the
+            // remote's "host:port" and offered on the next connect() to the same
+            // remote so it can grant an abbreviated handshake.
+            SimpleMutex _clientSessionMtx;
+            std::map<std::string, SSL_SESSION*> _clientSessions;
+
             /**
              * creates an SSL object to be used for this file descriptor.
              * caller must SSL_free it.
@@ -251,6 +265,18 @@ namespace mongo {
              */
             void _setupFIPS();
 
+            /*
+             * Offer a previously negotiated session for this connection's remote,
+             * if we have one, so the server can grant an abbreviated handshake.
+             */
+            void _applyClientSession(SSLConnection* conn);
+
+            /*
+             * Remember the session negotiated on this outgoing connection for
+             * later resumption.
+             */
+            void _recordClientSession(SSLConnection* conn);
+
             /*
              * sub function for checking the result of an SSL operation
              */
@@ -367,7 +393,8 @@ namespace mongo {
     SSLManager::SSLManager(const Params& params, bool isServer) :
         _validateCertificates(false),
         _weakValidation(params.weakCertificateValidation),
-        _allowInvalidCertificates(params.allowInvalidCertificates) {
+        _allowInvalidCertificates(params.allowInvalidCertificates),
+        _clientSessionMtx("SSLClientSessionCache") {
 
         SSL_library_init();
         SSL_load_error_strings();
@@ -430,6 +457,11 @@ namespace mongo {
         ERR_free_strings();
         EVP_cleanup();
 
+        for (std::map<std::string, SSL_SESSION*>::iterator it = _clientSessions.begin();
+             it != _clientSessions.end(); ++it) {
+            SSL_SESSION_free(it->second);
+        }
+
         if (NULL != _serverContext) {
             SSL_CTX_free(_serverContext);
         }
@@ -537,8 +569,29 @@ namespace mongo {
         // Note: this is for blocking sockets only.
         SSL_CTX_set_mode(*context, SSL_MODE_AUTO_RETRY);
 
-        // Disable session caching (see SERVER-10261)
-        SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+        if (context == &_serverContext) {
+            // Cache sessions for incoming connections so reconnecting clients can
+            // resume with an abbreviated handshake instead of paying a full key
+            // exchange every time.  Unlike the default setup that motivated
+            // disabling caching (SERVER-10261), this cache is explicitly bounded
+            // and its entries time out.
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_sess_set_cache_size(*context, SERVER_SESSION_CACHE_SIZE);
+            SSL_CTX_set_timeout(*context, SESSION_TIMEOUT_SECONDS);
+
+            // a session id context is required to resume sessions when peer
+            // certificates are verified
+            static const unsigned char sessionIdContext[] = "mongo";
+            SSL_CTX_set_session_id_context(*context,
+                                           sessionIdContext,
+                                           sizeof(sessionIdContext) - 1);
+        }
+        else {
+            // Outgoing sessions are cached per remote host by the manager itself
+            // (see _recordClientSession); OpenSSL's internal client cache would
+            // only accumulate sessions it never offers.
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+        }
  
         // Use the clusterfile for internal outgoing SSL connections if specified 
         if (context == &_clientContext && !params.clusterfile.empty()) {
@@ -732,19 +785,53 @@ namespace mongo {
         }
     }
 
+    void SSLManager::_applyClientSession(SSLConnection* conn) {
+        SimpleMutex::scoped_lock lck(_clientSessionMtx);
+        std::map<std::string, SSL_SESSION*>::const_iterator it =
+            _clientSessions.find(conn->socket->remoteString());
+        if (it != _clientSessions.end()) {
+            // merely an offer; the server falls back to a full handshake if it
+            // no longer knows (or has expired) the session
+            SSL_set_session(conn->ssl, it->second);
+        }
+    }
+
+    void SSLManager::_recordClientSession(SSLConnection* conn) {
+        SSL_SESSION* session = SSL_get1_session(conn->ssl);
+        if (NULL == session)
+            return;
+
+        SimpleMutex::scoped_lock lck(_clientSessionMtx);
+        if (_clientSessions.size() >= MAX_CLIENT_SESSIONS &&
+            _clientSessions.count(conn->socket->remoteString()) == 0) {
+            // talking to more distinct remotes than we are willing to track
+            SSL_SESSION_free(session);
+            return;
+        }
+
+        SSL_SESSION*& cached = _clientSessions[conn->socket->remoteString()];
+        if (cached)
+            SSL_SESSION_free(cached);
+        cached = session;
+    }
+
     SSLConnection* SSLManager::connect(Socket* socket) {
         SSLConnection* sslConn = new SSLConnection(_clientContext, socket, NULL, 0);
         ScopeGuard sslGuard = MakeGuard(::SSL_free, sslConn->ssl);
         ScopeGuard bioGuard = MakeGuard(::BIO_free, sslConn->networkBIO);
- 
+
+        _applyClientSession(sslConn);
+
         int ret;
         do {
             ret = ::SSL_connect(sslConn->ssl);
         } while(!_doneWithSSLOp(sslConn, ret));
- 
+
         if (ret != 1)
             _handleSSLError(SSL_get_error(sslConn, ret), ret);
- 
+
+        _recordClientSession(sslConn);
+
         sslGuard.Dismiss();
         bioGuard.Dismiss();
         return sslConn;
@@ -0,0 +1,108 @@
+// numa.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/numa.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+        bool interleaveApplied = false;
+    }
+
+    int numaNodeCount() {
+#ifdef __linux__
+        // nodes are exposed as /sys/devices/system/node/node0, node1, ...
+        int count = 0;
+        try {
+            while (boost::filesystem::exists(
+                       mongoutils::str::stream() << "/sys/devices/system/node/node" << count)) {
+                count++;
+            }
+        }
+        catch (const boost::filesystem::filesystem_error&) {
+            // fall through; treat an unreadable topology as a single node
+        }
+        return count > 0 ? count : 1;
+#else
+        return 1;
+#endif
+    }
+
+#ifdef __linux__
+    Status numaInterleaveAllNodes() {
+        // mode and syscall constants from linux/mempolicy.h; we invoke the syscall
+        // directly so we don't pick up a libnuma dependency for one call.
+        const int MPOL_INTERLEAVE_MODE = 3;
+
+        // all-ones mask covers every possible node; the kernel ignores bits for
+        // nodes that don't exist
+        unsigned long nodeMask[16];
+        for (size_t i = 0; i < sizeof(nodeMask) / sizeof(nodeMask[0]); i++) {
+            nodeMask[i] = ~0UL;
+        }
+
+        long rc = syscall(__NR_set_mempolicy,
+                          MPOL_INTERLEAVE_MODE,
+                          nodeMask,
+                          sizeof(nodeMask) * 8);
+        if (rc != 0) {
+            return Status(ErrorCodes::InternalError,
+                          mongoutils::str::stream() << "set_mempolicy(MPOL_INTERLEAVE) failed: "
+                                        << errnoWithDescription());
+        }
+
+        interleaveApplied = true;
+        return Status::OK();
+    }
+#else
+    Status numaInterleaveAllNodes() {
+        return Status(ErrorCodes::InternalError,
+                      "NUMA interleaving is only supported on linux");
+    }
+#endif
+
+    bool numaInterleaveApplied() {
+        return interleaveApplied;
+    }
+
+}  // namespace mongo
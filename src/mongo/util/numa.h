@@ -0,0 +1,57 @@
+// numa.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/base/status.h"
+
+namespace mongo {
+
+    /**
+     * Number of NUMA memory nodes on this host, or 1 when the topology cannot be
+     * determined (non-Linux, or no /sys nodes exposed).
+     */
+    int numaNodeCount();
+
+    /**
+     * Sets this process's memory policy to interleave page allocation across all
+     * NUMA nodes -- the same effect as launching under numactl --interleave=all.
+     * Only affects pages faulted in afterwards, so call it before the datafiles
+     * are mapped and before the caches warm up.
+     *
+     * Returns a non-OK status on platforms without set_mempolicy or if the kernel
+     * refuses the call; the process is unchanged in that case.
+     */
+    Status numaInterleaveAllNodes();
+
+    /** True once numaInterleaveAllNodes() has succeeded in this process. */
+    bool numaInterleaveApplied();
+
+}  // namespace mongo
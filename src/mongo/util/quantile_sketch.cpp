@@ -0,0 +1,132 @@
+// quantile_sketch.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/util/quantile_sketch.h"
+
+#include <cmath>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    QuantileSketch::QuantileSketch(double gamma, int numBuckets, double minValue)
+        : _gamma(gamma),
+          _invLogGamma(1.0 / std::log(gamma)),
+          _minValue(minValue),
+          _numBuckets(numBuckets) {
+        verify(gamma > 1.0);
+        verify(numBuckets >= 2 && numBuckets <= MaxBuckets);
+        verify(minValue > 0.0);
+    }
+
+    int QuantileSketch::_bucketFor(double value) const {
+        // !(value >= _minValue) also catches NaN and negatives
+        if (!(value >= _minValue))
+            return 0;
+        // the epsilon keeps exact boundaries (e.g. powers of two for gamma 2)
+        // in the bucket they open rather than one below it
+        int idx = static_cast<int>(std::log(value / _minValue) * _invLogGamma + 1e-9);
+        if (idx >= _numBuckets)
+            idx = _numBuckets - 1;
+        return idx;
+    }
+
+    void QuantileSketch::record(double value) {
+        _buckets[_bucketFor(value)].fetchAndAdd(1);
+        _count.fetchAndAdd(1);
+    }
+
+    void QuantileSketch::merge(const QuantileSketch& other) {
+        verify(_gamma == other._gamma &&
+               _numBuckets == other._numBuckets &&
+               _minValue == other._minValue);
+        for (int i = 0; i < _numBuckets; i++) {
+            long long count = other._buckets[i].load();
+            if (count)
+                _buckets[i].fetchAndAdd(count);
+        }
+        _count.fetchAndAdd(other._count.load());
+    }
+
+    double QuantileSketch::bucketLowerBound(int i) const {
+        if (i == 0)
+            return 0.0;
+        return _minValue * std::pow(_gamma, i);
+    }
+
+    double QuantileSketch::quantile(double prob) const {
+        long long total = _count.load();
+        if (total == 0)
+            return 0.0;
+
+        long long rank = static_cast<long long>(prob * total);
+        if (rank >= total)
+            rank = total - 1;
+
+        long long seen = 0;
+        int bucket = _numBuckets - 1;
+        for (int i = 0; i < _numBuckets; i++) {
+            seen += _buckets[i].load();
+            if (seen > rank) {
+                bucket = i;
+                break;
+            }
+        }
+
+        if (bucket == 0)
+            return 0.0;
+        // midpoint of [gamma^i, gamma^(i+1)); off from any point in the
+        // bucket by at most a factor of (gamma+1)/2
+        return _minValue * std::pow(_gamma, bucket) * (1.0 + _gamma) / 2.0;
+    }
+
+    void QuantileSketch::reset() {
+        for (int i = 0; i < _numBuckets; i++)
+            _buckets[i].store(0);
+        _count.store(0);
+    }
+
+    void QuantileSketch::appendSummary(const double* probs, int numProbs,
+                                       BSONObjBuilder* builder) const {
+        long long total = _count.load();
+        builder->appendNumber("count", total);
+        if (total == 0)
+            return;
+        BSONObjBuilder quantilesBuilder(builder->subobjStart("quantiles"));
+        for (int i = 0; i < numProbs; i++) {
+            quantilesBuilder.append(std::string(mongoutils::str::stream() << probs[i]),
+                                    quantile(probs[i]));
+        }
+        quantilesBuilder.doneFast();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,116 @@
+// quantile_sketch.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * A fixed-memory quantile sketch over non-negative samples, built on
+     * log-spaced buckets: bucket i counts samples in
+     * [minValue * gamma^i, minValue * gamma^(i+1)), except bucket 0 which
+     * starts at 0.  A reported quantile is therefore within a factor of
+     * 'gamma' of the true one, regardless of how many samples were recorded.
+     *
+     * Unlike the P^2-style DistributionEstimators (descriptive_stats.h),
+     * sketches with the same layout can be merged - per-thread or per-slice
+     * sketches sum into an overall one - and recording is a single atomic
+     * increment, so a sketch can sit on a hot path and be read or merged at
+     * any time without locking.
+     */
+    class QuantileSketch {
+    public:
+        // Memory reserved per sketch; 'numBuckets' may use less of it.
+        static const int MaxBuckets = 256;
+
+        /**
+         * @param gamma      ratio between consecutive bucket boundaries, > 1.
+         *                   gamma 2 gives power-of-two buckets; gamma 1.1
+         *                   keeps quantiles within ~10%.
+         * @param numBuckets buckets actually used, <= MaxBuckets.  Samples
+         *                   beyond the last boundary land in the last bucket.
+         * @param minValue   lower boundary of bucket 1; everything smaller
+         *                   (including 0) counts in bucket 0.
+         */
+        QuantileSketch(double gamma, int numBuckets, double minValue = 1.0);
+
+        /** records one sample, lock free */
+        void record(double value);
+
+        /**
+         * Adds another sketch's counts into this one.  The two must have been
+         * constructed with the same parameters.  Safe against concurrent
+         * record() on either side; counts recorded into 'other' mid-merge may
+         * be missed, as with any racing read.
+         */
+        void merge(const QuantileSketch& other);
+
+        /** total samples recorded */
+        long long count() const { return _count.load(); }
+
+        /**
+         * @return an estimate of the quantile at probability 'prob' (in
+         * [0, 1]), i.e. a value v such that about prob * count() samples were
+         * <= v.  Returns 0 when nothing has been recorded.
+         */
+        double quantile(double prob) const;
+
+        /** zeroes all counters */
+        void reset();
+
+        int numBuckets() const { return _numBuckets; }
+        long long bucketCount(int i) const { return _buckets[i].load(); }
+
+        /** lower boundary of bucket i; 0 for bucket 0 */
+        double bucketLowerBound(int i) const;
+
+        /**
+         * Appends { count: N, quantiles: { 0.5: ..., ... } } for the given
+         * probabilities; quantiles are omitted when nothing was recorded.
+         */
+        void appendSummary(const double* probs, int numProbs, BSONObjBuilder* builder) const;
+
+    private:
+        int _bucketFor(double value) const;
+
+        double _gamma;
+        double _invLogGamma;
+        double _minValue;
+        int _numBuckets;
+
+        AtomicInt64 _count;
+        AtomicInt64 _buckets[MaxBuckets];
+    };
+
+}  // namespace mongo
@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * Tests for mongo/util/quantile_sketch.h
+ */
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/quantile_sketch.h"
+
+namespace {
+
+    using mongo::QuantileSketch;
+
+    TEST(QuantileSketch, Empty) {
+        QuantileSketch s(2.0, 32);
+        ASSERT_EQUALS(0, s.count());
+        ASSERT_EQUALS(0.0, s.quantile(0.5));
+    }
+
+    TEST(QuantileSketch, PowerOfTwoBuckets) {
+        QuantileSketch s(2.0, 32);
+        s.record(0);    // bucket 0: [0, 2)
+        s.record(1);    // bucket 0
+        s.record(3);    // bucket 1: [2, 4)
+        s.record(4);    // bucket 2: [4, 8)
+        s.record(100);  // bucket 6: [64, 128)
+        ASSERT_EQUALS(5, s.count());
+        ASSERT_EQUALS(2, s.bucketCount(0));
+        ASSERT_EQUALS(1, s.bucketCount(1));
+        ASSERT_EQUALS(1, s.bucketCount(2));
+        ASSERT_EQUALS(1, s.bucketCount(6));
+        ASSERT_EQUALS(0.0, s.bucketLowerBound(0));
+        ASSERT_EQUALS(2.0, s.bucketLowerBound(1));
+        ASSERT_EQUALS(64.0, s.bucketLowerBound(6));
+    }
+
+    TEST(QuantileSketch, OverflowClampsToLastBucket) {
+        QuantileSketch s(2.0, 8);
+        s.record(1e18);
+        ASSERT_EQUALS(1, s.bucketCount(7));
+    }
+
+    TEST(QuantileSketch, QuantileAccuracy) {
+        // uniform on [1, 1000); with gamma 1.05 a quantile is off by < 5%
+        QuantileSketch s(1.05, QuantileSketch::MaxBuckets);
+        for (int i = 1; i < 1000; i++) {
+            s.record(i);
+        }
+        ASSERT_APPROX_EQUAL(500.0, s.quantile(0.5), 500.0 * 0.06);
+        ASSERT_APPROX_EQUAL(900.0, s.quantile(0.9), 900.0 * 0.06);
+        ASSERT_APPROX_EQUAL(990.0, s.quantile(0.99), 990.0 * 0.06);
+    }
+
+    TEST(QuantileSketch, Merge) {
+        QuantileSketch low(1.05, QuantileSketch::MaxBuckets);
+        QuantileSketch high(1.05, QuantileSketch::MaxBuckets);
+        for (int i = 1; i < 500; i++) {
+            low.record(i);
+            high.record(500 + i);
+        }
+
+        QuantileSketch merged(1.05, QuantileSketch::MaxBuckets);
+        merged.merge(low);
+        merged.merge(high);
+        ASSERT_EQUALS(low.count() + high.count(), merged.count());
+        // same result as if all the samples had been recorded directly
+        ASSERT_APPROX_EQUAL(500.0, merged.quantile(0.5), 500.0 * 0.06);
+        ASSERT_APPROX_EQUAL(250.0, merged.quantile(0.25), 250.0 * 0.06);
+        ASSERT_APPROX_EQUAL(750.0, merged.quantile(0.75), 750.0 * 0.06);
+    }
+
+    TEST(QuantileSketch, Reset) {
+        QuantileSketch s(2.0, 32);
+        s.record(10);
+        s.reset();
+        ASSERT_EQUALS(0, s.count());
+        ASSERT_EQUALS(0, s.bucketCount(3));
+    }
+
+}  // namespace
@@ -21,9 +21,11 @@
 
 #include <limits>
 #include <queue>
+#include <vector>
 
 #include <boost/thread/condition.hpp>
 
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
@@ -101,6 +103,9 @@ namespace mongo {
             scoped_lock l(_lock);
             _queue = std::queue<T>();
             _currentSize = 0;
+            // Wake any producers blocked in push(); consumers that clear() a
+            // bounded queue to shed its backlog mean to unstick them too.
+            _cvNoLongerFull.notify_all();
         }
 
         bool tryPop( T & t ) {
@@ -200,4 +205,248 @@ namespace mongo {
         boost::condition _cvNoLongerEmpty;
     };
 
+    /**
+     * Bounded single-producer / single-consumer queue backed by a ring buffer.
+     *
+     * The fast paths are lock free: push and pop each do a couple of atomic index
+     * operations and never take a mutex.  The mutex and condition variables below
+     * exist only to park a producer that found the queue full or a consumer that
+     * found it empty, and both spin briefly before parking, so at a steady stream
+     * rate neither side ever touches the lock.  This matters on hot pipelines
+     * (e.g. the replication fetch buffer) where per-element mutex round trips in
+     * BlockingQueue become measurable at high ops/sec.
+     *
+     * Threading rules: exactly one thread may call the push family and exactly
+     * one thread may call the pop/peek family.  empty(), size() and count() are
+     * safe from any thread as point-in-time snapshots.
+     *
+     * Sizing works like BlockingQueue: an optional getSize function measures each
+     * item and push blocks while the measured total would reach maxSize.  The
+     * ring additionally bounds the queue to kNumSlots items regardless of their
+     * measured size.
+     */
+    template<typename T>
+    class SingleProducerSingleConsumerQueue : boost::noncopyable {
+        typedef size_t (*getSizeFunc)(const T& t);
+    public:
+        enum { kNumSlots = 64 * 1024, kSlotMask = kNumSlots - 1 };
+
+        SingleProducerSingleConsumerQueue() :
+            _ring(kNumSlots),
+            _maxSize(std::numeric_limits<std::size_t>::max()),
+            _getSize(&_getSizeDefault),
+            _parkLock("SPSCQueue") {}
+        SingleProducerSingleConsumerQueue(size_t maxSize, getSizeFunc f) :
+            _ring(kNumSlots),
+            _maxSize(maxSize),
+            _getSize(f),
+            _parkLock("SPSCQueue(custom size)") {}
+
+        void push(T const& t) {
+            _pushOne(t);
+            _wakeIfParked(_consumerParked, _cvNoLongerEmpty);
+        }
+
+        /**
+         * Pushes every element of v, waking a parked consumer once at the end
+         * rather than once per element.
+         */
+        void pushMany(const std::vector<T>& v) {
+            for (typename std::vector<T>::const_iterator i = v.begin(); i != v.end(); ++i) {
+                _pushOne(*i);
+            }
+            if (!v.empty())
+                _wakeIfParked(_consumerParked, _cvNoLongerEmpty);
+        }
+
+        bool empty() const {
+            return _head.load() == _tail.load();
+        }
+
+        /**
+         * The size as measured by the size function. Default to counting each item
+         */
+        size_t size() const {
+            return _currentSize.load();
+        }
+
+        /**
+         * The max size for this queue
+         */
+        size_t maxSize() const {
+            return _maxSize;
+        }
+
+        /**
+         * The number/count of items in the queue
+         */
+        int count() const {
+            return static_cast<int>(_tail.load() - _head.load());
+        }
+
+        bool tryPop( T & t ) {
+            const unsigned long long head = _head.load();
+            if ( head == _tail.load() )
+                return false;
+
+            T& slot = _ring[head & kSlotMask];
+            t = slot;
+            slot = T(); // don't let the dead slot pin the item's buffers
+            _head.store(head + 1);
+            _currentSize.fetchAndSubtract(_getSize(t));
+            _wakeIfParked(_producerParked, _cvNoLongerFull);
+
+            return true;
+        }
+
+        /**
+         * Drains up to maxElements immediately available items into *out (appending).
+         * Never blocks.  Returns the number of items popped; the producer is woken
+         * at most once however many items move.
+         */
+        size_t tryPopMany( std::vector<T>* out, size_t maxElements ) {
+            unsigned long long head = _head.load();
+            const unsigned long long tail = _tail.load();
+            size_t n = 0;
+            size_t bytes = 0;
+
+            while ( head != tail && n < maxElements ) {
+                T& slot = _ring[head & kSlotMask];
+                bytes += _getSize(slot);
+                out->push_back(slot);
+                slot = T();
+                head++;
+                n++;
+            }
+
+            if ( n ) {
+                _head.store(head);
+                _currentSize.fetchAndSubtract(bytes);
+                _wakeIfParked(_producerParked, _cvNoLongerFull);
+            }
+            return n;
+        }
+
+        T blockingPop() {
+            T t;
+            for ( int i = 0; i < kSpinBeforeParking; i++ ) {
+                if ( tryPop(t) )
+                    return t;
+            }
+            while ( !tryPop(t) ) {
+                _park(_consumerParked, _cvNoLongerEmpty);
+            }
+            return t;
+        }
+
+        /**
+         * blocks waiting for an object until maxSecondsToWait passes
+         * if got one, return true and set in t
+         * otherwise return false and t won't be changed
+         */
+        bool blockingPop( T& t , int maxSecondsToWait ) {
+            Timer timer;
+            for ( int i = 0; i < kSpinBeforeParking; i++ ) {
+                if ( tryPop(t) )
+                    return true;
+            }
+            while ( !tryPop(t) ) {
+                if ( timer.seconds() >= maxSecondsToWait )
+                    return false;
+                _park(_consumerParked, _cvNoLongerEmpty);
+            }
+            return true;
+        }
+
+        bool blockingPeek(T& t, int maxSecondsToWait) {
+            Timer timer;
+            for ( int i = 0; i < kSpinBeforeParking; i++ ) {
+                if ( peek(t) )
+                    return true;
+            }
+            while ( !peek(t) ) {
+                if ( timer.seconds() >= maxSecondsToWait )
+                    return false;
+                _park(_consumerParked, _cvNoLongerEmpty);
+            }
+            return true;
+        }
+
+        bool peek(T& t) {
+            const unsigned long long head = _head.load();
+            if ( head == _tail.load() )
+                return false;
+
+            t = _ring[head & kSlotMask];
+            return true;
+        }
+
+    private:
+        // iterations of the fast-path check before falling back to the parking lot
+        static const int kSpinBeforeParking = 128;
+
+        bool _wouldBeFull(unsigned long long tail, size_t tSize) const {
+            return tail - _head.load() == kNumSlots ||
+                   _currentSize.load() + tSize >= _maxSize;
+        }
+
+        void _pushOne(T const& t) {
+            const size_t tSize = _getSize(t);
+            const unsigned long long tail = _tail.load(); // we own _tail; only we advance it
+
+            for ( int i = 0; i < kSpinBeforeParking && _wouldBeFull(tail, tSize); i++ ) {
+            }
+            while ( _wouldBeFull(tail, tSize) ) {
+                _park(_producerParked, _cvNoLongerFull);
+            }
+
+            _ring[tail & kSlotMask] = t;
+            _currentSize.fetchAndAdd(tSize);
+            _tail.store(tail + 1); // publishes the slot to the consumer
+        }
+
+        /**
+         * Parks on cv for a bounded slice.  The parked flag is raised under
+         * _parkLock so the other side's _wakeIfParked can't miss us, and the wait
+         * is timed so that even a racy unparked wakeup just costs one re-check.
+         */
+        void _park(AtomicUInt32& parkedFlag, boost::condition& cv) {
+            boost::xtime xt;
+            boost::xtime_get(&xt, MONGO_BOOST_TIME_UTC);
+            xt.nsec += 10 * 1000 * 1000; // 10ms
+            if ( xt.nsec >= 1000 * 1000 * 1000 ) {
+                xt.sec += 1;
+                xt.nsec -= 1000 * 1000 * 1000;
+            }
+
+            scoped_lock l( _parkLock );
+            parkedFlag.store(1);
+            cv.timed_wait( l.boost() , xt );
+            parkedFlag.store(0);
+        }
+
+        void _wakeIfParked(AtomicUInt32& parkedFlag, boost::condition& cv) {
+            if ( parkedFlag.load() ) {
+                scoped_lock l( _parkLock );
+                cv.notify_one();
+            }
+        }
+
+        std::vector<T> _ring;
+        const size_t _maxSize;
+        getSizeFunc _getSize;
+
+        // indices increase monotonically; (index & kSlotMask) is the ring slot.
+        // _head is advanced only by the consumer, _tail only by the producer.
+        AtomicUInt64 _head;
+        AtomicUInt64 _tail;
+        AtomicUInt64 _currentSize;
+
+        AtomicUInt32 _producerParked;
+        AtomicUInt32 _consumerParked;
+        mutable mongo::mutex _parkLock;
+        boost::condition _cvNoLongerFull;
+        boost::condition _cvNoLongerEmpty;
+    };
+
 }
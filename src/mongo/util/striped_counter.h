@@ -0,0 +1,107 @@
+// striped_counter.h
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#pragma once
+
+#ifdef __linux__
+# include <sched.h>
+#endif
+
+#include <boost/noncopyable.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * A 64bit counter striped over cache-line-padded per-core slots.
+     *
+     * increment() touches only the current core's slot, so hot-path counting never bounces a
+     * cache line between cores the way a single shared atomic (or a mutex-protected counter)
+     * does.  Reads sum all slots and are therefore more expensive than Counter64::get(); use
+     * this for counters that are written on every operation but read rarely (serverStatus etc).
+     *
+     * get() is not a point-in-time snapshot: increments racing with a read may or may not be
+     * included.  That is the same guarantee the old shared counters gave in practice.
+     */
+    class StripedCounter64 : boost::noncopyable {
+    public:
+        StripedCounter64() {}
+
+        void increment( uint64_t n = 1 ) { _slots[slotIndex()].value.addAndFetch(n); }
+
+        /** Sum of all slots. */
+        long long get() const {
+            long long total = 0;
+            for ( unsigned i = 0; i < kNumSlots; i++ )
+                total += _slots[i].value.load();
+            return total;
+        }
+
+        operator long long() const { return get(); }
+
+        /** Not atomic with respect to concurrent increments; fine for wrap handling. */
+        void zero() {
+            for ( unsigned i = 0; i < kNumSlots; i++ )
+                _slots[i].value.store(0);
+        }
+
+    private:
+        // power of two, >= the core count of the largest boxes we run on
+        static const unsigned kNumSlots = 64;
+
+        static unsigned slotIndex() {
+#ifdef __linux__
+            int cpu = sched_getcpu();
+            if ( cpu >= 0 )
+                return static_cast<unsigned>(cpu) & ( kNumSlots - 1 );
+#endif
+            // no cheap current-cpu call: assign each thread a slot round-robin on first use
+#if defined(_WIN32)
+            static __declspec( thread ) unsigned mySlot = 0xffffffff;
+#else
+            static __thread unsigned mySlot = 0xffffffff;
+#endif
+            if ( mySlot == 0xffffffff ) {
+                static AtomicUInt32 nextSlot;
+                mySlot = nextSlot.fetchAndAdd(1) & ( kNumSlots - 1 );
+            }
+            return mySlot;
+        }
+
+        struct Slot {
+            AtomicInt64 value;
+            char pad[ 64 - sizeof(AtomicInt64) ]; // one cache line per slot
+        };
+        Slot _slots[kNumSlots];
+    };
+
+}
@@ -0,0 +1,54 @@
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/striped_counter.h"
+
+namespace mongo {
+namespace {
+
+    TEST( StripedCounter64Test, Basic ) {
+        StripedCounter64 c;
+        ASSERT_EQUALS( 0, c.get() );
+        c.increment();
+        ASSERT_EQUALS( 1, c.get() );
+        c.increment( 41 );
+        ASSERT_EQUALS( 42, c.get() );
+        c.zero();
+        ASSERT_EQUALS( 0, c.get() );
+    }
+
+    void incrementNTimes( StripedCounter64* c, int n ) {
+        for ( int i = 0; i < n; i++ )
+            c->increment();
+    }
+
+    TEST( StripedCounter64Test, ManyThreads ) {
+        const int kThreads = 8;
+        const int kIncrementsPerThread = 10000;
+
+        StripedCounter64 c;
+        boost::thread_group threads;
+        for ( int i = 0; i < kThreads; i++ )
+            threads.create_thread( boost::bind( incrementNTimes, &c, kIncrementsPerThread ) );
+        threads.join_all();
+
+        ASSERT_EQUALS( static_cast<long long>( kThreads ) * kIncrementsPerThread, c.get() );
+    }
+
+}  // namespace
+}  // namespace mongo
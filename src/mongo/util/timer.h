@@ -19,6 +19,10 @@
 
 #include "mongo/client/export_macros.h"
 
+#if defined(_WIN32)
+#include <intrin.h>
+#endif
+
 namespace mongo {
 
     /**
@@ -77,6 +81,29 @@ namespace mongo {
 
         unsigned long long _old;
     };
+
+    /**
+     * Raw CPU cycle counter (rdtsc on x86), for micro-benchmarks that report
+     * cycles per operation -- see dbtests/perftests.cpp.  Not serializing and
+     * not synchronized across sockets, so only differences taken on one thread
+     * over many iterations mean anything.  Returns 0 on platforms without a
+     * cheap cycle counter; callers should skip cycle reporting in that case.
+     */
+    inline unsigned long long cycleClock() {
+#if defined(_WIN32)
+        return __rdtsc();
+#elif defined(__x86_64__) || defined(__amd64__)
+        unsigned lo, hi;
+        __asm__ __volatile__ ( "rdtsc" : "=a" (lo), "=d" (hi) );
+        return ( static_cast<unsigned long long>( hi ) << 32 ) | lo;
+#elif defined(__i386__)
+        unsigned long long x;
+        __asm__ __volatile__ ( "rdtsc" : "=A" (x) );
+        return x;
+#else
+        return 0;
+#endif
+    }
 }  // namespace mongo
 
 #include "mongo/util/timer-inl.h"
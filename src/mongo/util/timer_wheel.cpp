@@ -0,0 +1,354 @@
+// @file timer_wheel.cpp
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/timer_wheel.h"
+
+#include <boost/bind.hpp>
+
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    TimerWheel::TimerWheel()
+        : _mutex( "TimerWheel" )
+        , _shutdownRequested( false )
+        , _startMillis( curTimeMillis64() )
+        , _currentTick( 0 )
+        , _nextId( 0 )
+        , _running( NULL )
+        , _random( static_cast<int64_t>( curTimeMicros64() ) ) {
+    }
+
+    TimerWheel::~TimerWheel() {
+        for ( int i = 0; i < kSlots; i++ ) {
+            for ( JobList::iterator it = _lower[i].begin(); it != _lower[i].end(); ++it )
+                delete *it;
+            for ( JobList::iterator it = _upper[i].begin(); it != _upper[i].end(); ++it )
+                delete *it;
+        }
+        for ( JobList::iterator it = _overflow.begin(); it != _overflow.end(); ++it )
+            delete *it;
+    }
+
+    TimerWheel::JobId TimerWheel::schedulePeriodic( const std::string& jobName,
+                                                    const Work& work,
+                                                    int periodSecs ) {
+        verify( periodSecs > 0 );
+
+        mutex::scoped_lock lock( _mutex );
+
+        Job* job = new Job();
+        job->id = ++_nextId;
+        job->name = jobName;
+        job->work = work;
+        job->periodTicks = periodSecs;
+        // Random phase within the first period, so jobs that share a period spread
+        // across it instead of stacking on the same second.
+        job->dueTick = _currentTick + 1 + _random.nextInt32( periodSecs );
+        job->cancelled = false;
+
+        _insert( job );
+
+        // The new deadline may be nearer than whatever the wheel thread is
+        // currently sleeping towards.
+        _cond.notify_one();
+
+        return job->id;
+    }
+
+    void TimerWheel::unschedule( JobId id ) {
+        mutex::scoped_lock lock( _mutex );
+
+        if ( _removeFromLists( id ) )
+            return;
+
+        // Not queued, so it may be executing right now. Flag it so the wheel thread
+        // discards it instead of re-arming it, and wait out the current run.
+        if ( _running && _running->id == id ) {
+            _running->cancelled = true;
+            while ( _running && _running->id == id )
+                _idleCond.wait( lock.boost() );
+        }
+    }
+
+    void TimerWheel::setThreadHooks( const Work& init, const Work& cleanup ) {
+        mutex::scoped_lock lock( _mutex );
+        _threadInit = init;
+        _threadCleanup = cleanup;
+    }
+
+    Status TimerWheel::stop( int gracePeriodMillis ) {
+        {
+            mutex::scoped_lock lock( _mutex );
+            _shutdownRequested = true;
+            _cond.notify_one();
+        }
+
+        if ( !wait( gracePeriodMillis ) ) {
+            return Status( ErrorCodes::ExceededTimeLimit,
+                           "Grace period expired while waiting for timer wheel "
+                           "jobs to terminate" );
+        }
+        return Status::OK();
+    }
+
+    void TimerWheel::run() {
+        Work threadInit;
+        Work threadCleanup;
+        {
+            mutex::scoped_lock lock( _mutex );
+            threadInit = _threadInit;
+            threadCleanup = _threadCleanup;
+        }
+
+        if ( threadInit )
+            threadInit();
+
+        const boost::function<bool()> predicate =
+            boost::bind( &TimerWheel::_isShutdownRequested, this );
+
+        {
+            mutex::scoped_lock lock( _mutex );
+            while ( !predicate() ) {
+                const boost::xtime deadline = incxtimemillis( _millisToNextEvent() );
+                if ( _cond.timed_wait( lock.boost(), deadline, predicate ) )
+                    break;
+                _advanceTo( ( curTimeMillis64() - _startMillis ) / 1000, lock );
+            }
+        }
+
+        if ( threadCleanup )
+            threadCleanup();
+    }
+
+    bool TimerWheel::_isShutdownRequested() const {
+        return _shutdownRequested;
+    }
+
+    void TimerWheel::_insert( Job* job ) {
+        const long long delta = job->dueTick - _currentTick;
+        if ( delta < kSlots )
+            _lower[ job->dueTick & ( kSlots - 1 ) ].push_back( job );
+        else if ( delta < static_cast<long long>( kSlots ) * kSlots )
+            _upper[ ( job->dueTick >> kSlotBits ) & ( kSlots - 1 ) ].push_back( job );
+        else
+            _overflow.push_back( job );
+    }
+
+    void TimerWheel::_cascade() {
+        // Everything in this upper slot is due within the next lower-wheel
+        // revolution, so it all re-files into the lower wheel.
+        JobList pending;
+        pending.swap( _upper[ ( _currentTick >> kSlotBits ) & ( kSlots - 1 ) ] );
+
+        // Overflow jobs migrate into the upper wheel once they come within its span.
+        const long long upperSpan = static_cast<long long>( kSlots ) * kSlots;
+        for ( JobList::iterator it = _overflow.begin(); it != _overflow.end(); ) {
+            if ( (*it)->dueTick - _currentTick < upperSpan ) {
+                pending.push_back( *it );
+                it = _overflow.erase( it );
+            }
+            else {
+                ++it;
+            }
+        }
+
+        while ( !pending.empty() ) {
+            Job* job = pending.front();
+            pending.pop_front();
+            _insert( job );
+        }
+    }
+
+    bool TimerWheel::_removeFromLists( JobId id ) {
+        for ( int i = 0; i < kSlots; i++ ) {
+            for ( JobList::iterator it = _lower[i].begin(); it != _lower[i].end(); ++it ) {
+                if ( (*it)->id == id ) {
+                    delete *it;
+                    _lower[i].erase( it );
+                    return true;
+                }
+            }
+            for ( JobList::iterator it = _upper[i].begin(); it != _upper[i].end(); ++it ) {
+                if ( (*it)->id == id ) {
+                    delete *it;
+                    _upper[i].erase( it );
+                    return true;
+                }
+            }
+        }
+        for ( JobList::iterator it = _overflow.begin(); it != _overflow.end(); ++it ) {
+            if ( (*it)->id == id ) {
+                delete *it;
+                _overflow.erase( it );
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TimerWheel::_upperWheelArmed() const {
+        if ( !_overflow.empty() )
+            return true;
+        for ( int i = 0; i < kSlots; i++ )
+            if ( !_upper[i].empty() )
+                return true;
+        return false;
+    }
+
+    long long TimerWheel::_millisToNextEvent() const {
+        // Find the next tick at which there is something to do: a non-empty lower
+        // slot, or a lower-wheel boundary where the upper wheel needs cascading.
+        // If nothing is armed, one revolution is the longest we ever sleep.
+        long long nextTick = _currentTick + kSlots;
+
+        const bool upperArmed = _upperWheelArmed();
+        for ( long long t = _currentTick + 1; t < _currentTick + kSlots; t++ ) {
+            if ( upperArmed && ( t & ( kSlots - 1 ) ) == 0 ) {
+                nextTick = t;
+                break;
+            }
+            if ( !_lower[ t & ( kSlots - 1 ) ].empty() ) {
+                nextTick = t;
+                break;
+            }
+        }
+
+        const long long nowMillis = static_cast<long long>( curTimeMillis64() ) - _startMillis;
+        const long long targetMillis = nextTick * 1000;
+        return targetMillis > nowMillis ? targetMillis - nowMillis : 1;
+    }
+
+    void TimerWheel::_advanceTo( long long nowTick, mutex::scoped_lock& lock ) {
+        while ( _currentTick < nowTick && !_shutdownRequested ) {
+            ++_currentTick;
+            if ( ( _currentTick & ( kSlots - 1 ) ) == 0 )
+                _cascade();
+
+            // The slot holds only jobs due exactly now; a job re-armed during this
+            // tick always files into a different slot.
+            JobList& slot = _lower[ _currentTick & ( kSlots - 1 ) ];
+            while ( !slot.empty() && !_shutdownRequested ) {
+                Job* job = slot.front();
+                slot.pop_front();
+                _runJob( job, lock );
+            }
+        }
+    }
+
+    void TimerWheel::_runJob( Job* job, mutex::scoped_lock& lock ) {
+        _running = job;
+
+        lock.boost().unlock();
+        try {
+            job->work();
+        }
+        catch ( const std::exception& e ) {
+            error() << "timer wheel job " << job->name << " failed: " << e.what() << endl;
+        }
+        catch ( ... ) {
+            error() << "timer wheel job " << job->name << " failed with unknown error" << endl;
+        }
+        lock.boost().lock();
+
+        _running = NULL;
+        _idleCond.notify_all();
+
+        if ( job->cancelled ) {
+            delete job;
+            return;
+        }
+
+        job->dueTick = _currentTick + job->periodTicks;
+        _insert( job );
+    }
+
+    namespace {
+
+        // We rely here on zero-initialization of 'wheelMutex' to distinguish whether
+        // we are running before or after static initialization for this translation
+        // unit has completed. In the former case, we assume no threads are present,
+        // so we do not need to use the mutex. When present, the mutex protects
+        // 'theWheel' and 'theWheelDestroyed' below.
+        SimpleMutex* const wheelMutex = new SimpleMutex("globalTimerWheel");
+
+        // A scoped lock like object that only locks/unlocks the mutex if it exists.
+        class ConditionalScopedLock {
+        public:
+            ConditionalScopedLock( SimpleMutex* mutex ) : _mutex( mutex ) {
+                if ( _mutex )
+                    _mutex->lock();
+            }
+            ~ConditionalScopedLock() {
+                if ( _mutex )
+                    _mutex->unlock();
+            }
+        private:
+            SimpleMutex* const _mutex;
+        };
+
+        // The unique process-wide TimerWheel, also zero-initialized.
+        TimerWheel* theWheel;
+
+        // The wheel is never re-created once it has been destroyed.
+        bool theWheelDestroyed;
+
+    } // namespace
+
+    TimerWheel* globalTimerWheel() {
+        ConditionalScopedLock lock( wheelMutex );
+        if ( theWheelDestroyed )
+            return NULL;
+
+        if ( !theWheel )
+            theWheel = new TimerWheel();
+
+        return theWheel;
+    }
+
+    void startGlobalTimerWheel() {
+        ConditionalScopedLock lock( wheelMutex );
+        if ( theWheelDestroyed )
+            return;
+
+        if ( !theWheel )
+            theWheel = new TimerWheel();
+
+        theWheel->go();
+    }
+
+    Status stopGlobalTimerWheel( int gracePeriodMillis ) {
+        ConditionalScopedLock lock( wheelMutex );
+
+        Status status = Status::OK();
+        if ( theWheelDestroyed || !theWheel )
+            return status;
+
+        theWheel->cancel();
+        status = theWheel->stop( gracePeriodMillis );
+
+        if ( status.isOK() ) {
+            delete theWheel;
+            theWheelDestroyed = true;
+        }
+
+        return status;
+    }
+
+} // namespace mongo
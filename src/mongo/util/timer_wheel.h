@@ -0,0 +1,178 @@
+// @file timer_wheel.h
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/function.hpp>
+#include <boost/thread/condition.hpp>
+#include <list>
+#include <string>
+
+#include "mongo/base/status.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * A hierarchical timer wheel that multiplexes periodic maintenance jobs onto one
+     * shared background thread, instead of every subsystem parking a dedicated thread
+     * in its own sleep loop.
+     *
+     * Resolution is one second, which is plenty for maintenance work. Deadlines due
+     * within the next 64 seconds live in the lower wheel, deadlines within ~68 minutes
+     * in the upper wheel, and anything further out in an overflow list; entries cascade
+     * downward as time passes, so insertion and expiry are O(1) amortized. The thread
+     * sleeps until the next armed slot rather than waking on every tick.
+     *
+     * Each job gets a random initial phase within its period, so jobs that share a
+     * period are spread across it instead of all firing on the same second.
+     *
+     * Jobs run serially on the wheel thread. Long-running or lock-heavy work should
+     * keep its own thread: head-of-line blocking here delays every other job.
+     */
+    class TimerWheel : public BackgroundJob {
+    public:
+        typedef boost::function<void()> Work;
+        typedef size_t JobId;
+
+        TimerWheel();
+        virtual ~TimerWheel();
+
+        /**
+         * Registers 'work' to run every 'periodSecs' seconds, starting at a random
+         * point within the first period. 'jobName' is used for diagnostics only.
+         * May be called before or after the wheel thread has been started. Returns
+         * an id usable with unschedule().
+         */
+        JobId schedulePeriodic( const std::string& jobName, const Work& work, int periodSecs );
+
+        /**
+         * Removes a job from the wheel. If the job is executing right now, blocks
+         * until it finishes, so the job's state may be destroyed safely afterwards.
+         * Must not be called from the wheel thread itself.
+         */
+        void unschedule( JobId id );
+
+        /**
+         * Installs callbacks run once on the wheel thread: 'init' before the first
+         * job, 'cleanup' after the last. Lets a server attach thread-local state
+         * (e.g. a Client) that its jobs need. Call before go().
+         */
+        void setThreadHooks( const Work& init, const Work& cleanup );
+
+        /**
+         * Asks the wheel thread to exit, waiting up to 'gracePeriodMillis' for any
+         * running job to finish.
+         */
+        Status stop( int gracePeriodMillis );
+
+    private:
+        struct Job {
+            JobId id;
+            std::string name;
+            Work work;
+            long long periodTicks;
+            long long dueTick;
+            bool cancelled;
+        };
+
+        typedef std::list<Job*> JobList;
+
+        // One tick is one second; each wheel level has 64 slots.
+        static const int kSlotBits = 6;
+        static const int kSlots = 1 << kSlotBits;
+
+        virtual std::string name() const { return "TimerWheel"; }
+        virtual void run();
+
+        // The helpers below must be called with _mutex held.
+
+        // Files a job into the wheel level matching its deadline's distance.
+        void _insert( Job* job );
+
+        // Moves entries due within the next lower-wheel revolution down a level.
+        // Called when _currentTick crosses a lower-wheel boundary.
+        void _cascade();
+
+        // Erases and deletes a queued job. Returns false if 'id' is not queued.
+        bool _removeFromLists( JobId id );
+
+        // Millis to sleep until the next slot that needs attention.
+        long long _millisToNextEvent() const;
+
+        bool _upperWheelArmed() const;
+        bool _isShutdownRequested() const;
+
+        // Processes every tick up to 'nowTick', running due jobs.
+        void _advanceTo( long long nowTick, mutex::scoped_lock& lock );
+
+        // Executes one job with _mutex released, then re-arms or discards it.
+        void _runJob( Job* job, mutex::scoped_lock& lock );
+
+        // _mutex protects every member below.
+        mongo::mutex _mutex;
+
+        // Notified when a newly scheduled job may be due sooner than the current
+        // sleep deadline, and on shutdown.
+        boost::condition _cond;
+
+        // Notified when the currently executing job finishes; unschedule() waits on
+        // this before returning.
+        boost::condition _idleCond;
+
+        bool _shutdownRequested;
+
+        long long _startMillis;     // wall clock time of tick zero
+        long long _currentTick;     // last fully processed tick
+        JobId _nextId;
+
+        JobList _lower[kSlots];     // due within kSlots ticks
+        JobList _upper[kSlots];     // due within kSlots^2 ticks
+        JobList _overflow;          // everything further out
+
+        Job* _running;              // job currently executing, or NULL
+
+        PseudoRandom _random;       // initial phase jitter
+
+        Work _threadInit;
+        Work _threadCleanup;
+    };
+
+    /**
+     * The process-wide wheel that PeriodicTask and other periodic maintenance jobs
+     * register with. Created on first use; returns NULL once stopGlobalTimerWheel()
+     * has destroyed it. Safe to call during static initialization.
+     */
+    TimerWheel* globalTimerWheel();
+
+    /**
+     * Starts the global wheel's thread. May be called multiple times, from multiple
+     * threads; the thread is started only once. Since this starts a thread, it is not
+     * appropriate to call it from within a mongo initializer.
+     */
+    void startGlobalTimerWheel();
+
+    /**
+     * Stops and destroys the global wheel, waiting up to 'gracePeriodMillis' for a
+     * running job to finish. See PeriodicTask::stopRunningPeriodicTasks for the
+     * calling rules; they apply here unchanged.
+     */
+    Status stopGlobalTimerWheel( int gracePeriodMillis );
+
+} // namespace mongo
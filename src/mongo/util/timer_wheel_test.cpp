@@ -0,0 +1,66 @@
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/synchronization.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer_wheel.h"
+
+namespace {
+
+    using mongo::Notification;
+    using mongo::TimerWheel;
+
+    // Written on the wheel thread; reads below are ordered by the notification or by
+    // unschedule(), which synchronizes with the end of any in-flight run.
+    int runCount;
+    Notification* firstRun;
+
+    void bump() {
+        if ( ++runCount == 1 )
+            firstRun->notifyOne();
+    }
+
+    TEST(TimerWheel, RunsAndUnschedules) {
+        TimerWheel wheel;
+
+        Notification ran;
+        runCount = 0;
+        firstRun = &ran;
+
+        TimerWheel::JobId id = wheel.schedulePeriodic( "bump", bump, 1 );
+        wheel.go();
+
+        ran.waitToBeNotified();
+        ASSERT_GREATER_THAN_OR_EQUALS( runCount, 1 );
+
+        // After unschedule returns, the job may never run again.
+        wheel.unschedule( id );
+        const int observed = runCount;
+        mongo::sleepmillis( 1500 );
+        ASSERT_EQUALS( observed, runCount );
+
+        ASSERT_OK( wheel.stop( 10 * 1000 ) );
+    }
+
+    TEST(TimerWheel, StopWithoutStart) {
+        TimerWheel wheel;
+        wheel.cancel();
+        ASSERT_OK( wheel.stop( 1000 ) );
+    }
+
+} // namespace